@@ -3,6 +3,7 @@
 #include <setupapi.h>
 #include <string>
 #include "logger.h"
+#include "backup_store.h"
 
 #pragma comment(lib, "setupapi.lib")
 
@@ -43,4 +44,66 @@ extern "C" {
             return -(int)err;
         }
     }
+
+    /**
+     * [MAIDOS-AUDIT] 增量去重備份系統驅動存放區 (DriverStore\FileRepository)
+     * @param storePath 備份倉庫目錄
+     * @param backupName 本次備份名稱 (英數與 . _ -)
+     * @param parentName 增量基準備份名稱，NULL 或空字串表示完整讀取 (區塊仍會去重)
+     * @return 1=成功, -1=失敗
+     */
+    __declspec(dllexport) int backup_driver_store(const char* storePath, const char* backupName, const char* parentName) {
+        AUDIT_ENTRY(backup_driver_store);
+        if (!storePath || !backupName) return -1;
+
+        char windir[MAX_PATH];
+        UINT len = GetWindowsDirectoryA(windir, MAX_PATH);
+        if (len == 0 || len >= MAX_PATH) return -1;
+        std::string source = std::string(windir) + "\\System32\\DriverStore\\FileRepository";
+
+        BackupStore store(storePath);
+        BackupOptions options;
+        if (parentName) options.parent = parentName;
+        BackupStats stats;
+        std::string error;
+        if (!store.Open(&error) || !store.Backup(source, backupName, options, &stats, &error)) {
+            AUDIT_LOG("BACKUP", "Store backup failed: " + error);
+            return -1;
+        }
+        AUDIT_EXIT(backup_driver_store);
+        return 1;
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 將倉庫中的備份還原為目錄 (可再以 pnputil /add-driver 安裝)
+     * @return 1=成功, -1=失敗 (含區塊損毀)
+     */
+    __declspec(dllexport) int restore_driver_backup(const char* storePath, const char* backupName, const char* targetPath) {
+        AUDIT_ENTRY(restore_driver_backup);
+        if (!storePath || !backupName || !targetPath) return -1;
+
+        BackupStore store(storePath);
+        std::string error;
+        if (!store.Open(&error) || !store.Restore(backupName, targetPath, &error)) {
+            AUDIT_LOG("BACKUP", "Restore failed: " + error);
+            return -1;
+        }
+        AUDIT_EXIT(restore_driver_backup);
+        return 1;
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 刪除備份清單並回收不再被參照的區塊
+     * @return 回收的區塊數, -1=失敗
+     */
+    __declspec(dllexport) int remove_driver_backup(const char* storePath, const char* backupName) {
+        AUDIT_ENTRY(remove_driver_backup);
+        if (!storePath || !backupName) return -1;
+
+        BackupStore store(storePath);
+        if (!store.Open() || !store.Remove(backupName)) return -1;
+        int removed = (int)store.Prune();
+        AUDIT_EXIT(remove_driver_backup);
+        return removed;
+    }
 }
\ No newline at end of file
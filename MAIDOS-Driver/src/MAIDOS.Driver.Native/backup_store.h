@@ -0,0 +1,156 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 內容定址去重備份倉庫
+ * 功能: 以內容定義分塊 (FastCDC gear hash) 切割檔案，區塊以 SHA-256 命名並跨備份去重；
+ *       新區塊由多執行緒並行壓縮寫入；每次備份只是一份小型清單 (manifest)，
+ *       增量備份只需處理變動的位元組
+ *
+ * 倉庫結構:
+ *   <root>/chunks/<前2碼>/<sha256>   區塊 (1 位元組壓縮法 + 4 位元組原始大小 + 內容)
+ *   <root>/manifests/<name>          備份清單 (文字)
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// 內容定義分塊
+// ---------------------------------------------------------------------------
+
+struct ChunkerParams {
+    uint32_t min_size = 16 * 1024;
+    uint32_t avg_size = 64 * 1024;   // 須為 2 的次方
+    uint32_t max_size = 256 * 1024;
+};
+
+/**
+ * [MAIDOS-AUDIT] FastCDC 分塊器
+ * 切點只取決於附近內容，檔案中段插入資料只影響鄰近區塊，其餘區塊仍可去重
+ */
+class ContentChunker {
+public:
+    explicit ContentChunker(ChunkerParams params = ChunkerParams());
+
+    /**
+     * 從 data 開頭找下一個切點
+     * @param size 可用資料量；未到檔尾時呼叫端須提供至少 max_size 位元組
+     * @return 區塊長度 (1..min(size, max_size))
+     */
+    size_t FindCut(const uint8_t* data, size_t size) const;
+
+    const ChunkerParams& Params() const { return params_; }
+
+private:
+    ChunkerParams params_;
+    uint64_t mask_small_;   // 未達平均大小前使用 (較難切)
+    uint64_t mask_large_;   // 超過平均大小後使用 (較易切)
+};
+
+// ---------------------------------------------------------------------------
+// 備份清單
+// ---------------------------------------------------------------------------
+
+struct ChunkRef {
+    std::string id;      // SHA-256 小寫十六進位
+    uint32_t size = 0;   // 原始大小
+};
+
+struct ManifestFile {
+    std::string path;    // 相對路徑 (以 / 分隔)
+    uint64_t size = 0;
+    int64_t mtime = 0;   // 檔案系統時間戳 (僅用於增量比對)
+    std::vector<ChunkRef> chunks;
+};
+
+struct BackupManifest {
+    std::string name;
+    std::string parent;  // 增量基準 (可為空)
+    int64_t created = 0; // Unix 秒
+    std::vector<ManifestFile> files;
+
+    uint64_t TotalBytes() const;
+
+    bool Save(const std::string& path, std::string* error = nullptr) const;
+    bool Load(const std::string& path, std::string* error = nullptr);
+};
+
+// ---------------------------------------------------------------------------
+// 倉庫
+// ---------------------------------------------------------------------------
+
+// 區塊壓縮法 (區塊檔第 1 位元組)
+#define CHUNK_METHOD_RAW 0
+#define CHUNK_METHOD_LZ  1
+
+struct BackupOptions {
+    std::string parent;          // 增量基準備份；大小與時間戳相同的檔案直接沿用其區塊清單
+    int threads = 0;             // 雜湊/壓縮執行緒數，0=硬體核心數
+    bool compress = true;
+    ChunkerParams chunker;
+};
+
+struct BackupStats {
+    uint64_t files = 0;
+    uint64_t unchanged_files = 0;   // 依基準備份沿用，未讀取
+    uint64_t bytes_total = 0;       // 備份涵蓋的原始位元組
+    uint64_t bytes_read = 0;        // 實際讀取並分塊
+    uint64_t chunks = 0;            // 讀取檔案產生的區塊數
+    uint64_t new_chunks = 0;
+    uint64_t new_bytes = 0;         // 新區塊原始大小
+    uint64_t stored_bytes = 0;      // 新區塊寫入大小 (壓縮後)
+};
+
+class BackupStore {
+public:
+    explicit BackupStore(std::string root);
+
+    /**
+     * [MAIDOS-AUDIT] 開啟倉庫 (不存在則建立)，並索引既有區塊
+     * @param error 失敗原因輸出 (可為 nullptr)
+     */
+    bool Open(std::string* error = nullptr);
+
+    /**
+     * [MAIDOS-AUDIT] 備份 source_dir 整個目錄樹為 name
+     * @param stats 統計輸出 (可為 nullptr)
+     */
+    bool Backup(const std::string& source_dir, const std::string& name, const BackupOptions& options = BackupOptions(),
+                BackupStats* stats = nullptr, std::string* error = nullptr);
+
+    /**
+     * [MAIDOS-AUDIT] 還原備份到 target_dir；每個區塊以 SHA-256 驗證
+     */
+    bool Restore(const std::string& name, const std::string& target_dir, std::string* error = nullptr) const;
+
+    bool LoadManifest(const std::string& name, BackupManifest& manifest, std::string* error = nullptr) const;
+
+    // 依名稱排序
+    std::vector<std::string> ListBackups() const;
+
+    // 刪除清單 (區塊由 Prune 回收)
+    bool Remove(const std::string& name);
+
+    // 刪除不被任何清單參照的區塊，回傳刪除數量 (不可與 Backup 同時執行)
+    size_t Prune();
+
+    size_t ChunkCount() const;
+
+    // 備份名稱限英數與 . _ -
+    static bool ValidName(const std::string& name);
+
+    // 讀取並解壓單一區塊 (驗證雜湊)
+    bool ReadChunk(const std::string& id, std::vector<uint8_t>& data) const;
+
+private:
+    std::string ChunkPath(const std::string& id) const;
+    std::string ManifestPath(const std::string& name) const;
+
+    std::string root_;
+    mutable std::mutex lock_;
+    std::unordered_set<std::string> chunks_;   // 已存在 (或寫入中) 的區塊
+};
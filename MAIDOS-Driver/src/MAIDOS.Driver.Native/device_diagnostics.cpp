@@ -0,0 +1,190 @@
+#pragma warning(disable: 4819)
+#include "device_diagnostics.h"
+#include "logger.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+static std::string Upper(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) {
+        if (c >= 'a' && c <= 'z') c = (char)(c - 32);
+    }
+    return out;
+}
+
+size_t DiagnosticsReport::CountAtLeast(uint32_t severity) const {
+    size_t count = 0;
+    for (const DeviceDiagnosis& d : diagnoses) count += d.severity >= severity;
+    return count;
+}
+
+int DiagnosticsReport::Find(std::string_view instance_id) const {
+    std::string key = Upper(instance_id);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        if (Upper(nodes[i].instance_id) == key) return (int)i;
+    }
+    return -1;
+}
+
+// 單一設備本身的規則 (不看設備樹)
+static void EvaluateNode(const DeviceNode& node, DeviceDiagnosis& d) {
+    bool disabled = (node.status & DEVICE_STATUS_DISABLED) || node.problem_code == DEVICE_PROBLEM_DISABLED;
+    if (node.status & DEVICE_STATUS_HAS_PROBLEM) {
+        d.findings |= DIAG_FINDING_PROBLEM;
+        if (disabled) {
+            d.findings |= DIAG_FINDING_DISABLED;
+            d.severity = DIAG_SEVERITY_INFO;
+        } else if (node.problem_code == DEVICE_PROBLEM_NOT_CONFIGURED || node.problem_code == DEVICE_PROBLEM_FAILED_INSTALL) {
+            d.findings |= DIAG_FINDING_DRIVER_MISSING;
+            d.severity = DIAG_SEVERITY_WARNING;
+        } else {
+            d.severity = DIAG_SEVERITY_ERROR;
+        }
+    } else if (!(node.status & DEVICE_STATUS_STARTED)) {
+        d.findings |= DIAG_FINDING_NOT_STARTED;
+        d.severity = DIAG_SEVERITY_INFO;
+    }
+}
+
+void EvaluateDiagnostics(DiagnosticsReport& report) {
+    const size_t count = report.nodes.size();
+    report.diagnoses.assign(count, DeviceDiagnosis());
+
+    std::unordered_map<std::string, int32_t> rows;
+    rows.reserve(count);
+    for (size_t i = 0; i < count; i++) rows.emplace(Upper(report.nodes[i].instance_id), (int32_t)i);
+
+    for (size_t i = 0; i < count; i++) {
+        DeviceDiagnosis& d = report.diagnoses[i];
+        const DeviceNode& node = report.nodes[i];
+        if (!node.parent_id.empty()) {
+            auto it = rows.find(Upper(node.parent_id));
+            if (it != rows.end() && it->second != (int32_t)i) d.parent = it->second;
+        }
+        EvaluateNode(node, d);
+    }
+
+    // 根因: 往上找最上層有問題碼的祖先；最多走 count 步 (設備樹有環也會終止)
+    for (size_t i = 0; i < count; i++) {
+        DeviceDiagnosis& d = report.diagnoses[i];
+        if (d.findings == 0) continue;
+
+        int32_t cause = -1;
+        size_t steps = 0;
+        for (int32_t p = d.parent; p >= 0 && steps < count; p = report.diagnoses[p].parent, steps++) {
+            if (report.diagnoses[p].findings & DIAG_FINDING_PROBLEM) cause = p;
+        }
+        if (cause >= 0 && cause != (int32_t)i) {
+            d.findings |= DIAG_FINDING_PARENT_FAILED;
+            d.root_cause = cause;
+        } else {
+            d.root_cause = (int32_t)i;
+        }
+    }
+}
+
+bool RunDeviceDiagnostics(IDeviceProvider& provider, DiagnosticsReport& report, std::string* error) {
+    if (!provider.EnumerateNodes(report.nodes)) {
+        if (error) *error = "Device enumeration failed";
+        AUDIT_LOG("DIAG", "Device enumeration failed.");
+        return false;
+    }
+    EvaluateDiagnostics(report);
+    AUDIT_LOG("DIAG", "Diagnosed " + std::to_string(report.nodes.size()) + " devices: " +
+              std::to_string(report.CountAtLeast(DIAG_SEVERITY_ERROR)) + " errors, " +
+              std::to_string(report.CountAtLeast(DIAG_SEVERITY_WARNING) - report.CountAtLeast(DIAG_SEVERITY_ERROR)) +
+              " warnings");
+    return true;
+}
+
+size_t EncodeDiagnosticsBlob(const DiagnosticsReport& report, uint8_t* buffer, size_t capacity, size_t* needed) {
+    const size_t count = report.nodes.size();
+    size_t resources = 0;
+    size_t strings = 0;
+    for (const DeviceNode& n : report.nodes) {
+        resources += n.resources.size();
+        strings += n.instance_id.size() + 1;
+    }
+
+    DiagBlobHeader header{};
+    header.magic = DIAG_BLOB_MAGIC;
+    header.version = DIAG_BLOB_VERSION;
+    header.record_size = (uint16_t)sizeof(DiagBlobRecord);
+    header.count = (uint32_t)count;
+    header.resources_offset = (uint32_t)sizeof(DiagBlobHeader);
+    header.resource_count = (uint32_t)resources;
+    header.records_offset = (uint32_t)(header.resources_offset + resources * sizeof(DiagBlobResource));
+    header.strings_offset = (uint32_t)(header.records_offset + count * sizeof(DiagBlobRecord));
+    header.strings_size = (uint32_t)strings;
+
+    size_t total = header.strings_offset + strings;
+    if (needed) *needed = total;
+    if (!buffer || capacity < total) return 0;
+
+    memcpy(buffer, &header, sizeof(header));
+    DiagBlobResource* res_out = (DiagBlobResource*)(buffer + header.resources_offset);
+    uint8_t* rec_out = buffer + header.records_offset;
+    char* str_out = (char*)buffer + header.strings_offset;
+
+    uint32_t next_resource = 0;
+    uint32_t next_string = 0;
+    for (size_t i = 0; i < count; i++) {
+        const DeviceNode& n = report.nodes[i];
+        const DeviceDiagnosis& d = report.diagnoses[i];
+
+        DiagBlobRecord r{};
+        r.instance_id = ScanBlobString{ next_string, (uint32_t)n.instance_id.size() };
+        r.parent = d.parent;
+        r.root_cause = d.root_cause;
+        r.status = n.status;
+        r.problem_code = n.problem_code;
+        r.severity = d.severity;
+        r.findings = d.findings;
+        r.first_resource = next_resource;
+        r.resource_count = (uint32_t)n.resources.size();
+        memcpy(rec_out + i * sizeof(DiagBlobRecord), &r, sizeof(r));
+
+        for (const DeviceResource& src : n.resources) {
+            DiagBlobResource out{ src.type, src.flags, src.start, src.end };
+            memcpy(&res_out[next_resource++], &out, sizeof(out));
+        }
+        memcpy(str_out + next_string, n.instance_id.data(), n.instance_id.size());
+        str_out[next_string + n.instance_id.size()] = '\0';
+        next_string += (uint32_t)n.instance_id.size() + 1;
+    }
+    return total;
+}
+
+bool DiagBlobView::Open(const uint8_t* data, size_t size) {
+    if (!data || size < sizeof(DiagBlobHeader)) return false;
+    memcpy(&header_, data, sizeof(header_));
+    if (header_.magic != DIAG_BLOB_MAGIC || header_.version != DIAG_BLOB_VERSION) return false;
+    if (header_.record_size != sizeof(DiagBlobRecord)) return false;
+    if (header_.resources_offset < sizeof(DiagBlobHeader) || header_.resources_offset % 8 != 0 ||
+        header_.records_offset % 4 != 0) {
+        return false;
+    }
+
+    uint64_t resources_end = (uint64_t)header_.resources_offset + (uint64_t)header_.resource_count * sizeof(DiagBlobResource);
+    uint64_t records_end = (uint64_t)header_.records_offset + (uint64_t)header_.count * sizeof(DiagBlobRecord);
+    uint64_t strings_end = (uint64_t)header_.strings_offset + header_.strings_size;
+    if (resources_end > header_.records_offset || records_end > header_.strings_offset || strings_end > size) return false;
+
+    resources_ = (const DiagBlobResource*)(data + header_.resources_offset);
+    records_ = (const DiagBlobRecord*)(data + header_.records_offset);
+    strings_ = (const char*)data + header_.strings_offset;
+
+    for (uint32_t i = 0; i < header_.count; i++) {
+        const DiagBlobRecord& r = records_[i];
+        if ((uint64_t)r.instance_id.offset + r.instance_id.length >= header_.strings_size ||
+            strings_[r.instance_id.offset + r.instance_id.length] != '\0') {
+            return false;
+        }
+        if ((uint64_t)r.first_resource + r.resource_count > header_.resource_count) return false;
+        if (r.parent < -1 || r.parent >= (int64_t)header_.count) return false;
+        if (r.root_cause < -1 || r.root_cause >= (int64_t)header_.count) return false;
+    }
+    return true;
+}
@@ -0,0 +1,147 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 批次設備診斷
+ * 功能: 經由 IDeviceProvider 一次走訪設備樹，對全部設備套用診斷規則
+ *       (問題碼分級、缺驅動、停用、未啟動、上游設備故障的根因)，
+ *       結果連同已配置資源 (IRQ/記憶體/IO/DMA) 編碼成單一區塊，一次 FFI 呼叫取回
+ *
+ * 區塊佈局 (小端序，字串表沿用 scan_blob.h 的 ScanBlobString):
+ *   DiagBlobHeader                       32 位元組
+ *   DiagBlobResource[resource_count]     每筆 24 位元組 (8 位元組對齊)
+ *   DiagBlobRecord[count]                每筆 40 位元組；資源為 [first_resource, +resource_count)
+ *   字串表                                實例ID，以 NUL 結尾
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "device_provider.h"
+#include "scan_blob.h"
+
+// CM_PROB_* 中規則會用到的問題碼 (非 Windows 平台沒有 cfgmgr32.h)
+#define DEVICE_PROBLEM_NOT_CONFIGURED 1
+#define DEVICE_PROBLEM_FAILED_START   10
+#define DEVICE_PROBLEM_DISABLED       22
+#define DEVICE_PROBLEM_FAILED_INSTALL 28
+#define DEVICE_PROBLEM_CODE43         43
+
+// 嚴重度 (數字越大越嚴重)
+enum DiagnosticSeverity : uint32_t {
+    DIAG_SEVERITY_OK      = 0,
+    DIAG_SEVERITY_INFO    = 1,
+    DIAG_SEVERITY_WARNING = 2,
+    DIAG_SEVERITY_ERROR   = 3,
+};
+
+// 診斷發現 (位元旗標)
+enum DiagnosticFindings : uint32_t {
+    DIAG_FINDING_PROBLEM        = 0x1,   // 有問題碼
+    DIAG_FINDING_DRIVER_MISSING = 0x2,   // 未安裝/未設定驅動 (Code 1/28)
+    DIAG_FINDING_DISABLED       = 0x4,   // 使用者停用 (Code 22)
+    DIAG_FINDING_NOT_STARTED    = 0x8,   // 無問題碼但未啟動
+    DIAG_FINDING_PARENT_FAILED  = 0x10,  // 上游設備有問題，root_cause 指向最上層者
+};
+
+// 單一設備的診斷結果 (與 DiagnosticsReport::nodes 同列號)
+struct DeviceDiagnosis {
+    int32_t parent = -1;      // 父節點列號，不在列舉中為 -1
+    int32_t root_cause = -1;  // 根因列號 (最上層有問題的祖先，否則自己)；無發現為 -1
+    uint32_t severity = DIAG_SEVERITY_OK;
+    uint32_t findings = 0;
+};
+
+struct DiagnosticsReport {
+    std::vector<DeviceNode> nodes;
+    std::vector<DeviceDiagnosis> diagnoses;
+
+    // 嚴重度 >= severity 的設備數
+    size_t CountAtLeast(uint32_t severity) const;
+
+    // 依實例ID查列號，找不到回傳 -1
+    int Find(std::string_view instance_id) const;
+};
+
+/**
+ * [MAIDOS-AUDIT] 對 report.nodes 套用診斷規則，填入 report.diagnoses
+ * 父子關係以實例ID (不分大小寫) 解析；設備樹有環時仍會終止
+ */
+void EvaluateDiagnostics(DiagnosticsReport& report);
+
+/**
+ * [MAIDOS-AUDIT] 一次列舉 (IDeviceProvider::EnumerateNodes) 後套用規則
+ * @return true=成功, false=列舉失敗
+ */
+bool RunDeviceDiagnostics(IDeviceProvider& provider, DiagnosticsReport& report, std::string* error = nullptr);
+
+#define DIAG_BLOB_MAGIC   0x4744444Du   // "MDDG"
+#define DIAG_BLOB_VERSION 1
+
+#pragma pack(push, 4)
+struct DiagBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;       // sizeof(DiagBlobRecord)
+    uint32_t count;
+    uint32_t resources_offset;  // 相對區塊起點
+    uint32_t resource_count;
+    uint32_t records_offset;
+    uint32_t strings_offset;
+    uint32_t strings_size;
+};
+
+struct DiagBlobResource {
+    uint32_t type;    // DeviceResourceType
+    uint32_t flags;   // DeviceResourceFlags
+    uint64_t start;
+    uint64_t end;
+};
+
+struct DiagBlobRecord {
+    ScanBlobString instance_id;
+    int32_t parent;
+    int32_t root_cause;
+    uint32_t status;          // DeviceStatusFlags
+    uint32_t problem_code;
+    uint32_t severity;        // DiagnosticSeverity
+    uint32_t findings;        // DiagnosticFindings
+    uint32_t first_resource;
+    uint32_t resource_count;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(DiagBlobHeader) == 32, "DiagBlobHeader layout");
+static_assert(sizeof(DiagBlobResource) == 24, "DiagBlobResource layout");
+static_assert(sizeof(DiagBlobRecord) == 40, "DiagBlobRecord layout");
+
+/**
+ * [MAIDOS-AUDIT] 將診斷結果編碼到 buffer
+ * @param capacity buffer 大小；不足時不寫入任何資料
+ * @param needed 輸出所需大小 (可為 nullptr)
+ * @return 寫入的位元組數；緩衝區不足 (或 buffer 為 nullptr) 回傳 0
+ */
+size_t EncodeDiagnosticsBlob(const DiagnosticsReport& report, uint8_t* buffer, size_t capacity, size_t* needed);
+
+/**
+ * [MAIDOS-AUDIT] 唯讀檢視 (驗證後直接指向緩衝區，不複製)
+ */
+class DiagBlobView {
+public:
+    /**
+     * 驗證標頭、記錄、資源範圍、列號與字串
+     * @return false=格式錯誤或被截斷
+     */
+    bool Open(const uint8_t* data, size_t size);
+
+    uint32_t Count() const { return header_.count; }
+    const DiagBlobRecord& Record(size_t i) const { return records_[i]; }
+    const DiagBlobResource& Resource(size_t i) const { return resources_[i]; }
+    std::string_view String(ScanBlobString s) const { return std::string_view(strings_ + s.offset, s.length); }
+
+private:
+    DiagBlobHeader header_{};
+    const DiagBlobResource* resources_ = nullptr;
+    const DiagBlobRecord* records_ = nullptr;
+    const char* strings_ = nullptr;
+};
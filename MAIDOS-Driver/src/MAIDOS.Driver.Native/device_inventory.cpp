@@ -0,0 +1,350 @@
+#pragma warning(disable: 4819)
+#include "device_inventory.h"
+#include "logger.h"
+
+#include <memory>
+#include <unordered_set>
+
+// 新表格建構器: 所有字串寫入單一字串池，欄位只存 (offset, length)
+class DeviceInventory::Builder {
+public:
+    explicit Builder(size_t rows) {
+        ids.reserve(rows); names.reserve(rows); manufacturers.reserve(rows); versions.reserve(rows);
+        hardware_ids.reserve(rows); compatible_ids.reserve(rows);
+        status.reserve(rows); problems.reserve(rows); stamps.reserve(rows); row_generation.reserve(rows);
+    }
+
+    void Append(const DeviceRecord& d, uint64_t stamp, uint64_t generation) {
+        ids.push_back(Put(d.instance_id));
+        names.push_back(Put(d.name));
+        manufacturers.push_back(Put(d.manufacturer));
+        versions.push_back(Put(d.driver_version));
+        hardware_ids.push_back(PutMulti(d.hardware_ids));
+        compatible_ids.push_back(PutMulti(d.compatible_ids));
+        status.push_back(d.status);
+        problems.push_back(d.problem_code);
+        stamps.push_back(stamp);
+        row_generation.push_back(generation);
+    }
+
+    std::string pool;
+    std::vector<StrRef> ids, names, manufacturers, versions, hardware_ids, compatible_ids;
+    std::vector<uint32_t> status, problems;
+    std::vector<uint64_t> stamps, row_generation;
+
+private:
+    StrRef Put(std::string_view s) {
+        StrRef r{ (uint32_t)pool.size(), (uint32_t)s.size() };
+        pool.append(s.data(), s.size());
+        return r;
+    }
+
+    StrRef PutMulti(const std::vector<std::string>& values) {
+        StrRef r{ (uint32_t)pool.size(), 0 };
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0) pool.push_back('\0');
+            pool.append(values[i]);
+        }
+        r.length = (uint32_t)(pool.size() - r.offset);
+        return r;
+    }
+};
+
+void DeviceInventory::Adopt(Builder& b) {
+    pool_ = std::move(b.pool);
+    waste_ = 0;
+    ids_ = std::move(b.ids);
+    names_ = std::move(b.names);
+    manufacturers_ = std::move(b.manufacturers);
+    versions_ = std::move(b.versions);
+    hardware_ids_ = std::move(b.hardware_ids);
+    compatible_ids_ = std::move(b.compatible_ids);
+    status_ = std::move(b.status);
+    problems_ = std::move(b.problems);
+    stamps_ = std::move(b.stamps);
+    row_generation_ = std::move(b.row_generation);
+    RebuildIndex();
+}
+
+void DeviceInventory::RebuildIndex() {
+    index_.clear();
+    index_.reserve(ids_.size());
+    for (size_t i = 0; i < ids_.size(); i++) {
+        index_.emplace(View(ids_[i]), (uint32_t)i);
+    }
+}
+
+bool DeviceInventory::Snapshot() {
+    std::vector<DeviceRecord> records;
+    if (!provider_.Enumerate(records)) {
+        AUDIT_LOG("INVENTORY", "Snapshot enumeration failed.");
+        return false;
+    }
+
+    uint64_t generation = generation_ + 1;
+    Builder b(records.size());
+    for (const DeviceRecord& d : records) {
+        b.Append(d, DeviceStamp(d.driver_version), generation);
+    }
+    Adopt(b);
+    generation_ = generation;
+    has_snapshot_ = true;
+    invalidated_.clear();
+
+    AUDIT_LOG("INVENTORY", "Snapshot of " + std::to_string(Size()) + " devices, generation " + std::to_string(generation_));
+    return true;
+}
+
+// 多字串欄位的池內表示: 項目以 NUL 分隔，無結尾 NUL
+static void JoinMulti(const std::vector<std::string>& values, std::string& out) {
+    out.clear();
+    for (size_t i = 0; i < values.size(); i++) {
+        if (i > 0) out.push_back('\0');
+        out.append(values[i]);
+    }
+}
+
+// 就地更新字串欄位: 內容相同沿用原 offset；不變長時覆寫原位置；變長才附加到字串池尾端
+void DeviceInventory::PatchString(StrRef& ref, std::string_view s) {
+    if (View(ref) == s) return;
+
+    if (s.size() <= ref.length) {
+        pool_.replace(ref.offset, s.size(), s.data(), s.size());
+        waste_ += ref.length - s.size();
+        ref.length = (uint32_t)s.size();
+        return;
+    }
+    waste_ += ref.length;
+    ref = StrRef{ (uint32_t)pool_.size(), (uint32_t)s.size() };
+    pool_.append(s.data(), s.size());
+}
+
+// 重讀後的記錄寫回原列 (實例ID不變，索引鍵不受影響)
+void DeviceInventory::PatchRow(size_t row, const DeviceRecord& d, uint64_t stamp, uint64_t generation) {
+    PatchString(names_[row], d.name);
+    PatchString(manufacturers_[row], d.manufacturer);
+    PatchString(versions_[row], d.driver_version);
+    JoinMulti(d.hardware_ids, scratch_);
+    PatchString(hardware_ids_[row], scratch_);
+    JoinMulti(d.compatible_ids, scratch_);
+    PatchString(compatible_ids_[row], scratch_);
+    status_[row] = d.status;
+    problems_[row] = d.problem_code;
+    stamps_[row] = stamp;
+    row_generation_[row] = generation;
+}
+
+void DeviceInventory::AppendRow(const DeviceRecord& d, uint64_t stamp, uint64_t generation) {
+    auto put = [this](std::string_view s) {
+        StrRef r{ (uint32_t)pool_.size(), (uint32_t)s.size() };
+        pool_.append(s.data(), s.size());
+        return r;
+    };
+    ids_.push_back(put(d.instance_id));
+    names_.push_back(put(d.name));
+    manufacturers_.push_back(put(d.manufacturer));
+    versions_.push_back(put(d.driver_version));
+    JoinMulti(d.hardware_ids, scratch_);
+    hardware_ids_.push_back(put(scratch_));
+    JoinMulti(d.compatible_ids, scratch_);
+    compatible_ids_.push_back(put(scratch_));
+    status_.push_back(d.status);
+    problems_.push_back(d.problem_code);
+    stamps_.push_back(stamp);
+    row_generation_.push_back(generation);
+}
+
+// 移除 keep[row]==false 的列 (保持列順序，只搬移 offset/數值欄位)
+void DeviceInventory::RemoveRows(const std::vector<bool>& keep) {
+    size_t w = 0;
+    for (size_t r = 0; r < keep.size(); r++) {
+        if (!keep[r]) {
+            waste_ += ids_[r].length + names_[r].length + manufacturers_[r].length + versions_[r].length +
+                      hardware_ids_[r].length + compatible_ids_[r].length;
+            continue;
+        }
+        if (w != r) {
+            ids_[w] = ids_[r]; names_[w] = names_[r]; manufacturers_[w] = manufacturers_[r]; versions_[w] = versions_[r];
+            hardware_ids_[w] = hardware_ids_[r]; compatible_ids_[w] = compatible_ids_[r];
+            status_[w] = status_[r]; problems_[w] = problems_[r];
+            stamps_[w] = stamps_[r]; row_generation_[w] = row_generation_[r];
+        }
+        w++;
+    }
+    ids_.resize(w); names_.resize(w); manufacturers_.resize(w); versions_.resize(w);
+    hardware_ids_.resize(w); compatible_ids_.resize(w);
+    status_.resize(w); problems_.resize(w); stamps_.resize(w); row_generation_.resize(w);
+}
+
+// 廢棄位元組過半時重新打包字串池
+void DeviceInventory::CompactPool() {
+    std::string pool;
+    pool.reserve(pool_.size() - waste_);
+    auto move = [&](StrRef& r) {
+        uint32_t offset = (uint32_t)pool.size();
+        pool.append(pool_.data() + r.offset, r.length);
+        r.offset = offset;
+    };
+    for (size_t i = 0; i < ids_.size(); i++) {
+        move(ids_[i]); move(names_[i]); move(manufacturers_[i]); move(versions_[i]);
+        move(hardware_ids_[i]); move(compatible_ids_[i]);
+    }
+    pool_ = std::move(pool);
+    waste_ = 0;
+}
+
+bool DeviceInventory::Refresh(InventoryDiff* diff) {
+    if (diff) *diff = InventoryDiff();
+
+    if (!has_snapshot_) {
+        if (!Snapshot()) return false;
+        if (diff) {
+            for (size_t i = 0; i < Size(); i++) diff->added.emplace_back(InstanceId(i));
+        }
+        return true;
+    }
+
+    std::vector<DeviceKey> keys;
+    if (!provider_.EnumerateKeys(keys)) {
+        AUDIT_LOG("INVENTORY", "Refresh enumeration failed.");
+        return false;
+    }
+
+    std::unordered_set<std::string> invalid(invalidated_.begin(), invalidated_.end());
+    invalidated_.clear();
+    const size_t rows = Size();
+    std::vector<bool> keep(rows, false);
+    uint64_t generation = generation_ + 1;
+    bool modified = false;
+    size_t reads = 0;
+
+    // 先比對既有列並就地修補；新增設備最後附加 (附加可能使字串池重新配置，索引鍵需重建)
+    std::vector<const DeviceKey*> added;
+    DeviceRecord record;
+    const char* base = pool_.data();
+    for (const DeviceKey& k : keys) {
+        int row = Find(k.instance_id);
+        if (row < 0) {
+            added.push_back(&k);
+            continue;
+        }
+
+        bool stale = stamps_[row] != k.stamp || invalid.count(k.instance_id) > 0;
+        if (stale) {
+            // 驅動改變或被標記: 重讀完整屬性，讀取失敗視為移除
+            if (provider_.ReadDevice(k.instance_id, record)) {
+                PatchRow(row, record, k.stamp, generation);
+                if (pool_.data() != base) {
+                    // 字串池重新配置: 索引鍵 (string_view) 失效
+                    RebuildIndex();
+                    base = pool_.data();
+                }
+                if (diff) diff->changed.push_back(k.instance_id);
+                keep[row] = true;
+                reads++;
+            }
+            modified = true;
+        } else {
+            keep[row] = true;
+            if (status_[row] != k.status || problems_[row] != k.problem_code) {
+                // 只有狀態改變: 不需重讀屬性
+                status_[row] = k.status;
+                problems_[row] = k.problem_code;
+                row_generation_[row] = generation;
+                if (diff) diff->changed.push_back(k.instance_id);
+                modified = true;
+            }
+        }
+    }
+
+    bool removed = false;
+    for (size_t i = 0; i < rows; i++) {
+        if (!keep[i]) {
+            if (diff) diff->removed.emplace_back(InstanceId(i));
+            removed = true;
+        }
+    }
+
+    if (removed) RemoveRows(keep);
+    for (const DeviceKey* k : added) {
+        if (provider_.ReadDevice(k->instance_id, record)) {
+            AppendRow(record, k->stamp, generation);
+            if (diff) diff->added.push_back(k->instance_id);
+            reads++;
+        }
+    }
+    modified = modified || removed || !added.empty();
+    if (waste_ > pool_.size() / 2) CompactPool();
+    if (removed || !added.empty() || pool_.data() != base) RebuildIndex();
+
+    if (modified) {
+        generation_ = generation;
+        AUDIT_LOG("INVENTORY", "Refresh re-read " + std::to_string(reads) + " of " + std::to_string(Size()) +
+                  " devices, generation " + std::to_string(generation_));
+    }
+    return true;
+}
+
+void DeviceInventory::Invalidate(const std::string& instance_id) {
+    invalidated_.push_back(instance_id);
+}
+
+int DeviceInventory::Find(std::string_view instance_id) const {
+    auto it = index_.find(instance_id);
+    return it == index_.end() ? -1 : (int)it->second;
+}
+
+std::vector<std::string_view> DeviceInventory::Split(StrRef r) const {
+    std::vector<std::string_view> out;
+    if (r.length == 0) return out;
+
+    std::string_view all = View(r);
+    size_t start = 0;
+    while (true) {
+        size_t end = all.find('\0', start);
+        if (end == std::string_view::npos) {
+            out.push_back(all.substr(start));
+            break;
+        }
+        out.push_back(all.substr(start, end - start));
+        start = end + 1;
+    }
+    return out;
+}
+
+std::string_view DeviceInventory::PrimaryHardwareId(size_t row) const {
+    std::string_view all = View(hardware_ids_[row]);
+    size_t end = all.find('\0');
+    return end == std::string_view::npos ? all : all.substr(0, end);
+}
+
+DeviceRecord DeviceInventory::Record(size_t row) const {
+    DeviceRecord d;
+    d.instance_id = std::string(InstanceId(row));
+    d.name = std::string(Name(row));
+    d.manufacturer = std::string(Manufacturer(row));
+    d.driver_version = std::string(DriverVersion(row));
+    for (std::string_view s : HardwareIds(row)) d.hardware_ids.emplace_back(s);
+    for (std::string_view s : CompatibleIds(row)) d.compatible_ids.emplace_back(s);
+    d.status = Status(row);
+    d.problem_code = ProblemCode(row);
+    return d;
+}
+
+std::mutex& SharedDeviceInventoryLock() {
+    static std::mutex lock;
+    return lock;
+}
+
+DeviceInventory& SharedDeviceInventory() {
+    static std::unique_ptr<DeviceInventory> inventory;
+    static IDeviceProvider* bound = nullptr;
+
+    // 預設來源被替換 (測試) 時重新綁定
+    IDeviceProvider& provider = DefaultDeviceProvider();
+    if (!inventory || bound != &provider) {
+        inventory.reset(new DeviceInventory(provider));
+        bound = &provider;
+    }
+    return *inventory;
+}
@@ -0,0 +1,120 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 設備清單快照 (列式儲存)
+ * 功能: 一次快照全部設備屬性；之後以輕量列舉比對差異，只重讀並就地修補新增/變更的設備
+ */
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "device_provider.h"
+
+// 刷新差異
+struct InventoryDiff {
+    std::vector<std::string> added;
+    std::vector<std::string> removed;
+    std::vector<std::string> changed;
+
+    bool Empty() const { return added.empty() && removed.empty() && changed.empty(); }
+};
+
+class DeviceInventory {
+public:
+    explicit DeviceInventory(IDeviceProvider& provider) : provider_(provider) {}
+
+    /**
+     * [MAIDOS-AUDIT] 全量快照: 一次完整列舉，讀取全部屬性
+     * @return true=成功, false=列舉失敗 (保留舊快照)
+     */
+    bool Snapshot();
+
+    /**
+     * [MAIDOS-AUDIT] 增量刷新: 輕量列舉後只重讀新增、狀態/指紋改變及被標記的設備
+     * 尚無快照時等同 Snapshot()
+     * @param diff 輸出差異 (可為 nullptr)
+     * @return true=成功, false=列舉失敗 (保留舊快照)
+     */
+    bool Refresh(InventoryDiff* diff = nullptr);
+
+    // 標記設備需重讀 (例如收到 PnP 通知)
+    void Invalidate(const std::string& instance_id);
+
+    // 快照世代: 每次內容改變 +1
+    uint64_t Generation() const { return generation_; }
+
+    size_t Size() const { return ids_.size(); }
+    bool Empty() const { return ids_.empty(); }
+
+    // 依實例ID查列號，找不到回傳 -1
+    int Find(std::string_view instance_id) const;
+
+    std::string_view InstanceId(size_t row) const { return View(ids_[row]); }
+    std::string_view Name(size_t row) const { return View(names_[row]); }
+    std::string_view Manufacturer(size_t row) const { return View(manufacturers_[row]); }
+    std::string_view DriverVersion(size_t row) const { return View(versions_[row]); }
+    uint32_t Status(size_t row) const { return status_[row]; }
+    uint32_t ProblemCode(size_t row) const { return problems_[row]; }
+
+    // 列最後變更時的世代
+    uint64_t RowGeneration(size_t row) const { return row_generation_[row]; }
+
+    // 多字串欄位 (NUL 分隔)
+    std::vector<std::string_view> HardwareIds(size_t row) const { return Split(hardware_ids_[row]); }
+    std::vector<std::string_view> CompatibleIds(size_t row) const { return Split(compatible_ids_[row]); }
+
+    // 多字串原始內容 (項目以 NUL 分隔，無結尾 NUL)，不配置記憶體
+    std::string_view HardwareIdsRaw(size_t row) const { return View(hardware_ids_[row]); }
+    std::string_view CompatibleIdsRaw(size_t row) const { return View(compatible_ids_[row]); }
+
+    // 第一個硬體ID (無則空)
+    std::string_view PrimaryHardwareId(size_t row) const;
+
+    // 還原為 DeviceRecord
+    DeviceRecord Record(size_t row) const;
+
+    // 字串池大小 (位元組)
+    size_t PoolBytes() const { return pool_.size(); }
+
+private:
+    struct StrRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::string_view View(StrRef r) const { return std::string_view(pool_.data() + r.offset, r.length); }
+    std::vector<std::string_view> Split(StrRef r) const;
+
+    // 全量快照由建構器產生新表格；增量刷新直接修補現有欄位
+    class Builder;
+    void Adopt(Builder& builder);
+    void RebuildIndex();
+    void PatchString(StrRef& ref, std::string_view s);
+    void PatchRow(size_t row, const DeviceRecord& d, uint64_t stamp, uint64_t generation);
+    void AppendRow(const DeviceRecord& d, uint64_t stamp, uint64_t generation);
+    void RemoveRows(const std::vector<bool>& keep);
+    void CompactPool();
+
+    IDeviceProvider& provider_;
+    uint64_t generation_ = 0;
+    bool has_snapshot_ = false;
+
+    std::string pool_;
+    size_t waste_ = 0;        // 池中已不被任何列引用的位元組
+    std::string scratch_;     // 多字串組合暫存
+    std::vector<StrRef> ids_, names_, manufacturers_, versions_, hardware_ids_, compatible_ids_;
+    std::vector<uint32_t> status_, problems_;
+    std::vector<uint64_t> stamps_, row_generation_;
+    std::unordered_map<std::string_view, uint32_t> index_;
+    std::vector<std::string> invalidated_;
+};
+
+/**
+ * [MAIDOS-AUDIT] 行程共用清單 (預設設備來源)
+ * 使用前須持有 SharedDeviceInventoryLock()
+ */
+DeviceInventory& SharedDeviceInventory();
+std::mutex& SharedDeviceInventoryLock();
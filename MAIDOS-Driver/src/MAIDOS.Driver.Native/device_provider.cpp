@@ -0,0 +1,380 @@
+#pragma warning(disable: 4819)
+#include "device_provider.h"
+#include "logger.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <setupapi.h>
+#include <cfgmgr32.h>
+#include <initguid.h>
+#include <devpkey.h>
+
+#pragma comment(lib, "setupapi.lib")
+#pragma comment(lib, "cfgmgr32.lib")
+#pragma comment(lib, "advapi32.lib")
+#endif
+
+// [MAIDOS-AUDIT] 合成設備: 與 drivers.tsv 同樣的 PCI\VEN_xxxx&DEV_xxxx 格式
+std::vector<DeviceRecord> FakeDeviceProvider::Synthetic(size_t count) {
+    static const char* vendors[] = { "10DE", "1002", "8086", "10EC" };
+    static const char* makers[] = { "NVIDIA", "AMD", "Intel", "Realtek" };
+
+    std::vector<DeviceRecord> devices;
+    devices.reserve(count);
+    char buf[128];
+    for (size_t i = 0; i < count; i++) {
+        DeviceRecord d;
+        size_t v = i % 4;
+        unsigned dev = 0x1000 + (unsigned)(i % 4096);
+
+        snprintf(buf, sizeof(buf), "PCI\\VEN_%s&DEV_%04X&SUBSYS_%08X&REV_%02X",
+                 vendors[v], dev, (unsigned)(0x10000000 + i), (unsigned)(i % 256));
+        d.hardware_ids.push_back(buf);
+        snprintf(buf, sizeof(buf), "PCI\\VEN_%s&DEV_%04X", vendors[v], dev);
+        d.hardware_ids.push_back(buf);
+        snprintf(buf, sizeof(buf), "PCI\\CC_%04X", (unsigned)(0x0300 + v));
+        d.compatible_ids.push_back(buf);
+
+        snprintf(buf, sizeof(buf), "PCI\\VEN_%s&DEV_%04X\\4&%08zx&0&00E0", vendors[v], dev, i);
+        d.instance_id = buf;
+        snprintf(buf, sizeof(buf), "%s Device %zu", makers[v], i);
+        d.name = buf;
+        d.manufacturer = makers[v];
+        snprintf(buf, sizeof(buf), "%zu.%zu.%zu.%zu", 30 + v, i % 10, i % 100, i % 1000);
+        d.driver_version = buf;
+        d.status = DEVICE_STATUS_STARTED;
+        devices.push_back(std::move(d));
+    }
+    return devices;
+}
+
+bool FakeDeviceProvider::EnumerateKeys(std::vector<DeviceKey>& out) {
+    enumerations_++;
+    out.clear();
+    if (fail_) return false;
+
+    out.reserve(devices_.size());
+    for (const DeviceRecord& d : devices_) {
+        DeviceKey k;
+        k.instance_id = d.instance_id;
+        k.status = d.status;
+        k.problem_code = d.problem_code;
+        k.stamp = DeviceStamp(d.driver_version);
+        out.push_back(std::move(k));
+    }
+    return true;
+}
+
+bool FakeDeviceProvider::ReadDevice(const std::string& instance_id, DeviceRecord& out) {
+    if (fail_) return false;
+
+    // 索引可能因 Devices() 被修改而過期: 驗證後必要時重建
+    auto lookup = [&]() -> const DeviceRecord* {
+        auto it = index_.find(instance_id);
+        if (it == index_.end() || it->second >= devices_.size()) return nullptr;
+        const DeviceRecord& d = devices_[it->second];
+        return d.instance_id == instance_id ? &d : nullptr;
+    };
+    const DeviceRecord* found = lookup();
+    if (!found) {
+        index_.clear();
+        for (size_t i = 0; i < devices_.size(); i++) index_[devices_[i].instance_id] = i;
+        found = lookup();
+    }
+    if (!found) return false;
+
+    property_reads_++;
+    out = *found;
+    return true;
+}
+
+void FakeDeviceProvider::SetNode(const std::string& instance_id, const std::string& parent_id,
+                                 std::vector<DeviceResource> resources) {
+    DeviceNode& node = nodes_[instance_id];
+    node.instance_id = instance_id;
+    node.parent_id = parent_id;
+    node.resources = std::move(resources);
+}
+
+bool FakeDeviceProvider::EnumerateNodes(std::vector<DeviceNode>& out) {
+    enumerations_++;
+    out.clear();
+    if (fail_) return false;
+
+    out.reserve(devices_.size());
+    for (const DeviceRecord& d : devices_) {
+        auto it = nodes_.find(d.instance_id);
+        DeviceNode n = it != nodes_.end() ? it->second : DeviceNode();
+        n.instance_id = d.instance_id;
+        n.status = d.status;
+        n.problem_code = d.problem_code;
+        out.push_back(std::move(n));
+    }
+    return true;
+}
+
+#ifdef _WIN32
+// 讀取字串/多字串屬性到可重用緩衝區；多字串拆成 vector
+static bool ReadProperty(HDEVINFO devInfo, PSP_DEVINFO_DATA devData, DWORD property, std::vector<char>& buf) {
+    DWORD dataType = 0;
+    DWORD required = 0;
+    if (buf.size() < 512) buf.resize(512);
+    if (!SetupDiGetDeviceRegistryPropertyA(devInfo, devData, property, &dataType,
+            (PBYTE)buf.data(), (DWORD)buf.size() - 2, &required)) {
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return false;
+        buf.resize(required + 2);
+        if (!SetupDiGetDeviceRegistryPropertyA(devInfo, devData, property, &dataType,
+                (PBYTE)buf.data(), (DWORD)buf.size() - 2, &required)) {
+            return false;
+        }
+    }
+    // 保證雙 NUL 結尾
+    buf[required] = '\0';
+    buf[required + 1] = '\0';
+    return true;
+}
+
+static void SplitMultiString(const char* p, std::vector<std::string>& out) {
+    while (*p) {
+        std::string s(p);
+        p += s.size() + 1;
+        out.push_back(std::move(s));
+    }
+}
+
+// 驅動版本: 以 devnode 屬性 DEVPKEY_Device_DriverVersion 讀取，不需每設備開啟驅動登錄鍵
+static std::string ReadDriverVersion(DEVINST devInst) {
+    WCHAR version[64] = { 0 };
+    ULONG size = sizeof(version) - sizeof(WCHAR);
+    DEVPROPTYPE type = 0;
+    if (CM_Get_DevNode_PropertyW(devInst, &DEVPKEY_Device_DriverVersion, &type, (PBYTE)version, &size, 0) != CR_SUCCESS ||
+        type != DEVPROP_TYPE_STRING) {
+        return std::string();
+    }
+
+    // 版本字串只含 ASCII 數字與句點
+    std::string result;
+    for (const WCHAR* p = version; *p; p++) result.push_back((char)*p);
+    return result;
+}
+
+static void ReadStatus(DEVINST devInst, uint32_t& statusFlags, uint32_t& problemCode) {
+    ULONG status = 0, problem = 0;
+    statusFlags = 0;
+    problemCode = 0;
+    if (CM_Get_DevNode_Status(&status, &problem, devInst, 0) == CR_SUCCESS) {
+        if (status & DN_STARTED) statusFlags |= DEVICE_STATUS_STARTED;
+        if (status & DN_HAS_PROBLEM) {
+            statusFlags |= DEVICE_STATUS_HAS_PROBLEM;
+            problemCode = problem;
+            if (problem == CM_PROB_DISABLED) statusFlags |= DEVICE_STATUS_DISABLED;
+        }
+    }
+}
+
+static void ReadRecord(HDEVINFO devInfo, PSP_DEVINFO_DATA devData, const char* instanceId,
+                       std::vector<char>& buf, DeviceRecord& d) {
+    d = DeviceRecord();
+    d.instance_id = instanceId;
+    if (ReadProperty(devInfo, devData, SPDRP_HARDWAREID, buf)) SplitMultiString(buf.data(), d.hardware_ids);
+    if (ReadProperty(devInfo, devData, SPDRP_COMPATIBLEIDS, buf)) SplitMultiString(buf.data(), d.compatible_ids);
+    if (ReadProperty(devInfo, devData, SPDRP_FRIENDLYNAME, buf) ||
+        ReadProperty(devInfo, devData, SPDRP_DEVICEDESC, buf)) {
+        d.name = buf.data();
+    }
+    if (ReadProperty(devInfo, devData, SPDRP_MFG, buf)) d.manufacturer = buf.data();
+    d.driver_version = ReadDriverVersion(devData->DevInst);
+    ReadStatus(devData->DevInst, d.status, d.problem_code);
+}
+
+bool SetupApiDeviceProvider::Enumerate(std::vector<DeviceRecord>& out) {
+    AUDIT_ENTRY(SetupApiDeviceProvider::Enumerate);
+    enumerations_.fetch_add(1, std::memory_order_relaxed);
+    out.clear();
+
+    HDEVINFO devInfo = SetupDiGetClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
+    if (devInfo == INVALID_HANDLE_VALUE) {
+        AUDIT_LOG("DEVICE", "Failed to get device list.");
+        return false;
+    }
+
+    SP_DEVINFO_DATA devData;
+    devData.cbSize = sizeof(SP_DEVINFO_DATA);
+    std::vector<char> buf(512);
+    char instanceId[MAX_DEVICE_ID_LEN];
+
+    for (DWORD i = 0; SetupDiEnumDeviceInfo(devInfo, i, &devData); i++) {
+        if (!SetupDiGetDeviceInstanceIdA(devInfo, &devData, instanceId, MAX_DEVICE_ID_LEN, NULL)) continue;
+        out.emplace_back();
+        ReadRecord(devInfo, &devData, instanceId, buf, out.back());
+    }
+    property_reads_.fetch_add(out.size(), std::memory_order_relaxed);
+
+    SetupDiDestroyDeviceInfoList(devInfo);
+    AUDIT_LOG("DEVICE", "Enumerated " + std::to_string(out.size()) + " devices.");
+    AUDIT_EXIT(SetupApiDeviceProvider::Enumerate);
+    return true;
+}
+
+bool SetupApiDeviceProvider::EnumerateKeys(std::vector<DeviceKey>& out) {
+    enumerations_.fetch_add(1, std::memory_order_relaxed);
+    out.clear();
+
+    HDEVINFO devInfo = SetupDiGetClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
+    if (devInfo == INVALID_HANDLE_VALUE) {
+        AUDIT_LOG("DEVICE", "Failed to get device list.");
+        return false;
+    }
+
+    SP_DEVINFO_DATA devData;
+    devData.cbSize = sizeof(SP_DEVINFO_DATA);
+    char instanceId[MAX_DEVICE_ID_LEN];
+
+    for (DWORD i = 0; SetupDiEnumDeviceInfo(devInfo, i, &devData); i++) {
+        if (!SetupDiGetDeviceInstanceIdA(devInfo, &devData, instanceId, MAX_DEVICE_ID_LEN, NULL)) continue;
+        DeviceKey k;
+        k.instance_id = instanceId;
+        ReadStatus(devData.DevInst, k.status, k.problem_code);
+        k.stamp = DeviceStamp(ReadDriverVersion(devData.DevInst));
+        out.push_back(std::move(k));
+    }
+
+    SetupDiDestroyDeviceInfoList(devInfo);
+    return true;
+}
+
+bool SetupApiDeviceProvider::ReadDevice(const std::string& instance_id, DeviceRecord& out) {
+    // 只解析這一個 devnode；NORMAL 旗標排除不存在的 (phantom) 設備，與 DIGCF_PRESENT 列舉一致
+    DEVINST devInst = 0;
+    if (CM_Locate_DevNodeA(&devInst, (DEVINSTID_A)instance_id.c_str(), CM_LOCATE_DEVNODE_NORMAL) != CR_SUCCESS) {
+        return false;
+    }
+
+    HDEVINFO devInfo = SetupDiCreateDeviceInfoList(NULL, NULL);
+    if (devInfo == INVALID_HANDLE_VALUE) return false;
+
+    SP_DEVINFO_DATA devData;
+    devData.cbSize = sizeof(SP_DEVINFO_DATA);
+    bool ok = SetupDiOpenDeviceInfoA(devInfo, instance_id.c_str(), NULL, 0, &devData) != FALSE;
+    if (ok) {
+        std::vector<char> buf(512);
+        ReadRecord(devInfo, &devData, instance_id.c_str(), buf, out);
+        property_reads_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    SetupDiDestroyDeviceInfoList(devInfo);
+    return ok;
+}
+
+// 讀取已配置資源 (ALLOC_LOG_CONF)；不認得的資源類型略過
+static void ReadResources(DEVINST devInst, std::vector<BYTE>& buf, std::vector<DeviceResource>& out) {
+    LOG_CONF logConf;
+    if (CM_Get_First_Log_Conf(&logConf, devInst, ALLOC_LOG_CONF) != CR_SUCCESS) return;
+
+    RES_DES current = (RES_DES)logConf;
+    RES_DES next;
+    RESOURCEID resId;
+    while (CM_Get_Next_Res_Des(&next, current, ResType_All, &resId, 0) == CR_SUCCESS) {
+        if (current != (RES_DES)logConf) CM_Free_Res_Des_Handle(current);
+        current = next;
+
+        ULONG size = 0;
+        if (CM_Get_Res_Des_Data_Size(&size, current, 0) != CR_SUCCESS || size == 0) continue;
+        if (buf.size() < size) buf.resize(size);
+        if (CM_Get_Res_Des_Data(current, buf.data(), size, 0) != CR_SUCCESS) continue;
+
+        DeviceResource r;
+        if (resId == ResType_IRQ && size >= sizeof(IRQ_DES)) {
+            const IRQ_DES* irq = (const IRQ_DES*)buf.data();
+            r.type = DEVICE_RESOURCE_IRQ;
+            r.start = r.end = irq->IRQD_Alloc_Num;
+            // MSI 以負值向量回報，不會與線路 IRQ 衝突
+            if ((irq->IRQD_Flags & mIRQD_Share) == fIRQD_Share || (LONG)irq->IRQD_Alloc_Num < 0) {
+                r.flags |= DEVICE_RESOURCE_SHARED;
+            }
+        } else if (resId == ResType_Mem && size >= sizeof(MEM_DES)) {
+            const MEM_DES* mem = (const MEM_DES*)buf.data();
+            r.type = DEVICE_RESOURCE_MEMORY;
+            r.start = mem->MD_Alloc_Base;
+            r.end = mem->MD_Alloc_End;
+#ifdef ResType_MemLarge
+        } else if (resId == ResType_MemLarge && size >= sizeof(MEM_LARGE_DES)) {
+            const MEM_LARGE_DES* mem = (const MEM_LARGE_DES*)buf.data();
+            r.type = DEVICE_RESOURCE_MEMORY;
+            r.start = mem->MLD_Alloc_Base;
+            r.end = mem->MLD_Alloc_End;
+#endif
+        } else if (resId == ResType_IO && size >= sizeof(IO_DES)) {
+            const IO_DES* io = (const IO_DES*)buf.data();
+            r.type = DEVICE_RESOURCE_IO;
+            r.start = io->IOD_Alloc_Base;
+            r.end = io->IOD_Alloc_End;
+        } else if (resId == ResType_DMA && size >= sizeof(DMA_DES)) {
+            const DMA_DES* dma = (const DMA_DES*)buf.data();
+            r.type = DEVICE_RESOURCE_DMA;
+            r.start = r.end = dma->DD_Alloc_Chan;
+        } else {
+            continue;
+        }
+        out.push_back(r);
+    }
+
+    if (current != (RES_DES)logConf) CM_Free_Res_Des_Handle(current);
+    CM_Free_Log_Conf_Handle(logConf);
+}
+
+bool SetupApiDeviceProvider::EnumerateNodes(std::vector<DeviceNode>& out) {
+    AUDIT_ENTRY(SetupApiDeviceProvider::EnumerateNodes);
+    enumerations_.fetch_add(1, std::memory_order_relaxed);
+    out.clear();
+
+    HDEVINFO devInfo = SetupDiGetClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
+    if (devInfo == INVALID_HANDLE_VALUE) {
+        AUDIT_LOG("DEVICE", "Failed to get device list.");
+        return false;
+    }
+
+    SP_DEVINFO_DATA devData;
+    devData.cbSize = sizeof(SP_DEVINFO_DATA);
+    std::vector<BYTE> buf(256);
+    char instanceId[MAX_DEVICE_ID_LEN];
+
+    for (DWORD i = 0; SetupDiEnumDeviceInfo(devInfo, i, &devData); i++) {
+        if (!SetupDiGetDeviceInstanceIdA(devInfo, &devData, instanceId, MAX_DEVICE_ID_LEN, NULL)) continue;
+        out.emplace_back();
+        DeviceNode& n = out.back();
+        n.instance_id = instanceId;
+        ReadStatus(devData.DevInst, n.status, n.problem_code);
+
+        DEVINST parent;
+        if (CM_Get_Parent(&parent, devData.DevInst, 0) == CR_SUCCESS &&
+            CM_Get_Device_IDA(parent, instanceId, MAX_DEVICE_ID_LEN, 0) == CR_SUCCESS) {
+            n.parent_id = instanceId;
+        }
+        ReadResources(devData.DevInst, buf, n.resources);
+    }
+
+    SetupDiDestroyDeviceInfoList(devInfo);
+    AUDIT_LOG("DEVICE", "Walked " + std::to_string(out.size()) + " device nodes.");
+    AUDIT_EXIT(SetupApiDeviceProvider::EnumerateNodes);
+    return true;
+}
+#endif
+
+static IDeviceProvider* g_override = nullptr;
+
+IDeviceProvider& DefaultDeviceProvider() {
+    if (g_override) return *g_override;
+#ifdef _WIN32
+    static SetupApiDeviceProvider provider;
+#else
+    static FakeDeviceProvider provider;
+#endif
+    return provider;
+}
+
+void SetDefaultDeviceProvider(IDeviceProvider* provider) {
+    g_override = provider;
+}
@@ -0,0 +1,190 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 設備來源抽象層
+ * 功能: 一次列舉全部設備及其屬性；Windows 走 SetupAPI，其他平台/測試走記憶體假資料
+ */
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+
+// 設備狀態 (對應 CM_Get_DevNode_Status 的 DN_* 旗標子集)
+enum DeviceStatusFlags : uint32_t {
+    DEVICE_STATUS_STARTED     = 0x1,
+    DEVICE_STATUS_HAS_PROBLEM = 0x2,
+    DEVICE_STATUS_DISABLED    = 0x4,
+};
+
+// 單一設備的一次性快照
+struct DeviceRecord {
+    std::string instance_id;                  // 設備實例ID (PCI\VEN_10DE&DEV_2684\4&...)
+    std::vector<std::string> hardware_ids;    // SPDRP_HARDWAREID (多字串，完整保留)
+    std::vector<std::string> compatible_ids;  // SPDRP_COMPATIBLEIDS
+    std::string name;                         // FriendlyName，無則 DeviceDesc
+    std::string manufacturer;                 // SPDRP_MFG
+    std::string driver_version;               // 驅動鍵 DriverVersion，無驅動為空
+    uint32_t status = 0;                      // DeviceStatusFlags
+    uint32_t problem_code = 0;                // CM_PROB_*
+};
+
+// 輕量列舉結果: 不讀屬性，只取實例ID、狀態與變更指紋
+struct DeviceKey {
+    std::string instance_id;
+    uint32_t status = 0;
+    uint32_t problem_code = 0;
+    uint64_t stamp = 0;  // 廉價變更指紋 = DeviceStamp(驅動版本)，驅動更換時改變
+};
+
+// 已配置資源類型
+enum DeviceResourceType : uint32_t {
+    DEVICE_RESOURCE_IRQ    = 1,
+    DEVICE_RESOURCE_MEMORY = 2,
+    DEVICE_RESOURCE_IO     = 3,
+    DEVICE_RESOURCE_DMA    = 4,
+};
+
+// 資源旗標
+enum DeviceResourceFlags : uint32_t {
+    DEVICE_RESOURCE_SHARED = 0x1,  // 可共用 (IRQ 共用/MSI)
+};
+
+// 單一已配置資源；IRQ/DMA 的 start == end == 編號，記憶體/IO 為含端點的位址範圍
+struct DeviceResource {
+    uint32_t type = 0;   // DeviceResourceType
+    uint32_t flags = 0;  // DeviceResourceFlags
+    uint64_t start = 0;
+    uint64_t end = 0;
+};
+
+// 診斷用節點: 狀態 + 設備樹父節點 + 已配置資源 (ALLOC_LOG_CONF)
+struct DeviceNode {
+    std::string instance_id;
+    std::string parent_id;                   // 根節點為空
+    uint32_t status = 0;                     // DeviceStatusFlags
+    uint32_t problem_code = 0;               // CM_PROB_*
+    std::vector<DeviceResource> resources;
+};
+
+// FNV-1a 64 位元雜湊 (變更指紋/屬性雜湊共用)
+inline uint64_t Fnv1a64(const char* data, size_t len, uint64_t hash = 1469598103934665603ULL) {
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// 設備變更指紋 (所有來源一致使用)
+inline uint64_t DeviceStamp(const std::string& driver_version) {
+    return Fnv1a64(driver_version.data(), driver_version.size());
+}
+
+/**
+ * [MAIDOS-AUDIT] 設備來源介面
+ * 每次 Enumerate 只做一次完整列舉 (SetupAPI 上即一次 SetupDiGetClassDevs)
+ */
+class IDeviceProvider {
+public:
+    virtual ~IDeviceProvider() = default;
+
+    /**
+     * 列舉所有存在的設備
+     * @param out 輸出 (先清空)
+     * @return true=成功, false=列舉失敗
+     */
+    virtual bool Enumerate(std::vector<DeviceRecord>& out) = 0;
+
+    /**
+     * 輕量列舉 (增量刷新用): 每設備只讀狀態與變更指紋
+     * @return true=成功, false=列舉失敗
+     */
+    virtual bool EnumerateKeys(std::vector<DeviceKey>& out) = 0;
+
+    /**
+     * 讀取單一設備完整屬性
+     * @return true=成功, false=設備不存在
+     */
+    virtual bool ReadDevice(const std::string& instance_id, DeviceRecord& out) = 0;
+
+    /**
+     * 診斷列舉: 一次走訪設備樹，讀取狀態、父節點與已配置資源
+     * @return true=成功, false=列舉失敗
+     */
+    virtual bool EnumerateNodes(std::vector<DeviceNode>& out) = 0;
+
+    // 供基準測試統計: 已執行的完整列舉次數
+    virtual uint64_t EnumerationCount() const = 0;
+
+    // 供基準測試統計: 已讀取完整屬性的設備數 (完整列舉計入每個設備)
+    virtual uint64_t PropertyReadCount() const = 0;
+};
+
+/**
+ * [MAIDOS-AUDIT] 記憶體假資料來源 (Linux 測試/基準)
+ */
+class FakeDeviceProvider : public IDeviceProvider {
+public:
+    FakeDeviceProvider() = default;
+    explicit FakeDeviceProvider(std::vector<DeviceRecord> devices) : devices_(std::move(devices)) {}
+
+    bool Enumerate(std::vector<DeviceRecord>& out) override {
+        enumerations_++;
+        if (fail_) return false;
+        out = devices_;
+        property_reads_ += devices_.size();
+        return true;
+    }
+
+    bool EnumerateKeys(std::vector<DeviceKey>& out) override;
+    bool ReadDevice(const std::string& instance_id, DeviceRecord& out) override;
+    bool EnumerateNodes(std::vector<DeviceNode>& out) override;
+
+    uint64_t EnumerationCount() const override { return enumerations_; }
+    uint64_t PropertyReadCount() const override { return property_reads_; }
+
+    std::vector<DeviceRecord>& Devices() { return devices_; }
+    void SetFailure(bool fail) { fail_ = fail; }
+
+    // 假設備樹: 設定父節點與已配置資源 (狀態取自 Devices())
+    void SetNode(const std::string& instance_id, const std::string& parent_id, std::vector<DeviceResource> resources = {});
+
+    // 產生 count 個合成 PCI 設備 (VEN/DEV 循環、版本遞增)
+    static std::vector<DeviceRecord> Synthetic(size_t count);
+
+private:
+    std::vector<DeviceRecord> devices_;
+    std::unordered_map<std::string, size_t> index_;  // ReadDevice 查找用
+    std::unordered_map<std::string, DeviceNode> nodes_;  // 父節點/資源
+    uint64_t enumerations_ = 0;
+    uint64_t property_reads_ = 0;
+    bool fail_ = false;
+};
+
+#ifdef _WIN32
+/**
+ * [MAIDOS-AUDIT] SetupAPI 實機來源
+ */
+class SetupApiDeviceProvider : public IDeviceProvider {
+public:
+    bool Enumerate(std::vector<DeviceRecord>& out) override;
+    bool EnumerateKeys(std::vector<DeviceKey>& out) override;
+    bool ReadDevice(const std::string& instance_id, DeviceRecord& out) override;
+    bool EnumerateNodes(std::vector<DeviceNode>& out) override;
+    uint64_t EnumerationCount() const override { return enumerations_.load(std::memory_order_relaxed); }
+    uint64_t PropertyReadCount() const override { return property_reads_.load(std::memory_order_relaxed); }
+
+private:
+    // DefaultDeviceProvider() 為共用靜態實例，並行匯出同時計數
+    std::atomic<uint64_t> enumerations_{ 0 };
+    std::atomic<uint64_t> property_reads_{ 0 };
+};
+#endif
+
+// 平台預設來源 (Windows=SetupAPI, 其他=空的假資料)
+IDeviceProvider& DefaultDeviceProvider();
+
+// 替換預設來源 (測試用，nullptr=恢復平台預設)
+void SetDefaultDeviceProvider(IDeviceProvider* provider);
@@ -4,6 +4,8 @@
 #include <cfgmgr32.h>
 #include <string>
 #include "logger.h"
+#include "device_diagnostics.h"
+#include "resource_conflicts.h"
 
 #pragma comment(lib, "setupapi.lib")
 #pragma comment(lib, "cfgmgr32.lib")
@@ -69,8 +71,7 @@ extern "C" {
         if (cr == CR_SUCCESS) {
             cr = CM_Get_Res_Des_Data(resDes, resData, sizeof(resData), 0);
             if (cr == CR_SUCCESS) {
-                unsigned int* pIrq = (unsigned int*)(resData + sizeof(unsigned int)); 
-                int irq = (int)(*pIrq);
+                int irq = (int)((const IRQ_DES*)resData)->IRQD_Alloc_Num;
                 AUDIT_LOG("DIAG", "Device IRQ: " + std::to_string(irq));
                 CM_Free_Res_Des_Handle(resDes);
                 CM_Free_Log_Conf_Handle(logConf);
@@ -83,4 +84,50 @@ extern "C" {
         AUDIT_EXIT(get_device_irq);
         return 0;
     }
+
+    /**
+     * [MAIDOS-AUDIT] 批次診斷: 一次走訪設備樹，全部設備的問題碼、狀態、診斷結果與已配置資源
+     * 以 device_diagnostics.h 的區塊格式寫入呼叫端緩衝區
+     * 每次呼叫都重新列舉；先給足夠大的緩衝區 (例如 64 KB) 通常一次即可，回傳 -2 時依 needed_size 重試
+     * @param needed_size 輸出所需位元組數 (可為 NULL)
+     * @return 設備數量, -1=列舉失敗, -2=緩衝區不足
+     */
+    __declspec(dllexport) int diagnose_all_devices(unsigned char* buffer, int buffer_size, int* needed_size) {
+        AUDIT_ENTRY(diagnose_all_devices);
+        DiagnosticsReport report;
+        if (!RunDeviceDiagnostics(DefaultDeviceProvider(), report)) return -1;
+
+        size_t needed = 0;
+        size_t written = EncodeDiagnosticsBlob(report, buffer, buffer_size > 0 ? (size_t)buffer_size : 0, &needed);
+        if (needed_size) *needed_size = (int)needed;
+        if (written == 0) return -2;
+
+        AUDIT_EXIT(diagnose_all_devices);
+        return (int)report.nodes.size();
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 整機資源衝突分析: 一次走訪設備樹，IRQ/記憶體/IO/DMA 依類型建區間樹找出重疊
+     * 以 resource_conflicts.h 的區塊格式寫入呼叫端緩衝區 (每次呼叫重新列舉，-2 時依 needed_size 重試)
+     * @param needed_size 輸出所需位元組數 (可為 NULL)
+     * @return 衝突數量 (不含可共用的重疊), -1=列舉失敗, -2=緩衝區不足
+     */
+    __declspec(dllexport) int analyze_resource_conflicts(unsigned char* buffer, int buffer_size, int* needed_size) {
+        AUDIT_ENTRY(analyze_resource_conflicts);
+        DiagnosticsReport report;
+        if (!RunDeviceDiagnostics(DefaultDeviceProvider(), report)) return -1;
+
+        ResourceMap map;
+        map.Build(report);
+        std::vector<ResourceOverlap> overlaps;
+        size_t conflicts = map.FindOverlaps(overlaps);
+
+        size_t needed = 0;
+        size_t written = EncodeConflictBlob(report, overlaps, buffer, buffer_size > 0 ? (size_t)buffer_size : 0, &needed);
+        if (needed_size) *needed_size = (int)needed;
+        if (written == 0) return -2;
+
+        AUDIT_EXIT(analyze_resource_conflicts);
+        return (int)conflicts;
+    }
 }
\ No newline at end of file
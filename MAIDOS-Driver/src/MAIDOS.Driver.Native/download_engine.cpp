@@ -0,0 +1,516 @@
+#pragma warning(disable: 4819)
+#include "download_engine.h"
+#include "logger.h"
+#include "sha256.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define WRITE_BUFFER_SIZE (1024 * 1024)
+
+namespace {
+
+// 可多執行緒定位讀寫的檔案 (pwrite/pread 或 OVERLAPPED 位移)
+class PartFile {
+public:
+    ~PartFile() { Close(); }
+
+    bool Open(const std::string& path, bool truncate) {
+#ifdef _WIN32
+        handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+                              truncate ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        return handle_ != INVALID_HANDLE_VALUE;
+#else
+        fd_ = open(path.c_str(), O_RDWR | (truncate ? O_CREAT | O_TRUNC : 0), 0644);
+        return fd_ >= 0;
+#endif
+    }
+
+    uint64_t Size() const {
+#ifdef _WIN32
+        LARGE_INTEGER size;
+        return GetFileSizeEx(handle_, &size) ? (uint64_t)size.QuadPart : 0;
+#else
+        struct stat st;
+        return fstat(fd_, &st) == 0 ? (uint64_t)st.st_size : 0;
+#endif
+    }
+
+    // 預先配置完整大小，避免並行寫入造成碎片與稀疏檔
+    bool Resize(uint64_t size) {
+#ifdef _WIN32
+        LARGE_INTEGER pos;
+        pos.QuadPart = (LONGLONG)size;
+        return SetFilePointerEx(handle_, pos, NULL, FILE_BEGIN) && SetEndOfFile(handle_);
+#else
+#if defined(__linux__)
+        if (size > 0 && posix_fallocate(fd_, 0, (off_t)size) == 0) return true;
+#endif
+        return ftruncate(fd_, (off_t)size) == 0;
+#endif
+    }
+
+    bool WriteAt(uint64_t offset, const char* data, size_t len) {
+        while (len > 0) {
+#ifdef _WIN32
+            OVERLAPPED ov = {};
+            ov.Offset = (DWORD)offset;
+            ov.OffsetHigh = (DWORD)(offset >> 32);
+            DWORD n = 0;
+            DWORD part = len > 0x40000000 ? 0x40000000 : (DWORD)len;
+            if (!WriteFile(handle_, data, part, &n, &ov) || n == 0) return false;
+#else
+            ssize_t n = pwrite(fd_, data, len, (off_t)offset);
+            if (n <= 0) return false;
+#endif
+            data += n;
+            len -= (size_t)n;
+            offset += (uint64_t)n;
+        }
+        return true;
+    }
+
+    bool ReadAt(uint64_t offset, char* data, size_t len) {
+        while (len > 0) {
+#ifdef _WIN32
+            OVERLAPPED ov = {};
+            ov.Offset = (DWORD)offset;
+            ov.OffsetHigh = (DWORD)(offset >> 32);
+            DWORD n = 0;
+            if (!ReadFile(handle_, data, (DWORD)len, &n, &ov) || n == 0) return false;
+#else
+            ssize_t n = pread(fd_, data, len, (off_t)offset);
+            if (n <= 0) return false;
+#endif
+            data += n;
+            len -= (size_t)n;
+            offset += (uint64_t)n;
+        }
+        return true;
+    }
+
+    bool Flush() {
+#ifdef _WIN32
+        return FlushFileBuffers(handle_) != FALSE;
+#elif defined(__linux__)
+        return fdatasync(fd_) == 0;
+#else
+        return fsync(fd_) == 0;
+#endif
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+#else
+        if (fd_ >= 0) close(fd_);
+        fd_ = -1;
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+};
+
+// 區塊完成狀態 (.part.map)
+struct ChunkMap {
+    std::string source;
+    std::string validator;   // 強 ETag 或 Last-Modified；續傳請求以 If-Range 帶回
+    uint64_t total = 0;
+    uint64_t chunk = 0;
+    std::vector<uint8_t> done;
+
+    bool Load(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        if (!std::getline(in, line) || line != "MAIDOS-PART 2") return false;
+        std::string bits;
+        while (std::getline(in, line)) {
+            size_t tab = line.find('\t');
+            if (tab == std::string::npos) continue;
+            std::string key = line.substr(0, tab), value = line.substr(tab + 1);
+            if (key == "source") source = value;
+            else if (key == "validator") validator = value;
+            else if (key == "total") total = strtoull(value.c_str(), nullptr, 10);
+            else if (key == "chunk") chunk = strtoull(value.c_str(), nullptr, 10);
+            else if (key == "done") bits = value;
+        }
+        if (chunk == 0 || bits.size() != (total + chunk - 1) / chunk) return false;
+        done.resize(bits.size());
+        for (size_t i = 0; i < bits.size(); i++) done[i] = bits[i] == '1';
+        return true;
+    }
+
+    // 寫入暫存檔後改名，中斷時不會留下半個狀態檔
+    bool Save(const std::string& path) const;
+};
+
+bool CommitFile(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+bool ChunkMap::Save(const std::string& path) const {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << "MAIDOS-PART 2\nsource\t" << source << "\nvalidator\t" << validator << "\ntotal\t" << total
+            << "\nchunk\t" << chunk << "\ndone\t";
+        for (uint8_t d : done) out << (d ? '1' : '0');
+        out << "\n";
+        if (!out.flush()) return false;
+    }
+    return CommitFile(tmp, path);
+}
+
+// "bytes 0-0/12345" → 起始位移與總長度
+bool ParseContentRange(const std::string& value, uint64_t& start, uint64_t& total) {
+    if (value.compare(0, 6, "bytes ") != 0) return false;
+    const char* p = value.c_str() + 6;
+    char* end = nullptr;
+    start = strtoull(p, &end, 10);
+    const char* slash = strchr(p, '/');
+    if (end == p || !slash || slash[1] == '*') return false;
+    total = strtoull(slash + 1, nullptr, 10);
+    return true;
+}
+
+// 緩衝寫入器: 累積到 1MB 再定位寫入
+class ChunkWriter {
+public:
+    ChunkWriter(PartFile& file, uint64_t offset) : file_(file), offset_(offset) { buffer_.reserve(WRITE_BUFFER_SIZE); }
+
+    bool Write(const char* data, size_t len) {
+        if (buffer_.size() + len > WRITE_BUFFER_SIZE && !Flush()) return false;
+        if (len >= WRITE_BUFFER_SIZE) {
+            if (!file_.WriteAt(offset_, data, len)) return false;
+            offset_ += len;
+            return true;
+        }
+        buffer_.insert(buffer_.end(), data, data + len);
+        return true;
+    }
+
+    bool Flush() {
+        if (buffer_.empty()) return true;
+        bool ok = file_.WriteAt(offset_, buffer_.data(), buffer_.size());
+        offset_ += buffer_.size();
+        buffer_.clear();
+        return ok;
+    }
+
+private:
+    PartFile& file_;
+    uint64_t offset_;
+    std::vector<char> buffer_;
+};
+
+void RemoveFile(const std::string& path) { remove(path.c_str()); }
+
+// If-Range 驗證值: 強 ETag 優先 (弱 ETag 不可用於 If-Range)，否則 Last-Modified；都沒有時回傳空 (不可續傳)
+std::string RangeValidator(const HttpResponse& response) {
+    std::string etag = response.Header("etag");
+    if (!etag.empty() && etag.compare(0, 2, "W/") != 0) return etag;
+    return response.Header("last-modified");
+}
+
+}  // namespace
+
+DownloadResult ChunkedDownloader::Download(const std::string& source, const std::string& save_path) {
+    DownloadResult result;
+    const std::string part = DownloadPartPath(save_path);
+    const std::string mapPath = DownloadMapPath(save_path);
+    const bool verify = IsSha256Hex(options_.expected_sha256);
+    auto cancelled = [&]() { return options_.cancel && options_.cancel->load(); };
+
+    PartFile file;
+    Sha256 hasher;
+    std::atomic<uint64_t> done_bytes{ 0 };
+    std::atomic<uint64_t> fetched{ 0 };
+    std::atomic<uint64_t> requests{ 0 };
+
+    // 探測: Range bytes=0-0；伺服器忽略 Range (200) 時直接以單一串流寫完整檔
+    HttpResponse probe;
+    std::unique_ptr<ChunkWriter> stream;
+    bool write_failed = false;
+    auto send_probe = [&](bool ranged) {
+        HttpRequest req;
+        req.path = source;
+        if (ranged) req.headers.emplace_back("Range", "bytes=0-0");
+        req.sink = [&](const char* data, size_t len) {
+            if (probe.status == 206) return true;
+            if (!stream) {
+                if (!file.Open(part, true)) {
+                    write_failed = true;
+                    return false;
+                }
+                stream.reset(new ChunkWriter(file, 0));
+            }
+            if (options_.throttle) options_.throttle(len);
+            if (cancelled()) return false;
+            if (!stream->Write(data, len)) {
+                write_failed = true;
+                return false;
+            }
+            hasher.Update(data, len);
+            fetched += len;
+            if (options_.progress) options_.progress(fetched.load(), 0);
+            return true;
+        };
+        requests++;
+        return transport_.Send(req, probe, options_.timeout_ms);
+    };
+
+    bool sent = send_probe(true);
+    if (sent && probe.status == 416) sent = send_probe(false);  // 空檔案或不接受 Range
+    result.requests = requests.load();
+
+    if (!sent || (probe.status != 200 && probe.status != 206)) {
+        file.Close();
+        if (stream) RemoveFile(part);
+        result.status = cancelled() ? DOWNLOAD_CANCELLED : DOWNLOAD_FAILED;
+        result.error = write_failed ? "write failed" : !sent ? "request failed" : "HTTP " + std::to_string(probe.status);
+        AUDIT_LOG("DOWNLOAD", "Download failed: " + source + " (" + result.error + ")");
+        return result;
+    }
+
+    uint64_t total = 0;
+    uint64_t range_start = 0;
+    if (probe.status == 200) {
+        // 單一串流: 已在探測請求中寫完；無法續傳
+        if (!stream) {
+            if (!file.Open(part, true)) {
+                result.error = "cannot create " + part;
+                AUDIT_LOG("DOWNLOAD", "Download failed: " + source + " (" + result.error + ")");
+                return result;
+            }
+            stream.reset(new ChunkWriter(file, 0));
+        }
+        if (!stream->Flush()) write_failed = true;
+        result.total_bytes = result.fetched_bytes = fetched.load();
+    } else if (!ParseContentRange(probe.Header("content-range"), range_start, total) || range_start != 0) {
+        result.error = "bad Content-Range";
+        return result;
+    } else {
+        result.ranged = true;
+        result.total_bytes = total;
+        const uint64_t chunk = options_.chunk_size > 0 ? options_.chunk_size : 4ull * 1024 * 1024;
+        const size_t chunks = (size_t)((total + chunk - 1) / chunk);
+
+        // 續傳: 伺服器須提供驗證值，且來源、驗證值、大小、區塊大小一致、.part 大小正確才沿用
+        const std::string validator = RangeValidator(probe);
+        ChunkMap map;
+        bool resume = !validator.empty() && map.Load(mapPath) && map.source == source && map.validator == validator &&
+                      map.total == total && map.chunk == chunk && file.Open(part, false) && file.Size() == total;
+        if (!resume) {
+            file.Close();
+            map.source = source;
+            map.validator = validator;
+            map.total = total;
+            map.chunk = chunk;
+            map.done.assign(chunks, 0);
+            if (!file.Open(part, true) || !file.Resize(total) || !map.Save(mapPath)) {
+                result.error = "cannot create " + part;
+                AUDIT_LOG("DOWNLOAD", "Download failed: " + source + " (" + result.error + ")");
+                return result;
+            }
+        }
+
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < chunks; i++) {
+            uint64_t len = (i + 1) * chunk > total ? total - i * chunk : chunk;
+            if (map.done[i]) result.resumed_bytes += len;
+            else pending.push_back(i);
+        }
+        done_bytes = result.resumed_bytes;
+
+        std::mutex map_lock;
+        std::mutex hash_lock;
+        size_t hash_cursor = 0;
+        std::atomic<bool> failed{ false };
+        std::atomic<bool> changed{ false };  // If-Range 不符: 伺服器改回完整 200，來源已更新
+
+        // 依序雜湊已完成的連續區塊 (從頁快取讀回)；blocking=false 時由其他執行緒稍後處理
+        auto advance_hash = [&](bool blocking) {
+            std::unique_lock<std::mutex> guard(hash_lock, std::defer_lock);
+            if (blocking) guard.lock();
+            else if (!guard.try_lock()) return;
+            std::vector<char> buf(WRITE_BUFFER_SIZE);
+            while (true) {
+                {
+                    std::lock_guard<std::mutex> m(map_lock);
+                    if (hash_cursor >= chunks || !map.done[hash_cursor]) return;
+                }
+                uint64_t offset = hash_cursor * chunk;
+                uint64_t end = offset + chunk < total ? offset + chunk : total;
+                while (offset < end) {
+                    size_t n = end - offset < buf.size() ? (size_t)(end - offset) : buf.size();
+                    if (!file.ReadAt(offset, buf.data(), n)) {
+                        failed = true;
+                        return;
+                    }
+                    hasher.Update(buf.data(), n);
+                    offset += n;
+                }
+                hash_cursor++;
+            }
+        };
+        advance_hash(true);
+
+        auto fetch_chunk = [&](size_t index) {
+            uint64_t start = index * chunk;
+            uint64_t len = start + chunk > total ? total - start : chunk;
+            HttpRequest req;
+            req.path = source;
+            req.headers.emplace_back("Range", "bytes=" + std::to_string(start) + "-" + std::to_string(start + len - 1));
+            if (!validator.empty()) req.headers.emplace_back("If-Range", validator);
+            HttpResponse resp;
+            ChunkWriter writer(file, start);
+            uint64_t received = 0;
+            req.sink = [&](const char* data, size_t n) {
+                uint64_t got_start = 0, got_total = 0;
+                if (resp.status == 200) {
+                    changed = true;
+                    failed = true;
+                    return false;
+                }
+                if (resp.status != 206 || received + n > len || cancelled() || failed.load()) return false;
+                if (received == 0 && (!ParseContentRange(resp.Header("content-range"), got_start, got_total) ||
+                                      got_start != start || got_total != total)) {
+                    return false;
+                }
+                if (options_.throttle) options_.throttle(n);
+                if (!writer.Write(data, n)) return false;
+                received += n;
+                fetched += n;
+                uint64_t now = done_bytes.fetch_add(n) + n;
+                if (options_.progress) options_.progress(now, total);
+                return true;
+            };
+            requests++;
+            bool ok = transport_.Send(req, resp, options_.timeout_ms) && resp.status == 206 && received == len &&
+                      writer.Flush();
+            if (resp.status == 200) changed = true;
+            if (!ok) done_bytes -= received;  // 重試時重新計算
+            return ok;
+        };
+
+        std::atomic<size_t> next{ 0 };
+        auto worker = [&]() {
+            size_t k;
+            while (!failed.load() && !cancelled() && (k = next.fetch_add(1)) < pending.size()) {
+                size_t index = pending[k];
+                bool ok = false;
+                for (int attempt = 0; attempt <= options_.max_retries && !ok && !cancelled() && !changed.load(); attempt++) {
+                    ok = fetch_chunk(index);
+                }
+                // 資料落盤後才標記完成，確保續傳狀態不會超前實際內容
+                if (!ok || !file.Flush()) {
+                    failed = true;
+                    break;
+                }
+                {
+                    std::lock_guard<std::mutex> m(map_lock);
+                    map.done[index] = 1;
+                    map.Save(mapPath);
+                }
+                advance_hash(false);
+            }
+        };
+
+        size_t threads = (size_t)(options_.max_parallel > 0 ? options_.max_parallel : 1);
+        if (threads > pending.size()) threads = pending.size();
+        std::vector<std::thread> pool;
+        for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+        if (threads > 0) worker();
+        for (std::thread& t : pool) t.join();
+
+        result.requests = requests.load();
+        result.fetched_bytes = fetched.load();
+        if (changed.load()) {
+            // 已下載的區塊屬於舊版本: 丟棄續傳狀態，下次從頭開始
+            file.Close();
+            RemoveFile(part);
+            RemoveFile(mapPath);
+            result.error = "source changed during download";
+            AUDIT_LOG("DOWNLOAD", "Source changed, partial download discarded: " + source);
+            return result;
+        }
+        if (failed.load() || cancelled()) {
+            file.Close();
+            result.status = cancelled() ? DOWNLOAD_CANCELLED : DOWNLOAD_FAILED;
+            result.error = cancelled() ? "cancelled" : "chunk download failed";
+            AUDIT_LOG("DOWNLOAD", "Download interrupted, resumable: " + source);
+            return result;
+        }
+        advance_hash(true);
+    }
+
+    result.requests = requests.load();
+    result.sha256 = hasher.FinalHex();
+    bool flushed = !write_failed && file.Flush();
+    file.Close();
+
+    if (!flushed) {
+        RemoveFile(part);
+        RemoveFile(mapPath);
+        result.error = "write failed";
+        return result;
+    }
+    if (verify && !Sha256HexEquals(result.sha256, options_.expected_sha256)) {
+        RemoveFile(part);
+        RemoveFile(mapPath);
+        result.status = DOWNLOAD_CHECKSUM_MISMATCH;
+        result.error = "SHA-256 mismatch";
+        AUDIT_LOG("DOWNLOAD", "Checksum mismatch: " + source + " got " + result.sha256);
+        return result;
+    }
+    if (!CommitFile(part, save_path)) {
+        result.error = "rename failed";
+        return result;
+    }
+    RemoveFile(mapPath);
+
+    result.status = DOWNLOAD_OK;
+    AUDIT_LOG("DOWNLOAD", "Downloaded " + std::to_string(result.total_bytes) + " bytes (resumed " +
+              std::to_string(result.resumed_bytes) + ") sha256=" + result.sha256);
+    return result;
+}
+
+DownloadResult DownloadFile(const std::string& url, const std::string& save_path, const DownloadOptions& options) {
+    ParsedUrl parsed;
+    if (!ParsedUrl::Parse(url, parsed)) {
+        DownloadResult result;
+        result.error = "bad URL";
+        return result;
+    }
+    std::unique_ptr<IUpdateTransport> transport = CreateUpdateTransport(parsed);
+    if (!transport) {
+        DownloadResult result;
+        result.error = "unsupported scheme";
+        return result;
+    }
+    ChunkedDownloader downloader(*transport, options);
+    return downloader.Download(parsed.path, save_path);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 分塊並行下載引擎
+ * 功能: HTTP Range 分塊並行寫入預先配置的 .part 檔；區塊完成狀態持久化於 .part.map 供中斷後續傳
+ *       (區塊請求帶 If-Range，來源變更時丟棄舊區塊)；
+ *       下載同時依序計算 SHA-256；校驗通過後以原子改名提交
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "update_client.h"
+
+// 下載結果狀態
+#define DOWNLOAD_OK                 1
+#define DOWNLOAD_FAILED            -1
+#define DOWNLOAD_CHECKSUM_MISMATCH -2
+#define DOWNLOAD_CANCELLED         -3
+
+// 進度回呼: 已完成位元組 (含續傳部分), 總位元組 (未知時為 0)；可能由下載執行緒呼叫
+using DownloadProgress = std::function<void(uint64_t done, uint64_t total)>;
+
+struct DownloadOptions {
+    uint64_t chunk_size = 4ull * 1024 * 1024;  // 區塊大小
+    int max_parallel = 4;                      // 並行區塊請求上限
+    int timeout_ms = 30000;                    // 每個請求逾時
+    int max_retries = 2;                       // 每個區塊額外重試次數
+    std::string expected_sha256;               // 64 位十六進位時比對；空或 VERIFY_ON_DOWNLOAD 只計算
+    DownloadProgress progress;
+    std::function<void(size_t bytes)> throttle; // 每收到一段資料即呼叫，可阻塞以限制頻寬
+    const std::atomic<bool>* cancel = nullptr; // 設為 true 時中止 (保留續傳狀態)
+};
+
+struct DownloadResult {
+    int status = DOWNLOAD_FAILED;
+    uint64_t total_bytes = 0;
+    uint64_t fetched_bytes = 0;    // 本次實際下載
+    uint64_t resumed_bytes = 0;    // 從先前中斷沿用
+    uint64_t requests = 0;
+    bool ranged = false;           // 伺服器支援 Range (false=單一串流)
+    std::string sha256;            // 小寫十六進位
+    std::string error;
+};
+
+class ChunkedDownloader {
+public:
+    explicit ChunkedDownloader(IUpdateTransport& transport, DownloadOptions options = DownloadOptions())
+        : transport_(transport), options_(std::move(options)) {}
+
+    /**
+     * [MAIDOS-AUDIT] 下載到 save_path
+     * @param source 伺服器路徑 (含查詢字串)；與 ETag/大小一起識別續傳狀態
+     * @param save_path 目標路徑；過程中使用 save_path.part 與 save_path.part.map
+     */
+    DownloadResult Download(const std::string& source, const std::string& save_path);
+
+private:
+    IUpdateTransport& transport_;
+    DownloadOptions options_;
+};
+
+// 依 URL 建立平台傳輸後下載
+DownloadResult DownloadFile(const std::string& url, const std::string& save_path, const DownloadOptions& options);
+
+// 續傳中間檔路徑
+inline std::string DownloadPartPath(const std::string& save_path) { return save_path + ".part"; }
+inline std::string DownloadMapPath(const std::string& save_path) { return save_path + ".part.map"; }
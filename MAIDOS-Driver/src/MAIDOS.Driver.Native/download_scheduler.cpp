@@ -0,0 +1,308 @@
+#pragma warning(disable: 4819)
+#include "download_scheduler.h"
+#include "logger.h"
+
+#include <cctype>
+#include <chrono>
+
+// ---------------------------------------------------------------------------
+// 時鐘
+// ---------------------------------------------------------------------------
+
+uint64_t SteadyClock::NowUs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SteadyClock::SleepUntilUs(uint64_t deadline_us) {
+    uint64_t now = NowUs();
+    if (deadline_us > now) std::this_thread::sleep_for(std::chrono::microseconds(deadline_us - now));
+}
+
+SteadyClock& SteadyClock::Instance() {
+    static SteadyClock clock;
+    return clock;
+}
+
+void SimulatedClock::SleepUntilUs(uint64_t deadline_us) {
+    uint64_t now = now_.load();
+    while (now < deadline_us && !now_.compare_exchange_weak(now, deadline_us)) {
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 令牌桶
+// ---------------------------------------------------------------------------
+
+TokenBucket::TokenBucket(uint64_t bytes_per_sec, uint64_t burst_bytes, IClock& clock)
+    : clock_(clock), rate_(bytes_per_sec), burst_(burst_bytes), tokens_((double)burst_bytes), last_us_(clock.NowUs()) {}
+
+uint64_t TokenBucket::Acquire(uint64_t bytes) {
+    uint64_t now, deadline;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        uint64_t rate = rate_.load();
+        if (rate == 0) return 0;
+
+        now = clock_.NowUs();
+        if (now > last_us_) {
+            tokens_ += (double)(now - last_us_) * rate / 1e6;
+            if (tokens_ > (double)burst_) tokens_ = (double)burst_;
+            last_us_ = now;
+        }
+        tokens_ -= (double)bytes;
+        if (tokens_ >= 0) return 0;
+
+        // 欠帳: 睡到帳戶回正；後來者的欠帳包含前者，依序排隊
+        deadline = now + (uint64_t)(-tokens_ * 1e6 / rate);
+    }
+    clock_.SleepUntilUs(deadline);
+    return deadline - now;
+}
+
+void TokenBucket::SetRate(uint64_t bytes_per_sec) {
+    std::lock_guard<std::mutex> guard(lock_);
+    uint64_t now = clock_.NowUs();
+    uint64_t rate = rate_.load();
+    if (rate > 0 && now > last_us_) {
+        tokens_ += (double)(now - last_us_) * rate / 1e6;
+        if (tokens_ > (double)burst_) tokens_ = (double)burst_;
+    }
+    if (rate == 0) tokens_ = (double)burst_;
+    last_us_ = now;
+    rate_ = bytes_per_sec;
+}
+
+// ---------------------------------------------------------------------------
+// 排程器
+// ---------------------------------------------------------------------------
+
+DownloadScheduler::DownloadScheduler(SchedulerOptions options, IClock& clock, DownloadRunner runner)
+    : options_(options), runner_(std::move(runner)),
+      bucket_(options.bytes_per_sec, options.burst_bytes, clock) {
+    if (!runner_) {
+        runner_ = [](const DownloadJob& job, const DownloadOptions& opts) {
+            return DownloadFile(job.url, job.save_path, opts);
+        };
+    }
+}
+
+DownloadScheduler::~DownloadScheduler() {
+    Shutdown();
+}
+
+void DownloadScheduler::Shutdown() {
+    std::vector<std::thread> workers;
+    std::vector<std::shared_ptr<Entry>> drained;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        stopping_ = true;
+        for (auto& kv : jobs_) kv.second->cancel = true;
+
+        // 排隊中的工作不再執行: 直接標記為已取消，WaitAll 才不會永遠等待
+        for (auto& kv : queue_) {
+            Entry& entry = *kv.second;
+            entry.status.state = DOWNLOAD_STATE_FINISHED;
+            entry.status.result.status = DOWNLOAD_CANCELLED;
+            entry.status.result.error = "cancelled";
+            FinishedLocked(entry.id);
+            drained.push_back(kv.second);
+        }
+        queue_.clear();
+        workers.swap(workers_);
+    }
+    work_cv_.notify_all();
+    for (std::thread& t : workers) t.join();
+
+    for (const auto& entry : drained) {
+        if (entry->job.on_complete) entry->job.on_complete(entry->id, entry->status.result);
+    }
+    idle_cv_.notify_all();
+}
+
+std::string DownloadScheduler::HostKey(const std::string& url) {
+    ParsedUrl parsed;
+    if (!ParsedUrl::Parse(url, parsed)) return std::string();
+    std::string key = parsed.host + ":" + std::to_string(parsed.port);
+    for (char& c : key) c = (char)tolower((unsigned char)c);
+    return key;
+}
+
+uint64_t DownloadScheduler::Submit(DownloadJob job) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (stopping_) return 0;
+    auto entry = std::make_shared<Entry>();
+    entry->id = next_id_++;
+    entry->host = HostKey(job.url);
+    entry->job = std::move(job);
+    queue_[{ entry->job.priority, entry->id }] = entry;
+    jobs_[entry->id] = entry;
+    EnsureWorkersLocked();
+    work_cv_.notify_all();
+    return entry->id;
+}
+
+void DownloadScheduler::EnsureWorkersLocked() {
+    while (!stopping_ && (int)workers_.size() < options_.max_active) {
+        workers_.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+std::shared_ptr<DownloadScheduler::Entry> DownloadScheduler::NextLocked() {
+    if (paused_ || active_ >= options_.max_active) return nullptr;
+
+    // 依優先序取第一個主機尚有名額的工作 (被佔滿的主機不阻擋其他主機)
+    for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+        auto host = host_active_.find(it->second->host);
+        if (host != host_active_.end() && host->second >= options_.max_per_host) continue;
+        std::shared_ptr<Entry> entry = it->second;
+        queue_.erase(it);
+        return entry;
+    }
+    return nullptr;
+}
+
+void DownloadScheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lk(lock_);
+    while (true) {
+        std::shared_ptr<Entry> entry;
+        work_cv_.wait(lk, [&]() { return stopping_ || (entry = NextLocked()) != nullptr; });
+        if (!entry) return;
+
+        active_++;
+        host_active_[entry->host]++;
+        entry->status.state = DOWNLOAD_STATE_RUNNING;
+        lk.unlock();
+        Run(entry);
+        lk.lock();
+
+        // 主機名額先釋放；全域名額待完成回呼結束後釋放，WaitAll 返回時回呼已執行完
+        if (--host_active_[entry->host] == 0) host_active_.erase(entry->host);
+        entry->status.state = DOWNLOAD_STATE_FINISHED;
+        FinishedLocked(entry->id);
+        work_cv_.notify_all();
+        if (entry->job.on_complete) {
+            lk.unlock();
+            entry->job.on_complete(entry->id, entry->status.result);
+            lk.lock();
+        }
+        active_--;
+        work_cv_.notify_all();
+        idle_cv_.notify_all();
+    }
+}
+
+void DownloadScheduler::Run(const std::shared_ptr<Entry>& entry) {
+    DownloadOptions options;
+    options.max_parallel = options_.chunk_parallel;
+    options.expected_sha256 = entry->job.expected_sha256;
+    options.cancel = &entry->cancel;
+    options.throttle = [this](size_t bytes) { bucket_.Acquire(bytes); };
+    options.progress = [this, entry](uint64_t done, uint64_t total) {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            entry->status.done = done;
+            entry->status.total = total;
+        }
+        if (entry->job.on_progress) entry->job.on_progress(entry->id, done, total);
+    };
+
+    AUDIT_LOG("DOWNLOAD", "Start job " + std::to_string(entry->id) + " priority " +
+              std::to_string(entry->job.priority) + ": " + entry->job.url);
+    DownloadResult result = runner_(entry->job, options);
+
+    std::lock_guard<std::mutex> guard(lock_);
+    entry->status.result = result;
+}
+
+bool DownloadScheduler::Cancel(uint64_t id) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || it->second->status.state == DOWNLOAD_STATE_FINISHED) return false;
+        entry = it->second;
+        entry->cancel = true;
+        if (entry->status.state == DOWNLOAD_STATE_RUNNING) return true;
+
+        queue_.erase({ entry->job.priority, entry->id });
+        entry->status.state = DOWNLOAD_STATE_FINISHED;
+        entry->status.result.status = DOWNLOAD_CANCELLED;
+        entry->status.result.error = "cancelled";
+        FinishedLocked(entry->id);
+    }
+    if (entry->job.on_complete) entry->job.on_complete(entry->id, entry->status.result);
+    idle_cv_.notify_all();
+    return true;
+}
+
+bool DownloadScheduler::Status(uint64_t id, DownloadJobStatus& status) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+    status = it->second->status;
+    return true;
+}
+
+bool DownloadScheduler::TakeStatus(uint64_t id, DownloadJobStatus& status) {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) return false;
+    status = it->second->status;
+    if (status.state == DOWNLOAD_STATE_FINISHED) jobs_.erase(it);
+    return true;
+}
+
+// 記錄完成順序；未被取走的已完成工作超過上限時淘汰最舊者 (已被 TakeStatus 移除者略過)
+void DownloadScheduler::FinishedLocked(uint64_t id) {
+    finished_.push_back(id);
+    while (finished_.size() > options_.max_finished) {
+        jobs_.erase(finished_.front());
+        finished_.pop_front();
+    }
+}
+
+void DownloadScheduler::Pause() {
+    std::lock_guard<std::mutex> guard(lock_);
+    paused_ = true;
+}
+
+void DownloadScheduler::Resume() {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        paused_ = false;
+    }
+    work_cv_.notify_all();
+}
+
+void DownloadScheduler::SetLimits(int max_active, int max_per_host, uint64_t bytes_per_sec) {
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (max_active > 0) options_.max_active = max_active;
+        if (max_per_host > 0) options_.max_per_host = max_per_host;
+        options_.bytes_per_sec = bytes_per_sec;
+        EnsureWorkersLocked();
+    }
+    bucket_.SetRate(bytes_per_sec);
+    work_cv_.notify_all();
+}
+
+bool DownloadScheduler::WaitAll(int timeout_ms) {
+    std::unique_lock<std::mutex> lk(lock_);
+    auto idle = [&]() { return queue_.empty() && active_ == 0; };
+    if (timeout_ms < 0) {
+        idle_cv_.wait(lk, idle);
+        return true;
+    }
+    return idle_cv_.wait_for(lk, std::chrono::milliseconds(timeout_ms), idle);
+}
+
+size_t DownloadScheduler::Queued() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return queue_.size();
+}
+
+size_t DownloadScheduler::Active() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return (size_t)active_;
+}
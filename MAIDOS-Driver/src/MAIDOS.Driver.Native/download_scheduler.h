@@ -0,0 +1,207 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 下載排程器
+ * 功能: 優先序佇列 (安全性驅動優先)、全域/每主機並行上限、令牌桶頻寬限制、進度回呼；
+ *       時鐘可替換為模擬時鐘以便在 Linux 上決定性測試
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "download_engine.h"
+
+// ---------------------------------------------------------------------------
+// 時鐘
+// ---------------------------------------------------------------------------
+
+class IClock {
+public:
+    virtual ~IClock() = default;
+    virtual uint64_t NowUs() = 0;
+    virtual void SleepUntilUs(uint64_t deadline_us) = 0;
+};
+
+// 實際時鐘 (steady_clock)
+class SteadyClock : public IClock {
+public:
+    uint64_t NowUs() override;
+    void SleepUntilUs(uint64_t deadline_us) override;
+
+    static SteadyClock& Instance();
+};
+
+// 模擬時鐘: 睡眠立即返回並把時間推進到 deadline (多執行緒共用時取最大值)
+class SimulatedClock : public IClock {
+public:
+    uint64_t NowUs() override { return now_.load(); }
+    void SleepUntilUs(uint64_t deadline_us) override;
+    void Advance(uint64_t us) { now_ += us; }
+
+private:
+    std::atomic<uint64_t> now_{ 0 };
+};
+
+// ---------------------------------------------------------------------------
+// 令牌桶
+// ---------------------------------------------------------------------------
+
+/**
+ * [MAIDOS-AUDIT] 令牌桶頻寬限制 (可多執行緒共用)
+ * 取用時先扣帳 (可為負)，再睡到帳戶回正；多個取用者依到達順序排隊，總速率不超過設定值
+ */
+class TokenBucket {
+public:
+    /**
+     * @param bytes_per_sec 速率，0=不限
+     * @param burst_bytes 閒置時最多累積的額度
+     */
+    TokenBucket(uint64_t bytes_per_sec, uint64_t burst_bytes, IClock& clock);
+
+    // 取用 bytes 額度，必要時阻塞；回傳等待的微秒數
+    uint64_t Acquire(uint64_t bytes);
+
+    void SetRate(uint64_t bytes_per_sec);
+    uint64_t Rate() const { return rate_.load(); }
+
+private:
+    IClock& clock_;
+    std::mutex lock_;
+    std::atomic<uint64_t> rate_;
+    uint64_t burst_;
+    double tokens_;
+    uint64_t last_us_;
+};
+
+// ---------------------------------------------------------------------------
+// 排程器
+// ---------------------------------------------------------------------------
+
+// 優先序: 數值越小越先
+#define DOWNLOAD_PRIORITY_CRITICAL 0   // 安全性修補
+#define DOWNLOAD_PRIORITY_HIGH     1
+#define DOWNLOAD_PRIORITY_NORMAL   2
+#define DOWNLOAD_PRIORITY_LOW      3
+
+// 工作狀態
+#define DOWNLOAD_STATE_QUEUED    0
+#define DOWNLOAD_STATE_RUNNING   1
+#define DOWNLOAD_STATE_FINISHED  2
+
+struct DownloadJob {
+    std::string url;
+    std::string save_path;
+    std::string expected_sha256;
+    int priority = DOWNLOAD_PRIORITY_NORMAL;
+    std::function<void(uint64_t id, uint64_t done, uint64_t total)> on_progress;
+    std::function<void(uint64_t id, const DownloadResult& result)> on_complete;
+};
+
+struct DownloadJobStatus {
+    int state = DOWNLOAD_STATE_QUEUED;
+    uint64_t done = 0;
+    uint64_t total = 0;
+    DownloadResult result;   // state == FINISHED 時有效
+};
+
+struct SchedulerOptions {
+    int max_active = 4;              // 全域同時下載數
+    int max_per_host = 2;            // 每主機同時下載數
+    int chunk_parallel = 2;          // 每個下載的並行區塊數
+    uint64_t bytes_per_sec = 0;      // 全域頻寬上限，0=不限
+    uint64_t burst_bytes = 256 * 1024;
+    size_t max_finished = 1024;      // 未被 TakeStatus 取走的已完成工作最多保留數 (超過時淘汰最舊者)
+};
+
+// 實際執行單一下載；預設為 DownloadFile。測試可替換
+using DownloadRunner = std::function<DownloadResult(const DownloadJob& job, const DownloadOptions& options)>;
+
+class DownloadScheduler {
+public:
+    explicit DownloadScheduler(SchedulerOptions options = SchedulerOptions(), IClock& clock = SteadyClock::Instance(),
+                               DownloadRunner runner = nullptr);
+    ~DownloadScheduler();
+
+    DownloadScheduler(const DownloadScheduler&) = delete;
+    DownloadScheduler& operator=(const DownloadScheduler&) = delete;
+
+    // 加入佇列，回傳工作ID (>0)；已 Shutdown 時回傳 0
+    uint64_t Submit(DownloadJob job);
+
+    /**
+     * 取消工作: 排隊中直接移除，執行中設定取消旗標 (保留續傳狀態)
+     * @return false=找不到或已完成
+     */
+    bool Cancel(uint64_t id);
+
+    bool Status(uint64_t id, DownloadJobStatus& status) const;
+
+    // 同 Status；工作已完成時讀取後即移除 (之後查詢回傳 false)
+    bool TakeStatus(uint64_t id, DownloadJobStatus& status);
+
+    /**
+     * 停止排程: 取消全部工作並等待工作執行緒結束；可重複呼叫
+     * 不可在進度/完成回呼或 DllMain 中呼叫 (會等待工作執行緒)
+     */
+    void Shutdown();
+
+    // 暫停/恢復派發 (執行中的下載不受影響)
+    void Pause();
+    void Resume();
+
+    // 調整上限；頻寬立即生效，並行上限於下次派發生效
+    void SetLimits(int max_active, int max_per_host, uint64_t bytes_per_sec);
+
+    /**
+     * 等待所有工作完成
+     * @return true=全部完成, false=逾時 (timeout_ms < 0 表示不限)
+     */
+    bool WaitAll(int timeout_ms = -1);
+
+    size_t Queued() const;
+    size_t Active() const;
+
+    // 主機鍵 (host:port)
+    static std::string HostKey(const std::string& url);
+
+private:
+    struct Entry {
+        uint64_t id;
+        DownloadJob job;
+        std::string host;
+        DownloadJobStatus status;
+        std::atomic<bool> cancel{ false };
+    };
+
+    void EnsureWorkersLocked();
+    void FinishedLocked(uint64_t id);
+    std::shared_ptr<Entry> NextLocked();
+    void WorkerLoop();
+    void Run(const std::shared_ptr<Entry>& entry);
+
+    SchedulerOptions options_;
+    DownloadRunner runner_;
+    TokenBucket bucket_;
+
+    mutable std::mutex lock_;
+    std::condition_variable work_cv_;
+    std::condition_variable idle_cv_;
+    std::map<std::pair<int, uint64_t>, std::shared_ptr<Entry>> queue_;   // (優先序, 序號) 排序
+    std::unordered_map<uint64_t, std::shared_ptr<Entry>> jobs_;
+    std::deque<uint64_t> finished_;                                      // 完成順序 (淘汰用)
+    std::unordered_map<std::string, int> host_active_;
+    std::vector<std::thread> workers_;
+    uint64_t next_id_ = 1;
+    int active_ = 0;
+    bool paused_ = false;
+    bool stopping_ = false;
+};
@@ -0,0 +1,258 @@
+#pragma warning(disable: 4819)
+#include "driver_catalog.h"
+#include "driver_version.h"
+#include "logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+static bool ParseHex(std::string_view s, uint32_t& out) {
+    if (s.empty() || s.size() > 8) return false;
+    uint32_t v = 0;
+    for (char c : s) {
+        v <<= 4;
+        if (c >= '0' && c <= '9') v |= (uint32_t)(c - '0');
+        else if (c >= 'A' && c <= 'F') v |= (uint32_t)(c - 'A' + 10);
+        else return false;
+    }
+    out = v;
+    return true;
+}
+
+static bool StartsWith(std::string_view s, std::string_view prefix) {
+    return s.size() >= prefix.size() && s.compare(0, prefix.size(), prefix) == 0;
+}
+
+HardwareIdKey HardwareIdKey::Parse(std::string_view id) {
+    HardwareIdKey key;
+
+    char upper[512];
+    size_t n = id.size() < sizeof(upper) ? id.size() : sizeof(upper);
+    for (size_t i = 0; i < n; i++) {
+        char c = id[i];
+        upper[i] = (c >= 'a' && c <= 'z') ? (char)(c - 32) : c;
+    }
+    std::string_view norm(upper, n);
+    key.full = Fnv1a64(norm.data(), norm.size());
+
+    size_t slash = norm.find('\\');
+    if (slash == std::string_view::npos) return key;
+    key.bus = Fnv1a64(norm.data(), slash);
+
+    // 只看第一段 (實例ID的尾段如 \4&1234&0&00E0 不屬於硬體ID)
+    std::string_view body = norm.substr(slash + 1);
+    size_t end = body.find('\\');
+    if (end != std::string_view::npos) body = body.substr(0, end);
+
+    bool ven = false, dev = false;
+    uint64_t extra = 0;
+    while (!body.empty()) {
+        size_t amp = body.find('&');
+        std::string_view token = body.substr(0, amp);
+        body = amp == std::string_view::npos ? std::string_view() : body.substr(amp + 1);
+
+        uint32_t v = 0;
+        if ((StartsWith(token, "VEN_") || StartsWith(token, "VID_")) && ParseHex(token.substr(4), v) && v <= 0xFFFF) {
+            key.ven = (uint16_t)v;
+            ven = true;
+        } else if ((StartsWith(token, "DEV_") || StartsWith(token, "PID_")) && ParseHex(token.substr(4), v) && v <= 0xFFFF) {
+            key.dev = (uint16_t)v;
+            dev = true;
+        } else if (StartsWith(token, "SUBSYS_") && ParseHex(token.substr(7), v)) {
+            key.subsys = v;
+            key.has_subsys = true;
+        } else if (StartsWith(token, "REV_") && ParseHex(token.substr(4), v) && v <= 0xFFFF) {
+            key.rev = (uint16_t)v;
+            key.has_rev = true;
+        } else {
+            extra = Fnv1a64(token.data(), token.size(), extra ? extra : 1469598103934665603ULL);
+        }
+    }
+
+    key.has_ven_dev = ven && dev;
+    if (key.has_ven_dev) {
+        key.extra = extra;
+    } else {
+        key.has_subsys = key.has_rev = false;
+    }
+    return key;
+}
+
+bool HardwareIdKey::Covers(const HardwareIdKey& device) const {
+    if (has_ven_dev != device.has_ven_dev) return false;
+    if (!has_ven_dev) return full == device.full;
+    if (bus != device.bus || ven != device.ven || dev != device.dev) return false;
+    if (has_subsys && (!device.has_subsys || subsys != device.subsys)) return false;
+    if (has_rev && (!device.has_rev || rev != device.rev)) return false;
+    if (extra != 0 && extra != device.extra) return false;
+    return true;
+}
+
+uint64_t HardwareIdKey::IndexKey() const {
+    if (!has_ven_dev) return full;
+    return (bus * 1099511628211ULL) ^ (((uint64_t)ven << 16) | dev);
+}
+
+bool DriverCatalog::LoadTsv(const std::string& path, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        if (error) *error = "Cannot open " + path;
+        AUDIT_LOG("CATALOG", "Cannot open " + path);
+        return false;
+    }
+
+    std::ostringstream content;
+    content << file.rdbuf();
+    size_t added = ParseTsv(content.str());
+    AUDIT_LOG("CATALOG", "Loaded " + std::to_string(added) + " entries from " + path);
+    return true;
+}
+
+size_t DriverCatalog::ParseTsv(std::string_view text) {
+    size_t added = 0;
+    std::vector<std::string_view> cols;
+
+    while (!text.empty()) {
+        size_t nl = text.find('\n');
+        std::string_view line = text.substr(0, nl);
+        text = nl == std::string_view::npos ? std::string_view() : text.substr(nl + 1);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty() || line[0] == '#') continue;
+
+        cols.clear();
+        while (true) {
+            size_t tab = line.find('\t');
+            cols.push_back(line.substr(0, tab));
+            if (tab == std::string_view::npos) break;
+            line = line.substr(tab + 1);
+        }
+        if (cols.size() < 5) continue;
+
+        CatalogEntry e;
+        e.driver_id = std::string(cols[0]);
+        e.name = std::string(cols[1]);
+        e.version = std::string(cols[2]);
+        e.manufacturer = std::string(cols[3]);
+        if (cols.size() > 5) e.download_url = std::string(cols[5]);
+        if (cols.size() > 6) e.checksum = std::string(cols[6]);
+        if (cols.size() > 7) e.score = atoi(std::string(cols[7]).c_str());
+
+        std::string_view ids = cols[4];
+        while (!ids.empty()) {
+            size_t semi = ids.find(';');
+            std::string_view id = ids.substr(0, semi);
+            ids = semi == std::string_view::npos ? std::string_view() : ids.substr(semi + 1);
+            while (!id.empty() && id.front() == ' ') id.remove_prefix(1);
+            while (!id.empty() && id.back() == ' ') id.remove_suffix(1);
+            if (!id.empty()) e.ids.push_back(HardwareIdKey::Parse(id));
+        }
+        if (e.ids.empty()) continue;
+
+        Add(std::move(e));
+        added++;
+    }
+    return added;
+}
+
+void DriverCatalog::Add(CatalogEntry entry) {
+    uint32_t index = (uint32_t)entries_.size();
+    for (uint32_t i = 0; i < entry.ids.size(); i++) {
+        index_[entry.ids[i].IndexKey()].push_back(Posting{ index, i });
+    }
+    entries_.push_back(std::move(entry));
+}
+
+void DriverCatalog::MatchOne(const HardwareIdKey& key, uint32_t rank, CatalogMatch& best) const {
+    auto it = index_.find(key.IndexKey());
+    if (it == index_.end()) return;
+
+    for (const Posting& p : it->second) {
+        const CatalogEntry& e = entries_[p.entry];
+        const HardwareIdKey& id = e.ids[p.id];
+        if (!id.Covers(key)) continue;
+
+        int spec = id.Specificity();
+        bool better;
+        if (!best.entry) better = true;
+        else if (rank != best.rank) better = rank < best.rank;
+        else if (spec != best.specificity) better = spec > best.specificity;
+        else if (e.score != best.entry->score) better = e.score > best.entry->score;
+        else better = CompareDriverVersions(e.version, best.entry->version) > 0;
+
+        if (better) {
+            best.entry = &e;
+            best.rank = rank;
+            best.specificity = spec;
+        }
+    }
+}
+
+bool DriverCatalog::MatchKeys(const HardwareIdKey* hardware, size_t hardware_count, const HardwareIdKey* compatible,
+                              size_t compatible_count, std::string_view driver_version, CatalogMatch& out) const {
+    out = CatalogMatch();
+
+    // Windows 排序: 硬體ID依序優先，相容ID一律排在所有硬體ID之後
+    for (size_t i = 0; i < hardware_count; i++) MatchOne(hardware[i], (uint32_t)i, out);
+    if (!out.entry) {
+        for (size_t i = 0; i < compatible_count; i++) MatchOne(compatible[i], 0x1000 + (uint32_t)i, out);
+    }
+    if (!out.entry) return false;
+
+    out.update_available = !driver_version.empty() && CompareDriverVersions(out.entry->version, driver_version) > 0;
+    return true;
+}
+
+bool DriverCatalog::Match(const DeviceRecord& device, CatalogMatch& out) const {
+    // 解析到執行緒區域緩衝區後交給 MatchKeys，排序規則只有一份
+    thread_local std::vector<HardwareIdKey> hardware;
+    thread_local std::vector<HardwareIdKey> compatible;
+    hardware.clear();
+    compatible.clear();
+    for (const std::string& id : device.hardware_ids) hardware.push_back(HardwareIdKey::Parse(id));
+    for (const std::string& id : device.compatible_ids) compatible.push_back(HardwareIdKey::Parse(id));
+    return MatchKeys(hardware.data(), hardware.size(), compatible.data(), compatible.size(), device.driver_version, out);
+}
+
+size_t DriverCatalog::MatchAll(const std::vector<DeviceRecord>& devices, std::vector<CatalogMatch>& out) const {
+    out.resize(devices.size());
+    size_t matched = 0;
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (Match(devices[i], out[i])) matched++;
+    }
+    return matched;
+}
+
+DriverCatalog DriverCatalog::Synthetic(size_t count) {
+    static const char* vendors[] = { "10DE", "1002", "8086", "10EC" };
+    static const char* makers[] = { "NVIDIA", "AMD", "Intel", "Realtek" };
+
+    DriverCatalog catalog;
+    catalog.entries_.reserve(count);
+    char buf[128];
+    for (size_t i = 0; i < count; i++) {
+        size_t v = i % 4;
+        unsigned dev = (unsigned)((i / 4) & 0xFFFF);
+
+        CatalogEntry e;
+        snprintf(buf, sizeof(buf), "DRV_SYN_%zu", i);
+        e.driver_id = buf;
+        snprintf(buf, sizeof(buf), "%s Synthetic Driver %zu", makers[v], i);
+        e.name = buf;
+        snprintf(buf, sizeof(buf), "%zu.%zu.%zu.%zu", 31 + v, i % 7, i % 100, i % 1000);
+        e.version = buf;
+        e.manufacturer = makers[v];
+        e.checksum = "VERIFY_ON_DOWNLOAD";
+        e.score = (int)(50 + i % 50);
+
+        snprintf(buf, sizeof(buf), "PCI\\VEN_%s&DEV_%04X", vendors[v], dev);
+        e.ids.push_back(HardwareIdKey::Parse(buf));
+        if (i % 3 == 0) {
+            snprintf(buf, sizeof(buf), "PCI\\VEN_%s&DEV_%04X&SUBSYS_%08X", vendors[v], dev, (unsigned)(0x10000000 + i % 1000));
+            e.ids.push_back(HardwareIdKey::Parse(buf));
+        }
+        catalog.Add(std::move(e));
+    }
+    return catalog;
+}
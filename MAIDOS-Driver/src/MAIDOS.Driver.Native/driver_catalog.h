@@ -0,0 +1,116 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 驅動目錄比對引擎
+ * 功能: 解析 drivers.tsv (及大型廠商目錄)，以正規化 VEN/DEV/SUBSYS/REV 建索引，
+ *       依 Windows 排序規則 (硬體ID優先於相容ID、越具體越優先、分數、版本) 選出最佳驅動
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "device_provider.h"
+
+// 正規化硬體ID (PCI\VEN_10DE&DEV_2684&SUBSYS_...&REV_A1、USB\VID_..&PID_..)
+struct HardwareIdKey {
+    uint64_t bus = 0;       // 匯流排前綴雜湊 (PCI、HDAUDIO、USB...)
+    uint64_t full = 0;      // 整個正規化字串雜湊 (無 VEN/DEV 的ID以此比對)
+    uint64_t extra = 0;     // 其他段 (CC_、MI_、FUNC_...) 的雜湊，0=無
+    uint32_t subsys = 0;
+    uint16_t ven = 0;
+    uint16_t dev = 0;
+    uint16_t rev = 0;
+    bool has_ven_dev = false;
+    bool has_subsys = false;
+    bool has_rev = false;
+
+    // 解析 (不分大小寫；實例ID的尾段會被忽略)
+    static HardwareIdKey Parse(std::string_view id);
+
+    // 具體程度: VEN/DEV=2，+SUBSYS、+REV、+其他段 各 1；通用ID=1
+    int Specificity() const { return has_ven_dev ? 2 + has_subsys + has_rev + (extra != 0) : 1; }
+
+    // 目錄ID (this) 是否涵蓋設備ID
+    bool Covers(const HardwareIdKey& device) const;
+
+    // 索引鍵
+    uint64_t IndexKey() const;
+};
+
+// 目錄記錄 (drivers.tsv 一列)
+struct CatalogEntry {
+    std::string driver_id;
+    std::string name;
+    std::string version;
+    std::string manufacturer;
+    std::string download_url;
+    std::string checksum;     // SHA-256 或 VERIFY_ON_DOWNLOAD
+    int score = 0;
+    std::vector<HardwareIdKey> ids;
+};
+
+// 比對結果
+struct CatalogMatch {
+    const CatalogEntry* entry = nullptr;
+    uint32_t rank = 0;          // 越小越好: 硬體ID位置，相容ID加 0x1000
+    int specificity = 0;
+    bool update_available = false;  // 目錄版本比設備目前版本新
+};
+
+class DriverCatalog {
+public:
+    /**
+     * [MAIDOS-AUDIT] 載入 TSV 檔
+     * @param error 失敗原因輸出 (可為 nullptr)
+     * @return true=成功
+     */
+    bool LoadTsv(const std::string& path, std::string* error = nullptr);
+
+    /**
+     * 解析 TSV 內容並加入目錄 (# 開頭為註解；欄位不足的列略過)
+     * @return 新增的記錄數
+     */
+    size_t ParseTsv(std::string_view text);
+
+    // 直接加入記錄 (測試/合成目錄)
+    void Add(CatalogEntry entry);
+
+    size_t Size() const { return entries_.size(); }
+    const std::vector<CatalogEntry>& Entries() const { return entries_; }
+
+    /**
+     * [MAIDOS-AUDIT] 為設備選出最佳驅動
+     * @return true=有符合的驅動
+     */
+    bool Match(const DeviceRecord& device, CatalogMatch& out) const;
+
+    /**
+     * [MAIDOS-AUDIT] 以已解析的ID比對 (離線/批次比對用，不需建 DeviceRecord)
+     * @param driver_version 設備目前驅動版本 (空=無驅動)
+     * @return true=有符合的驅動
+     */
+    bool MatchKeys(const HardwareIdKey* hardware, size_t hardware_count, const HardwareIdKey* compatible,
+                   size_t compatible_count, std::string_view driver_version, CatalogMatch& out) const;
+
+    /**
+     * [MAIDOS-AUDIT] 比對整份設備清單 (結果順序與輸入一致)
+     * @return 有符合驅動的設備數
+     */
+    size_t MatchAll(const std::vector<DeviceRecord>& devices, std::vector<CatalogMatch>& out) const;
+
+    // 產生 count 筆合成記錄 (基準測試用)
+    static DriverCatalog Synthetic(size_t count);
+
+private:
+    struct Posting {
+        uint32_t entry;
+        uint32_t id;
+    };
+
+    void MatchOne(const HardwareIdKey& key, uint32_t rank, CatalogMatch& best) const;
+
+    std::vector<CatalogEntry> entries_;
+    std::unordered_map<uint64_t, std::vector<Posting>> index_;
+};
@@ -0,0 +1,45 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 驅動版本比較
+ * 以數值元組比較 ("31.0.101.5186" > "31.0.101.999")，取代 strcmp 的「不同即更新」
+ */
+
+#include <string_view>
+
+/**
+ * 比較兩個版本字串
+ * 各段以 '.' 分隔並以數值比較；缺少的段視為 0 ("1.2" == "1.2.0")；
+ * 段內含非數字時該段退回字典序比較
+ * @return <0: a 較舊, 0: 相同, >0: a 較新
+ */
+inline int CompareDriverVersions(std::string_view a, std::string_view b) {
+    size_t i = 0, j = 0;
+    while (i < a.size() || j < b.size()) {
+        size_t ie = a.find('.', i);
+        size_t je = b.find('.', j);
+        if (ie == std::string_view::npos) ie = a.size();
+        if (je == std::string_view::npos) je = b.size();
+        std::string_view sa = i < a.size() ? a.substr(i, ie - i) : std::string_view();
+        std::string_view sb = j < b.size() ? b.substr(j, je - j) : std::string_view();
+
+        bool numeric = true;
+        for (char c : sa) numeric = numeric && c >= '0' && c <= '9';
+        for (char c : sb) numeric = numeric && c >= '0' && c <= '9';
+
+        if (numeric) {
+            // 去除前導零後先比長度再比字元，避免溢位
+            while (sa.size() > 1 && sa[0] == '0') sa.remove_prefix(1);
+            while (sb.size() > 1 && sb[0] == '0') sb.remove_prefix(1);
+            if (sa.empty()) sa = "0";
+            if (sb.empty()) sb = "0";
+            if (sa.size() != sb.size()) return sa.size() < sb.size() ? -1 : 1;
+        }
+        int c = sa.compare(sb);
+        if (c != 0) return c < 0 ? -1 : 1;
+
+        i = ie + 1;
+        j = je + 1;
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+#pragma warning(disable: 4819)
+#include "fleet_matcher.h"
+#include "scan_blob.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// 多字串 (項目\0項目\0...) 逐項解析，重用 out 的容量
+void ParseIds(std::string_view all, std::vector<HardwareIdKey>& out) {
+    out.clear();
+    while (!all.empty()) {
+        size_t end = all.find('\0');
+        std::string_view id = all.substr(0, end);
+        if (!id.empty()) out.push_back(HardwareIdKey::Parse(id));
+        if (end == std::string_view::npos) break;
+        all.remove_prefix(end + 1);
+    }
+}
+
+// 讀整個檔案到可重用的緩衝區
+bool ReadInto(const std::string& path, std::vector<uint8_t>& buffer, std::string& error) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        error = "Cannot open " + path;
+        return false;
+    }
+    std::streamoff size = in.tellg();
+    if (size < 0) {
+        error = "Cannot read " + path;
+        return false;
+    }
+    buffer.resize((size_t)size);
+    in.seekg(0);
+    if (size > 0 && !in.read((char*)buffer.data(), size)) {
+        error = "Cannot read " + path;
+        return false;
+    }
+    return true;
+}
+
+bool WriteAtomically(const std::string& path, const char* data, size_t size, std::string* error) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data, (std::streamsize)size);
+        out.flush();
+        if (!out) {
+            if (error) *error = "Cannot write " + tmp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        if (error) *error = "Cannot commit " + path;
+        return false;
+    }
+    return true;
+}
+
+// TSV 欄位不可含分隔字元
+void AppendField(std::string& out, std::string_view s) {
+    for (char c : s) out.push_back(c == '\t' || c == '\r' || c == '\n' ? ' ' : c);
+}
+
+}  // namespace
+
+bool FleetMatcher::MatchBlob(const uint8_t* data, size_t size, FleetMachineReport& report) const {
+    report.generation = 0;
+    report.devices = report.matched = 0;
+    report.updates.clear();
+    report.error.clear();
+
+    ScanBlobView view;
+    if (!view.Open(data, size)) {
+        report.error = "Invalid or truncated scan blob";
+        return false;
+    }
+    report.generation = view.Generation();
+    report.devices = view.Count();
+
+    // 每執行緒重用: 比對熱路徑只在有建議更新時配置
+    thread_local std::vector<HardwareIdKey> hardware;
+    thread_local std::vector<HardwareIdKey> compatible;
+    for (uint32_t i = 0; i < view.Count(); i++) {
+        const ScanBlobRecord& r = view.Record(i);
+        ParseIds(view.String(r.hardware_ids), hardware);
+        ParseIds(view.String(r.compatible_ids), compatible);
+
+        CatalogMatch match;
+        std::string_view current = view.String(r.driver_version);
+        if (!catalog_.MatchKeys(hardware.data(), hardware.size(), compatible.data(), compatible.size(), current, match)) {
+            continue;
+        }
+        report.matched++;
+        if (!match.update_available) continue;
+
+        FleetRecommendation rec;
+        rec.instance_id = std::string(view.String(r.instance_id));
+        rec.device_name = std::string(view.String(r.name));
+        rec.current_version = std::string(current);
+        rec.entry = match.entry;
+        report.updates.push_back(std::move(rec));
+    }
+    return true;
+}
+
+FleetSummary FleetMatcher::MatchFiles(const std::vector<std::string>& paths,
+                                      std::vector<FleetMachineReport>& reports) const {
+    reports.clear();
+    reports.resize(paths.size());
+
+    int threads = threads_;
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 2;
+    if ((size_t)threads > paths.size()) threads = (int)paths.size();
+
+    // 目錄唯讀共用；每個結果槽只由一個執行緒寫入，不需要鎖
+    std::atomic<size_t> cursor{ 0 };
+    std::atomic<uint64_t> bytes{ 0 };
+    auto worker = [&]() {
+        std::vector<uint8_t> buffer;
+        for (size_t i = cursor++; i < paths.size(); i = cursor++) {
+            FleetMachineReport& report = reports[i];
+            report.source = paths[i];
+            report.machine = fs::path(paths[i]).stem().string();
+            if (!ReadInto(paths[i], buffer, report.error)) continue;
+            bytes += buffer.size();
+            MatchBlob(buffer.data(), buffer.size(), report);
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    FleetSummary summary;
+    summary.machines = reports.size();
+    summary.bytes = bytes;
+    for (const FleetMachineReport& r : reports) {
+        if (!r.Ok()) {
+            summary.failed++;
+            AUDIT_LOG("FLEET", "Skipped " + r.source + ": " + r.error);
+            continue;
+        }
+        summary.devices += r.devices;
+        summary.matched += r.matched;
+        summary.updates += r.updates.size();
+    }
+    AUDIT_LOG("FLEET", "Matched " + std::to_string(summary.machines) + " machines (" + std::to_string(summary.failed) +
+              " failed), " + std::to_string(summary.devices) + " devices, " + std::to_string(summary.updates) +
+              " updates with " + std::to_string(threads) + " threads");
+    return summary;
+}
+
+bool FleetMatcher::ListInventoryFiles(const std::string& dir, std::vector<std::string>& out, std::string* error) {
+    out.clear();
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec) && it->path().extension() == FLEET_INVENTORY_EXT) {
+            out.push_back(it->path().string());
+        }
+    }
+    if (ec) {
+        if (error) *error = "Cannot list " + dir + ": " + ec.message();
+        return false;
+    }
+    std::sort(out.begin(), out.end());
+    return true;
+}
+
+bool FleetMatcher::WriteReport(const std::string& path, const std::vector<FleetMachineReport>& reports,
+                               std::string* error) {
+    std::string out = "# machine\tinstance_id\tdevice_name\tcurrent_version\tlatest_version\tdriver_id\tdownload_url\tchecksum\n";
+    for (const FleetMachineReport& r : reports) {
+        if (!r.Ok()) {
+            out += "# ERROR ";
+            AppendField(out, r.machine);
+            out += ": ";
+            AppendField(out, r.error);
+            out += '\n';
+            continue;
+        }
+        for (const FleetRecommendation& u : r.updates) {
+            const std::string_view fields[] = { r.machine, u.instance_id, u.device_name, u.current_version,
+                                                u.entry->version, u.entry->driver_id, u.entry->download_url,
+                                                u.entry->checksum };
+            for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++) {
+                if (f) out += '\t';
+                AppendField(out, fields[f]);
+            }
+            out += '\n';
+        }
+    }
+    return WriteAtomically(path, out.data(), out.size(), error);
+}
+
+bool WriteInventoryFile(const std::string& path, const uint8_t* data, size_t size, std::string* error) {
+    ScanBlobView view;
+    if (!view.Open(data, size)) {
+        if (error) *error = "Invalid scan blob";
+        return false;
+    }
+    return WriteAtomically(path, (const char*)data, size, error);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 機群批次比對
+ * 功能: 讀取各端點匯出的精簡掃描檔 (scan_blob.h 格式，副檔名 .mdscan)，
+ *       以一份共用唯讀的 DriverCatalog 索引多執行緒並行比對，輸出每台機器的建議更新；
+ *       不呼叫 SetupAPI，可在集中伺服器 (Linux) 執行
+ *
+ * 報告格式 (TSV，# 開頭為註解):
+ *   machine  instance_id  device_name  current_version  latest_version  driver_id  download_url  checksum
+ *   無法讀取的檔案以 "# ERROR <machine>: <原因>" 記錄
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "driver_catalog.h"
+
+#define FLEET_INVENTORY_EXT ".mdscan"
+
+// 單一設備的建議更新
+struct FleetRecommendation {
+    std::string instance_id;
+    std::string device_name;
+    std::string current_version;
+    const CatalogEntry* entry = nullptr;   // 指向共用目錄，目錄須比報告活得久
+};
+
+// 單一機器的比對結果
+struct FleetMachineReport {
+    std::string source;        // 清單檔路徑
+    std::string machine;       // 檔名去掉副檔名
+    uint64_t generation = 0;   // 端點清單快照世代
+    uint32_t devices = 0;
+    uint32_t matched = 0;      // 目錄中有對應驅動的設備數
+    std::vector<FleetRecommendation> updates;
+    std::string error;         // 非空=檔案無法讀取或格式錯誤
+
+    bool Ok() const { return error.empty(); }
+};
+
+struct FleetSummary {
+    size_t machines = 0;
+    size_t failed = 0;
+    uint64_t devices = 0;
+    uint64_t matched = 0;
+    uint64_t updates = 0;
+    uint64_t bytes = 0;        // 讀取的清單檔總位元組
+};
+
+class FleetMatcher {
+public:
+    /**
+     * @param catalog 共用目錄 (比對期間不可修改)
+     * @param threads 並行數 (<=0 使用 CPU 核心數)
+     */
+    explicit FleetMatcher(const DriverCatalog& catalog, int threads = 0) : catalog_(catalog), threads_(threads) {}
+
+    /**
+     * [MAIDOS-AUDIT] 比對單一掃描區塊 (machine/source 由呼叫端填)
+     * @return false=區塊格式錯誤 (report.error 含原因)
+     */
+    bool MatchBlob(const uint8_t* data, size_t size, FleetMachineReport& report) const;
+
+    /**
+     * [MAIDOS-AUDIT] 並行比對多個清單檔 (結果順序與輸入一致；單檔錯誤不中斷其他檔)
+     */
+    FleetSummary MatchFiles(const std::vector<std::string>& paths, std::vector<FleetMachineReport>& reports) const;
+
+    /**
+     * 列出目錄下的清單檔 (依檔名排序，不遞迴)
+     * @return false=目錄無法讀取
+     */
+    static bool ListInventoryFiles(const std::string& dir, std::vector<std::string>& out, std::string* error = nullptr);
+
+    /**
+     * [MAIDOS-AUDIT] 寫出建議報告 (暫存檔寫完後改名)
+     */
+    static bool WriteReport(const std::string& path, const std::vector<FleetMachineReport>& reports,
+                            std::string* error = nullptr);
+
+private:
+    const DriverCatalog& catalog_;
+    int threads_;
+};
+
+/**
+ * [MAIDOS-AUDIT] 將掃描區塊寫成清單檔 (端點匯出用；暫存檔寫完後改名)
+ */
+bool WriteInventoryFile(const std::string& path, const uint8_t* data, size_t size, std::string* error = nullptr);
@@ -0,0 +1,327 @@
+#pragma warning(disable: 4819)
+#include "inf_index.h"
+#include "driver_version.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+#define INF_INDEX_MAGIC "MAIDOS-INFINDEX 1"
+
+static std::string Upper(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) {
+        if (c >= 'a' && c <= 'z') c = (char)(c - 32);
+    }
+    return out;
+}
+
+// 索引檔以 tab/換行分欄，欄位內的控制字元換成空白
+static std::string Field(const std::string& s) {
+    std::string out(s);
+    for (char& c : out) {
+        if (c == '\t' || c == '\n' || c == '\r') c = ' ';
+    }
+    return out;
+}
+
+static std::vector<std::string> SplitTabs(const std::string& line) {
+    std::vector<std::string> cols;
+    size_t start = 0;
+    while (true) {
+        size_t tab = line.find('\t', start);
+        cols.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start));
+        if (tab == std::string::npos) break;
+        start = tab + 1;
+    }
+    return cols;
+}
+
+bool InfIndex::Update(const std::string& root, int threads, InfIndexStats* stats_out, std::string* error) {
+    // 列舉 *.inf (副檔名不分大小寫)
+    std::error_code ec;
+    struct Source {
+        std::string path;
+        fs::path full;
+        uint64_t size;
+        int64_t mtime;
+    };
+    std::vector<Source> sources;
+    for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        std::string ext = it->path().extension().string();
+        if (ext.size() != 4 || Upper(ext) != ".INF" || !it->is_regular_file(ec)) continue;
+        std::error_code stat_ec;
+        Source s;
+        s.full = it->path();
+        s.path = it->path().lexically_relative(root).generic_string();
+        s.size = it->file_size(stat_ec);
+        s.mtime = (int64_t)it->last_write_time(stat_ec).time_since_epoch().count();
+        if (!stat_ec) sources.push_back(std::move(s));
+    }
+    if (ec) {
+        if (error) *error = "Cannot enumerate " + root + ": " + ec.message();
+        AUDIT_LOG("INFINDEX", "Cannot enumerate " + root);
+        return false;
+    }
+    std::sort(sources.begin(), sources.end(), [](const Source& a, const Source& b) { return a.path < b.path; });
+
+    std::unordered_map<std::string, size_t> previous;
+    for (size_t i = 0; i < records_.size(); i++) previous[records_[i].path] = i;
+
+    InfIndexStats stats;
+    stats.files = sources.size();
+    std::vector<InfRecord> next(sources.size());
+    std::vector<size_t> work;
+    for (size_t i = 0; i < sources.size(); i++) {
+        auto it = previous.find(sources[i].path);
+        if (it != previous.end() && records_[it->second].size == sources[i].size &&
+            records_[it->second].mtime == sources[i].mtime) {
+            next[i] = std::move(records_[it->second]);
+            stats.unchanged++;
+        } else {
+            work.push_back(i);
+        }
+    }
+
+    // 變動的檔案並行讀取；內容雜湊相同者沿用舊的解析結果
+    std::atomic<size_t> cursor{ 0 };
+    std::atomic<uint64_t> parsed{ 0 }, rehashed{ 0 }, failed{ 0 };
+    std::vector<char> ok(sources.size(), 1);
+    auto worker = [&]() {
+        for (size_t w = cursor++; w < work.size(); w = cursor++) {
+            size_t i = work[w];
+            const Source& source = sources[i];
+            std::ifstream file(source.full, std::ios::binary);
+            if (!file.is_open()) {
+                ok[i] = 0;
+                failed++;
+                continue;
+            }
+            std::ostringstream content;
+            content << file.rdbuf();
+            std::string raw = content.str();
+
+            InfRecord& record = next[i];
+            record.path = source.path;
+            record.size = raw.size();
+            record.mtime = source.mtime;
+            record.hash = Fnv1a64(raw.data(), raw.size());
+
+            // 舊紀錄只讀不改 (previous 中每個路徑至多對應一個工作)
+            auto it = previous.find(source.path);
+            if (it != previous.end() && records_[it->second].hash == record.hash) {
+                record.driver = records_[it->second].driver;
+                record.info = records_[it->second].info;
+                rehashed++;
+                continue;
+            }
+
+            InfDocument doc;
+            doc.Parse(InfDocument::DecodeText(raw));
+            record.driver = record.info.FromDocument(doc);
+            parsed++;
+        }
+    };
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 2;
+    if ((size_t)threads > work.size()) threads = (int)work.size();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+
+    std::vector<InfRecord> kept;
+    kept.reserve(next.size());
+    for (size_t i = 0; i < next.size(); i++) {
+        if (ok[i]) kept.push_back(std::move(next[i]));
+    }
+    stats.parsed = parsed;
+    stats.rehashed = rehashed;
+    stats.failed = failed;
+    for (const auto& kv : previous) {
+        auto it = std::lower_bound(kept.begin(), kept.end(), kv.first,
+                                   [](const InfRecord& r, const std::string& path) { return r.path < path; });
+        if (it == kept.end() || it->path != kv.first) stats.removed++;
+    }
+
+    root_ = root;
+    records_ = std::move(kept);
+    Rebuild();
+    if (stats_out) *stats_out = stats;
+    AUDIT_LOG("INFINDEX", "Indexed " + std::to_string(stats.files) + " INFs under " + root + ": " +
+              std::to_string(stats.parsed) + " parsed, " + std::to_string(stats.unchanged + stats.rehashed) + " reused, " +
+              std::to_string(stats.removed) + " removed");
+    return true;
+}
+
+void InfIndex::Rebuild() {
+    ids_.clear();
+    for (uint32_t r = 0; r < records_.size(); r++) {
+        const std::vector<InfModel>& models = records_[r].info.models;
+        for (uint32_t m = 0; m < models.size(); m++) {
+            for (uint32_t p = 0; p < models[m].ids.size(); p++) {
+                ids_[Upper(models[m].ids[p])].push_back(Posting{ r, m, p });
+            }
+        }
+    }
+}
+
+bool InfIndex::Save(const std::string& path, std::string* error) const {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            if (error) *error = "Cannot write " + tmp;
+            return false;
+        }
+        out << INF_INDEX_MAGIC << "\n";
+        out << "root\t" << Field(root_) << "\n";
+        for (const InfRecord& r : records_) {
+            out << "inf\t" << r.size << "\t" << r.mtime << "\t" << r.hash << "\t" << (r.driver ? 1 : 0) << "\t"
+                << Field(r.path) << "\n";
+            if (!r.driver) continue;
+            const InfDriverInfo& i = r.info;
+            out << "ver\t" << Field(i.class_name) << "\t" << Field(i.class_guid) << "\t" << Field(i.provider) << "\t"
+                << Field(i.catalog) << "\t" << Field(i.driver_date) << "\t" << Field(i.driver_version) << "\n";
+            for (const InfModel& m : i.models) {
+                out << "model\t" << Field(m.decoration) << "\t" << Field(m.install_section) << "\t" << Field(m.manufacturer)
+                    << "\t" << Field(m.description);
+                for (const std::string& id : m.ids) out << "\t" << Field(id);
+                out << "\n";
+            }
+        }
+        out.flush();
+        if (!out) {
+            if (error) *error = "Write failed: " + tmp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        if (error) *error = "Cannot commit " + path;
+        return false;
+    }
+    return true;
+}
+
+bool InfIndex::Load(const std::string& path, std::string* error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        if (error) *error = "Cannot open " + path;
+        return false;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != INF_INDEX_MAGIC) {
+        if (error) *error = "Not an INF index: " + path;
+        return false;
+    }
+
+    std::string root;
+    std::vector<InfRecord> records;
+    int line_no = 1;
+    while (std::getline(in, line)) {
+        line_no++;
+        if (line.empty()) continue;
+        std::vector<std::string> cols = SplitTabs(line);
+        bool valid = true;
+        if (cols[0] == "inf" && cols.size() == 6) {
+            InfRecord r;
+            r.size = strtoull(cols[1].c_str(), nullptr, 10);
+            r.mtime = strtoll(cols[2].c_str(), nullptr, 10);
+            r.hash = strtoull(cols[3].c_str(), nullptr, 10);
+            r.driver = cols[4] == "1";
+            r.path = cols[5];
+            records.push_back(std::move(r));
+        } else if (cols[0] == "ver" && cols.size() == 7 && !records.empty()) {
+            InfDriverInfo& i = records.back().info;
+            i.class_name = cols[1];
+            i.class_guid = cols[2];
+            i.provider = cols[3];
+            i.catalog = cols[4];
+            i.driver_date = cols[5];
+            i.driver_version = cols[6];
+        } else if (cols[0] == "model" && cols.size() >= 6 && !records.empty()) {
+            InfModel m;
+            m.decoration = cols[1];
+            m.install_section = cols[2];
+            m.manufacturer = cols[3];
+            m.description = cols[4];
+            m.ids.assign(cols.begin() + 5, cols.end());
+            records.back().info.models.push_back(std::move(m));
+        } else if (cols[0] == "root" && cols.size() == 2) {
+            root = cols[1];
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            if (error) *error = path + ":" + std::to_string(line_no) + ": malformed line";
+            return false;
+        }
+    }
+
+    std::sort(records.begin(), records.end(), [](const InfRecord& a, const InfRecord& b) { return a.path < b.path; });
+    root_ = root;
+    records_ = std::move(records);
+    Rebuild();
+    AUDIT_LOG("INFINDEX", "Loaded " + std::to_string(records_.size()) + " INFs from " + path);
+    return true;
+}
+
+std::vector<InfCandidate> InfIndex::Lookup(std::string_view id, std::string_view arch) const {
+    std::vector<InfCandidate> out;
+    auto it = ids_.find(Upper(id));
+    if (it == ids_.end()) return out;
+    for (const Posting& p : it->second) {
+        const InfRecord& record = records_[p.record];
+        const InfModel& model = record.info.models[p.model];
+        if (!InfDecorationMatches(model.decoration, arch)) continue;
+        out.push_back(InfCandidate{ &record, &model, p.position ? 0x1000u : 0u });
+    }
+    return out;
+}
+
+void InfIndex::Consider(const std::string& upper_id, uint32_t device_rank, std::string_view arch, InfCandidate& best) const {
+    auto it = ids_.find(upper_id);
+    if (it == ids_.end()) return;
+
+    for (const Posting& p : it->second) {
+        const InfRecord& record = records_[p.record];
+        const InfModel& model = record.info.models[p.model];
+        if (!InfDecorationMatches(model.decoration, arch)) continue;
+
+        uint32_t rank = device_rank + (p.position ? 0x1000u + (p.position - 1) : 0u);
+        bool better;
+        if (!best.inf) {
+            better = true;
+        } else if (rank != best.rank) {
+            better = rank < best.rank;
+        } else {
+            uint32_t date = InfDateKey(record.info.driver_date), best_date = InfDateKey(best.inf->info.driver_date);
+            int version = CompareDriverVersions(record.info.driver_version, best.inf->info.driver_version);
+            if (date != best_date) better = date > best_date;
+            else if (version != 0) better = version > 0;
+            else better = record.path < best.inf->path;
+        }
+        if (better) best = InfCandidate{ &record, &model, rank };
+    }
+}
+
+bool InfIndex::Match(const DeviceRecord& device, std::string_view arch, InfCandidate& out) const {
+    out = InfCandidate();
+    for (size_t i = 0; i < device.hardware_ids.size(); i++) {
+        Consider(Upper(device.hardware_ids[i]), (uint32_t)i, arch, out);
+    }
+    for (size_t i = 0; i < device.compatible_ids.size(); i++) {
+        Consider(Upper(device.compatible_ids[i]), 0x2000u + (uint32_t)i, arch, out);
+    }
+    return out.inf != nullptr;
+}
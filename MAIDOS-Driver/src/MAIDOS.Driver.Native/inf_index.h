@@ -0,0 +1,91 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 本地驅動儲存庫索引
+ * 功能: 並行掃描目錄樹中的 INF，建立 硬體ID -> INF/模型 索引並持久化；
+ *       再次更新時大小與時間戳未變的 INF 直接沿用，時間戳變動但內容雜湊相同者不重新解析
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "device_provider.h"
+#include "inf_parser.h"
+
+// 索引中的一個 INF
+struct InfRecord {
+    std::string path;       // 相對儲存庫根目錄 (以 / 分隔)
+    uint64_t size = 0;
+    int64_t mtime = 0;      // 檔案系統時間戳 (僅用於增量比對)
+    uint64_t hash = 0;      // 內容 FNV-1a
+    bool driver = false;    // 含 [Version] 的驅動 INF
+    InfDriverInfo info;
+};
+
+// 查詢結果
+struct InfCandidate {
+    const InfRecord* inf = nullptr;
+    const InfModel* model = nullptr;
+    uint32_t rank = 0;      // 越小越好 (Windows 驅動排序: 硬體ID/相容ID 類別 * 0x1000 + 位置)
+};
+
+struct InfIndexStats {
+    uint64_t files = 0;        // 掃描到的 INF
+    uint64_t unchanged = 0;    // 大小/時間戳相同，未讀取
+    uint64_t rehashed = 0;     // 時間戳變動但內容相同，未重新解析
+    uint64_t parsed = 0;
+    uint64_t removed = 0;      // 已不存在
+    uint64_t failed = 0;       // 無法讀取
+};
+
+class InfIndex {
+public:
+    /**
+     * [MAIDOS-AUDIT] 掃描 root 目錄樹並增量更新索引
+     * @param threads 讀取/解析執行緒數，0=硬體核心數
+     * @param stats 統計輸出 (可為 nullptr)
+     * @param error 失敗原因輸出 (可為 nullptr)
+     */
+    bool Update(const std::string& root, int threads = 0, InfIndexStats* stats = nullptr, std::string* error = nullptr);
+
+    // 持久化 (文字格式，原子改名)
+    bool Save(const std::string& path, std::string* error = nullptr) const;
+    bool Load(const std::string& path, std::string* error = nullptr);
+
+    /**
+     * 支援某硬體ID (或相容ID) 的所有模型
+     * @param arch 平台 (amd64/x86/arm64)；空字串不篩選
+     * 回傳的指標於下次 Update/Load 前有效
+     */
+    std::vector<InfCandidate> Lookup(std::string_view id, std::string_view arch = std::string_view()) const;
+
+    /**
+     * [MAIDOS-AUDIT] 依 Windows 排序為設備選出最佳 INF
+     * 排名 (硬體ID優先於相容ID，INF 的硬體ID優先於其相容ID，位置越前越好) 相同時取 DriverVer 日期/版本較新者
+     * @return true=有支援的 INF
+     */
+    bool Match(const DeviceRecord& device, std::string_view arch, InfCandidate& out) const;
+
+    size_t Size() const { return records_.size(); }
+    const std::string& Root() const { return root_; }
+    const std::vector<InfRecord>& Records() const { return records_; }
+
+    // 不重複的硬體/相容ID數
+    size_t IdCount() const { return ids_.size(); }
+
+private:
+    struct Posting {
+        uint32_t record;
+        uint32_t model;
+        uint32_t position;  // 在模型 ID 清單中的位置 (0=硬體ID)
+    };
+
+    void Rebuild();
+    void Consider(const std::string& upper_id, uint32_t device_rank, std::string_view arch, InfCandidate& best) const;
+
+    std::string root_;
+    std::vector<InfRecord> records_;                           // 依路徑排序
+    std::unordered_map<std::string, std::vector<Posting>> ids_; // 大寫ID -> 模型
+};
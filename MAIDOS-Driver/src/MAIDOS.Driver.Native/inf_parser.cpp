@@ -0,0 +1,360 @@
+#pragma warning(disable: 4819)
+#include "inf_parser.h"
+
+#include <fstream>
+#include <sstream>
+
+static std::string Upper(std::string_view s) {
+    std::string out(s);
+    for (char& c : out) {
+        if (c >= 'a' && c <= 'z') c = (char)(c - 32);
+    }
+    return out;
+}
+
+static bool EqualsNoCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i], y = b[i];
+        if (x >= 'a' && x <= 'z') x = (char)(x - 32);
+        if (y >= 'a' && y <= 'z') y = (char)(y - 32);
+        if (x != y) return false;
+    }
+    return true;
+}
+
+static void AppendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+std::string InfDocument::DecodeText(std::string_view raw) {
+    const unsigned char* p = (const unsigned char*)raw.data();
+    if (raw.size() >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) return std::string(raw.substr(3));
+    if (raw.size() < 2 || !((p[0] == 0xFF && p[1] == 0xFE) || (p[0] == 0xFE && p[1] == 0xFF))) return std::string(raw);
+
+    // UTF-16 (驅動 INF 常見)，含代理對
+    bool le = p[0] == 0xFF;
+    std::string out;
+    out.reserve(raw.size() / 2);
+    for (size_t i = 2; i + 1 < raw.size(); i += 2) {
+        uint32_t u = le ? (p[i] | p[i + 1] << 8) : (p[i] << 8 | p[i + 1]);
+        if (u >= 0xD800 && u < 0xDC00 && i + 3 < raw.size()) {
+            uint32_t lo = le ? (p[i + 2] | p[i + 3] << 8) : (p[i + 2] << 8 | p[i + 3]);
+            if (lo >= 0xDC00 && lo < 0xE000) {
+                u = 0x10000 + ((u - 0xD800) << 10) + (lo - 0xDC00);
+                i += 2;
+            }
+        }
+        AppendUtf8(out, u);
+    }
+    return out;
+}
+
+void InfDocument::Parse(std::string_view text) {
+    sections_.clear();
+    by_name_.clear();
+    strings_.clear();
+
+    size_t current = std::string::npos;   // 目前節 (sections_ 位置)
+    bool split_commas = true;
+    uint32_t line_no = 0;
+    size_t i = 0;
+    const size_t n = text.size();
+
+    while (i < n) {
+        line_no++;
+        uint32_t first_line = line_no;
+
+        // 節標頭 [Name]
+        size_t s = i;
+        while (s < n && (text[s] == ' ' || text[s] == '\t')) s++;
+        if (s < n && text[s] == '[') {
+            size_t close = text.find(']', s);
+            size_t eol = text.find('\n', s);
+            if (eol == std::string_view::npos) eol = n;
+            if (close != std::string_view::npos && close < eol) {
+                std::string_view name = text.substr(s + 1, close - s - 1);
+                while (!name.empty() && (name.front() == ' ' || name.front() == '\t')) name.remove_prefix(1);
+                while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) name.remove_suffix(1);
+
+                // 同名節合併 (SetupAPI 行為)
+                std::string upper = Upper(name);
+                auto it = by_name_.find(upper);
+                if (it == by_name_.end()) {
+                    it = by_name_.emplace(upper, sections_.size()).first;
+                    sections_.push_back(InfSection{ std::string(name), {} });
+                }
+                current = it->second;
+                split_commas = upper.compare(0, 7, "STRINGS") != 0;  // [Strings] 的值可含逗號
+            }
+            i = eol + 1;
+            continue;
+        }
+
+        // 一個邏輯行 (可經 \ 續行跨越多個實體行)
+        InfLine line;
+        line.line = first_line;
+        std::string field;
+        size_t keep = 0;          // 引號結束位置之前的空白不修剪
+        bool started = false;
+        bool in_quote = false;
+        bool has_key = false;
+
+        auto finish_field = [&]() {
+            while (field.size() > keep && (field.back() == ' ' || field.back() == '\t')) field.pop_back();
+            std::string value;
+            value.swap(field);
+            keep = 0;
+            started = false;
+            return value;
+        };
+
+        while (i < n) {
+            char c = text[i];
+            if (c == '\n') break;
+            if (c == '\r') {
+                i++;
+                continue;
+            }
+            if (in_quote) {
+                if (c == '"') {
+                    if (i + 1 < n && text[i + 1] == '"') {
+                        field += '"';
+                        i++;
+                    } else {
+                        in_quote = false;
+                        keep = field.size();
+                    }
+                } else {
+                    field += c;
+                }
+                i++;
+                continue;
+            }
+            if (c == '"') {
+                in_quote = true;
+                started = true;
+                i++;
+                continue;
+            }
+            if (c == ';') {
+                while (i < n && text[i] != '\n') i++;
+                break;
+            }
+            if (c == '\\') {
+                // 行尾 (可接空白或註解) 的 \ 為續行
+                size_t j = i + 1;
+                while (j < n && (text[j] == ' ' || text[j] == '\t' || text[j] == '\r')) j++;
+                if (j >= n || text[j] == '\n' || text[j] == ';') {
+                    while (j < n && text[j] != '\n') j++;
+                    i = j + 1;
+                    line_no++;
+                    continue;
+                }
+            }
+            if (c == '=' && !has_key && line.values.empty()) {
+                line.key = finish_field();
+                has_key = true;
+                i++;
+                continue;
+            }
+            if (c == ',' && split_commas) {
+                line.values.push_back(finish_field());
+                i++;
+                continue;
+            }
+            if ((c == ' ' || c == '\t') && !started) {
+                i++;
+                continue;
+            }
+            field += c;
+            started = true;
+            i++;
+        }
+        i++;  // 跳過 '\n'
+
+        if (started || has_key || !line.values.empty()) line.values.push_back(finish_field());
+        if (line.values.empty() || current == std::string::npos) continue;
+        if (!has_key && line.values.size() == 1 && line.values[0].empty()) continue;
+        sections_[current].lines.push_back(std::move(line));
+    }
+
+    // 字串表: [Strings] 優先，其餘 [Strings.xxxx] 只補缺少的代號；值中的 %% 代表 %
+    auto unescape = [](const std::string& value) {
+        std::string out;
+        for (size_t k = 0; k < value.size(); k++) {
+            out += value[k];
+            if (value[k] == '%' && k + 1 < value.size() && value[k + 1] == '%') k++;
+        }
+        return out;
+    };
+    for (const InfSection& section : sections_) {
+        if (!EqualsNoCase(section.name, "Strings")) continue;
+        for (const InfLine& l : section.lines) strings_[Upper(l.key)] = unescape(l.values[0]);
+    }
+    for (const InfSection& section : sections_) {
+        if (section.name.size() <= 8 || !EqualsNoCase(section.name.substr(0, 8), "Strings.")) continue;
+        for (const InfLine& l : section.lines) strings_.emplace(Upper(l.key), unescape(l.values[0]));
+    }
+
+    if (strings_.empty()) return;
+    for (InfSection& section : sections_) {
+        for (InfLine& l : section.lines) {
+            if (l.key.find('%') != std::string::npos) l.key = Expand(l.key);
+            for (std::string& v : l.values) {
+                if (v.find('%') != std::string::npos) v = Expand(v);
+            }
+        }
+    }
+}
+
+std::string InfDocument::Expand(std::string_view text) const {
+    std::string out;
+    out.reserve(text.size());
+    for (size_t i = 0; i < text.size(); i++) {
+        if (text[i] != '%') {
+            out += text[i];
+            continue;
+        }
+        size_t close = text.find('%', i + 1);
+        if (close == std::string_view::npos) {
+            out.append(text.substr(i));
+            break;
+        }
+        if (close == i + 1) {
+            out += '%';  // %% -> %
+        } else {
+            auto it = strings_.find(Upper(text.substr(i + 1, close - i - 1)));
+            if (it != strings_.end()) {
+                out += it->second;
+            } else {
+                out.append(text.substr(i, close - i + 1));
+            }
+        }
+        i = close;
+    }
+    return out;
+}
+
+bool InfDocument::Load(const std::string& path, std::string* error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        if (error) *error = "Cannot open " + path;
+        return false;
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    Parse(DecodeText(content.str()));
+    return true;
+}
+
+const InfSection* InfDocument::Find(std::string_view name) const {
+    auto it = by_name_.find(Upper(name));
+    return it == by_name_.end() ? nullptr : &sections_[it->second];
+}
+
+std::string InfDocument::Value(std::string_view section, std::string_view key) const {
+    const InfSection* s = Find(section);
+    if (!s) return std::string();
+    for (const InfLine& l : s->lines) {
+        if (EqualsNoCase(l.key, key)) return l.values.empty() ? std::string() : l.values[0];
+    }
+    return std::string();
+}
+
+bool InfDriverInfo::FromDocument(const InfDocument& doc) {
+    *this = InfDriverInfo();
+    const InfSection* version = doc.Find("Version");
+    if (!version) return false;
+
+    for (const InfLine& l : version->lines) {
+        if (EqualsNoCase(l.key, "Class")) {
+            class_name = l.values[0];
+        } else if (EqualsNoCase(l.key, "ClassGuid")) {
+            class_guid = l.values[0];
+        } else if (EqualsNoCase(l.key, "Provider")) {
+            provider = l.values[0];
+        } else if (EqualsNoCase(l.key, "DriverVer")) {
+            driver_date = l.values[0];
+            if (l.values.size() > 1) driver_version = l.values[1];
+        } else if (catalog.empty() && l.key.size() >= 11 && EqualsNoCase(l.key.substr(0, 11), "CatalogFile")) {
+            catalog = l.values[0];  // CatalogFile 或 CatalogFile.NTamd64 等
+        }
+    }
+
+    const InfSection* manufacturers = doc.Find("Manufacturer");
+    if (!manufacturers) return true;
+
+    auto add_models = [&](const std::string& manufacturer, const std::string& section_name, const std::string& decoration) {
+        const InfSection* section = doc.Find(section_name);
+        if (!section) return;
+        for (const InfLine& l : section->lines) {
+            if (l.values.size() < 2) continue;
+            InfModel model;
+            model.manufacturer = manufacturer;
+            model.description = l.key;
+            model.install_section = l.values[0];
+            model.decoration = decoration;
+            for (size_t v = 1; v < l.values.size(); v++) {
+                if (!l.values[v].empty()) model.ids.push_back(l.values[v]);
+            }
+            if (!model.ids.empty()) models.push_back(std::move(model));
+        }
+    };
+
+    for (const InfLine& l : manufacturers->lines) {
+        if (l.values.empty() || l.values[0].empty()) continue;
+        // "%Mfg% = Models, NTamd64, NTarm64"；舊式只寫 "%Mfg%" 時節名即為名稱本身
+        const std::string& base = l.values[0];
+        std::string manufacturer = l.key.empty() ? base : l.key;
+        add_models(manufacturer, base, std::string());
+        for (size_t d = 1; d < l.values.size(); d++) {
+            if (!l.values[d].empty()) add_models(manufacturer, base + "." + l.values[d], l.values[d]);
+        }
+    }
+    return true;
+}
+
+uint32_t InfDateKey(std::string_view date) {
+    unsigned parts[3] = { 0, 0, 0 };
+    int index = 0;
+    bool digit = false;
+    for (char c : date) {
+        if (c >= '0' && c <= '9') {
+            parts[index] = parts[index] * 10 + (unsigned)(c - '0');
+            digit = true;
+        } else if ((c == '/' || c == '-') && digit && index < 2) {
+            index++;
+            digit = false;
+        } else if (c != ' ') {
+            return 0;
+        }
+    }
+    if (index != 2 || !digit) return 0;
+    unsigned month = parts[0], day = parts[1], year = parts[2];
+    if (month < 1 || month > 12 || day < 1 || day > 31 || year > 9999) return 0;
+    return year * 10000 + month * 100 + day;
+}
+
+bool InfDecorationMatches(std::string_view decoration, std::string_view arch) {
+    if (arch.empty() || decoration.empty()) return true;
+    if (decoration.size() < 2 || !EqualsNoCase(decoration.substr(0, 2), "NT")) return false;
+    std::string_view rest = decoration.substr(2);
+    size_t dot = rest.find('.');
+    std::string_view platform = rest.substr(0, dot);
+    return platform.empty() || EqualsNoCase(platform, arch);
+}
@@ -0,0 +1,88 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] INF 解析器
+ * 功能: 依 SetupAPI 語法解析 INF (節、key = v1, v2、引號、; 註解、\ 續行、%字串% 替換、UTF-16 BOM)，
+ *       並擷取 [Version] 的 DriverVer/Provider/Class 與 [Manufacturer] 模型節中的硬體ID
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct InfLine {
+    std::string key;                  // '=' 左側；無 '=' 的行為空
+    std::vector<std::string> values;  // ',' 分隔，已去引號並展開 %字串%
+    uint32_t line = 0;                // 原始行號 (1 起算)
+};
+
+struct InfSection {
+    std::string name;
+    std::vector<InfLine> lines;
+};
+
+class InfDocument {
+public:
+    /**
+     * 解析 INF 文字 (UTF-8/ANSI；UTF-16 請先經 DecodeText)
+     * 與 SetupAPI 一樣寬鬆: 無法辨識的行略過，不會失敗
+     */
+    void Parse(std::string_view text);
+
+    /**
+     * [MAIDOS-AUDIT] 讀取並解析 INF 檔
+     * @param error 失敗原因輸出 (可為 nullptr)
+     */
+    bool Load(const std::string& path, std::string* error = nullptr);
+
+    // 依 BOM 轉為 UTF-8 (UTF-16LE/BE 轉碼、UTF-8 BOM 去除；無 BOM 原樣)
+    static std::string DecodeText(std::string_view raw);
+
+    // 節名不分大小寫；不存在回傳 nullptr
+    const InfSection* Find(std::string_view name) const;
+
+    // 節中第一個 key 相符 (不分大小寫) 的第一個值；不存在回傳空字串
+    std::string Value(std::string_view section, std::string_view key) const;
+
+    const std::vector<InfSection>& Sections() const { return sections_; }
+
+private:
+    std::string Expand(std::string_view text) const;
+
+    std::vector<InfSection> sections_;
+    std::unordered_map<std::string, size_t> by_name_;       // 大寫節名 -> sections_ 位置
+    std::unordered_map<std::string, std::string> strings_;  // 大寫字串代號 -> 值
+};
+
+// [Manufacturer] 模型節中的一個模型 (一行)
+struct InfModel {
+    std::string manufacturer;
+    std::string description;
+    std::string install_section;
+    std::string decoration;         // 平台修飾 (NTamd64、NTamd64.10.0...16299)；未修飾為空
+    std::vector<std::string> ids;   // [0]=硬體ID，其餘為相容ID
+};
+
+struct InfDriverInfo {
+    std::string class_name;
+    std::string class_guid;
+    std::string provider;
+    std::string catalog;
+    std::string driver_date;        // mm/dd/yyyy
+    std::string driver_version;
+    std::vector<InfModel> models;
+
+    /**
+     * [MAIDOS-AUDIT] 從已解析的 INF 擷取驅動資訊
+     * @return false=不是驅動 INF (沒有 [Version] 節)
+     */
+    bool FromDocument(const InfDocument& doc);
+};
+
+// DriverVer 日期轉為可比較的 yyyymmdd (無法解析回傳 0)
+uint32_t InfDateKey(std::string_view date);
+
+// 模型平台修飾是否適用於 arch (amd64/x86/arm64)；未修飾或空 arch 一律適用
+bool InfDecorationMatches(std::string_view decoration, std::string_view arch);
@@ -2,22 +2,161 @@
 #include <setupapi.h>
 #include <newdev.h>
 #include <srrestoreptapi.h>
+#include <wintrust.h>
+#include <softpub.h>
 #include "logger.h"
+#include "package_verifier.h"
+#include "inf_parser.h"
+#include <filesystem>
+#include <memory>
+#include <mutex>
 
 #pragma comment(lib, "setupapi.lib")
 #pragma comment(lib, "newdev.lib")
+#pragma comment(lib, "wintrust.lib")
 
 #ifndef DIIRF_FORCE_INF
 #define DIIRF_FORCE_INF (0x00000002)
 #endif
 
+#ifndef ERROR_DATA_CHECKSUM_ERROR
+#define ERROR_DATA_CHECKSUM_ERROR 323L
+#endif
+
+#ifndef ERROR_INVALID_IMAGE_HASH
+#define ERROR_INVALID_IMAGE_HASH 577L
+#endif
+
 typedef BOOL (WINAPI *PFN_SRSETRESTOREPOINTA)(PRESTOREPOINTINFOA, PSTATEMGRSTATUS);
 
+// 行程共用雜湊快取 (set_package_hash_cache 設定路徑前只存在記憶體)
+static std::mutex g_hashCacheLock;
+static std::unique_ptr<HashCache> g_hashCache(new HashCache());
+
+/**
+ * 核對套件目錄；manifest 為空時使用目錄內的 maidos.sha256
+ * @return 不符檔案數, 0=全部相符, -1=清單無法讀取
+ */
+static int VerifyPackage(const std::string& packageDir, const std::string& manifest, int* checked) {
+    std::string manifestPath = manifest.empty() ? (std::filesystem::path(packageDir) / PACKAGE_MANIFEST_NAME).string() : manifest;
+    std::vector<ExpectedHash> expected;
+    std::string error;
+    if (!LoadSha256Manifest(manifestPath, expected, &error)) {
+        AUDIT_LOG("VERIFY", error);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(g_hashCacheLock);
+    PackageVerifier verifier(g_hashCache.get());
+    PackageVerifyReport report;
+    verifier.Verify(packageDir, expected, report);
+    if (!g_hashCache->Save(&error)) AUDIT_LOG("VERIFY", "Hash cache not saved: " + error);
+    if (checked) *checked = (int)expected.size();
+    return (int)report.failed;
+}
+
+// 路徑是否位於目錄之內 (含目錄本身)；以正規化後的路徑比較
+static bool IsInside(const std::string& path, const std::string& dir) {
+    std::error_code ec;
+    std::filesystem::path p = std::filesystem::weakly_canonical(path, ec);
+    if (ec) return true;  // 無法判斷時視為在套件內 (不信任)
+    std::filesystem::path d = std::filesystem::weakly_canonical(dir, ec);
+    if (ec) return true;
+    std::filesystem::path rel = p.lexically_relative(d);
+    return !rel.empty() && *rel.begin() != "..";
+}
+
+/**
+ * [MAIDOS-AUDIT] INF 宣告的 CatalogFile 是否有效簽章 (簽章鏈由本機信任存放區驗證，信任來源在套件之外)
+ * 套件檔案是否列於目錄檔由 DiInstallDriver 安裝時核對
+ */
+static bool HasTrustedCatalog(const std::string& infPath) {
+    InfDocument doc;
+    InfDriverInfo info;
+    if (!doc.Load(infPath) || !info.FromDocument(doc) || info.catalog.empty()) return false;
+
+    std::filesystem::path catalog = std::filesystem::path(infPath).parent_path() / info.catalog;
+    std::wstring wide = catalog.wstring();
+    WINTRUST_FILE_INFO file = {};
+    file.cbStruct = sizeof(file);
+    file.pcwszFilePath = wide.c_str();
+
+    WINTRUST_DATA data = {};
+    data.cbStruct = sizeof(data);
+    data.dwUIChoice = WTD_UI_NONE;
+    data.fdwRevocationChecks = WTD_REVOKE_NONE;
+    data.dwUnionChoice = WTD_CHOICE_FILE;
+    data.pFile = &file;
+    data.dwStateAction = WTD_STATEACTION_VERIFY;
+
+    GUID action = WINTRUST_ACTION_GENERIC_VERIFY_V2;
+    LONG status = WinVerifyTrust((HWND)INVALID_HANDLE_VALUE, &action, &data);
+    data.dwStateAction = WTD_STATEACTION_CLOSE;
+    WinVerifyTrust((HWND)INVALID_HANDLE_VALUE, &action, &data);
+
+    if (status != ERROR_SUCCESS) {
+        AUDIT_LOG("VERIFY", "Catalog signature not trusted: " + catalog.string() + " (" + std::to_string(status) + ")");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * [MAIDOS-AUDIT] 安裝前信任檢查: 須有套件外的可信清單，或 INF 目錄檔有有效簽章；兩者皆無則拒絕
+ * 套件內的 maidos.sha256 與套件一起被竄改即失去意義，不作為信任來源
+ * @return 0=通過, 其他=安裝函式應回傳的錯誤碼
+ */
+static int CheckPackageTrust(const std::string& infPath, const char* manifestPath) {
+    std::string packageDir = std::filesystem::path(infPath).parent_path().string();
+    if (manifestPath && manifestPath[0]) {
+        if (IsInside(manifestPath, packageDir)) {
+            AUDIT_LOG("INSTALL", "Manifest inside the package is not trusted: " + std::string(manifestPath));
+            return -(int)ERROR_INVALID_IMAGE_HASH;
+        }
+        if (VerifyPackage(packageDir, manifestPath, nullptr) != 0) {
+            AUDIT_LOG("INSTALL", "Package integrity check failed, install aborted.");
+            return -(int)ERROR_DATA_CHECKSUM_ERROR;
+        }
+        AUDIT_LOG("INSTALL", "Package integrity verified against trusted manifest.");
+        return 0;
+    }
+    if (!HasTrustedCatalog(infPath)) {
+        AUDIT_LOG("INSTALL", "No trusted manifest or signed catalog, install refused.");
+        return -(int)ERROR_INVALID_IMAGE_HASH;
+    }
+    AUDIT_LOG("INSTALL", "Package catalog signature verified.");
+    return 0;
+}
+
 extern "C" {
+    __declspec(dllexport) int install_driver_native_verified(const char* infPath, const char* manifestPath);
+
+    /**
+     * [MAIDOS-AUDIT] 安裝驅動套件 (INF 目錄檔須有有效簽章)
+     * @return 1=成功, 2=成功需重新開機, 負值=-錯誤碼 (未通過信任檢查為 -ERROR_INVALID_IMAGE_HASH)
+     */
     __declspec(dllexport) int install_driver_native(const char* infPath) {
+        return install_driver_native_verified(infPath, nullptr);
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 安裝驅動套件
+     * @param manifestPath 套件外的可信 sha256sum 清單 (例如隨更新目錄下載並驗證者)；
+     *        NULL=改為要求 INF 目錄檔有有效簽章。清單位於套件目錄內時拒絕
+     * @return 1=成功, 2=成功需重新開機, -ERROR_DATA_CHECKSUM_ERROR=檔案不符,
+     *         -ERROR_INVALID_IMAGE_HASH=沒有可信清單或簽章, 其他負值=-安裝錯誤碼
+     */
+    __declspec(dllexport) int install_driver_native_verified(const char* infPath, const char* manifestPath) {
+        if (!infPath) return -(int)ERROR_INVALID_PARAMETER;
         AUDIT_ENTRY(install_driver_native);
         AUDIT_LOG("INSTALL", "INF Path: " + std::string(infPath));
 
+        int trust = CheckPackageTrust(infPath, manifestPath);
+        if (trust != 0) {
+            AUDIT_EXIT(install_driver_native);
+            return trust;
+        }
+
         RESTOREPOINTINFOA rpInfo;
         STATEMGRSTATUS rpStatus;
         rpInfo.dwEventType = BEGIN_SYSTEM_CHANGE;
@@ -56,4 +195,35 @@ extern "C" {
             return -(int)err;
         }
     }
+
+    /**
+     * [MAIDOS-AUDIT] 設定持久化雜湊快取檔 (未變動的套件檔案不再重算)
+     * @return 1=成功, -1=快取檔格式錯誤 (改用空快取)
+     */
+    __declspec(dllexport) int set_package_hash_cache(const char* cachePath) {
+        if (!cachePath) return -1;
+        std::lock_guard<std::mutex> guard(g_hashCacheLock);
+        g_hashCache.reset(new HashCache(cachePath));
+        std::string error;
+        if (!g_hashCache->Load(&error)) {
+            AUDIT_LOG("VERIFY", error);
+            return -1;
+        }
+        return 1;
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 核對驅動套件 (並行 SHA-256，結果快取)
+     * @param packageDir 套件目錄
+     * @param manifestPath sha256sum 格式清單 (NULL=套件目錄內的 maidos.sha256)
+     * @param checked 輸出核對的檔案數 (可為 NULL)
+     * @return 不符/遺失檔案數, 0=全部相符, -1=錯誤
+     */
+    __declspec(dllexport) int verify_driver_package(const char* packageDir, const char* manifestPath, int* checked) {
+        AUDIT_ENTRY(verify_driver_package);
+        if (!packageDir) return -1;
+        int failed = VerifyPackage(packageDir, manifestPath ? manifestPath : "", checked);
+        AUDIT_EXIT(verify_driver_package);
+        return failed;
+    }
 }
\ No newline at end of file
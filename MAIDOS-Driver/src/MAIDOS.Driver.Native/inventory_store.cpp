@@ -0,0 +1,529 @@
+#pragma warning(disable: 4819)
+#include "inventory_store.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <unordered_set>
+
+namespace fs = std::filesystem;
+
+#define INVENTORY_SNAPSHOT_MAGIC 0x5649444Du   // "MDIV"
+#define INVENTORY_JOURNAL_MAGIC  0x4A49444Du   // "MDIJ"
+#define INVENTORY_CURSOR_MAGIC   0x4349444Du   // "MDIC"
+#define INVENTORY_STORE_VERSION  1
+#define JOURNAL_HEADER_SIZE      8
+#define JOURNAL_MAX_RECORD       (1u << 20)
+
+namespace {
+
+// 小端序二進位寫入/讀取 (目標平台皆為小端序，直接 memcpy)
+class Writer {
+public:
+    template <typename T>
+    void Put(T value) {
+        char raw[sizeof(T)];
+        memcpy(raw, &value, sizeof(T));
+        out_.append(raw, sizeof(T));
+    }
+
+    void PutString(std::string_view s) {
+        size_t n = s.size() < 0xFFFF ? s.size() : 0xFFFF;
+        Put<uint16_t>((uint16_t)n);
+        out_.append(s.data(), n);
+    }
+
+    std::string& Data() { return out_; }
+
+private:
+    std::string out_;
+};
+
+class Reader {
+public:
+    Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    template <typename T>
+    bool Get(T& value) {
+        if (size_ - pos_ < sizeof(T)) return false;
+        memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+
+    bool GetString(std::string& s) {
+        uint16_t n;
+        if (!Get(n) || size_ - pos_ < n) return false;
+        s.assign(data_ + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    size_t Position() const { return pos_; }
+    bool AtEnd() const { return pos_ == size_; }
+
+private:
+    const char* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+bool ReadFile(const std::string& path, std::string& out) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    std::ostringstream content;
+    content << in.rdbuf();
+    out = content.str();
+    return true;
+}
+
+std::string EncodeChange(const InventoryChange& c) {
+    Writer payload;
+    payload.Put<uint64_t>(c.sequence);
+    payload.Put<int64_t>(c.time);
+    payload.Put<uint32_t>(c.kind);
+    payload.Put<uint32_t>(c.old_problem);
+    payload.Put<uint32_t>(c.new_problem);
+    payload.Put<uint32_t>(c.new_status);
+    payload.Put<uint64_t>(c.new_hash);
+    payload.PutString(c.instance_id);
+    payload.PutString(c.old_version);
+    payload.PutString(c.new_version);
+
+    Writer record;
+    record.Put<uint32_t>((uint32_t)payload.Data().size());
+    record.Data().append(payload.Data());
+    record.Put<uint64_t>(Fnv1a64(payload.Data().data(), payload.Data().size()));
+    return record.Data();
+}
+
+bool DecodeChange(const char* data, size_t size, InventoryChange& c) {
+    Reader r(data, size);
+    return r.Get(c.sequence) && r.Get(c.time) && r.Get(c.kind) && r.Get(c.old_problem) && r.Get(c.new_problem) &&
+           r.Get(c.new_status) && r.Get(c.new_hash) && r.GetString(c.instance_id) && r.GetString(c.old_version) &&
+           r.GetString(c.new_version) && r.AtEnd() && c.kind >= INVENTORY_CHANGE_ADDED &&
+           c.kind <= INVENTORY_CHANGE_PROPERTIES;
+}
+
+/**
+ * 逐筆解析日誌，遇到不完整/校驗失敗的紀錄即停止
+ * @param good_end 輸出最後一筆完整紀錄的結尾位置
+ * @return false=標頭錯誤
+ */
+template <typename Visit>
+bool ParseJournal(const std::string& data, size_t& good_end, Visit visit) {
+    good_end = 0;
+    if (data.size() < JOURNAL_HEADER_SIZE) return data.empty();
+    uint32_t magic, version;
+    memcpy(&magic, data.data(), 4);
+    memcpy(&version, data.data() + 4, 4);
+    if (magic != INVENTORY_JOURNAL_MAGIC || version != INVENTORY_STORE_VERSION) return false;
+
+    size_t pos = JOURNAL_HEADER_SIZE;
+    good_end = pos;
+    uint64_t last = 0;
+    while (data.size() - pos >= 4) {
+        uint32_t length;
+        memcpy(&length, data.data() + pos, 4);
+        if (length > JOURNAL_MAX_RECORD || data.size() - pos - 4 < (size_t)length + 8) break;
+        const char* payload = data.data() + pos + 4;
+        uint64_t checksum;
+        memcpy(&checksum, payload + length, 8);
+        InventoryChange c;
+        if (checksum != Fnv1a64(payload, length) || !DecodeChange(payload, length, c) || c.sequence <= last) break;
+        last = c.sequence;
+        pos += 4 + (size_t)length + 8;
+        good_end = pos;
+        visit(c);
+    }
+    return true;
+}
+
+std::string JournalHeader() {
+    Writer w;
+    w.Put<uint32_t>(INVENTORY_JOURNAL_MAGIC);
+    w.Put<uint32_t>(INVENTORY_STORE_VERSION);
+    return w.Data();
+}
+
+bool WriteAtomically(const std::string& path, const std::string& data, std::string* error) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), (std::streamsize)data.size());
+        out.flush();
+        if (!out) {
+            if (error) *error = "Cannot write " + tmp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        if (error) *error = "Cannot commit " + path;
+        return false;
+    }
+    return true;
+}
+
+void HashField(uint64_t& hash, std::string_view s) {
+    uint32_t length = (uint32_t)s.size();
+    hash = Fnv1a64((const char*)&length, sizeof(length), hash);
+    hash = Fnv1a64(s.data(), s.size(), hash);
+}
+
+}  // namespace
+
+uint64_t DevicePropertyHash(const DeviceInventory& inventory, size_t row) {
+    uint64_t hash = 1469598103934665603ULL;
+    HashField(hash, inventory.Name(row));
+    HashField(hash, inventory.Manufacturer(row));
+    HashField(hash, inventory.DriverVersion(row));
+    HashField(hash, inventory.HardwareIdsRaw(row));
+    HashField(hash, inventory.CompatibleIdsRaw(row));
+    return hash;
+}
+
+std::string InventoryStore::SnapshotPath() const {
+    return (fs::path(dir_) / "inventory.bin").string();
+}
+
+std::string InventoryStore::JournalPath() const {
+    return (fs::path(dir_) / "inventory.journal").string();
+}
+
+std::string InventoryStore::CursorPath(const std::string& consumer) const {
+    return (fs::path(dir_) / ("cursor." + consumer)).string();
+}
+
+uint64_t InventoryStore::LoadCursor(const std::string& consumer) const {
+    std::string data;
+    if (!ReadFile(CursorPath(consumer), data)) return 0;
+
+    Reader r(data.data(), data.size());
+    uint32_t magic = 0, version = 0;
+    uint64_t sequence = 0, checksum = 0;
+    if (!r.Get(magic) || !r.Get(version) || !r.Get(sequence) || !r.Get(checksum) || !r.AtEnd() ||
+        magic != INVENTORY_CURSOR_MAGIC || version != INVENTORY_STORE_VERSION ||
+        checksum != Fnv1a64((const char*)&sequence, sizeof(sequence))) {
+        AUDIT_LOG("INVSTORE", "Ignoring damaged cursor " + CursorPath(consumer));
+        return 0;
+    }
+    return sequence;
+}
+
+bool InventoryStore::SaveCursor(const std::string& consumer, uint64_t sequence, std::string* error) const {
+    Writer w;
+    w.Put<uint32_t>(INVENTORY_CURSOR_MAGIC);
+    w.Put<uint32_t>(INVENTORY_STORE_VERSION);
+    w.Put<uint64_t>(sequence);
+    w.Put<uint64_t>(Fnv1a64((const char*)&sequence, sizeof(sequence)));
+    return WriteAtomically(CursorPath(consumer), w.Data(), error);
+}
+
+const StoredDevice* InventoryStore::Find(const std::string& instance_id) const {
+    auto it = devices_.find(instance_id);
+    return it == devices_.end() ? nullptr : &it->second;
+}
+
+bool InventoryStore::Open(std::string* error) {
+    devices_.clear();
+    sequence_ = snapshot_sequence_ = 0;
+    journal_records_ = 0;
+    open_ = false;
+
+    std::error_code ec;
+    fs::create_directories(dir_, ec);
+    if (ec) {
+        if (error) *error = "Cannot create " + dir_ + ": " + ec.message();
+        return false;
+    }
+    if (!LoadSnapshot(error) || !ReplayJournal(error)) {
+        devices_.clear();
+        return false;
+    }
+    open_ = true;
+    AUDIT_LOG("INVSTORE", "Opened " + dir_ + ": " + std::to_string(devices_.size()) + " devices, sequence " +
+              std::to_string(sequence_) + " (" + std::to_string(journal_records_) + " journal records)");
+    return true;
+}
+
+bool InventoryStore::LoadSnapshot(std::string* error) {
+    std::string data;
+    if (!ReadFile(SnapshotPath(), data)) return true;  // 尚無快照
+
+    const size_t header = 24;
+    if (data.size() < header + 8) {
+        if (error) *error = "Truncated snapshot: " + SnapshotPath();
+        return false;
+    }
+    uint64_t checksum;
+    memcpy(&checksum, data.data() + data.size() - 8, 8);
+    if (checksum != Fnv1a64(data.data(), data.size() - 8)) {
+        if (error) *error = "Snapshot checksum mismatch: " + SnapshotPath();
+        return false;
+    }
+
+    Reader r(data.data(), data.size() - 8);
+    uint32_t magic, version, count, reserved;
+    uint64_t sequence;
+    if (!r.Get(magic) || !r.Get(version) || !r.Get(sequence) || !r.Get(count) || !r.Get(reserved) ||
+        magic != INVENTORY_SNAPSHOT_MAGIC || version != INVENTORY_STORE_VERSION) {
+        if (error) *error = "Not an inventory snapshot: " + SnapshotPath();
+        return false;
+    }
+    devices_.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+        StoredDevice d;
+        std::string id;
+        if (!r.Get(d.property_hash) || !r.Get(d.status) || !r.Get(d.problem_code) || !r.GetString(id) ||
+            !r.GetString(d.driver_version)) {
+            if (error) *error = "Malformed snapshot: " + SnapshotPath();
+            return false;
+        }
+        devices_[std::move(id)] = std::move(d);
+    }
+    if (!r.AtEnd()) {
+        if (error) *error = "Malformed snapshot: " + SnapshotPath();
+        return false;
+    }
+    sequence_ = snapshot_sequence_ = sequence;
+    return true;
+}
+
+bool InventoryStore::ReplayJournal(std::string* error) {
+    std::string path = JournalPath();
+    std::string data;
+    if (!ReadFile(path, data) || data.size() < JOURNAL_HEADER_SIZE) {
+        // 不存在或連標頭都不完整: 重建空日誌
+        return WriteAtomically(path, JournalHeader(), error);
+    }
+
+    size_t good_end = 0;
+    bool ok = ParseJournal(data, good_end, [&](const InventoryChange& c) {
+        if (c.sequence <= snapshot_sequence_) return;  // 已併入快照 (壓縮途中中斷)
+        Apply(c);
+        sequence_ = c.sequence;
+        journal_records_++;
+    });
+    if (!ok) {
+        if (error) *error = "Not an inventory journal: " + path;
+        return false;
+    }
+    if (good_end < data.size()) {
+        std::error_code ec;
+        fs::resize_file(path, good_end, ec);
+        AUDIT_LOG("INVSTORE", "Truncated " + std::to_string(data.size() - good_end) + " torn bytes from " + path);
+        if (ec) {
+            if (error) *error = "Cannot truncate " + path + ": " + ec.message();
+            return false;
+        }
+    }
+    return true;
+}
+
+void InventoryStore::Apply(const InventoryChange& c) {
+    if (c.kind == INVENTORY_CHANGE_REMOVED) {
+        devices_.erase(c.instance_id);
+        return;
+    }
+    StoredDevice& d = devices_[c.instance_id];
+    d.property_hash = c.new_hash;
+    d.driver_version = c.new_version;
+    d.status = c.new_status;
+    d.problem_code = c.new_problem;
+}
+
+bool InventoryStore::Append(const std::vector<InventoryChange>& changes, std::string* error) {
+    std::string path = JournalPath();
+    std::error_code ec;
+    uintmax_t before = fs::file_size(path, ec);
+    if (ec) {
+        if (error) *error = "Cannot stat " + path + ": " + ec.message();
+        return false;
+    }
+
+    std::string data;
+    for (const InventoryChange& c : changes) data += EncodeChange(c);
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write(data.data(), (std::streamsize)data.size());
+        out.flush();
+        if (out) return true;
+    }
+
+    // 寫入失敗: 截回原大小，避免後續紀錄接在殘缺紀錄之後
+    fs::resize_file(path, before, ec);
+    if (error) *error = "Write failed: " + path;
+    return false;
+}
+
+bool InventoryStore::Commit(const DeviceInventory& inventory, std::vector<InventoryChange>* changes_out,
+                            std::string* error) {
+    if (changes_out) changes_out->clear();
+    if (!open_) {
+        if (error) *error = "Inventory store not open";
+        return false;
+    }
+
+    int64_t now = (int64_t)std::time(nullptr);
+    uint64_t sequence = sequence_;
+    std::vector<InventoryChange> changes;
+    auto make = [&](uint32_t kind, std::string_view id) -> InventoryChange& {
+        changes.emplace_back();
+        InventoryChange& c = changes.back();
+        c.sequence = ++sequence;
+        c.time = now;
+        c.kind = kind;
+        c.instance_id = std::string(id);
+        return c;
+    };
+
+    std::unordered_set<std::string_view> seen;
+    seen.reserve(inventory.Size());
+    for (size_t row = 0; row < inventory.Size(); row++) {
+        std::string_view id = inventory.InstanceId(row);
+        std::string_view version = inventory.DriverVersion(row);
+        uint64_t hash = DevicePropertyHash(inventory, row);
+        uint32_t status = inventory.Status(row);
+        uint32_t problem = inventory.ProblemCode(row);
+        seen.insert(id);
+
+        auto fill = [&](InventoryChange& c) {
+            c.new_version = std::string(version);
+            c.new_status = status;
+            c.new_problem = problem;
+            c.new_hash = hash;
+        };
+
+        const StoredDevice* old = Find(std::string(id));
+        if (!old) {
+            fill(make(INVENTORY_CHANGE_ADDED, id));
+            continue;
+        }
+        if (old->driver_version != version || old->property_hash != hash) {
+            InventoryChange& c = make(old->driver_version != version ? INVENTORY_CHANGE_DRIVER : INVENTORY_CHANGE_PROPERTIES, id);
+            c.old_version = old->driver_version;
+            c.old_problem = old->problem_code;
+            fill(c);
+        }
+        if (old->problem_code != problem || old->status != status) {
+            InventoryChange& c = make(INVENTORY_CHANGE_PROBLEM, id);
+            c.old_version = old->driver_version;
+            c.old_problem = old->problem_code;
+            fill(c);
+        }
+    }
+
+    // 移除的設備依實例ID排序，日誌內容與雜湊表順序無關
+    std::vector<const std::string*> removed;
+    for (const auto& kv : devices_) {
+        if (!seen.count(kv.first)) removed.push_back(&kv.first);
+    }
+    std::sort(removed.begin(), removed.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+    for (const std::string* id : removed) {
+        const StoredDevice& old = devices_[*id];
+        InventoryChange& c = make(INVENTORY_CHANGE_REMOVED, *id);
+        c.old_version = old.driver_version;
+        c.old_problem = old.problem_code;
+    }
+
+    if (changes.empty()) return true;
+    if (!Append(changes, error)) {
+        AUDIT_LOG("INVSTORE", "Journal append failed: " + JournalPath());
+        return false;
+    }
+    for (const InventoryChange& c : changes) Apply(c);
+    sequence_ = sequence;
+    journal_records_ += changes.size();
+    AUDIT_LOG("INVSTORE", "Committed " + std::to_string(changes.size()) + " changes, sequence " + std::to_string(sequence_));
+
+    if (compact_threshold_ > 0 && journal_records_ > compact_threshold_) {
+        std::string compact_error;
+        if (!Compact(&compact_error)) AUDIT_LOG("INVSTORE", "Compaction failed: " + compact_error);
+    }
+    if (changes_out) *changes_out = std::move(changes);
+    return true;
+}
+
+bool InventoryStore::ReadChanges(uint64_t after, std::vector<InventoryChange>& out, std::string* error) const {
+    out.clear();
+    if (after < snapshot_sequence_) {
+        if (error) *error = "Changes before sequence " + std::to_string(snapshot_sequence_) + " were compacted";
+        return false;
+    }
+    std::string data;
+    if (!ReadFile(JournalPath(), data)) {
+        if (error) *error = "Cannot open " + JournalPath();
+        return false;
+    }
+    size_t good_end = 0;
+    bool ok = ParseJournal(data, good_end, [&](const InventoryChange& c) {
+        if (c.sequence > after && c.sequence <= sequence_) out.push_back(c);
+    });
+    if (!ok && error) *error = "Not an inventory journal: " + JournalPath();
+    return ok;
+}
+
+bool InventoryStore::Compact(std::string* error) {
+    if (!open_) {
+        if (error) *error = "Inventory store not open";
+        return false;
+    }
+
+    std::vector<const std::pair<const std::string, StoredDevice>*> sorted;
+    sorted.reserve(devices_.size());
+    for (const auto& kv : devices_) sorted.push_back(&kv);
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    Writer w;
+    w.Put<uint32_t>(INVENTORY_SNAPSHOT_MAGIC);
+    w.Put<uint32_t>(INVENTORY_STORE_VERSION);
+    w.Put<uint64_t>(sequence_);
+    w.Put<uint32_t>((uint32_t)sorted.size());
+    w.Put<uint32_t>(0);
+    for (const auto* kv : sorted) {
+        w.Put<uint64_t>(kv->second.property_hash);
+        w.Put<uint32_t>(kv->second.status);
+        w.Put<uint32_t>(kv->second.problem_code);
+        w.PutString(kv->first);
+        w.PutString(kv->second.driver_version);
+    }
+    w.Put<uint64_t>(Fnv1a64(w.Data().data(), w.Data().size()));
+
+    // 先寫快照再清空日誌；中途中斷時，序號不大於快照的日誌紀錄在重播時略過
+    if (!WriteAtomically(SnapshotPath(), w.Data(), error)) return false;
+    snapshot_sequence_ = sequence_;
+    if (!WriteAtomically(JournalPath(), JournalHeader(), error)) return false;
+    journal_records_ = 0;
+    AUDIT_LOG("INVSTORE", "Compacted " + std::to_string(devices_.size()) + " devices at sequence " + std::to_string(sequence_));
+    return true;
+}
+
+std::vector<std::string> InventoryDeltaIds(const std::vector<InventoryChange>& changes) {
+    std::vector<std::string> ids;
+    std::unordered_set<std::string> seen;
+    for (const InventoryChange& c : changes) {
+        if (c.kind != INVENTORY_CHANGE_ADDED && c.kind != INVENTORY_CHANGE_DRIVER && c.kind != INVENTORY_CHANGE_PROPERTIES) continue;
+        if (seen.insert(c.instance_id).second) ids.push_back(c.instance_id);
+    }
+    return ids;
+}
+
+InventoryStore* SharedInventoryStore(const std::string& dir, std::string* error) {
+    static std::unique_ptr<InventoryStore> store;
+    static std::string opened;
+    if (!store || opened != dir) {
+        std::unique_ptr<InventoryStore> next(new InventoryStore(dir));
+        if (!next->Open(error)) return nullptr;
+        store = std::move(next);
+        opened = dir;
+    }
+    return store.get();
+}
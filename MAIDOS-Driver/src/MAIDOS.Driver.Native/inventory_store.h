@@ -0,0 +1,136 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 持久化硬體清單 + 變更日誌 (跨開機)
+ * 功能: 以實例ID為鍵保存每個設備的屬性雜湊、驅動版本與問題碼；每次提交與目前清單比對，
+ *       把差異 (新增/移除/驅動變更/問題碼變更/屬性變更) 附加到只增不改的日誌，
+ *       下游比對與更新檢查只需處理日誌中的差異
+ *
+ * 目錄內容 (小端序):
+ *   inventory.bin      快照: 標頭 + 每設備一筆 + FNV-1a 校驗；暫存檔寫完後改名
+ *   inventory.journal  日誌: 標頭 + [長度][內容][FNV-1a] 紀錄；開啟時截去不完整的尾端
+ *   cursor.<名稱>      下游游標: 各消費者已處理到的日誌序號 (與提交互相獨立)
+ * 開啟 = 載入快照 + 重播序號大於快照的日誌紀錄；日誌過長時自動壓縮回快照
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "device_inventory.h"
+
+// 變更種類
+enum InventoryChangeKind : uint32_t {
+    INVENTORY_CHANGE_ADDED      = 1,
+    INVENTORY_CHANGE_REMOVED    = 2,
+    INVENTORY_CHANGE_DRIVER     = 3,  // 驅動版本改變
+    INVENTORY_CHANGE_PROBLEM    = 4,  // 問題碼改變
+    INVENTORY_CHANGE_PROPERTIES = 5,  // 驅動版本相同，其他屬性 (名稱/硬體ID...) 改變
+};
+
+// 日誌紀錄
+struct InventoryChange {
+    uint64_t sequence = 0;      // 單調遞增，從 1 開始
+    int64_t time = 0;           // Unix 秒
+    uint32_t kind = 0;          // InventoryChangeKind
+    std::string instance_id;
+    std::string old_version;
+    std::string new_version;
+    uint32_t old_problem = 0;
+    uint32_t new_problem = 0;
+    uint32_t new_status = 0;    // DeviceStatusFlags
+    uint64_t new_hash = 0;      // 新的屬性雜湊 (重播用)
+};
+
+// 儲存的設備狀態
+struct StoredDevice {
+    uint64_t property_hash = 0;
+    std::string driver_version;
+    uint32_t status = 0;
+    uint32_t problem_code = 0;
+};
+
+// 屬性雜湊: 名稱、製造商、驅動版本、硬體ID、相容ID (不含狀態/問題碼，兩者另行追蹤)
+uint64_t DevicePropertyHash(const DeviceInventory& inventory, size_t row);
+
+class InventoryStore {
+public:
+    explicit InventoryStore(std::string dir) : dir_(std::move(dir)) {}
+
+    /**
+     * [MAIDOS-AUDIT] 開啟 (目錄不存在則建立): 載入快照並重播日誌
+     * 日誌尾端不完整 (寫入中斷) 時截斷到最後一筆完整紀錄
+     * @return true=成功, false=檔案損毀或無法存取
+     */
+    bool Open(std::string* error = nullptr);
+
+    /**
+     * [MAIDOS-AUDIT] 與目前清單比對並提交差異
+     * @param changes 輸出本次新增的日誌紀錄 (可為 nullptr)
+     * @return true=成功 (無差異也算成功), false=寫入失敗 (儲存內容不變)
+     */
+    bool Commit(const DeviceInventory& inventory, std::vector<InventoryChange>* changes = nullptr,
+                std::string* error = nullptr);
+
+    /**
+     * [MAIDOS-AUDIT] 讀取序號大於 after 的日誌紀錄 (下游以自己的游標取得差異)
+     * @return true=完整, false=after 早於 JournalStart() (已被壓縮，呼叫端須全量處理) 或讀取失敗
+     */
+    bool ReadChanges(uint64_t after, std::vector<InventoryChange>& out, std::string* error = nullptr) const;
+
+    /**
+     * [MAIDOS-AUDIT] 下游游標: 消費者以 ReadChanges(LoadCursor(名稱)) 取得差異，
+     * 結果交付後才以讀到的最後序號 SaveCursor；提交本身不推進任何游標
+     * @return LoadCursor: 尚無游標或檔案損毀時為 0 (視為從頭處理)
+     */
+    uint64_t LoadCursor(const std::string& consumer) const;
+    bool SaveCursor(const std::string& consumer, uint64_t sequence, std::string* error = nullptr) const;
+
+    /**
+     * [MAIDOS-AUDIT] 壓縮: 寫入新快照並清空日誌
+     * 游標早於壓縮點的消費者之後 ReadChanges 會失敗，須改為全量處理
+     */
+    bool Compact(std::string* error = nullptr);
+
+    // 最後一筆日誌序號 (尚無紀錄為 0)
+    uint64_t Sequence() const { return sequence_; }
+
+    // 日誌中可取得的最小序號 - 1 (即快照涵蓋到的序號)
+    uint64_t JournalStart() const { return snapshot_sequence_; }
+
+    size_t JournalRecords() const { return journal_records_; }
+    size_t Size() const { return devices_.size(); }
+    const StoredDevice* Find(const std::string& instance_id) const;
+
+    // 日誌超過此紀錄數時 Commit 後自動壓縮 (0=不自動壓縮)
+    void SetCompactThreshold(size_t records) { compact_threshold_ = records; }
+
+    std::string SnapshotPath() const;
+    std::string JournalPath() const;
+    std::string CursorPath(const std::string& consumer) const;
+
+private:
+    bool LoadSnapshot(std::string* error);
+    bool ReplayJournal(std::string* error);
+    bool Append(const std::vector<InventoryChange>& changes, std::string* error);
+    void Apply(const InventoryChange& change);
+
+    std::string dir_;
+    std::unordered_map<std::string, StoredDevice> devices_;
+    uint64_t sequence_ = 0;
+    uint64_t snapshot_sequence_ = 0;
+    size_t journal_records_ = 0;
+    size_t compact_threshold_ = 8192;
+    bool open_ = false;
+};
+
+// 需要重新比對/檢查更新的設備 (新增、驅動變更、屬性變更)，依序去重
+std::vector<std::string> InventoryDeltaIds(const std::vector<InventoryChange>& changes);
+
+/**
+ * [MAIDOS-AUDIT] 行程共用儲存；dir 與上次不同時重新開啟
+ * 使用前須持有 SharedDeviceInventoryLock()
+ * @return nullptr=開啟失敗
+ */
+InventoryStore* SharedInventoryStore(const std::string& dir, std::string* error = nullptr);
@@ -15,7 +15,11 @@ public:
         auto now_t = std::chrono::system_clock::to_time_t(now);
         
         struct tm timeinfo;
+#ifdef _WIN32
         localtime_s(&timeinfo, &now_t);
+#else
+        localtime_r(&now_t, &timeinfo);
+#endif
         
         std::cout << "[MAIDOS-AUDIT][" << module << "] " << message << std::endl;
         
@@ -0,0 +1,115 @@
+#pragma warning(disable: 4819)
+#include "lz_codec.h"
+
+#include <cstring>
+
+#define LZ_MIN_MATCH     4
+#define LZ_HASH_BITS     16
+#define LZ_MAX_OFFSET    65535
+#define LZ_LAST_LITERALS 5    // 區塊最後 5 位元組一律為字面值
+#define LZ_MF_LIMIT      12   // 距結尾 12 位元組內不再開始比對
+
+static inline uint32_t Read32(const uint8_t* p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline uint32_t Hash4(uint32_t v) { return (v * 2654435761u) >> (32 - LZ_HASH_BITS); }
+
+static void WriteLength(std::vector<uint8_t>& out, size_t len) {
+    for (; len >= 255; len -= 255) out.push_back(255);
+    out.push_back((uint8_t)len);
+}
+
+static void EmitSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t lit_len, size_t offset, size_t match_len) {
+    size_t ml = match_len ? match_len - LZ_MIN_MATCH : 0;
+    out.push_back((uint8_t)((lit_len >= 15 ? 15 : lit_len) << 4 | (ml >= 15 ? 15 : ml)));
+    if (lit_len >= 15) WriteLength(out, lit_len - 15);
+    out.insert(out.end(), literals, literals + lit_len);
+    if (!match_len) return;  // 最後一段只有字面值
+    out.push_back((uint8_t)offset);
+    out.push_back((uint8_t)(offset >> 8));
+    if (ml >= 15) WriteLength(out, ml - 15);
+}
+
+size_t LzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>& out) {
+    size_t start = out.size();
+    size_t anchor = 0;
+
+    if (size > LZ_MF_LIMIT) {
+        // 雜湊表存位置 + 1，0 表示空
+        std::vector<uint32_t> table((size_t)1 << LZ_HASH_BITS, 0);
+        const size_t limit = size - LZ_MF_LIMIT;
+        const size_t match_limit = size - LZ_LAST_LITERALS;
+        size_t ip = 0;
+
+        while (ip < limit) {
+            uint32_t seq = Read32(src + ip);
+            uint32_t h = Hash4(seq);
+            size_t ref = table[h];
+            table[h] = (uint32_t)(ip + 1);
+
+            if (ref == 0 || ip - (ref - 1) > LZ_MAX_OFFSET || Read32(src + ref - 1) != seq) {
+                ip += 1 + ((ip - anchor) >> 6);  // 長時間無匹配時加速跳過 (不可壓縮資料)
+                continue;
+            }
+            ref--;
+
+            size_t len = LZ_MIN_MATCH;
+            while (ip + len < match_limit && src[ref + len] == src[ip + len]) len++;
+
+            EmitSequence(out, src + anchor, ip - anchor, ip - ref, len);
+            ip += len;
+            anchor = ip;
+        }
+    }
+
+    EmitSequence(out, src + anchor, size - anchor, 0, 0);
+    return out.size() - start;
+}
+
+bool LzDecompress(const uint8_t* src, size_t size, uint8_t* out, size_t raw_size) {
+    size_t ip = 0, op = 0;
+    auto read_length = [&](size_t& len) {
+        uint8_t b;
+        do {
+            if (ip >= size) return false;
+            b = src[ip++];
+            len += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (ip < size) {
+        uint8_t token = src[ip++];
+
+        size_t lit = token >> 4;
+        if (lit == 15 && !read_length(lit)) return false;
+        if (lit > size - ip || lit > raw_size - op) return false;
+        memcpy(out + op, src + ip, lit);
+        ip += lit;
+        op += lit;
+        if (ip == size) break;  // 最後一段
+
+        if (size - ip < 2) return false;
+        size_t offset = src[ip] | (size_t)src[ip + 1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > op) return false;
+
+        size_t len = token & 15;
+        if (len == 15 && !read_length(len)) return false;
+        len += LZ_MIN_MATCH;
+        if (len > raw_size - op) return false;
+
+        // 來源與目的可能重疊 (offset < len)，逐位元組複製
+        const uint8_t* from = out + op - offset;
+        if (offset >= len) {
+            memcpy(out + op, from, len);
+        } else {
+            for (size_t i = 0; i < len; i++) out[op + i] = from[i];
+        }
+        op += len;
+    }
+    return op == raw_size;
+}
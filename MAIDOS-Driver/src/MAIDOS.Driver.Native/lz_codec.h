@@ -0,0 +1,23 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] LZ 區塊壓縮 (LZ4 區塊格式相容的精簡實作)
+ * 功能: 無外部相依的快速壓縮，供備份倉庫壓縮區塊使用
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * 壓縮一個區塊 (附加到 out 後方)
+ * @return 壓縮後大小
+ */
+size_t LzCompress(const uint8_t* src, size_t size, std::vector<uint8_t>& out);
+
+/**
+ * 解壓縮一個區塊
+ * @param raw_size 原始大小 (由呼叫端保存)
+ * @return true=成功且大小正確, false=資料損壞
+ */
+bool LzDecompress(const uint8_t* src, size_t size, uint8_t* out, size_t raw_size);
@@ -0,0 +1,407 @@
+#pragma warning(disable: 4819)
+#include "package_verifier.h"
+#include "device_provider.h"
+#include "logger.h"
+#include "sha256.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#define HASH_CACHE_MAGIC "MAIDOS-HASHCACHE 1"
+#define HASH_READ_BLOCK  (1 << 20)   // 1 MiB 循序讀取
+
+// 快取鍵: 正規化的絕對路徑
+static std::string CacheKey(const std::string& path) {
+    std::error_code ec;
+    fs::path abs = fs::absolute(path, ec);
+    return (ec ? fs::path(path) : abs).lexically_normal().generic_string();
+}
+
+bool ReadFileStamp(const std::string& path, FileStamp& out) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    BY_HANDLE_FILE_INFORMATION info;
+    BOOL ok = GetFileInformationByHandle(file, &info);
+    CloseHandle(file);
+    if (!ok || (info.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) return false;
+    out.size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    out.mtime = (int64_t)(((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime);
+    uint64_t index = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+    out.file_id = Fnv1a64((const char*)&index, sizeof(index), info.dwVolumeSerialNumber);
+#else
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    out.size = (uint64_t)st.st_size;
+    out.mtime = (int64_t)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+    uint64_t ino = (uint64_t)st.st_ino;
+    out.file_id = Fnv1a64((const char*)&ino, sizeof(ino), (uint64_t)st.st_dev);
+#endif
+    return true;
+}
+
+bool HashFileSha256(const std::string& path, std::string& hex, std::string* error) {
+    std::unique_ptr<char[]> buffer(new char[HASH_READ_BLOCK]);
+    Sha256 sha;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        if (error) *error = "Cannot open " + path;
+        return false;
+    }
+    DWORD got = 0;
+    bool ok = true;
+    while ((ok = ReadFile(file, buffer.get(), HASH_READ_BLOCK, &got, NULL) != FALSE) && got > 0) {
+        sha.Update(buffer.get(), got);
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (error) *error = "Cannot open " + path;
+        return false;
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    bool ok = true;
+    while (true) {
+        ssize_t got = read(fd, buffer.get(), HASH_READ_BLOCK);
+        if (got == 0) break;
+        if (got < 0) {
+            ok = false;
+            break;
+        }
+        sha.Update(buffer.get(), (size_t)got);
+    }
+    close(fd);
+#endif
+    if (!ok) {
+        if (error) *error = "Read failed: " + path;
+        return false;
+    }
+    hex = sha.FinalHex();
+    return true;
+}
+
+bool HashCache::Load(std::string* error) {
+    std::lock_guard<std::mutex> guard(lock_);
+    entries_.clear();
+    dirty_ = false;
+    if (path_.empty()) return true;
+
+    std::ifstream in(path_, std::ios::binary);
+    if (!in.is_open()) return true;  // 尚無快取
+
+    std::string line;
+    if (!std::getline(in, line) || line != HASH_CACHE_MAGIC) {
+        if (error) *error = "Not a hash cache: " + path_;
+        return false;
+    }
+    int line_no = 1;
+    while (std::getline(in, line)) {
+        line_no++;
+        if (line.empty()) continue;
+        // size \t mtime \t file_id \t sha256 \t path (路徑可含 tab，取剩餘全部)
+        size_t t1 = line.find('\t');
+        size_t t2 = t1 == std::string::npos ? t1 : line.find('\t', t1 + 1);
+        size_t t3 = t2 == std::string::npos ? t2 : line.find('\t', t2 + 1);
+        size_t t4 = t3 == std::string::npos ? t3 : line.find('\t', t3 + 1);
+        if (t4 == std::string::npos || !IsSha256Hex(line.substr(t3 + 1, t4 - t3 - 1))) {
+            entries_.clear();
+            if (error) *error = path_ + ":" + std::to_string(line_no) + ": malformed line";
+            return false;
+        }
+        Entry e;
+        e.stamp.size = strtoull(line.c_str(), nullptr, 10);
+        e.stamp.mtime = strtoll(line.c_str() + t1 + 1, nullptr, 10);
+        e.stamp.file_id = strtoull(line.c_str() + t2 + 1, nullptr, 10);
+        e.hex = line.substr(t3 + 1, t4 - t3 - 1);
+        entries_[line.substr(t4 + 1)] = std::move(e);
+    }
+    return true;
+}
+
+bool HashCache::Save(std::string* error) {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (path_.empty() || !dirty_) return true;
+
+    std::vector<const std::pair<const std::string, Entry>*> sorted;
+    sorted.reserve(entries_.size());
+    for (const auto& kv : entries_) sorted.push_back(&kv);
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    std::string tmp = path_ + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            if (error) *error = "Cannot write " + tmp;
+            return false;
+        }
+        out << HASH_CACHE_MAGIC << "\n";
+        for (const auto* kv : sorted) {
+            if (kv->first.find('\n') != std::string::npos) continue;
+            const Entry& e = kv->second;
+            out << e.stamp.size << "\t" << e.stamp.mtime << "\t" << e.stamp.file_id << "\t" << e.hex << "\t" << kv->first << "\n";
+        }
+        out.flush();
+        if (!out) {
+            if (error) *error = "Write failed: " + tmp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, path_, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        if (error) *error = "Cannot commit " + path_;
+        return false;
+    }
+    dirty_ = false;
+    return true;
+}
+
+bool HashCache::Lookup(const std::string& path, const FileStamp& stamp, std::string& hex) const {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto it = entries_.find(CacheKey(path));
+    if (it == entries_.end() || !(it->second.stamp == stamp)) return false;
+    hex = it->second.hex;
+    return true;
+}
+
+void HashCache::Store(const std::string& path, const FileStamp& stamp, const std::string& hex) {
+    std::string key = CacheKey(path);
+    std::lock_guard<std::mutex> guard(lock_);
+    Entry& e = entries_[key];
+    if (e.stamp == stamp && e.hex == hex) return;
+    e.stamp = stamp;
+    e.hex = hex;
+    dirty_ = true;
+}
+
+size_t HashCache::Prune() {
+    std::lock_guard<std::mutex> guard(lock_);
+    size_t removed = 0;
+    for (auto it = entries_.begin(); it != entries_.end();) {
+        FileStamp now;
+        if (!ReadFileStamp(it->first, now) || !(now == it->second.stamp)) {
+            it = entries_.erase(it);
+            removed++;
+        } else {
+            ++it;
+        }
+    }
+    if (removed) dirty_ = true;
+    return removed;
+}
+
+size_t HashCache::Size() const {
+    std::lock_guard<std::mutex> guard(lock_);
+    return entries_.size();
+}
+
+bool LoadSha256Manifest(const std::string& manifest_path, std::vector<ExpectedHash>& out, std::string* error) {
+    out.clear();
+    std::ifstream in(manifest_path, std::ios::binary);
+    if (!in.is_open()) {
+        if (error) *error = "Cannot open " + manifest_path;
+        return false;
+    }
+    std::string line;
+    int line_no = 0;
+    while (std::getline(in, line)) {
+        line_no++;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line_no == 1 && line.compare(0, 3, "\xEF\xBB\xBF") == 0) line.erase(0, 3);
+        if (line.empty() || line[0] == '#') continue;
+
+        // "<hex>  <path>" 或 "<hex> *<path>"
+        if (line.size() < 66 || line[64] != ' ' || (line[65] != ' ' && line[65] != '*') || !IsSha256Hex(line.substr(0, 64))) {
+            if (error) *error = manifest_path + ":" + std::to_string(line_no) + ": malformed line";
+            return false;
+        }
+        ExpectedHash e;
+        e.sha256 = line.substr(0, 64);
+        e.path = line.substr(66);
+        if (e.path.empty()) {
+            if (error) *error = manifest_path + ":" + std::to_string(line_no) + ": missing path";
+            return false;
+        }
+        out.push_back(std::move(e));
+    }
+    return true;
+}
+
+bool WriteSha256Manifest(const std::string& manifest_path, std::vector<ExpectedHash> entries, std::string* error) {
+    std::sort(entries.begin(), entries.end(), [](const ExpectedHash& a, const ExpectedHash& b) { return a.path < b.path; });
+    std::string tmp = manifest_path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        for (const ExpectedHash& e : entries) out << e.sha256 << "  " << e.path << "\n";
+        out.flush();
+        if (!out) {
+            if (error) *error = "Cannot write " + tmp;
+            return false;
+        }
+    }
+    std::error_code ec;
+    fs::rename(tmp, manifest_path, ec);
+    if (ec) {
+        fs::remove(tmp, ec);
+        if (error) *error = "Cannot commit " + manifest_path;
+        return false;
+    }
+    return true;
+}
+
+// 清單路徑不得為絕對路徑或含 ".." (不可跳出套件目錄)
+static bool SafeRelative(const std::string& rel) {
+    fs::path p(rel);
+    if (p.is_absolute() || p.has_root_name() || p.has_root_directory()) return false;
+    for (const fs::path& part : p) {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
+bool PackageVerifier::Digest(const std::string& path, std::string& hex, bool& cached, uint64_t& hashed) const {
+    cached = false;
+    FileStamp before;
+    if (!ReadFileStamp(path, before)) return false;
+    if (cache_ && cache_->Lookup(path, before, hex)) {
+        cached = true;
+        return true;
+    }
+    if (!HashFileSha256(path, hex)) return false;
+    hashed += before.size;
+
+    // 計算期間檔案被改動則不寫入快取
+    FileStamp after;
+    if (cache_ && ReadFileStamp(path, after) && after == before) cache_->Store(path, before, hex);
+    return true;
+}
+
+// 依大小遞減分派 (大檔先算，避免最後只剩一個執行緒在算大檔)
+template <typename Work>
+static void RunParallel(const std::vector<uint64_t>& sizes, int threads, Work work) {
+    std::vector<size_t> order(sizes.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    if (threads <= 0) threads = (int)std::thread::hardware_concurrency();
+    if (threads <= 0) threads = 2;
+    if ((size_t)threads > order.size()) threads = (int)order.size();
+
+    std::atomic<size_t> cursor{ 0 };
+    auto worker = [&]() {
+        for (size_t w = cursor++; w < order.size(); w = cursor++) work(order[w]);
+    };
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+}
+
+bool PackageVerifier::Verify(const std::string& root, const std::vector<ExpectedHash>& expected,
+                             PackageVerifyReport& report) const {
+    report = PackageVerifyReport();
+    report.files.resize(expected.size());
+
+    std::vector<uint64_t> sizes(expected.size(), 0);
+    std::vector<std::string> full(expected.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        report.files[i].path = expected[i].path;
+        if (!SafeRelative(expected[i].path)) {
+            report.files[i].status = PACKAGE_FILE_UNSAFE;
+            continue;
+        }
+        full[i] = (fs::path(root) / fs::path(expected[i].path)).string();
+        FileStamp stamp;
+        if (!ReadFileStamp(full[i], stamp)) {
+            report.files[i].status = PACKAGE_FILE_MISSING;
+            continue;
+        }
+        sizes[i] = stamp.size;
+    }
+
+    std::atomic<uint64_t> hashed{ 0 };
+    std::atomic<size_t> hits{ 0 };
+    RunParallel(sizes, threads_, [&](size_t i) {
+        PackageFileResult& r = report.files[i];
+        if (r.status != PACKAGE_FILE_OK) return;
+        uint64_t bytes = 0;
+        if (!Digest(full[i], r.actual, r.cached, bytes)) {
+            r.status = PACKAGE_FILE_UNREADABLE;
+            return;
+        }
+        hashed += bytes;
+        hits += r.cached;
+        if (!Sha256HexEquals(r.actual, expected[i].sha256)) r.status = PACKAGE_FILE_MISMATCH;
+    });
+
+    for (const PackageFileResult& r : report.files) {
+        if (r.status != PACKAGE_FILE_OK) {
+            report.failed++;
+            AUDIT_LOG("VERIFY", "Package file failed (" + std::to_string(r.status) + "): " + r.path);
+        }
+    }
+    report.cache_hits = hits;
+    report.hashed_bytes = hashed;
+    AUDIT_LOG("VERIFY", "Verified " + std::to_string(expected.size()) + " files under " + root + ": " +
+              std::to_string(report.failed) + " failed, " + std::to_string(report.cache_hits) + " cached, " +
+              std::to_string(report.hashed_bytes) + " bytes hashed");
+    return report.Ok();
+}
+
+bool PackageVerifier::HashTree(const std::string& root, std::vector<ExpectedHash>& out, std::string* error) const {
+    out.clear();
+    std::error_code ec;
+    std::vector<std::string> paths;
+    std::vector<uint64_t> sizes;
+    for (auto it = fs::recursive_directory_iterator(root, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        std::error_code file_ec;
+        if (!it->is_regular_file(file_ec)) continue;
+        std::string rel = it->path().lexically_relative(root).generic_string();
+        if (rel == PACKAGE_MANIFEST_NAME) continue;
+        paths.push_back(rel);
+        sizes.push_back(it->file_size(file_ec));
+    }
+    if (ec) {
+        if (error) *error = "Cannot enumerate " + root + ": " + ec.message();
+        return false;
+    }
+
+    std::vector<std::string> hashes(paths.size());
+    std::vector<char> ok(paths.size(), 0);
+    RunParallel(sizes, threads_, [&](size_t i) {
+        bool cached = false;
+        uint64_t bytes = 0;
+        ok[i] = Digest((fs::path(root) / paths[i]).string(), hashes[i], cached, bytes);
+    });
+    for (size_t i = 0; i < paths.size(); i++) {
+        if (!ok[i]) {
+            if (error) *error = "Cannot read " + paths[i];
+            return false;
+        }
+        out.push_back(ExpectedHash{ paths[i], hashes[i] });
+    }
+    return true;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 驅動套件完整性驗證 + 持久化雜湊快取
+ * 功能: 安裝前以 SHA-256 核對套件檔案 (套件內 maidos.sha256 清單或 drivers.tsv 的 checksum)；
+ *       多執行緒並行、大區塊循序讀取；結果依 (路徑, 大小, 修改時間, 檔案ID) 快取，
+ *       未變動的檔案不再重新計算
+ *
+ * 清單格式同 sha256sum: 每行 "<64位十六進位>  <相對路徑>" (路徑前可有 '*')，'#' 開頭為註解
+ */
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define PACKAGE_MANIFEST_NAME "maidos.sha256"
+
+// 檔案身分: 任一欄位改變即視為內容可能改變
+struct FileStamp {
+    uint64_t size = 0;
+    int64_t mtime = 0;      // 平台原生時間單位
+    uint64_t file_id = 0;   // POSIX: dev ^ inode；Windows: 磁碟區序號 + 檔案索引
+
+    bool operator==(const FileStamp& o) const { return size == o.size && mtime == o.mtime && file_id == o.file_id; }
+};
+
+/**
+ * [MAIDOS-AUDIT] 讀取檔案身分
+ * @return false=檔案不存在或無法存取
+ */
+bool ReadFileStamp(const std::string& path, FileStamp& out);
+
+/**
+ * [MAIDOS-AUDIT] 以大區塊循序讀取計算檔案 SHA-256
+ * @param hex 輸出小寫十六進位摘要
+ * @return false=無法讀取
+ */
+bool HashFileSha256(const std::string& path, std::string& hex, std::string* error = nullptr);
+
+/**
+ * [MAIDOS-AUDIT] 持久化雜湊快取 (執行緒安全)
+ * 文字檔: 首行 "MAIDOS-HASHCACHE 1"，之後每行 size\tmtime\tfile_id\tsha256\t絕對路徑；暫存檔寫完後改名
+ */
+class HashCache {
+public:
+    HashCache() = default;
+    explicit HashCache(std::string path) : path_(std::move(path)) {}
+
+    // 載入 (檔案不存在視為空快取)；格式錯誤回傳 false 並清空
+    bool Load(std::string* error = nullptr);
+
+    // 有變更時寫回；未指定路徑時只存在記憶體
+    bool Save(std::string* error = nullptr);
+
+    // 路徑與身分都相符時輸出摘要
+    bool Lookup(const std::string& path, const FileStamp& stamp, std::string& hex) const;
+    void Store(const std::string& path, const FileStamp& stamp, const std::string& hex);
+
+    // 移除檔案已不存在或身分已變的項目，回傳移除數量
+    size_t Prune();
+
+    size_t Size() const;
+    const std::string& Path() const { return path_; }
+
+private:
+    struct Entry {
+        FileStamp stamp;
+        std::string hex;
+    };
+
+    std::string path_;
+    mutable std::mutex lock_;
+    std::unordered_map<std::string, Entry> entries_;
+    bool dirty_ = false;
+};
+
+// 預期摘要 (path 相對於套件根目錄)
+struct ExpectedHash {
+    std::string path;
+    std::string sha256;
+};
+
+/**
+ * [MAIDOS-AUDIT] 讀取 sha256sum 格式清單
+ * @return false=無法開啟或格式錯誤 (error 含行號)
+ */
+bool LoadSha256Manifest(const std::string& manifest_path, std::vector<ExpectedHash>& out, std::string* error = nullptr);
+
+// 寫出 sha256sum 格式清單 (依路徑排序)
+bool WriteSha256Manifest(const std::string& manifest_path, std::vector<ExpectedHash> entries, std::string* error = nullptr);
+
+enum PackageFileStatus : int {
+    PACKAGE_FILE_OK         = 0,
+    PACKAGE_FILE_MISMATCH   = 1,
+    PACKAGE_FILE_MISSING    = 2,
+    PACKAGE_FILE_UNREADABLE = 3,
+    PACKAGE_FILE_UNSAFE     = 4,   // 路徑跳出套件目錄或為絕對路徑
+};
+
+struct PackageFileResult {
+    std::string path;
+    std::string actual;   // 實際摘要 (無法計算為空)
+    int status = PACKAGE_FILE_OK;
+    bool cached = false;  // 摘要來自快取
+};
+
+struct PackageVerifyReport {
+    std::vector<PackageFileResult> files;   // 與輸入順序一致
+    size_t failed = 0;
+    size_t cache_hits = 0;
+    uint64_t hashed_bytes = 0;              // 實際讀取計算的位元組
+
+    bool Ok() const { return failed == 0; }
+};
+
+class PackageVerifier {
+public:
+    /**
+     * @param cache 雜湊快取 (可為 nullptr；呼叫端負責 Save)
+     * @param threads 並行數 (<=0 使用 CPU 核心數)
+     */
+    explicit PackageVerifier(HashCache* cache = nullptr, int threads = 0) : cache_(cache), threads_(threads) {}
+
+    /**
+     * [MAIDOS-AUDIT] 核對 root 下的檔案
+     * @return true=全部相符
+     */
+    bool Verify(const std::string& root, const std::vector<ExpectedHash>& expected, PackageVerifyReport& report) const;
+
+    /**
+     * [MAIDOS-AUDIT] 計算 root 下全部檔案的摘要 (產生清單用，略過清單檔本身)
+     * @return false=無法列舉
+     */
+    bool HashTree(const std::string& root, std::vector<ExpectedHash>& out, std::string* error = nullptr) const;
+
+private:
+    // 先查快取，未命中才計算並寫回快取
+    bool Digest(const std::string& path, std::string& hex, bool& cached, uint64_t& hashed) const;
+
+    HashCache* cache_;
+    int threads_;
+};
@@ -0,0 +1,173 @@
+#pragma warning(disable: 4819)
+#include "resource_conflicts.h"
+#include "logger.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+void IntervalTree::Build(std::vector<Interval> intervals) {
+    items_ = std::move(intervals);
+    std::sort(items_.begin(), items_.end(), [](const Interval& a, const Interval& b) {
+        return a.start != b.start ? a.start < b.start : a.id < b.id;
+    });
+    max_end_.assign(items_.size(), 0);
+    Fill(0, items_.size());
+}
+
+uint64_t IntervalTree::Fill(size_t lo, size_t hi) {
+    if (lo >= hi) return 0;
+    size_t mid = lo + (hi - lo) / 2;
+    uint64_t max_end = items_[mid].end;
+    max_end = std::max(max_end, Fill(lo, mid));
+    max_end = std::max(max_end, Fill(mid + 1, hi));
+    max_end_[mid] = max_end;
+    return max_end;
+}
+
+void ResourceMap::Build(const DiagnosticsReport& report) {
+    report_ = &report;
+    entries_.clear();
+
+    std::vector<IntervalTree::Interval> by_type[DEVICE_RESOURCE_DMA + 1];
+    for (size_t row = 0; row < report.nodes.size(); row++) {
+        const std::vector<DeviceResource>& resources = report.nodes[row].resources;
+        for (size_t r = 0; r < resources.size(); r++) {
+            const DeviceResource& res = resources[r];
+            if (res.type < DEVICE_RESOURCE_IRQ || res.type > DEVICE_RESOURCE_DMA || res.end < res.start) continue;
+            by_type[res.type].push_back(IntervalTree::Interval{ res.start, res.end, (uint32_t)entries_.size() });
+            entries_.push_back(Entry{ (int32_t)row, (uint32_t)r, res.flags });
+        }
+    }
+    for (uint32_t type = DEVICE_RESOURCE_IRQ; type <= DEVICE_RESOURCE_DMA; type++) {
+        trees_[type].Build(std::move(by_type[type]));
+    }
+}
+
+bool ResourceMap::Related(int32_t a, int32_t b) const {
+    const std::vector<DeviceDiagnosis>& d = report_->diagnoses;
+    size_t limit = d.size();
+    size_t steps = 0;
+    for (int32_t p = d[a].parent; p >= 0 && steps < limit; p = d[p].parent, steps++) {
+        if (p == b) return true;
+    }
+    steps = 0;
+    for (int32_t p = d[b].parent; p >= 0 && steps < limit; p = d[p].parent, steps++) {
+        if (p == a) return true;
+    }
+    return false;
+}
+
+size_t ResourceMap::FindOverlaps(std::vector<ResourceOverlap>& out) const {
+    out.clear();
+    if (!report_) return 0;
+
+    size_t conflicts = 0;
+    for (uint32_t type = DEVICE_RESOURCE_IRQ; type <= DEVICE_RESOURCE_DMA; type++) {
+        const IntervalTree& tree = trees_[type];
+        for (size_t i = 0; i < tree.Size(); i++) {
+            const IntervalTree::Interval& a = tree.At(i);
+            const Entry& ea = entries_[a.id];
+            // 每對只回報一次: 只看排序位置在 a 之後的區間
+            tree.Query(a.start, a.end, [&](const IntervalTree::Interval& b) {
+                if ((size_t)(&b - &tree.At(0)) <= i) return;
+                const Entry& eb = entries_[b.id];
+                if (ea.device == eb.device || Related(ea.device, eb.device)) return;
+
+                bool first = ea.device < eb.device;
+                ResourceOverlap o;
+                o.type = type;
+                o.device_a = first ? ea.device : eb.device;
+                o.device_b = first ? eb.device : ea.device;
+                o.resource_a = first ? ea.resource : eb.resource;
+                o.resource_b = first ? eb.resource : ea.resource;
+                o.start = std::max(a.start, b.start);
+                o.end = std::min(a.end, b.end);
+                o.conflict = !((ea.flags & DEVICE_RESOURCE_SHARED) && (eb.flags & DEVICE_RESOURCE_SHARED));
+                conflicts += o.conflict;
+                out.push_back(o);
+            });
+        }
+    }
+
+    std::sort(out.begin(), out.end(), [](const ResourceOverlap& x, const ResourceOverlap& y) {
+        if (x.type != y.type) return x.type < y.type;
+        if (x.start != y.start) return x.start < y.start;
+        if (x.device_a != y.device_a) return x.device_a < y.device_a;
+        if (x.device_b != y.device_b) return x.device_b < y.device_b;
+        return x.resource_a != y.resource_a ? x.resource_a < y.resource_a : x.resource_b < y.resource_b;
+    });
+    AUDIT_LOG("RESOURCE", "Found " + std::to_string(out.size()) + " overlaps, " + std::to_string(conflicts) +
+              " conflicts among " + std::to_string(entries_.size()) + " resources");
+    return conflicts;
+}
+
+std::vector<ResourceOwner> ResourceMap::Owners(uint32_t type, uint64_t start, uint64_t end) const {
+    std::vector<ResourceOwner> out;
+    if (type < DEVICE_RESOURCE_IRQ || type > DEVICE_RESOURCE_DMA) return out;
+    trees_[type].Query(start, end, [&](const IntervalTree::Interval& it) {
+        out.push_back(ResourceOwner{ entries_[it.id].device, entries_[it.id].resource });
+    });
+    return out;
+}
+
+size_t ResourceMap::Count(uint32_t type) const {
+    return type >= DEVICE_RESOURCE_IRQ && type <= DEVICE_RESOURCE_DMA ? trees_[type].Size() : 0;
+}
+
+size_t EncodeConflictBlob(const DiagnosticsReport& report, const std::vector<ResourceOverlap>& overlaps,
+                          uint8_t* buffer, size_t capacity, size_t* needed) {
+    // 實例ID去重: 列號 -> 字串表位置
+    std::unordered_map<int32_t, ScanBlobString> strings;
+    std::vector<int32_t> order;
+    uint32_t strings_size = 0;
+    uint32_t conflicts = 0;
+    auto add = [&](int32_t row) {
+        if (strings.count(row)) return;
+        uint32_t length = (uint32_t)report.nodes[row].instance_id.size();
+        strings.emplace(row, ScanBlobString{ strings_size, length });
+        order.push_back(row);
+        strings_size += length + 1;
+    };
+    for (const ResourceOverlap& o : overlaps) {
+        add(o.device_a);
+        add(o.device_b);
+        conflicts += o.conflict;
+    }
+
+    ConflictBlobHeader header{};
+    header.magic = CONFLICT_BLOB_MAGIC;
+    header.version = CONFLICT_BLOB_VERSION;
+    header.record_size = (uint16_t)sizeof(ConflictBlobRecord);
+    header.count = (uint32_t)overlaps.size();
+    header.conflicts = conflicts;
+    header.records_offset = (uint32_t)sizeof(ConflictBlobHeader);
+    header.strings_offset = (uint32_t)(sizeof(ConflictBlobHeader) + overlaps.size() * sizeof(ConflictBlobRecord));
+    header.strings_size = strings_size;
+
+    size_t total = (size_t)header.strings_offset + strings_size;
+    if (needed) *needed = total;
+    if (!buffer || capacity < total) return 0;
+
+    memcpy(buffer, &header, sizeof(header));
+    for (size_t i = 0; i < overlaps.size(); i++) {
+        const ResourceOverlap& o = overlaps[i];
+        ConflictBlobRecord r{};
+        r.device_a = strings[o.device_a];
+        r.device_b = strings[o.device_b];
+        r.type = o.type;
+        r.flags = o.conflict ? CONFLICT_FLAG_CONFLICT : 0;
+        r.start = o.start;
+        r.end = o.end;
+        memcpy(buffer + header.records_offset + i * sizeof(ConflictBlobRecord), &r, sizeof(r));
+    }
+    char* out = (char*)buffer + header.strings_offset;
+    for (int32_t row : order) {
+        const std::string& id = report.nodes[row].instance_id;
+        memcpy(out, id.data(), id.size());
+        out[id.size()] = '\0';
+        out += id.size() + 1;
+    }
+    return total;
+}
@@ -0,0 +1,155 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 硬體資源衝突分析
+ * 功能: 把全部設備的已配置資源 (IRQ/記憶體/IO/DMA) 依類型放進區間樹，
+ *       整機重疊/衝突在 O(n log n + k) 內找出 (k = 重疊數)；不依賴平台，輸入為 DeviceNode
+ *
+ * 判定: 同一設備自身的資源不算；祖先/後代 (例如 PCI 橋的轉送視窗與其下游設備) 不算；
+ *       雙方皆可共用 (共用 IRQ/MSI) 為重疊但非衝突；其餘重疊皆為衝突
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "device_diagnostics.h"
+
+/**
+ * [MAIDOS-AUDIT] 靜態區間樹 (排序陣列 + 隱式平衡樹，節點存子樹最大端點)
+ * 區間為含端點的 [start, end]
+ */
+class IntervalTree {
+public:
+    struct Interval {
+        uint64_t start;
+        uint64_t end;
+        uint32_t id;
+    };
+
+    // 建樹 O(n log n)；會依 start 排序
+    void Build(std::vector<Interval> intervals);
+
+    // 走訪所有與 [start, end] 重疊的區間 (依 start 遞增)，O(log n + k)
+    template <typename Visit>
+    void Query(uint64_t start, uint64_t end, Visit&& visit) const {
+        Query(0, items_.size(), start, end, visit);
+    }
+
+    size_t Size() const { return items_.size(); }
+    const Interval& At(size_t i) const { return items_[i]; }
+
+private:
+    uint64_t Fill(size_t lo, size_t hi);
+
+    template <typename Visit>
+    void Query(size_t lo, size_t hi, uint64_t start, uint64_t end, Visit& visit) const {
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (max_end_[mid] < start) return;
+            Query(lo, mid, start, end, visit);
+            const Interval& it = items_[mid];
+            if (it.start > end) return;  // 右子樹起點都更大
+            if (it.end >= start) visit(it);
+            lo = mid + 1;
+        }
+    }
+
+    std::vector<Interval> items_;
+    std::vector<uint64_t> max_end_;  // 以 mid 為根的子樹最大 end
+};
+
+// 一組重疊
+struct ResourceOverlap {
+    uint32_t type = 0;        // DeviceResourceType
+    int32_t device_a = -1;    // 列號 (DiagnosticsReport::nodes)
+    int32_t device_b = -1;
+    uint32_t resource_a = 0;  // 該設備 resources 中的索引
+    uint32_t resource_b = 0;
+    uint64_t start = 0;       // 交集
+    uint64_t end = 0;
+    bool conflict = false;    // false=雙方皆可共用
+};
+
+// 占用指定範圍的設備資源
+struct ResourceOwner {
+    int32_t device = -1;
+    uint32_t resource = 0;
+};
+
+class ResourceMap {
+public:
+    /**
+     * [MAIDOS-AUDIT] 由診斷結果建立各類型的區間樹 (沿用其父節點列號判斷祖先關係)
+     * report 須在 ResourceMap 使用期間保持有效
+     */
+    void Build(const DiagnosticsReport& report);
+
+    /**
+     * [MAIDOS-AUDIT] 整機重疊分析
+     * @param out 依 (類型, 交集起點) 排序
+     * @return 衝突數量 (不含可共用的重疊)
+     */
+    size_t FindOverlaps(std::vector<ResourceOverlap>& out) const;
+
+    // 查詢占用 [start, end] 的設備資源
+    std::vector<ResourceOwner> Owners(uint32_t type, uint64_t start, uint64_t end) const;
+
+    // 指定類型的資源數量
+    size_t Count(uint32_t type) const;
+
+private:
+    // 祖先/後代關係 (沿父節點最多走 nodes 數步)
+    bool Related(int32_t a, int32_t b) const;
+
+    struct Entry {
+        int32_t device;
+        uint32_t resource;
+        uint32_t flags;
+    };
+
+    const DiagnosticsReport* report_ = nullptr;
+    IntervalTree trees_[DEVICE_RESOURCE_DMA + 1];
+    std::vector<Entry> entries_;  // IntervalTree::Interval::id 的對應
+};
+
+#define CONFLICT_BLOB_MAGIC   0x4352444Du   // "MDRC"
+#define CONFLICT_BLOB_VERSION 1
+
+// ConflictBlobRecord::flags
+#define CONFLICT_FLAG_CONFLICT 0x1   // 未設定 = 雙方可共用的重疊
+
+#pragma pack(push, 4)
+struct ConflictBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;     // sizeof(ConflictBlobRecord)
+    uint32_t count;
+    uint32_t conflicts;       // 其中 CONFLICT_FLAG_CONFLICT 的數量
+    uint32_t records_offset;  // 相對區塊起點
+    uint32_t strings_offset;
+    uint32_t strings_size;
+    uint32_t reserved;
+};
+
+struct ConflictBlobRecord {
+    ScanBlobString device_a;  // 實例ID
+    ScanBlobString device_b;
+    uint32_t type;            // DeviceResourceType
+    uint32_t flags;
+    uint64_t start;           // 交集
+    uint64_t end;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ConflictBlobHeader) == 32, "ConflictBlobHeader layout");
+static_assert(sizeof(ConflictBlobRecord) == 40, "ConflictBlobRecord layout");
+
+/**
+ * [MAIDOS-AUDIT] 將重疊清單編碼到 buffer (實例ID去重存入字串表，以 NUL 結尾)
+ * @param capacity buffer 大小；不足時不寫入任何資料
+ * @param needed 輸出所需大小 (可為 nullptr)
+ * @return 寫入的位元組數；緩衝區不足 (或 buffer 為 nullptr) 回傳 0
+ */
+size_t EncodeConflictBlob(const DiagnosticsReport& report, const std::vector<ResourceOverlap>& overlaps,
+                          uint8_t* buffer, size_t capacity, size_t* needed);
@@ -0,0 +1,130 @@
+#pragma warning(disable: 4819)
+#include "scan_blob.h"
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+// 多字串項目數 (空字串為 0 項)
+uint32_t CountItems(std::string_view multi) {
+    if (multi.empty()) return 0;
+    uint32_t count = 1;
+    for (char c : multi) count += c == '\0';
+    return count;
+}
+
+// 去重字串表 (先計算佈局，再一次寫入)
+class StringTable {
+public:
+    ScanBlobString Add(std::string_view s) {
+        auto it = offsets_.find(s);
+        if (it != offsets_.end()) return ScanBlobString{ it->second, (uint32_t)s.size() };
+        uint32_t offset = (uint32_t)size_;
+        offsets_.emplace(s, offset);
+        order_.push_back(s);
+        size_ += s.size() + 1;
+        return ScanBlobString{ offset, (uint32_t)s.size() };
+    }
+
+    size_t Size() const { return size_; }
+
+    void Write(char* out) const {
+        for (std::string_view s : order_) {
+            memcpy(out, s.data(), s.size());
+            out[s.size()] = '\0';
+            out += s.size() + 1;
+        }
+    }
+
+private:
+    std::unordered_map<std::string_view, uint32_t> offsets_;  // 指向清單字串池，編碼期間有效
+    std::vector<std::string_view> order_;
+    size_t size_ = 0;
+};
+
+}  // namespace
+
+size_t EncodeScanBlob(const DeviceInventory& inventory, uint8_t* buffer, size_t capacity, size_t* needed) {
+    const size_t count = inventory.Size();
+    std::vector<ScanBlobRecord> records(count);
+    StringTable strings;
+
+    for (size_t row = 0; row < count; row++) {
+        ScanBlobRecord& r = records[row];
+        std::string_view hardware = inventory.HardwareIdsRaw(row);
+        std::string_view compatible = inventory.CompatibleIdsRaw(row);
+        r.instance_id = strings.Add(inventory.InstanceId(row));
+        r.name = strings.Add(inventory.Name(row));
+        r.manufacturer = strings.Add(inventory.Manufacturer(row));
+        r.driver_version = strings.Add(inventory.DriverVersion(row));
+        r.hardware_ids = strings.Add(hardware);
+        r.compatible_ids = strings.Add(compatible);
+        r.status = inventory.Status(row);
+        r.problem_code = inventory.ProblemCode(row);
+        r.hardware_id_count = CountItems(hardware);
+        r.compatible_id_count = CountItems(compatible);
+    }
+
+    ScanBlobHeader header{};
+    header.magic = SCAN_BLOB_MAGIC;
+    header.version = SCAN_BLOB_VERSION;
+    header.record_size = (uint16_t)sizeof(ScanBlobRecord);
+    header.count = (uint32_t)count;
+    header.records_offset = (uint32_t)sizeof(ScanBlobHeader);
+    header.strings_offset = (uint32_t)(sizeof(ScanBlobHeader) + count * sizeof(ScanBlobRecord));
+    header.strings_size = (uint32_t)strings.Size();
+    header.generation = inventory.Generation();
+
+    size_t total = header.strings_offset + strings.Size();
+    if (needed) *needed = total;
+    if (!buffer || capacity < total) return 0;
+
+    memcpy(buffer, &header, sizeof(header));
+    if (count) memcpy(buffer + header.records_offset, records.data(), count * sizeof(ScanBlobRecord));
+    strings.Write((char*)buffer + header.strings_offset);
+    return total;
+}
+
+bool ScanBlobView::Open(const uint8_t* data, size_t size) {
+    if (!data || size < sizeof(ScanBlobHeader)) return false;
+    memcpy(&header_, data, sizeof(header_));
+    if (header_.magic != SCAN_BLOB_MAGIC || header_.version != SCAN_BLOB_VERSION) return false;
+    if (header_.record_size != sizeof(ScanBlobRecord) || header_.records_offset < sizeof(ScanBlobHeader)) return false;
+    if (header_.records_offset % 4 != 0) return false;
+
+    uint64_t records_end = (uint64_t)header_.records_offset + (uint64_t)header_.count * sizeof(ScanBlobRecord);
+    uint64_t strings_end = (uint64_t)header_.strings_offset + header_.strings_size;
+    if (records_end > header_.strings_offset || strings_end > size) return false;
+
+    records_ = (const ScanBlobRecord*)(data + header_.records_offset);
+    strings_ = (const char*)data + header_.strings_offset;
+
+    // 每個字串須在字串表內且以 NUL 結尾 (消費端可直接當 C 字串用)
+    auto valid = [&](ScanBlobString s) {
+        return (uint64_t)s.offset + s.length < header_.strings_size && strings_[s.offset + s.length] == '\0';
+    };
+    for (uint32_t i = 0; i < header_.count; i++) {
+        const ScanBlobRecord& r = records_[i];
+        if (!valid(r.instance_id) || !valid(r.name) || !valid(r.manufacturer) || !valid(r.driver_version) ||
+            !valid(r.hardware_ids) || !valid(r.compatible_ids)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string_view> ScanBlobView::Multi(ScanBlobString s) const {
+    std::vector<std::string_view> out;
+    if (s.length == 0) return out;
+    std::string_view all = String(s);
+    size_t start = 0;
+    while (true) {
+        size_t end = all.find('\0', start);
+        out.push_back(all.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start));
+        if (end == std::string_view::npos) break;
+        start = end + 1;
+    }
+    return out;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 設備掃描結果的精簡 FFI 編碼
+ * 功能: 取代每筆約 1.7 KB、固定 char[512] 且會截斷的 NativeDeviceInfo；
+ *       輸出到呼叫端緩衝區的單一區塊 = 標頭 + 固定寬度記錄 + 去重字串表，
+ *       支援兩段式呼叫 (先取所需大小)，並完整保留多字串硬體ID/相容ID
+ *
+ * 佈局 (小端序，4 位元組對齊):
+ *   ScanBlobHeader                       32 位元組
+ *   ScanBlobRecord[count]                每筆 64 位元組
+ *   字串表                                每個字串以 NUL 結尾；多字串為 項目\0項目\0...\0
+ * 字串以 (offset, length) 指向字串表，length 不含結尾 NUL；相同字串只存一次
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "device_inventory.h"
+
+#define SCAN_BLOB_MAGIC   0x4353444Du   // "MDSC"
+#define SCAN_BLOB_VERSION 1
+
+#pragma pack(push, 4)
+struct ScanBlobString {
+    uint32_t offset;   // 相對字串表起點
+    uint32_t length;   // 位元組數 (不含結尾 NUL)
+};
+
+struct ScanBlobHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;     // sizeof(ScanBlobRecord)；新版本只會在尾端加欄位
+    uint32_t count;
+    uint32_t records_offset;  // 相對區塊起點
+    uint32_t strings_offset;
+    uint32_t strings_size;
+    uint64_t generation;      // 清單快照世代
+};
+
+struct ScanBlobRecord {
+    ScanBlobString instance_id;
+    ScanBlobString name;
+    ScanBlobString manufacturer;
+    ScanBlobString driver_version;
+    ScanBlobString hardware_ids;     // 多字串
+    ScanBlobString compatible_ids;   // 多字串
+    uint32_t status;                 // DeviceStatusFlags
+    uint32_t problem_code;
+    uint32_t hardware_id_count;
+    uint32_t compatible_id_count;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(ScanBlobHeader) == 32, "ScanBlobHeader layout");
+static_assert(sizeof(ScanBlobRecord) == 64, "ScanBlobRecord layout");
+
+/**
+ * [MAIDOS-AUDIT] 將清單編碼到 buffer
+ * @param capacity buffer 大小；不足時不寫入任何資料
+ * @param needed 輸出所需大小 (可為 nullptr)
+ * @return 寫入的位元組數；緩衝區不足 (或 buffer 為 nullptr) 回傳 0
+ */
+size_t EncodeScanBlob(const DeviceInventory& inventory, uint8_t* buffer, size_t capacity, size_t* needed);
+
+/**
+ * [MAIDOS-AUDIT] 唯讀檢視 (驗證後直接指向緩衝區，不複製)
+ */
+class ScanBlobView {
+public:
+    /**
+     * 驗證標頭、記錄與所有字串範圍
+     * @return false=格式錯誤或被截斷
+     */
+    bool Open(const uint8_t* data, size_t size);
+
+    uint32_t Count() const { return header_.count; }
+    uint64_t Generation() const { return header_.generation; }
+    const ScanBlobRecord& Record(size_t i) const { return records_[i]; }
+
+    std::string_view String(ScanBlobString s) const { return std::string_view(strings_ + s.offset, s.length); }
+
+    // 多字串拆成項目
+    std::vector<std::string_view> Multi(ScanBlobString s) const;
+
+private:
+    ScanBlobHeader header_{};
+    const ScanBlobRecord* records_ = nullptr;
+    const char* strings_ = nullptr;
+};
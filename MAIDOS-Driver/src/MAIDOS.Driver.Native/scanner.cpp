@@ -1,19 +1,21 @@
 #pragma warning(disable: 4819)
 #include <windows.h>
-#include <setupapi.h>
-#include <devguid.h>
-#include <cfgmgr32.h>
-#include <vector>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <cstdio>
 #include "logger.h"
-
-#pragma comment(lib, "setupapi.lib")
-#pragma comment(lib, "cfgmgr32.lib")
+#include "device_inventory.h"
+#include "scan_blob.h"
+#include "inventory_store.h"
+#include "fleet_matcher.h"
 
 // [MAIDOS-AUDIT] Entry: Hardware Enumeration (Universal Secure)
 // 符合憲法第 3 條：全流程日誌審計
 
+// commit_device_inventory 在清單儲存中的游標名稱
+#define SCAN_COMMIT_CURSOR "scan-commit"
+
 struct NativeDeviceInfo {
     char id[512];
     char name[512];
@@ -22,61 +24,155 @@ struct NativeDeviceInfo {
     char status[64];
 };
 
-void GetDeviceProperty(HDEVINFO hDevInfo, PSP_DEVINFO_DATA pDevInfoData, DWORD Property, char* buffer, DWORD bufferSize) {
-    DWORD dataType;
-    DWORD requiredSize = 0;
-    SetupDiGetDeviceRegistryPropertyA(hDevInfo, pDevInfoData, Property, &dataType, NULL, 0, &requiredSize);
-    if (requiredSize > 0) {
-        std::vector<char> tempBuffer(requiredSize);
-        if (SetupDiGetDeviceRegistryPropertyA(hDevInfo, pDevInfoData, Property, &dataType, (PBYTE)tempBuffer.data(), requiredSize, NULL)) {
-            strncpy_s(buffer, bufferSize, tempBuffer.data(), _TRUNCATE);
-            return;
-        }
-    }
-    strncpy_s(buffer, bufferSize, "Unknown", _TRUNCATE);
+static void CopyField(char* dst, size_t size, std::string_view src, const char* fallback) {
+    if (src.empty()) src = fallback;
+    strncpy_s(dst, size, src.data(), src.size() < size ? src.size() : size - 1);
 }
 
 extern "C" {
     __declspec(dllexport) int scan_hardware_native(NativeDeviceInfo* buffer, int maxCount) {
         AUDIT_ENTRY(scan_hardware_native);
-        SP_DEVINFO_DATA devInfoData;
-        devInfoData.cbSize = sizeof(SP_DEVINFO_DATA);
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        DeviceInventory& inventory = SharedDeviceInventory();
 
-        HDEVINFO hDevInfo = SetupDiClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
-        if (hDevInfo == INVALID_HANDLE_VALUE) {
+        // [MAIDOS-AUDIT] 首次全量快照，之後只重讀變更的設備
+        if (!inventory.Refresh()) {
             AUDIT_LOG("SCAN", "Failed to get device list.");
             return -1;
         }
 
         int count = 0;
-        for (DWORD i = 0; SetupDiEnumDeviceInfo(hDevInfo, i, &devInfoData) && count < maxCount; i++) {
-            GetDeviceProperty(hDevInfo, &devInfoData, SPDRP_FRIENDLYNAME, buffer[count].name, 512);
-            if (strcmp(buffer[count].name, "Unknown") == 0) {
-                GetDeviceProperty(hDevInfo, &devInfoData, SPDRP_DEVICEDESC, buffer[count].name, 512);
-            }
-            GetDeviceProperty(hDevInfo, &devInfoData, SPDRP_HARDWAREID, buffer[count].id, 512);
-            GetDeviceProperty(hDevInfo, &devInfoData, SPDRP_MFG, buffer[count].vendor, 512);
-            
-            // [MAIDOS-AUDIT] 獲取真實版本與狀態邏輯
-            GetDeviceProperty(hDevInfo, &devInfoData, SPDRP_DRIVER, buffer[count].version, 64);
-            
-            DWORD status, problem;
-            if (CM_Get_DevNode_Status(&status, &problem, devInfoData.DevInst, 0) == CR_SUCCESS) {
-                if (status & DN_HAS_PROBLEM) {
-                    sprintf_s(buffer[count].status, 64, "Error(Code %d)", problem);
-                } else {
-                    strncpy_s(buffer[count].status, 64, "Running", _TRUNCATE);
-                }
+        for (size_t row = 0; row < inventory.Size() && count < maxCount; row++) {
+            NativeDeviceInfo& info = buffer[count];
+            CopyField(info.name, 512, inventory.Name(row), "Unknown");
+            CopyField(info.id, 512, inventory.PrimaryHardwareId(row), "Unknown");
+            CopyField(info.vendor, 512, inventory.Manufacturer(row), "Unknown");
+            CopyField(info.version, 64, inventory.DriverVersion(row), "Unknown");
+
+            if (inventory.Status(row) & DEVICE_STATUS_HAS_PROBLEM) {
+                sprintf_s(info.status, 64, "Error(Code %u)", inventory.ProblemCode(row));
             } else {
-                strncpy_s(buffer[count].status, 64, "Unknown", _TRUNCATE);
+                strncpy_s(info.status, 64, "Running", _TRUNCATE);
             }
-            
             count++;
         }
 
         AUDIT_LOG("SCAN", "Successfully scanned " + std::to_string(count) + " devices.");
-        SetupDiDestroyDeviceInfoList(hDevInfo);
         AUDIT_EXIT(scan_hardware_native);
         return count;
     }
+
+    /**
+     * [MAIDOS-AUDIT] 增量刷新設備清單
+     * @param added/removed/changed 差異數量輸出 (可為 NULL)
+     * @return 快照世代, -1=列舉失敗
+     */
+    __declspec(dllexport) long long refresh_device_inventory(int* added, int* removed, int* changed) {
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        InventoryDiff diff;
+        if (!SharedDeviceInventory().Refresh(&diff)) return -1;
+
+        if (added) *added = (int)diff.added.size();
+        if (removed) *removed = (int)diff.removed.size();
+        if (changed) *changed = (int)diff.changed.size();
+        return (long long)SharedDeviceInventory().Generation();
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 刷新清單並提交到持久化儲存 (跨開機的變更日誌)
+     * 計數以本功能自己的游標讀取日誌 (不受 check_changed_updates 等其他消費者影響)，回報後才推進游標
+     * @param store_dir 儲存目錄
+     * @param added/removed/changed 自上次呼叫以來的日誌紀錄數量輸出 (changed 含驅動/問題碼/屬性變更，可為 NULL)；
+     *        游標之後的日誌已被壓縮時，全部設備計為新增
+     * @return 日誌最後序號, -1=列舉或寫入失敗
+     */
+    __declspec(dllexport) long long commit_device_inventory(const char* store_dir, int* added, int* removed, int* changed) {
+        if (!store_dir) return -1;
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        DeviceInventory& inventory = SharedDeviceInventory();
+        if (!inventory.Refresh()) return -1;
+
+        std::string error;
+        InventoryStore* store = SharedInventoryStore(store_dir, &error);
+        if (!store || !store->Commit(inventory, nullptr, &error)) {
+            AUDIT_LOG("SCAN", "Inventory store failed: " + error);
+            return -1;
+        }
+
+        uint64_t cursor = store->LoadCursor(SCAN_COMMIT_CURSOR);
+        uint64_t through = store->Sequence();
+        int counts[3] = { 0, 0, 0 };
+        std::vector<InventoryChange> changes;
+        if (cursor < store->JournalStart()) {
+            counts[0] = (int)store->Size();
+        } else if (!store->ReadChanges(cursor, changes, &error)) {
+            AUDIT_LOG("SCAN", "Inventory journal read failed: " + error);
+            return -1;
+        }
+        for (const InventoryChange& c : changes) {
+            counts[c.kind == INVENTORY_CHANGE_ADDED ? 0 : c.kind == INVENTORY_CHANGE_REMOVED ? 1 : 2]++;
+        }
+        if (added) *added = counts[0];
+        if (removed) *removed = counts[1];
+        if (changed) *changed = counts[2];
+
+        if (!store->SaveCursor(SCAN_COMMIT_CURSOR, through, &error)) {
+            AUDIT_LOG("SCAN", "Cannot save inventory cursor: " + error);
+        }
+        return (long long)through;
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 精簡掃描: 將完整清單編碼成 scan_blob.h 格式寫入呼叫端緩衝區
+     * 兩段式呼叫: 先以 buffer=NULL 取得 needed_size，配置後再呼叫；
+     * 兩次呼叫之間清單可能增長，回傳 -2 時依新的 needed_size 重試
+     * @param needed_size 輸出所需位元組數 (可為 NULL)
+     * @return 設備數量, -1=列舉失敗, -2=緩衝區不足
+     */
+    __declspec(dllexport) int scan_devices_compact(unsigned char* buffer, int buffer_size, int* needed_size) {
+        AUDIT_ENTRY(scan_devices_compact);
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        DeviceInventory& inventory = SharedDeviceInventory();
+        if (!inventory.Refresh()) {
+            AUDIT_LOG("SCAN", "Failed to get device list.");
+            return -1;
+        }
+
+        size_t needed = 0;
+        size_t written = EncodeScanBlob(inventory, buffer, buffer_size > 0 ? (size_t)buffer_size : 0, &needed);
+        if (needed_size) *needed_size = (int)needed;
+        if (written == 0) return -2;
+
+        AUDIT_LOG("SCAN", "Encoded " + std::to_string(inventory.Size()) + " devices in " + std::to_string(written) + " bytes.");
+        AUDIT_EXIT(scan_devices_compact);
+        return (int)inventory.Size();
+    }
+
+    /**
+     * [MAIDOS-AUDIT] 將精簡掃描結果匯出成清單檔 (供集中端 match_fleet_inventories 批次比對)
+     * @param path 輸出路徑 (建議副檔名 .mdscan)
+     * @return 設備數量, -1=列舉或寫入失敗
+     */
+    __declspec(dllexport) int export_device_inventory(const char* path) {
+        AUDIT_ENTRY(export_device_inventory);
+        if (!path) return -1;
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        DeviceInventory& inventory = SharedDeviceInventory();
+        if (!inventory.Refresh()) {
+            AUDIT_LOG("SCAN", "Failed to get device list.");
+            return -1;
+        }
+
+        size_t needed = 0;
+        EncodeScanBlob(inventory, nullptr, 0, &needed);
+        std::vector<uint8_t> blob(needed);
+        std::string error;
+        if (EncodeScanBlob(inventory, blob.data(), blob.size(), nullptr) == 0 ||
+            !WriteInventoryFile(path, blob.data(), blob.size(), &error)) {
+            AUDIT_LOG("SCAN", "Inventory export failed: " + error);
+            return -1;
+        }
+        AUDIT_EXIT(export_device_inventory);
+        return (int)inventory.Size();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] SHA-256 (FIPS 180-4) 串流雜湊
+ * 可分段餵入資料，不需整個檔案在記憶體中
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Sha256 {
+public:
+    Sha256() { Reset(); }
+
+    void Reset();
+    void Update(const void* data, size_t len);
+
+    // 結束並回傳 32 位元組摘要 (之後須 Reset 才能再用)
+    void Final(uint8_t digest[32]);
+
+    // 結束並回傳小寫十六進位字串
+    std::string FinalHex();
+
+    // 已餵入的位元組數
+    uint64_t Length() const { return length_; }
+
+private:
+    void Block(const uint8_t* p);
+
+    uint32_t state_[8];
+    uint8_t buffer_[64];
+    size_t buffered_;
+    uint64_t length_;
+};
+
+// 十六進位摘要比較 (忽略大小寫)；expected 不是 64 位十六進位字串時回傳 false
+bool Sha256HexEquals(const std::string& actual, const std::string& expected);
+
+// 是否為 64 位十六進位字串 (drivers.tsv 的 VERIFY_ON_DOWNLOAD 等佔位值不算)
+bool IsSha256Hex(const std::string& value);
@@ -0,0 +1,92 @@
+#pragma warning(disable: 4819)
+#include "update_check.h"
+#include "driver_version.h"
+#include "logger.h"
+
+#include <cstring>
+
+static void CopyField(char* dst, size_t size, const std::string& src) {
+    size_t n = src.size() < size - 1 ? src.size() : size - 1;
+    memcpy(dst, src.data(), n);
+    dst[n] = '\0';
+}
+
+bool BatchUpdateChecker::Refresh() {
+    index_.clear();
+    if (!provider_.Enumerate(devices_)) {
+        devices_.clear();
+        AUDIT_LOG("UPDATE", "Device enumeration failed.");
+        return false;
+    }
+
+    index_.reserve(devices_.size());
+    for (size_t i = 0; i < devices_.size(); i++) {
+        index_.emplace(devices_[i].instance_id, i);
+    }
+    return true;
+}
+
+const DeviceRecord* BatchUpdateChecker::Find(const std::string& instance_id) const {
+    auto it = index_.find(instance_id);
+    return it == index_.end() ? nullptr : &devices_[it->second];
+}
+
+void BatchUpdateChecker::Fill(const char* device_id, const DeviceRecord* device, const LatestVersionLookup& latest,
+                              UpdateResult* result) {
+    memset(result, 0, sizeof(UpdateResult));
+    CopyField(result->device_id, MAX_PATH_LEN, device_id);
+
+    if (!device) {
+        CopyField(result->current_version, 64, "Not Found");
+        result->update_status = -1;
+        return;
+    }
+
+    CopyField(result->current_version, 64, device->driver_version.empty() ? "Unknown" : device->driver_version);
+
+    std::string newest = latest ? latest(*device) : std::string();
+    if (!newest.empty() && !device->driver_version.empty() &&
+        CompareDriverVersions(newest, device->driver_version) > 0) {
+        CopyField(result->latest_version, 64, newest);
+        result->update_available = 1;
+        result->update_status = 0;  // 有更新可用
+        return;
+    }
+
+    // 無版本來源、版本相同或目錄較舊 (不降級)
+    memcpy(result->latest_version, result->current_version, 64);
+    result->update_available = 0;
+    result->update_status = 1;  // 已是最新
+}
+
+int BatchUpdateChecker::CheckAll(UpdateResult* results, int max_count, const LatestVersionLookup& latest) const {
+    return CheckRecords(devices_, results, max_count, latest);
+}
+
+int BatchUpdateChecker::CheckRecords(const std::vector<DeviceRecord>& devices, UpdateResult* results, int max_count,
+                                     const LatestVersionLookup& latest) {
+    if (!results || max_count <= 0) return 0;
+
+    int count = 0;
+    for (const DeviceRecord& d : devices) {
+        if (count >= max_count) break;
+        Fill(d.instance_id.c_str(), &d, latest, &results[count]);
+        count++;
+    }
+    AUDIT_LOG("UPDATE", "Batch checked " + std::to_string(count) + " devices.");
+    return count;
+}
+
+int BatchUpdateChecker::CheckMany(const char* const* device_ids, int count, UpdateResult* results,
+                                  const LatestVersionLookup& latest) const {
+    if (!device_ids || !results || count <= 0) return 0;
+
+    int found = 0;
+    for (int i = 0; i < count; i++) {
+        const char* id = device_ids[i] ? device_ids[i] : "";
+        const DeviceRecord* d = Find(id);
+        Fill(id, d, latest, &results[i]);
+        if (d) found++;
+    }
+    return found;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 批次更新檢查引擎
+ * 功能: 一次列舉 + 實例ID索引，單趟解析全部設備 (取代逐設備重新列舉)
+ */
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "device_provider.h"
+
+#define MAX_PATH_LEN 512
+
+// 更新結果結構
+typedef struct {
+    char device_id[MAX_PATH_LEN];
+    char current_version[64];
+    char latest_version[64];
+    int update_available;  // 0=否, 1=是
+    int update_status;     // 0=成功, -1=失敗, 1=無需更新
+} UpdateResult;
+
+// 最新版本來源: 回傳設備的最新版本，空字串=未知 (視同已是最新)；只有數值上較新才算更新
+using LatestVersionLookup = std::function<std::string(const DeviceRecord&)>;
+
+class BatchUpdateChecker {
+public:
+    explicit BatchUpdateChecker(IDeviceProvider& provider) : provider_(provider) {}
+
+    /**
+     * 列舉一次並重建實例ID索引
+     * @return true=成功, false=列舉失敗
+     */
+    bool Refresh();
+
+    // 依實例ID查找 (O(1))，找不到回傳 nullptr
+    const DeviceRecord* Find(const std::string& instance_id) const;
+
+    /**
+     * [MAIDOS-AUDIT] 檢查所有設備
+     * @return 寫入的結果數量
+     */
+    int CheckAll(UpdateResult* results, int max_count, const LatestVersionLookup& latest = nullptr) const;
+
+    /**
+     * [MAIDOS-AUDIT] 檢查給定的設備記錄 (不列舉，供只處理清單差異的呼叫端使用)
+     * @return 寫入的結果數量
+     */
+    static int CheckRecords(const std::vector<DeviceRecord>& devices, UpdateResult* results, int max_count,
+                            const LatestVersionLookup& latest = nullptr);
+
+    /**
+     * [MAIDOS-AUDIT] 檢查指定設備 (結果順序與輸入一致，找不到者 update_status=-1)
+     * @return 找到的設備數量
+     */
+    int CheckMany(const char* const* device_ids, int count, UpdateResult* results,
+                  const LatestVersionLookup& latest = nullptr) const;
+
+    const std::vector<DeviceRecord>& Devices() const { return devices_; }
+
+private:
+    static void Fill(const char* device_id, const DeviceRecord* device, const LatestVersionLookup& latest,
+                     UpdateResult* result);
+
+    IDeviceProvider& provider_;
+    std::vector<DeviceRecord> devices_;
+    std::unordered_map<std::string, size_t> index_;
+};
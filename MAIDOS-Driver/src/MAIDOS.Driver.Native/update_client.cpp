@@ -0,0 +1,532 @@
+#pragma warning(disable: 4819)
+#include "update_client.h"
+#include "logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <winhttp.h>
+
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "winhttp.lib")
+
+typedef SOCKET socket_t;
+#define INVALID_SOCK INVALID_SOCKET
+#define CLOSE_SOCK closesocket
+#define MSG_NOSIGNAL_FLAG 0
+#else
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+typedef int socket_t;
+#define INVALID_SOCK (-1)
+#define MSG_NOSIGNAL_FLAG MSG_NOSIGNAL
+#define CLOSE_SOCK close
+#endif
+
+#define USER_AGENT "MAIDOS-Driver-Updater/1.0"
+
+bool ParsedUrl::Parse(const std::string& url, ParsedUrl& out) {
+    size_t scheme_end = url.find("://");
+    if (scheme_end == std::string::npos) return false;
+    out.scheme = url.substr(0, scheme_end);
+    for (char& c : out.scheme) c = (char)tolower((unsigned char)c);
+    if (out.scheme != "http" && out.scheme != "https") return false;
+
+    size_t host_start = scheme_end + 3;
+    size_t path_start = url.find('/', host_start);
+    std::string authority = url.substr(host_start, path_start == std::string::npos ? std::string::npos : path_start - host_start);
+    out.path = path_start == std::string::npos ? "/" : url.substr(path_start);
+
+    size_t colon = authority.rfind(':');
+    if (colon != std::string::npos && authority.find(']') == std::string::npos) {
+        int port = atoi(authority.c_str() + colon + 1);
+        if (port <= 0 || port > 65535) return false;
+        out.port = (uint16_t)port;
+        out.host = authority.substr(0, colon);
+    } else {
+        out.port = out.scheme == "https" ? 443 : 80;
+        out.host = authority;
+    }
+    return !out.host.empty();
+}
+
+std::string UrlEncode(const std::string& value) {
+    static const char hex[] = "0123456789ABCDEF";
+    std::string out;
+    out.reserve(value.size() * 3);
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out.push_back((char)c);
+        } else {
+            out.push_back('%');
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 15]);
+        }
+    }
+    return out;
+}
+
+std::string ParseVersionResponse(const std::string& body) {
+    // 預期回應格式: "VERSION:x.x.x" 或直接版本號
+    size_t start = body.find(':');
+    start = start == std::string::npos ? 0 : start + 1;
+    size_t end = body.find_first_of("\r\n", start);
+    std::string version = body.substr(start, end == std::string::npos ? std::string::npos : end - start);
+    while (!version.empty() && version.front() == ' ') version.erase(0, 1);
+    while (!version.empty() && version.back() == ' ') version.pop_back();
+    return version;
+}
+
+// ---------------------------------------------------------------------------
+// SocketTransport
+// ---------------------------------------------------------------------------
+
+static void EnsureSockets() {
+#ifdef _WIN32
+    static bool started = []() {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    (void)started;
+#endif
+}
+
+static void SetTimeouts(socket_t s, int timeout_ms) {
+#ifdef _WIN32
+    DWORD tv = (DWORD)timeout_ms;
+#else
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char*)&tv, sizeof(tv));
+    setsockopt(s, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv));
+}
+
+SocketTransport::SocketTransport(std::string host, uint16_t port, size_t max_idle)
+    : host_(std::move(host)), port_(port), max_idle_(max_idle) {
+    EnsureSockets();
+}
+
+SocketTransport::~SocketTransport() {
+    for (intptr_t s : idle_) CLOSE_SOCK((socket_t)s);
+}
+
+intptr_t SocketTransport::Connect(int timeout_ms) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    char port[8];
+    snprintf(port, sizeof(port), "%u", (unsigned)port_);
+    struct addrinfo* addrs = nullptr;
+    if (getaddrinfo(host_.c_str(), port, &hints, &addrs) != 0) return -1;
+
+    socket_t s = INVALID_SOCK;
+    for (struct addrinfo* a = addrs; a; a = a->ai_next) {
+        s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s == INVALID_SOCK) continue;
+        SetTimeouts(s, timeout_ms);
+        if (connect(s, a->ai_addr, (int)a->ai_addrlen) == 0) break;
+        CLOSE_SOCK(s);
+        s = INVALID_SOCK;
+    }
+    freeaddrinfo(addrs);
+    if (s == INVALID_SOCK) return -1;
+
+    int one = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+    opened_++;
+    return (intptr_t)s;
+}
+
+static bool SendAll(socket_t s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(s, data.data() + sent, (int)(data.size() - sent), MSG_NOSIGNAL_FLAG);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+static std::string Lower(std::string s) {
+    for (char& c : s) c = (char)tolower((unsigned char)c);
+    return s;
+}
+
+// 解析標頭區 (不含結尾空行)；名稱轉小寫，值去除前後空白
+static bool ParseHead(const std::string& head, HttpResponse& response) {
+    size_t line_end = head.find("\r\n");
+    std::string status_line = head.substr(0, line_end);
+    if (Lower(status_line.substr(0, 5)) != "http/") return false;
+    size_t sp = status_line.find(' ');
+    response.status = sp == std::string::npos ? 0 : atoi(status_line.c_str() + sp + 1);
+
+    response.headers.clear();
+    size_t pos = line_end == std::string::npos ? head.size() : line_end + 2;
+    while (pos < head.size()) {
+        size_t next = head.find("\r\n", pos);
+        if (next == std::string::npos) next = head.size();
+        size_t colon = head.find(':', pos);
+        if (colon != std::string::npos && colon < next) {
+            std::string value = head.substr(colon + 1, next - colon - 1);
+            size_t v = value.find_first_not_of(" \t");
+            value = v == std::string::npos ? std::string() : value.substr(v, value.find_last_not_of(" \t") - v + 1);
+            response.headers.emplace_back(Lower(head.substr(pos, colon - pos)), value);
+        }
+        pos = next + 2;
+    }
+    return true;
+}
+
+static bool RecvMore(socket_t s, std::string& buf, bool& received) {
+    char chunk[16384];
+    int n = recv(s, chunk, sizeof(chunk), 0);
+    if (n <= 0) return false;
+    received = true;
+    buf.append(chunk, (size_t)n);
+    return true;
+}
+
+bool SocketTransport::Exchange(intptr_t sock, const HttpRequest& request, HttpResponse& response, bool& keep_alive,
+                               bool& received) {
+    socket_t s = (socket_t)sock;
+    received = false;
+    std::string wire = request.method + " " + request.path + " HTTP/1.1\r\nHost: " + host_ +
+                       "\r\nUser-Agent: " USER_AGENT "\r\nConnection: keep-alive\r\n";
+    bool has_type = false;
+    for (const auto& h : request.headers) {
+        wire += h.first + ": " + h.second + "\r\n";
+        if (Lower(h.first) == "content-type") has_type = true;
+    }
+    if (!request.body.empty() || request.method == "POST") {
+        if (!has_type) wire += "Content-Type: text/plain\r\n";
+        wire += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+    }
+    wire += "\r\n";
+    wire += request.body;
+    if (!SendAll(s, wire)) return false;
+
+    std::string buf;
+    size_t header_end;
+    while ((header_end = buf.find("\r\n\r\n")) == std::string::npos) {
+        if (!RecvMore(s, buf, received)) return false;
+    }
+    if (!ParseHead(buf.substr(0, header_end), response)) return false;
+    buf.erase(0, header_end + 4);
+    keep_alive = Lower(response.Header("connection")) != "close";
+
+    response.body.clear();
+    bool to_sink = request.sink && response.status / 100 == 2;
+    auto deliver = [&](size_t n) {
+        bool ok = to_sink ? request.sink(buf.data(), n) : (response.body.append(buf, 0, n), true);
+        buf.erase(0, n);
+        return ok;
+    };
+
+    if (request.method == "HEAD" || response.status == 204 || response.status == 304) return true;
+
+    if (Lower(response.Header("transfer-encoding")).find("chunked") != std::string::npos) {
+        // 逐塊解碼: <hex 長度>\r\n<資料>\r\n ... 0\r\n\r\n (不支援 trailer)
+        while (true) {
+            size_t line_end;
+            while ((line_end = buf.find("\r\n")) == std::string::npos) {
+                if (!RecvMore(s, buf, received)) return false;
+            }
+            unsigned long long size = strtoull(buf.c_str(), nullptr, 16);
+            buf.erase(0, line_end + 2);
+            bool last = size == 0;
+            while (size > 0) {
+                if (buf.empty() && !RecvMore(s, buf, received)) return false;
+                size_t take = size < buf.size() ? (size_t)size : buf.size();
+                if (!deliver(take)) return false;
+                size -= take;
+            }
+            while (buf.size() < 2) {
+                if (!RecvMore(s, buf, received)) return false;
+            }
+            buf.erase(0, 2);
+            if (last) break;
+        }
+        return true;
+    }
+
+    std::string length = response.Header("content-length");
+    if (!length.empty()) {
+        unsigned long long remaining = strtoull(length.c_str(), nullptr, 10);
+        while (remaining > 0) {
+            if (buf.empty() && !RecvMore(s, buf, received)) return false;
+            size_t take = remaining < buf.size() ? (size_t)remaining : buf.size();
+            if (!deliver(take)) return false;
+            remaining -= take;
+        }
+        return true;
+    }
+
+    // 無長度: 讀到連線關閉
+    keep_alive = false;
+    do {
+        if (!deliver(buf.size())) return false;
+    } while (RecvMore(s, buf, received));
+    return true;
+}
+
+void SocketTransport::Release(intptr_t sock, bool keep_alive) {
+    if (keep_alive) {
+        std::lock_guard<std::mutex> guard(lock_);
+        if (idle_.size() < max_idle_) {
+            idle_.push_back(sock);
+            return;
+        }
+    }
+    CLOSE_SOCK((socket_t)sock);
+}
+
+bool SocketTransport::Send(const HttpRequest& request, HttpResponse& response, int timeout_ms) {
+    // 先用閒置連線；閒置連線可能已被伺服器關閉，尚未收到任何回應時以新連線重試一次
+    for (int attempt = 0; attempt < 2; attempt++) {
+        intptr_t sock = -1;
+        bool reused = false;
+        if (attempt == 0) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!idle_.empty()) {
+                sock = idle_.back();
+                idle_.pop_back();
+                reused = true;
+            }
+        }
+        if (sock < 0) {
+            sock = Connect(timeout_ms);
+            if (sock < 0) return false;
+        } else {
+            SetTimeouts((socket_t)sock, timeout_ms);
+        }
+
+        bool keep_alive = false, received = false;
+        if (Exchange(sock, request, response, keep_alive, received)) {
+            Release(sock, keep_alive);
+            return true;
+        }
+        CLOSE_SOCK((socket_t)sock);
+        if (!reused || received) return false;  // 已收到部分回應時不重送
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// WinHttpTransport
+// ---------------------------------------------------------------------------
+
+#ifdef _WIN32
+static std::wstring Widen(const std::string& s) {
+    if (s.empty()) return std::wstring();
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), NULL, 0);
+    std::wstring w((size_t)n, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), &w[0], n);
+    return w;
+}
+
+static std::string Narrow(const wchar_t* w) {
+    int n = WideCharToMultiByte(CP_UTF8, 0, w, -1, NULL, 0, NULL, NULL);
+    if (n <= 1) return std::string();
+    std::string s((size_t)n - 1, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, w, -1, &s[0], n, NULL, NULL);
+    return s;
+}
+
+WinHttpTransport::WinHttpTransport(const std::string& host, uint16_t port, bool secure) : secure_(secure) {
+    session_ = WinHttpOpen(L"" USER_AGENT, WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+    if (session_) connect_ = WinHttpConnect((HINTERNET)session_, Widen(host).c_str(), port, 0);
+}
+
+WinHttpTransport::~WinHttpTransport() {
+    if (connect_) WinHttpCloseHandle((HINTERNET)connect_);
+    if (session_) WinHttpCloseHandle((HINTERNET)session_);
+}
+
+bool WinHttpTransport::Send(const HttpRequest& request, HttpResponse& response, int timeout_ms) {
+    if (!connect_) return false;
+
+    HINTERNET req = WinHttpOpenRequest((HINTERNET)connect_, Widen(request.method).c_str(), Widen(request.path).c_str(),
+        NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, secure_ ? WINHTTP_FLAG_SECURE : 0);
+    if (!req) return false;
+    WinHttpSetTimeouts(req, timeout_ms, timeout_ms, timeout_ms, timeout_ms);
+
+    std::string extra;
+    for (const auto& h : request.headers) extra += h.first + ": " + h.second + "\r\n";
+    std::wstring wextra = Widen(extra);
+
+    bool ok = WinHttpSendRequest(req, wextra.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : wextra.c_str(), (DWORD)-1L,
+                  request.body.empty() ? WINHTTP_NO_REQUEST_DATA : (LPVOID)request.body.data(),
+                  (DWORD)request.body.size(), (DWORD)request.body.size(), 0) &&
+              WinHttpReceiveResponse(req, NULL);
+    if (ok) {
+        DWORD size = 0;
+        WinHttpQueryHeaders(req, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+            WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+        std::wstring raw(size / sizeof(wchar_t) + 1, L'\0');
+        ok = WinHttpQueryHeaders(req, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+            &raw[0], &size, WINHTTP_NO_HEADER_INDEX) && ParseHead(Narrow(raw.c_str()), response);
+    }
+    if (ok) {
+        response.body.clear();
+        bool to_sink = request.sink && response.status / 100 == 2;
+        std::vector<char> buffer(64 * 1024);
+
+        DWORD read = 0;
+        while ((ok = WinHttpReadData(req, buffer.data(), (DWORD)buffer.size(), &read) != FALSE) && read > 0) {
+            if (to_sink) {
+                if (!request.sink(buffer.data(), read)) {
+                    ok = false;
+                    break;
+                }
+            } else {
+                response.body.append(buffer.data(), read);
+            }
+        }
+    }
+    WinHttpCloseHandle(req);
+    return ok;
+}
+#endif
+
+std::unique_ptr<IUpdateTransport> CreateUpdateTransport(const ParsedUrl& url) {
+#ifdef _WIN32
+    return std::unique_ptr<IUpdateTransport>(new WinHttpTransport(url.host, url.port, url.scheme == "https"));
+#else
+    if (url.scheme != "http") return nullptr;
+    return std::unique_ptr<IUpdateTransport>(new SocketTransport(url.host, url.port));
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// UpdateCheckClient
+// ---------------------------------------------------------------------------
+
+std::vector<UpdateReply> UpdateCheckClient::Check(const std::vector<UpdateQuery>& queries) {
+    std::vector<UpdateReply> replies(queries.size());
+    if (queries.empty()) return replies;
+
+    std::vector<size_t> pending;
+    if (options_.batch && CheckBatch(queries, replies)) {
+        for (size_t i = 0; i < queries.size(); i++) {
+            if (!replies[i].ok) pending.push_back(i);
+        }
+        AUDIT_LOG("UPDATE", "Batch update check answered " + std::to_string(queries.size() - pending.size()) +
+                  " of " + std::to_string(queries.size()) + " devices.");
+        if (pending.empty()) return replies;
+    } else {
+        pending.resize(queries.size());
+        for (size_t i = 0; i < queries.size(); i++) pending[i] = i;
+    }
+
+    // 批次未回覆的設備改為逐設備查詢
+    CheckEach(queries, pending, replies);
+    AUDIT_LOG("UPDATE", "Per-device update check for " + std::to_string(pending.size()) + " devices, " +
+              std::to_string(transport_.ConnectionsOpened()) + " connections.");
+    return replies;
+}
+
+// 批次回應須明確標示格式: Content-Type 或本體首行標記，避免把一般 200 頁面 (如首頁/代理錯誤頁) 當成批次回覆
+static bool IsBatchReply(const HttpResponse& response) {
+    std::string type = Lower(response.Header("content-type"));
+    type = type.substr(0, type.find(';'));
+    while (!type.empty() && type.back() == ' ') type.pop_back();
+    if (type == UPDATE_BATCH_CONTENT_TYPE) return true;
+
+    const std::string& body = response.body;
+    size_t marker = strlen(UPDATE_BATCH_MARKER);
+    return body.compare(0, marker, UPDATE_BATCH_MARKER) == 0 &&
+           (body.size() == marker || body[marker] == '\r' || body[marker] == '\n');
+}
+
+bool UpdateCheckClient::CheckBatch(const std::vector<UpdateQuery>& queries, std::vector<UpdateReply>& replies) {
+    // 請求: 每行 "設備ID\t目前版本"；回應: 每行 "設備ID\t最新版本" (版本空白=伺服器不認識此設備)
+    HttpRequest request;
+    request.method = "POST";
+    request.path = path_;
+    request.headers.emplace_back("Content-Type", UPDATE_BATCH_CONTENT_TYPE);
+    request.headers.emplace_back("Accept", UPDATE_BATCH_CONTENT_TYPE);
+    for (const UpdateQuery& q : queries) {
+        request.body += q.device_id;
+        request.body += '\t';
+        request.body += q.current_version;
+        request.body += '\n';
+    }
+
+    HttpResponse response;
+    requests_++;
+    if (!transport_.Send(request, response, options_.timeout_ms) || response.status != 200) return false;
+    if (!IsBatchReply(response)) {
+        AUDIT_LOG("UPDATE", "Batch reply not recognised, falling back to per-device checks.");
+        return false;
+    }
+
+    std::unordered_map<std::string, std::string> latest;
+    size_t pos = 0;
+    const std::string& body = response.body;
+    while (pos < body.size()) {
+        size_t end = body.find('\n', pos);
+        if (end == std::string::npos) end = body.size();
+        std::string line = body.substr(pos, end - pos);
+        pos = end + 1;
+
+        size_t tab = line.find('\t');
+        if (tab == std::string::npos) continue;
+        latest[line.substr(0, tab)] = ParseVersionResponse(line.substr(tab + 1));
+    }
+
+    // 只有回應中出現的設備算已回覆；其餘保持 ok=false 交由逐設備查詢
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto it = latest.find(queries[i].device_id);
+        if (it == latest.end()) continue;
+        replies[i].ok = true;
+        replies[i].latest_version = it->second;
+    }
+    return true;
+}
+
+void UpdateCheckClient::CheckEach(const std::vector<UpdateQuery>& queries, const std::vector<size_t>& pending,
+                                  std::vector<UpdateReply>& replies) {
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]() {
+        size_t n;
+        while ((n = next.fetch_add(1)) < pending.size()) {
+            size_t i = pending[n];
+            HttpRequest request;
+            request.path = path_ + UrlEncode(queries[i].device_id);
+            HttpResponse response;
+            requests_++;
+            if (!transport_.Send(request, response, options_.timeout_ms)) continue;
+
+            if (response.status == 200) {
+                replies[i].ok = true;
+                replies[i].latest_version = ParseVersionResponse(response.body);
+            } else if (response.status == 404) {
+                replies[i].ok = true;  // 伺服器不認識此設備
+            }
+        }
+    };
+
+    size_t threads = (size_t)(options_.max_parallel > 0 ? options_.max_parallel : 1);
+    if (threads > pending.size()) threads = pending.size();
+
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for (std::thread& t : pool) t.join();
+}
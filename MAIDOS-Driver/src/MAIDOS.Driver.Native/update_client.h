@@ -0,0 +1,172 @@
+#pragma once
+#pragma warning(disable: 4819)
+/**
+ * [MAIDOS-AUDIT] 線上更新檢查客戶端
+ * 功能: 整份設備清單一次 POST 查詢 (回應須帶批次 Content-Type 或首行標記)；
+ *       伺服器不支援或未回覆的設備改為有上限的並行 GET，
+ *       連線由傳輸層保持 (keep-alive) 重用，每個請求有逾時
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// 解析後的 URL (http://host:port/path)
+struct ParsedUrl {
+    std::string scheme;   // "http" / "https"
+    std::string host;
+    uint16_t port = 0;
+    std::string path;     // 含查詢字串，至少為 "/"
+
+    static bool Parse(const std::string& url, ParsedUrl& out);
+};
+
+using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+
+// 回應本體接收器: 呼叫時 response 的 status/headers 已填好；回傳 false 中止傳輸 (Send 回傳 false)
+using HttpBodySink = std::function<bool(const char* data, size_t len)>;
+
+struct HttpRequest {
+    std::string method = "GET";
+    std::string path = "/";
+    HttpHeaders headers;      // 額外請求標頭 (如 Range)
+    std::string body;
+    HttpBodySink sink;        // 非空時 2xx 回應本體串流交給 sink，不存入 response.body
+};
+
+struct HttpResponse {
+    int status = 0;
+    HttpHeaders headers;      // 名稱已轉小寫
+    std::string body;
+
+    std::string Header(const std::string& name) const {
+        for (const auto& h : headers) {
+            if (h.first == name) return h.second;
+        }
+        return std::string();
+    }
+};
+
+/**
+ * [MAIDOS-AUDIT] HTTP 傳輸介面 (單一伺服器)
+ * 實作須可被多執行緒同時呼叫，並自行重用連線
+ */
+class IUpdateTransport {
+public:
+    virtual ~IUpdateTransport() = default;
+
+    /**
+     * 送出請求
+     * @return true=收到完整回應 (任何狀態碼), false=連線/逾時錯誤
+     */
+    virtual bool Send(const HttpRequest& request, HttpResponse& response, int timeout_ms) = 0;
+
+    // 已建立的連線數 (基準/測試統計)
+    virtual uint64_t ConnectionsOpened() const = 0;
+};
+
+/**
+ * [MAIDOS-AUDIT] 純 socket HTTP/1.1 傳輸 (僅 http，keep-alive 連線池)
+ */
+class SocketTransport : public IUpdateTransport {
+public:
+    SocketTransport(std::string host, uint16_t port, size_t max_idle = 8);
+    ~SocketTransport() override;
+
+    bool Send(const HttpRequest& request, HttpResponse& response, int timeout_ms) override;
+    uint64_t ConnectionsOpened() const override { return opened_.load(); }
+
+private:
+    intptr_t Connect(int timeout_ms);
+    bool Exchange(intptr_t sock, const HttpRequest& request, HttpResponse& response, bool& keep_alive, bool& received);
+    void Release(intptr_t sock, bool keep_alive);
+
+    std::string host_;
+    uint16_t port_;
+    size_t max_idle_;
+    std::mutex lock_;
+    std::vector<intptr_t> idle_;
+    std::atomic<uint64_t> opened_{ 0 };
+};
+
+#ifdef _WIN32
+/**
+ * [MAIDOS-AUDIT] WinHTTP 傳輸 (http/https，單一 session 內由 WinHTTP 重用連線)
+ */
+class WinHttpTransport : public IUpdateTransport {
+public:
+    WinHttpTransport(const std::string& host, uint16_t port, bool secure);
+    ~WinHttpTransport() override;
+
+    bool Send(const HttpRequest& request, HttpResponse& response, int timeout_ms) override;
+    uint64_t ConnectionsOpened() const override { return 1; }
+
+private:
+    void* session_ = nullptr;
+    void* connect_ = nullptr;
+    bool secure_;
+};
+#endif
+
+// 依 URL 建立平台預設傳輸 (Windows=WinHTTP, 其他=socket，僅 http)
+std::unique_ptr<IUpdateTransport> CreateUpdateTransport(const ParsedUrl& url);
+
+// 批次協定: 請求/回應的 Content-Type；伺服器也可改以本體首行標記表明為批次回覆
+#define UPDATE_BATCH_CONTENT_TYPE "text/x-maidos-update-batch"
+#define UPDATE_BATCH_MARKER "#MAIDOS-UPDATE-BATCH"
+
+// 查詢項目
+struct UpdateQuery {
+    std::string device_id;
+    std::string current_version;
+};
+
+// 查詢結果
+struct UpdateReply {
+    std::string latest_version;  // 空=伺服器未回報
+    bool ok = false;             // false=請求失敗/逾時
+};
+
+struct UpdateClientOptions {
+    int max_parallel = 4;     // 逐設備模式的並行請求上限
+    int timeout_ms = 5000;    // 每個請求逾時
+    bool batch = true;        // 先嘗試整批 POST
+};
+
+class UpdateCheckClient {
+public:
+    /**
+     * @param transport 連到更新伺服器的傳輸層
+     * @param path 伺服器路徑；批次模式 POST 到此路徑，逐設備模式 GET path + 設備ID
+     */
+    UpdateCheckClient(IUpdateTransport& transport, std::string path, UpdateClientOptions options = UpdateClientOptions())
+        : transport_(transport), path_(std::move(path)), options_(options) {}
+
+    /**
+     * [MAIDOS-AUDIT] 查詢所有設備的最新版本
+     * @return 與 queries 同順序的結果
+     */
+    std::vector<UpdateReply> Check(const std::vector<UpdateQuery>& queries);
+
+    // 實際送出的請求數 (統計)
+    uint64_t RequestsSent() const { return requests_.load(); }
+
+private:
+    bool CheckBatch(const std::vector<UpdateQuery>& queries, std::vector<UpdateReply>& replies);
+    void CheckEach(const std::vector<UpdateQuery>& queries, const std::vector<size_t>& pending, std::vector<UpdateReply>& replies);
+
+    IUpdateTransport& transport_;
+    std::string path_;
+    UpdateClientOptions options_;
+    std::atomic<uint64_t> requests_{ 0 };
+};
+
+// 解析版本回應 ("VERSION:x.x.x" 或直接版本號，去除換行)
+std::string ParseVersionResponse(const std::string& body);
+
+// URL 百分比編碼 (設備ID含 '\\' 與 '&')
+std::string UrlEncode(const std::string& value);
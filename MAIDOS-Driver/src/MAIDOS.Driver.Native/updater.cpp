@@ -6,26 +6,70 @@
 #include <windows.h>
 #include <wininet.h>
 #include <setupapi.h>
+#include <newdev.h>
 #include <stdio.h>
 #include <string.h>
 #include "logger.h"
+#include "update_check.h"
+#include "driver_catalog.h"
+#include "driver_version.h"
+#include "update_client.h"
+#include "download_engine.h"
+#include "download_scheduler.h"
+#include "inf_index.h"
+#include "inventory_store.h"
+#include "fleet_matcher.h"
+#include <map>
+#include <mutex>
+#include <unordered_set>
 
 #pragma comment(lib, "wininet.lib")
 #pragma comment(lib, "setupapi.lib")
+#pragma comment(lib, "newdev.lib")
 
 #define EXPORT extern "C" __declspec(dllexport)
-#define MAX_PATH_LEN 512
 #define MAX_URL_LEN 2048
-#define BUFFER_SIZE 8192
 
-// 更新結果結構
-typedef struct {
-    char device_id[MAX_PATH_LEN];
-    char current_version[64];
-    char latest_version[64];
-    int update_available;  // 0=否, 1=是
-    int update_status;     // 0=成功, -1=失敗, 1=無需更新
-} UpdateResult;
+// [MAIDOS-AUDIT] 已載入的驅動目錄 (load_driver_catalog)
+static std::mutex g_catalogLock;
+static DriverCatalog g_catalog;
+
+// [MAIDOS-AUDIT] 背景下載排程器 (start_download_scheduler 或首次排程時建立，shutdown_download_scheduler 停止)
+// 刻意不以靜態物件持有: 靜態解構在 DLL 卸載時於 loader lock 下執行，等待工作執行緒會死結
+static std::mutex g_schedulerLock;
+static std::shared_ptr<DownloadScheduler>* g_scheduler = new std::shared_ptr<DownloadScheduler>();
+
+static std::shared_ptr<DownloadScheduler> Scheduler(bool create) {
+    std::lock_guard<std::mutex> guard(g_schedulerLock);
+    if (!*g_scheduler && create) g_scheduler->reset(new DownloadScheduler());
+    return *g_scheduler;
+}
+
+// 下載進度回呼 (由下載執行緒呼叫)
+typedef void (*DownloadProgressCallback)(long long job_id, unsigned long long done, unsigned long long total);
+
+// [MAIDOS-AUDIT] 本地驅動儲存庫索引 (index_driver_repository)
+static std::mutex g_infIndexLock;
+static InfIndex g_infIndex;
+
+// INF 模型節平台修飾對應的本機平台
+static const char* NativeArch() {
+#if defined(_M_ARM64)
+    return "arm64";
+#elif defined(_WIN64)
+    return "amd64";
+#else
+    return "x86";
+#endif
+}
+
+static std::string UpperId(const std::string& id) {
+    std::string out(id);
+    for (char& c : out) {
+        if (c >= 'a' && c <= 'z') c = (char)(c - 32);
+    }
+    return out;
+}
 
 /**
  * [MAIDOS-AUDIT] 檢查驅動更新 (線上)
@@ -40,39 +84,15 @@ EXPORT int check_driver_update(const char* device_id, const char* update_server,
     memset(result, 0, sizeof(UpdateResult));
     strncpy_s(result->device_id, MAX_PATH_LEN, device_id, _TRUNCATE);
     
-    // 獲取當前驅動版本
-    HDEVINFO devInfo = SetupDiGetClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
-    if (devInfo == INVALID_HANDLE_VALUE) {
-        result->update_status = -1;
-        return -1;
-    }
-    
-    SP_DEVINFO_DATA devData;
-    devData.cbSize = sizeof(SP_DEVINFO_DATA);
-    BOOL found = FALSE;
-    
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(devInfo, i, &devData); i++) {
-        char instanceId[MAX_PATH_LEN];
-        if (SetupDiGetDeviceInstanceIdA(devInfo, &devData, instanceId, MAX_PATH_LEN, NULL)) {
-            if (strcmp(instanceId, device_id) == 0) {
-                // 獲取驅動版本
-                char driverVersion[64] = "Unknown";
-                DWORD reqSize;
-                SetupDiGetDeviceRegistryPropertyA(devInfo, &devData, SPDRP_DRIVER,
-                    NULL, (PBYTE)driverVersion, sizeof(driverVersion), &reqSize);
-                strncpy_s(result->current_version, 64, driverVersion, _TRUNCATE);
-                found = TRUE;
-                break;
-            }
-        }
-    }
-    SetupDiDestroyDeviceInfoList(devInfo);
-    
-    if (!found) {
+    // 獲取當前驅動版本 (直接定位單一 devnode，不列舉設備樹)
+    DeviceRecord device;
+    if (!DefaultDeviceProvider().ReadDevice(device_id, device)) {
         strcpy_s(result->current_version, 64, "Not Found");
         result->update_status = -1;
         return -1;
     }
+    strncpy_s(result->current_version, 64,
+        device.driver_version.empty() ? "Unknown" : device.driver_version.c_str(), _TRUNCATE);
     
     // [MAIDOS-AUDIT] 線上版本檢查
     // 如果提供了更新伺服器 URL，發送 HTTP 請求檢查最新版本
@@ -106,8 +126,8 @@ EXPORT int check_driver_update(const char* device_id, const char* update_server,
                     
                     strncpy_s(result->latest_version, 64, versionStart, _TRUNCATE);
                     
-                    // 比對版本
-                    if (strcmp(result->current_version, result->latest_version) != 0) {
+                    // 比對版本 (數值比較，不降級)
+                    if (CompareDriverVersions(result->latest_version, result->current_version) > 0) {
                         result->update_available = 1;
                         result->update_status = 0;  // 有更新可用
                         InternetCloseHandle(hUrl);
@@ -130,50 +150,99 @@ EXPORT int check_driver_update(const char* device_id, const char* update_server,
 }
 
 /**
- * [MAIDOS-AUDIT] 下載驅動更新
+ * [MAIDOS-AUDIT] 下載驅動更新 (分塊並行、可續傳、校驗 SHA-256 後原子改名)
  * @param download_url 下載URL
  * @param save_path 保存路徑
- * @return 1=成功, -1=失敗
+ * @param expected_sha256 預期 SHA-256 (64 位十六進位；NULL/空/VERIFY_ON_DOWNLOAD=只計算不比對)
+ * @param sha256_out 實際 SHA-256 輸出 (至少 65 bytes，可為 NULL)
+ * @return 1=成功, -1=失敗 (可再次呼叫續傳), -2=校驗不符
  */
-EXPORT int download_driver_update(const char* download_url, const char* save_path) {
+EXPORT int download_driver_update_verified(const char* download_url, const char* save_path,
+                                           const char* expected_sha256, char* sha256_out) {
     if (!download_url || !save_path) return -1;
     
-    HINTERNET hInternet = InternetOpenA("MAIDOS-Driver-Updater/1.0", 
-        INTERNET_OPEN_TYPE_PRECONFIG, NULL, NULL, 0);
-    if (!hInternet) return -1;
+    DownloadOptions options;
+    if (expected_sha256) options.expected_sha256 = expected_sha256;
     
-    HINTERNET hUrl = InternetOpenUrlA(hInternet, download_url, NULL, 0,
-        INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE, 0);
-    if (!hUrl) {
-        InternetCloseHandle(hInternet);
-        return -1;
-    }
-    
-    FILE* fp;
-    if (fopen_s(&fp, save_path, "wb") != 0) {
-        InternetCloseHandle(hUrl);
-        InternetCloseHandle(hInternet);
-        return -1;
-    }
-    
-    char buffer[BUFFER_SIZE];
-    DWORD bytesRead;
-    while (InternetReadFile(hUrl, buffer, BUFFER_SIZE, &bytesRead) && bytesRead > 0) {
-        fwrite(buffer, 1, bytesRead, fp);
+    DownloadResult result = DownloadFile(download_url, save_path, options);
+    if (sha256_out) strcpy_s(sha256_out, 65, result.sha256.c_str());
+    return result.status == DOWNLOAD_CHECKSUM_MISMATCH ? -2 : result.status == DOWNLOAD_OK ? 1 : -1;
+}
+
+/**
+ * [MAIDOS-AUDIT] 下載驅動更新
+ * @param download_url 下載URL
+ * @param save_path 保存路徑
+ * @return 1=成功, -1=失敗
+ */
+EXPORT int download_driver_update(const char* download_url, const char* save_path) {
+    return download_driver_update_verified(download_url, save_path, NULL, NULL) == 1 ? 1 : -1;
+}
+
+// 相容驅動排名的識別分數 (低 16 位): 0x0000-0x0FFF 表示設備硬體ID與 INF 硬體ID相符，其餘為相容ID比對
+#define DRIVER_RANK_HARDWARE_ID_LIMIT 0x1000
+
+/**
+ * [MAIDOS-AUDIT] 只對單一 devnode 安裝: 以該 INF 建立相容驅動清單，
+ * 選取以硬體ID相符且排名最佳的項目，SetupDiSetSelectedDriver + DiInstallDevice
+ * @param force true=即使不是較佳相符也安裝 (僅在 INF 版本嚴格較新時使用)
+ */
+static bool InstallOnDevnode(const char* instance_id, const char* inf_path, bool force) {
+    HDEVINFO devInfo = SetupDiCreateDeviceInfoList(NULL, NULL);
+    if (devInfo == INVALID_HANDLE_VALUE) return false;
+
+    bool installed = false;
+    SP_DEVINFO_DATA devData;
+    devData.cbSize = sizeof(SP_DEVINFO_DATA);
+    SP_DEVINSTALL_PARAMS_A params;
+    params.cbSize = sizeof(params);
+    if (SetupDiOpenDeviceInfoA(devInfo, instance_id, NULL, 0, &devData) &&
+        SetupDiGetDeviceInstallParamsA(devInfo, &devData, &params)) {
+        strncpy_s(params.DriverPath, MAX_PATH, inf_path, _TRUNCATE);
+        params.Flags |= DI_ENUMSINGLEINF;
+
+        if (SetupDiSetDeviceInstallParamsA(devInfo, &devData, &params) &&
+            SetupDiBuildDriverInfoList(devInfo, &devData, SPDIT_COMPATDRIVER)) {
+            SP_DRVINFO_DATA_W drv, best;
+            drv.cbSize = sizeof(drv);
+            DWORD bestRank = MAXDWORD;
+            for (DWORD i = 0; SetupDiEnumDriverInfoW(devInfo, &devData, SPDIT_COMPATDRIVER, i, &drv); i++) {
+                SP_DRVINSTALL_PARAMS drvParams;
+                drvParams.cbSize = sizeof(drvParams);
+                if (!SetupDiGetDriverInstallParamsW(devInfo, &devData, &drv, &drvParams)) continue;
+                if ((drvParams.Rank & 0xFFFF) >= DRIVER_RANK_HARDWARE_ID_LIMIT) continue;  // 不以相容ID安裝
+                if (drvParams.Rank < bestRank) {
+                    best = drv;
+                    bestRank = drvParams.Rank;
+                }
+            }
+
+            // DiInstallDevice 只有 Unicode 版本，驅動節點以 W 結構選取
+            if (bestRank != MAXDWORD && SetupDiSetSelectedDriverW(devInfo, &devData, &best)) {
+                BOOL needReboot = FALSE;
+                installed = DiInstallDevice(NULL, devInfo, &devData, reinterpret_cast<PSP_DRVINFO_DATA>(&best),
+                                            force ? DIIRFLAG_FORCE_INF : 0, &needReboot) != FALSE;
+                if (!installed) {
+                    AUDIT_LOG("UPDATE", "DiInstallDevice failed for " + std::string(instance_id) + ": " +
+                              std::to_string(GetLastError()));
+                }
+            } else if (bestRank == MAXDWORD) {
+                AUDIT_LOG("UPDATE", "No hardware-ID match in INF for " + std::string(instance_id));
+            }
+            SetupDiDestroyDriverInfoList(devInfo, &devData, SPDIT_COMPATDRIVER);
+        }
     }
-    
-    fclose(fp);
-    InternetCloseHandle(hUrl);
-    InternetCloseHandle(hInternet);
-    
-    return 1;
+    SetupDiDestroyDeviceInfoList(devInfo);
+    return installed;
 }
 
 /**
  * [MAIDOS-AUDIT] 執行驅動更新 (本地INF)
+ * 只以設備硬體ID比對 INF 支援的ID (不以相容ID安裝)；
+ * 只有 INF DriverVer 嚴格新於已安裝版本時才強制安裝，否則交由系統依排名決定是否較佳
  * @param inf_path INF文件路徑
- * @param device_id 設備ID (可選, NULL=自動匹配)
- * @return 1=成功, -1=失敗
+ * @param device_id 設備ID (可選, NULL=INF 支援的所有設備)；指定時只安裝到該 devnode
+ * @return 1=成功, -1=失敗 (含 INF 不支援指定設備)
  */
 EXPORT int apply_driver_update(const char* inf_path, const char* device_id) {
     if (!inf_path) return -1;
@@ -181,36 +250,134 @@ EXPORT int apply_driver_update(const char* inf_path, const char* device_id) {
     // [MAIDOS-AUDIT] 空字符串視同NULL，表示自動匹配所有設備
     BOOL match_all = (!device_id || device_id[0] == '\0');
     
-    // 使用 UpdateDriverForPlugAndPlayDevices API
-    // 或者調用現有的 install_driver_native
+    InfDocument doc;
+    InfDriverInfo info;
+    if (!doc.Load(inf_path) || !info.FromDocument(doc)) {
+        AUDIT_LOG("UPDATE", "Not a driver INF: " + std::string(inf_path));
+        return -1;
+    }
+    std::unordered_set<std::string> supported;
+    for (const InfModel& model : info.models) {
+        if (!InfDecorationMatches(model.decoration, NativeArch())) continue;
+        for (const std::string& id : model.ids) supported.insert(UpperId(id));
+    }
     
-    HDEVINFO devInfo = SetupDiGetClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
-    if (devInfo == INVALID_HANDLE_VALUE) return -1;
+    // INF 版本嚴格較新才強制 (已安裝版本未知時不強制)
+    auto strictly_newer = [&](const DeviceRecord& d) {
+        return !info.driver_version.empty() && !d.driver_version.empty() &&
+               CompareDriverVersions(info.driver_version, d.driver_version) > 0;
+    };
     
-    SP_DEVINFO_DATA devData;
-    devData.cbSize = sizeof(SP_DEVINFO_DATA);
-    BOOL success = FALSE;
+    char fullPath[MAX_PATH];
+    DWORD len = GetFullPathNameA(inf_path, MAX_PATH, fullPath, NULL);
+    if (len == 0 || len >= MAX_PATH) return -1;
     
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(devInfo, i, &devData); i++) {
-        char instanceId[MAX_PATH_LEN];
-        if (SetupDiGetDeviceInstanceIdA(devInfo, &devData, instanceId, MAX_PATH_LEN, NULL)) {
-            if (match_all || strcmp(instanceId, device_id) == 0) {
-                // 嘗試更新驅動
-                BOOL needReboot = FALSE;
-                if (SetupDiInstallDevice(devInfo, &devData)) {
-                    success = TRUE;
-                    if (!match_all) break;  // 指定設備，找到即退出
-                }
-            }
+    if (!match_all) {
+        DeviceRecord device;
+        if (!DefaultDeviceProvider().ReadDevice(device_id, device)) return -1;
+        bool found = false;
+        for (const std::string& id : device.hardware_ids) found = found || supported.count(UpperId(id)) > 0;
+        if (!found) {
+            AUDIT_LOG("UPDATE", std::string(device_id) + " is not supported by " + std::string(inf_path));
+            return -1;
         }
+        return InstallOnDevnode(device.instance_id.c_str(), fullPath, strictly_newer(device)) ? 1 : -1;
     }
     
-    SetupDiDestroyDeviceInfoList(devInfo);
+    std::vector<DeviceRecord> devices;
+    if (!DefaultDeviceProvider().Enumerate(devices)) return -1;
+    
+    // 每個設備取排序最前且 INF 支援的硬體ID；UpdateDriverForPlugAndPlayDevices 會套用到所有具該ID的設備，同一ID只呼叫一次
+    // 同一ID下所有設備的已安裝版本都較舊時才強制
+    std::map<std::string, bool> targets;
+    for (const DeviceRecord& d : devices) {
+        for (const std::string& id : d.hardware_ids) {
+            if (!supported.count(UpperId(id))) continue;
+            auto it = targets.emplace(id, true).first;
+            it->second = it->second && strictly_newer(d);
+            break;
+        }
+    }
+    if (targets.empty()) {
+        AUDIT_LOG("UPDATE", "No present device is supported by " + std::string(inf_path));
+        return -1;
+    }
+    
+    BOOL success = FALSE;
+    for (const auto& target : targets) {
+        BOOL needReboot = FALSE;
+        DWORD flags = target.second ? INSTALLFLAG_FORCE : 0;
+        if (UpdateDriverForPlugAndPlayDevicesA(NULL, target.first.c_str(), fullPath, flags, &needReboot)) {
+            success = TRUE;
+        } else {
+            AUDIT_LOG("UPDATE", "UpdateDriverForPlugAndPlayDevices failed for " + target.first + ": " + std::to_string(GetLastError()));
+        }
+    }
     return success ? 1 : -1;
 }
 
+/**
+ * [MAIDOS-AUDIT] 建立/增量更新本地驅動儲存庫索引 (硬體ID -> INF)
+ * @param repo_dir 儲存庫根目錄 (遞迴掃描 *.inf)
+ * @param index_path 持久化索引檔 (可為 NULL=不持久化)；首次呼叫時載入以沿用未變動 INF 的解析結果
+ * @return 索引的 INF 數, -1=失敗
+ */
+EXPORT int index_driver_repository(const char* repo_dir, const char* index_path) {
+    if (!repo_dir) return -1;
+    bool persist = index_path && index_path[0];
+    
+    std::lock_guard<std::mutex> guard(g_infIndexLock);
+    if (persist && g_infIndex.Size() == 0) g_infIndex.Load(index_path);
+    if (!g_infIndex.Update(repo_dir)) return -1;
+    if (persist && !g_infIndex.Save(index_path)) return -1;
+    return (int)g_infIndex.Size();
+}
+
+/**
+ * [MAIDOS-AUDIT] 從已建立的儲存庫索引中為設備選出最佳 INF (Windows 排序規則)
+ * @param device_id 設備實例ID
+ * @param inf_path INF 完整路徑輸出
+ * @param inf_path_len 緩衝區大小
+ * @return 1=找到, 0=無支援的 INF, -1=錯誤
+ */
+EXPORT int find_driver_inf(const char* device_id, char* inf_path, int inf_path_len) {
+    if (!device_id || !inf_path || inf_path_len <= 0) return -1;
+    
+    DeviceRecord device;
+    if (!DefaultDeviceProvider().ReadDevice(device_id, device)) return -1;
+    
+    std::lock_guard<std::mutex> guard(g_infIndexLock);
+    InfCandidate best;
+    if (!g_infIndex.Match(device, NativeArch(), best)) return 0;
+    
+    std::string full = g_infIndex.Root() + "\\" + best.inf->path;
+    for (char& c : full) {
+        if (c == '/') c = '\\';
+    }
+    if ((int)full.size() >= inf_path_len) return -1;
+    strcpy_s(inf_path, inf_path_len, full.c_str());
+    return 1;
+}
+
+/**
+ * [MAIDOS-AUDIT] 載入驅動目錄 (drivers.tsv 格式，取代先前載入的目錄)
+ * @param tsv_path 目錄檔路徑
+ * @return 目錄記錄數, -1=失敗
+ */
+EXPORT int load_driver_catalog(const char* tsv_path) {
+    if (!tsv_path) return -1;
+    
+    DriverCatalog catalog;
+    if (!catalog.LoadTsv(tsv_path)) return -1;
+    
+    std::lock_guard<std::mutex> guard(g_catalogLock);
+    g_catalog = std::move(catalog);
+    return (int)g_catalog.Size();
+}
+
 /**
  * [MAIDOS-AUDIT] 批次檢查所有設備更新
+ * 單次列舉，所有設備在同一趟內解析 (不再逐設備呼叫 check_driver_update)
  * @param results 結果陣列
  * @param max_count 最大數量
  * @return 實際檢查數量, -1=錯誤
@@ -218,21 +385,281 @@ EXPORT int apply_driver_update(const char* inf_path, const char* device_id) {
 EXPORT int check_all_updates(UpdateResult* results, int max_count) {
     if (!results || max_count <= 0) return -1;
     
-    HDEVINFO devInfo = SetupDiGetClassDevs(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
-    if (devInfo == INVALID_HANDLE_VALUE) return -1;
+    BatchUpdateChecker checker(DefaultDeviceProvider());
+    if (!checker.Refresh()) return -1;
     
-    SP_DEVINFO_DATA devData;
-    devData.cbSize = sizeof(SP_DEVINFO_DATA);
-    int count = 0;
+    // 已載入目錄時以目錄最佳匹配的版本作為最新版本
+    std::lock_guard<std::mutex> guard(g_catalogLock);
+    LatestVersionLookup latest = nullptr;
+    if (g_catalog.Size() > 0) {
+        latest = [](const DeviceRecord& d) {
+            CatalogMatch match;
+            return g_catalog.Match(d, match) ? match.entry->version : std::string();
+        };
+    }
+    return checker.CheckAll(results, max_count, latest);
+}
+
+/**
+ * [MAIDOS-AUDIT] 批次檢查指定設備更新
+ * @param device_ids 設備實例ID陣列
+ * @param count 設備數量
+ * @param results 結果陣列 (至少 count 個，順序與 device_ids 一致)
+ * @return 找到的設備數量, -1=錯誤
+ */
+EXPORT int check_updates_batch(const char* const* device_ids, int count, UpdateResult* results) {
+    if (!device_ids || !results || count <= 0) return -1;
+    
+    BatchUpdateChecker checker(DefaultDeviceProvider());
+    if (!checker.Refresh()) return -1;
     
-    for (DWORD i = 0; SetupDiEnumDeviceInfo(devInfo, i, &devData) && count < max_count; i++) {
-        char instanceId[MAX_PATH_LEN];
-        if (SetupDiGetDeviceInstanceIdA(devInfo, &devData, instanceId, MAX_PATH_LEN, NULL)) {
-            check_driver_update(instanceId, NULL, &results[count]);
-            count++;
+    return checker.CheckMany(device_ids, count, results);
+}
+
+// 更新檢查在清單儲存中的游標名稱 (與 commit_device_inventory 等其他消費者各自獨立)
+#define UPDATE_CHECK_CURSOR "update-check"
+
+/**
+ * [MAIDOS-AUDIT] 只檢查自上次檢查以來有變動的設備
+ * 刷新清單並提交到持久化儲存，以本功能自己的游標讀取日誌，只對新增、驅動變更、屬性變更的設備做目錄比對
+ * (首次使用儲存目錄或游標之後的日誌已被壓縮時，全部設備皆重新檢查)
+ * 結果全部寫入 results 後才推進游標；max_count 不足時游標不動，下次呼叫會再次回報
+ * @param store_dir 清單儲存目錄 (inventory.bin / inventory.journal)
+ * @param results 結果陣列
+ * @param max_count 最大數量
+ * @return 實際檢查數量 (0=無變動), -1=錯誤
+ */
+EXPORT int check_changed_updates(const char* store_dir, UpdateResult* results, int max_count) {
+    if (!store_dir || !results || max_count <= 0) return -1;
+
+    std::vector<DeviceRecord> changed;
+    uint64_t through = 0;
+    std::string error;
+    {
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        DeviceInventory& inventory = SharedDeviceInventory();
+        if (!inventory.Refresh()) return -1;
+
+        InventoryStore* store = SharedInventoryStore(store_dir, &error);
+        if (!store || !store->Commit(inventory, nullptr, &error)) {
+            AUDIT_LOG("UPDATE", "Inventory store failed: " + error);
+            return -1;
         }
+
+        uint64_t cursor = store->LoadCursor(UPDATE_CHECK_CURSOR);
+        through = store->Sequence();
+        std::vector<InventoryChange> changes;
+        if (cursor < store->JournalStart()) {
+            // 游標之後的紀錄已被壓縮: 無法得知差異，全部重新檢查
+            for (size_t row = 0; row < inventory.Size(); row++) changed.push_back(inventory.Record(row));
+        } else if (!store->ReadChanges(cursor, changes, &error)) {
+            AUDIT_LOG("UPDATE", "Inventory journal read failed: " + error);
+            return -1;
+        } else {
+            for (const std::string& id : InventoryDeltaIds(changes)) {
+                int row = inventory.Find(id);
+                if (row >= 0) changed.push_back(inventory.Record(row));
+            }
+        }
+    }
+
+    int written;
+    {
+        std::lock_guard<std::mutex> guard(g_catalogLock);
+        LatestVersionLookup latest = nullptr;
+        if (g_catalog.Size() > 0) {
+            latest = [](const DeviceRecord& d) {
+                CatalogMatch match;
+                return g_catalog.Match(d, match) ? match.entry->version : std::string();
+            };
+        }
+        written = BatchUpdateChecker::CheckRecords(changed, results, max_count, latest);
+    }
+
+    // 結果已交付才推進游標；寫入失敗只會造成下次重複回報
+    if ((size_t)written == changed.size()) {
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        InventoryStore* store = SharedInventoryStore(store_dir, &error);
+        if (!store || !store->SaveCursor(UPDATE_CHECK_CURSOR, through, &error)) {
+            AUDIT_LOG("UPDATE", "Cannot save update-check cursor: " + error);
+        }
+    }
+    return written;
+}
+
+/**
+ * [MAIDOS-AUDIT] 機群批次比對
+ * 以已載入的目錄並行比對 inventory_dir 下所有端點匯出的清單檔 (*.mdscan，見 export_device_inventory)
+ * @param inventory_dir 清單檔目錄
+ * @param report_path 建議報告輸出路徑 (TSV，每台機器每個可更新設備一列)
+ * @param threads 並行數 (<=0 使用 CPU 核心數)
+ * @return 建議更新總數, -1=錯誤 (未載入目錄、目錄無法讀取或報告無法寫入)
+ */
+EXPORT int match_fleet_inventories(const char* inventory_dir, const char* report_path, int threads) {
+    if (!inventory_dir || !report_path) return -1;
+
+    std::string error;
+    std::vector<std::string> files;
+    if (!FleetMatcher::ListInventoryFiles(inventory_dir, files, &error)) {
+        AUDIT_LOG("FLEET", error);
+        return -1;
+    }
+
+    std::lock_guard<std::mutex> guard(g_catalogLock);
+    if (g_catalog.Size() == 0) {
+        AUDIT_LOG("FLEET", "No driver catalog loaded");
+        return -1;
+    }
+    std::vector<FleetMachineReport> reports;
+    FleetSummary summary = FleetMatcher(g_catalog, threads).MatchFiles(files, reports);
+    if (!FleetMatcher::WriteReport(report_path, reports, &error)) {
+        AUDIT_LOG("FLEET", error);
+        return -1;
+    }
+    return (int)summary.updates;
+}
+
+/**
+ * [MAIDOS-AUDIT] 線上批次檢查所有設備更新
+ * 整份清單一次 POST；伺服器不支援時改為並行 GET (連線重用、每請求逾時)
+ * @param update_server 更新伺服器URL (批次 POST 到此路徑，逐設備 GET 此路徑 + 設備ID)
+ * @param results 結果陣列
+ * @param max_count 最大數量
+ * @param max_parallel 逐設備模式並行請求上限 (<=0 使用預設值)
+ * @return 實際檢查數量, -1=錯誤
+ */
+EXPORT int check_updates_online(const char* update_server, UpdateResult* results, int max_count, int max_parallel) {
+    if (!update_server || !results || max_count <= 0) return -1;
+    
+    ParsedUrl url;
+    if (!ParsedUrl::Parse(update_server, url)) return -1;
+    std::unique_ptr<IUpdateTransport> transport = CreateUpdateTransport(url);
+    if (!transport) return -1;
+    
+    BatchUpdateChecker checker(DefaultDeviceProvider());
+    if (!checker.Refresh()) return -1;
+    
+    const std::vector<DeviceRecord>& devices = checker.Devices();
+    size_t count = devices.size() < (size_t)max_count ? devices.size() : (size_t)max_count;
+    std::vector<UpdateQuery> queries(count);
+    for (size_t i = 0; i < count; i++) {
+        queries[i].device_id = devices[i].instance_id;
+        queries[i].current_version = devices[i].driver_version;
     }
     
-    SetupDiDestroyDeviceInfoList(devInfo);
-    return count;
+    UpdateClientOptions options;
+    if (max_parallel > 0) options.max_parallel = max_parallel;
+    UpdateCheckClient client(*transport, url.path, options);
+    std::vector<UpdateReply> replies = client.Check(queries);
+    
+    // CheckAll 依列舉順序寫入，與 queries 一一對應
+    size_t next = 0;
+    int written = checker.CheckAll(results, (int)count, [&](const DeviceRecord&) {
+        return replies[next++].latest_version;
+    });
+    for (int i = 0; i < written; i++) {
+        if (!replies[i].ok) results[i].update_status = -1;
+    }
+    return written;
+}
+
+/**
+ * [MAIDOS-AUDIT] 排程背景下載
+ * @param download_url 下載URL
+ * @param save_path 保存路徑
+ * @param expected_sha256 預期 SHA-256 (可為 NULL)
+ * @param priority 0=安全性修補, 1=高, 2=一般, 3=低
+ * @param progress 進度回呼 (可為 NULL)
+ * @return 工作ID (>0), -1=錯誤
+ */
+EXPORT long long schedule_driver_download(const char* download_url, const char* save_path,
+                                          const char* expected_sha256, int priority,
+                                          DownloadProgressCallback progress) {
+    if (!download_url || !save_path) return -1;
+    
+    DownloadJob job;
+    job.url = download_url;
+    job.save_path = save_path;
+    if (expected_sha256) job.expected_sha256 = expected_sha256;
+    job.priority = priority < DOWNLOAD_PRIORITY_CRITICAL ? DOWNLOAD_PRIORITY_CRITICAL :
+                   priority > DOWNLOAD_PRIORITY_LOW ? DOWNLOAD_PRIORITY_LOW : priority;
+    if (progress) {
+        job.on_progress = [progress](uint64_t id, uint64_t done, uint64_t total) {
+            progress((long long)id, done, total);
+        };
+    }
+    uint64_t id = Scheduler(true)->Submit(job);
+    return id > 0 ? (long long)id : -1;
+}
+
+/**
+ * [MAIDOS-AUDIT] 查詢背景下載狀態
+ * @param done 已完成位元組 (可為 NULL)
+ * @param total 總位元組 (可為 NULL)
+ * @param result 完成時的結果: 1=成功, -1=失敗, -2=校驗不符, -3=已取消 (可為 NULL)
+ * 回報已完成 (2) 後工作即被移除，之後查詢回傳 -1
+ * @return 0=排隊中, 1=下載中, 2=已完成, -1=找不到
+ */
+EXPORT int get_download_status(long long job_id, unsigned long long* done, unsigned long long* total, int* result) {
+    std::shared_ptr<DownloadScheduler> scheduler = Scheduler(false);
+    DownloadJobStatus status;
+    if (!scheduler || !scheduler->TakeStatus((uint64_t)job_id, status)) return -1;
+    if (done) *done = status.done;
+    if (total) *total = status.total;
+    if (result) *result = status.state == DOWNLOAD_STATE_FINISHED ? status.result.status : 0;
+    return status.state;
+}
+
+/**
+ * [MAIDOS-AUDIT] 取消背景下載 (執行中者保留續傳狀態)
+ * @return 1=成功, 0=找不到或已完成
+ */
+EXPORT int cancel_driver_download(long long job_id) {
+    std::shared_ptr<DownloadScheduler> scheduler = Scheduler(false);
+    return scheduler && scheduler->Cancel((uint64_t)job_id) ? 1 : 0;
+}
+
+/**
+ * [MAIDOS-AUDIT] 設定下載上限
+ * @param max_active 同時下載數 (<=0 不變)
+ * @param max_per_host 每主機同時下載數 (<=0 不變)
+ * @param bytes_per_sec 全域頻寬上限 (0=不限)
+ */
+EXPORT void set_download_limits(int max_active, int max_per_host, unsigned long long bytes_per_sec) {
+    Scheduler(true)->SetLimits(max_active, max_per_host, bytes_per_sec);
+}
+
+/**
+ * [MAIDOS-AUDIT] 等待所有背景下載完成
+ * @param timeout_ms 逾時 (<0=不限)
+ * @return 1=全部完成, 0=逾時
+ */
+EXPORT int wait_driver_downloads(int timeout_ms) {
+    std::shared_ptr<DownloadScheduler> scheduler = Scheduler(false);
+    return !scheduler || scheduler->WaitAll(timeout_ms) ? 1 : 0;
+}
+
+/**
+ * [MAIDOS-AUDIT] 啟動背景下載排程器 (可重複呼叫)
+ * @return 1=成功
+ */
+EXPORT int start_download_scheduler() {
+    Scheduler(true);
+    return 1;
+}
+
+/**
+ * [MAIDOS-AUDIT] 停止背景下載排程器: 取消全部工作並等待工作執行緒結束
+ * 須於 FreeLibrary 前由應用程式呼叫；不可在 DllMain 或下載回呼中呼叫
+ * @return 1=已停止, 0=尚未啟動
+ */
+EXPORT int shutdown_download_scheduler() {
+    std::shared_ptr<DownloadScheduler> scheduler;
+    {
+        std::lock_guard<std::mutex> guard(g_schedulerLock);
+        scheduler.swap(*g_scheduler);
+    }
+    if (!scheduler) return 0;
+    scheduler->Shutdown();
+    return 1;
 }
@@ -0,0 +1,357 @@
+// [MAIDOS-AUDIT] 內容定址去重備份倉庫測試 (可在 Linux 執行，使用暫存目錄中的樣本檔)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native BackupStoreTest.cpp ../../src/MAIDOS.Driver.Native/backup_store.cpp ../../src/MAIDOS.Driver.Native/lz_codec.cpp ../../src/MAIDOS.Driver.Native/sha256.cpp -o backup_store_test
+// 執行: ./backup_store_test
+
+#include <iostream>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <assert.h>
+#include "backup_store.h"
+#include "lz_codec.h"
+
+namespace fs = std::filesystem;
+
+static std::string RandomBlob(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string s(size, '\0');
+    for (char& c : s) c = (char)(rng() & 0xFF);
+    return s;
+}
+
+// 類似驅動程式二進位: 重複的字串表/結構夾雜亂數 (可壓縮但不是純文字)
+static std::string DriverLikeBlob(size_t size, unsigned seed) {
+    static const char* words[] = { "IoCreateDevice", "KeAcquireSpinLock", "\\Device\\MaidosPort", "PCI\\VEN_8086&DEV_",
+                                   "DriverEntry", "ExAllocatePoolWithTag", "IRP_MJ_READ", "\x48\x8b\xc4\x48\x89\x58\x08" };
+    std::mt19937 rng(seed);
+    std::string s;
+    s.reserve(size);
+    while (s.size() < size) {
+        if (rng() % 3) {
+            s += words[rng() % 8];
+        } else {
+            for (int i = 0, n = 4 + rng() % 24; i < n; i++) s += (char)(rng() & 0xFF);
+        }
+    }
+    s.resize(size);
+    return s;
+}
+
+static std::string ReadAll(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static void WriteAll(const fs::path& path, const std::string& data) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), (std::streamsize)data.size());
+}
+
+static fs::path TempDir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+// 兩個目錄樹內容完全相同
+static bool SameTree(const fs::path& a, const fs::path& b) {
+    std::set<std::string> names_a, names_b;
+    for (auto& e : fs::recursive_directory_iterator(a)) {
+        if (e.is_regular_file()) names_a.insert(e.path().lexically_relative(a).generic_string());
+    }
+    for (auto& e : fs::recursive_directory_iterator(b)) {
+        if (e.is_regular_file()) names_b.insert(e.path().lexically_relative(b).generic_string());
+    }
+    if (names_a != names_b) return false;
+    for (const std::string& n : names_a) {
+        if (ReadAll(a / n) != ReadAll(b / n)) return false;
+    }
+    return true;
+}
+
+// 模擬 pnputil 匯出的驅動目錄: 每個套件一個子目錄 (inf/cat/sys/dll)
+static void MakeDriverTree(const fs::path& dir, int packages, size_t sys_size) {
+    for (int p = 0; p < packages; p++) {
+        fs::path pkg = dir / ("oem" + std::to_string(p) + ".inf_amd64_" + std::to_string(1000 + p));
+        std::string inf = "[Version]\r\nSignature=\"$WINDOWS NT$\"\r\nClass=Net\r\nDriverVer=01/02/2024,1.0." +
+                          std::to_string(p) + "\r\n[Manufacturer]\r\n%MAIDOS%=Models,NTamd64\r\n";
+        for (int i = 0; i < 200; i++) inf += "%Dev" + std::to_string(i) + "%=Install,PCI\\VEN_8086&DEV_" + std::to_string(1500 + i) + "\r\n";
+        WriteAll(pkg / ("oem" + std::to_string(p) + ".inf"), inf);
+        WriteAll(pkg / "driver.cat", RandomBlob(8 * 1024, 100 + p));
+        WriteAll(pkg / "driver.sys", DriverLikeBlob(sys_size, 200 + p));
+        // 所有套件共用同一個執行階段 DLL (跨套件去重)
+        WriteAll(pkg / "bin" / "maidos_runtime.dll", DriverLikeBlob(300 * 1024, 7));
+    }
+    WriteAll(dir / "empty.txt", "");
+}
+
+static uint64_t StoreBytes(const fs::path& root) {
+    uint64_t total = 0;
+    for (auto& e : fs::recursive_directory_iterator(root / "chunks")) {
+        if (e.is_regular_file()) total += e.file_size();
+    }
+    return total;
+}
+
+void TestLzCodec() {
+    std::vector<std::string> samples = { "", "a", "abcdabcdabcdabcdabcdabcd", std::string(100000, 'z'),
+                                         RandomBlob(70000, 1), DriverLikeBlob(200000, 2) };
+    for (int n = 0; n < 40; n++) samples.push_back(DriverLikeBlob(n, 3 + n));
+
+    for (const std::string& s : samples) {
+        std::vector<uint8_t> packed;
+        LzCompress((const uint8_t*)s.data(), s.size(), packed);
+        std::string back(s.size(), '\0');
+        assert(LzDecompress(packed.data(), packed.size(), (uint8_t*)&back[0], s.size()));
+        assert(back == s);
+        // 大小不符與截斷皆須偵測
+        if (!s.empty()) {
+            assert(!LzDecompress(packed.data(), packed.size(), (uint8_t*)&back[0], s.size() - 1));
+            if (packed.size() > 1) assert(!LzDecompress(packed.data(), packed.size() - 1, (uint8_t*)&back[0], s.size()));
+        }
+    }
+
+    std::vector<uint8_t> packed;
+    size_t driver = LzCompress((const uint8_t*)samples[5].data(), samples[5].size(), packed);
+    packed.clear();
+    size_t zeros = LzCompress((const uint8_t*)samples[3].data(), samples[3].size(), packed);
+    assert(driver < samples[5].size() / 2 && zeros < 1000);
+
+    // 任意垃圾輸入不可越界
+    std::vector<uint8_t> out(4096);
+    for (unsigned seed = 0; seed < 2000; seed++) {
+        std::string junk = RandomBlob(1 + seed % 64, seed);
+        LzDecompress((const uint8_t*)junk.data(), junk.size(), out.data(), out.size());
+    }
+    std::cout << "[TEST] LZ codec round-trips; driver-like " << samples[5].size() << " -> " << driver << " bytes." << std::endl;
+}
+
+static std::vector<std::string> ChunksOf(const ContentChunker& chunker, const std::string& data) {
+    std::vector<std::string> chunks;
+    for (size_t pos = 0; pos < data.size();) {
+        size_t cut = chunker.FindCut((const uint8_t*)data.data() + pos, data.size() - pos);
+        chunks.push_back(data.substr(pos, cut));
+        pos += cut;
+    }
+    return chunks;
+}
+
+void TestChunkerBoundariesSurviveInsert() {
+    ContentChunker chunker;
+    std::string data = RandomBlob(8 * 1024 * 1024, 11);
+    std::vector<std::string> before = ChunksOf(chunker, data);
+
+    size_t total = 0;
+    for (size_t i = 0; i < before.size(); i++) {
+        assert(before[i].size() <= chunker.Params().max_size);
+        if (i + 1 < before.size()) assert(before[i].size() > chunker.Params().min_size);
+        total += before[i].size();
+    }
+    assert(total == data.size());
+    size_t avg = data.size() / before.size();
+    assert(avg > 40 * 1024 && avg < 100 * 1024);
+
+    // 中段插入 100 位元組: 只有附近區塊改變
+    std::string edited = data.substr(0, 3 * 1024 * 1024) + RandomBlob(100, 12) + data.substr(3 * 1024 * 1024);
+    std::vector<std::string> after = ChunksOf(chunker, edited);
+    std::set<std::string> old_set(before.begin(), before.end());
+    size_t changed = 0;
+    for (const std::string& c : after) changed += old_set.count(c) ? 0 : 1;
+    assert(changed <= 3);
+    std::cout << "[TEST] " << before.size() << " chunks (avg " << avg / 1024 << " KB); insert changed " << changed
+              << " chunks." << std::endl;
+}
+
+void TestBackupRestoreRoundTrip() {
+    fs::path source = TempDir("maidos_bs_src");
+    fs::path root = TempDir("maidos_bs_store");
+    fs::path restore = TempDir("maidos_bs_restore");
+    MakeDriverTree(source, 6, 700 * 1024);
+
+    BackupStore store(root.string());
+    assert(store.Open());
+    BackupStats stats;
+    std::string error;
+    assert(store.Backup(source.string(), "full-1", BackupOptions(), &stats, &error));
+    assert(stats.files == 6 * 4 + 1 && stats.unchanged_files == 0);
+    assert(stats.bytes_read == stats.bytes_total);
+    // 6 份相同的 runtime DLL 只存一次，且壓縮後更小
+    assert(stats.new_bytes <= stats.bytes_total - 5 * 300 * 1024);
+    assert(stats.stored_bytes < stats.new_bytes * 3 / 4);
+    assert(StoreBytes(root) == stats.stored_bytes);
+
+    assert(store.Restore("full-1", restore.string(), &error));
+    assert(SameTree(source, restore));
+    assert(fs::exists(restore / "empty.txt") && fs::file_size(restore / "empty.txt") == 0);
+
+    BackupManifest manifest;
+    assert(store.LoadManifest("full-1", manifest));
+    assert(manifest.name == "full-1" && manifest.files.size() == stats.files);
+    assert(manifest.TotalBytes() == stats.bytes_total);
+    assert(fs::file_size(root / "manifests" / "full-1") < 16 * 1024);
+
+    // 同樣內容再備份一次 (不指定基準): 讀取全部但無新區塊
+    BackupStats again;
+    assert(store.Backup(source.string(), "full-2", BackupOptions(), &again));
+    assert(again.new_chunks == 0 && again.stored_bytes == 0 && again.chunks == stats.chunks);
+
+    // 重新開啟倉庫沿用既有區塊索引
+    BackupStore reopened(root.string());
+    assert(reopened.Open());
+    assert(reopened.ChunkCount() == store.ChunkCount());
+    assert(reopened.ListBackups() == std::vector<std::string>({ "full-1", "full-2" }));
+    for (const fs::path& dir : { source, root, restore }) fs::remove_all(dir);
+    std::cout << "[TEST] " << stats.bytes_total << " bytes backed up as " << stats.new_chunks << " chunks, "
+              << stats.stored_bytes << " bytes stored; restore identical." << std::endl;
+}
+
+void TestIncrementalCostsChangedBytes() {
+    fs::path source = TempDir("maidos_bs_inc_src");
+    fs::path root = TempDir("maidos_bs_inc_store");
+    fs::path restore = TempDir("maidos_bs_inc_restore");
+    MakeDriverTree(source, 8, 1024 * 1024);
+
+    BackupStore store(root.string());
+    assert(store.Open());
+    BackupStats base;
+    assert(store.Backup(source.string(), "base", BackupOptions(), &base));
+
+    // 一個驅動更新: driver.sys 中段插入一段修補，並新增一個套件
+    fs::path sys = source / "oem3.inf_amd64_1003" / "driver.sys";
+    std::string content = ReadAll(sys);
+    std::string patch = RandomBlob(4096, 99);
+    WriteAll(sys, content.substr(0, 400 * 1024) + patch + content.substr(400 * 1024));
+    fs::last_write_time(sys, fs::last_write_time(sys) + std::chrono::seconds(5));
+    WriteAll(source / "oem9.inf_amd64_2000" / "oem9.inf", "[Version]\r\nClass=Display\r\n");
+
+    BackupOptions options;
+    options.parent = "base";
+    BackupStats inc;
+    assert(store.Backup(source.string(), "inc", options, &inc));
+    assert(inc.files == base.files + 1);
+    assert(inc.unchanged_files == base.files - 1);
+    assert(inc.bytes_read == content.size() + patch.size() + 26);
+    // 只有插入點附近的區塊是新的
+    assert(inc.new_bytes < patch.size() + 3 * 256 * 1024);
+    assert(inc.new_bytes * 4 < inc.bytes_read);
+
+    assert(store.Restore("inc", restore.string()));
+    assert(SameTree(source, restore));
+    BackupManifest manifest;
+    assert(store.LoadManifest("inc", manifest) && manifest.parent == "base");
+    for (const fs::path& dir : { source, root, restore }) fs::remove_all(dir);
+    std::cout << "[TEST] Incremental backup read " << inc.bytes_read << " of " << inc.bytes_total << " bytes, stored "
+              << inc.new_bytes << " new bytes." << std::endl;
+}
+
+void TestPruneAndCorruption() {
+    fs::path a = TempDir("maidos_bs_prune_a");
+    fs::path b = TempDir("maidos_bs_prune_b");
+    fs::path root = TempDir("maidos_bs_prune_store");
+    fs::path restore = TempDir("maidos_bs_prune_restore");
+    WriteAll(a / "shared.sys", DriverLikeBlob(500 * 1024, 1));
+    WriteAll(a / "only_a.sys", RandomBlob(200 * 1024, 2));
+    WriteAll(b / "shared.sys", DriverLikeBlob(500 * 1024, 1));
+    WriteAll(b / "only_b.sys", RandomBlob(200 * 1024, 3));
+
+    BackupStore store(root.string());
+    assert(store.Open());
+    BackupStats sa, sb;
+    assert(store.Backup(a.string(), "a", BackupOptions(), &sa));
+    assert(store.Backup(b.string(), "b", BackupOptions(), &sb));
+    assert(sb.new_chunks < sb.chunks);
+    size_t before = store.ChunkCount();
+
+    assert(store.Prune() == 0);
+    assert(store.Remove("a") && !store.Remove("a"));
+    size_t removed = store.Prune();
+    assert(removed > 0 && store.ChunkCount() == before - removed);
+    assert(store.Restore("b", restore.string()));
+    assert(SameTree(b, restore));
+
+    // 損毀的區塊在還原時被偵測
+    BackupManifest manifest;
+    assert(store.LoadManifest("b", manifest));
+    const std::string& id = manifest.files[0].chunks[0].id;
+    fs::path chunk = root / "chunks" / id.substr(0, 2) / id;
+    std::string raw = ReadAll(chunk);
+    raw[raw.size() / 2] ^= 0x40;
+    WriteAll(chunk, raw);
+    std::string error;
+    assert(!store.Restore("b", TempDir("maidos_bs_prune_bad").string(), &error));
+    assert(error.find(id) != std::string::npos);
+
+    // 名稱與參數驗證
+    assert(!store.Backup(a.string(), "../escape", BackupOptions(), nullptr, &error));
+    BackupOptions missing;
+    missing.parent = "nope";
+    assert(!store.Backup(a.string(), "c", missing, nullptr, &error));
+    assert(!store.Restore("nope", restore.string(), &error));
+    for (const fs::path& dir : { a, b, root, restore, fs::temp_directory_path() / "maidos_bs_prune_bad" }) fs::remove_all(dir);
+    std::cout << "[TEST] Prune removed " << removed << " unreferenced chunks; corruption detected." << std::endl;
+}
+
+void BenchBackup() {
+    fs::path source = TempDir("maidos_bs_bench_src");
+    MakeDriverTree(source, 24, 4 * 1024 * 1024);
+    uint64_t bytes = 0;
+    for (auto& e : fs::recursive_directory_iterator(source)) {
+        if (e.is_regular_file()) bytes += e.file_size();
+    }
+
+    auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+        return (long long)std::chrono::duration_cast<std::chrono::milliseconds>(b - a).count();
+    };
+    std::ostringstream line;
+    line << "[BENCH] tree=" << bytes / (1024 * 1024) << "MB";
+    int cores = (int)std::thread::hardware_concurrency();
+    for (int threads : { 1, cores > 1 ? cores : 2 }) {
+        fs::path root = TempDir("maidos_bs_bench_store");
+        BackupStore store(root.string());
+        assert(store.Open());
+        BackupOptions options;
+        options.threads = threads;
+        BackupStats stats;
+        auto a = std::chrono::steady_clock::now();
+        assert(store.Backup(source.string(), "full", options, &stats));
+        auto b = std::chrono::steady_clock::now();
+        line << " full/t" << threads << "=" << ms(a, b) << "ms";
+
+        if (threads > 1) {
+            options.parent = "full";
+            BackupStats inc;
+            a = std::chrono::steady_clock::now();
+            assert(store.Backup(source.string(), "inc", options, &inc));
+            b = std::chrono::steady_clock::now();
+            line << " unchanged-incremental=" << ms(a, b) << "ms stored=" << stats.stored_bytes / (1024 * 1024) << "MB";
+            fs::path restore = TempDir("maidos_bs_bench_restore");
+            a = std::chrono::steady_clock::now();
+            assert(store.Restore("inc", restore.string()));
+            b = std::chrono::steady_clock::now();
+            line << " restore=" << ms(a, b) << "ms";
+            fs::remove_all(restore);
+        }
+        fs::remove_all(root);
+    }
+    fs::remove_all(source);
+    std::cout << line.str() << std::endl;
+}
+
+int main() {
+    std::cout << "Starting MAIDOS Backup Store Tests..." << std::endl;
+    TestLzCodec();
+    TestChunkerBoundariesSurviveInsert();
+    TestBackupRestoreRoundTrip();
+    TestIncrementalCostsChangedBytes();
+    TestPruneAndCorruption();
+
+    BenchBackup();
+    std::cout << "All Backup Store Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,174 @@
+// [MAIDOS-AUDIT] 驅動目錄比對引擎測試 (可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native CatalogTest.cpp ../../src/MAIDOS.Driver.Native/driver_catalog.cpp ../../src/MAIDOS.Driver.Native/update_check.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o catalog_test
+// 執行: ./catalog_test [drivers.tsv 路徑]
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <assert.h>
+#include "driver_catalog.h"
+#include "driver_version.h"
+#include "update_check.h"
+
+void TestVersionCompare() {
+    assert(CompareDriverVersions("31.0.101.5186", "31.0.101.999") > 0);
+    assert(CompareDriverVersions("551.86", "552.12") < 0);
+    assert(CompareDriverVersions("1.2", "1.2.0") == 0);
+    assert(CompareDriverVersions("10.0", "9.9.9") > 0);
+    assert(CompareDriverVersions("6.0.9561.1", "6.0.9561.01") == 0);
+    assert(CompareDriverVersions("24.1.1", "24.1.1") == 0);
+    assert(CompareDriverVersions("1.0b", "1.0a") > 0);
+    assert(CompareDriverVersions("99999999999999999999.1", "99999999999999999998.9") > 0);
+    std::cout << "[TEST] Versions compare as numeric tuples." << std::endl;
+}
+
+void TestHardwareIdParse() {
+    HardwareIdKey k = HardwareIdKey::Parse("pci\\ven_10de&dev_2684&subsys_16F310DE&rev_A1");
+    assert(k.has_ven_dev && k.ven == 0x10DE && k.dev == 0x2684);
+    assert(k.has_subsys && k.subsys == 0x16F310DE);
+    assert(k.has_rev && k.rev == 0xA1);
+    assert(k.Specificity() == 4);
+
+    HardwareIdKey generic = HardwareIdKey::Parse("PCI\\VEN_10DE&DEV_2684");
+    assert(generic.Covers(k));
+    assert(!k.Covers(generic));
+
+    // 實例ID尾段被忽略
+    HardwareIdKey inst = HardwareIdKey::Parse("PCI\\VEN_10DE&DEV_2684\\4&1A2B3C&0&0008");
+    assert(generic.Covers(inst));
+
+    // 匯流排不同不匹配
+    assert(!generic.Covers(HardwareIdKey::Parse("HDAUDIO\\VEN_10DE&DEV_2684")));
+
+    // USB VID/PID、無 VEN/DEV 的ID
+    HardwareIdKey usb = HardwareIdKey::Parse("USB\\VID_046D&PID_C52B&REV_1203");
+    assert(usb.has_ven_dev && usb.ven == 0x046D && usb.dev == 0xC52B && usb.rev == 0x1203);
+    HardwareIdKey acpi = HardwareIdKey::Parse("ACPI\\PNP0A08");
+    assert(!acpi.has_ven_dev && acpi.Covers(HardwareIdKey::Parse("acpi\\pnp0a08")));
+    std::cout << "[TEST] Hardware IDs normalize to VEN/DEV/SUBSYS/REV." << std::endl;
+}
+
+void TestLoadRepositoryCatalog(const char* path) {
+    DriverCatalog catalog;
+    std::string error;
+    if (!catalog.LoadTsv(path, &error)) {
+        std::cout << "[SKIP] " << error << std::endl;
+        return;
+    }
+    assert(catalog.Size() >= 27);
+
+    DeviceRecord gpu;
+    gpu.hardware_ids = { "PCI\\VEN_10DE&DEV_2684&SUBSYS_16F310DE&REV_A1", "PCI\\VEN_10DE&DEV_2684&SUBSYS_16F310DE",
+                         "PCI\\VEN_10DE&DEV_2684&REV_A1", "PCI\\VEN_10DE&DEV_2684" };
+    gpu.compatible_ids = { "PCI\\VEN_10DE&CC_030000", "PCI\\CC_0300" };
+    gpu.driver_version = "546.33";
+
+    CatalogMatch m;
+    assert(catalog.Match(gpu, m));
+    assert(m.entry->driver_id == "DRV_NV_RTX4090");
+    assert(m.update_available);
+
+    // 目錄版本較舊: 不建議降級
+    gpu.driver_version = "560.94";
+    assert(catalog.Match(gpu, m));
+    assert(!m.update_available);
+
+    DeviceRecord audio;
+    audio.hardware_ids = { "HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897&SUBSYS_18491897&REV_1003", "HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897" };
+    assert(catalog.Match(audio, m));
+    assert(m.entry->driver_id == "DRV_RTK_ALC897");
+    std::cout << "[TEST] drivers.tsv loaded (" << catalog.Size() << " entries) and matched." << std::endl;
+}
+
+void TestRanking() {
+    DriverCatalog catalog;
+    catalog.ParseTsv(
+        "# driver_id\tname\tversion\tmanufacturer\tdevice_ids\tdownload_url\tchecksum\tscore\n"
+        "GENERIC\tGeneric\t9.0\tX\tPCI\\VEN_1234&DEV_0001\t\tVERIFY_ON_DOWNLOAD\t99\n"
+        "OEM\tOEM\t2.0\tX\tPCI\\VEN_1234&DEV_0001&SUBSYS_00011234\t\tVERIFY_ON_DOWNLOAD\t10\n"
+        "CLASS\tClass\t50.0\tX\tPCI\\CC_0300\t\tVERIFY_ON_DOWNLOAD\t100\n"
+        "OLD\tOld\t1.0\tX\tPCI\\VEN_1234&DEV_0002;PCI\\VEN_1234&DEV_0003\t\tVERIFY_ON_DOWNLOAD\t50\n"
+        "NEW\tNew\t1.1\tX\tPCI\\VEN_1234&DEV_0002\t\tVERIFY_ON_DOWNLOAD\t50\n"
+        "short\tline\n");
+    assert(catalog.Size() == 5);
+
+    DeviceRecord d;
+    d.hardware_ids = { "PCI\\VEN_1234&DEV_0001&SUBSYS_00011234", "PCI\\VEN_1234&DEV_0001" };
+    d.compatible_ids = { "PCI\\CC_0300" };
+    CatalogMatch m;
+
+    // 第一個硬體ID最優先 (即使分數較低)
+    assert(catalog.Match(d, m) && m.entry->driver_id == "OEM" && m.rank == 0);
+
+    // 同一硬體ID位置: 更具體的目錄ID優先
+    d.hardware_ids = { "PCI\\VEN_1234&DEV_0001&SUBSYS_00011234&REV_01" };
+    assert(catalog.Match(d, m) && m.entry->driver_id == "OEM" && m.specificity == 3);
+
+    // 只有相容ID匹配
+    d.hardware_ids = { "PCI\\VEN_9999&DEV_0001" };
+    assert(catalog.Match(d, m) && m.entry->driver_id == "CLASS" && m.rank >= 0x1000);
+
+    // 同分數同具體程度: 較新版本優先；一筆記錄多個ID
+    d.hardware_ids = { "PCI\\VEN_1234&DEV_0002" };
+    d.compatible_ids.clear();
+    assert(catalog.Match(d, m) && m.entry->driver_id == "NEW");
+    d.hardware_ids = { "PCI\\VEN_1234&DEV_0003" };
+    assert(catalog.Match(d, m) && m.entry->driver_id == "OLD");
+
+    d.hardware_ids = { "PCI\\VEN_FFFF&DEV_FFFF" };
+    assert(!catalog.Match(d, m) && m.entry == nullptr);
+    std::cout << "[TEST] Matches rank by ID position, specificity, score, version." << std::endl;
+}
+
+void TestUpdateCheckWithCatalog() {
+    DriverCatalog catalog = DriverCatalog::Synthetic(100000);
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(100));
+    BatchUpdateChecker checker(provider);
+    assert(checker.Refresh());
+
+    LatestVersionLookup latest = [&](const DeviceRecord& d) {
+        CatalogMatch m;
+        return catalog.Match(d, m) ? m.entry->version : std::string();
+    };
+    std::vector<UpdateResult> results(100);
+    assert(checker.CheckAll(results.data(), 100, latest) == 100);
+
+    for (int i = 0; i < 100; i++) {
+        CatalogMatch m;
+        assert(catalog.Match(checker.Devices()[i], m));
+        bool newer = CompareDriverVersions(m.entry->version, checker.Devices()[i].driver_version) > 0;
+        assert(results[i].update_available == (newer ? 1 : 0));
+    }
+    std::cout << "[TEST] Batch update check uses catalog versions." << std::endl;
+}
+
+void BenchMatchInventory(size_t catalogSize, size_t devices) {
+    auto t0 = std::chrono::steady_clock::now();
+    DriverCatalog catalog = DriverCatalog::Synthetic(catalogSize);
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<DeviceRecord> inventory = FakeDeviceProvider::Synthetic(devices);
+    std::vector<CatalogMatch> matches;
+    auto t2 = std::chrono::steady_clock::now();
+    size_t matched = catalog.MatchAll(inventory, matches);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    std::cout << "[BENCH] catalog=" << catalogSize << " build=" << us(t0, t1) << "us"
+              << " devices=" << devices << " matched=" << matched
+              << " match=" << us(t2, t3) << "us" << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "Starting MAIDOS Catalog Tests..." << std::endl;
+    TestVersionCompare();
+    TestHardwareIdParse();
+    TestLoadRepositoryCatalog(argc > 1 ? argv[1] : "../../data/drivers.tsv");
+    TestRanking();
+    TestUpdateCheckWithCatalog();
+
+    BenchMatchInventory(100000, 250);
+    BenchMatchInventory(100000, 10000);
+    std::cout << "All Catalog Tests Passed!" << std::endl;
+    return 0;
+}
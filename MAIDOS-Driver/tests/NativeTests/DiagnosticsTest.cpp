@@ -0,0 +1,223 @@
+// [MAIDOS-AUDIT] 批次設備診斷測試 (假設備樹，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native DiagnosticsTest.cpp ../../src/MAIDOS.Driver.Native/device_diagnostics.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o diagnostics_test
+// 執行: ./diagnostics_test [設備數量]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <assert.h>
+#include "device_diagnostics.h"
+
+static DeviceRecord Device(const std::string& id, uint32_t status, uint32_t problem = 0) {
+    DeviceRecord d;
+    d.instance_id = id;
+    d.status = status;
+    d.problem_code = problem;
+    return d;
+}
+
+static DeviceResource Resource(uint32_t type, uint64_t start, uint64_t end, uint32_t flags = 0) {
+    DeviceResource r;
+    r.type = type;
+    r.flags = flags;
+    r.start = start;
+    r.end = end;
+    return r;
+}
+
+// ROOT -> PCI 根橋 -> {故障橋 -> {顯示卡(43), 網卡(未啟動)}, 音效(28), 停用的序列埠(22), 正常 USB}
+static FakeDeviceProvider MakeTree() {
+    const uint32_t ok = DEVICE_STATUS_STARTED;
+    const uint32_t bad = DEVICE_STATUS_HAS_PROBLEM;
+    FakeDeviceProvider provider({
+        Device("HTREE\\ROOT\\0", ok),
+        Device("ACPI\\PNP0A08\\0", ok),
+        Device("PCI\\VEN_8086&DEV_A340\\3&11583659&0&E0", bad, DEVICE_PROBLEM_FAILED_START),
+        Device("PCI\\VEN_10DE&DEV_2684\\4&1A2B3C&0&0008", bad, DEVICE_PROBLEM_CODE43),
+        Device("PCI\\VEN_10EC&DEV_8168\\4&1A2B3C&0&0010", 0),
+        Device("HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897\\5&2C", bad, DEVICE_PROBLEM_FAILED_INSTALL),
+        Device("ACPI\\PNP0501\\1", bad | DEVICE_STATUS_DISABLED, DEVICE_PROBLEM_DISABLED),
+        Device("USB\\ROOT_HUB30\\5&ABC&0&0", ok),
+    });
+    provider.SetNode("ACPI\\PNP0A08\\0", "HTREE\\ROOT\\0");
+    provider.SetNode("PCI\\VEN_8086&DEV_A340\\3&11583659&0&E0", "ACPI\\PNP0A08\\0",
+                     { Resource(DEVICE_RESOURCE_IRQ, 16, 16, DEVICE_RESOURCE_SHARED) });
+    // 父節點ID大小寫與列舉結果不同
+    provider.SetNode("PCI\\VEN_10DE&DEV_2684\\4&1A2B3C&0&0008", "pci\\ven_8086&dev_a340\\3&11583659&0&e0",
+                     { Resource(DEVICE_RESOURCE_MEMORY, 0xF6000000, 0xF6FFFFFF),
+                       Resource(DEVICE_RESOURCE_MEMORY, 0xE0000000, 0xEFFFFFFF),
+                       Resource(DEVICE_RESOURCE_IO, 0xE000, 0xE07F),
+                       Resource(DEVICE_RESOURCE_IRQ, 0xFFFFFFFA, 0xFFFFFFFA, DEVICE_RESOURCE_SHARED) });
+    provider.SetNode("PCI\\VEN_10EC&DEV_8168\\4&1A2B3C&0&0010", "PCI\\VEN_8086&DEV_A340\\3&11583659&0&E0");
+    provider.SetNode("HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897\\5&2C", "ACPI\\PNP0A08\\0",
+                     { Resource(DEVICE_RESOURCE_DMA, 3, 3) });
+    provider.SetNode("ACPI\\PNP0501\\1", "ACPI\\PNP0A08\\0");
+    provider.SetNode("USB\\ROOT_HUB30\\5&ABC&0&0", "ACPI\\PNP0A08\\0", { Resource(DEVICE_RESOURCE_IRQ, 16, 16, DEVICE_RESOURCE_SHARED) });
+    return provider;
+}
+
+void TestRules() {
+    FakeDeviceProvider provider = MakeTree();
+    DiagnosticsReport report;
+    assert(RunDeviceDiagnostics(provider, report));
+    assert(provider.EnumerationCount() == 1);
+    assert(report.nodes.size() == 8 && report.diagnoses.size() == 8);
+
+    auto at = [&](const char* id) -> const DeviceDiagnosis& {
+        int row = report.Find(id);
+        assert(row >= 0);
+        return report.diagnoses[row];
+    };
+    int root = report.Find("HTREE\\ROOT\\0");
+    int bridge = report.Find("PCI\\VEN_8086&DEV_A340\\3&11583659&0&E0");
+
+    assert(at("HTREE\\ROOT\\0").severity == DIAG_SEVERITY_OK && at("HTREE\\ROOT\\0").root_cause == -1);
+    assert(at("HTREE\\ROOT\\0").parent == -1);
+    assert(at("ACPI\\PNP0A08\\0").parent == root);
+
+    const DeviceDiagnosis& b = at("PCI\\VEN_8086&DEV_A340\\3&11583659&0&E0");
+    assert(b.severity == DIAG_SEVERITY_ERROR && b.findings == DIAG_FINDING_PROBLEM && b.root_cause == bridge);
+
+    // 下游設備的根因指向故障橋
+    const DeviceDiagnosis& gpu = at("PCI\\VEN_10DE&DEV_2684\\4&1A2B3C&0&0008");
+    assert(gpu.parent == bridge);
+    assert(gpu.severity == DIAG_SEVERITY_ERROR);
+    assert(gpu.findings == (DIAG_FINDING_PROBLEM | DIAG_FINDING_PARENT_FAILED) && gpu.root_cause == bridge);
+    const DeviceDiagnosis& nic = at("PCI\\VEN_10EC&DEV_8168\\4&1A2B3C&0&0010");
+    assert(nic.findings == (DIAG_FINDING_NOT_STARTED | DIAG_FINDING_PARENT_FAILED) && nic.root_cause == bridge);
+
+    const DeviceDiagnosis& audio = at("HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897\\5&2C");
+    assert(audio.severity == DIAG_SEVERITY_WARNING && (audio.findings & DIAG_FINDING_DRIVER_MISSING));
+    assert(audio.root_cause == report.Find("HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897\\5&2C"));
+
+    const DeviceDiagnosis& serial = at("ACPI\\PNP0501\\1");
+    assert(serial.severity == DIAG_SEVERITY_INFO && (serial.findings & DIAG_FINDING_DISABLED));
+
+    assert(at("USB\\ROOT_HUB30\\5&ABC&0&0").findings == 0);
+    assert(report.CountAtLeast(DIAG_SEVERITY_ERROR) == 2);
+    assert(report.CountAtLeast(DIAG_SEVERITY_WARNING) == 3);
+    assert(report.CountAtLeast(DIAG_SEVERITY_INFO) == 5);
+    std::cout << "[TEST] Rules: severity, driver missing, disabled, root cause through the tree." << std::endl;
+}
+
+void TestCycleAndMissingParent() {
+    FakeDeviceProvider provider({ Device("A", DEVICE_STATUS_HAS_PROBLEM, 10), Device("B", DEVICE_STATUS_HAS_PROBLEM, 10),
+                                  Device("C", DEVICE_STATUS_STARTED), Device("D", DEVICE_STATUS_HAS_PROBLEM, 43) });
+    provider.SetNode("A", "B");
+    provider.SetNode("B", "A");
+    provider.SetNode("C", "C");
+    provider.SetNode("D", "GONE\\0");
+    DiagnosticsReport report;
+    assert(RunDeviceDiagnostics(provider, report));
+    assert(report.diagnoses[0].parent == 1 && report.diagnoses[1].parent == 0);
+    assert(report.diagnoses[0].root_cause >= 0 && report.diagnoses[1].root_cause >= 0);
+    assert(report.diagnoses[2].parent == -1);
+    assert(report.diagnoses[3].parent == -1 && report.diagnoses[3].root_cause == 3);
+
+    provider.SetFailure(true);
+    std::string error;
+    assert(!RunDeviceDiagnostics(provider, report, &error) && !error.empty());
+    std::cout << "[TEST] Cyclic and dangling parents terminate." << std::endl;
+}
+
+void TestBlobRoundTrip() {
+    FakeDeviceProvider provider = MakeTree();
+    DiagnosticsReport report;
+    assert(RunDeviceDiagnostics(provider, report));
+
+    size_t needed = 0;
+    assert(EncodeDiagnosticsBlob(report, nullptr, 0, &needed) == 0);
+    std::vector<uint8_t> blob(needed, 0xCD);
+    assert(EncodeDiagnosticsBlob(report, blob.data(), needed - 1, nullptr) == 0 && blob[0] == 0xCD);
+    assert(EncodeDiagnosticsBlob(report, blob.data(), blob.size(), nullptr) == needed);
+
+    DiagBlobView view;
+    assert(view.Open(blob.data(), blob.size()));
+    assert(view.Count() == report.nodes.size());
+    size_t resources = 0;
+    for (uint32_t i = 0; i < view.Count(); i++) {
+        const DiagBlobRecord& r = view.Record(i);
+        const DeviceNode& n = report.nodes[i];
+        const DeviceDiagnosis& d = report.diagnoses[i];
+        assert(view.String(r.instance_id) == n.instance_id);
+        assert(r.parent == d.parent && r.root_cause == d.root_cause);
+        assert(r.severity == d.severity && r.findings == d.findings);
+        assert(r.status == n.status && r.problem_code == n.problem_code);
+        assert(r.resource_count == n.resources.size());
+        for (uint32_t k = 0; k < r.resource_count; k++) {
+            const DiagBlobResource& res = view.Resource(r.first_resource + k);
+            assert(res.type == n.resources[k].type && res.flags == n.resources[k].flags);
+            assert(res.start == n.resources[k].start && res.end == n.resources[k].end);
+        }
+        resources += r.resource_count;
+    }
+    assert(resources == 7);
+
+    for (size_t size = 0; size < blob.size(); size++) assert(!view.Open(blob.data(), size));
+    std::vector<uint8_t> bad = blob;
+    DiagBlobHeader header;
+    memcpy(&header, bad.data(), sizeof(header));
+    DiagBlobRecord record;
+    memcpy(&record, bad.data() + header.records_offset, sizeof(record));
+    record.parent = 1000;
+    memcpy(bad.data() + header.records_offset, &record, sizeof(record));
+    assert(!view.Open(bad.data(), bad.size()));
+
+    bad = blob;
+    record.parent = -1;
+    record.resource_count = 100;
+    memcpy(bad.data() + header.records_offset, &record, sizeof(record));
+    assert(!view.Open(bad.data(), bad.size()));
+    std::cout << "[TEST] Blob round-trip (" << blob.size() << " bytes) and corruption rejected." << std::endl;
+}
+
+void BenchDiagnostics(size_t devices) {
+    // 合成樹: 每 16 個設備掛在一個橋下，每 97 個設備有一個故障
+    std::vector<DeviceRecord> records = FakeDeviceProvider::Synthetic(devices);
+    for (size_t i = 0; i < records.size(); i++) {
+        if (i % 97 == 0) {
+            records[i].status = DEVICE_STATUS_HAS_PROBLEM;
+            records[i].problem_code = DEVICE_PROBLEM_CODE43;
+        }
+    }
+    FakeDeviceProvider provider(records);
+    for (size_t i = 0; i < records.size(); i++) {
+        provider.SetNode(records[i].instance_id, i % 16 ? records[i - i % 16].instance_id : std::string(),
+                         { Resource(DEVICE_RESOURCE_MEMORY, 0xF0000000 + i * 0x1000, 0xF0000FFF + i * 0x1000),
+                           Resource(DEVICE_RESOURCE_IRQ, 16 + i % 8, 16 + i % 8, DEVICE_RESOURCE_SHARED) });
+    }
+
+    const int rounds = 10;
+    DiagnosticsReport report;
+    std::vector<uint8_t> blob;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) {
+        assert(RunDeviceDiagnostics(provider, report));
+        size_t needed = 0;
+        EncodeDiagnosticsBlob(report, nullptr, 0, &needed);
+        blob.resize(needed);
+        assert(EncodeDiagnosticsBlob(report, blob.data(), blob.size(), nullptr) == needed);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    assert(provider.EnumerationCount() == (uint64_t)rounds);
+
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() / rounds;
+    std::ostringstream line;
+    line << "[BENCH] devices=" << devices << " enumerations=1 per run"
+         << " diagnose+encode=" << us << "us blob=" << blob.size() << "B"
+         << " errors=" << report.CountAtLeast(DIAG_SEVERITY_ERROR)
+         << " (per-device API: " << devices * 2 << " FFI calls / CM_Locate_DevNode)";
+    std::cout << line.str() << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Device Diagnostics Test Suite ===" << std::endl;
+    TestRules();
+    TestCycleAndMissingParent();
+    TestBlobRoundTrip();
+    BenchDiagnostics(argc > 1 ? (size_t)atoi(argv[1]) : 5000);
+    std::cout << "All Diagnostics Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,305 @@
+// [MAIDOS-AUDIT] 分塊並行下載引擎測試 (可在 Linux 執行，使用本機 HTTP 伺服器)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native DownloadTest.cpp ../../src/MAIDOS.Driver.Native/download_engine.cpp ../../src/MAIDOS.Driver.Native/sha256.cpp ../../src/MAIDOS.Driver.Native/update_client.cpp -o download_test
+// 執行: ./download_test
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <assert.h>
+#include "download_engine.h"
+#include "sha256.h"
+#include "local_http_server.h"
+
+namespace fs = std::filesystem;
+
+static std::string RandomBlob(size_t size, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::string s(size, '\0');
+    for (char& c : s) c = (char)(rng() & 0xFF);
+    return s;
+}
+
+static std::string HashOf(const std::string& s) {
+    Sha256 h;
+    h.Update(s.data(), s.size());
+    return h.FinalHex();
+}
+
+static std::string ReadAll(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+}
+
+static std::string TempPath(const char* name) {
+    std::string path = (fs::temp_directory_path() / name).string();
+    fs::remove(path);
+    fs::remove(DownloadPartPath(path));
+    fs::remove(DownloadMapPath(path));
+    return path;
+}
+
+void TestSha256() {
+    assert(HashOf("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    assert(HashOf("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    assert(HashOf("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+           "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    assert(HashOf(std::string(1000000, 'a')) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+    // 任意切段餵入結果相同
+    std::string data = RandomBlob(100003, 7);
+    Sha256 h;
+    for (size_t pos = 0, step = 1; pos < data.size(); pos += step, step = step * 3 % 997 + 1) {
+        h.Update(data.data() + pos, std::min(step, data.size() - pos));
+    }
+    assert(h.FinalHex() == HashOf(data));
+
+    assert(IsSha256Hex(HashOf("x")) && !IsSha256Hex("VERIFY_ON_DOWNLOAD"));
+    assert(Sha256HexEquals(HashOf("abc"), "BA7816BF8F01CFEA414140DE5DAE2223B00361A396177A9CB410FF61F20015AD"));
+    std::cout << "[TEST] SHA-256 matches FIPS 180-4 vectors." << std::endl;
+}
+
+void TestParallelRangedDownload() {
+    LocalBlobServer server(RandomBlob(10 * 1024 * 1024 + 123, 1));
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    DownloadOptions options;
+    options.chunk_size = 1024 * 1024;
+    options.max_parallel = 4;
+    options.expected_sha256 = HashOf(server.blob);
+    uint64_t last_progress = 0;
+    std::mutex progress_lock;
+    options.progress = [&](uint64_t done, uint64_t total) {
+        std::lock_guard<std::mutex> guard(progress_lock);
+        assert(total == server.blob.size() && done <= total);
+        if (done > last_progress) last_progress = done;
+    };
+
+    std::string path = TempPath("maidos_dl_parallel.bin");
+    DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_OK);
+    assert(r.ranged && r.total_bytes == server.blob.size() && r.fetched_bytes == server.blob.size());
+    assert(r.requests == 1 + 11);
+    assert(r.sha256 == options.expected_sha256);
+    assert(last_progress == server.blob.size());
+    assert(ReadAll(path) == server.blob);
+    assert(!fs::exists(DownloadPartPath(path)) && !fs::exists(DownloadMapPath(path)));
+    assert(transport.ConnectionsOpened() <= 4);
+    fs::remove(path);
+    std::cout << "[TEST] 11 chunks fetched over " << transport.ConnectionsOpened() << " connections, hash verified." << std::endl;
+}
+
+void TestResumeAfterInterruption() {
+    LocalBlobServer server(RandomBlob(8 * 1024 * 1024, 2));
+    DownloadOptions options;
+    options.chunk_size = 512 * 1024;
+    options.max_parallel = 2;
+    options.max_retries = 0;
+    options.expected_sha256 = HashOf(server.blob);
+    std::string path = TempPath("maidos_dl_resume.bin");
+
+    // 第 6 個請求只送半個區塊，之後伺服器全部斷線
+    server.cut_request = 5;
+    server.fail_after = 6;
+    DownloadResult first;
+    {
+        SocketTransport transport("127.0.0.1", server.server.Port());
+        first = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    }
+    assert(first.status == DOWNLOAD_FAILED);
+    assert(!fs::exists(path) && fs::exists(DownloadPartPath(path)) && fs::exists(DownloadMapPath(path)));
+
+    server.fail_after = -1;
+    server.cut_request = -1;
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    DownloadResult second = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(second.status == DOWNLOAD_OK);
+    assert(second.resumed_bytes > 0 && second.resumed_bytes % options.chunk_size == 0);
+    assert(second.resumed_bytes + second.fetched_bytes == server.blob.size());
+    assert(ReadAll(path) == server.blob);
+    assert(!fs::exists(DownloadMapPath(path)));
+    fs::remove(path);
+    std::cout << "[TEST] Resumed " << second.resumed_bytes << " bytes, fetched " << second.fetched_bytes
+              << " after interruption." << std::endl;
+}
+
+void TestChangedFileRestarts() {
+    LocalBlobServer server(RandomBlob(2 * 1024 * 1024, 3));
+    DownloadOptions options;
+    options.chunk_size = 256 * 1024;
+    options.max_parallel = 1;
+    options.max_retries = 0;
+    std::string path = TempPath("maidos_dl_etag.bin");
+
+    server.fail_after = 3;
+    {
+        SocketTransport transport("127.0.0.1", server.server.Port());
+        assert(ChunkedDownloader(transport, options).Download("/pkg.exe", path).status == DOWNLOAD_FAILED);
+    }
+
+    // 伺服器檔案已更新 (ETag 不同): 不可拼接舊區塊
+    server.fail_after = -1;
+    server.blob = RandomBlob(2 * 1024 * 1024, 4);
+    server.etag = "\"v2\"";
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_OK && r.resumed_bytes == 0);
+    assert(ReadAll(path) == server.blob);
+    fs::remove(path);
+    std::cout << "[TEST] ETag change discards stale partial download." << std::endl;
+}
+
+void TestChangeDuringDownloadDetected() {
+    LocalBlobServer server(RandomBlob(2 * 1024 * 1024, 6));
+    DownloadOptions options;
+    options.chunk_size = 256 * 1024;
+    options.max_parallel = 1;
+    std::string path = TempPath("maidos_dl_ifrange.bin");
+
+    // 探測後檔案更新: 區塊請求帶 If-Range，伺服器改回完整 200，不可混入新舊內容
+    server.change_after = 3;
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_FAILED);
+    assert(r.error == "source changed during download");
+    assert(!fs::exists(path) && !fs::exists(DownloadPartPath(path)) && !fs::exists(DownloadMapPath(path)));
+    std::cout << "[TEST] If-Range mismatch mid-download discards partial chunks." << std::endl;
+}
+
+void TestOpenFailureReported() {
+    // 空檔案: 探測 416 後改為單一串流，本體為空，.part 於串流結束後才建立
+    LocalBlobServer server("");
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    std::string path = TempPath("maidos_no_such_dir") + "/x/pkg.bin";
+    DownloadResult r = ChunkedDownloader(transport).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_FAILED);
+    assert(r.error.compare(0, 13, "cannot create") == 0);
+    std::cout << "[TEST] Open failure reports an error (" << r.error << ")." << std::endl;
+}
+
+void TestChecksumMismatch() {
+    LocalBlobServer server(RandomBlob(300000, 5));
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    DownloadOptions options;
+    options.chunk_size = 64 * 1024;
+    options.expected_sha256 = HashOf("something else");
+    std::string path = TempPath("maidos_dl_bad.bin");
+
+    DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_CHECKSUM_MISMATCH);
+    assert(r.sha256 == HashOf(server.blob));
+    assert(!fs::exists(path) && !fs::exists(DownloadPartPath(path)) && !fs::exists(DownloadMapPath(path)));
+    std::cout << "[TEST] Checksum mismatch leaves no file behind." << std::endl;
+}
+
+void TestServerWithoutRanges() {
+    LocalBlobServer server(RandomBlob(3 * 1024 * 1024 + 7, 6));
+    server.ranges = false;
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    DownloadOptions options;
+    options.expected_sha256 = HashOf(server.blob);
+    std::string path = TempPath("maidos_dl_stream.bin");
+
+    DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_OK && !r.ranged && r.requests == 1);
+    assert(ReadAll(path) == server.blob);
+    fs::remove(path);
+
+    // 空檔案: Range 回 416，改為一般 GET
+    LocalBlobServer empty("");
+    SocketTransport t2("127.0.0.1", empty.server.Port());
+    options.expected_sha256 = HashOf("");
+    r = ChunkedDownloader(t2, options).Download("/empty", path);
+    assert(r.status == DOWNLOAD_OK && r.total_bytes == 0 && fs::file_size(path) == 0);
+    fs::remove(path);
+    std::cout << "[TEST] Servers without Range support stream in one request." << std::endl;
+}
+
+void TestCancel() {
+    LocalBlobServer server(RandomBlob(4 * 1024 * 1024, 8));
+    server.rate = 32 * 1024 * 1024;
+    SocketTransport transport("127.0.0.1", server.server.Port());
+    std::atomic<bool> cancel{ false };
+    DownloadOptions options;
+    options.chunk_size = 256 * 1024;
+    options.cancel = &cancel;
+    options.progress = [&](uint64_t done, uint64_t) {
+        if (done > 1024 * 1024) cancel = true;
+    };
+    std::string path = TempPath("maidos_dl_cancel.bin");
+
+    DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_CANCELLED);
+    assert(fs::exists(DownloadMapPath(path)));
+
+    cancel = false;
+    options.progress = nullptr;
+    r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+    assert(r.status == DOWNLOAD_OK && r.resumed_bytes > 0);
+    assert(ReadAll(path) == server.blob);
+    fs::remove(path);
+    std::cout << "[TEST] Cancel keeps resumable state." << std::endl;
+}
+
+void BenchDownload(size_t size, uint64_t rate) {
+    auto ms = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::milliseconds>(b - a).count(); };
+    LocalBlobServer server(RandomBlob(size, 9));
+    server.rate = rate;
+    std::string path = TempPath("maidos_dl_bench.bin");
+
+    // 舊做法: 單一串流，8KB fwrite，不校驗
+    auto t0 = std::chrono::steady_clock::now();
+    {
+        SocketTransport transport("127.0.0.1", server.server.Port());
+        FILE* fp = fopen(path.c_str(), "wb");
+        HttpRequest req;
+        req.path = "/pkg.exe";
+        req.sink = [&](const char* data, size_t len) {
+            for (size_t off = 0; off < len; off += 8192) fwrite(data + off, 1, std::min<size_t>(8192, len - off), fp);
+            return true;
+        };
+        HttpResponse resp;
+        transport.Send(req, resp, 60000);
+        fclose(fp);
+        fs::remove(path);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::ostringstream line;
+    line << "[BENCH] size=" << size / (1024 * 1024) << "MB rate/conn=" << rate / (1024 * 1024) << "MB/s"
+              << " legacy=" << ms(t0, t1) << "ms";
+    for (int parallel : { 1, 4, 8 }) {
+        SocketTransport transport("127.0.0.1", server.server.Port());
+        DownloadOptions options;
+        options.max_parallel = parallel;
+        options.chunk_size = 2 * 1024 * 1024;
+        options.expected_sha256 = HashOf(server.blob);
+        auto a = std::chrono::steady_clock::now();
+        DownloadResult r = ChunkedDownloader(transport, options).Download("/pkg.exe", path);
+        auto b = std::chrono::steady_clock::now();
+        assert(r.status == DOWNLOAD_OK);
+        fs::remove(path);
+        line << " chunked" << parallel << "=" << ms(a, b) << "ms";
+    }
+    std::cout << line.str() << std::endl;
+}
+
+int main() {
+    std::cout << "Starting MAIDOS Download Tests..." << std::endl;
+    TestSha256();
+    TestParallelRangedDownload();
+    TestResumeAfterInterruption();
+    TestChangedFileRestarts();
+    TestChangeDuringDownloadDetected();
+    TestOpenFailureReported();
+    TestChecksumMismatch();
+    TestServerWithoutRanges();
+    TestCancel();
+
+    BenchDownload(64 * 1024 * 1024, 0);
+    BenchDownload(32 * 1024 * 1024, 64 * 1024 * 1024);
+    std::cout << "All Download Tests Passed!" << std::endl;
+    return 0;
+}
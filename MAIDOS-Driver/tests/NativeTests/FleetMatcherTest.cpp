@@ -0,0 +1,194 @@
+// [MAIDOS-AUDIT] 機群批次比對測試 (合成機群的 .mdscan 清單檔，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native FleetMatcherTest.cpp ../../src/MAIDOS.Driver.Native/fleet_matcher.cpp ../../src/MAIDOS.Driver.Native/driver_catalog.cpp ../../src/MAIDOS.Driver.Native/scan_blob.cpp ../../src/MAIDOS.Driver.Native/device_inventory.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o fleet_matcher_test
+// 執行: ./fleet_matcher_test [機器數量] [每台設備數]
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <assert.h>
+#include "fleet_matcher.h"
+#include "scan_blob.h"
+
+namespace fs = std::filesystem;
+
+static fs::path TempDir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+static std::vector<uint8_t> Encode(const std::vector<DeviceRecord>& devices) {
+    FakeDeviceProvider provider(devices);
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+    size_t needed = 0;
+    EncodeScanBlob(inventory, nullptr, 0, &needed);
+    std::vector<uint8_t> blob(needed);
+    assert(EncodeScanBlob(inventory, blob.data(), blob.size(), nullptr) == needed);
+    return blob;
+}
+
+// 合成機器: 同一批硬體型號的不同子集，驅動版本依機器而異 (部分落後於目錄)
+static std::vector<DeviceRecord> Machine(size_t index, size_t devices) {
+    std::vector<DeviceRecord> pool = FakeDeviceProvider::Synthetic(devices + 64);
+    std::vector<DeviceRecord> out(pool.begin() + (index % 64), pool.begin() + (index % 64) + devices);
+    for (size_t i = 0; i < out.size(); i++) {
+        out[i].instance_id += "&M" + std::to_string(index);
+        if ((i + index) % 5 == 0) out[i].driver_version = "1.0.0." + std::to_string(index % 10);
+    }
+    return out;
+}
+
+static DeviceRecord Device(const char* instance, std::vector<std::string> hardware, std::vector<std::string> compatible,
+                           const char* version) {
+    DeviceRecord d;
+    d.instance_id = instance;
+    d.name = std::string("Device ") + instance;
+    d.hardware_ids = std::move(hardware);
+    d.compatible_ids = std::move(compatible);
+    d.driver_version = version;
+    return d;
+}
+
+void TestMatchBlob() {
+    DriverCatalog catalog;
+    catalog.ParseTsv("# id\tname\tversion\tmfg\tids\turl\tchecksum\tscore\n"
+                     "DRV_GPU\tGPU Driver\t31.0.15.5222\tNVIDIA\tPCI\\VEN_10DE&DEV_2684\thttps://x/gpu.exe\tabc\t90\n"
+                     "DRV_HDA\tHD Audio\t6.0.9500.1\tRealtek\tHDAUDIO\\FUNC_01&VEN_10EC&DEV_0897\thttps://x/hda.exe\tdef\t70\n"
+                     "DRV_CLASS\tGeneric Storage\t10.1.0.0\tMicrosoft\tPCI\\CC_0106\thttps://x/ahci.exe\t\t10\n");
+
+    std::vector<DeviceRecord> devices;
+    devices.push_back(Device("PCI\\VEN_10DE&DEV_2684\\1", { "PCI\\VEN_10DE&DEV_2684&SUBSYS_16F310DE&REV_A1", "PCI\\VEN_10DE&DEV_2684" }, {}, "31.0.15.3000"));
+    devices.push_back(Device("HDAUDIO\\2", { "HDAUDIO\\FUNC_01&VEN_10EC&DEV_0897&SUBSYS_10438882" }, {}, "6.0.9500.1"));
+    devices.push_back(Device("PCI\\VEN_8086&DEV_A352\\3", { "PCI\\VEN_8086&DEV_A352" }, { "PCI\\CC_010601", "PCI\\CC_0106" }, "10.0.0.1"));
+    devices.push_back(Device("USB\\VID_046D&PID_C52B\\4", { "USB\\VID_046D&PID_C52B" }, {}, "1.0"));
+    std::vector<uint8_t> blob = Encode(devices);
+
+    FleetMachineReport report;
+    assert(FleetMatcher(catalog, 1).MatchBlob(blob.data(), blob.size(), report));
+    assert(report.devices == 4 && report.matched == 3 && report.updates.size() == 2);
+    assert(report.updates[0].instance_id == devices[0].instance_id && report.updates[0].entry->driver_id == "DRV_GPU");
+    assert(report.updates[0].current_version == "31.0.15.3000" && report.updates[0].device_name == devices[0].name);
+    assert(report.updates[1].entry->driver_id == "DRV_CLASS");   // 只有相容ID符合
+
+    // 與逐設備 DriverCatalog::Match 一致
+    DriverCatalog big = DriverCatalog::Synthetic(20000);
+    std::vector<DeviceRecord> machine = Machine(3, 2000);
+    std::vector<uint8_t> mblob = Encode(machine);
+    assert(FleetMatcher(big, 1).MatchBlob(mblob.data(), mblob.size(), report));
+    size_t matched = 0, updates = 0;
+    for (const DeviceRecord& d : machine) {
+        CatalogMatch m;
+        if (!big.Match(d, m)) continue;
+        matched++;
+        if (!m.update_available) continue;
+        assert(report.updates[updates].instance_id == d.instance_id && report.updates[updates].entry == m.entry);
+        updates++;
+    }
+    assert(report.matched == matched && report.updates.size() == updates && updates > 0);
+
+    // 截斷的區塊
+    assert(!FleetMatcher(catalog).MatchBlob(blob.data(), blob.size() - 1, report) && !report.error.empty());
+    std::cout << "[TEST] Blob matching agrees with per-device catalog match." << std::endl;
+}
+
+void TestMatchFiles() {
+    fs::path dir = TempDir("maidos_fleet_files");
+    DriverCatalog catalog = DriverCatalog::Synthetic(20000);
+    for (size_t m = 0; m < 40; m++) {
+        std::vector<uint8_t> blob = Encode(Machine(m, 300));
+        assert(WriteInventoryFile((dir / ("host" + std::to_string(100 + m) + FLEET_INVENTORY_EXT)).string(), blob.data(), blob.size()));
+    }
+    {
+        std::ofstream bad(dir / ("broken" FLEET_INVENTORY_EXT), std::ios::binary);
+        bad << "not a scan blob";
+        std::ofstream other(dir / "notes.txt");
+        other << "ignored";
+    }
+    uint8_t junk[8] = { 0 };
+    assert(!WriteInventoryFile((dir / "junk.mdscan").string(), junk, sizeof(junk)));
+
+    std::vector<std::string> files;
+    assert(FleetMatcher::ListInventoryFiles(dir.string(), files));
+    assert(files.size() == 41 && fs::path(files[0]).stem() == "broken" && fs::path(files[1]).stem() == "host100");
+    files.push_back((dir / ("missing" FLEET_INVENTORY_EXT)).string());
+
+    std::vector<FleetMachineReport> serial, parallel;
+    FleetSummary a = FleetMatcher(catalog, 1).MatchFiles(files, serial);
+    FleetSummary b = FleetMatcher(catalog, 4).MatchFiles(files, parallel);
+    assert(a.machines == 42 && a.failed == 2 && a.devices == 40 * 300 && a.updates > 0);
+    assert(b.failed == a.failed && b.devices == a.devices && b.matched == a.matched && b.updates == a.updates);
+    for (size_t i = 0; i < serial.size(); i++) {
+        assert(serial[i].machine == parallel[i].machine && serial[i].updates.size() == parallel[i].updates.size());
+        for (size_t u = 0; u < serial[i].updates.size(); u++) {
+            assert(serial[i].updates[u].instance_id == parallel[i].updates[u].instance_id);
+            assert(serial[i].updates[u].entry == parallel[i].updates[u].entry);
+        }
+    }
+    assert(!serial[0].Ok() && !serial.back().Ok() && serial[1].Ok() && serial[1].machine == "host100");
+
+    // 報告: 每個建議一列 + 錯誤註解
+    std::string report_path = (dir / "fleet.tsv").string();
+    assert(FleetMatcher::WriteReport(report_path, serial, nullptr));
+    std::ifstream in(report_path);
+    std::string line;
+    size_t rows = 0, errors = 0;
+    while (std::getline(in, line)) {
+        if (line.rfind("# ERROR ", 0) == 0) errors++;
+        else if (!line.empty() && line[0] != '#') {
+            rows++;
+            assert(line.rfind("host", 0) == 0 && std::count(line.begin(), line.end(), '\t') == 7);
+        }
+    }
+    assert(rows == a.updates && errors == 2);
+
+    std::string error;
+    assert(!FleetMatcher::ListInventoryFiles((dir / "nope").string(), files, &error) && !error.empty());
+    fs::remove_all(dir);
+    std::cout << "[TEST] Parallel file matching, bad files and report output." << std::endl;
+}
+
+void BenchFleet(size_t machines, size_t devices) {
+    fs::path dir = TempDir("maidos_fleet_bench");
+    DriverCatalog catalog = DriverCatalog::Synthetic(50000);
+    std::vector<std::string> files;
+    for (size_t m = 0; m < machines; m++) {
+        std::vector<uint8_t> blob = Encode(Machine(m, devices));
+        files.push_back((dir / ("m" + std::to_string(m) + FLEET_INVENTORY_EXT)).string());
+        assert(WriteInventoryFile(files.back(), blob.data(), blob.size()));
+    }
+
+    auto ms = [](auto a, auto b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+    std::vector<FleetMachineReport> reports;
+    auto t0 = std::chrono::steady_clock::now();
+    FleetSummary one = FleetMatcher(catalog, 1).MatchFiles(files, reports);
+    auto t1 = std::chrono::steady_clock::now();
+    int cores = (int)std::thread::hardware_concurrency();
+    FleetSummary all = FleetMatcher(catalog, cores).MatchFiles(files, reports);
+    auto t2 = std::chrono::steady_clock::now();
+    assert(one.updates == all.updates && one.failed == 0);
+
+    std::ostringstream line;
+    line << "[BENCH] machines=" << machines << " devices=" << one.devices << " updates=" << one.updates
+         << " bytes=" << one.bytes << " threads=1:" << ms(t0, t1) << "ms ("
+         << (uint64_t)(machines * 1000.0 / ms(t0, t1)) << " machines/s)"
+         << " threads=" << cores << ":" << ms(t1, t2) << "ms ("
+         << (uint64_t)(machines * 1000.0 / ms(t1, t2)) << " machines/s)";
+    std::cout << line.str() << std::endl;
+    fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Fleet Matcher Test Suite ===" << std::endl;
+    TestMatchBlob();
+    TestMatchFiles();
+    BenchFleet(argc > 1 ? (size_t)atoi(argv[1]) : 1000, argc > 2 ? (size_t)atoi(argv[2]) : 250);
+    std::cout << "All Fleet Matcher Tests Passed!" << std::endl;
+    return 0;
+}
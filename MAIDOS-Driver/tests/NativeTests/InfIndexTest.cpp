@@ -0,0 +1,322 @@
+// [MAIDOS-AUDIT] INF 解析器與本地驅動儲存庫索引測試 (可在 Linux 執行，使用暫存目錄中的合成 INF)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native InfIndexTest.cpp ../../src/MAIDOS.Driver.Native/inf_parser.cpp ../../src/MAIDOS.Driver.Native/inf_index.cpp -o inf_index_test
+// 執行: ./inf_index_test
+
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <assert.h>
+#include "inf_parser.h"
+#include "inf_index.h"
+
+namespace fs = std::filesystem;
+
+static void WriteAll(const fs::path& path, const std::string& data) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), (std::streamsize)data.size());
+}
+
+static fs::path TempDir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+// UTF-8 (僅 ASCII/BMP) 轉 UTF-16LE 含 BOM
+static std::string ToUtf16(const std::string& text) {
+    std::string out("\xFF\xFE", 2);
+    for (size_t i = 0; i < text.size();) {
+        unsigned char c = (unsigned char)text[i];
+        unsigned cp;
+        if (c < 0x80) {
+            cp = c;
+            i += 1;
+        } else if ((c & 0xE0) == 0xC0) {
+            cp = (c & 0x1F) << 6 | (text[i + 1] & 0x3F);
+            i += 2;
+        } else {
+            cp = (c & 0x0F) << 12 | (text[i + 1] & 0x3F) << 6 | (text[i + 2] & 0x3F);
+            i += 3;
+        }
+        out += (char)(cp & 0xFF);
+        out += (char)(cp >> 8);
+    }
+    return out;
+}
+
+static const char* kSampleInf =
+    "; MAIDOS sample network driver\r\n"
+    "[Version]\r\n"
+    "Signature   = \"$WINDOWS NT$\"\r\n"
+    "Class       = Net\r\n"
+    "ClassGuid   = {4d36e972-e325-11ce-bfc1-08002be10318}\r\n"
+    "Provider    = %ProviderName%\r\n"
+    "CatalogFile.NTamd64 = maidosnet.cat\r\n"
+    "DriverVer   = 03/15/2024,31.0.101.5186 ; inline comment\r\n"
+    "\r\n"
+    "[Manufacturer]\r\n"
+    "%Mfg% = Maidos, NTamd64, NTx86.10.0...16299\r\n"
+    "%Legacy%\r\n"
+    "\r\n"
+    "[Maidos.NTamd64]\r\n"
+    "%Dev.Desc% = Install, PCI\\VEN_8086&DEV_15F3&SUBSYS_00008086, PCI\\VEN_8086&DEV_15F3\r\n"
+    "\"Quoted \"\"Model\"\" ; not a comment\" = Install.Quoted, \\\r\n"
+    "    PCI\\VEN_8086&DEV_15F2 ; continued from the previous line\r\n"
+    "\r\n"
+    "[Maidos.NTx86.10.0...16299]\r\n"
+    "%Dev.Desc% = Install, PCI\\VEN_8086&DEV_15F3\r\n"
+    "\r\n"
+    "[Legacy Devices]\r\n"
+    "%Old.Desc% = OldInstall, USB\\VID_0BDA&PID_8153\r\n"
+    "\r\n"
+    "[Maidos.NTamd64]\r\n"
+    "%Dev.Desc%\xE2\x84\xA2 = Install, PCI\\VEN_8086&DEV_0D4F\r\n"
+    "\r\n"
+    "[Strings]\r\n"
+    "ProviderName = \"MAIDOS, Inc.\"\r\n"
+    "Mfg          = \"MAIDOS\"\r\n"
+    "Dev.Desc     = \"MAIDOS 2.5GbE Controller (100%% speed)\"\r\n"
+    "Legacy       = \"Legacy Devices\"\r\n"
+    "\r\n"
+    "[Strings.0411]\r\n"
+    "Dev.Desc     = \"localized\"\r\n"
+    "Old.Desc     = \"Old USB Adapter\"\r\n";
+
+void TestParseSample(const std::string& text, const char* label) {
+    InfDocument doc;
+    doc.Parse(InfDocument::DecodeText(text));
+    assert(doc.Value("version", "CLASS") == "Net");
+    assert(doc.Value("Version", "Provider") == "MAIDOS, Inc.");
+    assert(doc.Find("maidos.ntamd64") && doc.Find("MAIDOS.NTAMD64")->lines.size() == 3);  // 同名節合併
+    assert(!doc.Find("Missing") && doc.Value("Version", "Missing").empty());
+
+    InfDriverInfo info;
+    assert(info.FromDocument(doc));
+    assert(info.class_guid == "{4d36e972-e325-11ce-bfc1-08002be10318}");
+    assert(info.catalog == "maidosnet.cat");
+    assert(info.driver_date == "03/15/2024" && info.driver_version == "31.0.101.5186");
+    assert(InfDateKey(info.driver_date) == 20240315);
+    assert(info.models.size() == 5);
+
+    const InfModel& first = info.models[0];
+    assert(first.manufacturer == "MAIDOS" && first.decoration == "NTamd64");
+    assert(first.description == "MAIDOS 2.5GbE Controller (100% speed)");
+    assert(first.install_section == "Install");
+    assert(first.ids.size() == 2 && first.ids[0] == "PCI\\VEN_8086&DEV_15F3&SUBSYS_00008086");
+
+    const InfModel& quoted = info.models[1];
+    assert(quoted.description == "Quoted \"Model\" ; not a comment");
+    assert(quoted.install_section == "Install.Quoted");
+    assert(quoted.ids.size() == 1 && quoted.ids[0] == "PCI\\VEN_8086&DEV_15F2");
+
+    assert(info.models[2].description == "MAIDOS 2.5GbE Controller (100% speed)\xE2\x84\xA2");
+    assert(info.models[3].decoration == "NTx86.10.0...16299");
+    assert(info.models[4].manufacturer == "Legacy Devices" && info.models[4].decoration.empty());
+    assert(info.models[4].description == "Old USB Adapter");  // 只在 [Strings.0411] 定義
+    std::cout << "[TEST] " << label << " INF parsed: " << info.models.size() << " models, DriverVer "
+              << info.driver_version << "." << std::endl;
+}
+
+void TestParserEdgeCases() {
+    InfDocument doc;
+    doc.Parse("no section line\n[A]\nkey=\nvalue only\n  , second\n[B]\r\nx = \"  padded  \" , plain  \nunterminated = \"abc");
+    const InfSection* a = doc.Find("A");
+    assert(a && a->lines.size() == 3);
+    assert(a->lines[0].key == "key" && a->lines[0].values.size() == 1 && a->lines[0].values[0].empty());
+    assert(a->lines[1].key.empty() && a->lines[1].values[0] == "value only");
+    assert(a->lines[2].values.size() == 2 && a->lines[2].values[1] == "second");
+    const InfSection* b = doc.Find("B");
+    assert(b->lines[0].values[0] == "  padded  " && b->lines[0].values[1] == "plain");
+    assert(b->lines[1].values[0] == "abc");
+
+    InfDriverInfo info;
+    assert(!info.FromDocument(doc));
+
+    assert(InfDateKey("1/2/2023") == 20230102 && InfDateKey("13/01/2020") == 0 && InfDateKey("garbage") == 0);
+    assert(InfDecorationMatches("NTamd64", "amd64") && InfDecorationMatches("ntAMD64.10.0", "amd64"));
+    assert(!InfDecorationMatches("NTx86", "amd64") && InfDecorationMatches("", "arm64"));
+    assert(InfDecorationMatches("NT", "arm64") && InfDecorationMatches("NTarm64", ""));
+    std::cout << "[TEST] Parser edge cases (quotes, empty values, unterminated strings, dates, decorations)." << std::endl;
+}
+
+// 合成儲存庫: 每個套件一個 INF，VEN/DEV 不重複，另有共用的相容ID
+static std::string SyntheticInf(int n, const char* date, const char* version) {
+    char buf[256];
+    std::ostringstream inf;
+    inf << "[Version]\r\nSignature=\"$WINDOWS NT$\"\r\nClass=Display\r\nProvider=%P%\r\n";
+    inf << "DriverVer=" << date << "," << version << "\r\n\r\n[Manufacturer]\r\n%P%=Models,NTamd64,NTarm64\r\n\r\n";
+    for (const char* arch : { "NTamd64", "NTarm64" }) {
+        inf << "[Models." << arch << "]\r\n";
+        for (int m = 0; m < 8; m++) {
+            snprintf(buf, sizeof(buf), "%%D%d%% = Install%d, PCI\\VEN_%04X&DEV_%04X, PCI\\CC_0300\r\n", m, m,
+                     0x1000 + n / 4096, (n * 8 + m) & 0xFFFF);
+            inf << buf;
+        }
+        inf << "\r\n";
+    }
+    inf << "[Strings]\r\nP=\"Vendor " << n << "\"\r\n";
+    for (int m = 0; m < 8; m++) inf << "D" << m << "=\"Synthetic Display Adapter " << n << "/" << m << "\"\r\n";
+    // 其餘節 (複製清單/服務) 佔大部分篇幅，與真實 INF 相近
+    for (int s = 0; s < 20; s++) inf << "[Install" << s << ".CopyFiles]\r\nmaidos" << s << ".sys,,,0x00004000\r\n";
+    return inf.str();
+}
+
+static std::string PackagePath(int n) {
+    return "pkg" + std::to_string(n / 100) + "/display_" + std::to_string(n) + ".inf_amd64/display_" + std::to_string(n) + ".inf";
+}
+
+static void MakeRepository(const fs::path& dir, int count) {
+    for (int n = 0; n < count; n++) WriteAll(dir / PackagePath(n), SyntheticInf(n, "06/01/2023", "30.0.15.1000"));
+    WriteAll(dir / "readme.txt", "not an inf");
+    WriteAll(dir / "setup" / "autorun.INF", "[AutoRun]\r\nopen=setup.exe\r\n");  // 非驅動 INF
+}
+
+static DeviceRecord MakeDevice(std::vector<std::string> hardware_ids, std::vector<std::string> compatible_ids) {
+    DeviceRecord d;
+    d.instance_id = hardware_ids.empty() ? "ROOT\\X\\0000" : hardware_ids[0] + "\\4&1&0";
+    d.hardware_ids = std::move(hardware_ids);
+    d.compatible_ids = std::move(compatible_ids);
+    return d;
+}
+
+void TestIndexAndMatch() {
+    fs::path repo = TempDir("maidos_inf_repo");
+    MakeRepository(repo, 300);
+    // 較新的同型驅動 (相同硬體ID，DriverVer 較新) 與只支援 arm64 的套件
+    WriteAll(repo / "newer" / "display_7_v2.inf", SyntheticInf(7, "01/20/2024", "31.0.15.2000"));
+
+    InfIndex index;
+    InfIndexStats stats;
+    assert(index.Update(repo.string(), 4, &stats));
+    assert(stats.files == 302 && stats.parsed == 302 && stats.unchanged == 0 && stats.failed == 0);
+    assert(index.Size() == 302);
+    assert(index.Records()[0].path < index.Records()[1].path);
+
+    // 硬體ID查詢 (不分大小寫)
+    char id[64];
+    snprintf(id, sizeof(id), "pci\\ven_%04x&dev_%04x", 0x1000, 42 * 8 + 3);
+    std::vector<InfCandidate> hits = index.Lookup(id, "amd64");
+    assert(hits.size() == 1 && hits[0].inf->path == PackagePath(42) && hits[0].model->install_section == "Install3");
+    assert(hits[0].model->description == "Synthetic Display Adapter 42/3" && hits[0].rank == 0);
+    assert(index.Lookup(id).size() == 2);           // amd64 + arm64
+    assert(index.Lookup(id, "x86").empty());
+    assert(index.Lookup("PCI\\CC_0300", "amd64").size() == 301 * 8);  // autorun.INF 不是驅動 INF
+
+    // 設備比對: 硬體ID優先於相容ID；相同排名取 DriverVer 較新者
+    snprintf(id, sizeof(id), "PCI\\VEN_%04X&DEV_%04X", 0x1000, 7 * 8);
+    InfCandidate best;
+    assert(index.Match(MakeDevice({ std::string(id) + "&SUBSYS_12345678", id }, { "PCI\\CC_0300" }), "amd64", best));
+    assert(best.inf->path == "newer/display_7_v2.inf" && best.rank == 1);
+    assert(best.inf->info.driver_version == "31.0.15.2000");
+
+    // 只有相容ID相符: 排名落在 0x3000 (設備相容ID × INF 相容ID)
+    assert(index.Match(MakeDevice({ "PCI\\VEN_ABCD&DEV_0001" }, { "PCI\\CC_0300" }), "amd64", best));
+    assert(best.rank >= 0x3000 && best.inf->info.driver_version == "31.0.15.2000");
+    assert(!index.Match(MakeDevice({ "USB\\VID_FFFF&PID_0001" }, {}), "amd64", best));
+
+    // 持久化後再載入，結果一致
+    fs::path file = fs::temp_directory_path() / "maidos_inf_index.tsv";
+    std::string error;
+    assert(index.Save(file.string(), &error));
+    InfIndex loaded;
+    assert(loaded.Load(file.string(), &error));
+    assert(loaded.Size() == index.Size() && loaded.IdCount() == index.IdCount() && loaded.Root() == repo.string());
+    assert(loaded.Match(MakeDevice({ id }, {}), "amd64", best) && best.inf->path == "newer/display_7_v2.inf");
+    assert(best.model->description == "Synthetic Display Adapter 7/0");
+
+    // 增量: 不變 / 只改時間戳 / 改內容 / 刪除 / 新增
+    fs::path touched = repo / PackagePath(10);
+    fs::last_write_time(touched, fs::last_write_time(touched) + std::chrono::seconds(10));
+    WriteAll(repo / PackagePath(11), SyntheticInf(11, "02/02/2025", "32.0.0.1"));
+    fs::remove(repo / PackagePath(12));
+    WriteAll(repo / "added" / "new.inf", SyntheticInf(5000, "03/03/2025", "1.0.0.0"));
+    assert(loaded.Update(repo.string(), 4, &stats));
+    assert(stats.files == 302 && stats.unchanged == 299 && stats.rehashed == 1 && stats.parsed == 2);
+    assert(stats.removed == 1);
+    snprintf(id, sizeof(id), "PCI\\VEN_%04X&DEV_%04X", 0x1000, 11 * 8);
+    hits = loaded.Lookup(id, "amd64");
+    assert(hits.size() == 1 && hits[0].inf->info.driver_version == "32.0.0.1");
+    snprintf(id, sizeof(id), "PCI\\VEN_%04X&DEV_%04X", 0x1000, 12 * 8);
+    assert(loaded.Lookup(id).empty());
+
+    InfIndex corrupt;
+    WriteAll(file, "MAIDOS-INFINDEX 1\nbogus\tline\n");
+    assert(!corrupt.Load(file.string(), &error) && error.find(":2:") != std::string::npos);
+    fs::remove(file);
+    fs::remove_all(repo);
+    std::cout << "[TEST] Index of 302 INFs: lookup, ranking, persistence and incremental update (1 rehashed, 2 parsed, 1 removed)."
+              << std::endl;
+}
+
+void BenchIndex(int count) {
+    fs::path repo = TempDir("maidos_inf_bench");
+    MakeRepository(repo, count);
+
+    auto ms = [](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+        return (double)std::chrono::duration_cast<std::chrono::microseconds>(b - a).count() / 1000.0;
+    };
+    std::ostringstream line;
+    line << "[BENCH] infs=" << count;
+    int cores = (int)std::thread::hardware_concurrency();
+    InfIndex index;
+    for (int threads : { 1, cores > 1 ? cores : 2 }) {
+        InfIndex fresh;
+        auto a = std::chrono::steady_clock::now();
+        assert(fresh.Update(repo.string(), threads));
+        auto b = std::chrono::steady_clock::now();
+        line << " full/t" << threads << "=" << ms(a, b) << "ms";
+        index = std::move(fresh);
+    }
+
+    InfIndexStats stats;
+    auto a = std::chrono::steady_clock::now();
+    assert(index.Update(repo.string(), 0, &stats));
+    auto b = std::chrono::steady_clock::now();
+    assert(stats.unchanged == (uint64_t)count + 1);
+    line << " incremental=" << ms(a, b) << "ms";
+
+    fs::path file = fs::temp_directory_path() / "maidos_inf_bench.tsv";
+    assert(index.Save(file.string()));
+    InfIndex loaded;
+    a = std::chrono::steady_clock::now();
+    assert(loaded.Load(file.string()));
+    b = std::chrono::steady_clock::now();
+    line << " load=" << ms(a, b) << "ms (" << fs::file_size(file) / 1024 << "KB, " << loaded.IdCount() << " ids)";
+
+    const int lookups = 200000;
+    char id[64];
+    size_t found = 0;
+    InfCandidate best;
+    a = std::chrono::steady_clock::now();
+    for (int i = 0; i < lookups; i++) {
+        snprintf(id, sizeof(id), "PCI\\VEN_%04X&DEV_%04X", 0x1000 + (i % count) / 4096, ((i % count) * 8 + i % 8) & 0xFFFF);
+        DeviceRecord d;
+        d.hardware_ids.push_back(id);
+        found += loaded.Match(d, "amd64", best) ? 1 : 0;
+    }
+    b = std::chrono::steady_clock::now();
+    assert(found == (size_t)lookups);
+    line << " match=" << ms(a, b) * 1000.0 / lookups << "us/device";
+
+    fs::remove(file);
+    fs::remove_all(repo);
+    std::cout << line.str() << std::endl;
+}
+
+int main() {
+    std::cout << "Starting MAIDOS INF Index Tests..." << std::endl;
+    TestParseSample(kSampleInf, "UTF-8");
+    TestParseSample(ToUtf16(kSampleInf), "UTF-16LE");
+    TestParserEdgeCases();
+    TestIndexAndMatch();
+
+    BenchIndex(5000);
+    std::cout << "All INF Index Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,296 @@
+// [MAIDOS-AUDIT] 持久化清單與變更日誌測試 (假設備來源模擬設備增減/驅動更換，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native InventoryStoreTest.cpp ../../src/MAIDOS.Driver.Native/inventory_store.cpp ../../src/MAIDOS.Driver.Native/device_inventory.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o inventory_store_test
+// 執行: ./inventory_store_test [設備數量]
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <assert.h>
+#include "inventory_store.h"
+
+namespace fs = std::filesystem;
+
+static fs::path TempDir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    return dir;
+}
+
+static size_t CountKind(const std::vector<InventoryChange>& changes, uint32_t kind) {
+    size_t n = 0;
+    for (const InventoryChange& c : changes) n += c.kind == kind;
+    return n;
+}
+
+// 模擬一次開機: 新的清單物件 + 重新開啟的儲存
+static std::vector<InventoryChange> Boot(FakeDeviceProvider& provider, const fs::path& dir, uint64_t* sequence = nullptr) {
+    DeviceInventory inventory(provider);
+    assert(inventory.Refresh());
+    InventoryStore store(dir.string());
+    std::string error;
+    assert(store.Open(&error));
+    std::vector<InventoryChange> changes;
+    assert(store.Commit(inventory, &changes, &error));
+    assert(store.Size() == inventory.Size());
+    if (sequence) *sequence = store.Sequence();
+    return changes;
+}
+
+void TestChurnAcrossBoots() {
+    fs::path dir = TempDir("maidos_invstore_churn");
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(300));
+
+    uint64_t first = 0;
+    std::vector<InventoryChange> changes = Boot(provider, dir, &first);
+    assert(changes.size() == 300 && CountKind(changes, INVENTORY_CHANGE_ADDED) == 300);
+    assert(first == 300);
+    assert(InventoryDeltaIds(changes).size() == 300);
+
+    // 無變動的開機不寫入任何紀錄
+    uint64_t second = 0;
+    assert(Boot(provider, dir, &second).empty() && second == first);
+
+    // 設備變動: 移除 10、新增 5、驅動更換 7、問題碼 3、名稱改變 2
+    std::vector<DeviceRecord>& devices = provider.Devices();
+    std::vector<std::string> removed;
+    for (int i = 0; i < 10; i++) {
+        removed.push_back(devices.back().instance_id);
+        devices.pop_back();
+    }
+    std::vector<DeviceRecord> extra = FakeDeviceProvider::Synthetic(305);
+    for (size_t i = 300; i < 305; i++) {
+        extra[i].instance_id += "&NEW";
+        devices.push_back(extra[i]);
+    }
+    for (int i = 0; i < 7; i++) devices[i * 3].driver_version = "99.0.0." + std::to_string(i);
+    for (int i = 0; i < 3; i++) {
+        devices[100 + i].status = DEVICE_STATUS_HAS_PROBLEM;
+        devices[100 + i].problem_code = 43;
+    }
+    devices[200].name = "Renamed Device";
+    devices[201].hardware_ids.push_back("PCI\\VEN_10DE&DEV_FFFF");
+    devices[0].problem_code = 10;  // 同一設備驅動與問題碼皆改變
+    devices[0].status = DEVICE_STATUS_HAS_PROBLEM;
+
+    uint64_t third = 0;
+    changes = Boot(provider, dir, &third);
+    assert(CountKind(changes, INVENTORY_CHANGE_REMOVED) == 10);
+    assert(CountKind(changes, INVENTORY_CHANGE_ADDED) == 5);
+    assert(CountKind(changes, INVENTORY_CHANGE_DRIVER) == 7);
+    assert(CountKind(changes, INVENTORY_CHANGE_PROBLEM) == 4);
+    assert(CountKind(changes, INVENTORY_CHANGE_PROPERTIES) == 2);
+    assert(third == first + changes.size());
+    assert(InventoryDeltaIds(changes).size() == 5 + 7 + 2);
+    for (const InventoryChange& c : changes) {
+        if (c.kind == INVENTORY_CHANGE_DRIVER && c.instance_id == devices[3].instance_id) {
+            assert(c.new_version == "99.0.0.1" && !c.old_version.empty());
+        }
+        if (c.kind == INVENTORY_CHANGE_REMOVED) assert(std::find(removed.begin(), removed.end(), c.instance_id) != removed.end());
+    }
+
+    // 下游以游標讀取差異
+    InventoryStore store(dir.string());
+    assert(store.Open());
+    std::vector<InventoryChange> since;
+    assert(store.ReadChanges(first, since));
+    assert(since.size() == changes.size());
+    for (size_t i = 0; i < since.size(); i++) {
+        assert(since[i].sequence == changes[i].sequence && since[i].kind == changes[i].kind);
+        assert(since[i].instance_id == changes[i].instance_id);
+    }
+    assert(store.Find(devices[3].instance_id)->driver_version == "99.0.0.1");
+    assert(store.Find(devices[100].instance_id)->problem_code == 43);
+    assert(!store.Find(removed[0]));
+
+    fs::remove_all(dir);
+    std::cout << "[TEST] Churn across boots journaled (" << changes.size() << " changes)." << std::endl;
+}
+
+void TestTornJournalTail() {
+    fs::path dir = TempDir("maidos_invstore_torn");
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(50));
+    Boot(provider, dir);
+    provider.Devices()[1].driver_version = "1.2.3.4";
+    Boot(provider, dir);
+
+    InventoryStore store(dir.string());
+    std::string journal = store.JournalPath();
+    uintmax_t complete = fs::file_size(journal);
+
+    // 寫入中斷: 尾端半筆紀錄
+    {
+        std::ofstream out(journal, std::ios::binary | std::ios::app);
+        out.write("\x40\x00\x00\x00garbage", 11);
+    }
+    assert(store.Open());
+    assert(store.Sequence() == 51 && store.Size() == 50);
+    assert(fs::file_size(journal) == complete);
+    assert(store.Find(provider.Devices()[1].instance_id)->driver_version == "1.2.3.4");
+
+    // 截斷後可繼續附加
+    provider.Devices()[2].driver_version = "5.6.7.8";
+    assert(Boot(provider, dir).size() == 1);
+    assert(store.Open() && store.Sequence() == 52);
+
+    // 最後一筆紀錄內容損毀: 捨棄該筆
+    {
+        std::fstream io(journal, std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(-12, std::ios::end);
+        io.put('X');
+    }
+    assert(store.Open() && store.Sequence() == 51);
+    assert(store.Find(provider.Devices()[2].instance_id)->driver_version != "5.6.7.8");
+
+    fs::remove_all(dir);
+    std::cout << "[TEST] Torn and corrupt journal tails truncated." << std::endl;
+}
+
+void TestCompaction() {
+    fs::path dir = TempDir("maidos_invstore_compact");
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(100));
+    DeviceInventory inventory(provider);
+    assert(inventory.Refresh());
+
+    InventoryStore store(dir.string());
+    store.SetCompactThreshold(150);
+    assert(store.Open());
+    assert(store.Commit(inventory));
+    assert(store.JournalRecords() == 100);
+
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 20; i++) provider.Devices()[i].driver_version = "7.0." + std::to_string(round) + "." + std::to_string(i);
+        assert(inventory.Refresh());
+        assert(store.Commit(inventory));
+    }
+    // 第三輪後日誌達 160 筆，超過門檻自動壓縮
+    assert(store.Sequence() == 160);
+    assert(store.JournalStart() == 160 && store.JournalRecords() == 0);
+
+    std::vector<InventoryChange> since;
+    assert(!store.ReadChanges(100, since));   // 已壓縮
+    assert(store.ReadChanges(160, since) && since.empty());
+
+    InventoryStore reopened(dir.string());
+    assert(reopened.Open());
+    assert(reopened.Size() == 100 && reopened.Sequence() == 160);
+    for (size_t row = 0; row < inventory.Size(); row++) {
+        const StoredDevice* d = reopened.Find(std::string(inventory.InstanceId(row)));
+        assert(d && d->driver_version == inventory.DriverVersion(row));
+        assert(d->property_hash == DevicePropertyHash(inventory, row));
+    }
+
+    // 壓縮途中中斷 (快照已寫、日誌未清): 舊紀錄不重複套用
+    provider.Devices()[50].driver_version = "8.0.0.0";
+    assert(inventory.Refresh() && store.Commit(inventory));
+    std::string journal_before;
+    {
+        std::ifstream in(store.JournalPath(), std::ios::binary);
+        std::ostringstream s;
+        s << in.rdbuf();
+        journal_before = s.str();
+    }
+    assert(store.Compact());
+    {
+        std::ofstream out(store.JournalPath(), std::ios::binary | std::ios::trunc);
+        out << journal_before;
+    }
+    assert(reopened.Open() && reopened.Sequence() == 161 && reopened.JournalRecords() == 0);
+
+    // 快照損毀必須回報
+    {
+        std::fstream io(store.SnapshotPath(), std::ios::binary | std::ios::in | std::ios::out);
+        io.seekp(30);
+        io.put('\x7F');
+    }
+    std::string error;
+    assert(!reopened.Open(&error) && !error.empty());
+
+    fs::remove_all(dir);
+    std::cout << "[TEST] Compaction to snapshot and crash-safe replay." << std::endl;
+}
+
+void TestIndependentCursors() {
+    fs::path dir = TempDir("maidos_invstore_cursors");
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(20));
+    DeviceInventory inventory(provider);
+    assert(inventory.Refresh());
+
+    InventoryStore store(dir.string());
+    assert(store.Open());
+    assert(store.LoadCursor("update-check") == 0);
+    assert(store.Commit(inventory));
+
+    // 消費者 A 讀完並推進游標；B 尚未讀取
+    std::vector<InventoryChange> since;
+    assert(store.ReadChanges(store.LoadCursor("update-check"), since) && since.size() == 20);
+    assert(store.SaveCursor("update-check", store.Sequence()));
+
+    provider.Devices()[3].driver_version = "9.9.9.9";
+    assert(inventory.Refresh() && store.Commit(inventory));
+
+    // 另一次提交不影響各自的游標: A 只看到新變更，B 仍看到全部
+    assert(store.ReadChanges(store.LoadCursor("update-check"), since) && since.size() == 1);
+    assert(since[0].kind == INVENTORY_CHANGE_DRIVER);
+    assert(store.ReadChanges(store.LoadCursor("scan-commit"), since) && since.size() == 21);
+
+    // 游標跨開機保存；損毀時回到 0
+    InventoryStore reopened(dir.string());
+    assert(reopened.Open() && reopened.LoadCursor("update-check") == 20);
+    {
+        std::ofstream out(reopened.CursorPath("update-check"), std::ios::binary | std::ios::trunc);
+        out << "junk";
+    }
+    assert(reopened.LoadCursor("update-check") == 0);
+
+    fs::remove_all(dir);
+    std::cout << "[TEST] Consumers keep independent journal cursors." << std::endl;
+}
+
+void BenchBoot(size_t devices) {
+    fs::path dir = TempDir("maidos_invstore_bench");
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(devices));
+    Boot(provider, dir);
+    {
+        InventoryStore store(dir.string());
+        assert(store.Open() && store.Compact());
+    }
+
+    // 1% 設備更換驅動
+    for (size_t i = 0; i < devices; i += 100) provider.Devices()[i].driver_version = "31.0.0.1";
+
+    auto t0 = std::chrono::steady_clock::now();
+    DeviceInventory inventory(provider);
+    assert(inventory.Refresh());
+    auto t1 = std::chrono::steady_clock::now();
+    InventoryStore store(dir.string());
+    assert(store.Open());
+    auto t2 = std::chrono::steady_clock::now();
+    std::vector<InventoryChange> changes;
+    assert(store.Commit(inventory, &changes));
+    auto t3 = std::chrono::steady_clock::now();
+    size_t delta = InventoryDeltaIds(changes).size();
+    assert(delta == (devices + 99) / 100);
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    std::ostringstream line;
+    line << "[BENCH] devices=" << devices << " snapshot=" << fs::file_size(store.SnapshotPath()) << "B"
+         << " scan=" << us(t0, t1) << "us open=" << us(t1, t2) << "us diff+journal=" << us(t2, t3) << "us"
+         << " downstream=" << delta << "/" << devices << " devices";
+    std::cout << line.str() << std::endl;
+    fs::remove_all(dir);
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Inventory Store Test Suite ===" << std::endl;
+    TestChurnAcrossBoots();
+    TestTornJournalTail();
+    TestCompaction();
+    TestIndependentCursors();
+    BenchBoot(argc > 1 ? (size_t)atoi(argv[1]) : 10000);
+    std::cout << "All Inventory Store Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,194 @@
+// [MAIDOS-AUDIT] 設備清單快照/增量刷新測試 (假設備來源，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native InventoryTest.cpp ../../src/MAIDOS.Driver.Native/device_inventory.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o inventory_test
+// 執行: ./inventory_test [設備數量...]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <assert.h>
+#include "device_inventory.h"
+
+void TestSnapshotColumns() {
+    std::vector<DeviceRecord> devices = FakeDeviceProvider::Synthetic(100);
+    FakeDeviceProvider provider(devices);
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+    assert(inventory.Size() == 100);
+    assert(inventory.Generation() == 1);
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        int row = inventory.Find(devices[i].instance_id);
+        assert(row >= 0);
+        assert(inventory.Name(row) == devices[i].name);
+        assert(inventory.DriverVersion(row) == devices[i].driver_version);
+        assert(inventory.HardwareIds(row).size() == devices[i].hardware_ids.size());
+        assert(inventory.PrimaryHardwareId(row) == devices[i].hardware_ids[0]);
+        assert(inventory.CompatibleIds(row)[0] == devices[i].compatible_ids[0]);
+
+        DeviceRecord back = inventory.Record(row);
+        assert(back.hardware_ids == devices[i].hardware_ids);
+        assert(back.status == devices[i].status);
+    }
+    assert(inventory.Find("NON_EXISTENT_DEVICE_ID") == -1);
+    std::cout << "[TEST] Snapshot columns round-trip (" << inventory.PoolBytes() << " pool bytes)." << std::endl;
+}
+
+void TestIncrementalRefresh() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(50));
+    DeviceInventory inventory(provider);
+
+    InventoryDiff diff;
+    assert(inventory.Refresh(&diff));  // 首次 = 全量
+    assert(diff.added.size() == 50);
+    assert(provider.PropertyReadCount() == 50);
+
+    // 無變化: 不讀屬性、世代不變
+    assert(inventory.Refresh(&diff));
+    assert(diff.Empty());
+    assert(inventory.Generation() == 1);
+    assert(provider.PropertyReadCount() == 50);
+
+    // 驅動更新 1 個、狀態改變 1 個、移除 1 個、新增 1 個
+    std::vector<DeviceRecord>& live = provider.Devices();
+    live[3].driver_version = "99.0.0.1";
+    live[4].status = DEVICE_STATUS_HAS_PROBLEM;
+    live[4].problem_code = 43;
+    std::string removed = live[5].instance_id;
+    live.erase(live.begin() + 5);
+    DeviceRecord extra = FakeDeviceProvider::Synthetic(51)[50];
+    extra.instance_id = "USB\\VID_046D&PID_C52B\\NEW";
+    live.push_back(extra);
+
+    assert(inventory.Refresh(&diff));
+    assert(diff.added.size() == 1 && diff.added[0] == extra.instance_id);
+    assert(diff.removed.size() == 1 && diff.removed[0] == removed);
+    assert(diff.changed.size() == 2);
+    assert(inventory.Generation() == 2);
+    assert(inventory.Size() == 50);
+    // 只有新增與驅動變更的設備重讀屬性
+    assert(provider.PropertyReadCount() == 52);
+
+    int row = inventory.Find(live[3].instance_id);
+    assert(inventory.DriverVersion(row) == "99.0.0.1");
+    assert(inventory.RowGeneration(row) == 2);
+    row = inventory.Find(live[4].instance_id);
+    assert(inventory.ProblemCode(row) == 43);
+    assert(inventory.Find(removed) == -1);
+    assert(inventory.RowGeneration(inventory.Find(live[0].instance_id)) == 1);
+    std::cout << "[TEST] Incremental refresh re-reads only added/changed devices." << std::endl;
+}
+
+void TestRefreshPatchesInPlace() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(200));
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+    size_t pool = inventory.PoolBytes();
+
+    // 只改狀態或驅動版本不變長: 字串池不增長
+    std::vector<DeviceRecord>& live = provider.Devices();
+    live[7].status = DEVICE_STATUS_DISABLED;
+    live[8].driver_version = "1.0";
+    InventoryDiff diff;
+    assert(inventory.Refresh(&diff));
+    assert(diff.changed.size() == 2);
+    assert(inventory.PoolBytes() == pool);
+    assert(inventory.DriverVersion(inventory.Find(live[8].instance_id)) == "1.0");
+
+    // 反覆變長更新: 廢棄空間會被回收，所有列仍可查到
+    for (int round = 0; round < 20; round++) {
+        for (size_t i = 0; i < live.size(); i += 3) live[i].driver_version += ".1";
+        assert(inventory.Refresh(&diff));
+    }
+    assert(inventory.PoolBytes() < pool * 3);
+    for (size_t i = 0; i < live.size(); i++) {
+        int row = inventory.Find(live[i].instance_id);
+        assert(row == (int)i);
+        assert(inventory.DriverVersion(row) == live[i].driver_version);
+        assert(inventory.Name(row) == live[i].name);
+    }
+    std::cout << "[TEST] Refresh patches rows in place (" << inventory.PoolBytes() << " pool bytes)." << std::endl;
+}
+
+void TestInvalidate() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(10));
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+
+    provider.Devices()[2].name = "Renamed";
+    InventoryDiff diff;
+    assert(inventory.Refresh(&diff));
+    assert(diff.Empty());  // 名稱改變不影響指紋
+
+    inventory.Invalidate(provider.Devices()[2].instance_id);
+    assert(inventory.Refresh(&diff));
+    assert(diff.changed.size() == 1);
+    assert(inventory.Name(inventory.Find(provider.Devices()[2].instance_id)) == "Renamed");
+    std::cout << "[TEST] Invalidate forces a re-read." << std::endl;
+}
+
+void TestFailureKeepsSnapshot() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(10));
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+
+    provider.SetFailure(true);
+    assert(!inventory.Refresh());
+    assert(!inventory.Snapshot());
+    assert(inventory.Size() == 10);
+    assert(inventory.Generation() == 1);
+    std::cout << "[TEST] Enumeration failure keeps the previous snapshot." << std::endl;
+}
+
+void TestSharedInventoryFollowsDefaultProvider() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(7));
+    SetDefaultDeviceProvider(&provider);
+    {
+        std::lock_guard<std::mutex> guard(SharedDeviceInventoryLock());
+        assert(SharedDeviceInventory().Refresh());
+        assert(SharedDeviceInventory().Size() == 7);
+    }
+    SetDefaultDeviceProvider(nullptr);
+    std::cout << "[TEST] Shared inventory binds to the default provider." << std::endl;
+}
+
+// 全量重掃 vs 增量刷新 (1% 設備改變驅動)
+void BenchFullVersusIncremental(size_t devices) {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(devices));
+    DeviceInventory inventory(provider);
+
+    auto t0 = std::chrono::steady_clock::now();
+    inventory.Snapshot();
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t fullReads = provider.PropertyReadCount();
+
+    for (size_t i = 0; i < devices; i += 100) provider.Devices()[i].driver_version += ".1";
+    auto t2 = std::chrono::steady_clock::now();
+    inventory.Refresh();
+    auto t3 = std::chrono::steady_clock::now();
+    uint64_t incrementalReads = provider.PropertyReadCount() - fullReads;
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    std::cout << "[BENCH] devices=" << devices
+              << " full=" << us(t0, t1) << "us (" << fullReads << " property reads)"
+              << " incremental=" << us(t2, t3) << "us (" << incrementalReads << " property reads)"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "Starting MAIDOS Inventory Tests..." << std::endl;
+    TestSnapshotColumns();
+    TestIncrementalRefresh();
+    TestRefreshPatchesInPlace();
+    TestInvalidate();
+    TestFailureKeepsSnapshot();
+    TestSharedInventoryFollowsDefaultProvider();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) BenchFullVersusIncremental((size_t)atoi(argv[i]));
+    } else {
+        BenchFullVersusIncremental(1000);
+        BenchFullVersusIncremental(10000);
+    }
+    std::cout << "All Inventory Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,234 @@
+// [MAIDOS-AUDIT] 原生模組基準與測試框架 (假設備來源模擬 10 ~ 10,000 個設備的設備樹，可在 Linux 執行)
+// 每項操作回報: 耗時、配置次數/位元組 (攔截全域 operator new)、跨界呼叫次數 (設備來源的列舉/屬性讀取，
+// Windows 上即 SetupAPI/CfgMgr 呼叫)、稽核日誌行數；跨界次數同時作為回歸檢查 (例如增量刷新不得逐設備讀取)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native NativeBenchTest.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp ../../src/MAIDOS.Driver.Native/device_inventory.cpp ../../src/MAIDOS.Driver.Native/scan_blob.cpp ../../src/MAIDOS.Driver.Native/driver_catalog.cpp ../../src/MAIDOS.Driver.Native/update_check.cpp ../../src/MAIDOS.Driver.Native/device_diagnostics.cpp ../../src/MAIDOS.Driver.Native/resource_conflicts.cpp -o native_bench_test
+// 執行: ./native_bench_test [最大設備數]
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <new>
+#include <sstream>
+#include <assert.h>
+#include "device_inventory.h"
+#include "scan_blob.h"
+#include "driver_catalog.h"
+#include "update_check.h"
+#include "device_diagnostics.h"
+#include "resource_conflicts.h"
+#include "logger.h"
+
+namespace fs = std::filesystem;
+
+// ---- 配置計數 ----
+static std::atomic<uint64_t> g_allocs{ 0 };
+static std::atomic<uint64_t> g_alloc_bytes{ 0 };
+
+void* operator new(size_t size) {
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+// ---- 日誌行數: 量測期間把 std::cout 換成只計數換行的緩衝區 ----
+class LineCounter : public std::streambuf {
+public:
+    uint64_t lines = 0;
+
+protected:
+    int overflow(int c) override {
+        if (c == '\n') lines++;
+        return c == EOF ? 0 : c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        for (std::streamsize i = 0; i < n; i++) lines += s[i] == '\n';
+        return n;
+    }
+};
+
+struct OpStats {
+    double us = 0;          // 每次操作
+    double allocs = 0;
+    double bytes = 0;
+    double enumerations = 0;
+    double reads = 0;
+    double log_lines = 0;
+};
+
+// setup 不計時 (例如模擬驅動更換)，run 為被量測的操作
+static OpStats Measure(FakeDeviceProvider& provider, int reps, const std::function<void(int)>& setup,
+                       const std::function<void()>& run) {
+    OpStats s;
+    LineCounter counter;
+    std::streambuf* saved = std::cout.rdbuf(&counter);
+    for (int r = 0; r < reps; r++) {
+        if (setup) setup(r);
+        uint64_t e0 = provider.EnumerationCount(), p0 = provider.PropertyReadCount();
+        uint64_t a0 = g_allocs.load(), b0 = g_alloc_bytes.load();
+        auto t0 = std::chrono::steady_clock::now();
+        run();
+        auto t1 = std::chrono::steady_clock::now();
+        s.us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+        s.allocs += (double)(g_allocs.load() - a0);
+        s.bytes += (double)(g_alloc_bytes.load() - b0);
+        s.enumerations += (double)(provider.EnumerationCount() - e0);
+        s.reads += (double)(provider.PropertyReadCount() - p0);
+    }
+    std::cout.rdbuf(saved);
+    s.log_lines = (double)counter.lines;
+    for (double* v : { &s.us, &s.allocs, &s.bytes, &s.enumerations, &s.reads, &s.log_lines }) *v /= reps;
+    return s;
+}
+
+static void Report(const char* op, size_t devices, const OpStats& s) {
+    std::ostringstream line;
+    line.setf(std::ios::fixed);
+    line.precision(1);
+    line << "[BENCH] op=" << op << " devices=" << devices << " us=" << s.us << " allocs=" << s.allocs
+         << " bytes=" << (uint64_t)s.bytes << " enum=" << s.enumerations << " reads=" << s.reads
+         << " log=" << s.log_lines;
+    std::cout << line.str() << std::endl;
+}
+
+static DeviceResource Resource(uint32_t type, uint64_t start, uint64_t end, uint32_t flags = 0) {
+    DeviceResource r;
+    r.type = type;
+    r.flags = flags;
+    r.start = start;
+    r.end = end;
+    return r;
+}
+
+// 模擬設備樹: 8 叉樹 (列 0 為根)，每設備一段 MMIO 與一個 IRQ (多數為 MSI，少數共用傳統 IRQ)，約 1% 設備有問題碼
+static FakeDeviceProvider MakeTree(size_t count) {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(count));
+    std::vector<DeviceRecord>& devices = provider.Devices();
+    for (size_t i = 0; i < count; i++) {
+        if (i % 97 == 50) {
+            devices[i].status = DEVICE_STATUS_HAS_PROBLEM;
+            devices[i].problem_code = DEVICE_PROBLEM_CODE43;
+        }
+        std::vector<DeviceResource> resources;
+        resources.push_back(Resource(DEVICE_RESOURCE_MEMORY, 0xC0000000ULL + i * 0x10000, 0xC0000000ULL + i * 0x10000 + 0xFFFF));
+        if (i % 64 == 0) resources.push_back(Resource(DEVICE_RESOURCE_IRQ, 16 + i % 8, 16 + i % 8, DEVICE_RESOURCE_SHARED));
+        else resources.push_back(Resource(DEVICE_RESOURCE_IRQ, 0xFFFFFF00ULL - i, 0xFFFFFF00ULL - i, DEVICE_RESOURCE_SHARED));
+        provider.SetNode(devices[i].instance_id, i ? devices[(i - 1) / 8].instance_id : std::string(), std::move(resources));
+    }
+    return provider;
+}
+
+static void RunSize(size_t n) {
+    FakeDeviceProvider provider = MakeTree(n);
+    DriverCatalog catalog = DriverCatalog::Synthetic(n < 1000 ? 1000 : n);
+    int reps = n <= 100 ? 200 : n <= 1000 ? 20 : 3;
+    size_t changes = n / 100 ? n / 100 : 1;
+
+    // 列舉: 完整快照 = 1 次列舉 + 每設備一次屬性讀取
+    OpStats s = Measure(provider, reps, nullptr, [&]() {
+        DeviceInventory inventory(provider);
+        assert(inventory.Snapshot());
+    });
+    assert(s.enumerations == 1 && s.reads == n);
+    Report("enumerate.snapshot", n, s);
+
+    // 增量刷新: 無變更時只做輕量列舉，不讀屬性
+    DeviceInventory inventory(provider);
+    Measure(provider, 1, nullptr, [&]() { assert(inventory.Snapshot()); });
+    s = Measure(provider, reps, nullptr, [&]() { assert(inventory.Refresh()); });
+    assert(s.enumerations == 1 && s.reads == 0);
+    Report("enumerate.refresh_idle", n, s);
+
+    // 增量刷新: 1% 設備更換驅動，只重讀這些設備
+    s = Measure(provider, reps, [&](int rep) {
+        for (size_t i = 0; i < changes; i++) {
+            provider.Devices()[(i * 101 + rep) % n].driver_version = "99.0." + std::to_string(rep) + "." + std::to_string(i);
+        }
+    }, [&]() { assert(inventory.Refresh()); });
+    assert(s.enumerations == 1 && s.reads <= changes);
+    Report("enumerate.refresh_1pct", n, s);
+
+    // 精簡掃描編碼 (兩段式呼叫)
+    std::vector<uint8_t> blob;
+    s = Measure(provider, reps, nullptr, [&]() {
+        size_t needed = 0;
+        EncodeScanBlob(inventory, nullptr, 0, &needed);
+        blob.resize(needed);
+        assert(EncodeScanBlob(inventory, blob.data(), blob.size(), nullptr) == needed);
+    });
+    assert(s.enumerations == 0 && s.reads == 0);
+    Report("scan.encode_blob", n, s);
+
+    // 目錄比對 (不跨界)
+    std::vector<DeviceRecord> records;
+    for (size_t row = 0; row < inventory.Size(); row++) records.push_back(inventory.Record(row));
+    std::vector<CatalogMatch> matches;
+    s = Measure(provider, reps, nullptr, [&]() { catalog.MatchAll(records, matches); });
+    assert(s.enumerations == 0 && s.reads == 0);
+    Report("match.catalog", n, s);
+
+    // 批次更新檢查: 一次列舉，與設備數無關
+    std::vector<UpdateResult> results(n);
+    LatestVersionLookup latest = [&](const DeviceRecord& d) {
+        CatalogMatch match;
+        return catalog.Match(d, match) ? match.entry->version : std::string();
+    };
+    s = Measure(provider, reps, nullptr, [&]() {
+        BatchUpdateChecker checker(provider);
+        assert(checker.Refresh());
+        assert(checker.CheckAll(results.data(), (int)n, latest) == (int)n);
+    });
+    assert(s.enumerations == 1);
+    Report("update.check_all", n, s);
+
+    // 診斷: 一次走訪設備樹
+    DiagnosticsReport report;
+    s = Measure(provider, reps, nullptr, [&]() { assert(RunDeviceDiagnostics(provider, report)); });
+    assert(s.enumerations == 1 && s.reads == 0);
+    assert(report.CountAtLeast(DIAG_SEVERITY_ERROR) >= n / 97);
+    Report("diag.run", n, s);
+
+    // 資源衝突分析 (不跨界)
+    std::vector<ResourceOverlap> overlaps;
+    s = Measure(provider, reps, nullptr, [&]() {
+        ResourceMap map;
+        map.Build(report);
+        map.FindOverlaps(overlaps);
+    });
+    assert(s.enumerations == 0 && s.reads == 0);
+    Report("diag.conflicts", n, s);
+
+    // 稽核日誌: 每設備一行 (舊版 scan_hardware_native 的記錄量)
+    s = Measure(provider, n <= 1000 ? reps : 1, nullptr, [&]() {
+        for (size_t i = 0; i < n; i++) AUDIT_LOG("SCAN", "Found: " + records[i].instance_id);
+    });
+    assert(s.log_lines == n);
+    Report("log.per_device", n, s);
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Native Benchmark Harness ===" << std::endl;
+    size_t max_devices = argc > 1 ? (size_t)atoi(argv[1]) : 10000;
+
+    // 稽核日誌檔寫在暫存目錄，不污染工作目錄
+    fs::path cwd = fs::current_path();
+    fs::path dir = fs::temp_directory_path() / "maidos_native_bench";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    fs::current_path(dir);
+
+    for (size_t n = 10; n <= max_devices; n *= 10) {
+        RunSize(n);
+        std::cout << "[TEST] " << n << " devices: crossing counts within bounds." << std::endl;
+    }
+
+    fs::current_path(cwd);
+    fs::remove_all(dir);
+    std::cout << "All Native Benchmark Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,221 @@
+// [MAIDOS-AUDIT] 驅動套件完整性驗證與雜湊快取測試 (可在 Linux 執行，使用暫存目錄中的合成套件)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native PackageVerifierTest.cpp ../../src/MAIDOS.Driver.Native/package_verifier.cpp ../../src/MAIDOS.Driver.Native/sha256.cpp -o package_verifier_test
+// 執行: ./package_verifier_test [套件大小MB]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <assert.h>
+#include "package_verifier.h"
+
+namespace fs = std::filesystem;
+
+static void WriteAll(const fs::path& path, const std::string& data) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), (std::streamsize)data.size());
+}
+
+static fs::path TempDir(const char* name) {
+    fs::path dir = fs::temp_directory_path() / name;
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    return dir;
+}
+
+static std::string Pattern(size_t size, uint32_t seed) {
+    std::string data(size, '\0');
+    uint32_t x = seed * 2654435761u + 1;
+    for (size_t i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        data[i] = (char)x;
+    }
+    return data;
+}
+
+// 合成套件: INF/CAT/SYS + 子目錄中的大檔
+static void MakePackage(const fs::path& root, size_t big_bytes) {
+    WriteAll(root / "maidosnet.inf", "[Version]\r\nSignature=\"$WINDOWS NT$\"\r\nDriverVer=01/02/2026,1.2.3.4\r\n");
+    WriteAll(root / "maidosnet.cat", Pattern(4096, 1));
+    WriteAll(root / "maidosnet.sys", Pattern(300000, 2));
+    WriteAll(root / "x64" / "helper.dll", Pattern(big_bytes, 3));
+    WriteAll(root / "x64" / "firmware.bin", Pattern(big_bytes / 2, 4));
+    WriteAll(root / "empty.txt", "");
+}
+
+void TestHashFile() {
+    fs::path dir = TempDir("maidos_verify_hash");
+    WriteAll(dir / "abc", "abc");
+    std::string hex;
+    assert(HashFileSha256((dir / "abc").string(), hex));
+    assert(hex == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    WriteAll(dir / "empty", "");
+    assert(HashFileSha256((dir / "empty").string(), hex));
+    assert(hex == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    std::string error;
+    assert(!HashFileSha256((dir / "missing").string(), hex, &error) && !error.empty());
+    fs::remove_all(dir);
+    std::cout << "[TEST] SHA-256 of files (known vectors)." << std::endl;
+}
+
+void TestManifestVerify() {
+    fs::path root = TempDir("maidos_verify_pkg");
+    MakePackage(root, 2 << 20);
+
+    PackageVerifier verifier(nullptr, 4);
+    std::vector<ExpectedHash> hashes;
+    assert(verifier.HashTree(root.string(), hashes));
+    assert(hashes.size() == 6);
+    std::string manifest = (root / PACKAGE_MANIFEST_NAME).string();
+    assert(WriteSha256Manifest(manifest, hashes));
+
+    std::vector<ExpectedHash> loaded;
+    assert(LoadSha256Manifest(manifest, loaded));
+    assert(loaded.size() == 6 && loaded[0].path == "empty.txt");
+
+    // 清單檔本身不在雜湊範圍
+    assert(verifier.HashTree(root.string(), hashes) && hashes.size() == 6);
+
+    PackageVerifyReport report;
+    assert(verifier.Verify(root.string(), loaded, report));
+    assert(report.files.size() == 6 && report.failed == 0 && report.hashed_bytes > (3u << 20));
+
+    // 改一個位元組、刪一個檔、加入不安全路徑
+    std::string sys = Pattern(300000, 2);
+    sys[12345] ^= 1;
+    WriteAll(root / "maidosnet.sys", sys);
+    fs::remove(root / "maidosnet.cat");
+    loaded.push_back(ExpectedHash{ "../outside.sys", loaded[0].sha256 });
+    loaded.push_back(ExpectedHash{ "/etc/passwd", loaded[0].sha256 });
+    assert(!verifier.Verify(root.string(), loaded, report));
+    assert(report.failed == 4);
+    for (const PackageFileResult& r : report.files) {
+        if (r.path == "maidosnet.sys") assert(r.status == PACKAGE_FILE_MISMATCH && r.actual.size() == 64);
+        if (r.path == "maidosnet.cat") assert(r.status == PACKAGE_FILE_MISSING);
+        if (r.path == "../outside.sys" || r.path == "/etc/passwd") assert(r.status == PACKAGE_FILE_UNSAFE);
+        if (r.path == "x64/helper.dll") assert(r.status == PACKAGE_FILE_OK);
+    }
+
+    // 清單格式錯誤
+    std::string error;
+    WriteAll(root / "bad.sha256", "# comment\nnot-a-hash  file\n");
+    assert(!LoadSha256Manifest((root / "bad.sha256").string(), loaded, &error) && error.find(":2:") != std::string::npos);
+    WriteAll(root / "star.sha256", std::string(64, 'a') + " *bin/file.sys\r\n");
+    assert(LoadSha256Manifest((root / "star.sha256").string(), loaded) && loaded[0].path == "bin/file.sys");
+
+    fs::remove_all(root);
+    std::cout << "[TEST] Manifest verify: mismatch, missing and unsafe paths." << std::endl;
+}
+
+void TestHashCache() {
+    fs::path root = TempDir("maidos_verify_cache");
+    MakePackage(root / "pkg", 1 << 20);
+    std::string cache_path = (root / "hashcache.txt").string();
+
+    HashCache cache(cache_path);
+    assert(cache.Load());
+    PackageVerifier verifier(&cache, 2);
+    std::vector<ExpectedHash> expected;
+    assert(verifier.HashTree((root / "pkg").string(), expected));
+    assert(cache.Size() == 6);
+
+    PackageVerifyReport report;
+    assert(verifier.Verify((root / "pkg").string(), expected, report));
+    assert(report.cache_hits == 6 && report.hashed_bytes == 0);
+    assert(cache.Save());
+
+    // 重新載入 (模擬下次執行): 全部命中
+    HashCache reloaded(cache_path);
+    assert(reloaded.Load() && reloaded.Size() == 6);
+    PackageVerifier warm(&reloaded, 2);
+    assert(warm.Verify((root / "pkg").string(), expected, report));
+    assert(report.cache_hits == 6 && report.hashed_bytes == 0);
+
+    // 內容改變且修改時間改變: 只重算該檔並偵測不符
+    fs::path sys = root / "pkg" / "maidosnet.sys";
+    std::string data = Pattern(300000, 2);
+    data[0] ^= 0x55;
+    WriteAll(sys, data);
+    fs::last_write_time(sys, fs::last_write_time(sys) + std::chrono::seconds(5));
+    assert(!warm.Verify((root / "pkg").string(), expected, report));
+    assert(report.cache_hits == 5 && report.hashed_bytes == 300000 && report.failed == 1);
+
+    // 以新檔取代 (大小與修改時間相同、inode 不同): 仍須重算
+    fs::path helper = root / "pkg" / "x64" / "helper.dll";
+    auto mtime = fs::last_write_time(helper);
+    std::string helper_data = Pattern(1 << 20, 3);
+    helper_data[100] ^= 1;
+    WriteAll(root / "replacement", helper_data);
+    fs::last_write_time(root / "replacement", mtime);
+    fs::rename(root / "replacement", helper);
+    assert(!warm.Verify((root / "pkg").string(), expected, report));
+    // maidosnet.sys 的新摘要已在上一輪寫回快取
+    assert(report.failed == 2 && report.cache_hits == 5 && report.hashed_bytes == (1u << 20));
+
+    // 清除已不存在的項目
+    fs::remove(root / "pkg" / "empty.txt");
+    assert(reloaded.Prune() >= 1);
+    assert(reloaded.Save());
+
+    // 快取檔損毀: 回報錯誤並清空
+    WriteAll(cache_path, "MAIDOS-HASHCACHE 1\nbroken line\n");
+    HashCache broken(cache_path);
+    std::string error;
+    assert(!broken.Load(&error) && broken.Size() == 0);
+
+    fs::remove_all(root);
+    std::cout << "[TEST] Hash cache keyed by path, size, mtime and file ID." << std::endl;
+}
+
+void BenchVerify(size_t megabytes) {
+    fs::path root = TempDir("maidos_verify_bench");
+    // 1 個大檔 + 200 個小檔
+    WriteAll(root / "pkg" / "big.bin", Pattern(megabytes << 20, 9));
+    for (int i = 0; i < 200; i++) WriteAll(root / "pkg" / "files" / ("f" + std::to_string(i) + ".sys"), Pattern(64 * 1024, 100 + i));
+
+    std::vector<ExpectedHash> expected;
+    PackageVerifier(nullptr, 1).HashTree((root / "pkg").string(), expected);
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    PackageVerifyReport report;
+    auto t0 = std::chrono::steady_clock::now();
+    assert(PackageVerifier(nullptr, 1).Verify((root / "pkg").string(), expected, report));
+    auto t1 = std::chrono::steady_clock::now();
+    assert(PackageVerifier(nullptr, 0).Verify((root / "pkg").string(), expected, report));
+    auto t2 = std::chrono::steady_clock::now();
+
+    HashCache cache((root / "cache.txt").string());
+    PackageVerifier cached(&cache, 0);
+    assert(cached.Verify((root / "pkg").string(), expected, report));
+    assert(cache.Save());
+    HashCache reloaded((root / "cache.txt").string());
+    assert(reloaded.Load());
+    auto t3 = std::chrono::steady_clock::now();
+    assert(PackageVerifier(&reloaded, 0).Verify((root / "pkg").string(), expected, report));
+    auto t4 = std::chrono::steady_clock::now();
+    assert(report.cache_hits == expected.size());
+
+    std::ostringstream line;
+    line << "[BENCH] files=" << expected.size() << " bytes=" << ((megabytes << 20) + 200 * 64 * 1024)
+         << " threads=1:" << us(t0, t1) << "us"
+         << " threads=" << std::thread::hardware_concurrency() << ":" << us(t1, t2) << "us"
+         << " warm_cache:" << us(t3, t4) << "us";
+    std::cout << line.str() << std::endl;
+    fs::remove_all(root);
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Package Verifier Test Suite ===" << std::endl;
+    TestHashFile();
+    TestManifestVerify();
+    TestHashCache();
+    BenchVerify(argc > 1 ? (size_t)atoi(argv[1]) : 64);
+    std::cout << "All Package Verifier Tests Passed!" << std::endl;
+    return 0;
+}
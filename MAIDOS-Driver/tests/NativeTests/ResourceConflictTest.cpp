@@ -0,0 +1,218 @@
+// [MAIDOS-AUDIT] 資源衝突分析測試 (假設備樹與假資源，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native ResourceConflictTest.cpp ../../src/MAIDOS.Driver.Native/resource_conflicts.cpp ../../src/MAIDOS.Driver.Native/device_diagnostics.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o resource_conflict_test
+// 執行: ./resource_conflict_test [設備數量]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <sstream>
+#include <tuple>
+#include <assert.h>
+#include "resource_conflicts.h"
+
+static DeviceResource Res(uint32_t type, uint64_t start, uint64_t end, uint32_t flags = 0) {
+    DeviceResource r;
+    r.type = type;
+    r.flags = flags;
+    r.start = start;
+    r.end = end;
+    return r;
+}
+
+static DeviceNode Node(const std::string& id, const std::string& parent, std::vector<DeviceResource> resources) {
+    DeviceNode n;
+    n.instance_id = id;
+    n.parent_id = parent;
+    n.status = DEVICE_STATUS_STARTED;
+    n.resources = std::move(resources);
+    return n;
+}
+
+void TestIntervalTree() {
+    std::vector<IntervalTree::Interval> items = { { 10, 20, 0 }, { 15, 15, 1 }, { 30, 40, 2 }, { 0, 5, 3 }, { 18, 35, 4 } };
+    IntervalTree tree;
+    tree.Build(items);
+    auto hits = [&](uint64_t s, uint64_t e) {
+        std::set<uint32_t> ids;
+        tree.Query(s, e, [&](const IntervalTree::Interval& it) { ids.insert(it.id); });
+        return ids;
+    };
+    assert(hits(15, 15) == (std::set<uint32_t>{ 0, 1 }));
+    assert(hits(20, 30) == (std::set<uint32_t>{ 0, 2, 4 }));
+    assert(hits(6, 9).empty());
+    assert(hits(5, 5) == (std::set<uint32_t>{ 3 }));
+    assert(hits(41, 100).empty());
+    assert(hits(0, ~0ULL).size() == 5);
+
+    IntervalTree empty;
+    empty.Build({});
+    assert(empty.Size() == 0 && [&] { bool any = false; empty.Query(0, ~0ULL, [&](const IntervalTree::Interval&) { any = true; }); return !any; }());
+    std::cout << "[TEST] Interval tree queries." << std::endl;
+}
+
+void TestMachineConflicts() {
+    DiagnosticsReport report;
+    report.nodes = {
+        Node("ROOT", "", {}),
+        // PCI 橋: 轉送視窗包含下游設備的範圍 (不算衝突)
+        Node("BRIDGE", "ROOT", { Res(DEVICE_RESOURCE_MEMORY, 0xF0000000, 0xF7FFFFFF), Res(DEVICE_RESOURCE_IO, 0xE000, 0xEFFF) }),
+        Node("GPU", "BRIDGE", { Res(DEVICE_RESOURCE_MEMORY, 0xF6000000, 0xF6FFFFFF), Res(DEVICE_RESOURCE_IO, 0xE000, 0xE07F),
+                                Res(DEVICE_RESOURCE_IRQ, 16, 16, DEVICE_RESOURCE_SHARED) }),
+        // 與 GPU 記憶體部分重疊 (衝突)、共用 IRQ 16 (可共用)
+        Node("NIC", "BRIDGE", { Res(DEVICE_RESOURCE_MEMORY, 0xF6FF0000, 0xF700FFFF), Res(DEVICE_RESOURCE_IRQ, 16, 16, DEVICE_RESOURCE_SHARED) }),
+        // 獨占 IRQ 16 (與共用者衝突)、IO 與 GPU 重疊
+        Node("LEGACY", "ROOT", { Res(DEVICE_RESOURCE_IRQ, 16, 16), Res(DEVICE_RESOURCE_IO, 0xE070, 0xE08F), Res(DEVICE_RESOURCE_DMA, 3, 3) }),
+        Node("SOUND", "ROOT", { Res(DEVICE_RESOURCE_DMA, 3, 3), Res(DEVICE_RESOURCE_IRQ, 5, 5) }),
+        // 自身重疊不算
+        Node("SELF", "ROOT", { Res(DEVICE_RESOURCE_MEMORY, 0x1000, 0x1FFF), Res(DEVICE_RESOURCE_MEMORY, 0x1800, 0x27FF) }),
+    };
+    EvaluateDiagnostics(report);
+
+    ResourceMap map;
+    map.Build(report);
+    assert(map.Count(DEVICE_RESOURCE_IRQ) == 4 && map.Count(DEVICE_RESOURCE_MEMORY) == 5);
+
+    std::vector<ResourceOverlap> overlaps;
+    size_t conflicts = map.FindOverlaps(overlaps);
+    auto id = [&](int32_t row) { return report.nodes[row].instance_id; };
+    std::set<std::tuple<uint32_t, std::string, std::string, bool>> found;
+    for (const ResourceOverlap& o : overlaps) found.emplace(o.type, id(o.device_a), id(o.device_b), o.conflict);
+
+    std::set<std::tuple<uint32_t, std::string, std::string, bool>> expected = {
+        { DEVICE_RESOURCE_IRQ, "GPU", "NIC", false },
+        { DEVICE_RESOURCE_IRQ, "GPU", "LEGACY", true },
+        { DEVICE_RESOURCE_IRQ, "NIC", "LEGACY", true },
+        { DEVICE_RESOURCE_MEMORY, "GPU", "NIC", true },
+        { DEVICE_RESOURCE_IO, "BRIDGE", "LEGACY", true },
+        { DEVICE_RESOURCE_IO, "GPU", "LEGACY", true },
+        { DEVICE_RESOURCE_DMA, "LEGACY", "SOUND", true },
+    };
+    assert(found == expected);
+    assert(overlaps.size() == expected.size() && conflicts == 6);
+
+    for (const ResourceOverlap& o : overlaps) {
+        if (o.type == DEVICE_RESOURCE_MEMORY) assert(o.start == 0xF6FF0000 && o.end == 0xF6FFFFFF);
+        if (o.type == DEVICE_RESOURCE_IO && id(o.device_a) == "GPU") assert(o.start == 0xE070 && o.end == 0xE07F);
+    }
+
+    std::vector<ResourceOwner> owners = map.Owners(DEVICE_RESOURCE_MEMORY, 0xF6800000, 0xF6800000);
+    assert(owners.size() == 2);  // BRIDGE 視窗 + GPU
+    assert(map.Owners(DEVICE_RESOURCE_DMA, 4, 7).empty());
+
+    // FFI 區塊
+    size_t needed = 0;
+    assert(EncodeConflictBlob(report, overlaps, nullptr, 0, &needed) == 0);
+    std::vector<uint8_t> blob(needed);
+    assert(EncodeConflictBlob(report, overlaps, blob.data(), needed - 1, nullptr) == 0);
+    assert(EncodeConflictBlob(report, overlaps, blob.data(), blob.size(), nullptr) == needed);
+    ConflictBlobHeader header;
+    memcpy(&header, blob.data(), sizeof(header));
+    assert(header.magic == CONFLICT_BLOB_MAGIC && header.count == overlaps.size() && header.conflicts == 6);
+    const char* strings = (const char*)blob.data() + header.strings_offset;
+    for (size_t i = 0; i < overlaps.size(); i++) {
+        ConflictBlobRecord r;
+        memcpy(&r, blob.data() + header.records_offset + i * sizeof(r), sizeof(r));
+        assert(std::string(strings + r.device_a.offset) == id(overlaps[i].device_a));
+        assert(std::string(strings + r.device_b.offset) == id(overlaps[i].device_b));
+        assert(r.start == overlaps[i].start && ((r.flags & CONFLICT_FLAG_CONFLICT) != 0) == overlaps[i].conflict);
+    }
+    std::cout << "[TEST] Machine conflicts: exclusive vs shared, bridge windows, self overlap." << std::endl;
+}
+
+// 隨機資源: 與兩兩比對的結果一致
+static void RandomMachine(size_t devices, uint32_t seed, DiagnosticsReport& report) {
+    std::mt19937_64 rng(seed);
+    report.nodes.clear();
+    for (size_t i = 0; i < devices; i++) {
+        std::vector<DeviceResource> res;
+        // 多數設備用 MSI (唯一向量、可共用)，少數用 24 條傳統 IRQ 線 (隨機共用/獨占)
+        uint64_t irq = rng() % 8 ? 0xFFFFFF00ULL - i : rng() % 24;
+        uint32_t flags = irq > 0xFFFF || rng() % 2 ? (uint32_t)DEVICE_RESOURCE_SHARED : 0u;
+        res.push_back(Res(DEVICE_RESOURCE_IRQ, irq, irq, flags));
+        uint64_t base = 0xE0000000ULL + (rng() % (devices * 4)) * 0x10000;
+        res.push_back(Res(DEVICE_RESOURCE_MEMORY, base, base + 0x1000 * (1 + rng() % 32) - 1));
+        uint64_t port = 0x1000 + (rng() % (devices * 8)) * 0x20;
+        res.push_back(Res(DEVICE_RESOURCE_IO, port, port + 0x1F));
+        std::string parent = i % 16 ? "DEV" + std::to_string(i - i % 16) : std::string();
+        report.nodes.push_back(Node("DEV" + std::to_string(i), parent, std::move(res)));
+    }
+    EvaluateDiagnostics(report);
+}
+
+static size_t BruteForce(const DiagnosticsReport& report, size_t* overlaps) {
+    auto related = [&](int32_t a, int32_t b) {
+        for (int32_t p = report.diagnoses[a].parent; p >= 0; p = report.diagnoses[p].parent) if (p == b) return true;
+        for (int32_t p = report.diagnoses[b].parent; p >= 0; p = report.diagnoses[p].parent) if (p == a) return true;
+        return false;
+    };
+    size_t conflicts = 0;
+    *overlaps = 0;
+    for (size_t a = 0; a < report.nodes.size(); a++) {
+        for (size_t b = a + 1; b < report.nodes.size(); b++) {
+            if (related((int32_t)a, (int32_t)b)) continue;
+            for (const DeviceResource& x : report.nodes[a].resources) {
+                for (const DeviceResource& y : report.nodes[b].resources) {
+                    if (x.type != y.type || x.end < y.start || y.end < x.start) continue;
+                    (*overlaps)++;
+                    conflicts += !((x.flags & DEVICE_RESOURCE_SHARED) && (y.flags & DEVICE_RESOURCE_SHARED));
+                }
+            }
+        }
+    }
+    return conflicts;
+}
+
+void TestAgainstBruteForce() {
+    for (uint32_t seed = 1; seed <= 5; seed++) {
+        DiagnosticsReport report;
+        RandomMachine(300, seed, report);
+        ResourceMap map;
+        map.Build(report);
+        std::vector<ResourceOverlap> overlaps;
+        size_t conflicts = map.FindOverlaps(overlaps);
+        size_t brute_overlaps = 0;
+        assert(conflicts == BruteForce(report, &brute_overlaps));
+        assert(overlaps.size() == brute_overlaps);
+    }
+    std::cout << "[TEST] Matches brute-force pairwise comparison." << std::endl;
+}
+
+void BenchConflicts(size_t devices) {
+    DiagnosticsReport report;
+    RandomMachine(devices, 42, report);
+
+    auto t0 = std::chrono::steady_clock::now();
+    ResourceMap map;
+    map.Build(report);
+    std::vector<ResourceOverlap> overlaps;
+    size_t conflicts = map.FindOverlaps(overlaps);
+    auto t1 = std::chrono::steady_clock::now();
+
+    size_t small = devices < 2000 ? devices : 2000;
+    DiagnosticsReport sample;
+    RandomMachine(small, 42, sample);
+    auto t2 = std::chrono::steady_clock::now();
+    size_t brute_overlaps = 0;
+    BruteForce(sample, &brute_overlaps);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    std::ostringstream line;
+    line << "[BENCH] devices=" << devices << " resources=" << devices * 3
+         << " interval_tree=" << us(t0, t1) << "us (" << overlaps.size() << " overlaps, " << conflicts << " conflicts)"
+         << " pairwise@" << small << "=" << us(t2, t3) << "us";
+    std::cout << line.str() << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Resource Conflict Test Suite ===" << std::endl;
+    TestIntervalTree();
+    TestMachineConflicts();
+    TestAgainstBruteForce();
+    BenchConflicts(argc > 1 ? (size_t)atoi(argv[1]) : 20000);
+    std::cout << "All Resource Conflict Tests Passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,203 @@
+// [MAIDOS-AUDIT] 精簡掃描編碼測試 (假設備來源，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native ScanBlobTest.cpp ../../src/MAIDOS.Driver.Native/scan_blob.cpp ../../src/MAIDOS.Driver.Native/device_inventory.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o scan_blob_test
+// 執行: ./scan_blob_test [設備數量]
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <assert.h>
+#include "scan_blob.h"
+
+// 舊版 scan_hardware_native 的每筆固定大小 (id/name/vendor 各 512 + version/status 各 64)
+static const size_t kLegacyRecordSize = 512 * 3 + 64 * 2;
+
+static std::vector<uint8_t> Encode(const DeviceInventory& inventory) {
+    size_t needed = 0;
+    assert(EncodeScanBlob(inventory, nullptr, 0, &needed) == 0);
+    std::vector<uint8_t> blob(needed);
+    assert(EncodeScanBlob(inventory, blob.data(), blob.size(), nullptr) == needed);
+    return blob;
+}
+
+void TestRoundTrip() {
+    std::vector<DeviceRecord> devices = FakeDeviceProvider::Synthetic(200);
+
+    // 長多字串 (超過舊結構的 512 位元組欄位) 與空欄位
+    DeviceRecord& big = devices[7];
+    for (int i = 0; i < 40; i++) big.hardware_ids.push_back("USB\\VID_046D&PID_C52B&REV_" + std::to_string(1200 + i) + "&MI_00");
+    big.name = std::string(700, 'N');
+    devices[8].compatible_ids.clear();
+    devices[9].manufacturer.clear();
+    devices[10].status = DEVICE_STATUS_HAS_PROBLEM;
+    devices[10].problem_code = 28;
+
+    FakeDeviceProvider provider(devices);
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+
+    std::vector<uint8_t> blob = Encode(inventory);
+    ScanBlobView view;
+    assert(view.Open(blob.data(), blob.size()));
+    assert(view.Count() == devices.size());
+    assert(view.Generation() == inventory.Generation());
+
+    for (size_t row = 0; row < inventory.Size(); row++) {
+        const ScanBlobRecord& r = view.Record(row);
+        DeviceRecord expected = inventory.Record(row);
+        assert(view.String(r.instance_id) == expected.instance_id);
+        assert(view.String(r.name) == expected.name);
+        assert(view.String(r.manufacturer) == expected.manufacturer);
+        assert(view.String(r.driver_version) == expected.driver_version);
+        assert(r.status == expected.status);
+        assert(r.problem_code == expected.problem_code);
+
+        std::vector<std::string_view> hardware = view.Multi(r.hardware_ids);
+        std::vector<std::string_view> compatible = view.Multi(r.compatible_ids);
+        assert(hardware.size() == r.hardware_id_count && hardware.size() == expected.hardware_ids.size());
+        assert(compatible.size() == r.compatible_id_count && compatible.size() == expected.compatible_ids.size());
+        for (size_t i = 0; i < hardware.size(); i++) assert(hardware[i] == expected.hardware_ids[i]);
+        for (size_t i = 0; i < compatible.size(); i++) assert(compatible[i] == expected.compatible_ids[i]);
+
+        // 字串以 NUL 結尾，可直接當 C 字串
+        assert(strlen(view.String(r.name).data()) == r.name.length);
+    }
+    std::cout << "[TEST] Round-trip keeps full multi-string IDs (" << blob.size() << " bytes)." << std::endl;
+}
+
+void TestBufferTooSmall() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(20));
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+
+    size_t needed = 0;
+    assert(EncodeScanBlob(inventory, nullptr, 1 << 20, &needed) == 0);
+    assert(needed > sizeof(ScanBlobHeader) + 20 * sizeof(ScanBlobRecord));
+
+    std::vector<uint8_t> blob(needed, 0xCD);
+    size_t again = 0;
+    assert(EncodeScanBlob(inventory, blob.data(), needed - 1, &again) == 0);
+    assert(again == needed);
+    assert(blob[0] == 0xCD);  // 不足時不寫入
+
+    assert(EncodeScanBlob(inventory, blob.data(), blob.size(), &again) == needed);
+    ScanBlobView view;
+    assert(view.Open(blob.data(), blob.size()));
+
+    // 空清單只有標頭
+    FakeDeviceProvider empty_provider;
+    DeviceInventory empty(empty_provider);
+    assert(empty.Snapshot());
+    std::vector<uint8_t> header = Encode(empty);
+    assert(header.size() == sizeof(ScanBlobHeader));
+    assert(view.Open(header.data(), header.size()) && view.Count() == 0);
+    std::cout << "[TEST] Two-call protocol reports needed size." << std::endl;
+}
+
+void TestDeduplication() {
+    // 同廠商、同版本、同相容ID 的設備共用字串
+    std::vector<DeviceRecord> devices = FakeDeviceProvider::Synthetic(400);
+    FakeDeviceProvider provider(devices);
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+    std::vector<uint8_t> blob = Encode(inventory);
+
+    ScanBlobView view;
+    assert(view.Open(blob.data(), blob.size()));
+    const ScanBlobRecord& a = view.Record(0);
+    const ScanBlobRecord& b = view.Record(4);
+    assert(view.String(a.manufacturer) == view.String(b.manufacturer));
+    assert(a.manufacturer.offset == b.manufacturer.offset);
+    assert(a.compatible_ids.offset == b.compatible_ids.offset);
+
+    size_t raw = 0;
+    for (const DeviceRecord& d : devices) {
+        raw += d.instance_id.size() + d.name.size() + d.manufacturer.size() + d.driver_version.size() + 6;
+        for (const std::string& id : d.hardware_ids) raw += id.size() + 1;
+        for (const std::string& id : d.compatible_ids) raw += id.size() + 1;
+    }
+    size_t strings = blob.size() - sizeof(ScanBlobHeader) - devices.size() * sizeof(ScanBlobRecord);
+    assert(strings < raw);
+    std::cout << "[TEST] String table deduplicated (" << strings << " of " << raw << " bytes)." << std::endl;
+}
+
+void TestRejectsCorruption() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(30));
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+    std::vector<uint8_t> blob = Encode(inventory);
+    ScanBlobView view;
+
+    // 任何截斷都必須被拒絕
+    for (size_t size = 0; size < blob.size(); size++) assert(!view.Open(blob.data(), size));
+    assert(!view.Open(nullptr, blob.size()));
+
+    std::vector<uint8_t> bad = blob;
+    bad[0] ^= 0xFF;
+    assert(!view.Open(bad.data(), bad.size()));
+
+    bad = blob;
+    ScanBlobHeader header;
+    memcpy(&header, bad.data(), sizeof(header));
+    header.count = 0x7FFFFFFF;
+    memcpy(bad.data(), &header, sizeof(header));
+    assert(!view.Open(bad.data(), bad.size()));
+
+    // 字串越界
+    bad = blob;
+    ScanBlobRecord record;
+    memcpy(&record, bad.data() + sizeof(ScanBlobHeader), sizeof(record));
+    record.name.length = 0xFFFFFFF0u;
+    memcpy(bad.data() + sizeof(ScanBlobHeader), &record, sizeof(record));
+    assert(!view.Open(bad.data(), bad.size()));
+
+    // 字串結尾不是 NUL
+    bad = blob;
+    memcpy(&record, bad.data() + sizeof(ScanBlobHeader), sizeof(record));
+    bad[sizeof(ScanBlobHeader) + 30 * sizeof(ScanBlobRecord) + record.name.offset + record.name.length] = 'X';
+    assert(!view.Open(bad.data(), bad.size()));
+
+    assert(view.Open(blob.data(), blob.size()));
+    std::cout << "[TEST] Truncated and corrupt blobs rejected." << std::endl;
+}
+
+void BenchEncode(size_t devices) {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(devices));
+    DeviceInventory inventory(provider);
+    assert(inventory.Snapshot());
+
+    const int rounds = 20;
+    std::vector<uint8_t> blob;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; i++) blob = Encode(inventory);
+    auto t1 = std::chrono::steady_clock::now();
+
+    ScanBlobView view;
+    size_t chars = 0;
+    for (int i = 0; i < rounds; i++) {
+        assert(view.Open(blob.data(), blob.size()));
+        for (uint32_t row = 0; row < view.Count(); row++) chars += view.String(view.Record(row).name).size();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    assert(chars > 0);
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count() / rounds; };
+    std::ostringstream line;
+    line << "[BENCH] devices=" << devices
+         << " compact=" << blob.size() << "B (" << blob.size() / devices << "B/device)"
+         << " legacy=" << devices * kLegacyRecordSize << "B (" << kLegacyRecordSize << "B/device)"
+         << " encode=" << us(t0, t1) << "us decode=" << us(t1, t2) << "us";
+    std::cout << line.str() << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "=== MAIDOS Scan Blob Test Suite ===" << std::endl;
+    TestRoundTrip();
+    TestBufferTooSmall();
+    TestDeduplication();
+    TestRejectsCorruption();
+    BenchEncode(argc > 1 ? (size_t)atoi(argv[1]) : 5000);
+    std::cout << "All Scan Blob Tests Passed!" << std::endl;
+    return 0;
+}
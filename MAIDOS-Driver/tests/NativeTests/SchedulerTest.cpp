@@ -0,0 +1,369 @@
+// [MAIDOS-AUDIT] 下載排程器測試 (可在 Linux 執行；模擬時鐘 + 本機 HTTP 伺服器)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native SchedulerTest.cpp ../../src/MAIDOS.Driver.Native/download_scheduler.cpp ../../src/MAIDOS.Driver.Native/download_engine.cpp ../../src/MAIDOS.Driver.Native/sha256.cpp ../../src/MAIDOS.Driver.Native/update_client.cpp -o scheduler_test
+// 執行: ./scheduler_test
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <assert.h>
+#include "download_scheduler.h"
+#include "sha256.h"
+#include "local_http_server.h"
+
+namespace fs = std::filesystem;
+
+// 假下載: 以 16KB 為單位經過 throttle/progress，不碰網路
+static DownloadResult FakeTransfer(const DownloadOptions& options, uint64_t size) {
+    DownloadResult r;
+    for (uint64_t done = 0; done < size;) {
+        if (options.cancel && options.cancel->load()) {
+            r.status = DOWNLOAD_CANCELLED;
+            return r;
+        }
+        uint64_t n = std::min<uint64_t>(16384, size - done);
+        if (options.throttle) options.throttle((size_t)n);
+        done += n;
+        if (options.progress) options.progress(done, size);
+    }
+    r.status = DOWNLOAD_OK;
+    r.total_bytes = r.fetched_bytes = size;
+    return r;
+}
+
+static DownloadJob Job(const std::string& url, int priority) {
+    DownloadJob job;
+    job.url = url;
+    job.priority = priority;
+    return job;
+}
+
+void TestTokenBucket() {
+    SimulatedClock clock;
+    const uint64_t rate = 1000000, burst = 64000;
+    TokenBucket bucket(rate, burst, clock);
+
+    assert(bucket.Acquire(burst) == 0);          // 初始額度
+    for (int i = 0; i < 10; i++) bucket.Acquire(100000);
+    assert(clock.NowUs() == 1000000);            // 1MB @ 1MB/s
+
+    // 閒置只累積到 burst
+    clock.Advance(10000000);
+    assert(bucket.Acquire(burst) == 0);
+    assert(bucket.Acquire(32000) == 32000);
+
+    // 改速率立即生效
+    bucket.SetRate(2000000);
+    uint64_t start = clock.NowUs();
+    bucket.Acquire(200000);
+    assert(clock.NowUs() - start == 100000);
+
+    bucket.SetRate(0);
+    assert(bucket.Acquire(1ull << 40) == 0);
+    std::cout << "[TEST] Token bucket meters bytes against simulated clock." << std::endl;
+}
+
+void TestTokenBucketShared() {
+    SimulatedClock clock;
+    TokenBucket bucket(4000000, 0, clock);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 100; i++) bucket.Acquire(10000);
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    // 4 執行緒合計 4MB @ 4MB/s: 總時間 1 秒，與執行緒數無關
+    assert(clock.NowUs() == 1000000);
+    std::cout << "[TEST] Shared bucket caps aggregate rate across threads." << std::endl;
+}
+
+void TestPriorityOrder() {
+    std::mutex lock;
+    std::vector<uint64_t> order;
+    SchedulerOptions options;
+    options.max_active = 1;
+    DownloadScheduler scheduler(options, SteadyClock::Instance(), [&](const DownloadJob& job, const DownloadOptions& o) {
+        std::lock_guard<std::mutex> guard(lock);
+        order.push_back(strtoull(job.url.c_str() + job.url.rfind('/') + 1, nullptr, 10));
+        return FakeTransfer(o, 1);
+    });
+
+    scheduler.Pause();
+    const int priorities[] = { DOWNLOAD_PRIORITY_LOW, DOWNLOAD_PRIORITY_NORMAL, DOWNLOAD_PRIORITY_CRITICAL,
+                               DOWNLOAD_PRIORITY_HIGH, DOWNLOAD_PRIORITY_CRITICAL, DOWNLOAD_PRIORITY_NORMAL };
+    for (int i = 0; i < 6; i++) {
+        scheduler.Submit(Job("http://cdn.example.com/" + std::to_string(i + 1), priorities[i]));
+    }
+    assert(scheduler.Queued() == 6);
+    scheduler.Resume();
+    assert(scheduler.WaitAll(5000));
+
+    std::vector<uint64_t> expected = { 3, 5, 4, 2, 6, 1 };
+    assert(order == expected);
+    std::cout << "[TEST] Critical first, FIFO within a priority." << std::endl;
+}
+
+void TestConcurrencyLimits() {
+    std::atomic<int> global{ 0 }, global_max{ 0 };
+    std::mutex lock;
+    std::map<std::string, int> host_now, host_max;
+    SchedulerOptions options;
+    options.max_active = 4;
+    options.max_per_host = 2;
+
+    DownloadScheduler scheduler(options, SteadyClock::Instance(), [&](const DownloadJob& job, const DownloadOptions& o) {
+        std::string host = DownloadScheduler::HostKey(job.url);
+        int g = ++global;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            host_max[host] = std::max(host_max[host], ++host_now[host]);
+            global_max = std::max(global_max.load(), g);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            host_now[host]--;
+        }
+        global--;
+        return FakeTransfer(o, 1);
+    });
+
+    for (int i = 0; i < 18; i++) {
+        scheduler.Submit(Job("http://host" + std::to_string(i % 3) + ".example.com/f" + std::to_string(i),
+                             DOWNLOAD_PRIORITY_NORMAL));
+    }
+    assert(scheduler.WaitAll(10000));
+    assert(global_max == 4);
+    for (auto& kv : host_max) assert(kv.second <= 2);
+    std::cout << "[TEST] Global limit 4, per-host limit 2 respected." << std::endl;
+}
+
+void TestBusyHostDoesNotBlockOthers() {
+    std::mutex lock;
+    std::vector<std::string> started;
+    SchedulerOptions options;
+    options.max_active = 2;
+    options.max_per_host = 1;
+    DownloadScheduler scheduler(options, SteadyClock::Instance(), [&](const DownloadJob& job, const DownloadOptions& o) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            started.push_back(DownloadScheduler::HostKey(job.url));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return FakeTransfer(o, 1);
+    });
+
+    scheduler.Pause();
+    for (int i = 0; i < 4; i++) scheduler.Submit(Job("http://a.example.com/" + std::to_string(i), DOWNLOAD_PRIORITY_CRITICAL));
+    scheduler.Submit(Job("http://b.example.com:8080/x", DOWNLOAD_PRIORITY_LOW));
+    scheduler.Resume();
+    assert(scheduler.WaitAll(5000));
+
+    // 主機 a 已佔滿名額，低優先序的主機 b 工作仍立即開始
+    assert(started.size() == 5);
+    assert(started[0] == "a.example.com:80" && started[1] == "b.example.com:8080");
+    std::cout << "[TEST] Saturated host does not starve other hosts." << std::endl;
+}
+
+void TestBandwidthSimulated() {
+    SimulatedClock clock;
+    SchedulerOptions options;
+    options.max_active = 4;
+    options.bytes_per_sec = 1024 * 1024;
+    options.burst_bytes = 0;
+
+    std::mutex lock;
+    std::map<uint64_t, uint64_t> last_done;
+    DownloadScheduler scheduler(options, clock, [](const DownloadJob&, const DownloadOptions& o) {
+        return FakeTransfer(o, 1024 * 1024);
+    });
+    for (int i = 0; i < 4; i++) {
+        DownloadJob job = Job("http://h" + std::to_string(i) + "/pkg", DOWNLOAD_PRIORITY_NORMAL);
+        job.on_progress = [&](uint64_t id, uint64_t done, uint64_t total) {
+            std::lock_guard<std::mutex> guard(lock);
+            assert(total == 1024 * 1024 && done >= last_done[id]);
+            last_done[id] = done;
+        };
+        scheduler.Submit(job);
+    }
+    assert(scheduler.WaitAll(10000));
+
+    // 4MB @ 1MB/s = 4 秒模擬時間
+    assert(clock.NowUs() == 4000000);
+    for (auto& kv : last_done) {
+        DownloadJobStatus status;
+        assert(scheduler.Status(kv.first, status));
+        assert(kv.second == 1024 * 1024 && status.done == 1024 * 1024);
+        assert(status.state == DOWNLOAD_STATE_FINISHED && status.result.status == DOWNLOAD_OK);
+    }
+    std::cout << "[TEST] Aggregate bandwidth shaped to 1MB/s on simulated clock." << std::endl;
+}
+
+void TestCancel() {
+    std::atomic<bool> running{ false };
+    SchedulerOptions options;
+    options.max_active = 1;
+    DownloadScheduler scheduler(options, SteadyClock::Instance(), [&](const DownloadJob&, const DownloadOptions& o) {
+        running = true;
+        while (!o.cancel->load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        DownloadResult r;
+        r.status = DOWNLOAD_CANCELLED;
+        return r;
+    });
+
+    std::atomic<int> cancelled{ 0 };
+    DownloadJob job = Job("http://a/1", DOWNLOAD_PRIORITY_NORMAL);
+    job.on_complete = [&](uint64_t, const DownloadResult& r) {
+        if (r.status == DOWNLOAD_CANCELLED) cancelled++;
+    };
+    uint64_t first = scheduler.Submit(job);
+    uint64_t second = scheduler.Submit(job);
+    while (!running) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    assert(scheduler.Cancel(second));   // 排隊中
+    assert(cancelled == 1 && scheduler.Queued() == 0);
+    assert(scheduler.Cancel(first));    // 執行中
+    assert(scheduler.WaitAll(5000));
+    assert(cancelled == 2);
+    assert(!scheduler.Cancel(first) && !scheduler.Cancel(999));
+    std::cout << "[TEST] Queued and running jobs cancel." << std::endl;
+}
+
+void TestFinishedJobsEvicted() {
+    SimulatedClock clock;
+    SchedulerOptions options;
+    options.max_finished = 3;
+    DownloadScheduler scheduler(options, clock, [](const DownloadJob&, const DownloadOptions& o) {
+        return FakeTransfer(o, 1000);
+    });
+
+    uint64_t first = scheduler.Submit(Job("http://a/1", DOWNLOAD_PRIORITY_NORMAL));
+    assert(scheduler.WaitAll(5000));
+    DownloadJobStatus status;
+    assert(scheduler.TakeStatus(first, status) && status.state == DOWNLOAD_STATE_FINISHED);
+    assert(!scheduler.Status(first, status));   // 讀取後即移除
+
+    // 從未被讀取的已完成工作只保留最新 max_finished 個
+    std::vector<uint64_t> ids;
+    for (int i = 0; i < 5; i++) {
+        ids.push_back(scheduler.Submit(Job("http://a/" + std::to_string(i), DOWNLOAD_PRIORITY_NORMAL)));
+        assert(scheduler.WaitAll(5000));
+    }
+    assert(!scheduler.Status(ids[0], status) && !scheduler.Status(ids[1], status));
+    for (size_t i = 2; i < ids.size(); i++) assert(scheduler.Status(ids[i], status));
+    std::cout << "[TEST] Finished jobs are evicted after their status is read." << std::endl;
+}
+
+void TestShutdown() {
+    SchedulerOptions options;
+    options.max_active = 1;
+    DownloadScheduler scheduler(options, SteadyClock::Instance(), [](const DownloadJob&, const DownloadOptions& o) {
+        while (!o.cancel->load()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        DownloadResult r;
+        r.status = DOWNLOAD_CANCELLED;
+        return r;
+    });
+
+    std::atomic<int> completed{ 0 };
+    DownloadJob job = Job("http://a/1", DOWNLOAD_PRIORITY_NORMAL);
+    job.on_complete = [&](uint64_t, const DownloadResult& r) {
+        assert(r.status == DOWNLOAD_CANCELLED);
+        completed++;
+    };
+    scheduler.Submit(job);
+    uint64_t queued = scheduler.Submit(job);
+
+    // 執行中與排隊中的工作都結束，之後不再接受新工作
+    scheduler.Shutdown();
+    assert(completed == 2);
+    assert(scheduler.WaitAll(0));
+    DownloadJobStatus status;
+    assert(scheduler.Status(queued, status) && status.result.status == DOWNLOAD_CANCELLED);
+    assert(scheduler.Submit(job) == 0);
+    scheduler.Shutdown();
+    std::cout << "[TEST] Shutdown cancels and joins workers." << std::endl;
+}
+
+static std::string HashOf(const std::string& s) {
+    Sha256 h;
+    h.Update(s.data(), s.size());
+    return h.FinalHex();
+}
+
+void TestEndToEnd() {
+    std::string a(1536 * 1024, 'a'), b(1024 * 1024, 'b');
+    for (size_t i = 0; i < a.size(); i++) a[i] = (char)(i * 31 + i / 4096);
+    LocalBlobServer hostA(a), hostB(b);
+
+    SchedulerOptions options;
+    options.max_active = 3;
+    options.max_per_host = 2;
+    options.bytes_per_sec = 8 * 1024 * 1024;
+    options.burst_bytes = 0;
+    DownloadScheduler scheduler(options);
+
+    std::vector<std::string> paths;
+    std::atomic<int> ok{ 0 };
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 6; i++) {
+        LocalBlobServer& server = i % 2 ? hostB : hostA;
+        DownloadJob job;
+        job.url = server.server.Url("/pkg" + std::to_string(i));
+        job.save_path = (fs::temp_directory_path() / ("maidos_sched_" + std::to_string(i) + ".bin")).string();
+        job.expected_sha256 = HashOf(server.blob);
+        job.priority = i == 5 ? DOWNLOAD_PRIORITY_CRITICAL : DOWNLOAD_PRIORITY_NORMAL;
+        job.on_complete = [&](uint64_t, const DownloadResult& r) {
+            if (r.status == DOWNLOAD_OK) ok++;
+        };
+        fs::remove(job.save_path);
+        paths.push_back(job.save_path);
+        scheduler.Submit(job);
+    }
+    assert(scheduler.WaitAll(30000));
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // 共 7.5MB @ 8MB/s
+    assert(ok == 6);
+    assert(secs > 0.85);
+    for (size_t i = 0; i < paths.size(); i++) {
+        assert(fs::file_size(paths[i]) == (i % 2 ? b.size() : a.size()));
+        fs::remove(paths[i]);
+    }
+    std::cout << "[TEST] 6 downloads over 2 hosts at 8MB/s took " << secs << "s." << std::endl;
+}
+
+void BenchDispatch(size_t jobs) {
+    SchedulerOptions options;
+    options.max_active = 8;
+    options.max_per_host = 8;
+    DownloadScheduler scheduler(options, SteadyClock::Instance(), [](const DownloadJob&, const DownloadOptions& o) {
+        return FakeTransfer(o, 1);
+    });
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < jobs; i++) {
+        scheduler.Submit(Job("http://h" + std::to_string(i % 16) + "/f", (int)(i % 4)));
+    }
+    scheduler.WaitAll();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "[BENCH] jobs=" << jobs << " dispatch=" << us << "us (" << (double)us / jobs << "us/job)" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting MAIDOS Scheduler Tests..." << std::endl;
+    TestTokenBucket();
+    TestTokenBucketShared();
+    TestPriorityOrder();
+    TestConcurrencyLimits();
+    TestBusyHostDoesNotBlockOthers();
+    TestBandwidthSimulated();
+    TestCancel();
+    TestFinishedJobsEvicted();
+    TestShutdown();
+    TestEndToEnd();
+
+    BenchDispatch(10000);
+    std::cout << "All Scheduler Tests Passed!" << std::endl;
+    return 0;
+}
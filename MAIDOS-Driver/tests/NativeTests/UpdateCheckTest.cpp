@@ -0,0 +1,149 @@
+// [MAIDOS-AUDIT] 批次更新檢查引擎測試 (假設備來源，可在 Linux 執行)
+// 編譯: g++ -std=c++17 -O2 -I../../src/MAIDOS.Driver.Native UpdateCheckTest.cpp ../../src/MAIDOS.Driver.Native/update_check.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o update_check_test
+// 執行: ./update_check_test [設備數量...]
+
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <assert.h>
+#include "update_check.h"
+
+void TestSingleEnumeration() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(250));
+    BatchUpdateChecker checker(provider);
+    assert(checker.Refresh());
+
+    std::vector<UpdateResult> results(250);
+    int count = checker.CheckAll(results.data(), (int)results.size());
+    assert(count == 250);
+    assert(provider.EnumerationCount() == 1);
+
+    for (int i = 0; i < count; i++) {
+        const DeviceRecord& d = checker.Devices()[i];
+        assert(d.instance_id == results[i].device_id);
+        assert(d.driver_version == results[i].current_version);
+        assert(results[i].update_available == 0);
+        assert(results[i].update_status == 1);
+    }
+    std::cout << "[TEST] 250 devices checked with 1 enumeration." << std::endl;
+}
+
+void TestLatestVersionLookup() {
+    std::vector<DeviceRecord> devices = FakeDeviceProvider::Synthetic(3);
+    devices[2].driver_version.clear();
+    FakeDeviceProvider provider(devices);
+    BatchUpdateChecker checker(provider);
+    assert(checker.Refresh());
+
+    const std::string target = devices[0].instance_id;
+    LatestVersionLookup latest = [&](const DeviceRecord& d) {
+        return d.instance_id == target ? std::string("99.0.0.0") : std::string();
+    };
+
+    UpdateResult results[3];
+    assert(checker.CheckAll(results, 3, latest) == 3);
+    assert(results[0].update_available == 1 && results[0].update_status == 0);
+    assert(strcmp(results[0].latest_version, "99.0.0.0") == 0);
+    assert(results[1].update_available == 0 && results[1].update_status == 1);
+    assert(strcmp(results[2].current_version, "Unknown") == 0);
+
+    // max_count 截斷
+    assert(checker.CheckAll(results, 2, latest) == 2);
+    std::cout << "[TEST] Latest version lookup applied." << std::endl;
+}
+
+void TestCheckManyPreservesOrder() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(10));
+    BatchUpdateChecker checker(provider);
+    assert(checker.Refresh());
+
+    const char* ids[] = {
+        checker.Devices()[7].instance_id.c_str(),
+        "NON_EXISTENT_DEVICE_ID",
+        checker.Devices()[0].instance_id.c_str(),
+        nullptr,
+    };
+    UpdateResult results[4];
+    assert(checker.CheckMany(ids, 4, results) == 2);
+    assert(strcmp(results[0].device_id, ids[0]) == 0 && results[0].update_status == 1);
+    assert(strcmp(results[1].current_version, "Not Found") == 0 && results[1].update_status == -1);
+    assert(strcmp(results[2].device_id, ids[2]) == 0);
+    assert(results[3].update_status == -1);
+    assert(provider.EnumerationCount() == 1);
+    std::cout << "[TEST] CheckMany keeps input order and flags missing devices." << std::endl;
+}
+
+void TestEnumerationFailure() {
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(5));
+    provider.SetFailure(true);
+    BatchUpdateChecker checker(provider);
+    assert(!checker.Refresh());
+    assert(checker.Find("anything") == nullptr);
+
+    UpdateResult results[5];
+    assert(checker.CheckAll(results, 5) == 0);
+    std::cout << "[TEST] Enumeration failure reported." << std::endl;
+}
+
+// 舊演算法: 每個設備重新列舉並線性搜尋實例ID (check_all_updates -> check_driver_update)
+static int LegacyCheckAll(IDeviceProvider& provider, UpdateResult* results, int max_count) {
+    std::vector<DeviceRecord> outer;
+    if (!provider.Enumerate(outer)) return -1;
+
+    int count = 0;
+    for (const DeviceRecord& d : outer) {
+        if (count >= max_count) break;
+        std::vector<DeviceRecord> inner;
+        provider.Enumerate(inner);
+        for (const DeviceRecord& candidate : inner) {
+            if (candidate.instance_id == d.instance_id) {
+                memset(&results[count], 0, sizeof(UpdateResult));
+                strncpy(results[count].device_id, candidate.instance_id.c_str(), MAX_PATH_LEN - 1);
+                strncpy(results[count].current_version, candidate.driver_version.c_str(), 63);
+                break;
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+void BenchAgainstLegacy(size_t devices) {
+    std::vector<UpdateResult> results(devices);
+
+    FakeDeviceProvider legacyProvider(FakeDeviceProvider::Synthetic(devices));
+    auto t0 = std::chrono::steady_clock::now();
+    LegacyCheckAll(legacyProvider, results.data(), (int)devices);
+    auto t1 = std::chrono::steady_clock::now();
+
+    FakeDeviceProvider batchProvider(FakeDeviceProvider::Synthetic(devices));
+    BatchUpdateChecker checker(batchProvider);
+    auto t2 = std::chrono::steady_clock::now();
+    checker.Refresh();
+    checker.CheckAll(results.data(), (int)devices);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    std::cout << "[BENCH] devices=" << devices
+              << " legacy=" << us(t0, t1) << "us (" << legacyProvider.EnumerationCount() << " enumerations)"
+              << " batch=" << us(t2, t3) << "us (" << batchProvider.EnumerationCount() << " enumerations)"
+              << std::endl;
+}
+
+int main(int argc, char** argv) {
+    std::cout << "Starting MAIDOS Update Check Tests..." << std::endl;
+    TestSingleEnumeration();
+    TestLatestVersionLookup();
+    TestCheckManyPreservesOrder();
+    TestEnumerationFailure();
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) BenchAgainstLegacy((size_t)atoi(argv[i]));
+    } else {
+        BenchAgainstLegacy(50);
+        BenchAgainstLegacy(250);
+    }
+    std::cout << "All Update Check Tests Passed!" << std::endl;
+    return 0;
+}
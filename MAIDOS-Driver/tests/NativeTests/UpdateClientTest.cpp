@@ -0,0 +1,268 @@
+// [MAIDOS-AUDIT] 線上更新檢查客戶端測試 (可在 Linux 執行，使用本機 HTTP 伺服器)
+// 編譯: g++ -std=c++17 -O2 -pthread -I../../src/MAIDOS.Driver.Native UpdateClientTest.cpp ../../src/MAIDOS.Driver.Native/update_client.cpp ../../src/MAIDOS.Driver.Native/update_check.cpp ../../src/MAIDOS.Driver.Native/device_provider.cpp -o update_client_test
+// 執行: ./update_client_test
+
+#include <iostream>
+#include <chrono>
+#include <unordered_map>
+#include <assert.h>
+#include "update_client.h"
+#include "update_check.h"
+#include "local_http_server.h"
+
+// 伺服器端: 依設備ID雜湊決定，約一半設備有 99.x 版本，其餘不認識
+static std::string LatestFor(const std::string& id) {
+    size_t h = std::hash<std::string>()(id);
+    return h % 2 == 0 ? "99." + std::to_string(h % 1000) : std::string();
+}
+
+static std::string UrlDecode(const std::string& s) {
+    std::string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '%' && i + 2 < s.size()) {
+            out.push_back((char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            out.push_back(s[i]);
+        }
+    }
+    return out;
+}
+
+static void UpdateHandler(const LocalRequest& req, LocalResponse& resp, bool batch, int delay_ms) {
+    if (delay_ms > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    if (req.method == "POST") {
+        if (!batch) {
+            resp.status = 405;
+            return;
+        }
+        resp.headers.emplace_back("Content-Type", UPDATE_BATCH_CONTENT_TYPE "; charset=utf-8");
+        size_t pos = 0;
+        while (pos < req.body.size()) {
+            size_t end = req.body.find('\n', pos);
+            std::string line = req.body.substr(pos, end - pos);
+            pos = end + 1;
+            std::string id = line.substr(0, line.find('\t'));
+            std::string latest = LatestFor(id);
+            resp.body += id + "\t" + (latest.empty() ? std::string() : "VERSION:" + latest) + "\n";
+        }
+        return;
+    }
+
+    std::string latest = LatestFor(UrlDecode(req.path.substr(req.path.find("/check/") + 7)));
+    if (latest.empty()) {
+        resp.status = 404;
+        return;
+    }
+    resp.body = "VERSION:" + latest + "\r\n";
+}
+
+static std::vector<UpdateQuery> Queries(size_t n) {
+    std::vector<UpdateQuery> queries;
+    for (const DeviceRecord& d : FakeDeviceProvider::Synthetic(n)) {
+        queries.push_back({ d.instance_id, d.driver_version });
+    }
+    return queries;
+}
+
+static void VerifyReplies(const std::vector<UpdateQuery>& queries, const std::vector<UpdateReply>& replies) {
+    assert(replies.size() == queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        assert(replies[i].ok);
+        assert(replies[i].latest_version == LatestFor(queries[i].device_id));
+    }
+}
+
+void TestHelpers() {
+    assert(UrlEncode("PCI\\VEN_10DE&DEV_2684") == "PCI%5CVEN_10DE%26DEV_2684");
+    assert(UrlEncode("a b~") == "a%20b~");
+    assert(ParseVersionResponse("VERSION:1.2.3\r\n") == "1.2.3");
+    assert(ParseVersionResponse(" 4.5 \n") == "4.5");
+
+    ParsedUrl url;
+    assert(ParsedUrl::Parse("http://127.0.0.1:8080/check/", url));
+    assert(url.host == "127.0.0.1" && url.port == 8080 && url.path == "/check/");
+    assert(ParsedUrl::Parse("HTTPS://updates.example.com", url));
+    assert(url.scheme == "https" && url.port == 443 && url.path == "/");
+    assert(!ParsedUrl::Parse("ftp://x/", url));
+    assert(!ParsedUrl::Parse("http://x:0/", url));
+    std::cout << "[TEST] URL encoding and response parsing." << std::endl;
+}
+
+void TestBatchSingleRequest() {
+    LocalHttpServer server([](const LocalRequest& q, LocalResponse& r) { UpdateHandler(q, r, true, 0); });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateCheckClient client(transport, "/check/");
+
+    std::vector<UpdateQuery> queries = Queries(500);
+    VerifyReplies(queries, client.Check(queries));
+    assert(server.Requests() == 1);
+    assert(client.RequestsSent() == 1);
+    std::cout << "[TEST] Batch mode checks 500 devices in one request." << std::endl;
+}
+
+void TestBatchReplyMustBeMarked() {
+    // 不認識批次協定的伺服器對 POST 回一般 200 頁面: 不可當成「全部沒有更新」
+    LocalHttpServer server([](const LocalRequest& q, LocalResponse& r) {
+        if (q.method == "POST") {
+            r.body = "<html>welcome</html>";
+            return;
+        }
+        UpdateHandler(q, r, false, 0);
+    });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateCheckClient client(transport, "/check/");
+
+    std::vector<UpdateQuery> queries = Queries(20);
+    VerifyReplies(queries, client.Check(queries));
+    assert(server.Requests() == 21);
+    std::cout << "[TEST] Unmarked 200 reply falls back to per-device checks." << std::endl;
+}
+
+void TestPartialBatchFallsBack() {
+    // 批次回應 (以首行標記) 只回覆前 10 個設備: 其餘逐設備查詢
+    std::vector<UpdateQuery> queries = Queries(30);
+    LocalHttpServer server([&](const LocalRequest& q, LocalResponse& r) {
+        if (q.method == "POST") {
+            r.body = UPDATE_BATCH_MARKER "\n";
+            for (size_t i = 0; i < 10; i++) {
+                std::string latest = LatestFor(queries[i].device_id);
+                r.body += queries[i].device_id + "\t" + latest + "\n";
+            }
+            return;
+        }
+        UpdateHandler(q, r, false, 0);
+    });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateCheckClient client(transport, "/check/");
+
+    VerifyReplies(queries, client.Check(queries));
+    assert(server.Requests() == 1 + 20);
+    std::cout << "[TEST] Devices missing from a batch reply are checked individually." << std::endl;
+}
+
+void TestFallbackReusesConnections() {
+    LocalHttpServer server([](const LocalRequest& q, LocalResponse& r) { UpdateHandler(q, r, false, 0); });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateClientOptions options;
+    options.max_parallel = 4;
+    UpdateCheckClient client(transport, "/check/", options);
+
+    std::vector<UpdateQuery> queries = Queries(200);
+    VerifyReplies(queries, client.Check(queries));
+    assert(server.Requests() == 201);                  // 1 次批次嘗試 + 200 次 GET
+    assert(transport.ConnectionsOpened() <= 4);        // 不超過並行上限
+    assert(server.Connections() == transport.ConnectionsOpened());
+    std::cout << "[TEST] Fallback GETs reuse " << transport.ConnectionsOpened() << " connections." << std::endl;
+}
+
+void TestServerClosesConnection() {
+    // 伺服器每次回應後關閉連線: 客戶端須重連而非失敗
+    LocalHttpServer server([](const LocalRequest& q, LocalResponse& r) {
+        UpdateHandler(q, r, false, 0);
+        r.close = true;
+    });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateClientOptions options;
+    options.batch = false;
+    options.max_parallel = 2;
+    UpdateCheckClient client(transport, "/check/", options);
+
+    std::vector<UpdateQuery> queries = Queries(20);
+    VerifyReplies(queries, client.Check(queries));
+    assert(transport.ConnectionsOpened() == 20);
+    std::cout << "[TEST] Connection: close forces reconnect." << std::endl;
+}
+
+void TestTimeout() {
+    LocalHttpServer server([](const LocalRequest& q, LocalResponse& r) { UpdateHandler(q, r, false, 300); });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateClientOptions options;
+    options.batch = false;
+    options.timeout_ms = 50;
+    options.max_parallel = 4;
+    UpdateCheckClient client(transport, "/check/", options);
+
+    std::vector<UpdateQuery> queries = Queries(4);
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<UpdateReply> replies = client.Check(queries);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t0).count();
+    for (const UpdateReply& r : replies) assert(!r.ok);
+    assert(ms < 250);
+    std::cout << "[TEST] Slow server times out after " << ms << "ms." << std::endl;
+}
+
+void TestCheckerIntegration() {
+    LocalHttpServer server([](const LocalRequest& q, LocalResponse& r) { UpdateHandler(q, r, true, 0); });
+    SocketTransport transport("127.0.0.1", server.Port());
+    UpdateCheckClient client(transport, "/check/");
+
+    FakeDeviceProvider provider(FakeDeviceProvider::Synthetic(50));
+    BatchUpdateChecker checker(provider);
+    assert(checker.Refresh());
+
+    std::vector<UpdateQuery> queries;
+    for (const DeviceRecord& d : checker.Devices()) queries.push_back({ d.instance_id, d.driver_version });
+    std::vector<UpdateReply> replies = client.Check(queries);
+
+    size_t next = 0;
+    std::vector<UpdateResult> results(50);
+    assert(checker.CheckAll(results.data(), 50, [&](const DeviceRecord&) { return replies[next++].latest_version; }) == 50);
+    for (size_t i = 0; i < 50; i++) {
+        assert(results[i].update_available == (LatestFor(queries[i].device_id).empty() ? 0 : 1));
+    }
+    std::cout << "[TEST] Online replies feed BatchUpdateChecker." << std::endl;
+}
+
+void BenchModes(size_t devices, int latency_ms) {
+    auto us = [](auto a, auto b) { return std::chrono::duration_cast<std::chrono::microseconds>(b - a).count(); };
+    std::vector<UpdateQuery> queries = Queries(devices);
+    LocalHttpServer batchServer([=](const LocalRequest& q, LocalResponse& r) { UpdateHandler(q, r, true, latency_ms); });
+    LocalHttpServer getServer([=](const LocalRequest& q, LocalResponse& r) { UpdateHandler(q, r, false, latency_ms); });
+
+    // 舊做法: 逐設備、每次新連線、序列
+    auto t0 = std::chrono::steady_clock::now();
+    for (const UpdateQuery& q : queries) {
+        SocketTransport fresh("127.0.0.1", getServer.Port(), 0);
+        HttpRequest req;
+        req.path = "/check/" + UrlEncode(q.device_id);
+        HttpResponse resp;
+        fresh.Send(req, resp, 5000);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    SocketTransport pooled("127.0.0.1", getServer.Port());
+    UpdateClientOptions options;
+    options.batch = false;
+    options.max_parallel = 8;
+    UpdateCheckClient parallel(pooled, "/check/", options);
+    parallel.Check(queries);
+    auto t2 = std::chrono::steady_clock::now();
+
+    SocketTransport single("127.0.0.1", batchServer.Port());
+    UpdateCheckClient batch(single, "/check/");
+    batch.Check(queries);
+    auto t3 = std::chrono::steady_clock::now();
+
+    std::cout << "[BENCH] devices=" << devices << " latency=" << latency_ms << "ms"
+              << " serial=" << us(t0, t1) << "us"
+              << " parallel8=" << us(t1, t2) << "us (" << pooled.ConnectionsOpened() << " conns)"
+              << " batch=" << us(t2, t3) << "us" << std::endl;
+}
+
+int main() {
+    std::cout << "Starting MAIDOS Update Client Tests..." << std::endl;
+    TestHelpers();
+    TestBatchSingleRequest();
+    TestBatchReplyMustBeMarked();
+    TestPartialBatchFallsBack();
+    TestFallbackReusesConnections();
+    TestServerClosesConnection();
+    TestTimeout();
+    TestCheckerIntegration();
+
+    BenchModes(250, 0);
+    BenchModes(100, 5);
+    std::cout << "All Update Client Tests Passed!" << std::endl;
+    return 0;
+}
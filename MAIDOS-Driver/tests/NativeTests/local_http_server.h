@@ -0,0 +1,245 @@
+#pragma once
+// [MAIDOS-AUDIT] 測試用本機 HTTP/1.1 伺服器 (POSIX，只綁 127.0.0.1)
+// 每個連線一個執行緒，支援 keep-alive；處理函式由測試提供
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct LocalRequest {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers;  // 名稱已轉小寫
+    std::string body;
+
+    std::string Header(const std::string& name) const {
+        auto it = headers.find(name);
+        return it == headers.end() ? std::string() : it->second;
+    }
+};
+
+struct LocalResponse {
+    int status = 200;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers;
+    bool close = false;     // 回應後關閉連線
+    bool abort = false;     // 不回應，直接斷線
+    uint64_t rate = 0;      // 每連線傳送速率上限 (bytes/s)，0=不限；模擬遠端頻寬
+    size_t cut_after = 0;   // >0: 本體只送出這麼多位元組就斷線
+};
+
+class LocalHttpServer {
+public:
+    using Handler = std::function<void(const LocalRequest&, LocalResponse&)>;
+
+    explicit LocalHttpServer(Handler handler) : handler_(std::move(handler)) {
+        listen_ = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(listen_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(listen_, (sockaddr*)&addr, sizeof(addr));
+        listen(listen_, 128);
+
+        socklen_t len = sizeof(addr);
+        getsockname(listen_, (sockaddr*)&addr, &len);
+        port_ = ntohs(addr.sin_port);
+        acceptor_ = std::thread([this]() { AcceptLoop(); });
+    }
+
+    ~LocalHttpServer() {
+        stopping_ = true;
+        shutdown(listen_, SHUT_RDWR);
+        close(listen_);
+        acceptor_.join();
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            for (int s : open_) shutdown(s, SHUT_RDWR);
+        }
+        for (std::thread& t : workers_) t.join();
+    }
+
+    uint16_t Port() const { return port_; }
+    std::string Url(const std::string& path) const { return "http://127.0.0.1:" + std::to_string(port_) + path; }
+    uint64_t Connections() const { return connections_.load(); }
+    uint64_t Requests() const { return requests_.load(); }
+
+private:
+    void AcceptLoop() {
+        while (!stopping_) {
+            int s = accept(listen_, nullptr, nullptr);
+            if (s < 0) break;
+            int one = 1;
+            setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            connections_++;
+            std::lock_guard<std::mutex> guard(lock_);
+            open_.push_back(s);
+            workers_.emplace_back([this, s]() { Serve(s); });
+        }
+    }
+
+    static bool ReadRequest(int s, std::string& buf, LocalRequest& req) {
+        char chunk[8192];
+        size_t end;
+        while ((end = buf.find("\r\n\r\n")) == std::string::npos) {
+            ssize_t n = recv(s, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            buf.append(chunk, (size_t)n);
+        }
+
+        std::string head = buf.substr(0, end);
+        size_t line_end = head.find("\r\n");
+        std::string line = head.substr(0, line_end);
+        size_t sp1 = line.find(' '), sp2 = line.rfind(' ');
+        req.method = line.substr(0, sp1);
+        req.path = line.substr(sp1 + 1, sp2 - sp1 - 1);
+        req.headers.clear();
+
+        size_t pos = line_end == std::string::npos ? head.size() : line_end + 2;
+        while (pos < head.size()) {
+            size_t next = head.find("\r\n", pos);
+            if (next == std::string::npos) next = head.size();
+            std::string h = head.substr(pos, next - pos);
+            size_t colon = h.find(':');
+            if (colon != std::string::npos) {
+                std::string name = h.substr(0, colon);
+                for (char& c : name) c = (char)tolower((unsigned char)c);
+                size_t v = h.find_first_not_of(' ', colon + 1);
+                req.headers[name] = v == std::string::npos ? std::string() : h.substr(v);
+            }
+            pos = next + 2;
+        }
+
+        size_t length = (size_t)atoll(req.Header("content-length").c_str());
+        buf.erase(0, end + 4);
+        while (buf.size() < length) {
+            ssize_t n = recv(s, chunk, sizeof(chunk), 0);
+            if (n <= 0) return false;
+            buf.append(chunk, (size_t)n);
+        }
+        req.body = buf.substr(0, length);
+        buf.erase(0, length);
+        return true;
+    }
+
+    void Serve(int s) {
+        std::string buf;
+        LocalRequest req;
+        while (!stopping_ && ReadRequest(s, buf, req)) {
+            requests_++;
+            LocalResponse resp;
+            handler_(req, resp);
+            if (resp.abort) break;
+
+            bool close_after = resp.close || req.Header("connection") == "close";
+            std::string wire = "HTTP/1.1 " + std::to_string(resp.status) + " X\r\nContent-Length: " +
+                               std::to_string(resp.body.size()) + "\r\n";
+            for (auto& h : resp.headers) wire += h.first + ": " + h.second + "\r\n";
+            if (close_after) wire += "Connection: close\r\n";
+            wire += "\r\n";
+            size_t limit = resp.cut_after > 0 && resp.cut_after < resp.body.size() ? wire.size() + resp.cut_after : 0;
+            wire += resp.body;
+            if (limit > 0) {
+                wire.resize(limit);
+                close_after = true;
+            }
+
+            size_t sent = 0;
+            auto start = std::chrono::steady_clock::now();
+            while (sent < wire.size()) {
+                size_t piece = wire.size() - sent;
+                if (resp.rate > 0) {
+                    if (piece > 16384) piece = 16384;
+                    auto due = start + std::chrono::microseconds(sent * 1000000 / resp.rate);
+                    std::this_thread::sleep_until(due);
+                }
+                ssize_t n = send(s, wire.data() + sent, piece, MSG_NOSIGNAL);
+                if (n <= 0) break;
+                sent += (size_t)n;
+            }
+            if (close_after || sent < wire.size()) break;
+        }
+        shutdown(s, SHUT_RDWR);
+        std::lock_guard<std::mutex> guard(lock_);
+        for (size_t i = 0; i < open_.size(); i++) {
+            if (open_[i] == s) {
+                open_.erase(open_.begin() + (long)i);
+                break;
+            }
+        }
+        close(s);
+    }
+
+    Handler handler_;
+    int listen_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stopping_{ false };
+    std::atomic<uint64_t> connections_{ 0 };
+    std::atomic<uint64_t> requests_{ 0 };
+    std::mutex lock_;
+    std::vector<int> open_;
+    std::vector<std::thread> workers_;
+    std::thread acceptor_;
+};
+
+// 提供單一檔案的測試伺服器 (支援 Range，可模擬故障)
+struct LocalBlobServer {
+    std::string blob;
+    std::string etag = "\"v1\"";
+    bool ranges = true;
+    uint64_t rate = 0;
+    std::atomic<int> fail_after{ -1 };   // >=0: 第 N 個請求之後全部斷線
+    std::atomic<int> cut_request{ -1 };  // 該請求只送出一半本體
+    std::atomic<int> change_after{ -1 }; // >=0: 第 N 個請求起檔案視為已更新 (ETag 改為 "v2")
+    std::atomic<int> served{ 0 };
+    LocalHttpServer server;
+
+    explicit LocalBlobServer(std::string data)
+        : blob(std::move(data)), server([this](const LocalRequest& q, LocalResponse& r) { Handle(q, r); }) {}
+
+    void Handle(const LocalRequest& req, LocalResponse& resp) {
+        int n = served++;
+        if (fail_after >= 0 && n >= fail_after) {
+            resp.abort = true;
+            return;
+        }
+        resp.rate = rate;
+        std::string current = change_after >= 0 && n >= change_after ? std::string("\"v2\"") : etag;
+        resp.headers.emplace_back("ETag", current);
+        std::string range = req.Header("range");
+        std::string if_range = req.Header("if-range");
+        // If-Range 不符時忽略 Range，回傳完整檔案 (RFC 9110)
+        if (ranges && range.compare(0, 6, "bytes=") == 0 && (if_range.empty() || if_range == current)) {
+            uint64_t start = strtoull(range.c_str() + 6, nullptr, 10);
+            uint64_t end = strtoull(range.c_str() + range.find('-') + 1, nullptr, 10);
+            if (start >= blob.size()) {
+                resp.status = 416;
+                return;
+            }
+            if (end >= blob.size()) end = blob.size() - 1;
+            resp.status = 206;
+            resp.body = blob.substr(start, end - start + 1);
+            resp.headers.emplace_back("Content-Range", "bytes " + std::to_string(start) + "-" + std::to_string(end) +
+                                                           "/" + std::to_string(blob.size()));
+        } else {
+            resp.body = blob;
+        }
+        if (n == cut_request) resp.cut_after = resp.body.size() / 2;
+    }
+};
@@ -6,23 +6,28 @@
 HINSTANCE g_hInst;
 
 // DLL 入口點
+// 引擎與其背景執行緒在 loader lock 之外建立與停止：首次 ImeSelect/ImeProcessKey 時初始化，
+// ImeDestroy 時清理；這裡只記錄實例句柄
 BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpReserved) {
     switch (dwReason) {
         case DLL_PROCESS_ATTACH:
             g_hInst = hInstance;
-            // 初始化 IME 模組
-            InitializeImeModule();
-            break;
-            
-        case DLL_PROCESS_DETACH:
-            // 清理 IME 模組
-            CleanupImeModule();
+            DisableThreadLibraryCalls(hInstance);
             break;
     }
     
     return TRUE;
 }
 
+// IME 終止：在卸載前停止引擎的背景執行緒
+__declspec(dllexport) BOOL WINAPI ImeDestroy(UINT uReserved) {
+    if (uReserved != 0) {
+        return FALSE;
+    }
+    CleanupImeModule();
+    return TRUE;
+}
+
 // IME 組件入口點
 __declspec(dllexport) HRESULT WINAPI ImeSelect(HIMC hIMC, BOOL fSelect) {
     if (fSelect) {
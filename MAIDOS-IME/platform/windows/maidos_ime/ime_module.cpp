@@ -6,21 +6,67 @@
 #include <algorithm>
 #include <locale>
 #include <codecvt>
+#include <mutex>
+#include <map>
 
 // 包含C++核心引擎頭文件
 #include "ime_engine.h"
+#include "typing_trace.h"
 
-// 全局引擎實例
-static std::unique_ptr<ImeEngine> g_engine;
+// 全局引擎實例：引擎會啟動詞組挖掘執行緒，只能在 DllMain 之外建立與停止，
+// 因此不用靜態物件的解構（DLL 卸載時在 loader lock 下執行）而由 CleanupImeModule 明確釋放
+static ImeEngine* g_engine = nullptr;
+static std::mutex g_engineLock;
 // 當前輸入緩衝區
 static std::wstring inputBuffer;
 // 候選字詞列表
 static std::vector<Candidate> candidateList;
+// 打字軌跡紀錄（設定 MAIDOS_IME_TRACE_DIR 時啟用）：紀錄器的環形緩衝區只允許單一生產者，
+// 而 HIMC 屬於建立它的執行緒，所以每個輸入上下文各有一個紀錄器 (nullptr 表示未啟用)；
+// 同引擎一樣只在 DllMain 之外開啟與關閉
+static std::map<HIMC, TypingTraceRecorder*> g_traces;
+static std::mutex g_traceLock;
 
-// 初始化 IME 模組
+// 取得上下文的紀錄器，首次使用時依環境變數開啟
+static TypingTraceRecorder* TraceFor(HIMC hIMC) {
+    std::lock_guard<std::mutex> lock(g_traceLock);
+    auto it = g_traces.find(hIMC);
+    if (it != g_traces.end()) {
+        return it->second;
+    }
+    TypingTraceRecorder* trace = new TypingTraceRecorder();
+    if (!trace->OpenFromEnvironment()) {
+        delete trace;
+        trace = nullptr;
+    }
+    g_traces[hIMC] = trace;
+    return trace;
+}
+
+// 關閉並移除上下文的紀錄器（等待寫入執行緒，鎖外進行）
+static void CloseTrace(HIMC hIMC) {
+    TypingTraceRecorder* trace = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(g_traceLock);
+        auto it = g_traces.find(hIMC);
+        if (it == g_traces.end()) {
+            return;
+        }
+        trace = it->second;
+        g_traces.erase(it);
+    }
+    delete trace;
+}
+
+// 初始化 IME 模組（首次選用或按鍵時呼叫，可重複呼叫）
 void InitializeImeModule() {
+    std::lock_guard<std::mutex> lock(g_engineLock);
+    if (g_engine) {
+        return;
+    }
+
     // 初始化 C++ 核心引擎
-    g_engine = std::make_unique<ImeEngine>();
+    g_engine = new ImeEngine();
     
     // 初始化引擎
     std::wstring configPath = L"src/config/maidos.toml"; // 配置文件路徑
@@ -30,15 +76,27 @@ void InitializeImeModule() {
     candidateList.clear();
 }
 
-// 清理 IME 模組
+// 清理 IME 模組（由 ImeDestroy 呼叫，會等待背景執行緒結束）
 void CleanupImeModule() {
-    g_engine.reset();
+    std::map<HIMC, TypingTraceRecorder*> traces;
+    {
+        std::lock_guard<std::mutex> lock(g_traceLock);
+        traces.swap(g_traces);
+    }
+    for (auto& entry : traces) {
+        delete entry.second;
+    }
+
+    std::lock_guard<std::mutex> lock(g_engineLock);
+    delete g_engine;
+    g_engine = nullptr;
     inputBuffer.clear();
     candidateList.clear();
 }
 
 // 啟用 IME 上下文
 HRESULT ActivateImeContext(HIMC hIMC) {
+    InitializeImeModule();
     // 設置 IME 狀態為開啟
     ImmAssociateContext(GetFocus(), hIMC);
     return S_OK;
@@ -46,6 +104,7 @@ HRESULT ActivateImeContext(HIMC hIMC) {
 
 // 停用 IME 上下文
 HRESULT DeactivateImeContext(HIMC hIMC) {
+    CloseTrace(hIMC);
     // 設置 IME 狀態為關閉
     ImmAssociateContext(GetFocus(), NULL);
     return S_OK;
@@ -53,6 +112,10 @@ HRESULT DeactivateImeContext(HIMC hIMC) {
 
 // 處理鍵盤事件
 BOOL ProcessImeKey(HIMC hIMC, UINT vKey, LPARAM lParam, const BYTE* lpbKeyState) {
+    InitializeImeModule();
+    TypingTraceRecorder* trace = TraceFor(hIMC);
+    if (trace) trace->OnKey(TraceKeyClassFromVirtualKey(vKey));
+
     // 簡單示例：只處理字母鍵和空格鍵
     if (vKey >= 'A' && vKey <= 'Z') {
         // 添加字母到輸入緩衝區
@@ -61,6 +124,11 @@ BOOL ProcessImeKey(HIMC hIMC, UINT vKey, LPARAM lParam, const BYTE* lpbKeyState)
     } else if (vKey == VK_SPACE) {
         // 空格鍵觸發選字
         GetCandidatesFromCore(nullptr, nullptr, 0);
+        if (trace && candidateList.empty()) {
+            trace->OnBreak();
+        } else if (trace) {
+            trace->OnCommit(0, candidateList[0].character.size());
+        }
         inputBuffer.clear();
         return TRUE;
     } else if (vKey == VK_BACK) {
@@ -13,10 +13,10 @@ class ImeEngine;
 extern "C" {
 #endif
 
-// 初始化 IME 模組
+// 初始化 IME 模組（延遲到首次 ImeSelect/ImeProcessKey；不可在 DllMain 中呼叫）
 void InitializeImeModule();
 
-// 清理 IME 模組
+// 清理 IME 模組（ImeDestroy；會停止背景執行緒，不可在 DllMain 中呼叫）
 void CleanupImeModule();
 
 // 啟用 IME 上下文
@@ -143,6 +143,30 @@ bool ImeEngine::Initialize(const std::wstring& configPath)
         pinyinScheme->SetParser(m_pinyinParser.get());
         m_schemes[L"pinyin"] = std::move(pinyinScheme);
         m_schemes[L"bopomofo"] = std::make_unique<BopomofoScheme>();
+        // One scheme per Shuangpin layout; plain "shuangpin" is the default layout
+        auto shuangpinScheme = std::make_unique<ShuangpinScheme>();
+        shuangpinScheme->SetParser(m_pinyinParser.get());
+        m_schemes[L"shuangpin"] = std::move(shuangpinScheme);
+        for (const ShuangpinLayout* layout : ShuangpinLayouts())
+        {
+            auto layoutScheme = std::make_unique<ShuangpinScheme>(*layout);
+            layoutScheme->SetParser(m_pinyinParser.get());
+            m_schemes[std::wstring(L"shuangpin_") + layout->name] = std::move(layoutScheme);
+        }
+
+        // Soft-config: MAIDOS_IME_SCHEME selects the active scheme (unknown names keep pinyin)
+        const std::wstring scheme = GetEnvVarW(L"MAIDOS_IME_SCHEME");
+        if (!scheme.empty())
+        {
+            SetDefaultScheme(scheme);
+        }
+
+        // Phrase mining runs on its own thread; commits only enqueue. Readings are
+        // spaced syllables, so phrases join as "ni hao shi jie"
+        PhraseMiner::Options minerOptions;
+        minerOptions.readingSeparator = L" ";
+        m_phraseMiner = std::make_unique<PhraseMiner>(minerOptions);
+        m_phraseMiner->Start();
 
         return true;
     }
@@ -152,6 +176,29 @@ bool ImeEngine::Initialize(const std::wstring& configPath)
     }
 }
 
+// Select the active scheme
+bool ImeEngine::SetDefaultScheme(const std::wstring& schemeName)
+{
+    if (schemeName != L"pinyin" && m_schemes.find(schemeName) == m_schemes.end())
+    {
+        return false;
+    }
+    m_defaultScheme = schemeName;
+    return true;
+}
+
+// Check whether a key belongs in the composition
+bool ImeEngine::IsCompositionKey(wchar_t key) const
+{
+    if ((key >= L'a' && key <= L'z') || (key >= L'A' && key <= L'Z'))
+    {
+        return true;
+    }
+    auto it = m_schemes.find(m_defaultScheme);
+    const auto* shuangpin = it != m_schemes.end() ? dynamic_cast<const ShuangpinScheme*>(it->second.get()) : nullptr;
+    return shuangpin && shuangpin->UsesKey(key);
+}
+
 // Process input
 std::vector<ImeEngine::Candidate> ImeEngine::ProcessInput(const std::wstring& input, const std::wstring& context)
 {
@@ -235,6 +282,98 @@ std::vector<ImeEngine::Candidate> ImeEngine::GetCrossCandidates(const std::wstri
     return GetCandidatesFromScheme(input, scheme);
 }
 
+// Record a committed candidate
+void ImeEngine::CommitCandidate(const std::wstring& input, const std::wstring& candidate,
+                                const std::wstring& scheme)
+{
+    if (!m_phraseMiner)
+        return;
+
+    ApplyMinedPhrases();
+    const std::wstring reading = CommitReading(input, scheme.empty() ? m_defaultScheme : scheme);
+    if (reading.empty())
+    {
+        m_phraseMiner->BreakSequence();
+        return;
+    }
+    m_phraseMiner->RecordCommit(reading, candidate);
+}
+
+// Toneless pinyin reading of a composition ("" if the scheme has none)
+std::wstring ImeEngine::CommitReading(const std::wstring& input, const std::wstring& schemeName)
+{
+    // Shuangpin keys are layout keystrokes; the dictionary only knows their syllables
+    auto it = m_schemes.find(schemeName);
+    if (auto* shuangpin = it != m_schemes.end() ? dynamic_cast<ShuangpinScheme*>(it->second.get()) : nullptr)
+    {
+        return shuangpin->ReadingFor(input);
+    }
+    if (schemeName != L"pinyin")
+    {
+        return std::wstring();
+    }
+
+    std::vector<TonedSyllableId> syllables;
+    if (!ParsePinyinReading(input, syllables, false))
+    {
+        return std::wstring();
+    }
+    std::wstring reading;
+    for (TonedSyllableId syllable : syllables)
+    {
+        if (!reading.empty())
+        {
+            reading.push_back(L' ');
+        }
+        for (char ch : PinyinSyllableText(TonedSyllableBase(syllable)))
+        {
+            reading.push_back(static_cast<wchar_t>(ch));
+        }
+    }
+    return reading;
+}
+
+// End the current commit sequence
+void ImeEngine::BreakCommitSequence()
+{
+    if (m_phraseMiner)
+    {
+        m_phraseMiner->BreakSequence();
+    }
+}
+
+// Add mined phrases to the dictionary
+size_t ImeEngine::ApplyMinedPhrases()
+{
+    if (!m_phraseMiner || !m_dictionary)
+        return 0;
+
+    std::vector<PhraseMiner::MinedPhrase> phrases;
+    if (m_phraseMiner->TakePromotions(phrases) == 0)
+        return 0;
+
+    size_t added = 0;
+    for (const auto& phrase : phrases)
+    {
+        const auto existing = m_dictionary->Lookup(phrase.reading);
+        const bool known = std::any_of(existing.begin(), existing.end(),
+            [&phrase](const Dictionary::DictEntry& e) { return e.word == phrase.word; });
+        if (known)
+            continue;
+
+        m_dictionary->AddEntry(phrase.reading, Dictionary::DictEntry{
+            phrase.word, 1000 + phrase.count, phrase.reading, { L"user_phrase" } });
+        ++added;
+
+        // Append only the new posting; a full rebuild would re-parse the whole dictionary on commit
+        if (m_pinyinParser)
+        {
+            m_pinyinParser->IndexAddedEntry(phrase.reading);
+        }
+    }
+    return added;
+}
+
 // Load configuration
 void ImeEngine::LoadConfiguration(const std::wstring& configPath)
 {
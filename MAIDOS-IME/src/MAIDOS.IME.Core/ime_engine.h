@@ -6,6 +6,8 @@
 #include "converter.h"
 #include "schemes.h"
 #include "bopomofo_scheme.h"
+#include "shuangpin_scheme.h"
+#include "phrase_miner.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -75,6 +77,15 @@ public:
     // Initialize engine
     bool Initialize(const std::wstring& configPath);
 
+    // Select the scheme used by ProcessInput ("pinyin", "bopomofo", "shuangpin_microsoft" ...); false if unknown
+    bool SetDefaultScheme(const std::wstring& schemeName);
+
+    // Scheme used by ProcessInput
+    const std::wstring& GetDefaultScheme() const { return m_defaultScheme; }
+
+    // True if key should be buffered for the active scheme (letters; ';' for Shuangpin layouts that use it)
+    bool IsCompositionKey(wchar_t key) const;
+
     // Process input
     std::vector<Candidate> ProcessInput(const std::wstring& input, const std::wstring& context = L"");
 
@@ -95,6 +106,26 @@ public:
     std::vector<Candidate> GetCrossCandidates(const std::wstring& input, 
                                             const std::wstring& scheme, const std::wstring& charset);
 
+    // Record a committed candidate for phrase mining. input is the composition as
+    // typed in scheme (default: the active scheme); it is mined under its toneless
+    // pinyin reading, and schemes without one end the commit sequence instead.
+    void CommitCandidate(const std::wstring& input, const std::wstring& candidate,
+                         const std::wstring& scheme = std::wstring());
+
+    // End the current commit sequence (escape, focus change)
+    void BreakCommitSequence();
+
+    // Add mined phrases to the dictionary as user phrases; returns the number added.
+    // Promotions live for the session only: there is no user dictionary file yet,
+    // and the miner re-learns frequent phrases within a few commits.
+    size_t ApplyMinedPhrases();
+
+    // Loaded dictionary (read-only; null before Initialize)
+    const Dictionary* GetDictionary() const { return m_dictionary.get(); }
+
+    // Pinyin parser (null before Initialize)
+    PinyinParser* GetPinyinParser() const { return m_pinyinParser.get(); }
+
 private:
     // Configuration
     bool m_aiSelectionEnabled;
@@ -108,8 +139,10 @@ private:
     std::unique_ptr<PinyinParser> m_pinyinParser;
     std::unique_ptr<CharsetConverter> m_converter;
     std::map<std::wstring, std::unique_ptr<InputScheme>> m_schemes;
+    std::unique_ptr<PhraseMiner> m_phraseMiner;
 
     // Helper methods
     void LoadConfiguration(const std::wstring& configPath);
+    std::wstring CommitReading(const std::wstring& input, const std::wstring& schemeName);
     std::vector<Candidate> GetCandidatesFromScheme(const std::wstring& input, const std::wstring& schemeName);
 };
\ No newline at end of file
@@ -0,0 +1,383 @@
+#include "pch.h"
+#include "phrase_miner.h"
+#include <algorithm>
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+// Second hash for double hashing (splitmix64 finalizer)
+uint64_t Mix(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ull;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBull;
+    x ^= x >> 31;
+    return x;
+}
+
+} // namespace
+
+// Constructor
+PhraseMiner::PhraseMiner() : PhraseMiner(Options())
+{
+}
+
+// Constructor
+PhraseMiner::PhraseMiner(const Options& options) :
+    m_options(options),
+    m_breakPending(false),
+    m_dropped(0),
+    m_inFlight(0),
+    m_stopping(false)
+{
+    m_options.sketchWidth = std::max<size_t>(m_options.sketchWidth, 16);
+    m_options.sketchDepth = std::max<size_t>(m_options.sketchDepth, 1);
+    m_options.heavyHitters = std::max<size_t>(m_options.heavyHitters, 1);
+    m_options.maxCommits = std::max<size_t>(m_options.maxCommits, 2);
+    m_options.queueCapacity = std::max<size_t>(m_options.queueCapacity, 1);
+    m_options.promoteCount = std::max<uint32_t>(m_options.promoteCount, 1);
+
+    m_sketch.assign(m_options.sketchWidth * m_options.sketchDepth, 0);
+    m_tracked.reserve(m_options.heavyHitters);
+}
+
+// Destructor
+PhraseMiner::~PhraseMiner()
+{
+    Stop();
+}
+
+// Start the background worker
+void PhraseMiner::Start()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    if (m_worker.joinable())
+    {
+        return;
+    }
+    m_stopping = false;
+    m_worker = std::thread(&PhraseMiner::WorkerLoop, this);
+}
+
+// Stop the background worker (queued commits are processed first)
+void PhraseMiner::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (!m_worker.joinable())
+        {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_queueCv.notify_all();
+    m_worker.join();
+    m_worker = std::thread();
+}
+
+// Record one commit
+void PhraseMiner::RecordCommit(const std::wstring& reading, const std::wstring& word)
+{
+    if (word.empty())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (m_pending.size() >= m_options.queueCapacity)
+        {
+            // Drop the oldest commit; the gap must not be mined as a sequence
+            m_pending.pop_front();
+            if (!m_pending.empty())
+            {
+                m_pending.front().breakBefore = true;
+            }
+            ++m_dropped;
+        }
+        m_pending.push_back(Commit{ reading, word, m_breakPending });
+        m_breakPending = false;
+    }
+    m_queueCv.notify_one();
+}
+
+// End the current commit sequence
+void PhraseMiner::BreakSequence()
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    m_breakPending = true;
+}
+
+// Process queued commits on the calling thread
+void PhraseMiner::ProcessPending()
+{
+    std::deque<Commit> batch;
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        batch.swap(m_pending);
+        m_inFlight += batch.size();
+    }
+    Process(batch);
+}
+
+// Wait until the queue is drained
+void PhraseMiner::Flush()
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    if (!m_worker.joinable())
+    {
+        lock.unlock();
+        ProcessPending();
+        return;
+    }
+    m_idleCv.wait(lock, [this]() { return m_pending.empty() && m_inFlight == 0; });
+}
+
+// Move out promoted phrases
+size_t PhraseMiner::TakePromotions(std::vector<MinedPhrase>& out)
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    const size_t count = m_ready.size();
+    for (auto& phrase : m_ready)
+    {
+        out.push_back(std::move(phrase));
+    }
+    m_ready.clear();
+    return count;
+}
+
+// Sketch estimate for a phrase
+uint32_t PhraseMiner::Estimate(const std::vector<std::wstring>& words) const
+{
+    uint64_t hash = kFnvOffset;
+    for (const auto& word : words)
+    {
+        hash = HashWord(hash, word);
+    }
+    std::lock_guard<std::mutex> lock(m_sketchMutex);
+    return EstimateHash(hash);
+}
+
+// Number of tracked heavy hitters
+size_t PhraseMiner::GetTrackedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_sketchMutex);
+    return m_tracked.size();
+}
+
+// Commits dropped because the queue was full
+size_t PhraseMiner::GetDroppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_queueMutex);
+    return m_dropped;
+}
+
+// Approximate memory held by the miner
+size_t PhraseMiner::GetMemoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(m_sketchMutex);
+    size_t bytes = m_sketch.capacity() * sizeof(uint32_t);
+    bytes += m_tracked.capacity() * sizeof(Tracked);
+    for (const auto& tracked : m_tracked)
+    {
+        bytes += (tracked.word.capacity() + tracked.reading.capacity()) * sizeof(wchar_t);
+    }
+    bytes += m_trackedIndex.size() * (sizeof(uint64_t) + sizeof(size_t) + 2 * sizeof(void*));
+    bytes += m_promoted.size() * (2 * sizeof(uint64_t) + 2 * sizeof(void*));
+    return bytes;
+}
+
+// FNV-1a over one word, followed by a unit separator so that word boundaries matter
+uint64_t PhraseMiner::HashWord(uint64_t hash, const std::wstring& word)
+{
+    for (wchar_t ch : word)
+    {
+        hash = (hash ^ static_cast<uint64_t>(ch)) * kFnvPrime;
+    }
+    return (hash ^ 0x1F) * kFnvPrime;
+}
+
+// Conservative update: only the counters holding the minimum are raised
+uint32_t PhraseMiner::Increment(uint64_t hash)
+{
+    const uint64_t step = Mix(hash) | 1;
+    const uint32_t next = EstimateHash(hash) + 1;
+    for (size_t row = 0; row < m_options.sketchDepth; ++row)
+    {
+        uint32_t& counter = m_sketch[row * m_options.sketchWidth + (hash + row * step) % m_options.sketchWidth];
+        counter = std::max(counter, next);
+    }
+    return next;
+}
+
+// Minimum over the rows
+uint32_t PhraseMiner::EstimateHash(uint64_t hash) const
+{
+    const uint64_t step = Mix(hash) | 1;
+    uint32_t estimate = UINT32_MAX;
+    for (size_t row = 0; row < m_options.sketchDepth; ++row)
+    {
+        estimate = std::min(estimate, m_sketch[row * m_options.sketchWidth + (hash + row * step) % m_options.sketchWidth]);
+    }
+    return estimate;
+}
+
+// Count every run of consecutive commits ending at this one
+void PhraseMiner::Observe(const Commit& commit, std::vector<MinedPhrase>& promoted)
+{
+    if (commit.breakBefore)
+    {
+        m_window.clear();
+    }
+    m_window.push_back(commit);
+    if (m_window.size() > m_options.maxCommits)
+    {
+        m_window.pop_front();
+    }
+
+    size_t length = m_window.back().word.size();
+    for (size_t first = m_window.size() - 1; first-- > 0;)
+    {
+        length += m_window[first].word.size();
+        if (length > m_options.maxPhraseLength)
+        {
+            break;
+        }
+
+        uint64_t hash = kFnvOffset;
+        for (size_t i = first; i < m_window.size(); ++i)
+        {
+            hash = HashWord(hash, m_window[i].word);
+        }
+        if (m_promoted.count(hash))
+        {
+            continue;
+        }
+        Track(hash, Increment(hash), first, promoted);
+    }
+}
+
+// Update the heavy-hitter table; promote when the count reaches the threshold
+void PhraseMiner::Track(uint64_t hash, uint32_t count, size_t first, std::vector<MinedPhrase>& promoted)
+{
+    auto it = m_trackedIndex.find(hash);
+    size_t slot;
+    if (it != m_trackedIndex.end())
+    {
+        slot = it->second;
+        m_tracked[slot].count = count;
+    }
+    else
+    {
+        if (m_tracked.size() < m_options.heavyHitters)
+        {
+            slot = m_tracked.size();
+            m_tracked.push_back(Tracked());
+        }
+        else
+        {
+            // Replace the weakest entry only if the newcomer is already heavier
+            slot = 0;
+            for (size_t i = 1; i < m_tracked.size(); ++i)
+            {
+                if (m_tracked[i].count < m_tracked[slot].count)
+                {
+                    slot = i;
+                }
+            }
+            if (m_tracked[slot].count >= count)
+            {
+                return;
+            }
+            m_trackedIndex.erase(m_tracked[slot].hash);
+        }
+
+        Tracked& tracked = m_tracked[slot];
+        tracked.hash = hash;
+        tracked.count = count;
+        tracked.word.clear();
+        tracked.reading.clear();
+        for (size_t i = first; i < m_window.size(); ++i)
+        {
+            if (i > first)
+            {
+                tracked.reading += m_options.readingSeparator;
+            }
+            tracked.word += m_window[i].word;
+            tracked.reading += m_window[i].reading;
+        }
+        m_trackedIndex[hash] = slot;
+    }
+
+    if (count < m_options.promoteCount)
+    {
+        return;
+    }
+
+    Tracked& tracked = m_tracked[slot];
+    promoted.push_back(MinedPhrase{ std::move(tracked.word), std::move(tracked.reading), count });
+
+    // Remove from the table (swap with the last entry)
+    m_trackedIndex.erase(hash);
+    if (slot + 1 != m_tracked.size())
+    {
+        m_tracked[slot] = std::move(m_tracked.back());
+        m_trackedIndex[m_tracked[slot].hash] = slot;
+    }
+    m_tracked.pop_back();
+
+    m_promoted.insert(hash);
+    m_promotedOrder.push_back(hash);
+    if (m_promotedOrder.size() > m_options.promotedCapacity)
+    {
+        m_promoted.erase(m_promotedOrder.front());
+        m_promotedOrder.pop_front();
+    }
+}
+
+// Run a batch of commits through the sketch and publish promotions
+void PhraseMiner::Process(std::deque<Commit>& batch)
+{
+    std::vector<MinedPhrase> promoted;
+    {
+        std::lock_guard<std::mutex> lock(m_sketchMutex);
+        for (const auto& commit : batch)
+        {
+            Observe(commit, promoted);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        for (auto& phrase : promoted)
+        {
+            m_ready.push_back(std::move(phrase));
+        }
+        m_inFlight -= batch.size();
+    }
+    m_idleCv.notify_all();
+}
+
+// Worker: drain the queue whenever commits arrive
+void PhraseMiner::WorkerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    for (;;)
+    {
+        m_queueCv.wait(lock, [this]() { return m_stopping || !m_pending.empty(); });
+        if (m_pending.empty() && m_stopping)
+        {
+            break;
+        }
+
+        std::deque<Commit> batch;
+        batch.swap(m_pending);
+        m_inFlight += batch.size();
+        lock.unlock();
+        Process(batch);
+        lock.lock();
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "pch.h"
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Mines multi-word phrases from consecutive commits. Every run of 2..N
+// consecutive commits is counted in a count-min sketch (conservative update);
+// the most frequent runs are tracked in a fixed-size heavy-hitter table and
+// reported for promotion once their estimate reaches the threshold.
+//
+// RecordCommit only appends to a bounded queue; sketch updates run on the
+// worker thread (Start) or in ProcessPending when no worker is running.
+// Memory is bounded by the sketch, the heavy-hitter table, the queue and the
+// promoted-phrase filter, independent of how much the user types.
+class PhraseMiner {
+public:
+    struct Options {
+        size_t sketchWidth = 4096;      // counters per row
+        size_t sketchDepth = 4;         // rows (independent hashes)
+        size_t heavyHitters = 256;      // tracked candidate phrases
+        size_t maxCommits = 4;          // longest phrase, in commits
+        size_t maxPhraseLength = 8;     // longest phrase, in characters
+        uint32_t promoteCount = 3;      // confirmations before promotion
+        size_t queueCapacity = 1024;    // pending commits (oldest dropped when full)
+        size_t promotedCapacity = 4096; // remembered promotions (oldest forgotten first)
+        std::wstring readingSeparator;  // joins the readings of a phrase
+    };
+
+    // A phrase ready for the user dictionary
+    struct MinedPhrase {
+        std::wstring word;       // concatenated committed text
+        std::wstring reading;    // concatenated readings
+        uint32_t count;          // sketch estimate at promotion
+    };
+
+    PhraseMiner();
+    explicit PhraseMiner(const Options& options);
+    ~PhraseMiner();
+
+    PhraseMiner(const PhraseMiner&) = delete;
+    PhraseMiner& operator=(const PhraseMiner&) = delete;
+
+    // Start/stop the background worker
+    void Start();
+    void Stop();
+
+    // Record one committed candidate and the input it was typed with (cheap, thread-safe)
+    void RecordCommit(const std::wstring& reading, const std::wstring& word);
+
+    // End the current commit sequence (escape, punctuation, focus change)
+    void BreakSequence();
+
+    // Process queued commits on the calling thread
+    void ProcessPending();
+
+    // Wait until every queued commit has been processed
+    void Flush();
+
+    // Move out phrases promoted since the last call (thread-safe)
+    size_t TakePromotions(std::vector<MinedPhrase>& out);
+
+    // Sketch estimate for a phrase given as its committed words
+    uint32_t Estimate(const std::vector<std::wstring>& words) const;
+
+    // Statistics
+    size_t GetTrackedCount() const;
+    size_t GetDroppedCount() const;
+    size_t GetMemoryBytes() const;
+
+private:
+    struct Commit {
+        std::wstring reading;
+        std::wstring word;
+        bool breakBefore;
+    };
+
+    struct Tracked {
+        uint64_t hash;
+        uint32_t count;
+        std::wstring word;
+        std::wstring reading;
+    };
+
+    static uint64_t HashWord(uint64_t hash, const std::wstring& word);
+
+    uint32_t Increment(uint64_t hash);
+    uint32_t EstimateHash(uint64_t hash) const;
+    void Observe(const Commit& commit, std::vector<MinedPhrase>& promoted);
+    void Track(uint64_t hash, uint32_t count, size_t first, std::vector<MinedPhrase>& promoted);
+    void Process(std::deque<Commit>& batch);
+    void WorkerLoop();
+
+    Options m_options;
+
+    // Sketch state (worker side)
+    std::vector<uint32_t> m_sketch;
+    std::deque<Commit> m_window;
+    std::vector<Tracked> m_tracked;
+    std::unordered_map<uint64_t, size_t> m_trackedIndex;
+    std::unordered_set<uint64_t> m_promoted;
+    std::deque<uint64_t> m_promotedOrder;
+    mutable std::mutex m_sketchMutex;
+
+    // Queues shared with the committing thread
+    std::deque<Commit> m_pending;
+    std::vector<MinedPhrase> m_ready;
+    bool m_breakPending;
+    size_t m_dropped;
+    size_t m_inFlight;
+    bool m_stopping;
+    mutable std::mutex m_queueMutex;
+    std::condition_variable m_queueCv;
+    std::condition_variable m_idleCv;
+    std::thread m_worker;
+};
@@ -5,6 +5,7 @@
 // Constructor
 PinyinParser::PinyinParser(const Dictionary& dictionary) : m_dictionary(dictionary)
 {
+    m_toneIndex.Build(m_dictionary);
 }
 
 // Destructor
@@ -62,6 +63,31 @@ void PinyinParser::ClearCache()
     m_cache.clear();
 }
 
+// Recompile the syllable index
+void PinyinParser::RebuildIndex()
+{
+    m_toneIndex.Build(m_dictionary);
+    m_cache.clear();
+}
+
+// Index one appended entry
+void PinyinParser::IndexAddedEntry(const std::wstring& pronunciation)
+{
+    const auto& entries = m_dictionary.GetAllEntries();
+    const auto it = entries.find(pronunciation);
+    if (it != entries.end() && !it->second.empty())
+    {
+        m_toneIndex.Add(it->first, it->second, it->second.size() - 1);
+    }
+    m_cache.clear();
+}
+
+// Get syllable index
+const PinyinToneIndex& PinyinParser::GetToneIndex() const
+{
+    return m_toneIndex;
+}
+
 // Generate candidates
 std::vector<Dictionary::DictEntry> PinyinParser::GenerateCandidates(const std::wstring& pinyinSequence) const
 {
@@ -72,6 +98,17 @@ std::vector<Dictionary::DictEntry> PinyinParser::GenerateCandidates(const std::w
     {
         candidates.insert(candidates.end(), entries.begin(), entries.end());
     }
+
+    // Syllable index: "nihao", "ni hao" and "ni3hao" against tone-marked readings;
+    // tone digits filter the posting list
+    if (candidates.empty())
+    {
+        std::vector<TonedSyllableId> syllables;
+        if (ParsePinyinReading(pinyinSequence, syllables, false))
+        {
+            m_toneIndex.Lookup(syllables, candidates);
+        }
+    }
     
     if (candidates.empty() && pinyinSequence.length() > 1)
     {
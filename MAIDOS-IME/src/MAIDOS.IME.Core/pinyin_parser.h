@@ -2,6 +2,7 @@
 
 #include "pch.h"
 #include "dictionary.h"
+#include "pinyin_tone_index.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -33,9 +34,19 @@ public:
     // Clear cache
     void ClearCache();
 
+    // Recompile the syllable index after dictionary changes
+    void RebuildIndex();
+
+    // Index the entry just appended under pronunciation (Dictionary::AddEntry) without a rebuild
+    void IndexAddedEntry(const std::wstring& pronunciation);
+
+    // Syllable index (toneless and tone-number input)
+    const PinyinToneIndex& GetToneIndex() const;
+
 private:
     std::vector<Dictionary::DictEntry> GenerateCandidates(const std::wstring& pinyinSequence) const;
 
     const Dictionary& m_dictionary;
     std::map<std::wstring, ParseResult> m_cache;
+    PinyinToneIndex m_toneIndex;
 };
\ No newline at end of file
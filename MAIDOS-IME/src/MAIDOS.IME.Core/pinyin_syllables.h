@@ -0,0 +1,115 @@
+#pragma once
+
+#include "pch.h"
+#include <cstdint>
+#include <string_view>
+
+// Toneless pinyin syllable inventory shared by the syllable-based schemes.
+// A syllable ID is the index into kPinyinSyllables; the table is sorted so
+// that lookups are a binary search and IDs are stable across builds.
+// u-umlaut is written as v after n/l (lv, lve, nv, nve), matching the keys
+// in pinyin.dict.json.
+
+using SyllableId = uint16_t;
+
+constexpr SyllableId kInvalidSyllable = 0xFFFF;
+
+inline constexpr const char* kPinyinSyllables[] = {
+    "a", "ai", "an", "ang", "ao", "ba", "bai", "ban", "bang", "bao", "bei", "ben", "beng", "bi", "bian",
+    "biao", "bie", "bin", "bing", "bo", "bu", "ca", "cai", "can", "cang", "cao", "ce", "cen", "ceng", "cha",
+    "chai", "chan", "chang", "chao", "che", "chen", "cheng", "chi", "chong", "chou", "chu", "chua", "chuai",
+    "chuan", "chuang", "chui", "chun", "chuo", "ci", "cong", "cou", "cu", "cuan", "cui", "cun", "cuo", "da",
+    "dai", "dan", "dang", "dao", "de", "dei", "den", "deng", "di", "dia", "dian", "diao", "die", "ding",
+    "diu", "dong", "dou", "du", "duan", "dui", "dun", "duo", "e", "ei", "en", "eng", "er", "fa", "fan",
+    "fang", "fei", "fen", "feng", "fo", "fou", "fu", "ga", "gai", "gan", "gang", "gao", "ge", "gei", "gen",
+    "geng", "gong", "gou", "gu", "gua", "guai", "guan", "guang", "gui", "gun", "guo", "ha", "hai", "han",
+    "hang", "hao", "he", "hei", "hen", "heng", "hong", "hou", "hu", "hua", "huai", "huan", "huang", "hui",
+    "hun", "huo", "ji", "jia", "jian", "jiang", "jiao", "jie", "jin", "jing", "jiong", "jiu", "ju", "juan",
+    "jue", "jun", "ka", "kai", "kan", "kang", "kao", "ke", "kei", "ken", "keng", "kong", "kou", "ku", "kua",
+    "kuai", "kuan", "kuang", "kui", "kun", "kuo", "la", "lai", "lan", "lang", "lao", "le", "lei", "leng",
+    "li", "lia", "lian", "liang", "liao", "lie", "lin", "ling", "liu", "lo", "long", "lou", "lu", "luan",
+    "lun", "luo", "lv", "lve", "ma", "mai", "man", "mang", "mao", "me", "mei", "men", "meng", "mi", "mian",
+    "miao", "mie", "min", "ming", "miu", "mo", "mou", "mu", "na", "nai", "nan", "nang", "nao", "ne", "nei",
+    "nen", "neng", "ni", "nian", "niang", "niao", "nie", "nin", "ning", "niu", "nong", "nou", "nu", "nuan",
+    "nuo", "nv", "nve", "o", "ou", "pa", "pai", "pan", "pang", "pao", "pei", "pen", "peng", "pi", "pian",
+    "piao", "pie", "pin", "ping", "po", "pou", "pu", "qi", "qia", "qian", "qiang", "qiao", "qie", "qin",
+    "qing", "qiong", "qiu", "qu", "quan", "que", "qun", "ran", "rang", "rao", "re", "ren", "reng", "ri",
+    "rong", "rou", "ru", "rua", "ruan", "rui", "run", "ruo", "sa", "sai", "san", "sang", "sao", "se", "sen",
+    "seng", "sha", "shai", "shan", "shang", "shao", "she", "shei", "shen", "sheng", "shi", "shou", "shu",
+    "shua", "shuai", "shuan", "shuang", "shui", "shun", "shuo", "si", "song", "sou", "su", "suan", "sui",
+    "sun", "suo", "ta", "tai", "tan", "tang", "tao", "te", "tei", "teng", "ti", "tian", "tiao", "tie", "ting",
+    "tong", "tou", "tu", "tuan", "tui", "tun", "tuo", "wa", "wai", "wan", "wang", "wei", "wen", "weng", "wo",
+    "wu", "xi", "xia", "xian", "xiang", "xiao", "xie", "xin", "xing", "xiong", "xiu", "xu", "xuan", "xue",
+    "xun", "ya", "yan", "yang", "yao", "ye", "yi", "yin", "ying", "yo", "yong", "you", "yu", "yuan", "yue",
+    "yun", "za", "zai", "zan", "zang", "zao", "ze", "zei", "zen", "zeng", "zha", "zhai", "zhan", "zhang",
+    "zhao", "zhe", "zhei", "zhen", "zheng", "zhi", "zhong", "zhou", "zhu", "zhua", "zhuai", "zhuan", "zhuang",
+    "zhui", "zhun", "zhuo", "zi", "zong", "zou", "zu", "zuan", "zui", "zun", "zuo",
+};
+
+constexpr size_t kPinyinSyllableCount = sizeof(kPinyinSyllables) / sizeof(kPinyinSyllables[0]);
+
+// Check the table ordering at compile time
+constexpr bool PinyinSyllablesSorted()
+{
+    for (size_t i = 1; i < kPinyinSyllableCount; ++i)
+    {
+        if (!(std::string_view(kPinyinSyllables[i - 1]) < std::string_view(kPinyinSyllables[i])))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(PinyinSyllablesSorted(), "kPinyinSyllables must be sorted and unique");
+static_assert(kPinyinSyllableCount < kInvalidSyllable, "SyllableId is too narrow");
+
+// Find the ID of a toneless syllable (kInvalidSyllable if unknown)
+constexpr SyllableId FindPinyinSyllable(std::string_view syllable)
+{
+    size_t lo = 0;
+    size_t hi = kPinyinSyllableCount;
+    while (lo < hi)
+    {
+        const size_t mid = (lo + hi) / 2;
+        const std::string_view probe(kPinyinSyllables[mid]);
+        if (probe == syllable)
+        {
+            return static_cast<SyllableId>(mid);
+        }
+        if (probe < syllable)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return kInvalidSyllable;
+}
+
+// Wide-string overload for input coming from the schemes (ASCII letters only)
+inline SyllableId FindPinyinSyllable(std::wstring_view syllable)
+{
+    char buffer[8];
+    if (syllable.empty() || syllable.size() > sizeof(buffer))
+    {
+        return kInvalidSyllable;
+    }
+    for (size_t i = 0; i < syllable.size(); ++i)
+    {
+        if (syllable[i] < L'a' || syllable[i] > L'z')
+        {
+            return kInvalidSyllable;
+        }
+        buffer[i] = static_cast<char>(syllable[i]);
+    }
+    return FindPinyinSyllable(std::string_view(buffer, syllable.size()));
+}
+
+// Spelling of a syllable ID (empty for invalid IDs)
+constexpr std::string_view PinyinSyllableText(SyllableId id)
+{
+    return id < kPinyinSyllableCount ? std::string_view(kPinyinSyllables[id]) : std::string_view();
+}
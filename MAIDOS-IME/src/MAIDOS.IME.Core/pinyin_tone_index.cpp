@@ -0,0 +1,290 @@
+#include "pch.h"
+#include "pinyin_tone_index.h"
+
+namespace {
+
+constexpr size_t kMaxSyllableLength = 6;
+
+// Tone-marked vowels and u-umlaut forms
+struct ToneMark {
+    wchar_t marked;
+    wchar_t base;
+    uint8_t tone;
+};
+
+const ToneMark kToneMarks[] = {
+    { L'\x0101', L'a', 1 }, { L'\x00E1', L'a', 2 }, { L'\x01CE', L'a', 3 }, { L'\x00E0', L'a', 4 },
+    { L'\x0113', L'e', 1 }, { L'\x00E9', L'e', 2 }, { L'\x011B', L'e', 3 }, { L'\x00E8', L'e', 4 },
+    { L'\x012B', L'i', 1 }, { L'\x00ED', L'i', 2 }, { L'\x01D0', L'i', 3 }, { L'\x00EC', L'i', 4 },
+    { L'\x014D', L'o', 1 }, { L'\x00F3', L'o', 2 }, { L'\x01D2', L'o', 3 }, { L'\x00F2', L'o', 4 },
+    { L'\x016B', L'u', 1 }, { L'\x00FA', L'u', 2 }, { L'\x01D4', L'u', 3 }, { L'\x00F9', L'u', 4 },
+    { L'\x01D6', L'v', 1 }, { L'\x01D8', L'v', 2 }, { L'\x01DA', L'v', 3 }, { L'\x01DC', L'v', 4 },
+    { L'\x00FC', L'v', 0 },
+};
+
+bool FoldLetter(wchar_t ch, wchar_t& base, uint8_t& tone)
+{
+    tone = 0;
+    if (ch >= L'a' && ch <= L'z')
+    {
+        base = ch;
+        return true;
+    }
+    if (ch >= L'A' && ch <= L'Z')
+    {
+        base = static_cast<wchar_t>(ch - L'A' + L'a');
+        return true;
+    }
+    for (const auto& mark : kToneMarks)
+    {
+        if (mark.marked == ch)
+        {
+            base = mark.base;
+            tone = mark.tone;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Split a run of letters into the fewest valid syllables; a tone mark inside a
+// syllable becomes its tone
+bool SegmentRun(const std::wstring& letters, const std::vector<uint8_t>& marks,
+                std::vector<SyllableId>& syllables, std::vector<uint8_t>& tones)
+{
+    const size_t n = letters.size();
+    std::vector<uint16_t> best(n + 1, UINT16_MAX);
+    std::vector<uint8_t> length(n + 1, 0);
+    best[0] = 0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        if (best[i] == UINT16_MAX)
+        {
+            continue;
+        }
+        for (size_t len = 1; len <= kMaxSyllableLength && i + len <= n; ++len)
+        {
+            if (best[i] + 1 < best[i + len] &&
+                FindPinyinSyllable(std::wstring_view(letters.data() + i, len)) != kInvalidSyllable)
+            {
+                best[i + len] = static_cast<uint16_t>(best[i] + 1);
+                length[i + len] = static_cast<uint8_t>(len);
+            }
+        }
+    }
+    if (best[n] == UINT16_MAX)
+    {
+        return false;
+    }
+
+    const size_t first = syllables.size();
+    syllables.resize(first + best[n]);
+    tones.resize(first + best[n]);
+    size_t slot = syllables.size();
+    for (size_t end = n; end > 0; end -= length[end])
+    {
+        const size_t start = end - length[end];
+        --slot;
+        syllables[slot] = FindPinyinSyllable(std::wstring_view(letters.data() + start, length[end]));
+        tones[slot] = kToneAny;
+        for (size_t i = start; i < end; ++i)
+        {
+            if (marks[i] != kToneAny)
+            {
+                tones[slot] = marks[i];
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+// Parse a reading into toned syllables
+bool ParsePinyinReading(const std::wstring& text, std::vector<TonedSyllableId>& out, bool unmarkedIsNeutral)
+{
+    out.clear();
+
+    std::vector<SyllableId> syllables;
+    std::vector<uint8_t> tones;
+    std::wstring run;
+    std::vector<uint8_t> marks;
+    bool anyTone = false;
+
+    auto flush = [&]() -> bool
+    {
+        if (run.empty())
+        {
+            return true;
+        }
+        const bool ok = SegmentRun(run, marks, syllables, tones);
+        run.clear();
+        marks.clear();
+        return ok;
+    };
+
+    for (wchar_t ch : text)
+    {
+        wchar_t base;
+        uint8_t tone;
+        if (FoldLetter(ch, base, tone))
+        {
+            run.push_back(base);
+            marks.push_back(tone);
+            anyTone = anyTone || tone != kToneAny;
+        }
+        else if (ch >= L'0' && ch <= L'5')
+        {
+            // Tone digit closes the syllable before it
+            if (!flush() || syllables.empty())
+            {
+                return false;
+            }
+            tones.back() = (ch == L'0' || ch == L'5') ? kToneNeutral : static_cast<uint8_t>(ch - L'0');
+            anyTone = true;
+        }
+        else if (ch == L' ' || ch == L'\'' || ch == L'-')
+        {
+            if (!flush())
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (!flush() || syllables.empty())
+    {
+        return false;
+    }
+
+    out.reserve(syllables.size());
+    for (size_t i = 0; i < syllables.size(); ++i)
+    {
+        const uint8_t tone = (tones[i] == kToneAny && unmarkedIsNeutral && anyTone) ? kToneNeutral : tones[i];
+        out.push_back(MakeTonedSyllable(syllables[i], tone));
+    }
+    return true;
+}
+
+// Constructor
+PinyinToneIndex::PinyinToneIndex() : m_postingCount(0)
+{
+}
+
+// Destructor
+PinyinToneIndex::~PinyinToneIndex()
+{
+}
+
+// Compile the dictionary readings
+void PinyinToneIndex::Build(const Dictionary& dictionary)
+{
+    Clear();
+
+    for (const auto& item : dictionary.GetAllEntries())
+    {
+        for (size_t i = 0; i < item.second.size(); ++i)
+        {
+            Add(item.first, item.second, i);
+        }
+    }
+}
+
+// Compile one entry
+bool PinyinToneIndex::Add(const std::wstring& key, const std::vector<Dictionary::DictEntry>& entries, size_t index)
+{
+    const std::wstring& reading = entries[index].pronunciation.empty() ? key : entries[index].pronunciation;
+    if (!ParsePinyinReading(reading, m_scratch, true))
+    {
+        return false;
+    }
+
+    m_scratchKey.clear();
+    for (TonedSyllableId syllable : m_scratch)
+    {
+        m_scratchKey.push_back(static_cast<char16_t>(TonedSyllableBase(syllable)));
+    }
+    m_postings[m_scratchKey].push_back(Posting{ &entries, static_cast<uint32_t>(index), static_cast<uint32_t>(m_toned.size()) });
+    m_toned.insert(m_toned.end(), m_scratch.begin(), m_scratch.end());
+    ++m_postingCount;
+    return true;
+}
+
+// Drop all postings
+void PinyinToneIndex::Clear()
+{
+    m_postings.clear();
+    m_toned.clear();
+    m_postingCount = 0;
+}
+
+// Toneless key lookup, then tone filter on the toned IDs
+bool PinyinToneIndex::Lookup(const std::vector<TonedSyllableId>& input, std::vector<Dictionary::DictEntry>& out) const
+{
+    std::u16string key;
+    key.reserve(input.size());
+    bool toned = false;
+    for (TonedSyllableId syllable : input)
+    {
+        key.push_back(static_cast<char16_t>(TonedSyllableBase(syllable)));
+        toned = toned || TonedSyllableTone(syllable) != kToneAny;
+    }
+
+    const auto it = m_postings.find(key);
+    if (it == m_postings.end())
+    {
+        return false;
+    }
+
+    const size_t before = out.size();
+    for (const Posting& posting : it->second)
+    {
+        if (toned)
+        {
+            bool match = true;
+            for (size_t i = 0; i < input.size() && match; ++i)
+            {
+                const TonedSyllableId have = m_toned[posting.toned + i];
+                match = TonedSyllableTone(input[i]) == kToneAny || TonedSyllableTone(have) == kToneAny ||
+                        have == input[i];
+            }
+            if (!match)
+            {
+                continue;
+            }
+        }
+        out.push_back((*posting.entries)[posting.index]);
+    }
+    return out.size() > before;
+}
+
+// Toneless key lookup without a tone filter (already-decoded syllables)
+bool PinyinToneIndex::LookupToneless(const std::u16string& key, std::vector<const Dictionary::DictEntry*>& out) const
+{
+    const auto it = m_postings.find(key);
+    if (it == m_postings.end())
+    {
+        return false;
+    }
+    for (const Posting& posting : it->second)
+    {
+        out.push_back(&(*posting.entries)[posting.index]);
+    }
+    return true;
+}
+
+// Number of distinct toneless sequences
+size_t PinyinToneIndex::GetKeyCount() const
+{
+    return m_postings.size();
+}
+
+// Number of indexed entries
+size_t PinyinToneIndex::GetPostingCount() const
+{
+    return m_postingCount;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "pch.h"
+#include "dictionary.h"
+#include "pinyin_syllables.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Tone-annotated syllable index over the dictionary.
+//
+// Every entry reading is compiled into a sequence of toned syllable IDs
+// (syllable ID * kToneSlots + tone). Postings are grouped by the toneless
+// syllable sequence, so "nihao", "ni hao", "ni3hao3" and "ní hǎo" all reach
+// the same posting list; tone digits in the input are then checked against
+// the toned IDs of each posting (integer compares, no string work).
+//
+// Tones: 0 = not specified, 1-4, 5 = neutral. An unspecified input tone
+// matches any entry; an entry without tone information (toneless reading)
+// matches any input tone.
+
+using TonedSyllableId = uint16_t;
+
+constexpr uint8_t kToneAny = 0;
+constexpr uint8_t kToneNeutral = 5;
+constexpr uint8_t kToneSlots = 6;
+
+static_assert(kPinyinSyllableCount * kToneSlots < 0xFFFF, "TonedSyllableId is too narrow");
+
+constexpr TonedSyllableId MakeTonedSyllable(SyllableId syllable, uint8_t tone)
+{
+    return static_cast<TonedSyllableId>(syllable * kToneSlots + tone);
+}
+
+constexpr SyllableId TonedSyllableBase(TonedSyllableId toned)
+{
+    return static_cast<SyllableId>(toned / kToneSlots);
+}
+
+constexpr uint8_t TonedSyllableTone(TonedSyllableId toned)
+{
+    return static_cast<uint8_t>(toned % kToneSlots);
+}
+
+// Parse a reading into toned syllables. Accepts tone digits after a syllable
+// ("ni3hao", 0 or 5 = neutral), tone-marked vowels ("ní hǎo"), u-umlaut as
+// "v" or "ü", and separators (space, apostrophe, hyphen). Runs of letters are
+// split into the fewest valid syllables. With unmarkedIsNeutral set, a reading
+// that carries any tone treats its unmarked syllables as neutral (dictionary
+// readings); otherwise unmarked syllables stay unspecified (user input).
+bool ParsePinyinReading(const std::wstring& text, std::vector<TonedSyllableId>& out, bool unmarkedIsNeutral);
+
+class PinyinToneIndex {
+public:
+    PinyinToneIndex();
+    ~PinyinToneIndex();
+
+    // Compile every entry reading of the dictionary (pronunciation, or the key when empty)
+    void Build(const Dictionary& dictionary);
+
+    // Compile one entry appended after Build (entries is the dictionary's list for key,
+    // so postings stay valid as it grows); false if the reading is not pinyin
+    bool Add(const std::wstring& key, const std::vector<Dictionary::DictEntry>& entries, size_t index);
+
+    // Drop all postings
+    void Clear();
+
+    // Append entries matching the toned input syllables; returns false when nothing matched
+    bool Lookup(const std::vector<TonedSyllableId>& input, std::vector<Dictionary::DictEntry>& out) const;
+
+    // Append every entry of a toneless sequence (one char16_t SyllableId per syllable);
+    // the pointers are valid until the dictionary changes
+    bool LookupToneless(const std::u16string& key, std::vector<const Dictionary::DictEntry*>& out) const;
+
+    // Statistics
+    size_t GetKeyCount() const;
+    size_t GetPostingCount() const;
+
+private:
+    struct Posting {
+        const std::vector<Dictionary::DictEntry>* entries;  // map node storage, stable across inserts
+        uint32_t index;                                     // entry within the list
+        uint32_t toned;                                     // offset of the toned sequence in m_toned
+    };
+
+    // Toneless syllable sequence (one char16_t per syllable) -> postings
+    std::unordered_map<std::u16string, std::vector<Posting>> m_postings;
+
+    // Toned sequences of all postings, back to back
+    std::vector<TonedSyllableId> m_toned;
+
+    size_t m_postingCount;
+
+    // Reused by Add so Build does not allocate per entry
+    std::vector<TonedSyllableId> m_scratch;
+    std::u16string m_scratchKey;
+};
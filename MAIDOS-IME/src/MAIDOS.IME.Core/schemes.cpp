@@ -2,6 +2,7 @@
 #include "schemes.h"
 #include "pinyin_parser.h"
 #include "bopomofo_scheme.h"
+#include "shuangpin_scheme.h"
 #include <algorithm>
 #include <functional>
 
@@ -82,6 +83,19 @@ std::unique_ptr<InputScheme> SchemeFactory::CreateScheme(const std::wstring& sch
     {
         return std::make_unique<CangjieScheme>();
     }
+    else if (schemeName == L"shuangpin")
+    {
+        return std::make_unique<ShuangpinScheme>();
+    }
+    else if (schemeName.rfind(L"shuangpin_", 0) == 0)
+    {
+        // shuangpin_xiaohe / shuangpin_ziranma / shuangpin_microsoft
+        const ShuangpinLayout* layout = FindShuangpinLayout(schemeName.substr(10));
+        if (layout)
+        {
+            return std::make_unique<ShuangpinScheme>(*layout);
+        }
+    }
     
     return nullptr;
 }
\ No newline at end of file
@@ -0,0 +1,234 @@
+#include "pch.h"
+#include "shuangpin_scheme.h"
+#include "pinyin_parser.h"
+#include <algorithm>
+
+namespace {
+
+const ShuangpinLayout kLayouts[] = {
+    { L"xiaohe", &kXiaoheTable },
+    { L"ziranma", &kZiranmaTable },
+    { L"microsoft", &kMicrosoftTable },
+};
+
+} // namespace
+
+// Look up a built-in layout by name
+const ShuangpinLayout* FindShuangpinLayout(const std::wstring& name)
+{
+    for (const auto& layout : kLayouts)
+    {
+        if (name == layout.name)
+        {
+            return &layout;
+        }
+    }
+    return nullptr;
+}
+
+// Default layout
+const ShuangpinLayout& DefaultShuangpinLayout()
+{
+    return kLayouts[0];
+}
+
+// All layouts
+const std::vector<const ShuangpinLayout*>& ShuangpinLayouts()
+{
+    static const std::vector<const ShuangpinLayout*> layouts = [] {
+        std::vector<const ShuangpinLayout*> all;
+        for (const auto& layout : kLayouts)
+        {
+            all.push_back(&layout);
+        }
+        return all;
+    }();
+    return layouts;
+}
+
+// Constructor
+ShuangpinScheme::ShuangpinScheme(const ShuangpinLayout& layout) :
+    m_layout(&layout),
+    m_parser(nullptr),
+    m_keys(),
+    m_syllables(),
+    m_keyCount(0)
+{
+}
+
+// Switch layout
+void ShuangpinScheme::SetLayout(const ShuangpinLayout& layout)
+{
+    m_layout = &layout;
+    m_keyCount = 0;
+}
+
+// Append one key
+bool ShuangpinScheme::PushKey(wchar_t key)
+{
+    if (ShuangpinKeyIndex(key) < 0 || m_keyCount >= m_keys.size())
+    {
+        return false;
+    }
+
+    if (m_keyCount & 1)
+    {
+        const SyllableId id = DecodeShuangpinPair(*m_layout->table, m_keys[m_keyCount - 1], key);
+        if (id == kInvalidSyllable)
+        {
+            return false;
+        }
+        m_syllables[m_keyCount / 2] = id;
+    }
+
+    m_keys[m_keyCount++] = key;
+    return true;
+}
+
+// Remove the last key
+bool ShuangpinScheme::PopKey()
+{
+    if (m_keyCount == 0)
+    {
+        return false;
+    }
+    --m_keyCount;
+    return true;
+}
+
+// Clear the composition
+void ShuangpinScheme::ClearKeys()
+{
+    m_keyCount = 0;
+}
+
+// Reading of the decoded syllables
+std::wstring ShuangpinScheme::GetReading() const
+{
+    std::wstring reading;
+    reading.reserve(GetSyllableCount() * 7);
+    for (size_t i = 0; i < GetSyllableCount(); ++i)
+    {
+        if (i > 0)
+        {
+            reading.push_back(L' ');
+        }
+        for (char ch : PinyinSyllableText(m_syllables[i]))
+        {
+            reading.push_back(static_cast<wchar_t>(ch));
+        }
+    }
+    return reading;
+}
+
+// Reading of a complete key sequence
+std::wstring ShuangpinScheme::ReadingFor(const std::wstring& keys)
+{
+    if (!Decode(keys) || HasPendingKey())
+    {
+        return std::wstring();
+    }
+    return GetReading();
+}
+
+// Decode input against the current composition
+bool ShuangpinScheme::Decode(const std::wstring& input)
+{
+    // Keep the common prefix; typing or deleting at the end only touches the last key
+    size_t common = 0;
+    while (common < m_keyCount && common < input.size() && m_keys[common] == input[common])
+    {
+        ++common;
+    }
+    m_keyCount = common;
+
+    for (size_t i = common; i < input.size(); ++i)
+    {
+        if (!PushKey(input[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Process input
+std::vector<InputScheme::Candidate> ShuangpinScheme::ProcessInput(const std::wstring& input)
+{
+    return GetCandidates(input);
+}
+
+// Get candidates
+std::vector<InputScheme::Candidate> ShuangpinScheme::GetCandidates(const std::wstring& input)
+{
+    std::vector<Candidate> candidates;
+
+    if (!m_parser || !Decode(input) || GetSyllableCount() == 0)
+    {
+        return candidates;
+    }
+
+    // The decoded IDs are already the index key; no reading text to build and re-parse
+    m_lookupKey.clear();
+    for (size_t i = 0; i < GetSyllableCount(); ++i)
+    {
+        m_lookupKey.push_back(static_cast<char16_t>(m_syllables[i]));
+    }
+    m_lookupEntries.clear();
+    if (!m_parser->GetToneIndex().LookupToneless(m_lookupKey, m_lookupEntries))
+    {
+        return candidates;
+    }
+
+    std::stable_sort(m_lookupEntries.begin(), m_lookupEntries.end(),
+        [](const Dictionary::DictEntry* a, const Dictionary::DictEntry* b) {
+            return a->frequency > b->frequency;
+        });
+
+    candidates.reserve(std::min(m_lookupEntries.size(), kMaxCandidates));
+    for (const Dictionary::DictEntry* entry : m_lookupEntries)
+    {
+        if (candidates.size() == kMaxCandidates)
+        {
+            break;
+        }
+        // Same word under several tone readings: keep the most frequent
+        const bool seen = std::any_of(candidates.begin(), candidates.end(),
+            [entry](const Candidate& c) { return c.character == entry->word; });
+        if (seen)
+        {
+            continue;
+        }
+
+        Candidate c;
+        c.character = entry->word;
+        c.frequency = static_cast<int>(entry->frequency);
+
+        const auto it = m_userWords.find(c.character);
+        if (it != m_userWords.end())
+        {
+            c.frequency += it->second;
+        }
+
+        candidates.push_back(std::move(c));
+    }
+
+    std::sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) {
+            return a.frequency > b.frequency;
+        });
+
+    return candidates;
+}
+
+// Add word
+void ShuangpinScheme::AddWord(const std::wstring& word, int frequency)
+{
+    m_userWords[word] = frequency;
+}
+
+// Remove word
+void ShuangpinScheme::RemoveWord(const std::wstring& word)
+{
+    m_userWords.erase(word);
+}
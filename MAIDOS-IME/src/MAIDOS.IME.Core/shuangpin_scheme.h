@@ -0,0 +1,383 @@
+#pragma once
+
+#include "pch.h"
+#include "schemes.h"
+#include "dictionary.h"
+#include "pinyin_syllables.h"
+#include <array>
+#include <string>
+#include <vector>
+#include <map>
+
+class PinyinParser;
+
+// Shuangpin (double pinyin): every syllable is exactly two keys, an initial
+// key and a final key. Layouts are described by constexpr specs and compiled
+// into 27x27 key-pair tables (a-z plus ';') that map straight to SyllableId,
+// so decoding a pair is a single array load.
+
+constexpr int kShuangpinKeys = 27;
+
+// Key index for a layout table (-1 for keys outside a-z and ';')
+constexpr int ShuangpinKeyIndex(wchar_t key)
+{
+    if (key >= L'a' && key <= L'z')
+    {
+        return key - L'a';
+    }
+    if (key >= L'A' && key <= L'Z')
+    {
+        return key - L'A';
+    }
+    return key == L';' ? 26 : -1;
+}
+
+// How syllables without an initial (a, ai, er, ou ...) are typed
+enum class ShuangpinZeroInitial {
+    Xiaohe,     // single letters doubled (aa), two letters spelled (ai), longer: first letter + final key (ah)
+    LeadLetter, // first letter + final key (aa, al, ah); spelled if the final has no key (er)
+    FixedO      // 'o' + final key (oa, ol, oh)
+};
+
+// Layout description: zh/ch/sh keys and up to two finals per key (tried in order)
+struct ShuangpinLayoutSpec {
+    char zh;
+    char ch;
+    char sh;
+    const char* finals[kShuangpinKeys][2];
+    ShuangpinZeroInitial zeroInitial;
+};
+
+using ShuangpinTable = std::array<SyllableId, kShuangpinKeys * kShuangpinKeys>;
+
+namespace shuangpin_detail {
+
+constexpr size_t Length(const char* s)
+{
+    size_t n = 0;
+    while (s && s[n])
+    {
+        ++n;
+    }
+    return n;
+}
+
+constexpr bool Equal(const char* a, const char* b)
+{
+    return std::string_view(a, Length(a)) == std::string_view(b, Length(b));
+}
+
+// Syllable for initial + final, applying the written-form rules (ju not jv, yue not yve)
+constexpr SyllableId Join(const char* initial, const char* tail)
+{
+    char buffer[8] = {};
+    size_t n = 0;
+    for (size_t i = 0; initial[i]; ++i)
+    {
+        buffer[n++] = initial[i];
+    }
+    const bool umlautAsU = n == 1 && (buffer[0] == 'j' || buffer[0] == 'q' || buffer[0] == 'x' || buffer[0] == 'y');
+    for (size_t i = 0; tail[i] && n < sizeof(buffer); ++i)
+    {
+        buffer[n++] = (i == 0 && tail[i] == 'v' && umlautAsU) ? 'u' : tail[i];
+    }
+    return FindPinyinSyllable(std::string_view(buffer, n));
+}
+
+// Key carrying a final (-1 if the layout has no key for it)
+constexpr int FinalKey(const ShuangpinLayoutSpec& spec, const char* tail)
+{
+    for (int k = 0; k < kShuangpinKeys; ++k)
+    {
+        for (int f = 0; f < 2; ++f)
+        {
+            if (spec.finals[k][f] && Equal(spec.finals[k][f], tail))
+            {
+                return k;
+            }
+        }
+    }
+    return -1;
+}
+
+constexpr void Set(ShuangpinTable& table, int first, int second, SyllableId id)
+{
+    if (first >= 0 && second >= 0 && table[first * kShuangpinKeys + second] == kInvalidSyllable)
+    {
+        table[first * kShuangpinKeys + second] = id;
+    }
+}
+
+} // namespace shuangpin_detail
+
+// Compile a layout spec into its key-pair table
+constexpr ShuangpinTable BuildShuangpinTable(const ShuangpinLayoutSpec& spec)
+{
+    using namespace shuangpin_detail;
+
+    ShuangpinTable table = {};
+    for (auto& id : table)
+    {
+        id = kInvalidSyllable;
+    }
+
+    constexpr const char* kInitials = "bpmfdtnlgkhjqxrzcsyw";
+    for (int first = 0; first < 26; ++first)
+    {
+        const char key = static_cast<char>('a' + first);
+        char single[2] = { 0, 0 };
+        const char* initial = nullptr;
+        if (key == spec.zh) initial = "zh";
+        else if (key == spec.ch) initial = "ch";
+        else if (key == spec.sh) initial = "sh";
+        else
+        {
+            for (size_t i = 0; kInitials[i]; ++i)
+            {
+                if (kInitials[i] == key)
+                {
+                    single[0] = key;
+                    initial = single;
+                }
+            }
+        }
+        if (!initial)
+        {
+            continue;
+        }
+
+        for (int second = 0; second < kShuangpinKeys; ++second)
+        {
+            for (int f = 0; f < 2; ++f)
+            {
+                const char* tail = spec.finals[second][f];
+                const SyllableId id = tail ? Join(initial, tail) : kInvalidSyllable;
+                if (id != kInvalidSyllable)
+                {
+                    Set(table, first, second, id);
+                    break;
+                }
+            }
+        }
+    }
+
+    constexpr const char* kZeroInitial[] = { "a", "ai", "an", "ang", "ao", "e", "ei", "en", "eng", "er", "o", "ou" };
+    for (const char* tail : kZeroInitial)
+    {
+        const SyllableId id = FindPinyinSyllable(tail);
+        const size_t length = Length(tail);
+        const int lead = tail[0] - 'a';
+        switch (spec.zeroInitial)
+        {
+        case ShuangpinZeroInitial::Xiaohe:
+            if (length == 1) Set(table, lead, lead, id);
+            else if (length == 2) Set(table, lead, tail[1] - 'a', id);
+            else Set(table, lead, FinalKey(spec, tail), id);
+            break;
+        case ShuangpinZeroInitial::LeadLetter:
+            if (FinalKey(spec, tail) >= 0) Set(table, lead, FinalKey(spec, tail), id);
+            else if (length == 2) Set(table, lead, tail[1] - 'a', id);
+            break;
+        case ShuangpinZeroInitial::FixedO:
+            Set(table, 'o' - 'a', FinalKey(spec, tail), id);
+            break;
+        }
+    }
+    return table;
+}
+
+// Xiaohe (Flypy)
+inline constexpr ShuangpinLayoutSpec kXiaoheSpec = { 'v', 'i', 'u', {
+    /* a */ { "a", nullptr },      /* b */ { "in", nullptr },    /* c */ { "ao", nullptr },
+    /* d */ { "ai", nullptr },     /* e */ { "e", nullptr },     /* f */ { "en", nullptr },
+    /* g */ { "eng", nullptr },    /* h */ { "ang", nullptr },   /* i */ { "i", nullptr },
+    /* j */ { "an", nullptr },     /* k */ { "ing", "uai" },     /* l */ { "iang", "uang" },
+    /* m */ { "ian", nullptr },    /* n */ { "iao", nullptr },   /* o */ { "uo", "o" },
+    /* p */ { "ie", nullptr },     /* q */ { "iu", nullptr },    /* r */ { "uan", nullptr },
+    /* s */ { "ong", "iong" },     /* t */ { "ue", "ve" },       /* u */ { "u", nullptr },
+    /* v */ { "ui", "v" },         /* w */ { "ei", nullptr },    /* x */ { "ia", "ua" },
+    /* y */ { "un", nullptr },     /* z */ { "ou", nullptr },    /* ; */ { nullptr, nullptr } },
+    ShuangpinZeroInitial::Xiaohe };
+
+// Ziranma
+inline constexpr ShuangpinLayoutSpec kZiranmaSpec = { 'v', 'i', 'u', {
+    /* a */ { "a", nullptr },      /* b */ { "ou", nullptr },    /* c */ { "iao", nullptr },
+    /* d */ { "iang", "uang" },    /* e */ { "e", nullptr },     /* f */ { "en", nullptr },
+    /* g */ { "eng", nullptr },    /* h */ { "ang", nullptr },   /* i */ { "i", nullptr },
+    /* j */ { "an", nullptr },     /* k */ { "ao", nullptr },    /* l */ { "ai", nullptr },
+    /* m */ { "ian", nullptr },    /* n */ { "in", nullptr },    /* o */ { "uo", "o" },
+    /* p */ { "un", nullptr },     /* q */ { "iu", nullptr },    /* r */ { "uan", nullptr },
+    /* s */ { "ong", "iong" },     /* t */ { "ue", "ve" },       /* u */ { "u", nullptr },
+    /* v */ { "ui", "v" },         /* w */ { "ia", "ua" },       /* x */ { "ie", nullptr },
+    /* y */ { "ing", "uai" },      /* z */ { "ei", nullptr },    /* ; */ { nullptr, nullptr } },
+    ShuangpinZeroInitial::LeadLetter };
+
+// Microsoft Pinyin (ing on ';', zero initial typed with 'o')
+inline constexpr ShuangpinLayoutSpec kMicrosoftSpec = { 'v', 'i', 'u', {
+    /* a */ { "a", nullptr },      /* b */ { "ou", nullptr },    /* c */ { "iao", nullptr },
+    /* d */ { "iang", "uang" },    /* e */ { "e", nullptr },     /* f */ { "en", nullptr },
+    /* g */ { "eng", nullptr },    /* h */ { "ang", nullptr },   /* i */ { "i", nullptr },
+    /* j */ { "an", nullptr },     /* k */ { "ao", nullptr },    /* l */ { "ai", nullptr },
+    /* m */ { "ian", nullptr },    /* n */ { "in", nullptr },    /* o */ { "uo", "o" },
+    /* p */ { "un", nullptr },     /* q */ { "iu", nullptr },    /* r */ { "uan", "er" },
+    /* s */ { "ong", "iong" },     /* t */ { "ue", nullptr },    /* u */ { "u", nullptr },
+    /* v */ { "ui", "ve" },        /* w */ { "ia", "ua" },       /* x */ { "ie", nullptr },
+    /* y */ { "uai", "v" },        /* z */ { "ei", nullptr },    /* ; */ { "ing", nullptr } },
+    ShuangpinZeroInitial::FixedO };
+
+inline constexpr ShuangpinTable kXiaoheTable = BuildShuangpinTable(kXiaoheSpec);
+inline constexpr ShuangpinTable kZiranmaTable = BuildShuangpinTable(kZiranmaSpec);
+inline constexpr ShuangpinTable kMicrosoftTable = BuildShuangpinTable(kMicrosoftSpec);
+
+// Decode one key pair (kInvalidSyllable if the pair is not a syllable)
+constexpr SyllableId DecodeShuangpinPair(const ShuangpinTable& table, wchar_t first, wchar_t second)
+{
+    const int a = ShuangpinKeyIndex(first);
+    const int b = ShuangpinKeyIndex(second);
+    return (a < 0 || b < 0) ? kInvalidSyllable : table[a * kShuangpinKeys + b];
+}
+
+// Key for a table index (inverse of ShuangpinKeyIndex, lower case)
+constexpr wchar_t ShuangpinKeyChar(int index)
+{
+    return index == 26 ? L';' : static_cast<wchar_t>(L'a' + index);
+}
+
+// Key pair that types a syllable on a layout; false if the layout has none
+constexpr bool EncodeShuangpinSyllable(const ShuangpinTable& table, SyllableId id, wchar_t& first, wchar_t& second)
+{
+    for (int pair = 0; pair < kShuangpinKeys * kShuangpinKeys; ++pair)
+    {
+        if (table[pair] == id)
+        {
+            first = ShuangpinKeyChar(pair / kShuangpinKeys);
+            second = ShuangpinKeyChar(pair % kShuangpinKeys);
+            return true;
+        }
+    }
+    return false;
+}
+
+// True if some pair uses key in either position (';' is only live on layouts that assign a final to it)
+constexpr bool ShuangpinTableUsesKey(const ShuangpinTable& table, wchar_t key)
+{
+    const int k = ShuangpinKeyIndex(key);
+    if (k < 0)
+    {
+        return false;
+    }
+    for (int other = 0; other < kShuangpinKeys; ++other)
+    {
+        if (table[k * kShuangpinKeys + other] != kInvalidSyllable || table[other * kShuangpinKeys + k] != kInvalidSyllable)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Compile-time spot checks of the generated tables
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'n', L'i') == FindPinyinSyllable("ni"), "xiaohe ni");
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'h', L'c') == FindPinyinSyllable("hao"), "xiaohe hao");
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'u', L'l') == FindPinyinSyllable("shuang"), "xiaohe shuang");
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'b', L'o') == FindPinyinSyllable("bo"), "xiaohe bo");
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'l', L'v') == FindPinyinSyllable("lv"), "xiaohe lv");
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'j', L't') == FindPinyinSyllable("jue"), "xiaohe jue");
+static_assert(DecodeShuangpinPair(kXiaoheTable, L'a', L'h') == FindPinyinSyllable("ang"), "xiaohe ang");
+static_assert(DecodeShuangpinPair(kZiranmaTable, L'g', L'y') == FindPinyinSyllable("guai"), "ziranma guai");
+static_assert(DecodeShuangpinPair(kZiranmaTable, L'a', L'l') == FindPinyinSyllable("ai"), "ziranma ai");
+static_assert(DecodeShuangpinPair(kZiranmaTable, L'e', L'r') == FindPinyinSyllable("er"), "ziranma er");
+static_assert(DecodeShuangpinPair(kMicrosoftTable, L'x', L';') == FindPinyinSyllable("xing"), "microsoft xing");
+static_assert(DecodeShuangpinPair(kMicrosoftTable, L'o', L'r') == FindPinyinSyllable("er"), "microsoft er");
+static_assert(DecodeShuangpinPair(kMicrosoftTable, L'n', L'v') == FindPinyinSyllable("nve"), "microsoft nve");
+static_assert(ShuangpinTableUsesKey(kMicrosoftTable, L';') && !ShuangpinTableUsesKey(kXiaoheTable, L';'), "';' only on microsoft");
+
+// Runtime handle for a compiled layout
+struct ShuangpinLayout {
+    const wchar_t* name;
+    const ShuangpinTable* table;
+};
+
+// Look up a built-in layout by name ("xiaohe", "ziranma", "microsoft"); nullptr if unknown
+const ShuangpinLayout* FindShuangpinLayout(const std::wstring& name);
+
+// Layout used by the plain "shuangpin" scheme name
+const ShuangpinLayout& DefaultShuangpinLayout();
+
+// All built-in layouts (each is also registered as scheme "shuangpin_<name>")
+const std::vector<const ShuangpinLayout*>& ShuangpinLayouts();
+
+// Shuangpin input scheme. Keys are decoded incrementally into a fixed-size
+// syllable buffer; the decoded syllable IDs are looked up directly in the
+// PinyinParser's syllable index, so no reading text is built or re-parsed.
+class ShuangpinScheme : public InputScheme {
+public:
+    // Maximum syllables in one composition
+    static constexpr size_t kMaxSyllables = 32;
+
+    // Maximum candidates returned for one composition
+    static constexpr size_t kMaxCandidates = 20;
+
+    explicit ShuangpinScheme(const ShuangpinLayout& layout = DefaultShuangpinLayout());
+
+    // Set the PinyinParser to delegate candidate lookup
+    void SetParser(PinyinParser* parser) { m_parser = parser; }
+
+    // Switch layout (pointer swap; the composition is cleared)
+    void SetLayout(const ShuangpinLayout& layout);
+
+    // Get current layout
+    const ShuangpinLayout& GetLayout() const { return *m_layout; }
+
+    // True if key is part of the current layout (letters always; ';' only where it carries a final)
+    bool UsesKey(wchar_t key) const { return ShuangpinTableUsesKey(*m_layout->table, key); }
+
+    // Append one key; false if it does not form a valid syllable (key is rejected)
+    bool PushKey(wchar_t key);
+
+    // Remove the last key
+    bool PopKey();
+
+    // Clear the composition
+    void ClearKeys();
+
+    // Decoded syllables
+    size_t GetSyllableCount() const { return m_keyCount / 2; }
+    SyllableId GetSyllable(size_t index) const { return m_syllables[index]; }
+
+    // True if a first key is waiting for its second key
+    bool HasPendingKey() const { return (m_keyCount & 1) != 0; }
+
+    // Space-separated toneless reading of the decoded syllables ("ni hao")
+    std::wstring GetReading() const;
+
+    // Decode keys and return their reading; empty unless every key pairs into a syllable
+    std::wstring ReadingFor(const std::wstring& keys);
+
+    // Process input
+    std::vector<Candidate> ProcessInput(const std::wstring& input) override;
+
+    // Get candidates
+    std::vector<Candidate> GetCandidates(const std::wstring& input) override;
+
+    // Add word
+    void AddWord(const std::wstring& word, int frequency = 0) override;
+
+    // Remove word
+    void RemoveWord(const std::wstring& word) override;
+
+private:
+    // Bring the composition in line with input, re-decoding only keys after the common prefix
+    bool Decode(const std::wstring& input);
+
+    const ShuangpinLayout* m_layout;
+    PinyinParser* m_parser;
+    std::array<wchar_t, kMaxSyllables * 2> m_keys;
+    std::array<SyllableId, kMaxSyllables> m_syllables;
+    size_t m_keyCount;
+    std::map<std::wstring, int> m_userWords;
+
+    // Reused by GetCandidates (index key and matched entries)
+    std::u16string m_lookupKey;
+    std::vector<const Dictionary::DictEntry*> m_lookupEntries;
+};
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "ime_engine.h"
+#include "typing_trace.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+// Replays a captured typing trace (.mdtrace) against the engine and reports
+// per-keystroke candidate latency.
+//
+// Usage: maidos_trace_replay <trace> [--realtime] [--seed N] [--dump]
+//   --realtime  sleep for the recorded think time between events
+//   --seed N    seed for the pinyin re-synthesis (default 1)
+//   --dump      print the synthesized workload instead of running it
+
+// Standalone executable: no DLL module handle (dictionaries resolve from the exe directory)
+HMODULE g_hModule = nullptr;
+
+namespace {
+
+double Percentile(std::vector<double>& samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::wcerr << L"Usage: maidos_trace_replay <trace> [--realtime] [--seed N] [--dump]" << std::endl;
+        return 2;
+    }
+
+    bool realtime = false;
+    bool dump = false;
+    uint32_t seed = 1;
+    for (int i = 2; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--realtime") realtime = true;
+        else if (arg == "--dump") dump = true;
+        else if (arg == "--seed" && i + 1 < argc) seed = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+    }
+
+    const std::wstring tracePath = std::filesystem::path(argv[1]).wstring();
+    std::vector<TraceEvent> events;
+    if (!ReadTypingTrace(tracePath, events))
+    {
+        std::wcerr << L"Failed to read trace: " << tracePath << std::endl;
+        return 1;
+    }
+
+    ImeEngine engine;
+    if (!engine.Initialize(L"../../src/config/maidos.toml"))
+    {
+        std::wcerr << L"Failed to initialize engine" << std::endl;
+        return 1;
+    }
+
+    // Readings for the re-synthesis come from the dictionary the engine loaded
+    std::vector<std::wstring> readings;
+    for (const auto& entry : engine.GetDictionary()->GetAllEntries())
+    {
+        std::wstring letters = FoldReadingToLetters(entry.first);
+        if (!letters.empty())
+        {
+            readings.push_back(std::move(letters));
+        }
+    }
+
+    const std::vector<TraceWorkloadStep> steps = BuildTraceWorkload(events, readings, seed);
+
+    std::vector<double> latencies;
+    size_t keys = 0;
+    size_t commits = 0;
+    size_t breaks = 0;
+    uint64_t dropped = 0;
+    std::vector<ImeEngine::Candidate> candidates;
+    std::wstring lastInput;
+
+    for (size_t i = 0; i < steps.size(); ++i)
+    {
+        const TraceWorkloadStep& step = steps[i];
+        if (dump)
+        {
+            std::wcout << step.delayMicros << L"\t" << static_cast<int>(step.type) << L"\t"
+                       << step.scheme << L"\t" << step.input << std::endl;
+            continue;
+        }
+        if (realtime && step.delayMicros > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(step.delayMicros));
+        }
+
+        switch (step.type)
+        {
+        case TraceEventType::Key:
+            ++keys;
+            if (step.input.empty() || step.input == lastInput)
+            {
+                break;
+            }
+            lastInput = step.input;
+            {
+                const auto start = std::chrono::steady_clock::now();
+                candidates = engine.GetCrossCandidates(step.input, step.scheme, L"Traditional");
+                const auto end = std::chrono::steady_clock::now();
+                latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            }
+            break;
+        case TraceEventType::Commit:
+            ++commits;
+            if (!step.input.empty() && step.candidateIndex < candidates.size())
+            {
+                engine.CommitCandidate(step.input, candidates[step.candidateIndex].character, step.scheme);
+            }
+            candidates.clear();
+            lastInput.clear();
+            break;
+        case TraceEventType::Break:
+            ++breaks;
+            engine.BreakCommitSequence();
+            candidates.clear();
+            lastInput.clear();
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (const auto& e : events)
+    {
+        if (e.type == TraceEventType::Gap)
+        {
+            dropped += e.b;
+        }
+    }
+
+    if (dump)
+    {
+        return 0;
+    }
+
+    std::wcout << L"MAIDOS IME Trace Replay" << std::endl;
+    std::wcout << L"=======================" << std::endl;
+    std::wcout << L"Events: " << events.size() << L" (keys " << keys << L", commits " << commits
+               << L", breaks " << breaks << L", dropped " << dropped << L")" << std::endl;
+    std::wcout << L"Lookups: " << latencies.size() << std::endl;
+    std::wcout << L"Latency p50: " << Percentile(latencies, 0.50) << L" us" << std::endl;
+    std::wcout << L"Latency p95: " << Percentile(latencies, 0.95) << L" us" << std::endl;
+    std::wcout << L"Latency p99: " << Percentile(latencies, 0.99) << L" us" << std::endl;
+    if (!latencies.empty())
+    {
+        std::wcout << L"Latency max: " << *std::max_element(latencies.begin(), latencies.end()) << L" us" << std::endl;
+    }
+
+    return 0;
+}
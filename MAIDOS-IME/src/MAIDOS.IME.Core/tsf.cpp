@@ -1,5 +1,6 @@
 #include "pch.h"
 #include "ime_engine.h"
+#include "typing_trace.h"
 
 #include <msctf.h>
 #include <new>
@@ -307,6 +308,14 @@ public:
         }
 
         if (SUCCEEDED(hr)) {
+            // Opt-in typing-trace capture (MAIDOS_IME_TRACE_DIR)
+            if (m_trace.OpenFromEnvironment()) {
+                DebugLog(L"MAIDOS TSF: Typing trace enabled");
+                // Replay types compositions in this scheme (Shuangpin layouts differ in keys)
+                if (SUCCEEDED(EnsureEngineReady())) {
+                    m_trace.OnSchemeSwitch(TraceSchemeFromName(m_engine.GetDefaultScheme()));
+                }
+            }
             DebugLog(L"MAIDOS TSF: Activated");
         } else {
             DebugLog(L"MAIDOS TSF: Activate failed");
@@ -333,6 +342,7 @@ public:
 
         m_clientId = TF_CLIENTID_NULL;
         m_buffer.clear();
+        m_trace.Close();
         return S_OK;
     }
 
@@ -340,6 +350,8 @@ public:
     STDMETHODIMP OnSetFocus(BOOL fForeground) override
     {
         UNREFERENCED_PARAMETER(fForeground);
+        if (m_engineReady) m_engine.BreakCommitSequence();
+        m_trace.OnBreak();
         return S_OK;
     }
 
@@ -351,7 +363,7 @@ public:
 
         // We only "eat" keys we actually handle on KeyDown.
         *pfEaten = (wParam == VK_SPACE) || (wParam == VK_BACK) || (wParam == VK_ESCAPE) ||
-            ((wParam >= 'A' && wParam <= 'Z') || (wParam >= 'a' && wParam <= 'z'));
+            CompositionChar(wParam) != 0;
         return S_OK;
     }
 
@@ -363,9 +375,11 @@ public:
 
         if (!pic) return S_OK;
 
-        // Buffer letters as pinyin input; commit on space.
-        if ((wParam >= 'A' && wParam <= 'Z') || (wParam >= 'a' && wParam <= 'z')) {
-            const wchar_t ch = static_cast<wchar_t>(wParam);
+        // Buffer scheme keys as input; commit on space.
+        const wchar_t ch = CompositionChar(wParam);
+        m_trace.OnKey(TraceKeyClassFromVirtualKey(static_cast<unsigned int>(wParam), ch != 0));
+
+        if (ch) {
             m_buffer.push_back(ch);
             *pfEaten = TRUE;
             return S_OK;
@@ -379,6 +393,7 @@ public:
 
         if (wParam == VK_ESCAPE) {
             m_buffer.clear();
+            if (m_engineReady) m_engine.BreakCommitSequence();
             *pfEaten = TRUE;
             return S_OK;
         }
@@ -422,6 +437,19 @@ public:
     }
 
 private:
+    // Character buffered for a key (letters; ';' when the active Shuangpin layout uses it), 0 otherwise
+    wchar_t CompositionChar(WPARAM wParam)
+    {
+        if ((wParam >= 'A' && wParam <= 'Z') || (wParam >= 'a' && wParam <= 'z')) {
+            return static_cast<wchar_t>(wParam);
+        }
+        if (wParam == VK_OEM_1 && (GetKeyState(VK_SHIFT) & 0x8000) == 0 &&
+            SUCCEEDED(EnsureEngineReady()) && m_engine.IsCompositionKey(L';')) {
+            return L';';
+        }
+        return 0;
+    }
+
     HRESULT EnsureEngineReady()
     {
         if (m_engineReady) return S_OK;
@@ -446,6 +474,13 @@ private:
         const std::wstring out = candidates.empty() ? m_buffer : candidates[0].character;
 
         const HRESULT hr = CommitText(context, out);
+        if (SUCCEEDED(hr) && !candidates.empty()) {
+            m_engine.CommitCandidate(m_buffer, out);
+            m_trace.OnCommit(0, out.size());
+        } else {
+            m_engine.BreakCommitSequence();
+            m_trace.OnBreak();
+        }
         m_buffer.clear();
         return hr;
     }
@@ -473,6 +508,7 @@ private:
     std::wstring m_buffer;
     ImeEngine m_engine;
     bool m_engineReady;
+    TypingTraceRecorder m_trace;
 };
 
 class MaidosClassFactory final : public IClassFactory {
@@ -0,0 +1,552 @@
+#include "pch.h"
+#include "typing_trace.h"
+#include "pinyin_tone_index.h"
+#include "shuangpin_scheme.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+
+namespace {
+
+const char kTraceMagic[8] = { 'M', 'D', 'T', 'R', 'A', 'C', 'E', '1' };
+
+uint64_t NowMicros()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void AppendVarint(std::string& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(const uint8_t* data, size_t size, size_t& pos, uint64_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < size; shift += 7)
+    {
+        const uint8_t byte = data[pos++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AppendRecord(std::string& out, const TraceEvent& e, uint64_t delta)
+{
+    out.push_back(static_cast<char>((static_cast<uint8_t>(e.type) << 4) | static_cast<uint8_t>(e.keyClass)));
+    AppendVarint(out, delta);
+    switch (e.type)
+    {
+    case TraceEventType::Commit:
+        AppendVarint(out, e.a);
+        AppendVarint(out, e.b);
+        break;
+    case TraceEventType::SchemeSwitch:
+        AppendVarint(out, e.a);
+        break;
+    case TraceEventType::Gap:
+        AppendVarint(out, e.b);
+        break;
+    default:
+        break;
+    }
+}
+
+std::wstring GetEnvVarW(const wchar_t* name)
+{
+    wchar_t buf[32767];
+    const DWORD len = GetEnvironmentVariableW(name, buf, static_cast<DWORD>(sizeof(buf) / sizeof(buf[0])));
+    if (len == 0 || len >= (sizeof(buf) / sizeof(buf[0])))
+    {
+        return L"";
+    }
+    return std::wstring(buf, len);
+}
+
+// Readings typed as key pairs of a Shuangpin layout (readings the layout cannot type are skipped)
+std::vector<std::wstring> ShuangpinKeyCorpus(const std::vector<std::wstring>& readings, const ShuangpinTable& table)
+{
+    std::vector<std::wstring> keyed;
+    std::vector<TonedSyllableId> syllables;
+    for (const auto& reading : readings)
+    {
+        if (!ParsePinyinReading(reading, syllables, false))
+        {
+            continue;
+        }
+        std::wstring keys;
+        for (TonedSyllableId syllable : syllables)
+        {
+            wchar_t first = 0;
+            wchar_t second = 0;
+            if (!EncodeShuangpinSyllable(table, TonedSyllableBase(syllable), first, second))
+            {
+                keys.clear();
+                break;
+            }
+            keys.push_back(first);
+            keys.push_back(second);
+        }
+        if (!keys.empty())
+        {
+            keyed.push_back(std::move(keys));
+        }
+    }
+    return keyed;
+}
+
+// Deterministic generator for the replay synthesis
+uint32_t NextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+} // namespace
+
+// Classify a Windows virtual-key code
+TraceKeyClass TraceKeyClassFromVirtualKey(unsigned int vKey, bool compositionKey)
+{
+    if (compositionKey || (vKey >= 'A' && vKey <= 'Z')) return TraceKeyClass::Letter;
+    if ((vKey >= '0' && vKey <= '9') || (vKey >= 0x60 && vKey <= 0x69)) return TraceKeyClass::Digit;
+    if (vKey == VK_SPACE) return TraceKeyClass::Space;
+    if (vKey == VK_BACK) return TraceKeyClass::Backspace;
+    if (vKey == VK_ESCAPE) return TraceKeyClass::Escape;
+    if (vKey == VK_RETURN) return TraceKeyClass::Enter;
+    // VK_OEM_1 .. VK_OEM_3 and VK_OEM_4 .. VK_OEM_7
+    if ((vKey >= 0xBA && vKey <= 0xC0) || (vKey >= 0xDB && vKey <= 0xDE)) return TraceKeyClass::Punctuation;
+    return TraceKeyClass::Other;
+}
+
+// Scheme name -> id
+TraceScheme TraceSchemeFromName(const std::wstring& name)
+{
+    if (name == L"bopomofo") return TraceScheme::Bopomofo;
+    if (name == L"cangjie") return TraceScheme::Cangjie;
+    if (name == L"shuangpin_xiaohe") return TraceScheme::ShuangpinXiaohe;
+    if (name == L"shuangpin_ziranma") return TraceScheme::ShuangpinZiranma;
+    if (name == L"shuangpin_microsoft") return TraceScheme::ShuangpinMicrosoft;
+    if (name.rfind(L"shuangpin", 0) == 0) return TraceScheme::Shuangpin;
+    return TraceScheme::Pinyin;
+}
+
+// Scheme id -> name
+const wchar_t* TraceSchemeName(TraceScheme scheme)
+{
+    switch (scheme)
+    {
+    case TraceScheme::Bopomofo: return L"bopomofo";
+    case TraceScheme::Cangjie: return L"cangjie";
+    case TraceScheme::Shuangpin: return L"shuangpin";
+    case TraceScheme::ShuangpinXiaohe: return L"shuangpin_xiaohe";
+    case TraceScheme::ShuangpinZiranma: return L"shuangpin_ziranma";
+    case TraceScheme::ShuangpinMicrosoft: return L"shuangpin_microsoft";
+    default: return L"pinyin";
+    }
+}
+
+// Encode events (timeMicros are absolute; records store deltas)
+void EncodeTraceEvents(const std::vector<TraceEvent>& events, std::string& out, bool withHeader)
+{
+    if (withHeader)
+    {
+        out.append(kTraceMagic, sizeof(kTraceMagic));
+    }
+    uint64_t last = events.empty() ? 0 : events.front().timeMicros;
+    for (const auto& e : events)
+    {
+        AppendRecord(out, e, e.timeMicros >= last ? e.timeMicros - last : 0);
+        last = e.timeMicros;
+    }
+}
+
+// Decode a trace image
+bool DecodeTraceEvents(const uint8_t* data, size_t size, std::vector<TraceEvent>& events)
+{
+    events.clear();
+    if (size < sizeof(kTraceMagic) || std::memcmp(data, kTraceMagic, sizeof(kTraceMagic)) != 0)
+    {
+        return false;
+    }
+
+    size_t pos = sizeof(kTraceMagic);
+    uint64_t time = 0;
+    while (pos < size)
+    {
+        const uint8_t head = data[pos++];
+        TraceEvent e = {};
+        e.type = static_cast<TraceEventType>(head >> 4);
+        e.keyClass = static_cast<TraceKeyClass>(head & 0x0F);
+        if (head >> 4 < 1 || head >> 4 > 5 || (head & 0x0F) > 8)
+        {
+            return false;
+        }
+
+        uint64_t delta = 0;
+        uint64_t a = 0;
+        uint64_t b = 0;
+        if (!ReadVarint(data, size, pos, delta))
+        {
+            return false;
+        }
+        switch (e.type)
+        {
+        case TraceEventType::Commit:
+            if (!ReadVarint(data, size, pos, a) || !ReadVarint(data, size, pos, b)) return false;
+            break;
+        case TraceEventType::SchemeSwitch:
+            if (!ReadVarint(data, size, pos, a)) return false;
+            break;
+        case TraceEventType::Gap:
+            if (!ReadVarint(data, size, pos, b)) return false;
+            break;
+        default:
+            break;
+        }
+        if (a > 0xFFFF || b > 0xFFFFFFFFull)
+        {
+            return false;
+        }
+
+        time += delta;
+        e.timeMicros = time;
+        e.a = static_cast<uint16_t>(a);
+        e.b = static_cast<uint32_t>(b);
+        events.push_back(e);
+    }
+    return true;
+}
+
+// Read a trace file
+bool ReadTypingTrace(const std::wstring& path, std::vector<TraceEvent>& events)
+{
+    std::ifstream file{ std::filesystem::path(path), std::ios::binary };
+    if (!file.is_open())
+    {
+        return false;
+    }
+    const std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return DecodeTraceEvents(reinterpret_cast<const uint8_t*>(data.data()), data.size(), events);
+}
+
+// Constructor
+TypingTraceRecorder::TypingTraceRecorder() :
+    m_ring(),
+    m_head(0),
+    m_tail(0),
+    m_dropped(0),
+    m_droppedReported(0),
+    m_lastMicros(0),
+    m_open(false),
+    m_stopping(false)
+{
+    static_assert((kRingCapacity & (kRingCapacity - 1)) == 0, "ring capacity must be a power of two");
+}
+
+// Destructor
+TypingTraceRecorder::~TypingTraceRecorder()
+{
+    Close();
+}
+
+// Start capturing to a file
+bool TypingTraceRecorder::Open(const std::wstring& path)
+{
+    Close();
+
+    m_file.open(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+    {
+        return false;
+    }
+    m_file.write(kTraceMagic, sizeof(kTraceMagic));
+
+    m_head.store(0, std::memory_order_relaxed);
+    m_tail.store(0, std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    m_droppedReported = 0;
+    m_lastMicros = 0;
+    m_stopping = false;
+    m_writer = std::thread(&TypingTraceRecorder::WriterLoop, this);
+    m_open.store(true, std::memory_order_release);
+    return true;
+}
+
+// Start capturing if MAIDOS_IME_TRACE_DIR is set
+bool TypingTraceRecorder::OpenFromEnvironment()
+{
+    const std::wstring dir = GetEnvVarW(L"MAIDOS_IME_TRACE_DIR");
+    if (dir.empty())
+    {
+        return false;
+    }
+    // Several recorders can be open in one process (one per input context)
+    static std::atomic<unsigned> sequence{ 0 };
+    const std::wstring name = L"trace_" + std::to_wstring(GetCurrentProcessId()) + L"_" +
+        std::to_wstring(sequence.fetch_add(1, std::memory_order_relaxed)) + L"_" +
+        std::to_wstring(GetTickCount64()) + L".mdtrace";
+    return Open((std::filesystem::path(dir) / name).wstring());
+}
+
+// Stop capturing and flush
+void TypingTraceRecorder::Close()
+{
+    if (!m_writer.joinable())
+    {
+        return;
+    }
+    m_open.store(false, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_writer.join();
+    m_file.close();
+}
+
+// Capture hooks
+void TypingTraceRecorder::OnKey(TraceKeyClass keyClass)
+{
+    Push(TraceEventType::Key, keyClass, 0, 0);
+}
+
+void TypingTraceRecorder::OnCommit(size_t candidateIndex, size_t committedLength)
+{
+    Push(TraceEventType::Commit, TraceKeyClass::None,
+        static_cast<uint16_t>(std::min<size_t>(candidateIndex, 0xFFFF)),
+        static_cast<uint32_t>(std::min<size_t>(committedLength, 0xFFFFFFFF)));
+}
+
+void TypingTraceRecorder::OnSchemeSwitch(TraceScheme scheme)
+{
+    Push(TraceEventType::SchemeSwitch, TraceKeyClass::None, static_cast<uint16_t>(scheme), 0);
+}
+
+void TypingTraceRecorder::OnBreak()
+{
+    Push(TraceEventType::Break, TraceKeyClass::None, 0, 0);
+}
+
+// Producer side: one slot write and one release store, never blocks
+void TypingTraceRecorder::Push(TraceEventType type, TraceKeyClass keyClass, uint16_t a, uint32_t b)
+{
+    if (!m_open.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_tail.load(std::memory_order_acquire) >= kRingCapacity)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    m_ring[head & (kRingCapacity - 1)] = TraceEvent{ NowMicros(), type, keyClass, a, b };
+    m_head.store(head + 1, std::memory_order_release);
+}
+
+// Consumer side: encode everything published so far
+void TypingTraceRecorder::Drain(std::string& buffer)
+{
+    const uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+    if (dropped > m_droppedReported)
+    {
+        const TraceEvent gap = { m_lastMicros, TraceEventType::Gap, TraceKeyClass::None, 0,
+            static_cast<uint32_t>(std::min<uint64_t>(dropped - m_droppedReported, 0xFFFFFFFF)) };
+        AppendRecord(buffer, gap, 0);
+        m_droppedReported = dropped;
+    }
+
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    const size_t head = m_head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail)
+    {
+        const TraceEvent& e = m_ring[tail & (kRingCapacity - 1)];
+        const uint64_t delta = (m_lastMicros == 0 || e.timeMicros < m_lastMicros) ? 0 : e.timeMicros - m_lastMicros;
+        AppendRecord(buffer, e, delta);
+        m_lastMicros = e.timeMicros;
+    }
+    m_tail.store(tail, std::memory_order_release);
+}
+
+// Writer thread: batch records to disk a few times per second
+void TypingTraceRecorder::WriterLoop()
+{
+    std::string buffer;
+    for (;;)
+    {
+        bool stopping;
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_wake.wait_for(lock, std::chrono::milliseconds(200), [this]() { return m_stopping; });
+            stopping = m_stopping;
+        }
+
+        buffer.clear();
+        Drain(buffer);
+        if (!buffer.empty())
+        {
+            m_file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            m_file.flush();
+        }
+        if (stopping)
+        {
+            break;
+        }
+    }
+}
+
+// Letters-only toneless form of a reading
+std::wstring FoldReadingToLetters(const std::wstring& reading)
+{
+    // Tone-marked vowels (macron, acute, caron, grave) and u-umlaut forms
+    static const struct { wchar_t marked; wchar_t plain; } kFold[] = {
+        { L'\x0101', L'a' }, { L'\x00E1', L'a' }, { L'\x01CE', L'a' }, { L'\x00E0', L'a' },
+        { L'\x0113', L'e' }, { L'\x00E9', L'e' }, { L'\x011B', L'e' }, { L'\x00E8', L'e' },
+        { L'\x012B', L'i' }, { L'\x00ED', L'i' }, { L'\x01D0', L'i' }, { L'\x00EC', L'i' },
+        { L'\x014D', L'o' }, { L'\x00F3', L'o' }, { L'\x01D2', L'o' }, { L'\x00F2', L'o' },
+        { L'\x016B', L'u' }, { L'\x00FA', L'u' }, { L'\x01D4', L'u' }, { L'\x00F9', L'u' },
+        { L'\x01D6', L'v' }, { L'\x01D8', L'v' }, { L'\x01DA', L'v' }, { L'\x01DC', L'v' },
+        { L'\x00FC', L'v' },
+    };
+
+    std::wstring out;
+    out.reserve(reading.size());
+    for (wchar_t ch : reading)
+    {
+        if (ch >= L'a' && ch <= L'z')
+        {
+            out.push_back(ch);
+            continue;
+        }
+        if (ch >= L'A' && ch <= L'Z')
+        {
+            out.push_back(static_cast<wchar_t>(ch - L'A' + L'a'));
+            continue;
+        }
+        for (const auto& f : kFold)
+        {
+            if (f.marked == ch)
+            {
+                out.push_back(f.plain);
+                break;
+            }
+        }
+    }
+    return out;
+}
+
+// Turn a trace into engine inputs
+std::vector<TraceWorkloadStep> BuildTraceWorkload(const std::vector<TraceEvent>& events,
+                                                  const std::vector<std::wstring>& readings,
+                                                  uint32_t seed)
+{
+    static const std::vector<std::wstring> kFallback = { L"ni", L"hao", L"shi", L"jie", L"jin", L"tian" };
+    const std::vector<std::wstring>& letters = readings.empty() ? kFallback : readings;
+
+    // Compositions are typed in the recorded scheme: Shuangpin layouts get key pairs
+    std::vector<std::wstring> keyed;
+    const std::vector<std::wstring>* corpus = &letters;
+    auto useScheme = [&](const std::wstring& name) {
+        corpus = &letters;
+        if (name.rfind(L"shuangpin", 0) != 0)
+        {
+            return;
+        }
+        const ShuangpinLayout* layout = name.size() > 10 ? FindShuangpinLayout(name.substr(10)) : nullptr;
+        const ShuangpinTable& table = *(layout ? layout : &DefaultShuangpinLayout())->table;
+        keyed = ShuangpinKeyCorpus(letters, table);
+        if (keyed.empty())
+        {
+            keyed = ShuangpinKeyCorpus(kFallback, table);
+        }
+        corpus = &keyed;
+    };
+
+    std::vector<TraceWorkloadStep> steps;
+    steps.reserve(events.size());
+
+    uint32_t state = seed ? seed : 1;
+    std::wstring composition;
+    std::wstring source;
+    std::wstring scheme = L"pinyin";
+    uint64_t last = events.empty() ? 0 : events.front().timeMicros;
+
+    for (const auto& e : events)
+    {
+        TraceWorkloadStep step;
+        step.type = e.type;
+        step.delayMicros = static_cast<uint32_t>(std::min<uint64_t>(e.timeMicros - last, 0xFFFFFFFF));
+        step.candidateIndex = 0;
+        last = e.timeMicros;
+
+        switch (e.type)
+        {
+        case TraceEventType::Key:
+            if (e.keyClass == TraceKeyClass::Letter)
+            {
+                // Continue the current synthesized reading; backspaced letters are retyped identically
+                while (source.size() <= composition.size())
+                {
+                    source += (*corpus)[NextRandom(state) % corpus->size()];
+                }
+                composition.push_back(source[composition.size()]);
+            }
+            else if (e.keyClass == TraceKeyClass::Backspace)
+            {
+                if (!composition.empty())
+                {
+                    composition.pop_back();
+                }
+            }
+            else if (e.keyClass == TraceKeyClass::Escape)
+            {
+                composition.clear();
+                source.clear();
+            }
+            break;
+        case TraceEventType::Commit:
+            step.candidateIndex = e.a;
+            break;
+        case TraceEventType::SchemeSwitch:
+            scheme = TraceSchemeName(static_cast<TraceScheme>(e.a));
+            useScheme(scheme);
+            // Keys not yet typed come from the new scheme
+            source.resize(composition.size());
+            break;
+        case TraceEventType::Break:
+        case TraceEventType::Gap:
+            step.type = TraceEventType::Break;
+            composition.clear();
+            source.clear();
+            break;
+        }
+
+        step.input = composition;
+        step.scheme = scheme;
+        steps.push_back(std::move(step));
+
+        if (e.type == TraceEventType::Commit)
+        {
+            composition.clear();
+            source.clear();
+        }
+    }
+    return steps;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "pch.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opt-in typing-trace capture for realistic benchmark workloads.
+//
+// Traces are anonymized at the source: letter keys are recorded only as
+// "letter", committed text is never stored (only the candidate index and the
+// committed length), and timestamps are deltas from the previous event. The
+// replay side (BuildTraceWorkload) re-synthesizes keys for each composition
+// from a dictionary in the recorded scheme, preserving its length, edit
+// pattern and timing.
+//
+// File format (.mdtrace): 8-byte magic "MDTRACE1", then one record per event:
+//   byte     type << 4 | key class
+//   varint   microseconds since the previous event
+//   varint*  type-specific fields (commit: candidate index, committed length;
+//            scheme: scheme id; gap: dropped events)
+
+// Event types
+enum class TraceEventType : uint8_t {
+    Key = 1,
+    Commit = 2,
+    SchemeSwitch = 3,
+    Break = 4,  // focus change, escape, anything that ends the composition context
+    Gap = 5     // events dropped because the capture buffer was full
+};
+
+// Key classes (the only keystroke detail that is captured)
+enum class TraceKeyClass : uint8_t {
+    None = 0,
+    Letter = 1,
+    Digit = 2,
+    Space = 3,
+    Backspace = 4,
+    Escape = 5,
+    Enter = 6,
+    Punctuation = 7,
+    Other = 8
+};
+
+// Scheme ids used by SchemeSwitch events (Shuangpin = the default layout)
+enum class TraceScheme : uint8_t {
+    Pinyin = 0,
+    Bopomofo = 1,
+    Cangjie = 2,
+    Shuangpin = 3,
+    ShuangpinXiaohe = 4,
+    ShuangpinZiranma = 5,
+    ShuangpinMicrosoft = 6
+};
+
+struct TraceEvent {
+    uint64_t timeMicros;   // capture: steady clock; decoded: time since trace start
+    TraceEventType type;
+    TraceKeyClass keyClass;
+    uint16_t a;            // commit: candidate index; scheme: scheme id
+    uint32_t b;            // commit: committed length; gap: dropped events
+};
+
+// Classify a Windows virtual-key code. compositionKey marks keys the active
+// scheme composes with (';' on Microsoft Shuangpin), which count as Letter.
+TraceKeyClass TraceKeyClassFromVirtualKey(unsigned int vKey, bool compositionKey = false);
+
+// Scheme name <-> id
+TraceScheme TraceSchemeFromName(const std::wstring& name);
+const wchar_t* TraceSchemeName(TraceScheme scheme);
+
+// Encode/decode records (decoding validates the magic and every record)
+void EncodeTraceEvents(const std::vector<TraceEvent>& events, std::string& out, bool withHeader);
+bool DecodeTraceEvents(const uint8_t* data, size_t size, std::vector<TraceEvent>& events);
+
+// Read a whole trace file
+bool ReadTypingTrace(const std::wstring& path, std::vector<TraceEvent>& events);
+
+// Trace recorder. The On* hooks are called from the input thread and only
+// write into a lock-free single-producer/single-consumer ring; a writer
+// thread encodes and appends to the file. When the ring is full events are
+// dropped and reported as a Gap record.
+class TypingTraceRecorder {
+public:
+    static constexpr size_t kRingCapacity = 8192;  // power of two
+
+    TypingTraceRecorder();
+    ~TypingTraceRecorder();
+
+    TypingTraceRecorder(const TypingTraceRecorder&) = delete;
+    TypingTraceRecorder& operator=(const TypingTraceRecorder&) = delete;
+
+    // Start capturing to a file (truncates it)
+    bool Open(const std::wstring& path);
+
+    // Start capturing if MAIDOS_IME_TRACE_DIR is set (file: trace_<pid>_<n>_<tick>.mdtrace)
+    bool OpenFromEnvironment();
+
+    // Stop capturing and flush everything to disk
+    void Close();
+
+    bool IsOpen() const { return m_open.load(std::memory_order_relaxed); }
+
+    // Capture hooks (single producer thread)
+    void OnKey(TraceKeyClass keyClass);
+    void OnCommit(size_t candidateIndex, size_t committedLength);
+    void OnSchemeSwitch(TraceScheme scheme);
+    void OnBreak();
+
+    // Events dropped because the ring was full
+    uint64_t GetDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void Push(TraceEventType type, TraceKeyClass keyClass, uint16_t a, uint32_t b);
+    void Drain(std::string& buffer);
+    void WriterLoop();
+
+    std::array<TraceEvent, kRingCapacity> m_ring;
+    std::atomic<size_t> m_head;     // next slot to write (producer)
+    std::atomic<size_t> m_tail;     // next slot to read (consumer)
+    std::atomic<uint64_t> m_dropped;
+    uint64_t m_droppedReported;
+    uint64_t m_lastMicros;
+
+    std::atomic<bool> m_open;
+    std::ofstream m_file;
+    std::thread m_writer;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    bool m_stopping;
+};
+
+// One step of a replay workload
+struct TraceWorkloadStep {
+    TraceEventType type;        // Key (input changed), Commit, SchemeSwitch or Break
+    std::wstring input;         // composition after this step
+    std::wstring scheme;        // active scheme
+    uint32_t delayMicros;       // recorded think time before this step
+    uint16_t candidateIndex;    // commit: chosen candidate
+};
+
+// Turn a decoded trace into engine inputs. Letters of each composition are
+// filled from readings (toneless, letters only) chosen deterministically by seed;
+// under a Shuangpin scheme the readings are typed as that layout's key pairs.
+std::vector<TraceWorkloadStep> BuildTraceWorkload(const std::vector<TraceEvent>& events,
+                                                  const std::vector<std::wstring>& readings,
+                                                  uint32_t seed = 1);
+
+// Letters-only toneless form of a dictionary key ("ní hǎo" -> "nihao")
+std::wstring FoldReadingToLetters(const std::wstring& reading);
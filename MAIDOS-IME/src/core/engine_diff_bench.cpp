@@ -0,0 +1,652 @@
+#include "pch.h"
+#include "ime_engine.h"
+#include "typing_trace.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <set>
+#include <string>
+
+// Differential benchmark: C++ ImeEngine vs Rust maidos-core.
+//
+// Both engines load the same pinyin.dict.json and receive the same inputs
+// through a common adapter. The harness compares candidate lists and reports
+// per-call latency, allocations per call and the memory retained by the
+// loaded dictionary.
+//
+// Usage: engine_diff_bench [--dict-dir DIR] [--inputs FILE | --trace FILE]
+//                          [--iterations N] [--top K] [--limit N] [--show N] [--shipped]
+//   --dict-dir   directory holding pinyin.dict.json (default: src/dicts)
+//   --inputs     UTF-8 file, one input per line
+//   --trace      .mdtrace capture; replays its compositions (see typing_trace.h)
+//   --iterations timed passes over the inputs (default 5)
+//   --top        candidates compared per input (default 10)
+//   --shipped    also time ime_get_candidates (built-in table, scheme built per call)
+//
+// Rust allocation counts need maidos-core built with `--features alloc-stats`.
+
+// Rust maidos-core exports (ffi.rs)
+extern "C" {
+    void* ime_pinyin_engine_open(const char* dict_path);
+    char* ime_pinyin_engine_candidates(const void* handle, const char* input);
+    void ime_pinyin_engine_close(void* handle);
+    char* ime_get_candidates(const char* scheme_name, const char* input);
+    char* ime_last_error();
+    void ime_free_string(char* s);
+    int ime_alloc_stats(uint64_t* allocations, uint64_t* allocated_bytes, uint64_t* live_bytes);
+}
+
+// Standalone executable: no DLL module handle
+HMODULE g_hModule = nullptr;
+
+// ------------------------------------------------------------------
+// C++ allocation counters (global operator new/delete replacement)
+// ------------------------------------------------------------------
+
+namespace {
+
+std::atomic<uint64_t> g_cppAllocations(0);
+std::atomic<uint64_t> g_cppAllocatedBytes(0);
+std::atomic<uint64_t> g_cppLiveBytes(0);
+
+// Size header keeps max_align_t alignment for the returned block
+constexpr size_t kAllocHeader = alignof(std::max_align_t) > sizeof(size_t) ? alignof(std::max_align_t) : sizeof(size_t);
+
+void* CountedAlloc(size_t size) noexcept
+{
+    unsigned char* p = static_cast<unsigned char*>(std::malloc(size + kAllocHeader));
+    if (!p)
+    {
+        return nullptr;
+    }
+    std::memcpy(p, &size, sizeof(size));
+    g_cppAllocations.fetch_add(1, std::memory_order_relaxed);
+    g_cppAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    g_cppLiveBytes.fetch_add(size, std::memory_order_relaxed);
+    return p + kAllocHeader;
+}
+
+void CountedFree(void* ptr) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+    unsigned char* p = static_cast<unsigned char*>(ptr) - kAllocHeader;
+    size_t size;
+    std::memcpy(&size, p, sizeof(size));
+    g_cppLiveBytes.fetch_sub(size, std::memory_order_relaxed);
+    std::free(p);
+}
+
+} // namespace
+
+void* operator new(size_t size)
+{
+    void* p = CountedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    void* p = CountedAlloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return CountedAlloc(size); }
+void operator delete(void* ptr) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { CountedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { CountedFree(ptr); }
+
+namespace {
+
+struct AllocCounters {
+    uint64_t allocations;
+    uint64_t bytes;
+    uint64_t live;
+};
+
+std::string ToUtf8(const std::wstring& s)
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
+    return conv.to_bytes(s);
+}
+
+std::wstring FromUtf8(const std::string& s)
+{
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> conv;
+    return conv.from_bytes(s);
+}
+
+// "character" values of the candidate JSON produced by ffi.rs (serde_json only
+// escapes quotes, backslashes and control characters)
+void ParseCandidateJson(const char* json, std::vector<std::string>& out)
+{
+    static const char kKey[] = "\"character\":\"";
+    for (const char* p = std::strstr(json, kKey); p; p = std::strstr(p, kKey))
+    {
+        p += sizeof(kKey) - 1;
+        std::string value;
+        while (*p && *p != '"')
+        {
+            if (*p == '\\' && p[1])
+            {
+                ++p;
+            }
+            value.push_back(*p++);
+        }
+        out.push_back(std::move(value));
+    }
+}
+
+std::string TakeLastError()
+{
+    char* err = ime_last_error();
+    std::string message = err ? err : "unknown error";
+    ime_free_string(err);
+    return message;
+}
+
+// ------------------------------------------------------------------
+// Common adapter
+// ------------------------------------------------------------------
+
+// One engine under test. Prepare and TakeCandidates run outside the timed
+// region; Query is the measured call and returns the engine's native output.
+class EngineAdapter {
+public:
+    virtual ~EngineAdapter() = default;
+    virtual const char* Name() const = 0;
+    virtual bool Load(const std::filesystem::path& dictPath, std::string& error) = 0;
+    virtual void Prepare(const std::string& input) = 0;
+    virtual void Query() = 0;
+    virtual void TakeCandidates(std::vector<std::string>& out) = 0;
+    virtual bool Counters(AllocCounters& counters) const = 0;
+};
+
+// C++ ImeEngine (dictionary resolved through MAIDOS_IME_DICT_DIR)
+class CppEngineAdapter : public EngineAdapter {
+public:
+    const char* Name() const override { return "cpp-ImeEngine"; }
+
+    bool Load(const std::filesystem::path& dictPath, std::string& error) override
+    {
+        SetEnvironmentVariableW(L"MAIDOS_IME_DICT_DIR", dictPath.parent_path().wstring().c_str());
+        m_engine = std::make_unique<ImeEngine>();
+        if (!m_engine->Initialize(L""))
+        {
+            error = "ImeEngine::Initialize failed";
+            return false;
+        }
+
+        // Guard against the built-in fallback entries: the engine must hold the same file
+        Dictionary reference;
+        if (!reference.LoadFromFile(dictPath.wstring()) ||
+            reference.GetAllEntries().size() != m_engine->GetDictionary()->GetAllEntries().size())
+        {
+            error = "ImeEngine did not load " + dictPath.string();
+            return false;
+        }
+        return true;
+    }
+
+    // The parser memoizes every input it has parsed; drop the memo so each
+    // timed call measures a real parse (the Rust handle keeps no memo)
+    void Prepare(const std::string& input) override
+    {
+        m_input = FromUtf8(input);
+        m_engine->GetPinyinParser()->ClearCache();
+    }
+
+    void Query() override { m_candidates = m_engine->GetCrossCandidates(m_input, L"pinyin", L"Traditional"); }
+
+    void TakeCandidates(std::vector<std::string>& out) override
+    {
+        for (const auto& c : m_candidates)
+        {
+            out.push_back(ToUtf8(c.character));
+        }
+        m_candidates.clear();
+    }
+
+    bool Counters(AllocCounters& counters) const override
+    {
+        counters.allocations = g_cppAllocations.load(std::memory_order_relaxed);
+        counters.bytes = g_cppAllocatedBytes.load(std::memory_order_relaxed);
+        counters.live = g_cppLiveBytes.load(std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::unique_ptr<ImeEngine> m_engine;
+    std::wstring m_input;
+    std::vector<ImeEngine::Candidate> m_candidates;
+};
+
+// Rust allocation counters (alloc-stats feature)
+bool RustCounters(AllocCounters& counters)
+{
+    return ime_alloc_stats(&counters.allocations, &counters.bytes, &counters.live) == 0;
+}
+
+// Rust maidos-core pinyin engine loaded once over the same dictionary file
+class RustEngineAdapter : public EngineAdapter {
+public:
+    ~RustEngineAdapter() override
+    {
+        ime_free_string(m_result);
+        ime_pinyin_engine_close(m_handle);
+    }
+
+    const char* Name() const override { return "rust-maidos-core"; }
+
+    bool Load(const std::filesystem::path& dictPath, std::string& error) override
+    {
+        m_handle = ime_pinyin_engine_open(dictPath.u8string().c_str());
+        if (!m_handle)
+        {
+            error = TakeLastError();
+            return false;
+        }
+        return true;
+    }
+
+    void Prepare(const std::string& input) override { m_input = input; }
+
+    void Query() override
+    {
+        ime_free_string(m_result);
+        m_result = ime_pinyin_engine_candidates(m_handle, m_input.c_str());
+    }
+
+    void TakeCandidates(std::vector<std::string>& out) override
+    {
+        if (m_result)
+        {
+            ParseCandidateJson(m_result, out);
+            ime_free_string(m_result);
+            m_result = nullptr;
+        }
+    }
+
+    bool Counters(AllocCounters& counters) const override { return RustCounters(counters); }
+
+private:
+    void* m_handle = nullptr;
+    char* m_result = nullptr;
+    std::string m_input;
+};
+
+// Shipped FFI path used by ImeNative.cs (built-in table, scheme built per call)
+class RustShippedAdapter : public EngineAdapter {
+public:
+    ~RustShippedAdapter() override { ime_free_string(m_result); }
+
+    const char* Name() const override { return "rust-ime_get_candidates"; }
+
+    bool Load(const std::filesystem::path&, std::string&) override { return true; }
+
+    void Prepare(const std::string& input) override { m_input = input; }
+
+    void Query() override
+    {
+        ime_free_string(m_result);
+        m_result = ime_get_candidates("pinyin", m_input.c_str());
+    }
+
+    void TakeCandidates(std::vector<std::string>& out) override
+    {
+        if (m_result)
+        {
+            ParseCandidateJson(m_result, out);
+            ime_free_string(m_result);
+            m_result = nullptr;
+        }
+    }
+
+    bool Counters(AllocCounters& counters) const override { return RustCounters(counters); }
+
+private:
+    char* m_result = nullptr;
+    std::string m_input;
+};
+
+// ------------------------------------------------------------------
+// Measurement
+// ------------------------------------------------------------------
+
+struct EngineReport {
+    std::string name;
+    bool loaded = false;
+    double loadMillis = 0.0;
+    bool countersAvailable = false;
+    AllocCounters loadAlloc = {};          // load: allocations, bytes, retained bytes
+    std::vector<double> latencies;         // microseconds per call
+    uint64_t callAllocations = 0;
+    uint64_t callBytes = 0;
+    std::vector<std::vector<std::string>> candidates;  // first pass, per input
+};
+
+double Percentile(std::vector<double>& samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0.0;
+    }
+    const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+void RunEngine(EngineAdapter& engine, const std::filesystem::path& dictPath,
+               const std::vector<std::string>& inputs, int iterations, EngineReport& report)
+{
+    report.name = engine.Name();
+
+    AllocCounters before = {};
+    AllocCounters after = {};
+    report.countersAvailable = engine.Counters(before);
+
+    std::string error;
+    const auto loadStart = std::chrono::steady_clock::now();
+    report.loaded = engine.Load(dictPath, error);
+    const auto loadEnd = std::chrono::steady_clock::now();
+    if (!report.loaded)
+    {
+        std::cerr << report.name << ": load failed: " << error << std::endl;
+        return;
+    }
+    report.loadMillis = std::chrono::duration<double, std::milli>(loadEnd - loadStart).count();
+    if (report.countersAvailable && engine.Counters(after))
+    {
+        report.loadAlloc = AllocCounters{ after.allocations - before.allocations, after.bytes - before.bytes,
+                                          after.live - before.live };
+    }
+
+    report.candidates.resize(inputs.size());
+    report.latencies.reserve(inputs.size() * iterations);
+    for (int pass = 0; pass < iterations; ++pass)
+    {
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            engine.Prepare(inputs[i]);
+
+            engine.Counters(before);
+            const auto start = std::chrono::steady_clock::now();
+            engine.Query();
+            const auto end = std::chrono::steady_clock::now();
+            engine.Counters(after);
+
+            report.latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+            report.callAllocations += after.allocations - before.allocations;
+            report.callBytes += after.bytes - before.bytes;
+
+            std::vector<std::string> candidates;
+            engine.TakeCandidates(candidates);
+            if (pass == 0)
+            {
+                report.candidates[i] = std::move(candidates);
+            }
+        }
+    }
+}
+
+void PrintReport(EngineReport& report)
+{
+    std::cout << "[" << report.name << "]" << std::endl;
+    if (!report.loaded)
+    {
+        std::cout << "  not loaded" << std::endl;
+        return;
+    }
+    const size_t calls = report.latencies.size();
+    std::cout << "  load: " << report.loadMillis << " ms";
+    if (report.countersAvailable)
+    {
+        std::cout << ", " << report.loadAlloc.allocations << " allocations, "
+                  << report.loadAlloc.live / 1024 << " KiB retained";
+    }
+    std::cout << std::endl;
+    std::cout << "  latency p50/p95/p99: " << Percentile(report.latencies, 0.50) << " / "
+              << Percentile(report.latencies, 0.95) << " / " << Percentile(report.latencies, 0.99)
+              << " us over " << calls << " calls" << std::endl;
+    if (report.countersAvailable && calls > 0)
+    {
+        std::cout << "  per call: " << static_cast<double>(report.callAllocations) / calls << " allocations, "
+                  << static_cast<double>(report.callBytes) / calls << " bytes" << std::endl;
+    }
+    else
+    {
+        std::cout << "  per call: allocation counters unavailable" << std::endl;
+    }
+}
+
+// Candidate agreement between two engines over the first K candidates
+void CompareCandidates(const EngineReport& a, const EngineReport& b, const std::vector<std::string>& inputs,
+                       size_t top, size_t show)
+{
+    size_t top1 = 0;
+    size_t exact = 0;
+    size_t bothEmpty = 0;
+    size_t onlyA = 0;
+    size_t onlyB = 0;
+    double overlap = 0.0;
+    size_t shown = 0;
+
+    std::cout << "[agreement " << a.name << " vs " << b.name << ", top " << top << "]" << std::endl;
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const std::vector<std::string> ca(a.candidates[i].begin(), a.candidates[i].begin() + std::min(top, a.candidates[i].size()));
+        const std::vector<std::string> cb(b.candidates[i].begin(), b.candidates[i].begin() + std::min(top, b.candidates[i].size()));
+
+        if (ca.empty() && cb.empty())
+        {
+            ++bothEmpty;
+            ++top1;
+            ++exact;
+            overlap += 1.0;
+            continue;
+        }
+        if (cb.empty()) ++onlyA;
+        if (ca.empty()) ++onlyB;
+
+        const std::set<std::string> sa(ca.begin(), ca.end());
+        const std::set<std::string> sb(cb.begin(), cb.end());
+        size_t common = 0;
+        for (const auto& s : sa)
+        {
+            common += sb.count(s);
+        }
+        overlap += static_cast<double>(common) / static_cast<double>(sa.size() + sb.size() - common);
+
+        const bool sameTop = !ca.empty() && !cb.empty() && ca[0] == cb[0];
+        top1 += sameTop ? 1 : 0;
+        exact += ca == cb ? 1 : 0;
+
+        if (ca != cb && shown < show)
+        {
+            ++shown;
+            std::cout << "  \"" << inputs[i] << "\": ";
+            for (const auto& s : ca) std::cout << s << ' ';
+            std::cout << "| ";
+            for (const auto& s : cb) std::cout << s << ' ';
+            std::cout << std::endl;
+        }
+    }
+
+    const double n = inputs.empty() ? 1.0 : static_cast<double>(inputs.size());
+    std::cout << "  inputs: " << inputs.size() << " (both empty " << bothEmpty << ", only " << a.name << " "
+              << onlyA << ", only " << b.name << " " << onlyB << ")" << std::endl;
+    std::cout << "  top-1 agreement: " << 100.0 * top1 / n << "%" << std::endl;
+    std::cout << "  identical lists: " << 100.0 * exact / n << "%" << std::endl;
+    std::cout << "  mean overlap (Jaccard): " << 100.0 * overlap / n << "%" << std::endl;
+}
+
+std::filesystem::path ResolveDict(const std::filesystem::path& dir)
+{
+    for (const auto& candidate : { dir / "pinyin.dict.json", dir / "dicts" / "pinyin.dict.json" })
+    {
+        if (std::filesystem::is_regular_file(candidate))
+        {
+            return candidate;
+        }
+    }
+    return {};
+}
+
+// Inputs from a trace: every distinct composition the user produced
+bool InputsFromTrace(const std::filesystem::path& path, const Dictionary& dictionary, std::vector<std::string>& inputs)
+{
+    std::vector<TraceEvent> events;
+    if (!ReadTypingTrace(path.wstring(), events))
+    {
+        return false;
+    }
+    std::vector<std::wstring> readings;
+    for (const auto& entry : dictionary.GetAllEntries())
+    {
+        std::wstring letters = FoldReadingToLetters(entry.first);
+        if (!letters.empty())
+        {
+            readings.push_back(std::move(letters));
+        }
+    }
+    for (const auto& step : BuildTraceWorkload(events, readings))
+    {
+        if (step.type == TraceEventType::Key && !step.input.empty())
+        {
+            inputs.push_back(ToUtf8(step.input));
+        }
+    }
+    return true;
+}
+
+// Default inputs: each dictionary key as stored and as typed (letters only)
+void InputsFromDictionary(const Dictionary& dictionary, std::vector<std::string>& inputs)
+{
+    std::set<std::wstring> seen;
+    for (const auto& entry : dictionary.GetAllEntries())
+    {
+        for (const std::wstring& input : { entry.first, FoldReadingToLetters(entry.first) })
+        {
+            if (!input.empty() && seen.insert(input).second)
+            {
+                inputs.push_back(ToUtf8(input));
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    std::filesystem::path dictDir = "src/dicts";
+    std::filesystem::path inputsPath;
+    std::filesystem::path tracePath;
+    int iterations = 5;
+    size_t top = 10;
+    size_t limit = 0;
+    size_t show = 10;
+    bool shipped = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--dict-dir" && hasValue) dictDir = argv[++i];
+        else if (arg == "--inputs" && hasValue) inputsPath = argv[++i];
+        else if (arg == "--trace" && hasValue) tracePath = argv[++i];
+        else if (arg == "--iterations" && hasValue) iterations = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--top" && hasValue) top = std::max<size_t>(1, std::strtoul(argv[++i], nullptr, 10));
+        else if (arg == "--limit" && hasValue) limit = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--show" && hasValue) show = std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--shipped") shipped = true;
+        else
+        {
+            std::cerr << "Usage: engine_diff_bench [--dict-dir DIR] [--inputs FILE | --trace FILE] "
+                         "[--iterations N] [--top K] [--limit N] [--show N] [--shipped]" << std::endl;
+            return 2;
+        }
+    }
+
+    const std::filesystem::path dictPath = ResolveDict(dictDir);
+    Dictionary dictionary;
+    if (dictPath.empty() || !dictionary.LoadFromFile(dictPath.wstring()))
+    {
+        std::cerr << "pinyin.dict.json not found or invalid under " << dictDir.string() << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> inputs;
+    if (!inputsPath.empty())
+    {
+        std::ifstream file(inputsPath);
+        for (std::string line; std::getline(file, line);)
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (!line.empty()) inputs.push_back(line);
+        }
+    }
+    else if (!tracePath.empty())
+    {
+        if (!InputsFromTrace(tracePath, dictionary, inputs))
+        {
+            std::cerr << "Failed to read trace: " << tracePath.string() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        InputsFromDictionary(dictionary, inputs);
+    }
+    if (limit > 0 && inputs.size() > limit)
+    {
+        inputs.resize(limit);
+    }
+
+    std::cout << "MAIDOS IME engine differential benchmark" << std::endl;
+    std::cout << "dictionary: " << dictPath.string() << " (" << dictionary.GetAllEntries().size() << " keys)" << std::endl;
+    std::cout << "inputs: " << inputs.size() << ", iterations: " << iterations << std::endl << std::endl;
+
+    std::vector<std::unique_ptr<EngineAdapter>> engines;
+    engines.push_back(std::make_unique<CppEngineAdapter>());
+    engines.push_back(std::make_unique<RustEngineAdapter>());
+    if (shipped)
+    {
+        engines.push_back(std::make_unique<RustShippedAdapter>());
+    }
+
+    std::vector<EngineReport> reports(engines.size());
+    for (size_t e = 0; e < engines.size(); ++e)
+    {
+        RunEngine(*engines[e], dictPath, inputs, iterations, reports[e]);
+        PrintReport(reports[e]);
+    }
+    std::cout << std::endl;
+
+    if (!reports[0].loaded || !reports[1].loaded)
+    {
+        return 1;
+    }
+    CompareCandidates(reports[0], reports[1], inputs, top, show);
+    if (shipped && reports[2].loaded)
+    {
+        std::cout << std::endl << "(built-in table; differs from " << dictPath.filename().string() << ")" << std::endl;
+        CompareCandidates(reports[1], reports[2], inputs, top, show);
+    }
+
+    return 0;
+}
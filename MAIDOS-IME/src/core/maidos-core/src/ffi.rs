@@ -491,6 +491,121 @@ pub unsafe extern "C" fn ime_clear_learned(
     }
 }
 
+// =====================================================================
+// FFI: Pinyin engine handle (differential benchmark)
+// =====================================================================
+
+/// Pinyin engine loaded once and reused across calls
+pub struct PinyinEngineHandle {
+    scheme: crate::schemes::PinyinScheme,
+}
+
+/// Open a pinyin engine over a dictionary file in the `{"entries": {...}}`
+/// format shared with the C++ core. A null path uses the built-in table.
+/// Returns null on failure; release with `ime_pinyin_engine_close`.
+///
+/// # Safety
+/// - `dict_path` must be null or point to a valid NUL-terminated C string.
+#[no_mangle]
+pub unsafe extern "C" fn ime_pinyin_engine_open(
+    dict_path: *const c_char,
+) -> *mut PinyinEngineHandle {
+    let scheme = if dict_path.is_null() {
+        crate::schemes::PinyinScheme::new_default()
+    } else {
+        let path = match ptr_to_str(dict_path) {
+            Some(s) => s,
+            None => {
+                set_last_error("dict_path is not valid UTF-8".to_string());
+                return ptr::null_mut();
+            }
+        };
+        match crate::schemes::PinyinScheme::new_from_file(path) {
+            Ok(s) => s,
+            Err(e) => {
+                set_last_error(format!("Dictionary load failed: {}", e));
+                return ptr::null_mut();
+            }
+        }
+    };
+    Box::into_raw(Box::new(PinyinEngineHandle { scheme }))
+}
+
+/// Candidates (JSON, same shape as `ime_get_candidates`) from an open engine
+///
+/// # Safety
+/// - `handle` must be null or a live pointer returned by `ime_pinyin_engine_open`.
+/// - `input` must be null or point to a valid NUL-terminated C string.
+#[no_mangle]
+pub unsafe extern "C" fn ime_pinyin_engine_candidates(
+    handle: *const PinyinEngineHandle,
+    input: *const c_char,
+) -> *mut c_char {
+    if handle.is_null() {
+        set_last_error("handle is null".to_string());
+        return ptr::null_mut();
+    }
+    let input_str = match ptr_to_str(input) {
+        Some(s) => s,
+        None => {
+            set_last_error("input is null".to_string());
+            return ptr::null_mut();
+        }
+    };
+
+    match (*handle).scheme.get_candidates(input_str) {
+        Ok(candidates) => string_to_c(candidates_to_json(&candidates)),
+        Err(e) => {
+            set_last_error(format!("get_candidates failed: {}", e));
+            ptr::null_mut()
+        }
+    }
+}
+
+/// Release an engine opened with `ime_pinyin_engine_open`
+///
+/// # Safety
+/// - `handle` must be null or a pointer returned by `ime_pinyin_engine_open` that has not yet been closed.
+#[no_mangle]
+pub unsafe extern "C" fn ime_pinyin_engine_close(handle: *mut PinyinEngineHandle) {
+    if !handle.is_null() {
+        drop(Box::from_raw(handle));
+    }
+}
+
+/// Allocation counters since process start.
+/// Returns 0 when built with the `alloc-stats` feature, -1 otherwise.
+///
+/// # Safety
+/// - Each pointer must be null or point to writable `u64` storage.
+#[no_mangle]
+pub unsafe extern "C" fn ime_alloc_stats(
+    allocations: *mut u64,
+    allocated_bytes: *mut u64,
+    live_bytes: *mut u64,
+) -> i32 {
+    #[cfg(feature = "alloc-stats")]
+    {
+        let (count, bytes, live) = crate::alloc_stats::snapshot();
+        if !allocations.is_null() {
+            *allocations = count;
+        }
+        if !allocated_bytes.is_null() {
+            *allocated_bytes = bytes;
+        }
+        if !live_bytes.is_null() {
+            *live_bytes = live;
+        }
+        0
+    }
+    #[cfg(not(feature = "alloc-stats"))]
+    {
+        let _ = (allocations, allocated_bytes, live_bytes);
+        set_last_error("built without the alloc-stats feature".to_string());
+        -1
+    }
+}
+
 // =====================================================================
 // Tests
 // =====================================================================
@@ -607,4 +722,24 @@ mod tests {
     fn test_ffi_init() {
         assert_eq!(ime_init(), 0);
     }
+
+    #[test]
+    fn test_ffi_pinyin_engine_handle() {
+        unsafe {
+            let handle = ime_pinyin_engine_open(ptr::null());
+            assert!(!handle.is_null());
+
+            let input = CString::new("ni").unwrap();
+            let result = ime_pinyin_engine_candidates(handle, input.as_ptr());
+            assert!(!result.is_null());
+            let json = CStr::from_ptr(result).to_str().unwrap();
+            assert!(json.contains("你"));
+            ime_free_string(result);
+            ime_pinyin_engine_close(handle);
+
+            let missing = CString::new("/nonexistent/pinyin.dict.json").unwrap();
+            assert!(ime_pinyin_engine_open(missing.as_ptr()).is_null());
+            assert!(ime_pinyin_engine_candidates(ptr::null(), input.as_ptr()).is_null());
+        }
+    }
 }
@@ -17,6 +17,8 @@ pub mod english;
 pub mod japanese;
 pub mod user_learning;
 pub mod ffi;
+#[cfg(feature = "alloc-stats")]
+pub mod alloc_stats;
 
 /// MAIDOS-IME core error type
 #[derive(thiserror::Error, Debug)]
@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include "../../src/MAIDOS.IME.Core/phrase_miner.h"
+#include <algorithm>
+
+namespace {
+
+void Commit(PhraseMiner& miner, std::initializer_list<std::pair<const wchar_t*, const wchar_t*>> commits) {
+    for (const auto& c : commits) miner.RecordCommit(c.first, c.second);
+    miner.BreakSequence();
+}
+
+} // namespace
+
+TEST(PhraseMinerTest, PromotesRepeatedSequence) {
+    PhraseMiner::Options options;
+    options.promoteCount = 3;
+    options.readingSeparator = L" ";
+    PhraseMiner miner(options);
+
+    std::vector<PhraseMiner::MinedPhrase> promoted;
+    for (int i = 0; i < 2; ++i) {
+        Commit(miner, { { L"mai", L"\x9EA5" }, { L"dou", L"\x515C" } });
+    }
+    miner.ProcessPending();
+    EXPECT_EQ(miner.TakePromotions(promoted), 0u);
+    EXPECT_EQ(miner.Estimate({ L"\x9EA5", L"\x515C" }), 2u);
+
+    Commit(miner, { { L"mai", L"\x9EA5" }, { L"dou", L"\x515C" } });
+    miner.ProcessPending();
+    ASSERT_EQ(miner.TakePromotions(promoted), 1u);
+    EXPECT_EQ(promoted[0].word, L"\x9EA5\x515C");
+    EXPECT_EQ(promoted[0].reading, L"mai dou");
+    EXPECT_EQ(promoted[0].count, 3u);
+
+    // 已升級的片語不再重複回報
+    Commit(miner, { { L"mai", L"\x9EA5" }, { L"dou", L"\x515C" } });
+    miner.ProcessPending();
+    EXPECT_EQ(miner.TakePromotions(promoted), 0u);
+}
+
+TEST(PhraseMinerTest, BreaksAndLengthLimits) {
+    PhraseMiner::Options options;
+    options.promoteCount = 2;
+    options.maxPhraseLength = 4;
+    PhraseMiner miner(options);
+
+    // 中斷序列的兩次提交不構成片語
+    for (int i = 0; i < 5; ++i) {
+        miner.RecordCommit(L"a", L"A");
+        miner.BreakSequence();
+        miner.RecordCommit(L"b", L"B");
+        miner.BreakSequence();
+    }
+    miner.ProcessPending();
+    EXPECT_EQ(miner.Estimate({ L"A", L"B" }), 0u);
+
+    // 超過字數上限的片語不計數
+    for (int i = 0; i < 3; ++i) {
+        Commit(miner, { { L"x", L"XXX" }, { L"y", L"YY" } });
+    }
+    miner.ProcessPending();
+    EXPECT_EQ(miner.Estimate({ L"XXX", L"YY" }), 0u);
+
+    // 三段序列同時產生 2 與 3 段的片語
+    std::vector<PhraseMiner::MinedPhrase> promoted;
+    for (int i = 0; i < 2; ++i) {
+        Commit(miner, { { L"p", L"P" }, { L"q", L"Q" }, { L"r", L"R" } });
+    }
+    miner.ProcessPending();
+    miner.TakePromotions(promoted);
+    std::vector<std::wstring> words;
+    for (const auto& p : promoted) words.push_back(p.word);
+    std::sort(words.begin(), words.end());
+    EXPECT_EQ(words, (std::vector<std::wstring>{ L"PQ", L"PQR", L"QR" }));
+}
+
+TEST(PhraseMinerTest, BoundedMemoryUnderNoise) {
+    PhraseMiner::Options options;
+    options.heavyHitters = 32;
+    options.promoteCount = 20;
+    PhraseMiner miner(options);
+    const size_t baseline = miner.GetMemoryBytes();
+
+    // 大量只出現一次的序列 + 一個反覆出現的片語
+    std::vector<PhraseMiner::MinedPhrase> promoted;
+    for (int i = 0; i < 20000; ++i) {
+        miner.RecordCommit(L"r", std::wstring(1, static_cast<wchar_t>(0x4E00 + (i * 7919) % 20000)));
+        if (i % 50 == 0) {
+            miner.BreakSequence();
+            Commit(miner, { { L"zhang", L"\x5F35" }, { L"san", L"\x4E09" } });
+        }
+        if (i % 500 == 0) miner.ProcessPending();
+    }
+    miner.ProcessPending();
+
+    EXPECT_LE(miner.GetTrackedCount(), 32u);
+    EXPECT_LT(miner.GetMemoryBytes(), baseline + 64 * 1024);
+    miner.TakePromotions(promoted);
+    ASSERT_FALSE(promoted.empty());
+    EXPECT_EQ(promoted[0].word, L"\x5F35\x4E09") << "[MAIDOS-AUDIT] heavy hitter lost among noise";
+}
+
+TEST(PhraseMinerTest, WorkerThreadAndQueueBound) {
+    PhraseMiner::Options options;
+    options.promoteCount = 3;
+    options.queueCapacity = 8;
+    PhraseMiner miner(options);
+
+    // 佇列滿時丟棄最舊的提交
+    for (int i = 0; i < 20; ++i) miner.RecordCommit(L"k", L"K");
+    miner.BreakSequence();
+    EXPECT_EQ(miner.GetDroppedCount(), 12u);
+    miner.ProcessPending();
+    std::vector<PhraseMiner::MinedPhrase> promoted;
+    miner.TakePromotions(promoted);
+    promoted.clear();
+
+    miner.Start();
+    for (int i = 0; i < 3; ++i) {
+        Commit(miner, { { L"ni", L"\x4F60" }, { L"hao", L"\x597D" } });
+    }
+    miner.Flush();
+    ASSERT_EQ(miner.TakePromotions(promoted), 1u);
+    EXPECT_EQ(promoted[0].reading, L"nihao");
+    miner.Stop();
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include "../../src/MAIDOS.IME.Core/pinyin_tone_index.h"
+#include "../../src/MAIDOS.IME.Core/pinyin_parser.h"
+#include <algorithm>
+
+namespace {
+
+std::vector<TonedSyllableId> Parse(const std::wstring& text, bool unmarkedIsNeutral = false) {
+    std::vector<TonedSyllableId> out;
+    EXPECT_TRUE(ParsePinyinReading(text, out, unmarkedIsNeutral)) << "[MAIDOS-AUDIT] parse failed";
+    return out;
+}
+
+TonedSyllableId Toned(const char* syllable, uint8_t tone) {
+    return MakeTonedSyllable(FindPinyinSyllable(std::string_view(syllable)), tone);
+}
+
+void Add(Dictionary& dict, const std::wstring& reading, const std::wstring& word, unsigned int frequency) {
+    dict.AddEntry(reading, Dictionary::DictEntry{ word, frequency, reading, {} });
+}
+
+std::vector<std::wstring> Words(const PinyinToneIndex& index, const std::wstring& input) {
+    std::vector<TonedSyllableId> syllables;
+    std::vector<Dictionary::DictEntry> entries;
+    if (ParsePinyinReading(input, syllables, false)) index.Lookup(syllables, entries);
+    std::vector<std::wstring> words;
+    for (const auto& e : entries) words.push_back(e.word);
+    std::sort(words.begin(), words.end());
+    return words;
+}
+
+// 測試用詞典：聲調標記讀音 + 一筆無聲調讀音
+void FillDictionary(Dictionary& dict) {
+    Add(dict, L"m\x01CEi", L"\x8CB7", 900);              // mǎi 買
+    Add(dict, L"m\x00E0i", L"\x8CE3", 800);              // mài 賣
+    Add(dict, L"mai", L"\x57CB", 100);                   // 無聲調 埋
+    Add(dict, L"n\x01D0 h\x01CEo", L"\x4F60\x597D", 1000);  // nǐ hǎo 你好
+    Add(dict, L"xi\x00E8 xie", L"\x8B1D\x8B1D", 950);    // xiè xie 謝謝（輕聲）
+    Add(dict, L"x\x012B \x0101n", L"\x897F\x5B89", 700); // xī ān 西安
+}
+
+} // namespace
+
+TEST(PinyinToneIndexTest, ParsesReadings) {
+    EXPECT_EQ(Parse(L"ni3hao3"), (std::vector<TonedSyllableId>{ Toned("ni", 3), Toned("hao", 3) }));
+    EXPECT_EQ(Parse(L"ni3hao"), (std::vector<TonedSyllableId>{ Toned("ni", 3), Toned("hao", kToneAny) }));
+    EXPECT_EQ(Parse(L"n\x00ED h\x01CEo"), (std::vector<TonedSyllableId>{ Toned("ni", 2), Toned("hao", 3) }));
+    EXPECT_EQ(Parse(L"NiHao"), (std::vector<TonedSyllableId>{ Toned("ni", kToneAny), Toned("hao", kToneAny) }));
+
+    // 最少音節切分；撇號或聲調數字可強制分隔
+    EXPECT_EQ(Parse(L"xian"), (std::vector<TonedSyllableId>{ Toned("xian", kToneAny) }));
+    EXPECT_EQ(Parse(L"xi'an"), (std::vector<TonedSyllableId>{ Toned("xi", kToneAny), Toned("an", kToneAny) }));
+    EXPECT_EQ(Parse(L"xi1an1"), (std::vector<TonedSyllableId>{ Toned("xi", 1), Toned("an", 1) }));
+
+    // ü / v 與輕聲
+    EXPECT_EQ(Parse(L"l\x00FC\x00E8"), (std::vector<TonedSyllableId>{ Toned("lve", 4) }));
+    EXPECT_EQ(Parse(L"lv4"), (std::vector<TonedSyllableId>{ Toned("lv", 4) }));
+    EXPECT_EQ(Parse(L"xie4xie0"), (std::vector<TonedSyllableId>{ Toned("xie", 4), Toned("xie", kToneNeutral) }));
+    EXPECT_EQ(Parse(L"xi\x00E8 xie", true), (std::vector<TonedSyllableId>{ Toned("xie", 4), Toned("xie", kToneNeutral) }));
+    EXPECT_EQ(Parse(L"ni hao", true), (std::vector<TonedSyllableId>{ Toned("ni", kToneAny), Toned("hao", kToneAny) }));
+
+    std::vector<TonedSyllableId> out;
+    EXPECT_FALSE(ParsePinyinReading(L"xyz", out, false));
+    EXPECT_FALSE(ParsePinyinReading(L"3ni", out, false));
+    EXPECT_FALSE(ParsePinyinReading(L"ni7", out, false));
+    EXPECT_FALSE(ParsePinyinReading(L"", out, false));
+}
+
+TEST(PinyinToneIndexTest, TonesFilterPostings) {
+    Dictionary dict;
+    FillDictionary(dict);
+    PinyinToneIndex index;
+    index.Build(dict);
+    EXPECT_EQ(index.GetPostingCount(), 6u);
+    EXPECT_EQ(index.GetKeyCount(), 4u);
+
+    // 無聲調輸入取得整個 posting list；聲調數字縮小範圍，無聲調讀音仍保留
+    EXPECT_EQ(Words(index, L"mai"), (std::vector<std::wstring>{ L"\x57CB", L"\x8CB7", L"\x8CE3" }));
+    EXPECT_EQ(Words(index, L"mai3"), (std::vector<std::wstring>{ L"\x57CB", L"\x8CB7" }));
+    EXPECT_EQ(Words(index, L"mai4"), (std::vector<std::wstring>{ L"\x57CB", L"\x8CE3" }));
+
+    // 部分聲調
+    EXPECT_EQ(Words(index, L"nihao"), (std::vector<std::wstring>{ L"\x4F60\x597D" }));
+    EXPECT_EQ(Words(index, L"ni3hao"), (std::vector<std::wstring>{ L"\x4F60\x597D" }));
+    EXPECT_EQ(Words(index, L"nihao3"), (std::vector<std::wstring>{ L"\x4F60\x597D" }));
+    EXPECT_TRUE(Words(index, L"ni2hao").empty());
+
+    // 輕聲：5 或 0
+    EXPECT_EQ(Words(index, L"xie4xie5"), (std::vector<std::wstring>{ L"\x8B1D\x8B1D" }));
+    EXPECT_EQ(Words(index, L"xie4xie0"), (std::vector<std::wstring>{ L"\x8B1D\x8B1D" }));
+    EXPECT_TRUE(Words(index, L"xie4xie4").empty());
+
+    EXPECT_EQ(Words(index, L"xi1an1"), (std::vector<std::wstring>{ L"\x897F\x5B89" }));
+    EXPECT_TRUE(Words(index, L"xian1").empty());
+}
+
+TEST(PinyinToneIndexTest, ParserUsesIndex) {
+    Dictionary dict;
+    FillDictionary(dict);
+    PinyinParser parser(dict);
+
+    auto result = parser.ParseContinuousPinyin(L"ni3hao3");
+    ASSERT_EQ(result.candidates.size(), 1u);
+    EXPECT_EQ(result.candidates[0], L"\x4F60\x597D");
+
+    result = parser.ParseContinuousPinyin(L"mai3");
+    ASSERT_EQ(result.candidates.size(), 2u);
+    EXPECT_EQ(result.candidates[0], L"\x8CB7") << "[MAIDOS-AUDIT] candidates not ordered by frequency";
+
+    // 新增詞條後重建索引
+    Add(dict, L"m\x01CEi m\x00E0i", L"\x8CB7\x8CE3", 600);
+    EXPECT_TRUE(parser.ParseContinuousPinyin(L"mai3mai4").candidates.empty());
+    parser.RebuildIndex();
+    result = parser.ParseContinuousPinyin(L"mai3mai4");
+    ASSERT_FALSE(result.candidates.empty());
+    EXPECT_EQ(result.candidates[0], L"\x8CB7\x8CE3");
+}
+
+TEST(PinyinToneIndexTest, IndexAddedEntryAppends) {
+    Dictionary dict;
+    FillDictionary(dict);
+    PinyinParser parser(dict);
+    const size_t postings = parser.GetToneIndex().GetPostingCount();
+    EXPECT_FALSE(parser.ParseContinuousPinyin(L"mai3").candidates.empty());
+
+    // 新增詞條只追加一筆 posting，無需重建；既有讀音下的新詞條同樣可查到
+    Add(dict, L"m\x01CEi m\x00E0i", L"\x8CB7\x8CE3", 600);
+    parser.IndexAddedEntry(L"m\x01CEi m\x00E0i");
+    Add(dict, L"m\x01CEi", L"\x6E80", 10);
+    parser.IndexAddedEntry(L"m\x01CEi");
+    EXPECT_EQ(parser.GetToneIndex().GetPostingCount(), postings + 2);
+
+    auto result = parser.ParseContinuousPinyin(L"mai3mai4");
+    ASSERT_FALSE(result.candidates.empty());
+    EXPECT_EQ(result.candidates[0], L"\x8CB7\x8CE3");
+    result = parser.ParseContinuousPinyin(L"mai3");
+    EXPECT_EQ(result.candidates.size(), 3u) << "[MAIDOS-AUDIT] memoized result survived IndexAddedEntry";
+
+    PinyinToneIndex rebuilt;
+    rebuilt.Build(dict);
+    EXPECT_EQ(rebuilt.GetPostingCount(), parser.GetToneIndex().GetPostingCount());
+    EXPECT_EQ(rebuilt.GetKeyCount(), parser.GetToneIndex().GetKeyCount());
+}
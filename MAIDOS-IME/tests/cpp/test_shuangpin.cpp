@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include "../../src/MAIDOS.IME.Core/shuangpin_scheme.h"
+#include "../../src/MAIDOS.IME.Core/pinyin_parser.h"
+
+class ShuangpinSchemeTest : public ::testing::Test {
+protected:
+    Dictionary dictionary;
+    std::unique_ptr<PinyinParser> parser;
+    ShuangpinScheme scheme;
+
+    void SetUp() override {
+        dictionary.AddEntry(L"ni hao", Dictionary::DictEntry{ L"\x4F60\x597D", 1000, L"ni hao", {} });
+        dictionary.AddEntry(L"shuang pin", Dictionary::DictEntry{ L"\x53CC\x62FC", 500, L"shuang pin", {} });
+        dictionary.AddEntry(L"er", Dictionary::DictEntry{ L"\x4E8C", 700, L"er", {} });
+        parser = std::make_unique<PinyinParser>(dictionary);
+        scheme.SetParser(parser.get());
+    }
+
+    std::wstring Decode(const ShuangpinLayout& layout, const std::wstring& keys) {
+        scheme.SetLayout(layout);
+        for (wchar_t key : keys) {
+            if (!scheme.PushKey(key)) return L"<invalid>";
+        }
+        return scheme.GetReading();
+    }
+};
+
+// 每個可輸入的音節在三種佈局中都必須有唯一的兩鍵編碼
+TEST_F(ShuangpinSchemeTest, EverySyllableReachable) {
+    for (const wchar_t* name : { L"xiaohe", L"ziranma", L"microsoft" }) {
+        const ShuangpinLayout* layout = FindShuangpinLayout(name);
+        ASSERT_NE(layout, nullptr);
+        std::vector<int> hits(kPinyinSyllableCount, 0);
+        for (SyllableId id : *layout->table) {
+            if (id != kInvalidSyllable) hits[id]++;
+        }
+        for (size_t id = 0; id < kPinyinSyllableCount; ++id) {
+            // lo 與 luo 共用 o 鍵，依各佈局慣例只能打出 luo
+            if (std::string(kPinyinSyllables[id]) == "lo") continue;
+            EXPECT_GE(hits[id], 1) << "[MAIDOS-AUDIT] " << kPinyinSyllables[id] << " has no key pair";
+        }
+    }
+}
+
+TEST_F(ShuangpinSchemeTest, LayoutDecoding) {
+    const ShuangpinLayout& xiaohe = *FindShuangpinLayout(L"xiaohe");
+    const ShuangpinLayout& ziranma = *FindShuangpinLayout(L"ziranma");
+    const ShuangpinLayout& microsoft = *FindShuangpinLayout(L"microsoft");
+
+    EXPECT_EQ(Decode(xiaohe, L"nihc"), L"ni hao");
+    EXPECT_EQ(Decode(xiaohe, L"ulpb"), L"shuang pin");
+    EXPECT_EQ(Decode(xiaohe, L"vsiyuu"), L"zhong chun shu");
+    EXPECT_EQ(Decode(xiaohe, L"aaahzz"), L"a ang zou");
+    EXPECT_EQ(Decode(ziranma, L"nikk"), L"ni kao");
+    EXPECT_EQ(Decode(ziranma, L"udpn"), L"shuang pin");
+    EXPECT_EQ(Decode(ziranma, L"alob"), L"ai ou");
+    EXPECT_EQ(Decode(microsoft, L"x;or"), L"xing er");
+    EXPECT_EQ(Decode(microsoft, L"lvnv"), L"lve nve");
+    EXPECT_EQ(Decode(microsoft, L"jy"), L"ju");
+
+    // 不構成音節的鍵對會被拒絕
+    EXPECT_EQ(Decode(xiaohe, L"bk"), L"bing");
+    EXPECT_EQ(Decode(xiaohe, L"fi"), L"<invalid>");
+    EXPECT_EQ(Decode(xiaohe, L"1a"), L"<invalid>");
+}
+
+TEST_F(ShuangpinSchemeTest, IncrementalKeys) {
+    scheme.SetLayout(*FindShuangpinLayout(L"xiaohe"));
+    EXPECT_TRUE(scheme.PushKey(L'n'));
+    EXPECT_TRUE(scheme.HasPendingKey());
+    EXPECT_EQ(scheme.GetSyllableCount(), 0u);
+    EXPECT_TRUE(scheme.PushKey(L'i'));
+    EXPECT_EQ(scheme.GetSyllableCount(), 1u);
+    EXPECT_EQ(scheme.GetSyllable(0), FindPinyinSyllable("ni"));
+    EXPECT_TRUE(scheme.PushKey(L'h'));
+    EXPECT_TRUE(scheme.PopKey());
+    EXPECT_TRUE(scheme.PopKey());
+    EXPECT_TRUE(scheme.HasPendingKey());
+    EXPECT_TRUE(scheme.PushKey(L'i'));
+    EXPECT_EQ(scheme.GetReading(), L"ni");
+
+    // 切換佈局只換指標並清空組字
+    scheme.SetLayout(*FindShuangpinLayout(L"microsoft"));
+    EXPECT_EQ(scheme.GetSyllableCount(), 0u);
+    EXPECT_FALSE(scheme.PopKey());
+}
+
+TEST_F(ShuangpinSchemeTest, CandidatesFromPinyinDictionary) {
+    scheme.SetLayout(*FindShuangpinLayout(L"xiaohe"));
+    auto candidates = scheme.GetCandidates(L"nihc");
+    ASSERT_FALSE(candidates.empty());
+    EXPECT_EQ(candidates[0].character, L"\x4F60\x597D");
+
+    // 逐鍵輸入 (含尚未完成的第二鍵) 與退格
+    EXPECT_TRUE(scheme.GetCandidates(L"n").empty());
+    EXPECT_TRUE(scheme.GetCandidates(L"ulp").empty());
+    candidates = scheme.GetCandidates(L"ulpb");
+    ASSERT_FALSE(candidates.empty());
+    EXPECT_EQ(candidates[0].character, L"\x53CC\x62FC");
+
+    scheme.SetLayout(*FindShuangpinLayout(L"microsoft"));
+    candidates = scheme.GetCandidates(L"or");
+    ASSERT_FALSE(candidates.empty());
+    EXPECT_EQ(candidates[0].character, L"\x4E8C");
+
+    EXPECT_TRUE(scheme.GetCandidates(L"fi").empty()) << "[MAIDOS-AUDIT] invalid pair must not produce candidates";
+}
+
+TEST_F(ShuangpinSchemeTest, FactoryNames) {
+    EXPECT_NE(SchemeFactory::CreateScheme(L"shuangpin"), nullptr);
+    EXPECT_NE(SchemeFactory::CreateScheme(L"shuangpin_xiaohe"), nullptr);
+    EXPECT_NE(SchemeFactory::CreateScheme(L"shuangpin_ziranma"), nullptr);
+    EXPECT_NE(SchemeFactory::CreateScheme(L"shuangpin_microsoft"), nullptr);
+    EXPECT_EQ(SchemeFactory::CreateScheme(L"shuangpin_dvorak"), nullptr);
+}
+
+// ';' 只在有指定韻母的佈局 (微軟) 上屬於組字鍵
+TEST_F(ShuangpinSchemeTest, SemicolonOnlyWhereLayoutUsesIt) {
+    ASSERT_EQ(ShuangpinLayouts().size(), 3u);
+    for (const ShuangpinLayout* layout : ShuangpinLayouts()) {
+        scheme.SetLayout(*layout);
+        EXPECT_TRUE(scheme.UsesKey(L'q')) << "[MAIDOS-AUDIT] " << layout->name;
+        EXPECT_EQ(scheme.UsesKey(L';'), std::wstring(layout->name) == L"microsoft");
+        EXPECT_FALSE(scheme.UsesKey(L','));
+    }
+    EXPECT_EQ(Decode(*FindShuangpinLayout(L"microsoft"), L"x;"), L"xing");
+}
+
+// 提交時記錄的是解碼後的讀音，不是佈局按鍵
+TEST_F(ShuangpinSchemeTest, ReadingForCommit) {
+    scheme.SetLayout(*FindShuangpinLayout(L"xiaohe"));
+    EXPECT_EQ(scheme.ReadingFor(L"nihc"), L"ni hao");
+    EXPECT_EQ(scheme.ReadingFor(L"nih"), L"");
+    EXPECT_EQ(scheme.ReadingFor(L"fi"), L"");
+    scheme.SetLayout(*FindShuangpinLayout(L"microsoft"));
+    EXPECT_EQ(scheme.ReadingFor(L"x;or"), L"xing er");
+}
+
+// 直接以音節 ID 查索引：聲調不同的同一詞只出現一次，新加入的詞立即可查
+TEST_F(ShuangpinSchemeTest, LooksUpSyllableIndex) {
+    dictionary.AddEntry(L"hao3", Dictionary::DictEntry{ L"\x597D", 900, L"hao3", {} });
+    parser->IndexAddedEntry(L"hao3");
+    dictionary.AddEntry(L"hao4", Dictionary::DictEntry{ L"\x597D", 300, L"hao4", {} });
+    parser->IndexAddedEntry(L"hao4");
+    dictionary.AddEntry(L"hao4", Dictionary::DictEntry{ L"\x53F7", 400, L"hao4", {} });
+    parser->IndexAddedEntry(L"hao4");
+
+    scheme.SetLayout(*FindShuangpinLayout(L"xiaohe"));
+    const auto candidates = scheme.GetCandidates(L"hc");
+    ASSERT_EQ(candidates.size(), 2u);
+    EXPECT_EQ(candidates[0].character, L"\x597D");
+    EXPECT_EQ(candidates[0].frequency, 900);
+    EXPECT_EQ(candidates[1].character, L"\x53F7");
+}
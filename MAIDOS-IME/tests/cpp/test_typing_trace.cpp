@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "../../src/MAIDOS.IME.Core/typing_trace.h"
+#include <filesystem>
+
+namespace {
+
+TraceEvent Key(uint64_t t, TraceKeyClass keyClass) {
+    return TraceEvent{ t, TraceEventType::Key, keyClass, 0, 0 };
+}
+
+TraceEvent Commit(uint64_t t, uint16_t index, uint32_t length) {
+    return TraceEvent{ t, TraceEventType::Commit, TraceKeyClass::None, index, length };
+}
+
+std::wstring TempTracePath(const char* name) {
+    return (std::filesystem::temp_directory_path() / name).wstring();
+}
+
+} // namespace
+
+TEST(TypingTraceTest, EncodeDecodeRoundTrip) {
+    const std::vector<TraceEvent> events = {
+        Key(0, TraceKeyClass::Letter),
+        Key(150000, TraceKeyClass::Letter),
+        Key(150200, TraceKeyClass::Backspace),
+        Commit(400000, 2, 2),
+        TraceEvent{ 5000000, TraceEventType::SchemeSwitch, TraceKeyClass::None, static_cast<uint16_t>(TraceScheme::Shuangpin), 0 },
+        TraceEvent{ 5000001, TraceEventType::Gap, TraceKeyClass::None, 0, 70000 },
+    };
+
+    std::string data;
+    EncodeTraceEvents(events, data, true);
+    std::vector<TraceEvent> decoded;
+    ASSERT_TRUE(DecodeTraceEvents(reinterpret_cast<const uint8_t*>(data.data()), data.size(), decoded));
+    ASSERT_EQ(decoded.size(), events.size());
+    for (size_t i = 0; i < events.size(); ++i) {
+        EXPECT_EQ(decoded[i].timeMicros, events[i].timeMicros);
+        EXPECT_EQ(decoded[i].type, events[i].type);
+        EXPECT_EQ(decoded[i].keyClass, events[i].keyClass);
+        EXPECT_EQ(decoded[i].a, events[i].a);
+        EXPECT_EQ(decoded[i].b, events[i].b);
+    }
+
+    // 截斷或錯誤的檔頭必須被拒絕
+    EXPECT_FALSE(DecodeTraceEvents(reinterpret_cast<const uint8_t*>(data.data()), data.size() - 1, decoded));
+    data[0] = 'X';
+    EXPECT_FALSE(DecodeTraceEvents(reinterpret_cast<const uint8_t*>(data.data()), data.size(), decoded));
+}
+
+TEST(TypingTraceTest, KeyClassification) {
+    EXPECT_EQ(TraceKeyClassFromVirtualKey('N'), TraceKeyClass::Letter);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey('3'), TraceKeyClass::Digit);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(0x63), TraceKeyClass::Digit);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(VK_SPACE), TraceKeyClass::Space);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(VK_BACK), TraceKeyClass::Backspace);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(0xBC), TraceKeyClass::Punctuation);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(0x70), TraceKeyClass::Other);
+    // 微軟雙拼的 ';' 是組字鍵
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(0xBA), TraceKeyClass::Punctuation);
+    EXPECT_EQ(TraceKeyClassFromVirtualKey(0xBA, true), TraceKeyClass::Letter);
+    EXPECT_EQ(TraceSchemeFromName(L"shuangpin"), TraceScheme::Shuangpin);
+    EXPECT_EQ(TraceSchemeFromName(L"shuangpin_microsoft"), TraceScheme::ShuangpinMicrosoft);
+    EXPECT_STREQ(TraceSchemeName(TraceScheme::ShuangpinXiaohe), L"shuangpin_xiaohe");
+    EXPECT_STREQ(TraceSchemeName(TraceScheme::Bopomofo), L"bopomofo");
+}
+
+TEST(TypingTraceTest, RecorderWritesFile) {
+    const std::wstring path = TempTracePath("maidos_test_trace.mdtrace");
+    {
+        TypingTraceRecorder recorder;
+        ASSERT_TRUE(recorder.Open(path));
+        recorder.OnKey(TraceKeyClass::Letter);
+        recorder.OnKey(TraceKeyClass::Letter);
+        recorder.OnCommit(1, 2);
+        recorder.OnBreak();
+        recorder.Close();
+        EXPECT_FALSE(recorder.IsOpen());
+
+        // 關閉後的事件不應寫入
+        recorder.OnKey(TraceKeyClass::Letter);
+    }
+
+    std::vector<TraceEvent> events;
+    ASSERT_TRUE(ReadTypingTrace(path, events));
+    ASSERT_EQ(events.size(), 4u);
+    EXPECT_EQ(events[0].keyClass, TraceKeyClass::Letter);
+    EXPECT_EQ(events[2].type, TraceEventType::Commit);
+    EXPECT_EQ(events[2].a, 1u);
+    EXPECT_EQ(events[2].b, 2u);
+    EXPECT_EQ(events[3].type, TraceEventType::Break);
+    EXPECT_LE(events[0].timeMicros, events[3].timeMicros);
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(TypingTraceTest, FullRingReportsGap) {
+    const std::wstring path = TempTracePath("maidos_test_trace_gap.mdtrace");
+    uint64_t dropped = 0;
+    size_t written = 0;
+    {
+        TypingTraceRecorder recorder;
+        ASSERT_TRUE(recorder.Open(path));
+        // 寫入執行緒每 200ms 才清空一次，一口氣塞超過容量的事件
+        const size_t total = TypingTraceRecorder::kRingCapacity * 4;
+        for (size_t i = 0; i < total; ++i) recorder.OnKey(TraceKeyClass::Letter);
+        recorder.Close();
+        dropped = recorder.GetDroppedCount();
+        written = total - static_cast<size_t>(dropped);
+    }
+
+    std::vector<TraceEvent> events;
+    ASSERT_TRUE(ReadTypingTrace(path, events));
+    uint64_t gapTotal = 0;
+    size_t keys = 0;
+    for (const auto& e : events) {
+        if (e.type == TraceEventType::Gap) gapTotal += e.b;
+        if (e.type == TraceEventType::Key) ++keys;
+    }
+    EXPECT_EQ(keys, written);
+    EXPECT_EQ(gapTotal, dropped) << "[MAIDOS-AUDIT] dropped events not reported as gaps";
+    std::filesystem::remove(std::filesystem::path(path));
+}
+
+TEST(TypingTraceTest, WorkloadSynthesis) {
+    EXPECT_EQ(FoldReadingToLetters(L"n\x00ED h\x01CEo"), L"nihao");
+    EXPECT_EQ(FoldReadingToLetters(L"l\x01DC"), L"lv");
+
+    const std::vector<TraceEvent> events = {
+        Key(0, TraceKeyClass::Letter),
+        Key(100, TraceKeyClass::Letter),
+        Key(200, TraceKeyClass::Letter),
+        Key(300, TraceKeyClass::Backspace),
+        Key(400, TraceKeyClass::Letter),
+        Commit(500, 3, 1),
+        TraceEvent{ 600, TraceEventType::SchemeSwitch, TraceKeyClass::None, static_cast<uint16_t>(TraceScheme::Bopomofo), 0 },
+        Key(700, TraceKeyClass::Letter),
+        TraceEvent{ 800, TraceEventType::Break, TraceKeyClass::None, 0, 0 },
+    };
+
+    const auto steps = BuildTraceWorkload(events, { L"nihao" });
+    ASSERT_EQ(steps.size(), events.size());
+    EXPECT_EQ(steps[2].input, L"nih");
+    EXPECT_EQ(steps[3].input, L"ni");
+    EXPECT_EQ(steps[4].input, L"nih");  // 退格後重打相同字母
+    EXPECT_EQ(steps[5].type, TraceEventType::Commit);
+    EXPECT_EQ(steps[5].input, L"nih");
+    EXPECT_EQ(steps[5].candidateIndex, 3u);
+    EXPECT_EQ(steps[5].delayMicros, 100u);
+    EXPECT_EQ(steps[7].input, L"n");
+    EXPECT_EQ(steps[7].scheme, L"bopomofo");
+    EXPECT_TRUE(steps[8].input.empty());
+
+    // 相同種子產生相同工作負載
+    const std::vector<std::wstring> corpus = { L"ni", L"hao", L"shi", L"jie" };
+    const auto a = BuildTraceWorkload(events, corpus, 7);
+    const auto b = BuildTraceWorkload(events, corpus, 7);
+    for (size_t i = 0; i < a.size(); ++i) EXPECT_EQ(a[i].input, b[i].input);
+}
+
+// 雙拼佈局的工作負載以該佈局的鍵對打出讀音
+TEST(TypingTraceTest, ShuangpinWorkloadUsesLayoutKeys) {
+    const std::vector<TraceEvent> events = {
+        TraceEvent{ 0, TraceEventType::SchemeSwitch, TraceKeyClass::None, static_cast<uint16_t>(TraceScheme::ShuangpinMicrosoft), 0 },
+        Key(100, TraceKeyClass::Letter),
+        Key(200, TraceKeyClass::Letter),
+        Key(300, TraceKeyClass::Letter),
+        Key(400, TraceKeyClass::Letter),
+        Commit(500, 0, 2),
+    };
+
+    const auto steps = BuildTraceWorkload(events, { L"xing", L"ming" });
+    ASSERT_EQ(steps.size(), events.size());
+    EXPECT_EQ(steps[1].scheme, L"shuangpin_microsoft");
+    ASSERT_EQ(steps[4].input.size(), 4u);
+    for (size_t i = 0; i < 4; i += 2) {
+        const std::wstring pair = steps[4].input.substr(i, 2);
+        EXPECT_TRUE(pair == L"x;" || pair == L"m;") << "[MAIDOS-AUDIT] unexpected key pair";
+    }
+}
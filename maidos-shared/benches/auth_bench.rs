@@ -8,7 +8,7 @@
 //! </impl>
 
 use criterion::{black_box, criterion_group, criterion_main, Criterion, BenchmarkId, Throughput};
-use maidos_auth::{Capability, CapabilitySet, TokenIssuer};
+use maidos_auth::{Capability, CapabilitySet, TokenIssuer, VerifyCacheConfig};
 use std::time::Duration;
 
 /// 基準測試：Token 生成
@@ -44,6 +44,51 @@ fn bench_token_verify(c: &mut Criterion) {
     });
 }
 
+/// 基準測試：Token 驗證（停用快取，每次都計算 HMAC）
+fn bench_token_verify_uncached(c: &mut Criterion) {
+    let secret = b"benchmark-secret-key-32-bytes!!".to_vec();
+    let issuer = TokenIssuer::new(secret, Duration::from_secs(3600))
+        .with_verify_cache(VerifyCacheConfig { max_entries: 0, ttl_secs: 0 });
+    
+    let mut caps = CapabilitySet::empty();
+    caps.grant(Capability::LlmChat);
+    let token = issuer.issue(caps).unwrap();
+    let token_str = token.as_str().to_string();
+    
+    c.bench_function("token_verify_uncached", |b| {
+        b.iter(|| {
+            issuer.verify(black_box(&token_str)).unwrap()
+        })
+    });
+}
+
+/// 基準測試：批次驗證（64 個 Token，一半重複）
+fn bench_token_verify_batch(c: &mut Criterion) {
+    let secret = b"benchmark-secret-key-32-bytes!!".to_vec();
+    let issuer = TokenIssuer::new(secret, Duration::from_secs(3600));
+    
+    let tokens: Vec<String> = (0..32)
+        .map(|i| {
+            let caps = CapabilitySet::from_u32(1 << (i % 18));
+            issuer.issue_for_subject(caps, &format!("svc-{}", i)).unwrap().as_str().to_string()
+        })
+        .collect();
+    let batch: Vec<&str> = tokens.iter().chain(tokens.iter()).map(|s| s.as_str()).collect();
+    
+    let mut group = c.benchmark_group("token_verify_batch");
+    group.throughput(Throughput::Elements(batch.len() as u64));
+    group.bench_function("cached", |b| {
+        b.iter(|| issuer.verify_batch(black_box(&batch)))
+    });
+    group.bench_function("uncached", |b| {
+        b.iter(|| {
+            issuer.clear_cache();
+            issuer.verify_batch(black_box(&batch))
+        })
+    });
+    group.finish();
+}
+
 /// 基準測試：Token 生成+驗證完整流程
 fn bench_token_roundtrip(c: &mut Criterion) {
     let secret = b"benchmark-secret-key-32-bytes!!".to_vec();
@@ -172,6 +217,8 @@ criterion_group!(
     benches,
     bench_token_issue,
     bench_token_verify,
+    bench_token_verify_uncached,
+    bench_token_verify_batch,
     bench_token_roundtrip,
     bench_capability_check,
     bench_capability_set,
@@ -4,7 +4,7 @@
 //! WHAT: 訊息匯流排效能基準測試
 //! WHY: 測量 Pub/Sub 吞吐量和延遲
 //! HOW: 使用 Criterion + Tokio runtime
-//! METRICS: 訊息發布、序列化、事件創建 ops/sec
+//! METRICS: 訊息發布、序列化、事件創建 ops/sec、shm ping-pong 單程延遲
 //! </impl>
 
 use criterion::{black_box, criterion_group, criterion_main, Criterion, BenchmarkId, Throughput};
@@ -204,6 +204,45 @@ fn bench_event_id_generation(c: &mut Criterion) {
     });
 }
 
+/// 基準測試：同主機共享記憶體 ping-pong（單程延遲 = 往返 / 2）
+#[cfg(unix)]
+fn bench_shm_ping_pong(c: &mut Criterion) {
+    use maidos_bus::{ShmPublisher, ShmSubscriber};
+    use std::time::Duration;
+
+    let ping_name = format!("bench-ping-{}", std::process::id());
+    let pong_name = format!("bench-pong-{}", std::process::id());
+    let mut ping = ShmPublisher::create(&ping_name).unwrap();
+    let mut pong = ShmPublisher::create(&pong_name).unwrap();
+    let mut ping_rx = ShmSubscriber::open(&ping_name).unwrap();
+    let mut pong_rx = ShmSubscriber::open(&pong_name).unwrap();
+
+    // Echo 執行緒：收到 ping 立即回 pong，收到 bench.stop 結束
+    let echo = std::thread::spawn(move || {
+        while let Some(event) = ping_rx.recv_timeout(Duration::from_secs(5)) {
+            if event.topic == "bench.stop" {
+                break;
+            }
+            pong.publish(event).unwrap();
+        }
+    });
+
+    let event = Event::new("bench.ping", "bench-source", vec![0u8; 64]).unwrap();
+    c.bench_function("shm_ping_pong_roundtrip", |b| {
+        b.iter(|| {
+            ping.publish(black_box(event.clone())).unwrap();
+            black_box(pong_rx.recv_timeout(Duration::from_secs(1)).unwrap())
+        })
+    });
+
+    ping.publish(Event::new("bench.stop", "bench-source", vec![]).unwrap())
+        .unwrap();
+    echo.join().unwrap();
+}
+
+#[cfg(not(unix))]
+fn bench_shm_ping_pong(_c: &mut Criterion) {}
+
 criterion_group!(
     benches,
     bench_event_creation,
@@ -212,6 +251,7 @@ criterion_group!(
     bench_topic_validation,
     bench_config_creation,
     bench_event_id_generation,
+    bench_shm_ping_pong,
 );
 
 criterion_main!(benches);
@@ -11,6 +11,11 @@ use criterion::{black_box, criterion_group, criterion_main, Criterion, Benchmark
 use maidos_llm::{CompletionRequest, Message, Role};
 use maidos_llm::streaming::{SseParser, StreamChunk, StreamUsage};
 use maidos_llm::tool::{MaidosTool, ToolParameter, ToProviderFormat};
+use maidos_llm::providers::{OpenAiProvider, VllmProvider};
+use maidos_llm::{CachedProvider, DispatchConfig, Dispatcher, LlmProvider, ResponseCache, ResponseCacheConfig};
+use std::sync::Arc;
+use std::time::Duration;
+use tokio::io::{AsyncReadExt, AsyncWriteExt};
 
 /// 基準測試：Message 創建
 fn bench_message_creation(c: &mut Criterion) {
@@ -382,6 +387,155 @@ fn bench_tool_building(c: &mut Criterion) {
     group.finish();
 }
 
+/// 本機替身伺服器：OpenAI 相容 /chat/completions 與 /completions（提示清單），每個請求延遲 `delay` 後回應
+async fn spawn_stand_in_server(delay: Duration) -> String {
+    let listener = tokio::net::TcpListener::bind("127.0.0.1:0").await.unwrap();
+    let addr = listener.local_addr().unwrap();
+    tokio::spawn(async move {
+        while let Ok((mut sock, _)) = listener.accept().await {
+            tokio::spawn(async move {
+                let mut buf = Vec::new();
+                let mut tmp = [0u8; 4096];
+                let (path, request) = loop {
+                    let n = sock.read(&mut tmp).await.unwrap_or(0);
+                    if n == 0 {
+                        return;
+                    }
+                    buf.extend_from_slice(&tmp[..n]);
+                    if let Some(end) = buf.windows(4).position(|w| w == b"\r\n\r\n") {
+                        let headers = String::from_utf8_lossy(&buf[..end]).to_lowercase();
+                        let len = headers
+                            .lines()
+                            .find_map(|l| l.strip_prefix("content-length:"))
+                            .and_then(|v| v.trim().parse::<usize>().ok())
+                            .unwrap_or(0);
+                        if buf.len() >= end + 4 + len {
+                            let path = headers.split_whitespace().nth(1).unwrap_or("").to_string();
+                            break (path, buf[end + 4..end + 4 + len].to_vec());
+                        }
+                    }
+                };
+                tokio::time::sleep(delay).await;
+                let body = if path.ends_with("/chat/completions") {
+                    r#"{"id":"x","model":"stand-in","choices":[{"index":0,"message":{"role":"assistant","content":"ok"},"finish_reason":"stop"}],"usage":{"prompt_tokens":3,"completion_tokens":1,"total_tokens":4}}"#.to_string()
+                } else {
+                    // 提示清單：每個提示一個 choice
+                    let request: serde_json::Value = serde_json::from_slice(&request).unwrap_or_default();
+                    let prompts = request["prompt"].as_array().map(|p| p.len()).unwrap_or(1);
+                    let choices: Vec<String> = (0..prompts)
+                        .map(|i| format!(r#"{{"index":{},"text":"ok","finish_reason":"stop"}}"#, i))
+                        .collect();
+                    format!(r#"{{"id":"x","model":"stand-in","choices":[{}]}}"#, choices.join(","))
+                };
+                let response = format!(
+                    "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                    body.len(),
+                    body
+                );
+                let _ = sock.write_all(response.as_bytes()).await;
+            });
+        }
+    });
+    format!("http://{}", addr)
+}
+
+/// 基準測試：非同步派送吞吐量（替身伺服器每請求 5ms）
+fn bench_dispatch_throughput(c: &mut Criterion) {
+    const REQUESTS: usize = 32;
+    let rt = tokio::runtime::Runtime::new().unwrap();
+    let base_url = rt.block_on(spawn_stand_in_server(Duration::from_millis(5)));
+    let provider: Arc<dyn LlmProvider> = Arc::new(OpenAiProvider::new("bench-key", Some(base_url.clone())));
+
+    let mut group = c.benchmark_group("llm_dispatch");
+    group.sample_size(10);
+    group.throughput(Throughput::Elements(REQUESTS as u64));
+
+    // 基線：每個請求阻塞一個呼叫端執行緒
+    group.bench_function("blocking_sequential", |b| {
+        b.iter(|| {
+            for i in 0..REQUESTS {
+                let request = CompletionRequest::quick("stand-in", format!("prompt {}", i));
+                rt.block_on(provider.complete(request)).unwrap();
+            }
+        })
+    });
+
+    for concurrency in [4usize, 16] {
+        let config = DispatchConfig {
+            max_concurrency: concurrency,
+            ..Default::default()
+        };
+        let dispatcher = Dispatcher::new(provider.clone(), config, rt.handle().clone());
+        group.bench_with_input(BenchmarkId::new("dispatcher", concurrency), &concurrency, |b, _| {
+            b.iter(|| {
+                for i in 0..REQUESTS {
+                    dispatcher.submit(CompletionRequest::quick("stand-in", format!("prompt {}", i)));
+                }
+                for _ in 0..REQUESTS {
+                    dispatcher.poll(Duration::from_secs(5)).unwrap();
+                }
+            })
+        });
+    }
+
+    // 重複提示（4 種）由合併請求吸收
+    let dispatcher = Dispatcher::new(provider.clone(), DispatchConfig::default(), rt.handle().clone());
+    group.bench_function("dispatcher_coalesced", |b| {
+        b.iter(|| {
+            for i in 0..REQUESTS {
+                dispatcher.submit(CompletionRequest::quick("stand-in", format!("prompt {}", i % 4)));
+            }
+            for _ in 0..REQUESTS {
+                dispatcher.poll(Duration::from_secs(5)).unwrap();
+            }
+        })
+    });
+
+    // vLLM 微批次：每批 8 個提示合成一次 /completions 呼叫
+    let vllm: Arc<dyn LlmProvider> = Arc::new(VllmProvider::new(Some(base_url.clone())));
+    let dispatcher = Dispatcher::new(vllm, DispatchConfig::default(), rt.handle().clone());
+    group.bench_function("dispatcher_batched_vllm", |b| {
+        b.iter(|| {
+            for i in 0..REQUESTS {
+                dispatcher.submit(CompletionRequest::quick("stand-in", format!("prompt {}", i)));
+            }
+            for _ in 0..REQUESTS {
+                dispatcher.poll(Duration::from_secs(5)).unwrap();
+            }
+        })
+    });
+
+    group.finish();
+}
+
+/// 基準測試：回應快取命中 vs 替身伺服器（每請求 5ms）
+fn bench_response_cache(c: &mut Criterion) {
+    let rt = tokio::runtime::Runtime::new().unwrap();
+    let base_url = rt.block_on(spawn_stand_in_server(Duration::from_millis(5)));
+    let inner: Arc<dyn LlmProvider> = Arc::new(OpenAiProvider::new("bench-key", Some(base_url)));
+    let cache = Arc::new(ResponseCache::new(ResponseCacheConfig::default()).unwrap());
+    let cached = CachedProvider::new(inner.clone(), cache.clone());
+    let request = CompletionRequest::quick("stand-in", "rerank: 你好").temperature(0.0);
+    rt.block_on(cached.complete(request.clone())).unwrap();
+
+    let mut group = c.benchmark_group("llm_cache");
+    group.sample_size(10);
+
+    group.bench_function("uncached", |b| {
+        b.iter(|| rt.block_on(inner.complete(black_box(request.clone()))).unwrap())
+    });
+
+    group.bench_function("hit", |b| {
+        b.iter(|| rt.block_on(cached.complete(black_box(request.clone()))).unwrap())
+    });
+
+    group.bench_function("key", |b| {
+        b.iter(|| cache.key("OpenAI", black_box(&request)))
+    });
+
+    group.finish();
+}
+
 criterion_group!(
     benches,
     bench_message_creation,
@@ -396,6 +550,8 @@ criterion_group!(
     bench_stream_chunk,
     bench_tool_format,
     bench_tool_building,
+    bench_dispatch_throughput,
+    bench_response_cache,
 );
 
 criterion_main!(benches);
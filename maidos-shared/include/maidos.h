@@ -168,6 +168,10 @@ const char* maidos_auth_issue(MaidosTokenIssuer* issuer, uint32_t capabilities);
 /**
  * Verify a token and get its capabilities.
  * 
+ * Successful verifications are cached per issuer (bounded, and never past
+ * the token's own expiry), so repeated checks of the same token skip the
+ * HMAC. Revoked tokens are rejected before the cache is consulted.
+ * 
  * @param issuer Token issuer handle
  * @param token Token string to verify
  * @param out_caps Output: granted capabilities bitmask
@@ -193,6 +197,46 @@ bool maidos_auth_has_capability(
     MaidosCapability capability
 );
 
+/**
+ * Verify several tokens in one call.
+ * 
+ * @param issuer Token issuer handle
+ * @param tokens Array of token strings (entries may be NULL)
+ * @param count Number of tokens
+ * @param out_caps Output: capabilities per token (0 if invalid), count elements
+ * @param out_results Output: MaidosResult per token, count elements (may be NULL)
+ * @return Number of valid tokens
+ */
+size_t maidos_auth_verify_batch(
+    MaidosTokenIssuer* issuer,
+    const char* const* tokens,
+    size_t count,
+    uint32_t* out_caps,
+    MaidosResult* out_results
+);
+
+/**
+ * Revoke a token until it expires.
+ * 
+ * @param issuer Token issuer handle
+ * @param token Token string issued by this issuer
+ * @return MAIDOS_OK on success, MAIDOS_ERR_AUTH if the token is invalid
+ */
+MaidosResult maidos_auth_revoke(MaidosTokenIssuer* issuer, const char* token);
+
+/**
+ * Get verified-token cache counters.
+ * 
+ * @param issuer Token issuer handle
+ * @param out_hits Output: verifications served from the cache (may be NULL)
+ * @param out_misses Output: verifications that ran the HMAC (may be NULL)
+ */
+void maidos_auth_cache_stats(
+    MaidosTokenIssuer* issuer,
+    uint64_t* out_hits,
+    uint64_t* out_misses
+);
+
 /**
  * Parse capability from name string.
  * 
@@ -231,8 +275,12 @@ typedef struct {
 /**
  * Create a publisher bound to an address.
  * 
- * @param address ZeroMQ address (e.g., "tcp://127.0.0.1:5555")
+ * @param address ZeroMQ address (e.g., "tcp://127.0.0.1:5555"), or
+ *                "shm://<name>" for a same-host shared-memory ring
  * @return Publisher handle, or NULL on error
+ * 
+ * @note A shm ring has exactly one publisher; subscribers that fall more
+ *       than one ring behind skip forward to the newest event.
  */
 MaidosBusPublisher* maidos_bus_publisher_create(const char* address);
 
@@ -290,7 +338,8 @@ void maidos_bus_publisher_free(MaidosBusPublisher* publisher);
 /**
  * Create a subscriber connected to an address.
  * 
- * @param address ZeroMQ address to connect to
+ * @param address ZeroMQ address to connect to, or "shm://<name>" to attach
+ *                to a ring created by a publisher on the same host
  * @return Subscriber handle, or NULL on error
  */
 MaidosBusSubscriber* maidos_bus_subscriber_create(const char* address);
@@ -459,6 +508,236 @@ MaidosResult maidos_llm_complete_json(
     MaidosLlmResponse* out_response
 );
 
+/* ----------------------------------------------------------------------------
+ * Streaming
+ * ---------------------------------------------------------------------------- */
+
+/** Completion result returned by the streaming API (free with maidos_llm_result_free) */
+typedef struct MaidosLlmResult MaidosLlmResult;
+
+/**
+ * Streaming chunk callback.
+ * 
+ * @param delta Text delta (UTF-8, valid only during the call)
+ * @param is_final true on the last call
+ * @param user_data Caller context passed to maidos_llm_complete_stream
+ * @return false to cancel the stream
+ */
+typedef bool (*MaidosLlmStreamCallback)(const char* delta, bool is_final, void* user_data);
+
+/**
+ * Streaming completion with a per-chunk callback.
+ * 
+ * Blocks until the stream ends or the callback returns false (the
+ * connection is closed immediately; the result reports "Cancelled").
+ * 
+ * @return Result with the full text, must be freed with maidos_llm_result_free()
+ */
+MaidosLlmResult* maidos_llm_complete_stream(
+    MaidosLlmProvider* provider,
+    const char* model,
+    const char* system,
+    const char* user_message,
+    uint32_t max_tokens,
+    float temperature,
+    MaidosLlmStreamCallback callback,
+    void* user_data
+);
+
+/** Opaque pollable stream handle */
+typedef struct MaidosLlmStream MaidosLlmStream;
+
+/** Stream poll status */
+typedef enum {
+    MAIDOS_LLM_STREAM_CHUNK = 0,
+    MAIDOS_LLM_STREAM_PENDING = 1,
+    MAIDOS_LLM_STREAM_DONE = 2,
+    MAIDOS_LLM_STREAM_CANCELLED = 3,
+    MAIDOS_LLM_STREAM_ERROR = 4
+} MaidosLlmStreamStatus;
+
+/**
+ * Start a streaming completion in the background.
+ * 
+ * @return Stream handle, or NULL on invalid arguments
+ * @note Free the stream before freeing the provider
+ */
+MaidosLlmStream* maidos_llm_stream_start(
+    MaidosLlmProvider* provider,
+    const char* model,
+    const char* system,
+    const char* user_message,
+    uint32_t max_tokens,
+    float temperature
+);
+
+/**
+ * Wait up to timeout_ms for the next chunk.
+ * 
+ * @param out_delta Output: delta on MAIDOS_LLM_STREAM_CHUNK (free with maidos_llm_string_free())
+ * @return Poll status; DONE/CANCELLED/ERROR are sticky
+ */
+MaidosLlmStreamStatus maidos_llm_stream_next(
+    MaidosLlmStream* stream,
+    uint32_t timeout_ms,
+    char** out_delta
+);
+
+/** Cancel a running stream (closes the connection). */
+void maidos_llm_stream_cancel(MaidosLlmStream* stream);
+
+/**
+ * Get the accumulated result of a finished stream.
+ * 
+ * @return Result, must be freed with maidos_llm_result_free()
+ */
+MaidosLlmResult* maidos_llm_stream_result(const MaidosLlmStream* stream);
+
+/** Free a stream handle (cancels it if still running). */
+void maidos_llm_stream_free(MaidosLlmStream* stream);
+
+/** Free a result returned by the streaming API. */
+void maidos_llm_result_free(MaidosLlmResult* result);
+
+/* ----------------------------------------------------------------------------
+ * Async dispatch
+ * ---------------------------------------------------------------------------- */
+
+/** Opaque dispatcher handle */
+typedef struct MaidosLlmDispatcher MaidosLlmDispatcher;
+
+/** Dispatcher statistics */
+typedef struct {
+    uint64_t submitted;
+    uint64_t coalesced;   /**< answered by an identical in-flight request */
+    uint64_t batches;     /**< batched calls (2+ requests) sent to vLLM / LM Studio */
+    uint64_t completed;
+    uint64_t in_flight;
+} MaidosLlmDispatchStats;
+
+/**
+ * Completion callback (runs on a worker thread).
+ * 
+ * @param id Request ID from maidos_llm_submit
+ * @param result Result, valid only during the call (do not free)
+ * @param user_data Caller context
+ */
+typedef void (*MaidosLlmCompletionCallback)(uint64_t id, const MaidosLlmResult* result, void* user_data);
+
+/**
+ * Create a non-blocking dispatcher for a provider.
+ * 
+ * Provider calls are capped at max_concurrency; identical in-flight requests
+ * share one call; for vLLM and LM Studio, requests with the same model and
+ * sampling parameters arriving within batch_window_ms are sent as one
+ * /completions call with a prompt list, which takes one slot.
+ * 
+ * @param max_concurrency Calls in flight (0 = 4)
+ * @param batch_window_ms Batch window (0 = 2 ms)
+ * @param max_batch Requests per batch (0 = 8, 1 disables batching)
+ * @return Dispatcher handle, free it before freeing the provider
+ */
+MaidosLlmDispatcher* maidos_llm_dispatcher_create(
+    MaidosLlmProvider* provider,
+    uint32_t max_concurrency,
+    uint32_t batch_window_ms,
+    uint32_t max_batch
+);
+
+/**
+ * Deliver completions to callback instead of the poll queue (NULL to poll).
+ * 
+ * Returns once no other thread is running the previous callback; the
+ * callback itself may call this to replace or clear itself.
+ */
+void maidos_llm_dispatcher_set_callback(
+    MaidosLlmDispatcher* dispatcher,
+    MaidosLlmCompletionCallback callback,
+    void* user_data
+);
+
+/**
+ * Submit a request without blocking.
+ * 
+ * @return Request ID, or 0 on invalid arguments
+ */
+uint64_t maidos_llm_submit(
+    MaidosLlmDispatcher* dispatcher,
+    const char* model,
+    const char* system,
+    const char* user_message,
+    uint32_t max_tokens,
+    float temperature
+);
+
+/**
+ * Wait up to timeout_ms for the next completion.
+ * 
+ * @param out_id Output: request ID of the returned result
+ * @return Result (free with maidos_llm_result_free()), or NULL on timeout
+ */
+MaidosLlmResult* maidos_llm_poll(
+    MaidosLlmDispatcher* dispatcher,
+    uint32_t timeout_ms,
+    uint64_t* out_id
+);
+
+/** Get dispatcher statistics. */
+bool maidos_llm_dispatcher_stats(
+    const MaidosLlmDispatcher* dispatcher,
+    MaidosLlmDispatchStats* out_stats
+);
+
+/** Free a dispatcher; in-flight requests finish without invoking the callback. */
+void maidos_llm_dispatcher_free(MaidosLlmDispatcher* dispatcher);
+
+/* ----------------------------------------------------------------------------
+ * Response cache
+ * ---------------------------------------------------------------------------- */
+
+/** Response cache statistics */
+typedef struct {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t disk_hits;   /**< hits loaded from the on-disk tier */
+    uint64_t evictions;   /**< dropped by the size caps or TTL */
+    uint64_t entries;
+    uint64_t bytes;
+} MaidosLlmCacheStats;
+
+/**
+ * Enable the content-addressed response cache.
+ * 
+ * Requests with temperature 0 are keyed by a hash of (provider, request) and
+ * answered from the cache on repeat; hits report zero tokens, so they do not
+ * count against budgets. Applies to dispatchers created afterwards.
+ * 
+ * Not thread-safe: call it right after creating the handle, before the
+ * handle is shared with other threads or used concurrently.
+ * 
+ * @param dir Directory for the on-disk tier (NULL = memory only)
+ * @param max_entries Entry cap (0 = 1024)
+ * @param max_bytes Size cap (0 = 16 MiB)
+ * @param ttl_secs Entry lifetime (0 = 24 h)
+ * @return false on error or if the cache is already enabled
+ */
+bool maidos_llm_cache_enable(
+    MaidosLlmProvider* provider,
+    const char* dir,
+    uint32_t max_entries,
+    uint64_t max_bytes,
+    uint64_t ttl_secs
+);
+
+/** Get response cache statistics (false if the cache is not enabled). */
+bool maidos_llm_cache_stats(
+    const MaidosLlmProvider* provider,
+    MaidosLlmCacheStats* out_stats
+);
+
+/** Drop every cached response, in memory and on disk. */
+void maidos_llm_cache_clear(MaidosLlmProvider* provider);
+
 /**
  * Free completion response.
  * 
@@ -0,0 +1,262 @@
+//! Verified token cache
+//!
+//! <impl>
+//! WHAT: Bounded, TTL-aware cache of tokens that already passed verification
+//! WHY: Services gating every bus message / LLM call should not repeat HMAC
+//! HOW: RwLock<HashMap> keyed by the SHA-256 of the token string, entry
+//!      lifetime capped by both cache TTL and token expiry, revocation list
+//!      checked first. Only digests and decoded payloads are retained, never
+//!      the bearer token itself.
+//! TEST: Hit/miss accounting, expiry, capacity bound, revocation
+//! </impl>
+
+use std::collections::HashMap;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant, SystemTime, UNIX_EPOCH};
+
+use parking_lot::RwLock;
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+
+use crate::token::{CapabilityToken, TokenPayload};
+
+/// SHA-256 of a token string
+type TokenKey = [u8; 32];
+
+fn token_key(token_str: &str) -> TokenKey {
+    Sha256::digest(token_str.as_bytes()).into()
+}
+
+/// Verified token cache configuration
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct VerifyCacheConfig {
+    /// Maximum cached tokens
+    pub max_entries: usize,
+    /// Maximum time a verification result is reused, in seconds
+    pub ttl_secs: u64,
+}
+
+impl Default for VerifyCacheConfig {
+    fn default() -> Self {
+        Self {
+            max_entries: 4096,
+            ttl_secs: 60,
+        }
+    }
+}
+
+/// Verified token cache statistics
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct VerifyCacheStats {
+    /// Lookups served from the cache
+    pub hits: u64,
+    /// Lookups that required full verification
+    pub misses: u64,
+    /// Entries dropped to stay within `max_entries`
+    pub evictions: u64,
+    /// Entries currently cached
+    pub entries: usize,
+}
+
+struct CacheEntry {
+    payload: TokenPayload,
+    valid_until: Instant,
+}
+
+/// Cache of tokens that passed signature and expiry checks
+pub(crate) struct VerifiedTokenCache {
+    config: VerifyCacheConfig,
+    entries: RwLock<HashMap<TokenKey, CacheEntry>>,
+    /// Revoked token digest -> expiry (Unix seconds); pruned once the token expires
+    revoked: RwLock<HashMap<TokenKey, u64>>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl VerifiedTokenCache {
+    pub(crate) fn new(config: VerifyCacheConfig) -> Self {
+        Self {
+            config,
+            entries: RwLock::new(HashMap::new()),
+            revoked: RwLock::new(HashMap::new()),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        }
+    }
+
+    /// Look up a previously verified token
+    pub(crate) fn get(&self, token_str: &str) -> Option<CapabilityToken> {
+        let entries = self.entries.read();
+        match entries.get(&token_key(token_str)) {
+            Some(entry) if entry.valid_until > Instant::now() => {
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                Some(CapabilityToken::from_verified(entry.payload.clone(), token_str))
+            }
+            _ => {
+                self.misses.fetch_add(1, Ordering::Relaxed);
+                None
+            }
+        }
+    }
+
+    /// Remember a token that just passed full verification
+    pub(crate) fn insert(&self, token: &CapabilityToken) {
+        if self.config.max_entries == 0 {
+            return;
+        }
+        let lifetime = token
+            .remaining_ttl()
+            .min(Duration::from_secs(self.config.ttl_secs));
+        if lifetime.is_zero() {
+            return;
+        }
+
+        let key = token_key(token.as_str());
+        let now = Instant::now();
+        let mut entries = self.entries.write();
+        if entries.len() >= self.config.max_entries && !entries.contains_key(&key) {
+            let before = entries.len();
+            entries.retain(|_, e| e.valid_until > now);
+            if entries.len() >= self.config.max_entries {
+                let oldest = entries
+                    .iter()
+                    .min_by_key(|(_, e)| e.valid_until)
+                    .map(|(k, _)| *k);
+                if let Some(key) = oldest {
+                    entries.remove(&key);
+                }
+            }
+            self.evictions
+                .fetch_add((before - entries.len()) as u64, Ordering::Relaxed);
+        }
+        entries.insert(
+            key,
+            CacheEntry {
+                payload: token.payload().clone(),
+                valid_until: now + lifetime,
+            },
+        );
+    }
+
+    /// Revoke a token until it expires
+    pub(crate) fn revoke(&self, token_str: &str, expires_at: u64) {
+        let key = token_key(token_str);
+        self.entries.write().remove(&key);
+
+        let now = current_timestamp();
+        let mut revoked = self.revoked.write();
+        revoked.retain(|_, exp| *exp > now);
+        revoked.insert(key, expires_at);
+    }
+
+    /// Check the revocation list
+    pub(crate) fn is_revoked(&self, token_str: &str) -> bool {
+        let revoked = self.revoked.read();
+        !revoked.is_empty() && revoked.contains_key(&token_key(token_str))
+    }
+
+    /// Drop all cached verifications (revocations are kept)
+    pub(crate) fn clear(&self) {
+        self.entries.write().clear();
+    }
+
+    pub(crate) fn stats(&self) -> VerifyCacheStats {
+        VerifyCacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            entries: self.entries.read().len(),
+        }
+    }
+}
+
+fn current_timestamp() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_secs())
+        .unwrap_or(0)
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::capability::{Capability, CapabilitySet};
+
+    const TEST_SECRET: &[u8] = b"test-secret-key-32-bytes-long!!";
+
+    fn make_token(ttl_secs: u64) -> CapabilityToken {
+        let mut caps = CapabilitySet::empty();
+        caps.grant(Capability::LlmChat);
+        CapabilityToken::new(caps, Duration::from_secs(ttl_secs), TEST_SECRET).unwrap()
+    }
+
+    #[test]
+    fn test_cache_hit_and_miss() {
+        let cache = VerifiedTokenCache::new(VerifyCacheConfig::default());
+        let token = make_token(3600);
+
+        assert!(cache.get(token.as_str()).is_none());
+        cache.insert(&token);
+        let cached = cache.get(token.as_str()).unwrap();
+        assert!(cached.has(Capability::LlmChat));
+
+        let stats = cache.stats();
+        assert_eq!(stats.hits, 1);
+        assert_eq!(stats.misses, 1);
+        assert_eq!(stats.entries, 1);
+    }
+
+    #[test]
+    fn test_cache_respects_ttl() {
+        let cache = VerifiedTokenCache::new(VerifyCacheConfig {
+            max_entries: 16,
+            ttl_secs: 0,
+        });
+        let token = make_token(3600);
+        cache.insert(&token);
+        assert!(cache.get(token.as_str()).is_none());
+    }
+
+    #[test]
+    fn test_cache_is_bounded() {
+        let cache = VerifiedTokenCache::new(VerifyCacheConfig {
+            max_entries: 4,
+            ttl_secs: 60,
+        });
+        for ttl in 100..110 {
+            cache.insert(&make_token(ttl));
+        }
+        let stats = cache.stats();
+        assert_eq!(stats.entries, 4);
+        assert_eq!(stats.evictions, 6);
+    }
+
+    #[test]
+    fn test_cache_revocation() {
+        let cache = VerifiedTokenCache::new(VerifyCacheConfig::default());
+        let token = make_token(3600);
+        cache.insert(&token);
+
+        cache.revoke(token.as_str(), u64::MAX);
+        assert!(cache.is_revoked(token.as_str()));
+        assert!(cache.get(token.as_str()).is_none());
+
+        cache.clear();
+        assert!(cache.is_revoked(token.as_str()));
+    }
+
+    #[test]
+    fn test_cache_keys_are_digests() {
+        let cache = VerifiedTokenCache::new(VerifyCacheConfig::default());
+        let token = make_token(3600);
+        cache.insert(&token);
+
+        let key = token_key(token.as_str());
+        assert!(cache.entries.read().contains_key(&key));
+        let cached = cache.get(token.as_str()).unwrap();
+        assert_eq!(cached.as_str(), token.as_str());
+        assert_eq!(cached.expires_at(), token.expires_at());
+    }
+}
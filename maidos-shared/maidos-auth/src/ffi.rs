@@ -12,6 +12,7 @@
 use crate::capability::{Capability, CapabilitySet};
 use crate::error::AuthError;
 use crate::token::CapabilityToken;
+use crate::TokenIssuer;
 use std::ffi::{c_char, CStr, CString};
 use std::ptr;
 use std::sync::Mutex;
@@ -207,6 +208,213 @@ pub unsafe extern "C" fn maidos_auth_free_string(s: *mut c_char) {
     }
 }
 
+// ============================================================================
+// Token issuer (MaidosTokenIssuer in maidos.h)
+// ============================================================================
+
+/// `MaidosResult` codes shared with the other maidos.h modules
+const MAIDOS_OK: i32 = 0;
+const MAIDOS_ERR_NULL_POINTER: i32 = 1;
+const MAIDOS_ERR_INVALID_UTF8: i32 = 2;
+const MAIDOS_ERR_AUTH: i32 = 6;
+
+/// Create a token issuer with a verified-token cache
+///
+/// # Safety
+/// - `secret` must be a valid pointer to `secret_len` bytes
+/// - Caller must free the handle with `maidos_auth_issuer_free`
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_issuer_create(
+    secret: *const u8,
+    secret_len: usize,
+    ttl_secs: u64,
+) -> *mut TokenIssuer {
+    if secret.is_null() || secret_len == 0 {
+        set_last_error("Secret is null".to_string());
+        return ptr::null_mut();
+    }
+
+    let secret_vec = std::slice::from_raw_parts(secret, secret_len).to_vec();
+    Box::into_raw(Box::new(TokenIssuer::new(
+        secret_vec,
+        Duration::from_secs(ttl_secs),
+    )))
+}
+
+/// Issue a token from an issuer
+///
+/// # Safety
+/// - `issuer` must be a valid handle
+/// - Caller must free returned string with `maidos_auth_free_string`
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_issue(issuer: *mut TokenIssuer, capabilities: u32) -> *mut c_char {
+    if issuer.is_null() {
+        set_last_error("Issuer is null".to_string());
+        return ptr::null_mut();
+    }
+
+    match (*issuer).issue(CapabilitySet::from_u32(capabilities)) {
+        Ok(token) => CString::new(token.as_str())
+            .map(|cs| cs.into_raw())
+            .unwrap_or(ptr::null_mut()),
+        Err(e) => {
+            set_last_error(e.to_string());
+            ptr::null_mut()
+        }
+    }
+}
+
+/// Verify one token through the issuer cache
+unsafe fn issuer_verify_one(issuer: &TokenIssuer, token: *const c_char, out_caps: &mut u32) -> i32 {
+    *out_caps = 0;
+    if token.is_null() {
+        return MAIDOS_ERR_NULL_POINTER;
+    }
+    let token_str = match CStr::from_ptr(token).to_str() {
+        Ok(s) => s,
+        Err(_) => return MAIDOS_ERR_INVALID_UTF8,
+    };
+    match issuer.verify(token_str) {
+        Ok(verified) => {
+            *out_caps = verified.capabilities().as_u32();
+            MAIDOS_OK
+        }
+        Err(e) => {
+            set_last_error(e.to_string());
+            MAIDOS_ERR_AUTH
+        }
+    }
+}
+
+/// Verify a token and get its capabilities bitmask
+///
+/// # Safety
+/// - `issuer` must be a valid handle, `token` a null-terminated string
+/// - `out_caps` must be a valid pointer
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_verify(
+    issuer: *mut TokenIssuer,
+    token: *const c_char,
+    out_caps: *mut u32,
+) -> i32 {
+    if issuer.is_null() || out_caps.is_null() {
+        return MAIDOS_ERR_NULL_POINTER;
+    }
+    issuer_verify_one(&*issuer, token, &mut *out_caps)
+}
+
+/// Check if a token has all bits of `capability`
+///
+/// # Safety
+/// - `issuer` must be a valid handle, `token` a null-terminated string
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_has_capability(
+    issuer: *mut TokenIssuer,
+    token: *const c_char,
+    capability: u32,
+) -> bool {
+    if issuer.is_null() {
+        return false;
+    }
+    let mut caps = 0u32;
+    issuer_verify_one(&*issuer, token, &mut caps) == MAIDOS_OK
+        && capability != 0
+        && (caps & capability) == capability
+}
+
+/// Verify `count` tokens in one call
+///
+/// `out_caps[i]` receives the capabilities of `tokens[i]` (0 if invalid) and,
+/// when `out_results` is non-null, `out_results[i]` its `MaidosResult` code.
+///
+/// # Safety
+/// - `tokens` must point to `count` string pointers (entries may be null)
+/// - `out_caps` (and `out_results` if non-null) must hold `count` elements
+/// - Returns the number of valid tokens
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_verify_batch(
+    issuer: *mut TokenIssuer,
+    tokens: *const *const c_char,
+    count: usize,
+    out_caps: *mut u32,
+    out_results: *mut i32,
+) -> usize {
+    if issuer.is_null() || tokens.is_null() || out_caps.is_null() || count == 0 {
+        return 0;
+    }
+
+    let issuer = &*issuer;
+    let tokens = std::slice::from_raw_parts(tokens, count);
+    let caps = std::slice::from_raw_parts_mut(out_caps, count);
+    let mut valid = 0;
+
+    for (i, token) in tokens.iter().enumerate() {
+        let code = issuer_verify_one(issuer, *token, &mut caps[i]);
+        if code == MAIDOS_OK {
+            valid += 1;
+        }
+        if !out_results.is_null() {
+            *out_results.add(i) = code;
+        }
+    }
+    valid
+}
+
+/// Revoke a token issued by this issuer
+///
+/// # Safety
+/// - `issuer` must be a valid handle, `token` a null-terminated string
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_revoke(issuer: *mut TokenIssuer, token: *const c_char) -> i32 {
+    if issuer.is_null() || token.is_null() {
+        return MAIDOS_ERR_NULL_POINTER;
+    }
+    let token_str = match CStr::from_ptr(token).to_str() {
+        Ok(s) => s,
+        Err(_) => return MAIDOS_ERR_INVALID_UTF8,
+    };
+    match (*issuer).revoke(token_str) {
+        Ok(()) => MAIDOS_OK,
+        Err(e) => {
+            set_last_error(e.to_string());
+            MAIDOS_ERR_AUTH
+        }
+    }
+}
+
+/// Get verified-token cache counters
+///
+/// # Safety
+/// - `issuer` must be a valid handle; output pointers may be null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_cache_stats(
+    issuer: *mut TokenIssuer,
+    out_hits: *mut u64,
+    out_misses: *mut u64,
+) {
+    if issuer.is_null() {
+        return;
+    }
+    let stats = (*issuer).cache_stats();
+    if !out_hits.is_null() {
+        *out_hits = stats.hits;
+    }
+    if !out_misses.is_null() {
+        *out_misses = stats.misses;
+    }
+}
+
+/// Free a token issuer
+///
+/// # Safety
+/// - `issuer` must be a handle from `maidos_auth_issuer_create` or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_auth_issuer_free(issuer: *mut TokenIssuer) {
+    if !issuer.is_null() {
+        drop(Box::from_raw(issuer));
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -368,4 +576,72 @@ mod tests {
             assert!(!has);
         }
     }
+
+    #[test]
+    fn test_ffi_issuer_verify_and_batch() {
+        let secret = b"test-secret-32-bytes-long!!!!!!";
+        let caps = (Capability::LlmChat as u32) | (Capability::EventPublish as u32);
+
+        unsafe {
+            let issuer = maidos_auth_issuer_create(secret.as_ptr(), secret.len(), 3600);
+            assert!(!issuer.is_null());
+
+            let token = maidos_auth_issue(issuer, caps);
+            assert!(!token.is_null());
+
+            let mut out = 0u32;
+            assert_eq!(maidos_auth_verify(issuer, token, &mut out), MAIDOS_OK);
+            assert_eq!(out, caps);
+            assert!(maidos_auth_has_capability(issuer, token, Capability::EventPublish as u32));
+            assert!(!maidos_auth_has_capability(issuer, token, Capability::ShellExec as u32));
+
+            let bad = CString::new("invalid.token").unwrap();
+            let batch = [token as *const c_char, bad.as_ptr(), ptr::null()];
+            let mut out_caps = [0u32; 3];
+            let mut out_results = [0i32; 3];
+            let valid = maidos_auth_verify_batch(
+                issuer,
+                batch.as_ptr(),
+                batch.len(),
+                out_caps.as_mut_ptr(),
+                out_results.as_mut_ptr(),
+            );
+            assert_eq!(valid, 1);
+            assert_eq!(out_caps, [caps, 0, 0]);
+            assert_eq!(out_results, [MAIDOS_OK, MAIDOS_ERR_AUTH, MAIDOS_ERR_NULL_POINTER]);
+
+            let mut hits = 0u64;
+            let mut misses = 0u64;
+            maidos_auth_cache_stats(issuer, &mut hits, &mut misses);
+            assert_eq!(misses, 2);
+            assert_eq!(hits, 3);
+
+            assert_eq!(maidos_auth_revoke(issuer, token), MAIDOS_OK);
+            assert_eq!(maidos_auth_verify(issuer, token, &mut out), MAIDOS_ERR_AUTH);
+            assert_eq!(out, 0);
+
+            maidos_auth_free_string(token);
+            maidos_auth_issuer_free(issuer);
+        }
+    }
+
+    #[test]
+    fn test_ffi_issuer_null_safety() {
+        unsafe {
+            assert!(maidos_auth_issuer_create(ptr::null(), 0, 60).is_null());
+            assert!(maidos_auth_issue(ptr::null_mut(), 0).is_null());
+            let mut out = 0u32;
+            assert_eq!(
+                maidos_auth_verify(ptr::null_mut(), ptr::null(), &mut out),
+                MAIDOS_ERR_NULL_POINTER
+            );
+            assert!(!maidos_auth_has_capability(ptr::null_mut(), ptr::null(), 1));
+            assert_eq!(
+                maidos_auth_verify_batch(ptr::null_mut(), ptr::null(), 0, ptr::null_mut(), ptr::null_mut()),
+                0
+            );
+            maidos_auth_cache_stats(ptr::null_mut(), ptr::null_mut(), ptr::null_mut());
+            maidos_auth_issuer_free(ptr::null_mut());
+        }
+    }
 }
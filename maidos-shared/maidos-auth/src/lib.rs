@@ -4,6 +4,7 @@
 //! - HMAC-SHA256 signed tokens
 //! - Time-based expiration
 //! - Bitmask-based capability checking
+//! - Bounded cache of verified tokens with revocation
 //!
 //! # Example
 //!
@@ -26,6 +27,7 @@
 //! assert!(!verified.has(Capability::ShellExec));
 //! ```
 
+mod cache;
 mod capability;
 mod error;
 mod ffi;
@@ -33,6 +35,7 @@ mod policy;
 mod store;
 mod token;
 
+pub use cache::{VerifyCacheConfig, VerifyCacheStats};
 pub use capability::{Capability, CapabilitySet};
 pub use error::{AuthError, Result};
 pub use policy::{
@@ -41,14 +44,21 @@ pub use policy::{
 pub use store::{StoreConfig, StoreStats, StoredToken, TokenStore};
 pub use token::{CapabilityToken, TokenPayload};
 
+use cache::VerifiedTokenCache;
 use maidos_config::MaidosConfig;
 use std::time::Duration;
 use tracing::{error, info, warn};
 
 /// Token issuer that integrates with MaidosConfig
+///
+/// Successful verifications are cached (bounded by count and by both the
+/// cache TTL and the token's own expiry), so repeated checks of the same
+/// token skip the HMAC. Revoked tokens are rejected before the cache is
+/// consulted.
 pub struct TokenIssuer {
     secret: Vec<u8>,
     default_ttl: Duration,
+    cache: VerifiedTokenCache,
 }
 
 impl TokenIssuer {
@@ -66,12 +76,23 @@ impl TokenIssuer {
         Ok(Self {
             secret,
             default_ttl: Duration::from_secs(auth.token_ttl),
+            cache: VerifiedTokenCache::new(VerifyCacheConfig::default()),
         })
     }
 
     /// Create with explicit secret and TTL
     pub fn new(secret: Vec<u8>, default_ttl: Duration) -> Self {
-        Self { secret, default_ttl }
+        Self {
+            secret,
+            default_ttl,
+            cache: VerifiedTokenCache::new(VerifyCacheConfig::default()),
+        }
+    }
+
+    /// Replace the verified-token cache configuration (`max_entries: 0` disables it)
+    pub fn with_verify_cache(mut self, config: VerifyCacheConfig) -> Self {
+        self.cache = VerifiedTokenCache::new(config);
+        self
     }
 
     /// Issue a token with the given capabilities
@@ -99,10 +120,20 @@ impl TokenIssuer {
 
     /// Verify a token
     pub fn verify(&self, token_str: &str) -> Result<CapabilityToken> {
+        if self.cache.is_revoked(token_str) {
+            info!("[MAIDOS-AUDIT] Token verification failed: token revoked");
+            return Err(AuthError::InvalidToken("Token revoked".to_string()));
+        }
+        if let Some(token) = self.cache.get(token_str) {
+            info!("[MAIDOS-AUDIT] Token verified (cached) for subject: {:?}", token.subject());
+            return Ok(token);
+        }
+
         let result = CapabilityToken::verify(token_str, &self.secret);
         match result {
             Ok(ref token) => {
                 info!("[MAIDOS-AUDIT] Token verified successfully for subject: {:?}", token.subject());
+                self.cache.insert(token);
             }
             Err(ref e) => {
                 info!("[MAIDOS-AUDIT] Token verification failed: {}", e);
@@ -111,6 +142,32 @@ impl TokenIssuer {
         result
     }
 
+    /// Verify several tokens, returning each token's capabilities or error
+    pub fn verify_batch<S: AsRef<str>>(&self, tokens: &[S]) -> Vec<Result<CapabilitySet>> {
+        tokens
+            .iter()
+            .map(|t| self.verify(t.as_ref()).map(|token| token.capabilities()))
+            .collect()
+    }
+
+    /// Revoke a token; later verifications fail until it would have expired
+    pub fn revoke(&self, token_str: &str) -> Result<()> {
+        let token = CapabilityToken::verify(token_str, &self.secret)?;
+        self.cache.revoke(token_str, token.expires_at());
+        info!("[MAIDOS-AUDIT] Token revoked for subject: {:?}", token.subject());
+        Ok(())
+    }
+
+    /// Verified-token cache statistics
+    pub fn cache_stats(&self) -> VerifyCacheStats {
+        self.cache.stats()
+    }
+
+    /// Drop all cached verifications (e.g. after rotating policy)
+    pub fn clear_cache(&self) {
+        self.cache.clear();
+    }
+
     /// Check if a token has a specific capability
     pub fn check(&self, token_str: &str, cap: Capability) -> bool {
         match self.verify(token_str) {
@@ -238,4 +295,82 @@ mod tests {
         assert!(issuer.check_all(token.as_str(), &[Capability::LlmChat, Capability::FileRead]));
         assert!(!issuer.check_all(token.as_str(), &[Capability::LlmChat, Capability::ShellExec]));
     }
+
+    #[test]
+    fn test_issuer_verify_uses_cache() {
+        let issuer = TokenIssuer::new(
+            b"test-secret-key-32-bytes-long!!".to_vec(),
+            Duration::from_secs(3600),
+        );
+
+        let mut caps = CapabilitySet::empty();
+        caps.grant(Capability::LlmChat);
+        let token = issuer.issue(caps).unwrap();
+
+        for _ in 0..3 {
+            assert!(issuer.check(token.as_str(), Capability::LlmChat));
+        }
+        let stats = issuer.cache_stats();
+        assert_eq!(stats.misses, 1);
+        assert_eq!(stats.hits, 2);
+
+        // Tampered tokens never hit the cache
+        let tampered = format!("{}x", token.as_str());
+        assert!(issuer.verify(&tampered).is_err());
+    }
+
+    #[test]
+    fn test_issuer_revoke() {
+        let issuer = TokenIssuer::new(
+            b"test-secret-key-32-bytes-long!!".to_vec(),
+            Duration::from_secs(3600),
+        );
+
+        let token = issuer.issue(CapabilitySet::empty()).unwrap();
+        assert!(issuer.verify(token.as_str()).is_ok());
+
+        issuer.revoke(token.as_str()).unwrap();
+        assert!(matches!(
+            issuer.verify(token.as_str()),
+            Err(AuthError::InvalidToken(_))
+        ));
+        assert!(issuer.revoke("invalid.token").is_err());
+    }
+
+    #[test]
+    fn test_issuer_verify_batch() {
+        let issuer = TokenIssuer::new(
+            b"test-secret-key-32-bytes-long!!".to_vec(),
+            Duration::from_secs(3600),
+        );
+
+        let mut caps = CapabilitySet::empty();
+        caps.grant(Capability::FileRead);
+        let good = issuer.issue(caps).unwrap();
+
+        let results = issuer.verify_batch(&[good.as_str(), "invalid.token", good.as_str()]);
+        assert_eq!(results.len(), 3);
+        assert!(results[0].as_ref().unwrap().has(Capability::FileRead));
+        assert!(results[1].is_err());
+        assert!(results[2].is_ok());
+        assert_eq!(issuer.cache_stats().hits, 1);
+    }
+
+    #[test]
+    fn test_issuer_cache_disabled() {
+        let issuer = TokenIssuer::new(
+            b"test-secret-key-32-bytes-long!!".to_vec(),
+            Duration::from_secs(3600),
+        )
+        .with_verify_cache(VerifyCacheConfig {
+            max_entries: 0,
+            ttl_secs: 60,
+        });
+
+        let token = issuer.issue(CapabilitySet::empty()).unwrap();
+        assert!(issuer.verify(token.as_str()).is_ok());
+        assert!(issuer.verify(token.as_str()).is_ok());
+        assert_eq!(issuer.cache_stats().hits, 0);
+        assert_eq!(issuer.cache_stats().entries, 0);
+    }
 }
\ No newline at end of file
@@ -138,6 +138,11 @@ impl CapabilityToken {
         }
     }
 
+    /// Get expiration time (Unix timestamp)
+    pub fn expires_at(&self) -> u64 {
+        self.payload.exp
+    }
+
     /// Check if token is expired
     pub fn is_expired(&self) -> bool {
         let now = current_timestamp();
@@ -159,6 +164,19 @@ impl CapabilityToken {
         self.payload.sub.as_deref()
     }
 
+    /// Signed payload
+    pub(crate) fn payload(&self) -> &TokenPayload {
+        &self.payload
+    }
+
+    /// Rebuild a token whose string already passed `verify`
+    pub(crate) fn from_verified(payload: TokenPayload, token_str: &str) -> Self {
+        Self {
+            payload,
+            raw: token_str.to_string(),
+        }
+    }
+
     fn encode_token(payload: &TokenPayload, secret: &[u8]) -> Result<String> {
         let payload_json = serde_json::to_vec(payload)
             .map_err(|e| AuthError::SerializationError(e.to_string()))?;
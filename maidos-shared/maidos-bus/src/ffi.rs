@@ -3,28 +3,37 @@
 //! <impl>
 //! WHAT: C-compatible FFI for P/Invoke from C#/.NET
 //! WHY: Cross-language integration with MAIDOS applications
-//! HOW: Blocking wrappers around async API, opaque pointers for handles
+//! HOW: Blocking wrappers around async API, opaque pointers for handles;
+//!      `shm://name` addresses select the same-host shared-memory transport
 //! TEST: FFI handle creation, publish, receive
 //! </impl>
 
 use crate::event::Event;
 use crate::publisher::{Publisher, PublisherConfig};
+use crate::shm::{parse_shm_address, ShmPublisher, ShmSubscriber};
 use crate::subscriber::{Subscriber, SubscriberConfig};
 use std::ffi::{c_char, CStr, CString};
 use std::ptr;
 use std::sync::Arc;
+use std::time::Duration;
 use tokio::runtime::Runtime;
 
 /// Opaque publisher handle
-pub struct PublisherHandle {
-    publisher: Publisher,
-    runtime: Arc<Runtime>,
+pub enum PublisherHandle {
+    Tcp {
+        publisher: Publisher,
+        runtime: Arc<Runtime>,
+    },
+    Shm(ShmPublisher),
 }
 
 /// Opaque subscriber handle
-pub struct SubscriberHandle {
-    subscriber: Subscriber,
-    runtime: Arc<Runtime>,
+pub enum SubscriberHandle {
+    Tcp {
+        subscriber: Subscriber,
+        runtime: Arc<Runtime>,
+    },
+    Shm(ShmSubscriber),
 }
 
 /// Event data for FFI
@@ -44,6 +53,9 @@ pub struct FfiEvent {
 
 /// Create a new publisher
 ///
+/// `shm://name` creates a same-host shared-memory ring; any other address is
+/// bound as a TCP listener.
+///
 /// # Safety
 /// Returns null on failure
 #[no_mangle]
@@ -57,6 +69,13 @@ pub unsafe extern "C" fn maidos_bus_publisher_create(bind_addr: *const c_char) -
         }
     };
 
+    if let Some(name) = parse_shm_address(&addr) {
+        return match ShmPublisher::create(name) {
+            Ok(publisher) => Box::into_raw(Box::new(PublisherHandle::Shm(publisher))),
+            Err(_) => ptr::null_mut(),
+        };
+    }
+
     let runtime = match Runtime::new() {
         Ok(rt) => Arc::new(rt),
         Err(_) => return ptr::null_mut(),
@@ -73,13 +92,13 @@ pub unsafe extern "C" fn maidos_bus_publisher_create(bind_addr: *const c_char) -
         return ptr::null_mut();
     }
 
-    Box::into_raw(Box::new(PublisherHandle {
+    Box::into_raw(Box::new(PublisherHandle::Tcp {
         publisher,
         runtime,
     }))
 }
 
-/// Get publisher bound port
+/// Get publisher bound port (0 for shared-memory publishers)
 ///
 /// # Safety
 /// handle must be valid
@@ -89,11 +108,13 @@ pub unsafe extern "C" fn maidos_bus_publisher_port(handle: *mut PublisherHandle)
         return 0;
     }
 
-    let h = &*handle;
-    h.runtime
-        .block_on(h.publisher.bound_addr())
-        .map(|a| a.port())
-        .unwrap_or(0)
+    match &*handle {
+        PublisherHandle::Tcp { publisher, runtime } => runtime
+            .block_on(publisher.bound_addr())
+            .map(|a| a.port())
+            .unwrap_or(0),
+        PublisherHandle::Shm(_) => 0,
+    }
 }
 
 /// Publish an event
@@ -135,7 +156,11 @@ pub unsafe extern "C" fn maidos_bus_publish(
         Err(_) => return -4,
     };
 
-    match h.runtime.block_on(h.publisher.publish(event)) {
+    let result = match h {
+        PublisherHandle::Tcp { publisher, runtime } => runtime.block_on(publisher.publish(event)),
+        PublisherHandle::Shm(publisher) => publisher.publish(event),
+    };
+    match result {
         Ok(()) => 0,
         Err(_) => -5,
     }
@@ -148,8 +173,13 @@ pub unsafe extern "C" fn maidos_bus_publish(
 #[no_mangle]
 pub unsafe extern "C" fn maidos_bus_publisher_destroy(handle: *mut PublisherHandle) {
     if !handle.is_null() {
-        let mut h = Box::from_raw(handle);
-        let _ = h.runtime.block_on(h.publisher.stop());
+        if let PublisherHandle::Tcp {
+            mut publisher,
+            runtime,
+        } = *Box::from_raw(handle)
+        {
+            let _ = runtime.block_on(publisher.stop());
+        }
     }
 }
 
@@ -159,6 +189,9 @@ pub unsafe extern "C" fn maidos_bus_publisher_destroy(handle: *mut PublisherHand
 
 /// Create a new subscriber
 ///
+/// `shm://name` attaches to a shared-memory ring created by a publisher on
+/// the same host; any other address is connected over TCP.
+///
 /// # Safety
 /// publisher_addr must be valid
 #[no_mangle]
@@ -174,6 +207,13 @@ pub unsafe extern "C" fn maidos_bus_subscriber_create(
         Err(_) => return ptr::null_mut(),
     };
 
+    if let Some(name) = parse_shm_address(&addr) {
+        return match ShmSubscriber::open(name) {
+            Ok(subscriber) => Box::into_raw(Box::new(SubscriberHandle::Shm(subscriber))),
+            Err(_) => ptr::null_mut(),
+        };
+    }
+
     let runtime = match Runtime::new() {
         Ok(rt) => Arc::new(rt),
         Err(_) => return ptr::null_mut(),
@@ -191,7 +231,7 @@ pub unsafe extern "C" fn maidos_bus_subscriber_create(
         return ptr::null_mut();
     }
 
-    Box::into_raw(Box::new(SubscriberHandle {
+    Box::into_raw(Box::new(SubscriberHandle::Tcp {
         subscriber,
         runtime,
     }))
@@ -210,19 +250,28 @@ pub unsafe extern "C" fn maidos_bus_receive(
         return ptr::null_mut();
     }
 
-    let h = &mut *handle;
+    let received = match &mut *handle {
+        SubscriberHandle::Tcp {
+            subscriber,
+            runtime,
+        } => runtime
+            .block_on(async {
+                tokio::time::timeout(
+                    tokio::time::Duration::from_millis(timeout_ms),
+                    subscriber.recv(),
+                )
+                .await
+            })
+            .ok()
+            .flatten(),
+        SubscriberHandle::Shm(subscriber) => {
+            subscriber.recv_timeout(Duration::from_millis(timeout_ms))
+        }
+    };
 
-    let result = h.runtime.block_on(async {
-        tokio::time::timeout(
-            tokio::time::Duration::from_millis(timeout_ms),
-            h.subscriber.recv(),
-        )
-        .await
-    });
-
-    let event = match result {
-        Ok(Some(e)) => e,
-        _ => return ptr::null_mut(),
+    let event = match received {
+        Some(e) => e,
+        None => return ptr::null_mut(),
     };
 
     let topic = CString::new(event.topic.clone()).unwrap_or_default();
@@ -274,8 +323,13 @@ pub unsafe extern "C" fn maidos_bus_event_free(event: *mut FfiEvent) {
 #[no_mangle]
 pub unsafe extern "C" fn maidos_bus_subscriber_destroy(handle: *mut SubscriberHandle) {
     if !handle.is_null() {
-        let mut h = Box::from_raw(handle);
-        let _ = h.runtime.block_on(h.subscriber.stop());
+        if let SubscriberHandle::Tcp {
+            mut subscriber,
+            runtime,
+        } = *Box::from_raw(handle)
+        {
+            let _ = runtime.block_on(subscriber.stop());
+        }
     }
 }
 
@@ -484,6 +538,52 @@ mod tests {
         }
     }
 
+    #[cfg(unix)]
+    #[test]
+    fn test_ffi_shm_roundtrip() {
+        unsafe {
+            let addr = CString::new(format!("shm://ffi-test-{}", std::process::id())).unwrap();
+            let pub_handle = maidos_bus_publisher_create(addr.as_ptr());
+            assert!(!pub_handle.is_null());
+            assert_eq!(maidos_bus_publisher_port(pub_handle), 0);
+
+            let sub_handle = maidos_bus_subscriber_create(addr.as_ptr());
+            assert!(!sub_handle.is_null());
+
+            let topic = CString::new("ime.commit").unwrap();
+            let source = CString::new("ime-engine").unwrap();
+            let payload = [4u8, 5, 6];
+            let result = maidos_bus_publish(
+                pub_handle,
+                topic.as_ptr(),
+                source.as_ptr(),
+                payload.as_ptr(),
+                payload.len(),
+            );
+            assert_eq!(result, 0);
+
+            let event = maidos_bus_receive(sub_handle, 500);
+            assert!(!event.is_null());
+            let e = &*event;
+            assert_eq!(CStr::from_ptr(e.topic).to_str().unwrap(), "ime.commit");
+            assert_eq!(std::slice::from_raw_parts(e.payload, e.payload_len), &payload);
+            maidos_bus_event_free(event);
+
+            assert!(maidos_bus_receive(sub_handle, 10).is_null());
+
+            maidos_bus_subscriber_destroy(sub_handle);
+            maidos_bus_publisher_destroy(pub_handle);
+        }
+    }
+
+    #[test]
+    fn test_ffi_shm_subscriber_without_publisher() {
+        unsafe {
+            let addr = CString::new("shm://no-such-ring").unwrap();
+            assert!(maidos_bus_subscriber_create(addr.as_ptr()).is_null());
+        }
+    }
+
     #[test]
     fn test_ffi_receive_empty_payload() {
         unsafe {
@@ -1,7 +1,8 @@
 //! MAIDOS Cross-process Event Bus
 //!
 //! A lightweight, zero-dependency pub/sub message bus for inter-process
-//! communication. Uses TCP sockets with MessagePack serialization.
+//! communication. Uses TCP sockets with MessagePack serialization, or a
+//! shared-memory ring (`shm://name`) between processes on the same host.
 //!
 //! <impl>
 //! WHAT: Event-driven message bus with topic-based routing
@@ -39,12 +40,14 @@ pub mod error;
 pub mod event;
 pub mod ffi;
 pub mod publisher;
+pub mod shm;
 pub mod subscriber;
 
 // Re-exports for convenience
 pub use error::{BusError, Result};
 pub use event::Event;
 pub use publisher::{Publisher, PublisherConfig};
+pub use shm::{ShmPublisher, ShmSubscriber};
 pub use subscriber::{Subscriber, SubscriberConfig, SubscriberState};
 
 #[cfg(test)]
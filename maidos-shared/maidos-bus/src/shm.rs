@@ -0,0 +1,869 @@
+//! Same-host shared-memory transport
+//!
+//! <impl>
+//! WHAT: Named shared-memory ring buffer with publish/subscribe semantics
+//! WHY: Co-located components should not pay the loopback TCP stack per event
+//! HOW: Single-writer broadcast ring in a mapped file, futex wake-ups on Linux
+//! TEST: Roundtrip, topic filtering, lag recovery, wrap-around, close detection
+//! </impl>
+//!
+//! Addresses use the `shm://<name>` scheme. The publisher creates the ring
+//! and is its only writer; a second publisher on a live ring fails with
+//! `AddrInUse`, like binding a TCP port twice. A ring left behind by a
+//! publisher that closed or died is reclaimed. Every subscriber keeps its
+//! own read cursor, so a slow subscriber never blocks the publisher. A
+//! subscriber skips forward once it lags by more than the capacity minus
+//! the writer headroom (half the ring), because the writer may already be
+//! overwriting the records it would read next. This mirrors the `Lagged`
+//! behaviour of the TCP transport.
+//!
+//! Ring layout (native endian):
+//!
+//! ```text
+//! [RingHeader; 128 bytes][data; capacity bytes]
+//! record = [len: u32][event bytes][pad to 8]   (len == WRAP_MARKER → skip to ring start)
+//! ```
+
+use crate::error::{BusError, Result};
+use crate::event::Event;
+use std::fs::{File, OpenOptions};
+use std::io::ErrorKind;
+use std::path::PathBuf;
+use std::ptr;
+use std::sync::atomic::{fence, AtomicU32, AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+use tracing::{debug, info, warn};
+
+/// Address scheme for the shared-memory transport
+pub const SHM_SCHEME: &str = "shm://";
+
+/// Default ring data capacity (4MB)
+pub const DEFAULT_SHM_CAPACITY: usize = 4 * 1024 * 1024;
+
+const RING_MAGIC: u64 = 0x4D41_4944_4F53_4255; // "MAIDOSBU"
+const RING_VERSION: u32 = 2;
+const HEADER_SIZE: usize = 128;
+const RECORD_ALIGN: u64 = 8;
+const LEN_SIZE: usize = 4;
+const WRAP_MARKER: u32 = u32::MAX;
+/// Busy-poll window before parking on the futex (multi-core hosts only)
+const SPIN_WINDOW: Duration = Duration::from_micros(50);
+
+/// Shared ring header, placed at offset 0 of the mapping
+#[repr(C)]
+struct RingHeader {
+    magic: u64,
+    version: u32,
+    /// Data capacity in bytes (power of two)
+    capacity: u32,
+    /// Total bytes committed by the writer (monotonic)
+    write_pos: AtomicU64,
+    /// Futex word bumped on every commit
+    notify_seq: AtomicU32,
+    /// Number of readers parked on `notify_seq`
+    waiters: AtomicU32,
+    /// Set to 1 when the publisher goes away
+    closed: AtomicU32,
+    /// Process id of the publisher, used to detect rings left by a crash
+    owner_pid: AtomicU32,
+}
+
+/// Extract the ring name from an `shm://` address
+pub fn parse_shm_address(addr: &str) -> Option<&str> {
+    addr.strip_prefix(SHM_SCHEME)
+}
+
+/// Validate a ring name (used as a file name under the shm directory)
+fn validate_name(name: &str) -> Result<()> {
+    if name.is_empty()
+        || name.len() > 128
+        || !name
+            .chars()
+            .all(|c| c.is_ascii_alphanumeric() || c == '.' || c == '_' || c == '-')
+    {
+        return Err(BusError::InvalidAddress(format!("invalid shm name: {}", name)));
+    }
+    Ok(())
+}
+
+/// Backing file path for a ring name
+fn ring_path(name: &str) -> PathBuf {
+    let dir = if cfg!(target_os = "linux") {
+        PathBuf::from("/dev/shm")
+    } else {
+        std::env::temp_dir()
+    };
+    dir.join(format!("maidos-bus-{}", name))
+}
+
+/// Maximum encoded event size accepted by a ring of `capacity` bytes.
+fn max_record(capacity: u64) -> u64 {
+    capacity / 4
+}
+
+/// Distance the writer may be ahead of a reader's record before the copy is
+/// untrustworthy. A single write spans at most the skipped tail before a wrap
+/// marker plus one record, both shorter than `max_record`.
+fn write_headroom(capacity: u64) -> u64 {
+    2 * max_record(capacity)
+}
+
+fn align_up(n: u64) -> u64 {
+    (n + RECORD_ALIGN - 1) & !(RECORD_ALIGN - 1)
+}
+
+/// Mapped ring (shared by publisher and subscriber)
+struct ShmRing {
+    base: *mut u8,
+    map_len: usize,
+    capacity: u64,
+    path: PathBuf,
+    _file: File,
+}
+
+// SAFETY: the mapping is process-shared memory; all cross-thread access to the
+// header goes through atomics and record bytes are validated after copying.
+unsafe impl Send for ShmRing {}
+
+impl ShmRing {
+    fn create(name: &str, capacity: usize) -> Result<Self> {
+        validate_name(name)?;
+        if !capacity.is_power_of_two() || !(4096..=1 << 30).contains(&capacity) {
+            return Err(BusError::InvalidAddress(format!(
+                "shm capacity must be a power of two in [4096, 2^30], got {}",
+                capacity
+            )));
+        }
+
+        let path = ring_path(name);
+        let file = match Self::create_file(&path) {
+            Ok(file) => file,
+            Err(e) if e.kind() == ErrorKind::AlreadyExists => {
+                Self::reclaim_stale(&path)?;
+                Self::create_file(&path)?
+            }
+            Err(e) => return Err(e.into()),
+        };
+        let map_len = HEADER_SIZE + capacity;
+        file.set_len(map_len as u64)?;
+
+        let mut ring = Self::map(file, path, map_len)?;
+        ring.capacity = capacity as u64;
+        // SAFETY: freshly created file, we are the only user until the magic is set
+        unsafe {
+            let hdr = ring.base as *mut RingHeader;
+            ptr::addr_of_mut!((*hdr).version).write(RING_VERSION);
+            ptr::addr_of_mut!((*hdr).capacity).write(capacity as u32);
+            (*hdr).write_pos.store(0, Ordering::Relaxed);
+            (*hdr).notify_seq.store(0, Ordering::Relaxed);
+            (*hdr).waiters.store(0, Ordering::Relaxed);
+            (*hdr).closed.store(0, Ordering::Relaxed);
+            (*hdr).owner_pid.store(std::process::id(), Ordering::Relaxed);
+            fence(Ordering::Release);
+            ptr::addr_of_mut!((*hdr).magic).write_volatile(RING_MAGIC);
+        }
+        Ok(ring)
+    }
+
+    fn create_file(path: &PathBuf) -> std::io::Result<File> {
+        OpenOptions::new()
+            .read(true)
+            .write(true)
+            .create_new(true)
+            .open(path)
+    }
+
+    /// Remove an existing ring file whose publisher closed it or is gone;
+    /// fail with `AddrInUse` while a publisher still owns it
+    fn reclaim_stale(path: &PathBuf) -> Result<()> {
+        let in_use = || {
+            BusError::Io(std::io::Error::new(
+                ErrorKind::AddrInUse,
+                format!("{}: ring already has a publisher", path.display()),
+            ))
+        };
+        let file = match OpenOptions::new().read(true).write(true).open(path) {
+            Ok(file) => file,
+            // Removed between our create attempt and now
+            Err(e) if e.kind() == ErrorKind::NotFound => return Ok(()),
+            Err(e) => return Err(e.into()),
+        };
+        let map_len = file.metadata()?.len() as usize;
+        if map_len <= HEADER_SIZE {
+            // A publisher may be between create and set_len
+            return Err(in_use());
+        }
+
+        let ring = Self::map(file, path.clone(), map_len)?;
+        let hdr = ring.header();
+        // SAFETY: mapping is at least HEADER_SIZE bytes
+        let magic = unsafe { ptr::addr_of!(hdr.magic).read_volatile() };
+        fence(Ordering::Acquire);
+        if magic != RING_MAGIC {
+            // Not initialised yet, or not ours: never touch it
+            return Err(in_use());
+        }
+        let closed = hdr.closed.load(Ordering::Acquire) != 0;
+        if !closed && process_alive(hdr.owner_pid.load(Ordering::Acquire)) {
+            return Err(in_use());
+        }
+
+        warn!(
+            "[MAIDOS-AUDIT] Reclaiming stale shm ring {}",
+            path.display()
+        );
+        ring.unlink_if_current();
+        Ok(())
+    }
+
+    fn open(name: &str) -> Result<Self> {
+        validate_name(name)?;
+        let path = ring_path(name);
+        let file = OpenOptions::new()
+            .read(true)
+            .write(true)
+            .open(&path)
+            .map_err(|e| BusError::ConnectionFailed(format!("{}: {}", path.display(), e)))?;
+        let map_len = file.metadata()?.len() as usize;
+        if map_len <= HEADER_SIZE {
+            return Err(BusError::ConnectionFailed(format!(
+                "{}: ring not initialised",
+                path.display()
+            )));
+        }
+
+        let mut ring = Self::map(file, path, map_len)?;
+        // SAFETY: mapping is at least HEADER_SIZE bytes
+        let (magic, version, capacity) = unsafe {
+            let hdr = ring.base as *const RingHeader;
+            let magic = ptr::addr_of!((*hdr).magic).read_volatile();
+            fence(Ordering::Acquire);
+            (magic, (*hdr).version, (*hdr).capacity as u64)
+        };
+        if magic != RING_MAGIC || version != RING_VERSION {
+            return Err(BusError::ConnectionFailed(format!(
+                "{}: not a MAIDOS bus ring",
+                ring.path.display()
+            )));
+        }
+        if HEADER_SIZE as u64 + capacity != map_len as u64 {
+            return Err(BusError::ConnectionFailed(format!(
+                "{}: ring size mismatch",
+                ring.path.display()
+            )));
+        }
+        ring.capacity = capacity;
+        Ok(ring)
+    }
+
+    #[cfg(unix)]
+    fn map(file: File, path: PathBuf, map_len: usize) -> Result<Self> {
+        use std::os::unix::io::AsRawFd;
+
+        // SAFETY: fd is valid for the duration of the call; result is checked
+        let base = unsafe {
+            libc::mmap(
+                ptr::null_mut(),
+                map_len,
+                libc::PROT_READ | libc::PROT_WRITE,
+                libc::MAP_SHARED,
+                file.as_raw_fd(),
+                0,
+            )
+        };
+        if base == libc::MAP_FAILED {
+            return Err(BusError::Io(std::io::Error::last_os_error()));
+        }
+        Ok(Self {
+            base: base as *mut u8,
+            map_len,
+            capacity: 0,
+            path,
+            _file: file,
+        })
+    }
+
+    #[cfg(not(unix))]
+    fn map(_file: File, _path: PathBuf, _map_len: usize) -> Result<Self> {
+        Err(BusError::InvalidAddress(
+            "shm transport is only available on unix targets".to_string(),
+        ))
+    }
+
+    fn header(&self) -> &RingHeader {
+        // SAFETY: base points to a live mapping at least HEADER_SIZE bytes long
+        unsafe { &*(self.base as *const RingHeader) }
+    }
+
+    fn data(&self) -> *mut u8 {
+        // SAFETY: data region starts right after the header inside the mapping
+        unsafe { self.base.add(HEADER_SIZE) }
+    }
+
+    fn offset(&self, pos: u64) -> usize {
+        (pos & (self.capacity - 1)) as usize
+    }
+
+    /// Unlink the backing file only if the path still names this mapping's
+    /// file, so a ring created by a newer publisher is never removed
+    fn unlink_if_current(&self) {
+        #[cfg(unix)]
+        {
+            use std::os::unix::fs::MetadataExt;
+
+            let ours = match self._file.metadata() {
+                Ok(m) => m,
+                Err(_) => return,
+            };
+            match std::fs::metadata(&self.path) {
+                Ok(m) if m.dev() == ours.dev() && m.ino() == ours.ino() => {
+                    let _ = std::fs::remove_file(&self.path);
+                }
+                _ => {}
+            }
+        }
+    }
+
+    fn wake_all(&self) {
+        let hdr = self.header();
+        hdr.notify_seq.fetch_add(1, Ordering::SeqCst);
+        if hdr.waiters.load(Ordering::SeqCst) > 0 {
+            futex_wake(&hdr.notify_seq);
+        }
+    }
+}
+
+impl Drop for ShmRing {
+    fn drop(&mut self) {
+        #[cfg(unix)]
+        // SAFETY: base/map_len come from a successful mmap
+        unsafe {
+            libc::munmap(self.base as *mut libc::c_void, self.map_len);
+        }
+    }
+}
+
+/// Whether a process with `pid` still exists (0 = unknown owner)
+#[cfg(unix)]
+fn process_alive(pid: u32) -> bool {
+    if pid == 0 || pid > i32::MAX as u32 {
+        return false;
+    }
+    // SAFETY: signal 0 performs only the existence and permission check
+    let rc = unsafe { libc::kill(pid as libc::pid_t, 0) };
+    rc == 0 || std::io::Error::last_os_error().raw_os_error() == Some(libc::EPERM)
+}
+
+#[cfg(not(unix))]
+fn process_alive(_pid: u32) -> bool {
+    true
+}
+
+#[cfg(target_os = "linux")]
+fn futex_wait(word: &AtomicU32, expected: u32, timeout: Duration) {
+    let ts = libc::timespec {
+        tv_sec: timeout.as_secs().min(i32::MAX as u64) as libc::time_t,
+        tv_nsec: timeout.subsec_nanos() as libc::c_long,
+    };
+    // SAFETY: word lives in shared memory for the lifetime of the ring; a
+    // non-private futex is required because waiters may be in other processes.
+    unsafe {
+        libc::syscall(
+            libc::SYS_futex,
+            word as *const AtomicU32,
+            libc::FUTEX_WAIT,
+            expected,
+            &ts as *const libc::timespec,
+        );
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn futex_wake(word: &AtomicU32) {
+    // SAFETY: see futex_wait
+    unsafe {
+        libc::syscall(
+            libc::SYS_futex,
+            word as *const AtomicU32,
+            libc::FUTEX_WAKE,
+            i32::MAX,
+        );
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn futex_wait(word: &AtomicU32, expected: u32, timeout: Duration) {
+    let deadline = Instant::now() + timeout;
+    while word.load(Ordering::Acquire) == expected && Instant::now() < deadline {
+        std::thread::sleep(Duration::from_micros(50));
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn futex_wake(_word: &AtomicU32) {}
+
+/// Shared-memory event publisher (single writer per ring)
+pub struct ShmPublisher {
+    ring: ShmRing,
+    name: String,
+    events_published: u64,
+}
+
+impl ShmPublisher {
+    /// Create a ring with the default capacity
+    pub fn create(name: &str) -> Result<Self> {
+        Self::with_capacity(name, DEFAULT_SHM_CAPACITY)
+    }
+
+    /// Create a ring with `capacity` data bytes (power of two)
+    pub fn with_capacity(name: &str, capacity: usize) -> Result<Self> {
+        let ring = ShmRing::create(name, capacity)?;
+        info!(
+            "[MAIDOS-AUDIT] Shm publisher starting on {}{} ({} bytes)",
+            SHM_SCHEME, name, capacity
+        );
+        Ok(Self {
+            ring,
+            name: name.to_string(),
+            events_published: 0,
+        })
+    }
+
+    /// Ring name (without scheme)
+    pub fn name(&self) -> &str {
+        &self.name
+    }
+
+    /// Publish an event to all subscribers
+    pub fn publish(&mut self, event: Event) -> Result<()> {
+        let bytes = event.to_bytes()?;
+        self.publish_bytes(&bytes)?;
+        debug!("Published shm event: topic={}", event.topic);
+        Ok(())
+    }
+
+    /// Append one encoded event to the ring and wake readers
+    fn publish_bytes(&mut self, bytes: &[u8]) -> Result<()> {
+        let ring = &self.ring;
+        let cap = ring.capacity;
+        let record = align_up((LEN_SIZE + bytes.len()) as u64);
+        if record > max_record(cap) {
+            return Err(BusError::Serialization(format!(
+                "event of {} bytes exceeds shm record limit {}",
+                bytes.len(),
+                max_record(cap)
+            )));
+        }
+
+        let hdr = ring.header();
+        let mut pos = hdr.write_pos.load(Ordering::Relaxed);
+        let mut off = ring.offset(pos);
+        let to_end = cap - off as u64;
+
+        // SAFETY: offsets are masked into the data region and records never
+        // straddle the end of the ring (a wrap marker is written instead).
+        unsafe {
+            let data = ring.data();
+            if record > to_end {
+                ptr::write_unaligned(data.add(off) as *mut u32, WRAP_MARKER);
+                pos += to_end;
+                off = 0;
+            }
+            ptr::copy_nonoverlapping(bytes.as_ptr(), data.add(off + LEN_SIZE), bytes.len());
+            ptr::write_unaligned(data.add(off) as *mut u32, bytes.len() as u32);
+        }
+
+        hdr.write_pos.store(pos + record, Ordering::SeqCst);
+        ring.wake_all();
+        self.events_published += 1;
+        Ok(())
+    }
+
+    /// Total events published
+    pub fn events_published(&self) -> u64 {
+        self.events_published
+    }
+}
+
+impl Drop for ShmPublisher {
+    fn drop(&mut self) {
+        self.ring.header().closed.store(1, Ordering::SeqCst);
+        self.ring.wake_all();
+        self.ring.unlink_if_current();
+        info!("[MAIDOS-AUDIT] Shm publisher stopped: {}{}", SHM_SCHEME, self.name);
+    }
+}
+
+/// Outcome of a single non-blocking read attempt
+enum ReadOutcome {
+    Event(Event),
+    Filtered,
+    Empty,
+    Closed,
+}
+
+/// Shared-memory event subscriber
+pub struct ShmSubscriber {
+    ring: ShmRing,
+    cursor: u64,
+    topics: Vec<String>,
+    scratch: Vec<u8>,
+    spin_window: Duration,
+    events_received: u64,
+    lagged: u64,
+}
+
+impl ShmSubscriber {
+    /// Attach to an existing ring; only events published from now on are seen
+    pub fn open(name: &str) -> Result<Self> {
+        let ring = ShmRing::open(name)?;
+        let cursor = ring.header().write_pos.load(Ordering::Acquire);
+        Ok(Self {
+            ring,
+            cursor,
+            topics: Vec::new(),
+            scratch: Vec::new(),
+            // Spinning only pays off when the publisher can run concurrently
+            spin_window: match std::thread::available_parallelism() {
+                Ok(n) if n.get() > 1 => SPIN_WINDOW,
+                _ => Duration::ZERO,
+            },
+            events_received: 0,
+            lagged: 0,
+        })
+    }
+
+    /// Add topic filter (same wildcard rules as the TCP subscriber)
+    pub fn with_topic(mut self, topic: impl Into<String>) -> Self {
+        self.topics.push(topic.into());
+        self
+    }
+
+    /// Try to receive event (non-blocking)
+    pub fn try_recv(&mut self) -> Option<Event> {
+        loop {
+            match self.read_next() {
+                ReadOutcome::Event(e) => return Some(e),
+                ReadOutcome::Filtered => continue,
+                ReadOutcome::Empty | ReadOutcome::Closed => return None,
+            }
+        }
+    }
+
+    /// Receive next event, waiting up to `timeout`
+    pub fn recv_timeout(&mut self, timeout: Duration) -> Option<Event> {
+        let started = Instant::now();
+        let deadline = started + timeout;
+        loop {
+            match self.read_next() {
+                ReadOutcome::Event(e) => return Some(e),
+                ReadOutcome::Filtered => continue,
+                ReadOutcome::Closed => return None,
+                ReadOutcome::Empty => {}
+            }
+
+            let now = Instant::now();
+            if now >= deadline {
+                return None;
+            }
+            if now - started < self.spin_window {
+                std::hint::spin_loop();
+                continue;
+            }
+            self.park(deadline - now);
+        }
+    }
+
+    /// Whether the publisher has closed the ring
+    pub fn is_closed(&self) -> bool {
+        self.ring.header().closed.load(Ordering::Acquire) != 0
+    }
+
+    /// Events delivered to this subscriber
+    pub fn events_received(&self) -> u64 {
+        self.events_received
+    }
+
+    /// Times this subscriber fell behind and skipped forward
+    pub fn lagged(&self) -> u64 {
+        self.lagged
+    }
+
+    /// Sleep on the ring futex until the writer commits or `timeout` elapses
+    fn park(&self, timeout: Duration) {
+        let hdr = self.ring.header();
+        let seq = hdr.notify_seq.load(Ordering::SeqCst);
+        hdr.waiters.fetch_add(1, Ordering::SeqCst);
+        if hdr.write_pos.load(Ordering::SeqCst) == self.cursor
+            && hdr.closed.load(Ordering::SeqCst) == 0
+        {
+            futex_wait(&hdr.notify_seq, seq, timeout);
+        }
+        hdr.waiters.fetch_sub(1, Ordering::SeqCst);
+    }
+
+    fn skip_to(&mut self, pos: u64) {
+        warn!(
+            "[MAIDOS-AUDIT] Shm subscriber lagged behind by {} bytes",
+            pos - self.cursor
+        );
+        self.lagged += 1;
+        self.cursor = pos;
+    }
+
+    fn read_next(&mut self) -> ReadOutcome {
+        let cap = self.ring.capacity;
+        let hdr = self.ring.header();
+        let write_pos = hdr.write_pos.load(Ordering::Acquire);
+        if write_pos == self.cursor {
+            return if hdr.closed.load(Ordering::Acquire) != 0 {
+                ReadOutcome::Closed
+            } else {
+                ReadOutcome::Empty
+            };
+        }
+        // Past this lag the writer's next record may overwrite our cursor
+        if write_pos - self.cursor > cap - write_headroom(cap) {
+            self.skip_to(write_pos);
+            return ReadOutcome::Empty;
+        }
+
+        let start = self.cursor;
+        let off = self.ring.offset(start);
+        // SAFETY: off is inside the data region; a record never straddles the end
+        let len = unsafe { ptr::read_unaligned(self.ring.data().add(off) as *const u32) };
+        let record = if len == WRAP_MARKER {
+            cap - off as u64
+        } else {
+            let record = align_up((LEN_SIZE as u64) + len as u64);
+            if record > max_record(cap) || off as u64 + record > cap {
+                // Torn length: the writer lapped us while we were reading
+                self.skip_to(hdr.write_pos.load(Ordering::Acquire));
+                return ReadOutcome::Empty;
+            }
+            self.scratch.clear();
+            self.scratch.reserve(len as usize);
+            // SAFETY: bounds checked above; scratch has capacity for len bytes
+            unsafe {
+                ptr::copy_nonoverlapping(
+                    self.ring.data().add(off + LEN_SIZE),
+                    self.scratch.as_mut_ptr(),
+                    len as usize,
+                );
+                self.scratch.set_len(len as usize);
+            }
+            record
+        };
+
+        // Validate: the copy is only trustworthy if the writer (plus one
+        // in-flight write, which may span a wrap) has not advanced into the
+        // bytes we just read.
+        fence(Ordering::Acquire);
+        let now_pos = hdr.write_pos.load(Ordering::Acquire);
+        if now_pos + write_headroom(cap) > start + cap {
+            self.skip_to(now_pos);
+            return ReadOutcome::Empty;
+        }
+        self.cursor = start + record;
+        if len == WRAP_MARKER {
+            return ReadOutcome::Filtered;
+        }
+
+        let event = match Event::from_bytes(&self.scratch) {
+            Ok(e) => e,
+            Err(e) => {
+                warn!("[MAIDOS-AUDIT] Dropping undecodable shm event: {}", e);
+                return ReadOutcome::Filtered;
+            }
+        };
+        if !self.topics.is_empty() && !self.topics.iter().any(|t| event.matches_topic(t)) {
+            return ReadOutcome::Filtered;
+        }
+        self.events_received += 1;
+        ReadOutcome::Event(event)
+    }
+}
+
+#[cfg(all(test, unix))]
+mod tests {
+    use super::*;
+
+    fn unique_name(tag: &str) -> String {
+        format!("test-{}-{}", tag, std::process::id())
+    }
+
+    #[test]
+    fn test_parse_shm_address() {
+        assert_eq!(parse_shm_address("shm://ime.events"), Some("ime.events"));
+        assert_eq!(parse_shm_address("127.0.0.1:5555"), None);
+    }
+
+    #[test]
+    fn test_invalid_name_and_capacity() {
+        assert!(matches!(
+            ShmPublisher::create("bad/name"),
+            Err(BusError::InvalidAddress(_))
+        ));
+        assert!(matches!(
+            ShmPublisher::with_capacity(&unique_name("cap"), 5000),
+            Err(BusError::InvalidAddress(_))
+        ));
+    }
+
+    #[test]
+    fn test_open_missing_ring() {
+        let result = ShmSubscriber::open(&unique_name("missing"));
+        assert!(matches!(result, Err(BusError::ConnectionFailed(_))));
+    }
+
+    #[test]
+    fn test_shm_roundtrip() {
+        let name = unique_name("roundtrip");
+        let mut publisher = ShmPublisher::create(&name).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+
+        for i in 0..5u8 {
+            let event = Event::new(format!("test.event.{}", i), "shm-test", vec![i]).unwrap();
+            publisher.publish(event).unwrap();
+        }
+        for i in 0..5u8 {
+            let event = subscriber.recv_timeout(Duration::from_secs(1)).unwrap();
+            assert_eq!(event.topic, format!("test.event.{}", i));
+            assert_eq!(event.payload, vec![i]);
+        }
+        assert!(subscriber.try_recv().is_none());
+        assert_eq!(publisher.events_published(), 5);
+        assert_eq!(subscriber.events_received(), 5);
+    }
+
+    #[test]
+    fn test_shm_topic_filtering() {
+        let name = unique_name("filter");
+        let mut publisher = ShmPublisher::create(&name).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap().with_topic("wanted.*");
+
+        publisher.publish(Event::new("other.event", "src", vec![2]).unwrap()).unwrap();
+        publisher.publish(Event::new("wanted.event", "src", vec![1]).unwrap()).unwrap();
+
+        let event = subscriber.recv_timeout(Duration::from_secs(1)).unwrap();
+        assert_eq!(event.topic, "wanted.event");
+        assert!(subscriber.try_recv().is_none());
+    }
+
+    #[test]
+    fn test_shm_wraparound() {
+        let name = unique_name("wrap");
+        let mut publisher = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+
+        // Each record is a few hundred bytes: the ring wraps many times
+        for i in 0..200u32 {
+            let event = Event::new("wrap.test", "src", vec![(i % 251) as u8; 300]).unwrap();
+            publisher.publish(event).unwrap();
+            let received = subscriber.recv_timeout(Duration::from_secs(1)).unwrap();
+            assert_eq!(received.payload[0], (i % 251) as u8);
+        }
+        assert_eq!(subscriber.lagged(), 0);
+    }
+
+    #[test]
+    fn test_shm_lagged_subscriber_skips_forward() {
+        let name = unique_name("lag");
+        let mut publisher = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+
+        for _ in 0..100 {
+            publisher
+                .publish(Event::new("lag.test", "src", vec![0u8; 200]).unwrap())
+                .unwrap();
+        }
+        assert!(subscriber.try_recv().is_none());
+        assert_eq!(subscriber.lagged(), 1);
+
+        publisher.publish(Event::new("lag.after", "src", vec![7]).unwrap()).unwrap();
+        let event = subscriber.recv_timeout(Duration::from_secs(1)).unwrap();
+        assert_eq!(event.topic, "lag.after");
+    }
+
+    #[test]
+    fn test_shm_cross_thread_wakeup() {
+        let name = unique_name("wake");
+        let mut publisher = ShmPublisher::create(&name).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+
+        let handle = std::thread::spawn(move || {
+            let event = subscriber.recv_timeout(Duration::from_secs(5));
+            event.map(|e| e.payload)
+        });
+        std::thread::sleep(Duration::from_millis(50));
+        publisher.publish(Event::new("wake.test", "src", vec![42]).unwrap()).unwrap();
+
+        assert_eq!(handle.join().unwrap(), Some(vec![42]));
+    }
+
+    #[test]
+    fn test_shm_publisher_drop_closes_ring() {
+        let name = unique_name("close");
+        let publisher = ShmPublisher::create(&name).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+        drop(publisher);
+
+        assert!(subscriber.is_closed());
+        assert!(subscriber.recv_timeout(Duration::from_secs(1)).is_none());
+    }
+
+    #[test]
+    fn test_shm_second_publisher_rejected() {
+        let name = unique_name("exclusive");
+        let mut first = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+
+        match ShmPublisher::with_capacity(&name, 4096) {
+            Err(BusError::Io(e)) => assert_eq!(e.kind(), ErrorKind::AddrInUse),
+            other => panic!("expected AddrInUse, got {:?}", other.map(|_| ())),
+        }
+
+        // The live ring is untouched
+        first.publish(Event::new("still.live", "src", vec![1]).unwrap()).unwrap();
+        let event = subscriber.recv_timeout(Duration::from_secs(1)).unwrap();
+        assert_eq!(event.topic, "still.live");
+    }
+
+    #[test]
+    fn test_shm_stale_ring_reclaimed() {
+        let name = unique_name("stale");
+        let first = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        // Simulate a publisher that died without cleaning up
+        first.ring.header().owner_pid.store(0, Ordering::SeqCst);
+        std::mem::forget(first);
+
+        let mut second = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        let mut subscriber = ShmSubscriber::open(&name).unwrap();
+        second.publish(Event::new("after.reclaim", "src", vec![2]).unwrap()).unwrap();
+        assert_eq!(
+            subscriber.recv_timeout(Duration::from_secs(1)).unwrap().topic,
+            "after.reclaim"
+        );
+
+        drop(subscriber);
+
+        // A closed ring is reclaimed too, and its old owner never unlinks the new file
+        second.ring.header().closed.store(1, Ordering::SeqCst);
+        let third = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        drop(second);
+        assert!(ring_path(&name).exists());
+        drop(third);
+        assert!(!ring_path(&name).exists());
+    }
+
+    #[test]
+    fn test_shm_oversized_event_rejected() {
+        let name = unique_name("big");
+        let mut publisher = ShmPublisher::with_capacity(&name, 4096).unwrap();
+        let event = Event::new("big.test", "src", vec![0u8; 2048]).unwrap();
+        assert!(matches!(
+            publisher.publish(event),
+            Err(BusError::Serialization(_))
+        ));
+    }
+}
@@ -0,0 +1,646 @@
+//! Content-addressed response cache
+//!
+//! <impl>
+//! WHAT: Memory + optional on-disk cache of completion responses
+//! WHY: IME reranking and candidate explanation resend identical prompts;
+//!      repeats should return in microseconds and cost no tokens
+//! HOW: Key = SHA-256 of (provider, normalized request JSON); one LRU index
+//!      (entry count + byte cap) governs both tiers; TTL checked on lookup;
+//!      file I/O never runs under the index lock, and `CachedProvider` moves
+//!      it to the blocking pool; the wrapper reports zero usage on hits
+//! TEST: Key normalization, hit/miss, TTL, LRU eviction, disk reload, wrapper
+//! </impl>
+
+use std::collections::{BTreeMap, HashMap};
+use std::path::{Path, PathBuf};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{SystemTime, UNIX_EPOCH};
+
+use async_trait::async_trait;
+use parking_lot::Mutex;
+use serde::{Deserialize, Serialize};
+use sha2::{Digest, Sha256};
+
+use crate::error::Result;
+use crate::message::CompletionResponse;
+use crate::provider::{CompletionRequest, CompletionStream, LlmProvider, ModelInfo, ProviderInfo};
+
+/// Response cache configuration
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct ResponseCacheConfig {
+    /// Maximum cached responses
+    pub max_entries: usize,
+    /// Maximum total size of cached responses (serialized bytes)
+    pub max_bytes: usize,
+    /// Entry lifetime in seconds
+    pub ttl_secs: u64,
+    /// Directory for the on-disk tier (`None` = memory only)
+    pub dir: Option<PathBuf>,
+    /// Only cache requests with temperature 0
+    pub only_deterministic: bool,
+}
+
+impl Default for ResponseCacheConfig {
+    fn default() -> Self {
+        Self {
+            max_entries: 1024,
+            max_bytes: 16 * 1024 * 1024,
+            ttl_secs: 24 * 3600,
+            dir: None,
+            only_deterministic: true,
+        }
+    }
+}
+
+/// Response cache statistics
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct ResponseCacheStats {
+    /// Lookups answered from the cache
+    pub hits: u64,
+    /// Lookups that went to the provider
+    pub misses: u64,
+    /// Hits whose body was loaded from disk
+    pub disk_hits: u64,
+    /// Entries dropped by the LRU caps or TTL
+    pub evictions: u64,
+    /// Entries currently indexed
+    pub entries: usize,
+    /// Total serialized size of indexed entries
+    pub bytes: usize,
+}
+
+#[derive(Serialize, Deserialize)]
+struct DiskEntry {
+    stored_at_ms: u64,
+    response: CompletionResponse,
+}
+
+struct Entry {
+    /// `None` while the body is only on disk
+    response: Option<CompletionResponse>,
+    stored_at_ms: u64,
+    size: usize,
+    tick: u64,
+}
+
+/// Result of the in-memory part of a lookup
+enum Lookup {
+    Hit(CompletionResponse),
+    /// Indexed, body on disk (entry's `stored_at_ms`)
+    OnDisk(u64),
+    Miss,
+}
+
+#[derive(Default)]
+struct Index {
+    entries: HashMap<String, Entry>,
+    /// LRU order: access tick -> key
+    lru: BTreeMap<u64, String>,
+    tick: u64,
+    bytes: usize,
+}
+
+impl Index {
+    fn touch(&mut self, key: &str) {
+        self.tick += 1;
+        let tick = self.tick;
+        if let Some(entry) = self.entries.get_mut(key) {
+            self.lru.remove(&entry.tick);
+            entry.tick = tick;
+            self.lru.insert(tick, key.to_string());
+        }
+    }
+
+    fn remove(&mut self, key: &str) -> Option<Entry> {
+        let entry = self.entries.remove(key)?;
+        self.lru.remove(&entry.tick);
+        self.bytes -= entry.size;
+        Some(entry)
+    }
+}
+
+/// Content-addressed cache of completion responses
+pub struct ResponseCache {
+    config: ResponseCacheConfig,
+    index: Mutex<Index>,
+    hits: AtomicU64,
+    misses: AtomicU64,
+    disk_hits: AtomicU64,
+    evictions: AtomicU64,
+}
+
+impl ResponseCache {
+    /// Create a cache, indexing any responses already in `config.dir`
+    pub fn new(config: ResponseCacheConfig) -> Result<Self> {
+        let cache = Self {
+            config,
+            index: Mutex::new(Index::default()),
+            hits: AtomicU64::new(0),
+            misses: AtomicU64::new(0),
+            disk_hits: AtomicU64::new(0),
+            evictions: AtomicU64::new(0),
+        };
+        if let Some(dir) = cache.config.dir.clone() {
+            std::fs::create_dir_all(&dir)?;
+            cache.load_index(&dir)?;
+        }
+        Ok(cache)
+    }
+
+    /// Cache key for a request, or `None` if the request is not cacheable
+    ///
+    /// The request is normalized through `serde_json::Value` (sorted keys)
+    /// with the `stream` flag removed.
+    pub fn key(&self, provider: &str, request: &CompletionRequest) -> Option<String> {
+        if self.config.only_deterministic && request.temperature != Some(0.0) {
+            return None;
+        }
+
+        let mut value = serde_json::to_value(request).ok()?;
+        if let Some(map) = value.as_object_mut() {
+            map.remove("stream");
+        }
+
+        let mut hasher = Sha256::new();
+        hasher.update(provider.as_bytes());
+        hasher.update([0u8]);
+        hasher.update(value.to_string().as_bytes());
+        Some(hasher.finalize().iter().map(|b| format!("{:02x}", b)).collect())
+    }
+
+    /// Look up a cached response (may read the on-disk tier)
+    pub fn get(&self, key: &str) -> Option<CompletionResponse> {
+        match self.lookup(key) {
+            Lookup::Hit(response) => Some(response),
+            Lookup::OnDisk(stored_at_ms) => self.load(key, stored_at_ms),
+            Lookup::Miss => None,
+        }
+    }
+
+    /// Store a response (writes the on-disk tier when configured)
+    pub fn put(&self, key: &str, response: &CompletionResponse) {
+        self.insert(key, response.clone(), now_ms());
+    }
+
+    /// In-memory part of `get`; never touches the disk except to drop an
+    /// expired file after the lock is released
+    fn lookup(&self, key: &str) -> Lookup {
+        let now = now_ms();
+        let mut index = self.index.lock();
+
+        let (expired, stored_at_ms) = match index.entries.get(key) {
+            Some(entry) => (self.is_expired(entry.stored_at_ms, now), entry.stored_at_ms),
+            None => {
+                self.misses.fetch_add(1, Ordering::Relaxed);
+                return Lookup::Miss;
+            }
+        };
+
+        if expired {
+            index.remove(key);
+            drop(index);
+            self.remove_file(key);
+            self.evictions.fetch_add(1, Ordering::Relaxed);
+            self.misses.fetch_add(1, Ordering::Relaxed);
+            return Lookup::Miss;
+        }
+
+        index.touch(key);
+        match index.entries.get(key).and_then(|e| e.response.clone()) {
+            Some(response) => {
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                Lookup::Hit(response)
+            }
+            None => Lookup::OnDisk(stored_at_ms),
+        }
+    }
+
+    /// Read a body that `lookup` found on disk, then install it in memory
+    fn load(&self, key: &str, stored_at_ms: u64) -> Option<CompletionResponse> {
+        let disk = self.read_file(key);
+
+        let mut index = self.index.lock();
+        // The entry may have been replaced or evicted while we were reading
+        let unchanged = matches!(
+            index.entries.get(key),
+            Some(e) if e.stored_at_ms == stored_at_ms && e.response.is_none()
+        );
+        match disk {
+            Some(disk) => {
+                if unchanged {
+                    if let Some(entry) = index.entries.get_mut(key) {
+                        entry.response = Some(disk.response.clone());
+                    }
+                }
+                self.disk_hits.fetch_add(1, Ordering::Relaxed);
+                self.hits.fetch_add(1, Ordering::Relaxed);
+                Some(disk.response)
+            }
+            None => {
+                if unchanged {
+                    index.remove(key);
+                }
+                self.misses.fetch_add(1, Ordering::Relaxed);
+                None
+            }
+        }
+    }
+
+    fn insert(&self, key: &str, response: CompletionResponse, stored_at_ms: u64) {
+        if self.config.max_entries == 0 {
+            return;
+        }
+
+        let disk = DiskEntry {
+            stored_at_ms,
+            response,
+        };
+        let bytes = match serde_json::to_vec(&disk) {
+            Ok(b) => b,
+            Err(_) => return,
+        };
+        if bytes.len() > self.config.max_bytes {
+            return;
+        }
+        if self.config.dir.is_some() {
+            self.write_file(key, &bytes);
+        }
+
+        let mut index = self.index.lock();
+        index.remove(key);
+        index.tick += 1;
+        let tick = index.tick;
+        index.bytes += bytes.len();
+        index.lru.insert(tick, key.to_string());
+        index.entries.insert(
+            key.to_string(),
+            Entry {
+                response: Some(disk.response),
+                stored_at_ms,
+                size: bytes.len(),
+                tick,
+            },
+        );
+        let evicted = self.enforce_caps(&mut index);
+        drop(index);
+        self.remove_files(&evicted);
+    }
+
+    /// Drop every entry (memory and disk)
+    pub fn clear(&self) {
+        let keys: Vec<String> = {
+            let mut index = self.index.lock();
+            let keys = index.entries.keys().cloned().collect();
+            *index = Index::default();
+            keys
+        };
+        self.remove_files(&keys);
+    }
+
+    /// Cache statistics
+    pub fn stats(&self) -> ResponseCacheStats {
+        let index = self.index.lock();
+        ResponseCacheStats {
+            hits: self.hits.load(Ordering::Relaxed),
+            misses: self.misses.load(Ordering::Relaxed),
+            disk_hits: self.disk_hits.load(Ordering::Relaxed),
+            evictions: self.evictions.load(Ordering::Relaxed),
+            entries: index.entries.len(),
+            bytes: index.bytes,
+        }
+    }
+
+    fn is_expired(&self, stored_at_ms: u64, now_ms: u64) -> bool {
+        now_ms.saturating_sub(stored_at_ms) >= self.config.ttl_secs.saturating_mul(1000)
+    }
+
+    /// Evict LRU entries over the caps; returns their keys so the caller can
+    /// delete the files after releasing the lock
+    fn enforce_caps(&self, index: &mut Index) -> Vec<String> {
+        let mut evicted = Vec::new();
+        while index.entries.len() > self.config.max_entries || index.bytes > self.config.max_bytes {
+            let oldest = match index.lru.iter().next() {
+                Some((_, key)) => key.clone(),
+                None => break,
+            };
+            index.remove(&oldest);
+            self.evictions.fetch_add(1, Ordering::Relaxed);
+            evicted.push(oldest);
+        }
+        evicted
+    }
+
+    /// Index existing files by modification order; bodies load on first hit
+    fn load_index(&self, dir: &Path) -> Result<()> {
+        let now = now_ms();
+        let mut found = Vec::new();
+        for item in std::fs::read_dir(dir)?.flatten() {
+            let path = item.path();
+            if path.extension().and_then(|e| e.to_str()) != Some("json") {
+                continue;
+            }
+            let Some(key) = path.file_stem().and_then(|s| s.to_str()).map(str::to_string) else {
+                continue;
+            };
+            let Ok(meta) = item.metadata() else { continue };
+            let stored_at_ms = meta
+                .modified()
+                .ok()
+                .and_then(|t| t.duration_since(UNIX_EPOCH).ok())
+                .map(|d| d.as_millis() as u64)
+                .unwrap_or(0);
+            if self.is_expired(stored_at_ms, now) {
+                let _ = std::fs::remove_file(&path);
+                continue;
+            }
+            found.push((stored_at_ms, key, meta.len() as usize));
+        }
+        found.sort();
+
+        let mut index = self.index.lock();
+        for (stored_at_ms, key, size) in found {
+            index.tick += 1;
+            let tick = index.tick;
+            index.bytes += size;
+            index.lru.insert(tick, key.clone());
+            index.entries.insert(
+                key,
+                Entry {
+                    response: None,
+                    stored_at_ms,
+                    size,
+                    tick,
+                },
+            );
+        }
+        let evicted = self.enforce_caps(&mut index);
+        drop(index);
+        self.remove_files(&evicted);
+        Ok(())
+    }
+
+    fn path_for(&self, key: &str) -> Option<PathBuf> {
+        self.config.dir.as_ref().map(|d| d.join(format!("{}.json", key)))
+    }
+
+    fn read_file(&self, key: &str) -> Option<DiskEntry> {
+        let bytes = std::fs::read(self.path_for(key)?).ok()?;
+        serde_json::from_slice(&bytes).ok()
+    }
+
+    fn write_file(&self, key: &str, bytes: &[u8]) {
+        let Some(path) = self.path_for(key) else { return };
+        let tmp = path.with_extension("tmp");
+        if std::fs::write(&tmp, bytes).is_ok() && std::fs::rename(&tmp, &path).is_err() {
+            let _ = std::fs::remove_file(&tmp);
+        }
+    }
+
+    fn remove_file(&self, key: &str) {
+        if let Some(path) = self.path_for(key) {
+            let _ = std::fs::remove_file(path);
+        }
+    }
+
+    fn remove_files(&self, keys: &[String]) {
+        if self.config.dir.is_some() {
+            for key in keys {
+                self.remove_file(key);
+            }
+        }
+    }
+}
+
+/// Run `f` on the runtime's blocking pool when called from inside Tokio
+async fn run_blocking<T, F>(f: F) -> Option<T>
+where
+    F: FnOnce() -> T + Send + 'static,
+    T: Send + 'static,
+{
+    match tokio::runtime::Handle::try_current() {
+        Ok(handle) => handle.spawn_blocking(f).await.ok(),
+        Err(_) => Some(f()),
+    }
+}
+
+fn now_ms() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map(|d| d.as_millis() as u64)
+        .unwrap_or(0)
+}
+
+/// Provider wrapper that answers repeated requests from a `ResponseCache`
+///
+/// Cache hits report zero prompt/completion tokens (the original total is
+/// kept in `usage.cached_tokens`), so budget accounting charges nothing.
+pub struct CachedProvider {
+    inner: Arc<dyn LlmProvider>,
+    cache: Arc<ResponseCache>,
+}
+
+impl CachedProvider {
+    /// Wrap `inner` with `cache`
+    pub fn new(inner: Arc<dyn LlmProvider>, cache: Arc<ResponseCache>) -> Self {
+        Self { inner, cache }
+    }
+
+    /// The underlying cache
+    pub fn cache(&self) -> &Arc<ResponseCache> {
+        &self.cache
+    }
+
+    /// Memory hits are answered inline; disk reads go to the blocking pool
+    async fn cache_get(&self, key: &str) -> Option<CompletionResponse> {
+        match self.cache.lookup(key) {
+            Lookup::Hit(response) => Some(response),
+            Lookup::Miss => None,
+            Lookup::OnDisk(stored_at_ms) => {
+                let cache = self.cache.clone();
+                let key = key.to_string();
+                run_blocking(move || cache.load(&key, stored_at_ms)).await.flatten()
+            }
+        }
+    }
+
+    async fn cache_put(&self, key: &str, response: &CompletionResponse) {
+        if self.cache.config.dir.is_none() {
+            self.cache.put(key, response);
+            return;
+        }
+        let cache = self.cache.clone();
+        let key = key.to_string();
+        let response = response.clone();
+        run_blocking(move || cache.put(&key, &response)).await;
+    }
+}
+
+#[async_trait]
+impl LlmProvider for CachedProvider {
+    fn info(&self) -> &ProviderInfo {
+        self.inner.info()
+    }
+
+    async fn complete(&self, request: CompletionRequest) -> Result<CompletionResponse> {
+        let key = self.cache.key(self.inner.name(), &request);
+
+        if let Some(key) = &key {
+            if let Some(mut response) = self.cache_get(key).await {
+                response.usage.cached_tokens = Some(response.usage.total_tokens);
+                response.usage.prompt_tokens = 0;
+                response.usage.completion_tokens = 0;
+                response.usage.total_tokens = 0;
+                return Ok(response);
+            }
+        }
+
+        let response = self.inner.complete(request).await?;
+        if let Some(key) = &key {
+            self.cache_put(key, &response).await;
+        }
+        Ok(response)
+    }
+
+    async fn complete_stream(&self, request: CompletionRequest) -> Result<CompletionStream> {
+        self.inner.complete_stream(request).await
+    }
+
+    async fn list_models(&self) -> Result<Vec<ModelInfo>> {
+        self.inner.list_models().await
+    }
+
+    async fn health_check(&self) -> Result<bool> {
+        self.inner.health_check().await
+    }
+
+    fn supports_batching(&self) -> bool {
+        self.inner.supports_batching()
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::message::{FinishReason, Message, Usage};
+
+    fn response(text: &str) -> CompletionResponse {
+        CompletionResponse {
+            message: Message::assistant(text),
+            usage: Usage::new(10, 5),
+            finish_reason: FinishReason::Stop,
+            model: "m".to_string(),
+            id: None,
+        }
+    }
+
+    fn request(prompt: &str) -> CompletionRequest {
+        CompletionRequest::quick("m", prompt).temperature(0.0)
+    }
+
+    fn temp_dir(name: &str) -> PathBuf {
+        let dir = std::env::temp_dir().join(format!("maidos-llm-cache-{}-{}", name, std::process::id()));
+        let _ = std::fs::remove_dir_all(&dir);
+        dir
+    }
+
+    #[test]
+    fn test_key_normalization() {
+        let cache = ResponseCache::new(ResponseCacheConfig::default()).unwrap();
+        let a = cache.key("OpenAI", &request("hi")).unwrap();
+        assert_eq!(a.len(), 64);
+        assert_eq!(Some(a.clone()), cache.key("OpenAI", &request("hi").streaming()));
+        assert_ne!(Some(a.clone()), cache.key("Ollama", &request("hi")));
+        assert_ne!(Some(a), cache.key("OpenAI", &request("hello")));
+
+        // Sampling requests are not cached by default
+        assert!(cache.key("OpenAI", &CompletionRequest::quick("m", "hi")).is_none());
+    }
+
+    #[test]
+    fn test_hit_and_miss() {
+        let cache = ResponseCache::new(ResponseCacheConfig::default()).unwrap();
+        let key = cache.key("OpenAI", &request("hi")).unwrap();
+
+        assert!(cache.get(&key).is_none());
+        cache.put(&key, &response("hello"));
+        assert_eq!(cache.get(&key).unwrap().message.text(), "hello");
+
+        let stats = cache.stats();
+        assert_eq!((stats.hits, stats.misses, stats.entries), (1, 1, 1));
+    }
+
+    #[test]
+    fn test_ttl_expiry() {
+        let cache = ResponseCache::new(ResponseCacheConfig {
+            ttl_secs: 60,
+            ..Default::default()
+        })
+        .unwrap();
+        cache.insert("old", response("stale"), now_ms() - 61_000);
+        assert!(cache.get("old").is_none());
+        assert_eq!(cache.stats().entries, 0);
+    }
+
+    #[test]
+    fn test_lru_eviction() {
+        let cache = ResponseCache::new(ResponseCacheConfig {
+            max_entries: 2,
+            ..Default::default()
+        })
+        .unwrap();
+        cache.put("a", &response("a"));
+        cache.put("b", &response("b"));
+        assert!(cache.get("a").is_some()); // b is now least recently used
+        cache.put("c", &response("c"));
+
+        assert!(cache.get("b").is_none());
+        assert!(cache.get("a").is_some());
+        assert!(cache.get("c").is_some());
+        assert_eq!(cache.stats().evictions, 1);
+    }
+
+    #[test]
+    fn test_byte_cap() {
+        let one = serde_json::to_vec(&DiskEntry {
+            stored_at_ms: now_ms(),
+            response: response("x"),
+        })
+        .unwrap()
+        .len();
+        let cache = ResponseCache::new(ResponseCacheConfig {
+            max_bytes: one * 2 + one / 2,
+            ..Default::default()
+        })
+        .unwrap();
+        for key in ["a", "b", "c"] {
+            cache.put(key, &response("x"));
+        }
+        let stats = cache.stats();
+        assert_eq!(stats.entries, 2);
+        assert!(stats.bytes <= one * 2 + one / 2);
+    }
+
+    #[test]
+    fn test_disk_tier_survives_restart() {
+        let dir = temp_dir("restart");
+        let config = ResponseCacheConfig {
+            dir: Some(dir.clone()),
+            ..Default::default()
+        };
+
+        let cache = ResponseCache::new(config.clone()).unwrap();
+        let key = cache.key("OpenAI", &request("hi")).unwrap();
+        cache.put(&key, &response("persisted"));
+        drop(cache);
+
+        let cache = ResponseCache::new(config).unwrap();
+        assert_eq!(cache.stats().entries, 1);
+        assert_eq!(cache.get(&key).unwrap().message.text(), "persisted");
+        assert_eq!(cache.stats().disk_hits, 1);
+
+        cache.clear();
+        assert_eq!(std::fs::read_dir(&dir).unwrap().count(), 0);
+        let _ = std::fs::remove_dir_all(&dir);
+    }
+}
@@ -0,0 +1,679 @@
+//! Asynchronous request dispatcher
+//!
+//! <impl>
+//! WHAT: Submit completions without blocking and collect results by request ID
+//! WHY: Rerankers fire several prompts at once; C/C++ callers should not need
+//!      their own thread pool to keep a provider busy
+//! HOW: Tokio tasks gated by a per-provider semaphore; identical in-flight
+//!      requests share one provider call; for batching providers, requests
+//!      with the same batch key arriving within a short window go out as one
+//!      upstream call holding one permit
+//! TEST: Concurrency limit, coalescing, micro-batching, poll and callback delivery
+//! </impl>
+
+use std::cell::Cell;
+use std::collections::{HashMap, VecDeque};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use parking_lot::{Condvar, Mutex, RwLock};
+use serde::{Deserialize, Serialize};
+use tokio::runtime::Handle;
+use tokio::sync::Semaphore;
+
+use crate::error::{LlmError, Result};
+use crate::message::CompletionResponse;
+use crate::provider::{CompletionRequest, LlmProvider};
+
+/// Dispatcher configuration
+#[derive(Debug, Clone, Serialize, Deserialize)]
+pub struct DispatchConfig {
+    /// Maximum upstream calls in flight (a batch is one call)
+    pub max_concurrency: usize,
+    /// Share one provider call between identical in-flight requests
+    pub coalesce: bool,
+    /// How long a batch stays open for more requests, in milliseconds
+    pub batch_window_ms: u64,
+    /// Maximum requests per batch (1 disables batching)
+    pub max_batch: usize,
+}
+
+impl Default for DispatchConfig {
+    fn default() -> Self {
+        Self {
+            max_concurrency: 4,
+            coalesce: true,
+            batch_window_ms: 2,
+            max_batch: 8,
+        }
+    }
+}
+
+/// Dispatcher statistics
+#[derive(Debug, Clone, Default, Serialize, Deserialize)]
+pub struct DispatchStats {
+    /// Requests accepted by `submit`
+    pub submitted: u64,
+    /// Requests answered by another identical request's call
+    pub coalesced: u64,
+    /// Batched calls (two or more requests) sent to a batching provider
+    pub batches: u64,
+    /// Requests whose result has been delivered
+    pub completed: u64,
+    /// Requests submitted but not yet completed
+    pub in_flight: u64,
+}
+
+/// A finished request
+///
+/// Coalesced requests share the same result.
+#[derive(Debug, Clone)]
+pub struct Completion {
+    /// ID returned by `submit`
+    pub id: u64,
+    /// Provider response or error
+    pub result: Arc<Result<CompletionResponse>>,
+}
+
+/// Completion callback, invoked on a runtime worker thread
+///
+/// The callback may call `set_callback` (or drop the dispatcher) itself.
+pub type CompletionCallback = Arc<dyn Fn(Completion) + Send + Sync>;
+
+thread_local! {
+    /// Set while this thread runs a completion callback
+    static IN_CALLBACK: Cell<bool> = const { Cell::new(false) };
+}
+
+/// Callback invocations in progress, so replacing the callback can wait them out
+#[derive(Default)]
+struct Deliveries {
+    running: usize,
+    /// Of those, invocations blocked in `set_callback` themselves
+    replacing: usize,
+}
+
+/// Ends a delivery even if the callback panics
+struct DeliveryGuard<'a> {
+    inner: &'a Inner,
+    outer: bool,
+}
+
+impl Drop for DeliveryGuard<'_> {
+    fn drop(&mut self) {
+        IN_CALLBACK.with(|c| c.set(self.outer));
+        self.inner.deliveries.lock().running -= 1;
+        self.inner.deliveries_cv.notify_all();
+    }
+}
+
+struct Pending {
+    key: String,
+    request: CompletionRequest,
+}
+
+struct OpenBatch {
+    /// Identifies this batch to its window timer
+    generation: u64,
+    items: Vec<Pending>,
+}
+
+struct Inner {
+    provider: Arc<dyn LlmProvider>,
+    config: DispatchConfig,
+    runtime: Handle,
+    permits: Arc<Semaphore>,
+    next_id: AtomicU64,
+    /// Coalescing key -> request IDs waiting on that call
+    waiters: Mutex<HashMap<String, Vec<u64>>>,
+    /// Batch key -> batch still collecting requests
+    open_batches: Mutex<HashMap<String, OpenBatch>>,
+    next_generation: AtomicU64,
+    ready: Mutex<VecDeque<Completion>>,
+    ready_cv: Condvar,
+    callback: RwLock<Option<CompletionCallback>>,
+    deliveries: Mutex<Deliveries>,
+    deliveries_cv: Condvar,
+    submitted: AtomicU64,
+    coalesced: AtomicU64,
+    batches: AtomicU64,
+    completed: AtomicU64,
+}
+
+/// Non-blocking, concurrency-limited front end for one provider
+pub struct Dispatcher {
+    inner: Arc<Inner>,
+}
+
+impl Dispatcher {
+    /// Create a dispatcher that runs provider calls on `runtime`
+    pub fn new(provider: Arc<dyn LlmProvider>, config: DispatchConfig, runtime: Handle) -> Self {
+        let permits = Arc::new(Semaphore::new(config.max_concurrency.max(1)));
+        Self {
+            inner: Arc::new(Inner {
+                provider,
+                config,
+                runtime,
+                permits,
+                next_id: AtomicU64::new(0),
+                waiters: Mutex::new(HashMap::new()),
+                open_batches: Mutex::new(HashMap::new()),
+                next_generation: AtomicU64::new(0),
+                ready: Mutex::new(VecDeque::new()),
+                ready_cv: Condvar::new(),
+                callback: RwLock::new(None),
+                deliveries: Mutex::new(Deliveries::default()),
+                deliveries_cv: Condvar::new(),
+                submitted: AtomicU64::new(0),
+                coalesced: AtomicU64::new(0),
+                batches: AtomicU64::new(0),
+                completed: AtomicU64::new(0),
+            }),
+        }
+    }
+
+    /// Deliver completions to `callback` instead of the poll queue
+    ///
+    /// Pass `None` to go back to polling. Returns once no other thread is
+    /// still running the previous callback.
+    pub fn set_callback(&self, callback: Option<CompletionCallback>) {
+        self.inner.replace_callback(callback);
+    }
+
+    /// Submit a request; returns its ID immediately
+    pub fn submit(&self, request: CompletionRequest) -> u64 {
+        let inner = &self.inner;
+        let id = inner.next_id.fetch_add(1, Ordering::Relaxed) + 1;
+        inner.submitted.fetch_add(1, Ordering::Relaxed);
+
+        let key = if inner.config.coalesce {
+            serde_json::to_string(&request).unwrap_or_else(|_| format!("#{}", id))
+        } else {
+            format!("#{}", id)
+        };
+
+        {
+            let mut waiters = inner.waiters.lock();
+            if let Some(ids) = waiters.get_mut(&key) {
+                ids.push(id);
+                inner.coalesced.fetch_add(1, Ordering::Relaxed);
+                return id;
+            }
+            waiters.insert(key.clone(), vec![id]);
+        }
+
+        if inner.max_batch() > 1 && inner.provider.supports_batching() {
+            Inner::enqueue_batch(inner, Pending { key, request });
+        } else {
+            let inner = inner.clone();
+            self.inner.runtime.spawn(async move {
+                let _permit = inner.permits.clone().acquire_owned().await;
+                let result = inner.provider.complete(request).await;
+                inner.finish(&key, result);
+            });
+        }
+        id
+    }
+
+    /// Wait up to `timeout` for the next completion
+    pub fn poll(&self, timeout: Duration) -> Option<Completion> {
+        let deadline = Instant::now() + timeout;
+        let mut ready = self.inner.ready.lock();
+        while ready.is_empty() {
+            if self.inner.ready_cv.wait_until(&mut ready, deadline).timed_out() {
+                break;
+            }
+        }
+        ready.pop_front()
+    }
+
+    /// Dispatcher statistics
+    pub fn stats(&self) -> DispatchStats {
+        let inner = &self.inner;
+        DispatchStats {
+            submitted: inner.submitted.load(Ordering::Relaxed),
+            coalesced: inner.coalesced.load(Ordering::Relaxed),
+            batches: inner.batches.load(Ordering::Relaxed),
+            completed: inner.completed.load(Ordering::Relaxed),
+            in_flight: inner.waiters.lock().values().map(|ids| ids.len() as u64).sum(),
+        }
+    }
+}
+
+impl Drop for Dispatcher {
+    fn drop(&mut self) {
+        // Calls still in flight finish into the (dropped) queue, never a stale callback
+        self.inner.replace_callback(None);
+    }
+}
+
+impl Inner {
+    /// Batch size limit
+    fn max_batch(&self) -> usize {
+        self.config.max_batch.max(1)
+    }
+
+    fn enqueue_batch(this: &Arc<Self>, pending: Pending) {
+        let batch_key = pending.request.batch_key();
+        let mut open = this.open_batches.lock();
+        let batch = open.entry(batch_key.clone()).or_insert_with(|| OpenBatch {
+            generation: this.next_generation.fetch_add(1, Ordering::Relaxed),
+            items: Vec::new(),
+        });
+        batch.items.push(pending);
+
+        if batch.items.len() >= this.max_batch() {
+            let items = open.remove(&batch_key).map(|b| b.items).unwrap_or_default();
+            drop(open);
+            this.runtime.spawn(Self::run_batch(this.clone(), items));
+        } else if batch.items.len() == 1 {
+            // First request opens the window
+            let generation = batch.generation;
+            let inner = this.clone();
+            let window = Duration::from_millis(this.config.batch_window_ms);
+            this.runtime.spawn(async move {
+                tokio::time::sleep(window).await;
+                let items = {
+                    let mut open = inner.open_batches.lock();
+                    if open.get(&batch_key).map(|b| b.generation) != Some(generation) {
+                        return;
+                    }
+                    open.remove(&batch_key).map(|b| b.items).unwrap_or_default()
+                };
+                Self::run_batch(inner, items).await;
+            });
+        }
+    }
+
+    async fn run_batch(this: Arc<Self>, mut items: Vec<Pending>) {
+        // One upstream call either way, so one permit
+        let _permit = this.permits.clone().acquire_owned().await;
+        if items.len() == 1 {
+            let pending = items.pop().unwrap();
+            let result = this.provider.complete(pending.request).await;
+            this.finish(&pending.key, result);
+            return;
+        }
+        if items.is_empty() {
+            return;
+        }
+        this.batches.fetch_add(1, Ordering::Relaxed);
+
+        let (keys, requests): (Vec<String>, Vec<CompletionRequest>) =
+            items.into_iter().map(|p| (p.key, p.request)).unzip();
+        let mut results = this.provider.complete_batch(requests).await.into_iter();
+
+        for key in keys {
+            let result = results
+                .next()
+                .unwrap_or_else(|| Err(LlmError::Provider("Batch returned too few results".to_string())));
+            this.finish(&key, result);
+        }
+    }
+
+    /// Swap the callback, then wait for deliveries through the old one
+    ///
+    /// The callback runs without the lock held, so it can replace itself; a
+    /// call from inside a callback only waits for the other threads.
+    fn replace_callback(&self, callback: Option<CompletionCallback>) {
+        let old = std::mem::replace(&mut *self.callback.write(), callback);
+
+        let reentrant = IN_CALLBACK.with(|c| c.get());
+        let mut deliveries = self.deliveries.lock();
+        if reentrant {
+            deliveries.replacing += 1;
+            self.deliveries_cv.notify_all();
+        }
+        while deliveries.running > deliveries.replacing {
+            self.deliveries_cv.wait(&mut deliveries);
+        }
+        if reentrant {
+            deliveries.replacing -= 1;
+        }
+        drop(deliveries);
+        drop(old);
+    }
+
+    fn finish(&self, key: &str, result: Result<CompletionResponse>) {
+        let ids = self.waiters.lock().remove(key).unwrap_or_default();
+        let result = Arc::new(result);
+        self.completed.fetch_add(ids.len() as u64, Ordering::Relaxed);
+
+        // Counted under the read lock, so replace_callback sees every delivery of the old callback
+        let callback = {
+            let callback = self.callback.read();
+            if callback.is_some() {
+                self.deliveries.lock().running += 1;
+            }
+            callback.clone()
+        };
+        match callback {
+            Some(cb) => {
+                let _delivery = DeliveryGuard {
+                    inner: self,
+                    outer: IN_CALLBACK.with(|c| c.replace(true)),
+                };
+                for id in ids {
+                    cb(Completion { id, result: result.clone() });
+                }
+            }
+            None => {
+                let mut ready = self.ready.lock();
+                ready.extend(ids.into_iter().map(|id| Completion { id, result: result.clone() }));
+                self.ready_cv.notify_all();
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::message::{Message, Usage};
+    use crate::provider::{CompletionStream, ModelInfo, ProviderInfo};
+    use async_trait::async_trait;
+    use std::sync::atomic::AtomicUsize;
+    use tokio::runtime::Runtime;
+
+    struct MockProvider {
+        info: ProviderInfo,
+        batching: bool,
+        delay: Duration,
+        calls: AtomicUsize,
+        batch_calls: AtomicUsize,
+        batch_sizes: Mutex<Vec<usize>>,
+        active: AtomicUsize,
+        max_active: AtomicUsize,
+    }
+
+    impl MockProvider {
+        async fn upstream_call(&self) {
+            let now = self.active.fetch_add(1, Ordering::SeqCst) + 1;
+            self.max_active.fetch_max(now, Ordering::SeqCst);
+            tokio::time::sleep(self.delay).await;
+            self.active.fetch_sub(1, Ordering::SeqCst);
+        }
+
+        fn echo(request: CompletionRequest) -> CompletionResponse {
+            let text = request.messages.last().map(|m| m.text()).unwrap_or_default();
+            CompletionResponse {
+                message: Message::assistant(text),
+                usage: Usage::new(1, 1),
+                model: request.model,
+                finish_reason: crate::message::FinishReason::Stop,
+                id: None,
+            }
+        }
+
+        fn new(batching: bool, delay_ms: u64) -> Arc<Self> {
+            Arc::new(Self {
+                info: ProviderInfo {
+                    name: "Mock".to_string(),
+                    version: "1".to_string(),
+                    models: vec![],
+                    base_url: String::new(),
+                    supports_streaming: false,
+                    supports_vision: false,
+                    supports_tools: false,
+                },
+                batching,
+                delay: Duration::from_millis(delay_ms),
+                calls: AtomicUsize::new(0),
+                batch_calls: AtomicUsize::new(0),
+                batch_sizes: Mutex::new(Vec::new()),
+                active: AtomicUsize::new(0),
+                max_active: AtomicUsize::new(0),
+            })
+        }
+    }
+
+    #[async_trait]
+    impl LlmProvider for MockProvider {
+        fn info(&self) -> &ProviderInfo {
+            &self.info
+        }
+
+        async fn complete(&self, request: CompletionRequest) -> Result<CompletionResponse> {
+            self.calls.fetch_add(1, Ordering::SeqCst);
+            self.upstream_call().await;
+            Ok(MockProvider::echo(request))
+        }
+
+        /// One upstream call for the whole batch, like a prompt list
+        async fn complete_batch(&self, requests: Vec<CompletionRequest>) -> Vec<Result<CompletionResponse>> {
+            self.batch_calls.fetch_add(1, Ordering::SeqCst);
+            self.batch_sizes.lock().push(requests.len());
+            self.upstream_call().await;
+            requests.into_iter().map(|r| Ok(MockProvider::echo(r))).collect()
+        }
+
+        async fn complete_stream(&self, _request: CompletionRequest) -> Result<CompletionStream> {
+            Err(LlmError::Provider("not supported".to_string()))
+        }
+
+        async fn list_models(&self) -> Result<Vec<ModelInfo>> {
+            Ok(vec![])
+        }
+
+        async fn health_check(&self) -> Result<bool> {
+            Ok(true)
+        }
+
+        fn supports_batching(&self) -> bool {
+            self.batching
+        }
+    }
+
+    fn drain(dispatcher: &Dispatcher, count: usize) -> Vec<Completion> {
+        (0..count)
+            .map(|_| dispatcher.poll(Duration::from_secs(5)).expect("completion"))
+            .collect()
+    }
+
+    #[test]
+    fn test_concurrency_limit() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(false, 20);
+        let config = DispatchConfig {
+            max_concurrency: 3,
+            ..Default::default()
+        };
+        let dispatcher = Dispatcher::new(provider.clone(), config, rt.handle().clone());
+
+        let ids: Vec<u64> = (0..10)
+            .map(|i| dispatcher.submit(CompletionRequest::quick("m", format!("prompt {}", i))))
+            .collect();
+        let mut done: Vec<u64> = drain(&dispatcher, 10).iter().map(|c| c.id).collect();
+        done.sort();
+
+        assert_eq!(done, ids);
+        assert_eq!(provider.calls.load(Ordering::SeqCst), 10);
+        assert_eq!(provider.max_active.load(Ordering::SeqCst), 3);
+        assert_eq!(dispatcher.stats().in_flight, 0);
+    }
+
+    #[test]
+    fn test_identical_requests_coalesce() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(false, 20);
+        let dispatcher = Dispatcher::new(provider.clone(), DispatchConfig::default(), rt.handle().clone());
+
+        for _ in 0..5 {
+            dispatcher.submit(CompletionRequest::quick("m", "same prompt"));
+        }
+        let done = drain(&dispatcher, 5);
+
+        assert_eq!(provider.calls.load(Ordering::SeqCst), 1);
+        assert!(done.iter().all(|c| c.result.as_ref().as_ref().unwrap().message.text() == "same prompt"));
+        let stats = dispatcher.stats();
+        assert_eq!(stats.coalesced, 4);
+        assert_eq!(stats.completed, 5);
+    }
+
+    #[test]
+    fn test_coalescing_disabled() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(false, 5);
+        let config = DispatchConfig {
+            coalesce: false,
+            ..Default::default()
+        };
+        let dispatcher = Dispatcher::new(provider.clone(), config, rt.handle().clone());
+
+        for _ in 0..3 {
+            dispatcher.submit(CompletionRequest::quick("m", "same prompt"));
+        }
+        drain(&dispatcher, 3);
+        assert_eq!(provider.calls.load(Ordering::SeqCst), 3);
+    }
+
+    #[test]
+    fn test_micro_batching() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(true, 5);
+        let config = DispatchConfig {
+            max_concurrency: 4,
+            batch_window_ms: 20,
+            max_batch: 4,
+            ..Default::default()
+        };
+        let dispatcher = Dispatcher::new(provider.clone(), config, rt.handle().clone());
+
+        let ids: Vec<u64> = (0..6)
+            .map(|i| dispatcher.submit(CompletionRequest::quick("m", format!("prompt {}", i))))
+            .collect();
+        let done = drain(&dispatcher, 6);
+        for c in &done {
+            let i = ids.iter().position(|id| *id == c.id).unwrap();
+            assert_eq!(c.result.as_ref().as_ref().unwrap().message.text(), format!("prompt {}", i));
+        }
+
+        // A full batch of 4 goes out at once, the other 2 when the window closes
+        assert_eq!(dispatcher.stats().batches, 2);
+        assert_eq!(provider.batch_calls.load(Ordering::SeqCst), 2);
+        assert_eq!(provider.calls.load(Ordering::SeqCst), 0);
+        let mut sizes = provider.batch_sizes.lock().clone();
+        sizes.sort();
+        assert_eq!(sizes, vec![2, 4]);
+    }
+
+    #[test]
+    fn test_batch_larger_than_permits() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(true, 10);
+        let config = DispatchConfig {
+            max_concurrency: 1,
+            batch_window_ms: 5,
+            max_batch: 8,
+            ..Default::default()
+        };
+        let dispatcher = Dispatcher::new(provider.clone(), config, rt.handle().clone());
+
+        for i in 0..9 {
+            dispatcher.submit(CompletionRequest::quick("m", format!("prompt {}", i)));
+        }
+        drain(&dispatcher, 9);
+
+        // One permit per upstream call: the batch of 8 runs, the straggler goes out alone
+        assert_eq!(dispatcher.stats().batches, 1);
+        assert_eq!(provider.batch_calls.load(Ordering::SeqCst), 1);
+        assert_eq!(provider.calls.load(Ordering::SeqCst), 1);
+        assert_eq!(provider.max_active.load(Ordering::SeqCst), 1);
+    }
+
+    #[test]
+    fn test_batches_split_by_batch_key() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(true, 5);
+        let config = DispatchConfig {
+            batch_window_ms: 20,
+            ..Default::default()
+        };
+        let dispatcher = Dispatcher::new(provider.clone(), config, rt.handle().clone());
+
+        for i in 0..3 {
+            dispatcher.submit(CompletionRequest::quick("a", format!("prompt {}", i)));
+            dispatcher.submit(CompletionRequest::quick("b", format!("prompt {}", i)));
+        }
+        dispatcher.submit(CompletionRequest::quick("a", "hot").temperature(0.9));
+        drain(&dispatcher, 7);
+
+        // Models and sampling parameters never share a call
+        assert_eq!(provider.batch_calls.load(Ordering::SeqCst), 2);
+        assert_eq!(provider.calls.load(Ordering::SeqCst), 1);
+        assert_eq!(*provider.batch_sizes.lock(), vec![3, 3]);
+    }
+
+    #[test]
+    fn test_callback_delivery() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(false, 1);
+        let dispatcher = Dispatcher::new(provider, DispatchConfig::default(), rt.handle().clone());
+
+        let (tx, rx) = std::sync::mpsc::channel();
+        let tx = Mutex::new(tx);
+        dispatcher.set_callback(Some(Arc::new(move |c: Completion| {
+            let _ = tx.lock().send(c.id);
+        })));
+
+        let id = dispatcher.submit(CompletionRequest::quick("m", "hi"));
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap(), id);
+        assert!(dispatcher.poll(Duration::ZERO).is_none());
+    }
+
+    #[test]
+    fn test_callback_can_replace_itself() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(false, 1);
+        let dispatcher = Arc::new(Dispatcher::new(provider, DispatchConfig::default(), rt.handle().clone()));
+
+        // The callback switches the dispatcher back to polling from inside the call
+        let (tx, rx) = std::sync::mpsc::channel();
+        let tx = Mutex::new(tx);
+        let weak = Arc::downgrade(&dispatcher);
+        dispatcher.set_callback(Some(Arc::new(move |c: Completion| {
+            if let Some(d) = weak.upgrade() {
+                d.set_callback(None);
+            }
+            let _ = tx.lock().send(c.id);
+        })));
+
+        let first = dispatcher.submit(CompletionRequest::quick("m", "one"));
+        assert_eq!(rx.recv_timeout(Duration::from_secs(5)).unwrap(), first);
+        let second = dispatcher.submit(CompletionRequest::quick("m", "two"));
+        assert_eq!(dispatcher.poll(Duration::from_secs(5)).unwrap().id, second);
+    }
+
+    #[test]
+    fn test_set_callback_waits_for_running_callback() {
+        let rt = Runtime::new().unwrap();
+        let provider = MockProvider::new(false, 1);
+        let dispatcher = Dispatcher::new(provider, DispatchConfig::default(), rt.handle().clone());
+
+        let running = Arc::new(AtomicUsize::new(0));
+        let (entered_tx, entered_rx) = std::sync::mpsc::channel();
+        let entered_tx = Mutex::new(entered_tx);
+        let state = running.clone();
+        dispatcher.set_callback(Some(Arc::new(move |_c: Completion| {
+            state.fetch_add(1, Ordering::SeqCst);
+            let _ = entered_tx.lock().send(());
+            std::thread::sleep(Duration::from_millis(50));
+            state.fetch_sub(1, Ordering::SeqCst);
+        })));
+
+        dispatcher.submit(CompletionRequest::quick("m", "hi"));
+        entered_rx.recv_timeout(Duration::from_secs(5)).unwrap();
+        dispatcher.set_callback(None);
+        assert_eq!(running.load(Ordering::SeqCst), 0, "old callback still running after set_callback returned");
+    }
+
+    #[test]
+    fn test_poll_timeout() {
+        let rt = Runtime::new().unwrap();
+        let dispatcher = Dispatcher::new(MockProvider::new(false, 1), DispatchConfig::default(), rt.handle().clone());
+        let start = Instant::now();
+        assert!(dispatcher.poll(Duration::from_millis(20)).is_none());
+        assert!(start.elapsed() >= Duration::from_millis(20));
+    }
+}
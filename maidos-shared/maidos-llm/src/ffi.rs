@@ -3,23 +3,31 @@
 //! <impl>
 //! WHAT: C-compatible FFI for P/Invoke from C#/.NET
 //! WHY: Cross-language integration with MAIDOS applications
-//! HOW: Blocking wrappers around async API, opaque pointers
-//! TEST: FFI handle creation, completion, cleanup
+//! HOW: Blocking wrappers around async API, opaque pointers; streaming via
+//!      per-chunk callback or a pollable stream handle; async submission via
+//!      a dispatcher with request IDs; optional response cache wraps the provider
+//! TEST: FFI handle creation, completion, streaming against a local SSE server, cache, cleanup
 //! </impl>
 
+use crate::cache::{CachedProvider, ResponseCache, ResponseCacheConfig};
+use crate::dispatch::{Completion, DispatchConfig, Dispatcher};
 use crate::error::LlmError;
-use crate::message::Message;
+use crate::message::{CompletionResponse, Message, Usage};
 use crate::provider::{CompletionRequest, LlmProvider};
 use crate::providers::{create_provider, ProviderType};
-use std::ffi::{c_char, CStr, CString};
+use futures::StreamExt;
+use std::ffi::{c_char, c_void, CStr, CString};
 use std::ptr;
-use std::sync::Arc;
+use std::sync::{mpsc, Arc};
+use std::time::Duration;
 use tokio::runtime::Runtime;
+use tokio::task::JoinHandle;
 
 /// Opaque LLM handle
 pub struct LlmHandle {
     provider: Arc<dyn LlmProvider>,
     runtime: Runtime,
+    cache: Option<Arc<ResponseCache>>,
 }
 
 /// FFI error codes for detailed error handling
@@ -47,6 +55,8 @@ pub enum FfiErrorCode {
     BudgetExceeded = 9,
     /// Parse error
     ParseError = 10,
+    /// Cancelled by the caller (streaming)
+    Cancelled = 11,
     /// Unknown error
     Unknown = 99,
 }
@@ -140,6 +150,67 @@ pub struct FfiCompletionResult {
     pub model: *mut c_char,
 }
 
+impl FfiCompletionResult {
+    fn ok(text: &str, model: &str, prompt_tokens: u32, completion_tokens: u32) -> *mut Self {
+        Box::into_raw(Box::new(Self {
+            success: true,
+            text: CString::new(text).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
+            error: ptr::null_mut(),
+            error_details: FfiErrorDetails::null(),
+            prompt_tokens,
+            completion_tokens,
+            model: CString::new(model).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
+        }))
+    }
+
+    fn invalid(msg: &str) -> *mut Self {
+        Self::failed(msg, FfiErrorCode::InvalidArguments, "InvalidArguments")
+    }
+
+    fn failed(msg: &str, code: FfiErrorCode, error_type: &str) -> *mut Self {
+        Box::into_raw(Box::new(Self {
+            success: false,
+            text: ptr::null_mut(),
+            error: CString::new(msg).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
+            error_details: FfiErrorDetails {
+                code,
+                error_type: CString::new(error_type).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
+                message: CString::new(msg).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
+                suggestion: ptr::null_mut(),
+                retry_after_secs: 0,
+                is_capability_error: false,
+            },
+            prompt_tokens: 0,
+            completion_tokens: 0,
+            model: ptr::null_mut(),
+        }))
+    }
+
+    fn from_result(result: &crate::error::Result<CompletionResponse>) -> *mut Self {
+        match result {
+            Ok(response) => Self::ok(
+                &response.message.text(),
+                &response.model,
+                response.usage.prompt_tokens,
+                response.usage.completion_tokens,
+            ),
+            Err(e) => Self::from_llm_error(e),
+        }
+    }
+
+    fn from_llm_error(e: &LlmError) -> *mut Self {
+        Box::into_raw(Box::new(Self {
+            success: false,
+            text: ptr::null_mut(),
+            error: CString::new(e.to_string()).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
+            error_details: FfiErrorDetails::from_llm_error(e),
+            prompt_tokens: 0,
+            completion_tokens: 0,
+            model: ptr::null_mut(),
+        }))
+    }
+}
+
 // ============================================================================
 // Provider Management
 // ============================================================================
@@ -198,7 +269,11 @@ pub unsafe extern "C" fn maidos_llm_create(
         Err(_) => return ptr::null_mut(),
     };
 
-    Box::into_raw(Box::new(LlmHandle { provider, runtime }))
+    Box::into_raw(Box::new(LlmHandle {
+        provider,
+        runtime,
+        cache: None,
+    }))
 }
 
 /// Get provider name
@@ -261,52 +336,37 @@ pub unsafe extern "C" fn maidos_llm_complete(
     max_tokens: u32,
     temperature: f32,
 ) -> *mut FfiCompletionResult {
-    let make_error = |msg: &str| -> *mut FfiCompletionResult {
-        Box::into_raw(Box::new(FfiCompletionResult {
-            success: false,
-            text: ptr::null_mut(),
-            error: CString::new(msg).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
-            error_details: FfiErrorDetails {
-                code: FfiErrorCode::InvalidArguments,
-                error_type: CString::new("InvalidArguments").map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
-                message: CString::new(msg).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
-                suggestion: ptr::null_mut(),
-                retry_after_secs: 0,
-                is_capability_error: false,
-            },
-            prompt_tokens: 0,
-            completion_tokens: 0,
-            model: ptr::null_mut(),
-        }))
-    };
-
-    let make_llm_error = |e: &LlmError| -> *mut FfiCompletionResult {
-        Box::into_raw(Box::new(FfiCompletionResult {
-            success: false,
-            text: ptr::null_mut(),
-            error: CString::new(e.to_string()).map(|s| s.into_raw()).unwrap_or(ptr::null_mut()),
-            error_details: FfiErrorDetails::from_llm_error(e),
-            prompt_tokens: 0,
-            completion_tokens: 0,
-            model: ptr::null_mut(),
-        }))
-    };
-
-    if handle.is_null() || model.is_null() || user_message.is_null() {
-        return make_error("Invalid arguments");
+    if handle.is_null() {
+        return FfiCompletionResult::invalid("Invalid arguments");
     }
 
     let h = &*handle;
-
-    let model_str = match CStr::from_ptr(model).to_str() {
-        Ok(s) => s,
-        Err(_) => return make_error("Invalid model string"),
+    let request = match build_request(model, system, user_message, max_tokens, temperature) {
+        Ok(r) => r,
+        Err(msg) => return FfiCompletionResult::invalid(msg),
     };
 
-    let user_str = match CStr::from_ptr(user_message).to_str() {
-        Ok(s) => s,
-        Err(_) => return make_error("Invalid message string"),
-    };
+    FfiCompletionResult::from_result(&h.runtime.block_on(h.provider.complete(request)))
+}
+
+/// Build a single-turn request from FFI arguments
+unsafe fn build_request(
+    model: *const c_char,
+    system: *const c_char,
+    user_message: *const c_char,
+    max_tokens: u32,
+    temperature: f32,
+) -> std::result::Result<CompletionRequest, &'static str> {
+    if model.is_null() || user_message.is_null() {
+        return Err("Invalid arguments");
+    }
+
+    let model_str = CStr::from_ptr(model)
+        .to_str()
+        .map_err(|_| "Invalid model string")?;
+    let user_str = CStr::from_ptr(user_message)
+        .to_str()
+        .map_err(|_| "Invalid message string")?;
 
     let mut request = CompletionRequest::new(model_str).message(Message::user(user_str));
 
@@ -324,27 +384,658 @@ pub unsafe extern "C" fn maidos_llm_complete(
         request = request.temperature(temperature);
     }
 
-    match h.runtime.block_on(h.provider.complete(request)) {
-        Ok(response) => {
-            let text = CString::new(response.message.text())
-                .map(|s| s.into_raw())
-                .unwrap_or(ptr::null_mut());
+    Ok(request)
+}
 
-            let model_str = CString::new(response.model)
-                .map(|s| s.into_raw())
-                .unwrap_or(ptr::null_mut());
+// ============================================================================
+// Streaming
+// ============================================================================
+
+/// Streaming chunk callback
+///
+/// Called with each text delta (UTF-8, valid only during the call). The last
+/// call has `is_final = true`. Return `false` to cancel the stream.
+pub type MaidosLlmStreamCallback =
+    Option<unsafe extern "C" fn(delta: *const c_char, is_final: bool, user_data: *mut c_void) -> bool>;
+
+unsafe fn deliver_chunk(
+    callback: MaidosLlmStreamCallback,
+    delta: &str,
+    is_final: bool,
+    user_data: *mut c_void,
+) -> bool {
+    match callback {
+        Some(cb) => {
+            let delta = CString::new(delta).unwrap_or_default();
+            cb(delta.as_ptr(), is_final, user_data)
+        }
+        None => true,
+    }
+}
+
+enum StreamOutcome {
+    Done(String, Option<Usage>),
+    Cancelled,
+}
+
+/// Complete a chat request, delivering tokens to `callback` as they arrive
+///
+/// Blocks until the stream finishes or the callback returns `false`. The
+/// returned result carries the full text on success, or
+/// `FfiErrorCode::Cancelled` if the callback stopped the stream (the
+/// connection is closed immediately).
+///
+/// # Returns
+/// Completion result (must be freed with maidos_llm_result_free)
+///
+/// # Safety
+/// All pointers must be valid or null where allowed; `user_data` is passed
+/// back to `callback` unchanged
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_complete_stream(
+    handle: *mut LlmHandle,
+    model: *const c_char,
+    system: *const c_char,
+    user_message: *const c_char,
+    max_tokens: u32,
+    temperature: f32,
+    callback: MaidosLlmStreamCallback,
+    user_data: *mut c_void,
+) -> *mut FfiCompletionResult {
+    if handle.is_null() {
+        return FfiCompletionResult::invalid("Invalid arguments");
+    }
+
+    let h = &*handle;
+    let request = match build_request(model, system, user_message, max_tokens, temperature) {
+        Ok(r) => r.streaming(),
+        Err(msg) => return FfiCompletionResult::invalid(msg),
+    };
+    let model_name = request.model.clone();
+
+    let outcome = h.runtime.block_on(async {
+        let mut stream = h.provider.complete_stream(request).await?;
+        let mut text = String::new();
+        let mut usage = None;
+
+        while let Some(chunk) = stream.next().await {
+            let chunk = chunk?;
+            text.push_str(&chunk.delta);
+            if chunk.usage.is_some() {
+                usage = chunk.usage.clone();
+            }
+            if chunk.delta.is_empty() && !chunk.is_final {
+                continue;
+            }
+            let keep_going = deliver_chunk(callback, &chunk.delta, chunk.is_final, user_data);
+            if chunk.is_final {
+                return Ok(StreamOutcome::Done(text, usage));
+            }
+            if !keep_going {
+                return Ok(StreamOutcome::Cancelled);
+            }
+        }
+
+        // Connection closed without an explicit final event
+        deliver_chunk(callback, "", true, user_data);
+        Ok::<_, LlmError>(StreamOutcome::Done(text, usage))
+    });
+
+    match outcome {
+        Ok(StreamOutcome::Done(text, usage)) => {
+            let usage = usage.unwrap_or_default();
+            FfiCompletionResult::ok(&text, &model_name, usage.prompt_tokens, usage.completion_tokens)
+        }
+        Ok(StreamOutcome::Cancelled) => {
+            FfiCompletionResult::failed("Stream cancelled", FfiErrorCode::Cancelled, "Cancelled")
+        }
+        Err(e) => FfiCompletionResult::from_llm_error(&e),
+    }
+}
+
+/// Poll status for `maidos_llm_stream_next`
+#[repr(C)]
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum FfiStreamStatus {
+    /// A delta was written to `out_delta`
+    Chunk = 0,
+    /// No chunk within the timeout
+    Pending = 1,
+    /// Stream finished normally
+    Done = 2,
+    /// Stream was cancelled
+    Cancelled = 3,
+    /// Stream failed (see `maidos_llm_stream_result`)
+    Error = 4,
+}
+
+enum StreamEvent {
+    Chunk(String),
+    Done(Option<Usage>),
+    Failed(LlmError),
+}
 
-            Box::into_raw(Box::new(FfiCompletionResult {
-                success: true,
-                text,
-                error: ptr::null_mut(),
-                error_details: FfiErrorDetails::null(),
-                prompt_tokens: response.usage.prompt_tokens,
-                completion_tokens: response.usage.completion_tokens,
-                model: model_str,
-            }))
+/// Opaque pollable stream handle
+pub struct LlmStreamHandle {
+    events: mpsc::Receiver<StreamEvent>,
+    task: JoinHandle<()>,
+    model: String,
+    text: String,
+    usage: Option<Usage>,
+    error: Option<LlmError>,
+    status: FfiStreamStatus,
+}
+
+impl LlmStreamHandle {
+    fn is_finished(&self) -> bool {
+        !matches!(self.status, FfiStreamStatus::Chunk | FfiStreamStatus::Pending)
+    }
+}
+
+/// Start a streaming completion on the provider's runtime
+///
+/// # Returns
+/// Stream handle (free with maidos_llm_stream_free), or null on invalid arguments
+///
+/// # Safety
+/// All pointers must be valid or null where allowed. The stream must be
+/// freed before the provider handle is destroyed.
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_stream_start(
+    handle: *mut LlmHandle,
+    model: *const c_char,
+    system: *const c_char,
+    user_message: *const c_char,
+    max_tokens: u32,
+    temperature: f32,
+) -> *mut LlmStreamHandle {
+    if handle.is_null() {
+        return ptr::null_mut();
+    }
+
+    let h = &*handle;
+    let request = match build_request(model, system, user_message, max_tokens, temperature) {
+        Ok(r) => r.streaming(),
+        Err(_) => return ptr::null_mut(),
+    };
+    let model_name = request.model.clone();
+    let provider = h.provider.clone();
+    let (tx, rx) = mpsc::channel();
+
+    let task = h.runtime.spawn(async move {
+        let mut stream = match provider.complete_stream(request).await {
+            Ok(s) => s,
+            Err(e) => {
+                let _ = tx.send(StreamEvent::Failed(e));
+                return;
+            }
+        };
+
+        loop {
+            let event = match stream.next().await {
+                Some(Ok(chunk)) if chunk.is_final => {
+                    if !chunk.delta.is_empty() && tx.send(StreamEvent::Chunk(chunk.delta)).is_err() {
+                        return;
+                    }
+                    StreamEvent::Done(chunk.usage)
+                }
+                Some(Ok(chunk)) => {
+                    if chunk.delta.is_empty() {
+                        continue;
+                    }
+                    StreamEvent::Chunk(chunk.delta)
+                }
+                Some(Err(e)) => StreamEvent::Failed(e),
+                None => StreamEvent::Done(None),
+            };
+            let last = !matches!(event, StreamEvent::Chunk(_));
+            if tx.send(event).is_err() || last {
+                return;
+            }
         }
-        Err(e) => make_llm_error(&e),
+    });
+
+    Box::into_raw(Box::new(LlmStreamHandle {
+        events: rx,
+        task,
+        model: model_name,
+        text: String::new(),
+        usage: None,
+        error: None,
+        status: FfiStreamStatus::Pending,
+    }))
+}
+
+/// Wait up to `timeout_ms` for the next chunk
+///
+/// On `Chunk`, `*out_delta` receives the delta (free with maidos_llm_string_free).
+/// Once `Done`, `Cancelled` or `Error` is returned, every later call returns it too.
+///
+/// # Safety
+/// Stream must be valid; `out_delta` must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_stream_next(
+    stream: *mut LlmStreamHandle,
+    timeout_ms: u32,
+    out_delta: *mut *mut c_char,
+) -> FfiStreamStatus {
+    if !out_delta.is_null() {
+        *out_delta = ptr::null_mut();
+    }
+    if stream.is_null() {
+        return FfiStreamStatus::Error;
+    }
+
+    let s = &mut *stream;
+    if s.is_finished() {
+        return s.status;
+    }
+
+    let event = if timeout_ms == 0 {
+        s.events.try_recv().map_err(|e| matches!(e, mpsc::TryRecvError::Disconnected))
+    } else {
+        s.events
+            .recv_timeout(Duration::from_millis(timeout_ms as u64))
+            .map_err(|e| matches!(e, mpsc::RecvTimeoutError::Disconnected))
+    };
+
+    s.status = match event {
+        Ok(StreamEvent::Chunk(delta)) => {
+            s.text.push_str(&delta);
+            if !out_delta.is_null() {
+                *out_delta = CString::new(delta).map(|c| c.into_raw()).unwrap_or(ptr::null_mut());
+            }
+            FfiStreamStatus::Chunk
+        }
+        Ok(StreamEvent::Done(usage)) => {
+            s.usage = usage;
+            FfiStreamStatus::Done
+        }
+        Ok(StreamEvent::Failed(e)) => {
+            s.error = Some(e);
+            FfiStreamStatus::Error
+        }
+        Err(false) => FfiStreamStatus::Pending,
+        Err(true) => {
+            s.error = Some(LlmError::Provider("Stream task stopped".to_string()));
+            FfiStreamStatus::Error
+        }
+    };
+    s.status
+}
+
+/// Cancel a running stream (closes the connection)
+///
+/// # Safety
+/// Stream must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_stream_cancel(stream: *mut LlmStreamHandle) {
+    if stream.is_null() {
+        return;
+    }
+    let s = &mut *stream;
+    s.task.abort();
+    if !s.is_finished() {
+        s.status = FfiStreamStatus::Cancelled;
+    }
+}
+
+/// Get the accumulated result of a finished stream
+///
+/// # Returns
+/// Completion result with the full text (must be freed with maidos_llm_result_free)
+///
+/// # Safety
+/// Stream must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_stream_result(stream: *const LlmStreamHandle) -> *mut FfiCompletionResult {
+    if stream.is_null() {
+        return FfiCompletionResult::invalid("Invalid arguments");
+    }
+
+    let s = &*stream;
+    match s.status {
+        FfiStreamStatus::Done => {
+            let usage = s.usage.clone().unwrap_or_default();
+            FfiCompletionResult::ok(&s.text, &s.model, usage.prompt_tokens, usage.completion_tokens)
+        }
+        FfiStreamStatus::Cancelled => {
+            FfiCompletionResult::failed("Stream cancelled", FfiErrorCode::Cancelled, "Cancelled")
+        }
+        FfiStreamStatus::Error => match &s.error {
+            Some(e) => FfiCompletionResult::from_llm_error(e),
+            None => FfiCompletionResult::failed("Stream failed", FfiErrorCode::Unknown, "Unknown"),
+        },
+        _ => FfiCompletionResult::invalid("Stream still active"),
+    }
+}
+
+/// Free a stream handle (cancels it if still running)
+///
+/// # Safety
+/// Stream must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_stream_free(stream: *mut LlmStreamHandle) {
+    if !stream.is_null() {
+        let s = Box::from_raw(stream);
+        s.task.abort();
+    }
+}
+
+// ============================================================================
+// Async dispatch
+// ============================================================================
+
+/// Opaque dispatcher handle
+pub struct LlmDispatcherHandle {
+    dispatcher: Dispatcher,
+}
+
+/// Dispatcher statistics for FFI
+#[repr(C)]
+#[derive(Debug, Default)]
+pub struct FfiDispatchStats {
+    /// Requests accepted
+    pub submitted: u64,
+    /// Requests answered by an identical in-flight request
+    pub coalesced: u64,
+    /// Batches sent to a batching provider
+    pub batches: u64,
+    /// Requests completed
+    pub completed: u64,
+    /// Requests not yet completed
+    pub in_flight: u64,
+}
+
+/// Completion callback
+///
+/// `result` is only valid during the call (do not free it). Called on a
+/// runtime worker thread.
+pub type MaidosLlmCompletionCallback =
+    Option<unsafe extern "C" fn(id: u64, result: *const FfiCompletionResult, user_data: *mut c_void)>;
+
+/// Create a dispatcher for a provider
+///
+/// # Arguments
+/// * `max_concurrency` - Provider calls in flight (0 for default)
+/// * `batch_window_ms` - Batch window for batching providers (0 for default)
+/// * `max_batch` - Requests per batch (0 for default, 1 disables batching)
+///
+/// # Returns
+/// Dispatcher handle (free with maidos_llm_dispatcher_free before destroying the provider)
+///
+/// # Safety
+/// Handle must be valid
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_dispatcher_create(
+    handle: *mut LlmHandle,
+    max_concurrency: u32,
+    batch_window_ms: u32,
+    max_batch: u32,
+) -> *mut LlmDispatcherHandle {
+    if handle.is_null() {
+        return ptr::null_mut();
+    }
+
+    let h = &*handle;
+    let mut config = DispatchConfig::default();
+    if max_concurrency > 0 {
+        config.max_concurrency = max_concurrency as usize;
+    }
+    if batch_window_ms > 0 {
+        config.batch_window_ms = batch_window_ms as u64;
+    }
+    if max_batch > 0 {
+        config.max_batch = max_batch as usize;
+    }
+
+    Box::into_raw(Box::new(LlmDispatcherHandle {
+        dispatcher: Dispatcher::new(h.provider.clone(), config, h.runtime.handle().clone()),
+    }))
+}
+
+/// Deliver completions to `callback` instead of the poll queue (null to poll)
+///
+/// # Safety
+/// Dispatcher must be valid; `user_data` must stay valid until the callback
+/// is replaced or the dispatcher is freed. Both wait for callbacks running on
+/// other threads, and may be called from inside the callback
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_dispatcher_set_callback(
+    dispatcher: *mut LlmDispatcherHandle,
+    callback: MaidosLlmCompletionCallback,
+    user_data: *mut c_void,
+) {
+    if dispatcher.is_null() {
+        return;
+    }
+
+    let d = &*dispatcher;
+    let Some(cb) = callback else {
+        d.dispatcher.set_callback(None);
+        return;
+    };
+    let user_data = user_data as usize;
+    d.dispatcher.set_callback(Some(Arc::new(move |c: Completion| {
+        let result = FfiCompletionResult::from_result(&c.result);
+        cb(c.id, result, user_data as *mut c_void);
+        maidos_llm_result_free(result);
+    })));
+}
+
+/// Submit a request without blocking
+///
+/// # Returns
+/// Request ID (never 0), or 0 on invalid arguments
+///
+/// # Safety
+/// All pointers must be valid or null where allowed
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_submit(
+    dispatcher: *mut LlmDispatcherHandle,
+    model: *const c_char,
+    system: *const c_char,
+    user_message: *const c_char,
+    max_tokens: u32,
+    temperature: f32,
+) -> u64 {
+    if dispatcher.is_null() {
+        return 0;
+    }
+
+    match build_request(model, system, user_message, max_tokens, temperature) {
+        Ok(request) => (*dispatcher).dispatcher.submit(request),
+        Err(_) => 0,
+    }
+}
+
+/// Wait up to `timeout_ms` for the next completion
+///
+/// # Returns
+/// Completion result (free with maidos_llm_result_free) with its request ID
+/// in `*out_id`, or null on timeout
+///
+/// # Safety
+/// Dispatcher must be valid; `out_id` must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_poll(
+    dispatcher: *mut LlmDispatcherHandle,
+    timeout_ms: u32,
+    out_id: *mut u64,
+) -> *mut FfiCompletionResult {
+    if dispatcher.is_null() {
+        return ptr::null_mut();
+    }
+
+    match (*dispatcher).dispatcher.poll(Duration::from_millis(timeout_ms as u64)) {
+        Some(c) => {
+            if !out_id.is_null() {
+                *out_id = c.id;
+            }
+            FfiCompletionResult::from_result(&c.result)
+        }
+        None => ptr::null_mut(),
+    }
+}
+
+/// Get dispatcher statistics
+///
+/// # Safety
+/// Dispatcher and `out_stats` must be valid
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_dispatcher_stats(
+    dispatcher: *const LlmDispatcherHandle,
+    out_stats: *mut FfiDispatchStats,
+) -> bool {
+    if dispatcher.is_null() || out_stats.is_null() {
+        return false;
+    }
+
+    let stats = (*dispatcher).dispatcher.stats();
+    *out_stats = FfiDispatchStats {
+        submitted: stats.submitted,
+        coalesced: stats.coalesced,
+        batches: stats.batches,
+        completed: stats.completed,
+        in_flight: stats.in_flight,
+    };
+    true
+}
+
+/// Free a dispatcher
+///
+/// Requests still in flight finish without invoking the callback.
+///
+/// # Safety
+/// Dispatcher must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_dispatcher_free(dispatcher: *mut LlmDispatcherHandle) {
+    if !dispatcher.is_null() {
+        let _ = Box::from_raw(dispatcher);
+    }
+}
+
+/// Response cache statistics for FFI
+#[repr(C)]
+#[derive(Debug, Default)]
+pub struct FfiCacheStats {
+    /// Completions answered from the cache
+    pub hits: u64,
+    /// Cacheable completions sent to the provider
+    pub misses: u64,
+    /// Hits loaded from the on-disk tier
+    pub disk_hits: u64,
+    /// Entries dropped by the size caps or TTL
+    pub evictions: u64,
+    /// Entries currently cached
+    pub entries: u64,
+    /// Total cached bytes
+    pub bytes: u64,
+}
+
+/// Enable the response cache on a handle
+///
+/// Completions with temperature 0 are keyed by a hash of (provider, request)
+/// and served from the cache on repeat; hits report zero tokens.
+/// Dispatchers and streams created afterwards use the cache.
+///
+/// # Arguments
+/// * `dir` - Directory for the on-disk tier (null for memory only)
+/// * `max_entries` - Entry cap (0 for default)
+/// * `max_bytes` - Size cap in bytes (0 for default)
+/// * `ttl_secs` - Entry lifetime (0 for default)
+///
+/// # Returns
+/// false on invalid arguments, if the directory cannot be used, or if a
+/// cache is already enabled
+///
+/// # Safety
+/// Handle must be valid; `dir` must be valid UTF-8 or null. The handle's
+/// provider is swapped without synchronisation: call this before the handle
+/// is used from any other thread, never concurrently with another call on
+/// the same handle.
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_cache_enable(
+    handle: *mut LlmHandle,
+    dir: *const c_char,
+    max_entries: u32,
+    max_bytes: u64,
+    ttl_secs: u64,
+) -> bool {
+    if handle.is_null() {
+        return false;
+    }
+
+    let h = &mut *handle;
+    if h.cache.is_some() {
+        return false;
+    }
+
+    let mut config = ResponseCacheConfig::default();
+    if !dir.is_null() {
+        match CStr::from_ptr(dir).to_str() {
+            Ok(s) => config.dir = Some(s.into()),
+            Err(_) => return false,
+        }
+    }
+    if max_entries > 0 {
+        config.max_entries = max_entries as usize;
+    }
+    if max_bytes > 0 {
+        config.max_bytes = max_bytes as usize;
+    }
+    if ttl_secs > 0 {
+        config.ttl_secs = ttl_secs;
+    }
+
+    let cache = match ResponseCache::new(config) {
+        Ok(c) => Arc::new(c),
+        Err(_) => return false,
+    };
+    h.provider = Arc::new(CachedProvider::new(h.provider.clone(), cache.clone()));
+    h.cache = Some(cache);
+    true
+}
+
+/// Get response cache statistics
+///
+/// # Returns
+/// false if the handle has no cache
+///
+/// # Safety
+/// Handle and `out_stats` must be valid
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_cache_stats(handle: *const LlmHandle, out_stats: *mut FfiCacheStats) -> bool {
+    if handle.is_null() || out_stats.is_null() {
+        return false;
+    }
+
+    let Some(cache) = &(*handle).cache else {
+        return false;
+    };
+    let stats = cache.stats();
+    *out_stats = FfiCacheStats {
+        hits: stats.hits,
+        misses: stats.misses,
+        disk_hits: stats.disk_hits,
+        evictions: stats.evictions,
+        entries: stats.entries as u64,
+        bytes: stats.bytes as u64,
+    };
+    true
+}
+
+/// Drop every cached response (memory and disk)
+///
+/// # Safety
+/// Handle must be valid or null
+#[no_mangle]
+pub unsafe extern "C" fn maidos_llm_cache_clear(handle: *mut LlmHandle) {
+    if handle.is_null() {
+        return;
+    }
+    if let Some(cache) = &(*handle).cache {
+        cache.clear();
     }
 }
 
@@ -683,4 +1374,429 @@ mod tests {
             maidos_llm_destroy(handle);
         }
     }
+
+    /// Read one HTTP request (headers + Content-Length body)
+    fn read_http_request(sock: &mut std::net::TcpStream) {
+        use std::io::Read;
+        let mut buf = Vec::new();
+        let mut tmp = [0u8; 4096];
+        loop {
+            let n = sock.read(&mut tmp).unwrap_or(0);
+            if n == 0 {
+                return;
+            }
+            buf.extend_from_slice(&tmp[..n]);
+            if let Some(end) = buf.windows(4).position(|w| w == b"\r\n\r\n") {
+                let headers = String::from_utf8_lossy(&buf[..end]).to_lowercase();
+                let len = headers
+                    .lines()
+                    .find_map(|l| l.strip_prefix("content-length:"))
+                    .and_then(|v| v.trim().parse::<usize>().ok())
+                    .unwrap_or(0);
+                while buf.len() < end + 4 + len {
+                    let n = sock.read(&mut tmp).unwrap_or(0);
+                    if n == 0 {
+                        return;
+                    }
+                    buf.extend_from_slice(&tmp[..n]);
+                }
+                return;
+            }
+        }
+    }
+
+    /// Local OpenAI-compatible server answering one request with SSE frames
+    fn spawn_sse_server(frames: Vec<String>, gap: std::time::Duration) -> CString {
+        use std::io::Write;
+        let listener = std::net::TcpListener::bind("127.0.0.1:0").unwrap();
+        let addr = listener.local_addr().unwrap();
+        std::thread::spawn(move || {
+            if let Ok((mut sock, _)) = listener.accept() {
+                read_http_request(&mut sock);
+                let _ = sock.write_all(
+                    b"HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nConnection: close\r\n\r\n",
+                );
+                for frame in frames {
+                    if sock.write_all(frame.as_bytes()).is_err() {
+                        return;
+                    }
+                    let _ = sock.flush();
+                    std::thread::sleep(gap);
+                }
+            }
+        });
+        CString::new(format!("http://{}", addr)).unwrap()
+    }
+
+    fn sse_delta(content: &str) -> String {
+        format!(
+            "data: {{\"choices\":[{{\"index\":0,\"delta\":{{\"content\":\"{}\"}},\"finish_reason\":null}}]}}\n\n",
+            content
+        )
+    }
+
+    fn sse_finish() -> String {
+        "data: {\"choices\":[{\"index\":0,\"delta\":{},\"finish_reason\":\"stop\"}]}\n\ndata: [DONE]\n\n"
+            .to_string()
+    }
+
+    struct Collected {
+        deltas: Vec<(String, bool)>,
+        stop_after: usize,
+    }
+
+    unsafe extern "C" fn collect_chunk(delta: *const c_char, is_final: bool, user_data: *mut c_void) -> bool {
+        let c = &mut *(user_data as *mut Collected);
+        c.deltas.push((CStr::from_ptr(delta).to_string_lossy().into_owned(), is_final));
+        c.deltas.len() < c.stop_after
+    }
+
+    unsafe fn openai_handle(base_url: &CString) -> *mut LlmHandle {
+        let provider = CString::new("openai").unwrap();
+        let key = CString::new("test-key").unwrap();
+        let handle = maidos_llm_create(provider.as_ptr(), key.as_ptr(), base_url.as_ptr());
+        assert!(!handle.is_null());
+        handle
+    }
+
+    #[test]
+    fn test_complete_stream_callback() {
+        let frames = vec![sse_delta("Hel"), sse_delta("lo"), sse_delta(" world"), sse_finish()];
+        let base_url = spawn_sse_server(frames, std::time::Duration::from_millis(10));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("hi").unwrap();
+            let mut collected = Collected { deltas: Vec::new(), stop_after: usize::MAX };
+
+            let result = maidos_llm_complete_stream(
+                handle,
+                model.as_ptr(),
+                ptr::null(),
+                user.as_ptr(),
+                0,
+                -1.0,
+                Some(collect_chunk),
+                &mut collected as *mut Collected as *mut c_void,
+            );
+            let r = &*result;
+            assert!(r.success);
+            assert_eq!(CStr::from_ptr(r.text).to_str().unwrap(), "Hello world");
+            assert_eq!(CStr::from_ptr(r.model).to_str().unwrap(), "gpt-4o-mini");
+
+            let text: String = collected.deltas.iter().map(|(d, _)| d.as_str()).collect();
+            assert_eq!(text, "Hello world");
+            assert_eq!(collected.deltas.iter().filter(|(_, f)| *f).count(), 1);
+            assert!(collected.deltas.last().unwrap().1);
+
+            maidos_llm_result_free(result);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_complete_stream_cancel_from_callback() {
+        let frames = vec![sse_delta("a"), sse_delta("b"), sse_delta("c"), sse_finish()];
+        let base_url = spawn_sse_server(frames, std::time::Duration::from_millis(10));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("hi").unwrap();
+            let mut collected = Collected { deltas: Vec::new(), stop_after: 1 };
+
+            let result = maidos_llm_complete_stream(
+                handle,
+                model.as_ptr(),
+                ptr::null(),
+                user.as_ptr(),
+                0,
+                -1.0,
+                Some(collect_chunk),
+                &mut collected as *mut Collected as *mut c_void,
+            );
+            let r = &*result;
+            assert!(!r.success);
+            assert!(matches!(r.error_details.code, FfiErrorCode::Cancelled));
+            assert_eq!(collected.deltas.len(), 1);
+
+            maidos_llm_result_free(result);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_stream_poll_first_chunk_before_completion() {
+        let frames = vec![sse_delta("fast"), sse_delta(" then"), sse_delta(" slow"), sse_finish()];
+        let base_url = spawn_sse_server(frames, std::time::Duration::from_millis(100));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("hi").unwrap();
+            let stream = maidos_llm_stream_start(handle, model.as_ptr(), ptr::null(), user.as_ptr(), 0, -1.0);
+            assert!(!stream.is_null());
+
+            let start = std::time::Instant::now();
+            let mut first_chunk_at = None;
+            let mut deltas = Vec::new();
+            loop {
+                let mut delta: *mut c_char = ptr::null_mut();
+                match maidos_llm_stream_next(stream, 1000, &mut delta) {
+                    FfiStreamStatus::Chunk => {
+                        first_chunk_at.get_or_insert(start.elapsed());
+                        deltas.push(CStr::from_ptr(delta).to_str().unwrap().to_string());
+                        maidos_llm_string_free(delta);
+                    }
+                    FfiStreamStatus::Pending => continue,
+                    status => {
+                        assert_eq!(status, FfiStreamStatus::Done);
+                        break;
+                    }
+                }
+            }
+            let total = start.elapsed();
+            assert_eq!(deltas.concat(), "fast then slow");
+            assert!(first_chunk_at.unwrap() * 2 < total);
+            assert_eq!(maidos_llm_stream_next(stream, 0, ptr::null_mut()), FfiStreamStatus::Done);
+
+            let result = maidos_llm_stream_result(stream);
+            assert!((*result).success);
+            assert_eq!(CStr::from_ptr((*result).text).to_str().unwrap(), "fast then slow");
+
+            maidos_llm_result_free(result);
+            maidos_llm_stream_free(stream);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_stream_poll_cancel() {
+        let frames = vec![sse_delta("one"), sse_delta("two"), sse_finish()];
+        let base_url = spawn_sse_server(frames, std::time::Duration::from_secs(2));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("hi").unwrap();
+            let stream = maidos_llm_stream_start(handle, model.as_ptr(), ptr::null(), user.as_ptr(), 0, -1.0);
+
+            let mut delta: *mut c_char = ptr::null_mut();
+            assert_eq!(maidos_llm_stream_next(stream, 1000, &mut delta), FfiStreamStatus::Chunk);
+            maidos_llm_string_free(delta);
+
+            maidos_llm_stream_cancel(stream);
+            assert_eq!(maidos_llm_stream_next(stream, 1000, &mut delta), FfiStreamStatus::Cancelled);
+            assert!(delta.is_null());
+
+            let result = maidos_llm_stream_result(stream);
+            assert!(matches!((*result).error_details.code, FfiErrorCode::Cancelled));
+
+            maidos_llm_result_free(result);
+            maidos_llm_stream_free(stream);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_stream_connection_error() {
+        unsafe {
+            let base_url = CString::new("http://127.0.0.1:0").unwrap();
+            let handle = openai_handle(&base_url);
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("hi").unwrap();
+            let stream = maidos_llm_stream_start(handle, model.as_ptr(), ptr::null(), user.as_ptr(), 0, -1.0);
+
+            let mut status = FfiStreamStatus::Pending;
+            while status == FfiStreamStatus::Pending {
+                status = maidos_llm_stream_next(stream, 1000, ptr::null_mut());
+            }
+            assert_eq!(status, FfiStreamStatus::Error);
+            let result = maidos_llm_stream_result(stream);
+            assert!(!(*result).success);
+
+            maidos_llm_result_free(result);
+            maidos_llm_stream_free(stream);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_stream_null_safety() {
+        unsafe {
+            let result = maidos_llm_complete_stream(
+                ptr::null_mut(),
+                ptr::null(),
+                ptr::null(),
+                ptr::null(),
+                0,
+                -1.0,
+                None,
+                ptr::null_mut(),
+            );
+            assert!(!(*result).success);
+            maidos_llm_result_free(result);
+
+            assert!(maidos_llm_stream_start(ptr::null_mut(), ptr::null(), ptr::null(), ptr::null(), 0, -1.0).is_null());
+            assert_eq!(maidos_llm_stream_next(ptr::null_mut(), 0, ptr::null_mut()), FfiStreamStatus::Error);
+            maidos_llm_stream_cancel(ptr::null_mut());
+            maidos_llm_stream_free(ptr::null_mut());
+            let result = maidos_llm_stream_result(ptr::null());
+            assert!(!(*result).success);
+            maidos_llm_result_free(result);
+        }
+    }
+
+    /// Local OpenAI-compatible server answering every request after `delay`
+    fn spawn_json_server(delay: std::time::Duration) -> CString {
+        use std::io::Write;
+        let listener = std::net::TcpListener::bind("127.0.0.1:0").unwrap();
+        let addr = listener.local_addr().unwrap();
+        std::thread::spawn(move || {
+            for mut sock in listener.incoming().flatten() {
+                std::thread::spawn(move || {
+                    read_http_request(&mut sock);
+                    std::thread::sleep(delay);
+                    let body = "{\"id\":\"x\",\"model\":\"gpt-4o-mini\",\"choices\":[{\"index\":0,\"message\":{\"role\":\"assistant\",\"content\":\"ok\"},\"finish_reason\":\"stop\"}],\"usage\":{\"prompt_tokens\":3,\"completion_tokens\":1,\"total_tokens\":4}}";
+                    let _ = write!(
+                        sock,
+                        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                        body.len(),
+                        body
+                    );
+                });
+            }
+        });
+        CString::new(format!("http://{}", addr)).unwrap()
+    }
+
+    #[test]
+    fn test_dispatcher_submit_and_poll() {
+        let base_url = spawn_json_server(std::time::Duration::from_millis(20));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            let dispatcher = maidos_llm_dispatcher_create(handle, 2, 0, 0);
+            assert!(!dispatcher.is_null());
+
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let mut ids = Vec::new();
+            for i in 0..4 {
+                let user = CString::new(format!("prompt {}", i)).unwrap();
+                ids.push(maidos_llm_submit(dispatcher, model.as_ptr(), ptr::null(), user.as_ptr(), 0, 0.0));
+            }
+            // Identical to the first prompt: shares its call
+            let dup = CString::new("prompt 0").unwrap();
+            ids.push(maidos_llm_submit(dispatcher, model.as_ptr(), ptr::null(), dup.as_ptr(), 0, 0.0));
+            assert!(ids.iter().all(|id| *id != 0));
+
+            let mut done = Vec::new();
+            while done.len() < ids.len() {
+                let mut id = 0u64;
+                let result = maidos_llm_poll(dispatcher, 5000, &mut id);
+                assert!(!result.is_null());
+                assert!((*result).success);
+                assert_eq!(CStr::from_ptr((*result).text).to_str().unwrap(), "ok");
+                done.push(id);
+                maidos_llm_result_free(result);
+            }
+            done.sort();
+            ids.sort();
+            assert_eq!(done, ids);
+
+            let mut stats = FfiDispatchStats::default();
+            assert!(maidos_llm_dispatcher_stats(dispatcher, &mut stats));
+            assert_eq!(stats.submitted, 5);
+            assert_eq!(stats.coalesced, 1);
+            assert_eq!(stats.completed, 5);
+            assert_eq!(stats.in_flight, 0);
+            assert!(maidos_llm_poll(dispatcher, 0, ptr::null_mut()).is_null());
+
+            maidos_llm_dispatcher_free(dispatcher);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    unsafe extern "C" fn record_completion(id: u64, result: *const FfiCompletionResult, user_data: *mut c_void) {
+        let tx = &*(user_data as *const std::sync::Mutex<mpsc::Sender<(u64, bool)>>);
+        let _ = tx.lock().unwrap().send((id, (*result).success));
+    }
+
+    #[test]
+    fn test_dispatcher_callback() {
+        let base_url = spawn_json_server(std::time::Duration::from_millis(1));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            let dispatcher = maidos_llm_dispatcher_create(handle, 0, 0, 0);
+            let (tx, rx) = mpsc::channel::<(u64, bool)>();
+            let tx = std::sync::Mutex::new(tx);
+            maidos_llm_dispatcher_set_callback(
+                dispatcher,
+                Some(record_completion),
+                &tx as *const _ as *mut c_void,
+            );
+
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("hi").unwrap();
+            let id = maidos_llm_submit(dispatcher, model.as_ptr(), ptr::null(), user.as_ptr(), 0, 0.0);
+            assert_eq!(rx.recv_timeout(std::time::Duration::from_secs(5)).unwrap(), (id, true));
+
+            maidos_llm_dispatcher_free(dispatcher);
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_dispatcher_null_safety() {
+        unsafe {
+            assert!(maidos_llm_dispatcher_create(ptr::null_mut(), 0, 0, 0).is_null());
+            assert_eq!(maidos_llm_submit(ptr::null_mut(), ptr::null(), ptr::null(), ptr::null(), 0, 0.0), 0);
+            assert!(maidos_llm_poll(ptr::null_mut(), 0, ptr::null_mut()).is_null());
+            assert!(!maidos_llm_dispatcher_stats(ptr::null(), ptr::null_mut()));
+            maidos_llm_dispatcher_set_callback(ptr::null_mut(), None, ptr::null_mut());
+            maidos_llm_dispatcher_free(ptr::null_mut());
+        }
+    }
+
+    #[test]
+    fn test_cache_serves_repeat_without_tokens() {
+        let base_url = spawn_json_server(std::time::Duration::from_millis(0));
+
+        unsafe {
+            let handle = openai_handle(&base_url);
+            assert!(maidos_llm_cache_enable(handle, ptr::null(), 0, 0, 0));
+            assert!(!maidos_llm_cache_enable(handle, ptr::null(), 0, 0, 0));
+
+            let model = CString::new("gpt-4o-mini").unwrap();
+            let user = CString::new("rerank: 你好").unwrap();
+            for expected_tokens in [3, 0, 0] {
+                let result = maidos_llm_complete(handle, model.as_ptr(), ptr::null(), user.as_ptr(), 0, 0.0);
+                assert!((*result).success);
+                assert_eq!(CStr::from_ptr((*result).text).to_str().unwrap(), "ok");
+                assert_eq!((*result).prompt_tokens, expected_tokens);
+                maidos_llm_result_free(result);
+            }
+
+            let mut stats = FfiCacheStats::default();
+            assert!(maidos_llm_cache_stats(handle, &mut stats));
+            assert_eq!((stats.hits, stats.misses, stats.entries), (2, 1, 1));
+
+            maidos_llm_cache_clear(handle);
+            assert!(maidos_llm_cache_stats(handle, &mut stats));
+            assert_eq!(stats.entries, 0);
+
+            maidos_llm_destroy(handle);
+        }
+    }
+
+    #[test]
+    fn test_cache_null_safety() {
+        unsafe {
+            assert!(!maidos_llm_cache_enable(ptr::null_mut(), ptr::null(), 0, 0, 0));
+            assert!(!maidos_llm_cache_stats(ptr::null(), ptr::null_mut()));
+            maidos_llm_cache_clear(ptr::null_mut());
+        }
+    }
 }
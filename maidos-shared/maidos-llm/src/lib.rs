@@ -32,6 +32,8 @@
 //! }
 //! ```
 
+pub mod cache;
+pub mod dispatch;
 pub mod error;
 pub mod ffi;
 pub mod message;
@@ -43,6 +45,8 @@ pub mod streaming;
 pub mod tool;
 
 // Re-exports for convenience
+pub use cache::{CachedProvider, ResponseCache, ResponseCacheConfig, ResponseCacheStats};
+pub use dispatch::{Completion, DispatchConfig, DispatchStats, Dispatcher};
 pub use error::{LlmError, Result};
 pub use message::{CompletionResponse, Content, FinishReason, Message, Role, Usage};
 pub use provider::{CompletionRequest, CompletionStream, LlmProvider, ModelInfo, ProviderInfo, StreamChunk};
@@ -155,6 +155,17 @@ impl CompletionRequest {
     pub fn quick(model: impl Into<String>, prompt: impl Into<String>) -> Self {
         Self::new(model).message(Message::user(prompt))
     }
+
+    /// Key shared by requests that can go out in one batched call
+    ///
+    /// A batched call carries one model and one set of sampling parameters;
+    /// only the prompts differ.
+    pub fn batch_key(&self) -> String {
+        format!(
+            "{}\u{1f}{:?}\u{1f}{:?}\u{1f}{:?}\u{1f}{:?}",
+            self.model, self.max_tokens, self.temperature, self.top_p, self.stop
+        )
+    }
 }
 
 /// Provider information
@@ -209,6 +220,24 @@ pub trait LlmProvider: Send + Sync {
     /// Check if provider is healthy/reachable
     async fn health_check(&self) -> Result<bool>;
 
+    /// Whether `complete_batch` sends requests as one upstream call (vLLM, LM Studio)
+    ///
+    /// The dispatcher groups requests with the same
+    /// [`CompletionRequest::batch_key`] for such providers and holds one
+    /// concurrency permit per group.
+    fn supports_batching(&self) -> bool {
+        false
+    }
+
+    /// Complete several requests as one batch
+    ///
+    /// Results are returned in request order. Batching providers send the
+    /// requests that share a `batch_key` in one call. The default sends each
+    /// request as its own concurrent call.
+    async fn complete_batch(&self, requests: Vec<CompletionRequest>) -> Vec<Result<CompletionResponse>> {
+        futures::future::join_all(requests.into_iter().map(|r| self.complete(r))).await
+    }
+
     /// Get the provider name
     fn name(&self) -> &str {
         &self.info().name
@@ -239,6 +268,15 @@ mod tests {
         assert_eq!(req.temperature, Some(0.7));
     }
 
+    #[test]
+    fn test_batch_key() {
+        let a = CompletionRequest::quick("m", "one");
+        let b = CompletionRequest::quick("m", "two");
+        assert_eq!(a.batch_key(), b.batch_key());
+        assert_ne!(a.batch_key(), CompletionRequest::quick("n", "one").batch_key());
+        assert_ne!(a.batch_key(), b.clone().temperature(0.5).batch_key());
+    }
+
     #[test]
     fn test_request_quick() {
         let req = CompletionRequest::quick("claude-3", "What is 2+2?");
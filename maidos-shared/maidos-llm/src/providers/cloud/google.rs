@@ -241,7 +241,7 @@ impl LlmProvider for GoogleProvider {
         // Use SSE (Server-Sent Events) streaming — same protocol as OpenAI-compatible APIs
         let url = format!("{}/chat/completions", self.base_url);
         let mut request_body = self.build_request_body(&_request)?;
-        request_body["stream"] = serde_json::json!(true);
+        crate::streaming::enable_stream_usage(&mut request_body);
 
         let response = self.client
             .post(&url)
@@ -257,7 +257,7 @@ impl LlmProvider for GoogleProvider {
             return Err(LlmError::Provider(format!("Google streaming error {}: {}", status, body)));
         }
 
-        Ok(CompletionStream::from_sse_response(response))
+        Ok(crate::streaming::sse_completion_stream(response))
     }
     }
 
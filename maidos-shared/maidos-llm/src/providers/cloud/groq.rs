@@ -207,7 +207,7 @@ impl LlmProvider for GroqProvider {
         // Use SSE (Server-Sent Events) streaming — same protocol as OpenAI-compatible APIs
         let url = format!("{}/chat/completions", self.base_url);
         let mut request_body = self.build_request_body(&_request)?;
-        request_body["stream"] = serde_json::json!(true);
+        crate::streaming::enable_stream_usage(&mut request_body);
 
         let response = self.client
             .post(&url)
@@ -223,7 +223,7 @@ impl LlmProvider for GroqProvider {
             return Err(LlmError::Provider(format!("Groq streaming error {}: {}", status, body)));
         }
 
-        Ok(CompletionStream::from_sse_response(response))
+        Ok(crate::streaming::sse_completion_stream(response))
     }
     }
 
@@ -10,10 +10,9 @@
 use crate::error::{LlmError, Result};
 use crate::message::{CompletionResponse, Content, FinishReason, Message, Usage};
 use crate::provider::{
-    CompletionRequest, CompletionStream, LlmProvider, ModelInfo, ProviderInfo, StreamChunk,
+    CompletionRequest, CompletionStream, LlmProvider, ModelInfo, ProviderInfo,
 };
 use async_trait::async_trait;
-use futures::StreamExt;
 use reqwest::Client;
 use serde::{Deserialize, Serialize};
 use tracing::debug;
@@ -147,6 +146,7 @@ impl OpenAiProvider {
             top_p: req.top_p,
             stop: req.stop.clone(),
             stream: Some(req.stream),
+            stream_options: req.stream.then_some(OpenAiStreamOptions { include_usage: true }),
         }
     }
 
@@ -243,50 +243,7 @@ impl LlmProvider for OpenAiProvider {
             return Err(Self::parse_error(status.as_u16(), &error_body));
         }
 
-        let stream = response.bytes_stream();
-        let mut accumulated = String::new();
-
-        let mapped = stream.map(move |chunk_result| {
-            match chunk_result {
-                Ok(bytes) => {
-                    let text = String::from_utf8_lossy(&bytes);
-                    for line in text.lines() {
-                        if let Some(data) = line.strip_prefix("data: ") {
-                            if data == "[DONE]" {
-                                return Ok(StreamChunk {
-                                    delta: String::new(),
-                                    accumulated: accumulated.clone(),
-                                    is_final: true,
-                                    usage: None,
-                                });
-                            }
-                            if let Ok(chunk) = serde_json::from_str::<OpenAiStreamChunk>(data) {
-                                if let Some(choice) = chunk.choices.first() {
-                                    if let Some(content) = &choice.delta.content {
-                                        accumulated.push_str(content);
-                                        return Ok(StreamChunk {
-                                            delta: content.clone(),
-                                            accumulated: accumulated.clone(),
-                                            is_final: false,
-                                            usage: None,
-                                        });
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    Ok(StreamChunk {
-                        delta: String::new(),
-                        accumulated: accumulated.clone(),
-                        is_final: false,
-                        usage: None,
-                    })
-                }
-                Err(e) => Err(LlmError::Network(e.to_string())),
-            }
-        });
-
-        Ok(Box::pin(mapped))
+        Ok(crate::streaming::sse_completion_stream(response))
     }
 
     async fn list_models(&self) -> Result<Vec<ModelInfo>> {
@@ -344,6 +301,14 @@ struct OpenAiRequest {
     stop: Option<Vec<String>>,
     #[serde(skip_serializing_if = "Option::is_none")]
     stream: Option<bool>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    stream_options: Option<OpenAiStreamOptions>,
+}
+
+/// Asks for the trailing usage-only chunk when streaming
+#[derive(Debug, Serialize)]
+struct OpenAiStreamOptions {
+    include_usage: bool,
 }
 
 #[derive(Debug, Serialize)]
@@ -403,21 +368,6 @@ struct OpenAiUsage {
     total_tokens: u32,
 }
 
-#[derive(Debug, Deserialize)]
-struct OpenAiStreamChunk {
-    choices: Vec<OpenAiStreamChoice>,
-}
-
-#[derive(Debug, Deserialize)]
-struct OpenAiStreamChoice {
-    delta: OpenAiDelta,
-}
-
-#[derive(Debug, Deserialize)]
-struct OpenAiDelta {
-    content: Option<String>,
-}
-
 #[derive(Debug, Deserialize)]
 struct OpenAiErrorResponse {
     error: OpenAiError,
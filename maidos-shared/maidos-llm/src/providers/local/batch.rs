@@ -0,0 +1,355 @@
+//! Batched completions for OpenAI-compatible local servers
+//!
+//! <impl>
+//! WHAT: Send several chat requests as one `/completions` call with a prompt list
+//! WHY: vLLM and LM Studio schedule a prompt list as one batch, so a dispatcher
+//!      batch costs one HTTP round trip instead of one per request
+//! HOW: Requests sharing a `batch_key` are rendered to plain-text prompts
+//!      (system prompt, role-tagged turns, assistant cue); choices are matched
+//!      back by index. Lone requests keep the chat endpoint.
+//! TEST: Prompt rendering, grouping, choice order, usage attribution, HTTP errors
+//! </impl>
+
+use crate::error::{LlmError, Result};
+use crate::message::{CompletionResponse, FinishReason, Message, Usage};
+use crate::provider::CompletionRequest;
+use reqwest::Client;
+use serde::{Deserialize, Serialize};
+use std::future::Future;
+
+/// Render a chat request as a completion prompt
+///
+/// The completions endpoint takes raw text, so the model's chat template is
+/// not applied; turns are tagged with their role and the prompt ends with an
+/// assistant cue.
+pub(crate) fn render_prompt(request: &CompletionRequest) -> String {
+    let mut prompt = String::new();
+    if let Some(system) = &request.system {
+        prompt.push_str(system);
+        prompt.push_str("\n\n");
+    }
+    for message in &request.messages {
+        let role = match message.role.as_str() {
+            "system" => "System",
+            "user" => "User",
+            "assistant" => "Assistant",
+            _ => "Tool",
+        };
+        prompt.push_str(role);
+        prompt.push_str(": ");
+        prompt.push_str(&message.text());
+        prompt.push('\n');
+    }
+    prompt.push_str("Assistant:");
+    prompt
+}
+
+/// Complete requests in request order, one upstream call per `batch_key` group
+///
+/// Groups of one go through `single` (the provider's chat call); larger
+/// groups are sent to `{base_url}/completions` as a prompt list.
+pub(crate) async fn complete_batch<F, Fut>(
+    client: &Client,
+    base_url: &str,
+    provider: &str,
+    requests: Vec<CompletionRequest>,
+    single: F,
+) -> Vec<Result<CompletionResponse>>
+where
+    F: Fn(CompletionRequest) -> Fut + Sync,
+    Fut: Future<Output = Result<CompletionResponse>> + Send,
+{
+    let mut groups: Vec<(String, Vec<usize>)> = Vec::new();
+    for (i, request) in requests.iter().enumerate() {
+        let key = request.batch_key();
+        match groups.iter_mut().find(|(k, _)| *k == key) {
+            Some((_, indices)) => indices.push(i),
+            None => groups.push((key, vec![i])),
+        }
+    }
+
+    let requests = &requests;
+    let single = &single;
+    let calls = groups.into_iter().map(|(_, indices)| async move {
+        let results = if indices.len() == 1 {
+            vec![single(requests[indices[0]].clone()).await]
+        } else {
+            let group: Vec<&CompletionRequest> = indices.iter().map(|&i| &requests[i]).collect();
+            complete_prompts(client, base_url, provider, &group).await
+        };
+        indices.into_iter().zip(results).collect::<Vec<_>>()
+    });
+
+    let mut ordered: Vec<Option<Result<CompletionResponse>>> = (0..requests.len()).map(|_| None).collect();
+    for group in futures::future::join_all(calls).await {
+        for (i, result) in group {
+            ordered[i] = Some(result);
+        }
+    }
+    ordered
+        .into_iter()
+        .map(|r| r.unwrap_or_else(|| Err(LlmError::Provider("Batch returned too few results".to_string()))))
+        .collect()
+}
+
+/// One `/completions` call for requests sharing a `batch_key`
+///
+/// The server reports usage for the whole call only; it is attached to the
+/// first response so totals stay correct.
+async fn complete_prompts(
+    client: &Client,
+    base_url: &str,
+    provider: &str,
+    requests: &[&CompletionRequest],
+) -> Vec<Result<CompletionResponse>> {
+    let fail = |make: &dyn Fn() -> LlmError| -> Vec<Result<CompletionResponse>> {
+        requests.iter().map(|_| Err(make())).collect()
+    };
+
+    let first = requests[0];
+    let body = BatchRequest {
+        model: first.model.clone(),
+        prompt: requests.iter().map(|r| render_prompt(r)).collect(),
+        max_tokens: first.max_tokens,
+        temperature: first.temperature,
+        top_p: first.top_p,
+        stop: if first.stop.as_ref().is_none_or(|v| v.is_empty()) { None } else { first.stop.clone() },
+    };
+
+    let response = match client
+        .post(format!("{}/completions", base_url))
+        .header("Content-Type", "application/json")
+        .json(&body)
+        .send()
+        .await
+    {
+        Ok(response) => response,
+        Err(e) => return fail(&|| LlmError::ConnectionFailed(format!("{} not running: {}", provider, e))),
+    };
+
+    if !response.status().is_success() {
+        let code = response.status().to_string();
+        let message = response.text().await.unwrap_or_default();
+        return fail(&|| LlmError::ProviderError {
+            code: code.clone(),
+            message: message.clone(),
+        });
+    }
+
+    let parsed: BatchResponse = match response.json().await {
+        Ok(parsed) => parsed,
+        Err(e) => return fail(&|| LlmError::ParseError(e.to_string())),
+    };
+
+    let mut choices: Vec<Option<BatchChoice>> = requests.iter().map(|_| None).collect();
+    for choice in parsed.choices {
+        if let Some(slot) = choices.get_mut(choice.index) {
+            *slot = Some(choice);
+        }
+    }
+
+    let mut usage = parsed
+        .usage
+        .map(|u| Usage {
+            prompt_tokens: u.prompt_tokens,
+            completion_tokens: u.completion_tokens,
+            total_tokens: u.total_tokens,
+            cached_tokens: None,
+        })
+        .unwrap_or_default();
+
+    choices
+        .into_iter()
+        .map(|choice| {
+            let choice = choice.ok_or_else(|| LlmError::ParseError("No choice for prompt in batch response".to_string()))?;
+            let finish_reason = match choice.finish_reason.as_deref() {
+                Some("stop") => FinishReason::Stop,
+                Some("length") => FinishReason::Length,
+                _ => FinishReason::Unknown,
+            };
+            Ok(CompletionResponse {
+                message: Message::assistant(choice.text.trim_start()),
+                usage: std::mem::take(&mut usage),
+                finish_reason,
+                model: parsed.model.clone().unwrap_or_else(|| first.model.clone()),
+                id: parsed.id.clone(),
+            })
+        })
+        .collect()
+}
+
+#[derive(Debug, Serialize)]
+struct BatchRequest {
+    model: String,
+    prompt: Vec<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    max_tokens: Option<u32>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    temperature: Option<f32>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    top_p: Option<f32>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    stop: Option<Vec<String>>,
+}
+
+#[derive(Debug, Deserialize)]
+struct BatchResponse {
+    id: Option<String>,
+    model: Option<String>,
+    choices: Vec<BatchChoice>,
+    usage: Option<BatchUsage>,
+}
+
+#[derive(Debug, Deserialize)]
+struct BatchChoice {
+    #[serde(default)]
+    index: usize,
+    text: String,
+    finish_reason: Option<String>,
+}
+
+#[derive(Debug, Deserialize)]
+struct BatchUsage {
+    prompt_tokens: u32,
+    completion_tokens: u32,
+    total_tokens: u32,
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::io::{Read, Write};
+    use std::sync::atomic::{AtomicUsize, Ordering};
+    use std::sync::{Arc, Mutex};
+
+    /// Local server answering each request with `reply(path, body)`
+    fn spawn_server(reply: fn(&str, &serde_json::Value) -> (u16, String)) -> (String, Arc<Mutex<Vec<String>>>) {
+        let listener = std::net::TcpListener::bind("127.0.0.1:0").unwrap();
+        let addr = listener.local_addr().unwrap();
+        let paths = Arc::new(Mutex::new(Vec::new()));
+        let seen = paths.clone();
+        std::thread::spawn(move || {
+            for mut sock in listener.incoming().flatten() {
+                let mut buf = Vec::new();
+                let mut tmp = [0u8; 4096];
+                let (path, body) = loop {
+                    let n = sock.read(&mut tmp).unwrap_or(0);
+                    if n == 0 {
+                        break (String::new(), Vec::new());
+                    }
+                    buf.extend_from_slice(&tmp[..n]);
+                    if let Some(end) = buf.windows(4).position(|w| w == b"\r\n\r\n") {
+                        let headers = String::from_utf8_lossy(&buf[..end]).to_lowercase();
+                        let len = headers
+                            .lines()
+                            .find_map(|l| l.strip_prefix("content-length:"))
+                            .and_then(|v| v.trim().parse::<usize>().ok())
+                            .unwrap_or(0);
+                        if buf.len() >= end + 4 + len {
+                            let path = headers.split_whitespace().nth(1).unwrap_or("").to_string();
+                            break (path, buf[end + 4..end + 4 + len].to_vec());
+                        }
+                    }
+                };
+                let json = serde_json::from_slice(&body).unwrap_or(serde_json::Value::Null);
+                seen.lock().unwrap().push(path.clone());
+                let (status, reply) = reply(&path, &json);
+                let _ = write!(
+                    sock,
+                    "HTTP/1.1 {} X\r\nContent-Type: application/json\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                    status,
+                    reply.len(),
+                    reply
+                );
+            }
+        });
+        (format!("http://{}/v1", addr), paths)
+    }
+
+    /// Echo each prompt's last line back, choices in reverse order
+    fn echo_prompts(_path: &str, body: &serde_json::Value) -> (u16, String) {
+        let prompts = body["prompt"].as_array().cloned().unwrap_or_default();
+        let choices: Vec<serde_json::Value> = prompts
+            .iter()
+            .enumerate()
+            .rev()
+            .map(|(i, p)| {
+                let line = p.as_str().unwrap_or("").lines().rev().nth(1).unwrap_or("").to_string();
+                serde_json::json!({ "index": i, "text": format!(" {}", line), "finish_reason": "stop" })
+            })
+            .collect();
+        let reply = serde_json::json!({
+            "id": "cmpl-1",
+            "model": body["model"],
+            "choices": choices,
+            "usage": { "prompt_tokens": 10, "completion_tokens": 4, "total_tokens": 14 }
+        });
+        (200, reply.to_string())
+    }
+
+    fn run<F: Future>(future: F) -> F::Output {
+        tokio::runtime::Runtime::new().unwrap().block_on(future)
+    }
+
+    #[test]
+    fn test_render_prompt() {
+        let request = CompletionRequest::new("m")
+            .system("Be brief.")
+            .message(Message::user("Hi"))
+            .message(Message::assistant("Hello"))
+            .message(Message::user("Rank these"));
+        assert_eq!(
+            render_prompt(&request),
+            "Be brief.\n\nUser: Hi\nAssistant: Hello\nUser: Rank these\nAssistant:"
+        );
+    }
+
+    #[test]
+    fn test_one_call_per_group() {
+        let (base_url, paths) = spawn_server(echo_prompts);
+        let singles = AtomicUsize::new(0);
+        let requests = vec![
+            CompletionRequest::quick("m", "a"),
+            CompletionRequest::quick("m", "b"),
+            CompletionRequest::quick("other", "c"),
+            CompletionRequest::quick("m", "d"),
+        ];
+
+        let results = run(complete_batch(&Client::new(), &base_url, "vLLM", requests, |r: CompletionRequest| {
+            singles.fetch_add(1, Ordering::SeqCst);
+            async move { Ok(CompletionResponse {
+                message: Message::assistant(format!("single {}", r.model)),
+                usage: Usage::default(),
+                finish_reason: FinishReason::Stop,
+                model: r.model,
+                id: None,
+            }) }
+        }));
+
+        let texts: Vec<String> = results.iter().map(|r| r.as_ref().unwrap().message.text()).collect();
+        assert_eq!(texts, vec!["User: a", "User: b", "single other", "User: d"]);
+        assert_eq!(*paths.lock().unwrap(), vec!["/v1/completions".to_string()]);
+        assert_eq!(singles.load(Ordering::SeqCst), 1);
+
+        // Usage of the call is reported once
+        let total: u32 = results.iter().map(|r| r.as_ref().unwrap().usage.total_tokens).sum();
+        assert_eq!(total, 14);
+    }
+
+    #[test]
+    fn test_http_error_fails_every_request() {
+        let (base_url, _) = spawn_server(|_, _| (503, "busy".to_string()));
+        let requests = vec![CompletionRequest::quick("m", "a"), CompletionRequest::quick("m", "b")];
+        let results = run(complete_batch(&Client::new(), &base_url, "vLLM", requests, |_: CompletionRequest| async {
+            Err(LlmError::Provider("unused".to_string()))
+        }));
+
+        assert_eq!(results.len(), 2);
+        for result in results {
+            match result {
+                Err(LlmError::ProviderError { message, .. }) => assert_eq!(message, "busy"),
+                other => panic!("unexpected {:?}", other),
+            }
+        }
+    }
+}
@@ -120,6 +120,15 @@ impl LlmProvider for LmStudioProvider {
         &self.info
     }
 
+    /// LM Studio schedules a prompt list sent to `/completions` as one batch
+    fn supports_batching(&self) -> bool {
+        true
+    }
+
+    async fn complete_batch(&self, requests: Vec<CompletionRequest>) -> Vec<Result<CompletionResponse>> {
+        super::batch::complete_batch(&self.client, &self.base_url, "LM Studio", requests, |r| self.complete(r)).await
+    }
+
     async fn complete(&self, request: CompletionRequest) -> Result<CompletionResponse> {
         let url = format!("{}/chat/completions", self.base_url);
         let body = self.build_request(&request);
@@ -152,7 +161,7 @@ impl LlmProvider for LmStudioProvider {
         // Use SSE (Server-Sent Events) streaming — same protocol as OpenAI-compatible APIs
         let url = format!("{}/chat/completions", self.base_url);
         let mut request_body = self.build_request_body(&_request)?;
-        request_body["stream"] = serde_json::json!(true);
+        crate::streaming::enable_stream_usage(&mut request_body);
 
         let response = self.client
             .post(&url)
@@ -168,7 +177,7 @@ impl LlmProvider for LmStudioProvider {
             return Err(LlmError::Provider(format!("LM Studio streaming error {}: {}", status, body)));
         }
 
-        Ok(CompletionStream::from_sse_response(response))
+        Ok(crate::streaming::sse_completion_stream(response))
     }
     }
 
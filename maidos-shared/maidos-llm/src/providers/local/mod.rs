@@ -10,6 +10,7 @@
 pub mod ollama;
 pub mod lmstudio;
 pub mod vllm;
+mod batch;
 
 pub use ollama::OllamaProvider;
 pub use lmstudio::LmStudioProvider;
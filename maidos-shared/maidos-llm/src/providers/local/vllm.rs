@@ -123,6 +123,15 @@ impl LlmProvider for VllmProvider {
         &self.info
     }
 
+    /// vLLM schedules a prompt list sent to `/completions` as one batch
+    fn supports_batching(&self) -> bool {
+        true
+    }
+
+    async fn complete_batch(&self, requests: Vec<CompletionRequest>) -> Vec<Result<CompletionResponse>> {
+        super::batch::complete_batch(&self.client, &self.base_url, "vLLM", requests, |r| self.complete(r)).await
+    }
+
     async fn complete(&self, request: CompletionRequest) -> Result<CompletionResponse> {
         let url = format!("{}/chat/completions", self.base_url);
         let body = self.build_request(&request);
@@ -15,6 +15,10 @@
 //! ```
 
 use crate::error::{LlmError, Result};
+use crate::message::Usage;
+use crate::provider::{CompletionStream, StreamChunk as ProviderChunk};
+use bytes::Bytes;
+use futures::{Stream, StreamExt};
 use serde::{Deserialize, Serialize};
 use std::pin::Pin;
 use std::task::{Context, Poll};
@@ -141,9 +145,13 @@ pub type BoxedStream = Pin<Box<dyn StreamingResponse>>;
 /// data: {"content": " world"}
 /// data: [DONE]
 /// ```
+///
+/// Network reads are buffered as raw bytes and only complete events or lines
+/// are decoded, so a multi-byte UTF-8 character split across two reads is
+/// never replaced by U+FFFD.
 #[derive(Debug)]
 pub struct SseParser {
-    buffer: String,
+    buffer: Vec<u8>,
     done_marker: String,
 }
 
@@ -151,7 +159,7 @@ impl SseParser {
     /// Create a new SSE parser with default [DONE] marker
     pub fn new() -> Self {
         Self {
-            buffer: String::new(),
+            buffer: Vec::new(),
             done_marker: "[DONE]".to_string(),
         }
     }
@@ -159,7 +167,7 @@ impl SseParser {
     /// Create with custom done marker
     pub fn with_done_marker(marker: impl Into<String>) -> Self {
         Self {
-            buffer: String::new(),
+            buffer: Vec::new(),
             done_marker: marker.into(),
         }
     }
@@ -168,43 +176,44 @@ impl SseParser {
     ///
     /// Returns a vector of data payloads (without "data: " prefix)
     pub fn parse(&mut self, bytes: &[u8]) -> Vec<SseEvent> {
-        let text = String::from_utf8_lossy(bytes);
-        self.buffer.push_str(&text);
+        self.buffer.extend_from_slice(bytes);
 
         let mut events = Vec::new();
+        let mut consumed = 0;
 
-        // Split by double newline (SSE event boundary)
-        while let Some(pos) = self.buffer.find("\n\n") {
-            let event_text = self.buffer[..pos].to_string();
-            self.buffer = self.buffer[pos + 2..].to_string();
-
+        // Split by double newline (SSE event boundary). '\n' never occurs
+        // inside a multi-byte UTF-8 sequence, so complete events decode cleanly.
+        while let Some(pos) = find_bytes(&self.buffer[consumed..], b"\n\n") {
+            let event_text = String::from_utf8_lossy(&self.buffer[consumed..consumed + pos]);
             if let Some(event) = self.parse_event(&event_text) {
                 events.push(event);
             }
+            consumed += pos + 2;
         }
 
         // Also handle single newline for providers that use it
-        while let Some(pos) = self.buffer.find('\n') {
-            let line = self.buffer[..pos].to_string();
+        while let Some(pos) = self.buffer[consumed..].iter().position(|&b| b == b'\n') {
+            let line = String::from_utf8_lossy(&self.buffer[consumed..consumed + pos]);
             let trimmed = line.trim();
 
             // Skip empty lines
             if trimmed.is_empty() {
-                self.buffer = self.buffer[pos + 1..].to_string();
+                consumed += pos + 1;
                 continue;
             }
 
             // Check for complete data line
             if trimmed.starts_with("data:") {
-                self.buffer = self.buffer[pos + 1..].to_string();
                 if let Some(event) = self.parse_data_line(trimmed) {
                     events.push(event);
                 }
+                consumed += pos + 1;
             } else {
                 break; // Wait for more data
             }
         }
 
+        self.buffer.drain(..consumed);
         events
     }
 
@@ -240,6 +249,10 @@ impl SseParser {
     }
 }
 
+fn find_bytes(haystack: &[u8], needle: &[u8]) -> Option<usize> {
+    haystack.windows(needle.len()).position(|w| w == needle)
+}
+
 impl Default for SseParser {
     fn default() -> Self {
         Self::new()
@@ -375,6 +388,129 @@ impl TryFrom<OpenAiStreamChunk> for StreamChunk {
     }
 }
 
+/// Ask an OpenAI-compatible endpoint to stream, including the trailing
+/// usage-only chunk
+pub fn enable_stream_usage(body: &mut serde_json::Value) {
+    body["stream"] = serde_json::json!(true);
+    body["stream_options"] = serde_json::json!({ "include_usage": true });
+}
+
+/// Decoder state for `openai_sse_stream`
+struct OpenAiSseDecoder {
+    parser: SseParser,
+    accumulated: String,
+    usage: Option<Usage>,
+    /// A choice carried `finish_reason`; the final chunk waits for the
+    /// usage-only chunk, `[DONE]` or the end of the body
+    finish_seen: bool,
+    finished: bool,
+}
+
+impl OpenAiSseDecoder {
+    fn feed(&mut self, bytes: &[u8], out: &mut Vec<Result<ProviderChunk>>) {
+        for event in self.parser.parse(bytes) {
+            if self.finished {
+                break;
+            }
+            let chunk = match event {
+                SseEvent::Done => {
+                    out.push(Ok(self.final_chunk()));
+                    continue;
+                }
+                SseEvent::Data(data) => match serde_json::from_str::<OpenAiStreamChunk>(&data) {
+                    Ok(chunk) => chunk,
+                    Err(e) => {
+                        out.push(Err(LlmError::ParseError(e.to_string())));
+                        continue;
+                    }
+                },
+            };
+
+            if let Some(u) = chunk.usage {
+                self.usage = Some(Usage::new(u.prompt_tokens, u.completion_tokens));
+            }
+            match chunk.choices.into_iter().next() {
+                Some(c) => {
+                    self.finish_seen |= c.finish_reason.is_some();
+                    let delta = c.delta.content.unwrap_or_default();
+                    if !delta.is_empty() {
+                        self.accumulated.push_str(&delta);
+                        out.push(Ok(ProviderChunk {
+                            delta,
+                            accumulated: self.accumulated.clone(),
+                            is_final: false,
+                            usage: None,
+                        }));
+                    }
+                }
+                // Usage-only chunk sent after finish_reason (stream_options.include_usage)
+                None if self.finish_seen && self.usage.is_some() => out.push(Ok(self.final_chunk())),
+                None => {}
+            }
+        }
+    }
+
+    fn final_chunk(&mut self) -> ProviderChunk {
+        self.finished = true;
+        ProviderChunk {
+            delta: String::new(),
+            accumulated: self.accumulated.clone(),
+            is_final: true,
+            usage: self.usage.clone(),
+        }
+    }
+}
+
+/// Decode an OpenAI-compatible SSE byte stream into completion chunks
+///
+/// Every `data:` event in a network read becomes its own chunk (reads often
+/// carry several events, or split one event across two reads). Empty deltas
+/// are dropped. The final chunk carries the accumulated text and usage; it is
+/// emitted on the usage-only chunk that follows `finish_reason`, on `[DONE]`,
+/// or when the body ends after `finish_reason`.
+pub fn openai_sse_stream<S, E>(bytes: S) -> CompletionStream
+where
+    S: Stream<Item = std::result::Result<Bytes, E>> + Send + 'static,
+    E: std::fmt::Display,
+{
+    let decoder = OpenAiSseDecoder {
+        parser: SseParser::new(),
+        accumulated: String::new(),
+        usage: None,
+        finish_seen: false,
+        finished: false,
+    };
+
+    let stream = futures::stream::unfold(
+        (Box::pin(bytes), decoder),
+        |(mut bytes, mut decoder)| async move {
+            loop {
+                if decoder.finished {
+                    return None;
+                }
+                let mut out: Vec<Result<ProviderChunk>> = Vec::new();
+                match bytes.next().await {
+                    Some(Ok(b)) => decoder.feed(&b, &mut out),
+                    Some(Err(e)) => out.push(Err(LlmError::Network(e.to_string()))),
+                    None if decoder.finish_seen => out.push(Ok(decoder.final_chunk())),
+                    None => return None,
+                }
+                if !out.is_empty() {
+                    return Some((futures::stream::iter(out), (bytes, decoder)));
+                }
+            }
+        },
+    )
+    .flatten();
+
+    Box::pin(stream)
+}
+
+/// Stream an OpenAI-compatible `text/event-stream` HTTP response
+pub fn sse_completion_stream(response: reqwest::Response) -> CompletionStream {
+    openai_sse_stream(response.bytes_stream())
+}
+
 /// Anthropic streaming event types
 #[derive(Debug, Deserialize)]
 #[serde(tag = "type")]
@@ -696,4 +832,109 @@ mod tests {
         let tc = chunk.tool_call.unwrap();
         assert_eq!(tc.name, Some("get_weather".to_string()));
     }
+
+    fn collect_sse(frames: Vec<&'static str>) -> Vec<ProviderChunk> {
+        let input = futures::stream::iter(
+            frames
+                .into_iter()
+                .map(|f| Ok::<Bytes, std::io::Error>(Bytes::from_static(f.as_bytes()))),
+        );
+        futures::executor::block_on(
+            openai_sse_stream(input)
+                .map(|c| c.expect("chunk"))
+                .collect::<Vec<_>>(),
+        )
+    }
+
+    #[test]
+    fn test_openai_sse_stream_multiple_events_per_read() {
+        let chunks = collect_sse(vec![
+            "data: {\"choices\":[{\"index\":0,\"delta\":{\"content\":\"Hel\"},\"finish_reason\":null}]}\n\n\
+             data: {\"choices\":[{\"index\":0,\"delta\":{\"content\":\"lo\"},\"finish_reason\":null}]}\n\n",
+            "data: {\"choices\":[{\"index\":0,\"delta\":{},\"finish_reason\":\"stop\"}]}\n\ndata: [DONE]\n\n",
+        ]);
+
+        assert_eq!(chunks.len(), 3);
+        assert_eq!(chunks[0].delta, "Hel");
+        assert_eq!(chunks[1].delta, "lo");
+        assert!(chunks[2].is_final);
+        assert_eq!(chunks[2].accumulated, "Hello");
+    }
+
+    #[test]
+    fn test_openai_sse_stream_split_event() {
+        let chunks = collect_sse(vec![
+            "data: {\"choices\":[{\"index\":0,\"delta\":{\"con",
+            "tent\":\"Hi\"},\"finish_reason\":null}]}\n\n",
+            "data: [DONE]\n\n",
+        ]);
+
+        assert_eq!(chunks.len(), 2);
+        assert_eq!(chunks[0].delta, "Hi");
+        assert!(chunks[1].is_final);
+    }
+
+    #[test]
+    fn test_sse_parser_split_codepoint() {
+        // "你好" split inside the first character's UTF-8 sequence
+        let event = "data: {\"content\":\"你好\"}\n\n".as_bytes();
+        let split = event.iter().position(|&b| b >= 0x80).unwrap() + 1;
+
+        let mut parser = SseParser::new();
+        assert!(parser.parse(&event[..split]).is_empty());
+        let events = parser.parse(&event[split..]);
+        assert_eq!(events, vec![SseEvent::Data("{\"content\":\"你好\"}".to_string())]);
+    }
+
+    #[test]
+    fn test_openai_sse_stream_split_codepoint() {
+        let frames: Vec<&'static [u8]> = {
+            let text: &'static str =
+                "data: {\"choices\":[{\"index\":0,\"delta\":{\"content\":\"輸入法\"},\"finish_reason\":null}]}\n\ndata: [DONE]\n\n";
+            let bytes = text.as_bytes();
+            let split = bytes.iter().position(|&b| b >= 0x80).unwrap() + 2;
+            vec![&bytes[..split], &bytes[split..]]
+        };
+        let input = futures::stream::iter(
+            frames
+                .into_iter()
+                .map(|f| Ok::<Bytes, std::io::Error>(Bytes::from_static(f))),
+        );
+        let chunks = futures::executor::block_on(
+            openai_sse_stream(input)
+                .map(|c| c.expect("chunk"))
+                .collect::<Vec<_>>(),
+        );
+
+        assert_eq!(chunks[0].delta, "輸入法");
+        assert_eq!(chunks.last().unwrap().accumulated, "輸入法");
+    }
+
+    #[test]
+    fn test_openai_sse_stream_usage_after_finish() {
+        let chunks = collect_sse(vec![
+            "data: {\"choices\":[{\"index\":0,\"delta\":{\"content\":\"Hi\"},\"finish_reason\":\"stop\"}]}\n\n",
+            "data: {\"choices\":[],\"usage\":{\"prompt_tokens\":5,\"completion_tokens\":1,\"total_tokens\":6}}\n\n\
+             data: [DONE]\n\n",
+        ]);
+
+        assert_eq!(chunks.len(), 2);
+        assert_eq!(chunks[0].delta, "Hi");
+        assert!(chunks[1].is_final);
+        assert_eq!(chunks[1].accumulated, "Hi");
+        let usage = chunks[1].usage.as_ref().expect("usage");
+        assert_eq!(usage.prompt_tokens, 5);
+        assert_eq!(usage.completion_tokens, 1);
+    }
+
+    #[test]
+    fn test_openai_sse_stream_finish_without_done() {
+        let chunks = collect_sse(vec![
+            "data: {\"choices\":[{\"index\":0,\"delta\":{\"content\":\"ok\"},\"finish_reason\":\"stop\"}]}\n\n",
+        ]);
+
+        assert_eq!(chunks.len(), 2);
+        assert!(chunks[1].is_final);
+        assert_eq!(chunks[1].accumulated, "ok");
+    }
 }